@@ -126,6 +126,10 @@ enum spdk_bdev_io_type {
 	SPDK_BDEV_IO_TYPE_NVME_IO_MD,
 	SPDK_BDEV_IO_TYPE_WRITE_ZEROES,
 	SPDK_BDEV_IO_TYPE_ZCOPY,
+	SPDK_BDEV_IO_TYPE_ABORT,
+	SPDK_BDEV_IO_TYPE_GET_ZONE_INFO,
+	SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT,
+	SPDK_BDEV_IO_TYPE_ZONE_APPEND,
 	SPDK_BDEV_NUM_IO_TYPES /* Keep last */
 };
 
@@ -448,6 +452,17 @@ bool spdk_bdev_has_write_cache(const struct spdk_bdev *bdev);
  */
 const struct spdk_uuid *spdk_bdev_get_uuid(const struct spdk_bdev *bdev);
 
+/**
+ * Query whether block device is a zoned device.
+ *
+ * \param bdev Block device to query.
+ * \return true if block device is zoned, false otherwise.
+ *
+ * Zoned devices only accept sequential writes within a zone. The zone API
+ * is declared in spdk/bdev_zone.h.
+ */
+bool spdk_bdev_is_zoned(const struct spdk_bdev *bdev);
+
 /**
  * Get block device metadata size.
  *
@@ -1157,6 +1172,33 @@ int spdk_bdev_flush_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *
 int spdk_bdev_reset(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 		    spdk_bdev_io_completion_cb cb, void *cb_arg);
 
+/**
+ * Submit an abort request to the bdev on the given channel.
+ *
+ * The I/O submitted on the same channel with bio_cb_arg as its callback argument
+ * is aborted. An I/O that is still queued inside the bdev layer is completed with
+ * SPDK_BDEV_IO_STATUS_ABORTED right away, otherwise the bdev module is asked to
+ * abort it. I/O that was split by the bdev layer cannot be aborted.
+ *
+ * \ingroup bdev_io_submit_functions
+ *
+ * \param desc Block device descriptor.
+ * \param ch I/O channel. Obtained by calling spdk_bdev_get_io_channel().
+ * \param bio_cb_arg Callback argument of the I/O to abort.
+ * \param cb Called when the abort request is complete.
+ * \param cb_arg Argument passed to cb.
+ *
+ * \return 0 on success. On success, the callback will always
+ * be called (even if the request ultimately failed). Return
+ * negated errno on failure, in which case the callback will not be called.
+ *   * -EINVAL - bio_cb_arg is NULL
+ *   * -ENOTSUP - the bdev does not support aborting I/O
+ *   * -ENOENT - no outstanding I/O matched bio_cb_arg
+ *   * -ENOMEM - spdk_bdev_io buffer cannot be allocated
+ */
+int spdk_bdev_abort(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		    void *bio_cb_arg, spdk_bdev_io_completion_cb cb, void *cb_arg);
+
 /**
  * Submit an NVMe Admin command to the bdev. This passes directly through
  * the block layer to the device. Support for NVMe passthru is optional,
@@ -43,6 +43,7 @@
 #include "spdk/stdinc.h"
 
 #include "spdk/bdev.h"
+#include "spdk/bdev_zone.h"
 #include "spdk/queue.h"
 #include "spdk/scsi_spec.h"
 #include "spdk/thread.h"
@@ -221,6 +222,8 @@ struct spdk_bdev_fn_table {
 
 /** bdev I/O completion status */
 enum spdk_bdev_io_status {
+	/* The I/O was aborted by an abort request (see spdk_bdev_abort()). */
+	SPDK_BDEV_IO_STATUS_ABORTED = -5,
 	/*
 	 * NOMEM should be returned when a bdev module cannot start an I/O because of
 	 *  some lack of resources.  It may not be returned for RESET I/O.  I/O completed
@@ -331,6 +334,29 @@ struct spdk_bdev {
 	 */
 	uint32_t dif_check_flags;
 
+	/**
+	 * Specify whether the bdev is a zoned block device. Zoned bdevs must be
+	 * written sequentially within each zone and must set zone_size.
+	 */
+	bool zoned;
+
+	/**
+	 * Number of blocks per zone. Valid only if zoned is true.
+	 */
+	uint64_t zone_size;
+
+	/**
+	 * Maximum number of zones that can be open at the same time, or 0 for
+	 * no limit. Valid only if zoned is true.
+	 */
+	uint32_t max_open_zones;
+
+	/**
+	 * Optimal number of zones to keep open for writing. Valid only if zoned
+	 * is true.
+	 */
+	uint32_t optimal_open_zones;
+
 	/**
 	 * Pointer to the bdev module that registered this bdev.
 	 */
@@ -473,6 +499,26 @@ struct spdk_bdev_io {
 			/** Channel reference held while messages for this reset are in progress. */
 			struct spdk_io_channel *ch_ref;
 		} reset;
+		struct {
+			/** The callback argument of the I/O to abort. */
+			void *bio_cb_arg;
+
+			/** The outstanding I/O to abort. */
+			struct spdk_bdev_io *bio_to_abort;
+		} abort;
+		struct {
+			/** First logical block of a zone */
+			uint64_t zone_id;
+
+			/** Number of zones */
+			uint32_t num_zones;
+
+			/** Used to change zoned device zone state */
+			enum spdk_bdev_zone_action zone_action;
+
+			/** The data buffer */
+			void *buf;
+		} zone_mgmt;
 		struct {
 			/* The NVMe command to execute */
 			struct spdk_nvme_cmd cmd;
@@ -568,6 +614,9 @@ struct spdk_bdev_io {
 		/** Member used for linking child I/Os together. */
 		TAILQ_ENTRY(spdk_bdev_io) link;
 
+		/** Entry to the list io_submitted of struct spdk_bdev_channel. */
+		TAILQ_ENTRY(spdk_bdev_io) ch_link;
+
 		/** Entry to the list need_buf of struct spdk_bdev. */
 		STAILQ_ENTRY(spdk_bdev_io) buf_link;
 
@@ -199,6 +199,25 @@ struct spdk_bs_type {
 	char bstype[SPDK_BLOBSTORE_TYPE_LENGTH];
 };
 
+/**
+ * Create the device of an external snapshot.
+ *
+ * Called when a blob that is a clone of an external snapshot is opened. The
+ * returned device is only read from, and is destroyed by the blobstore when
+ * the blob is closed. Its block length must divide the blobstore io unit size.
+ *
+ * \param bs_ctx Context passed in spdk_bs_opts.
+ * \param blob Blob being opened.
+ * \param esnap_id Id of the external snapshot the blob was created with.
+ * \param id_len Length of esnap_id in bytes.
+ * \param bs_dev Set to the created device on success.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+typedef int (*spdk_bs_esnap_dev_create)(void *bs_ctx, struct spdk_blob *blob,
+					const void *esnap_id, uint32_t id_len,
+					struct spdk_bs_dev **bs_dev);
+
 struct spdk_bs_opts {
 	/** Size of cluster in bytes. Must be multiple of 4KiB page size. */
 	uint32_t cluster_sz;
@@ -223,6 +242,23 @@ struct spdk_bs_opts {
 
 	/** Argument passed to iter_cb_fn for each blob. */
 	void *iter_cb_arg;
+
+	/**
+	 * Called to create the device of an external snapshot when one of its
+	 * clones is opened. Required to open such clones.
+	 */
+	spdk_bs_esnap_dev_create esnap_bs_dev_create;
+
+	/** Argument passed to esnap_bs_dev_create. */
+	void *esnap_ctx;
+
+	/**
+	 * Time in microseconds to collect metadata writes for before they are
+	 * written together. Writes submitted while a previous group is being
+	 * written always wait for it and are written together. 0 writes without
+	 * waiting when nothing is in flight.
+	 */
+	uint32_t md_commit_window_us;
 };
 
 /**
@@ -411,6 +447,34 @@ struct spdk_blob_opts {
 	uint64_t  num_clusters;
 	bool	thin_provision;
 	struct spdk_blob_xattr_opts xattrs;
+
+	/**
+	 * Keep the cluster map in extent pages, so that allocating a cluster
+	 * only rewrites the metadata page that describes it. Blobs created
+	 * with this option cannot be opened by older versions of blobstore.
+	 */
+	bool	use_extent_table;
+
+	/**
+	 * Copy data from the parent in parts of a cluster, instead of whole
+	 * clusters, on the first write to a cluster of a clone or of a blob
+	 * that was snapshotted. Snapshots and clones of the blob inherit this
+	 * option. Blobs created with this option cannot be opened by older
+	 * versions of blobstore.
+	 */
+	bool	use_subcluster_cow;
+
+	/**
+	 * Id of an external snapshot, for example the name of a bdev, to use as
+	 * the parent of the blob. Such blob is always thin provisioned and reads
+	 * clusters it did not write from the device that
+	 * spdk_bs_opts.esnap_bs_dev_create creates for this id. The id is kept
+	 * in the blob metadata. NULL for blobs without external snapshot.
+	 */
+	const void *esnap_id;
+
+	/** Length of esnap_id in bytes. */
+	uint32_t esnap_id_len;
 };
 
 /**
@@ -535,6 +599,26 @@ bool spdk_blob_is_snapshot(struct spdk_blob *blob);
  */
 bool spdk_blob_is_clone(struct spdk_blob *blob);
 
+/**
+ * Check if blob is a clone of an external snapshot.
+ *
+ * \param blob Blob.
+ *
+ * \return true if blob is a clone of an external snapshot.
+ */
+bool spdk_blob_is_esnap_clone(const struct spdk_blob *blob);
+
+/**
+ * Get the id of the external snapshot of the blob.
+ *
+ * \param blob Blob.
+ * \param id Set to the external snapshot id. Valid while the blob is open.
+ * \param len Set to the length of the id in bytes.
+ *
+ * \return 0 on success, -EINVAL if blob is not a clone of an external snapshot.
+ */
+int spdk_blob_get_esnap_id(struct spdk_blob *blob, const void **id, size_t *len);
+
 /**
  * Check if blob is thin-provisioned.
  *
@@ -559,7 +643,8 @@ void spdk_bs_delete_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
  * Allocate all clusters in this blob. Data for allocated clusters is copied
  * from backing blob(s) if they exist.
  *
- * This call removes all dependencies on any backing blobs.
+ * This call removes all dependencies on any backing blobs, including an
+ * external snapshot.
  *
  * \param bs blobstore.
  * \param channel IO channel used to inflate blob.
@@ -577,7 +662,9 @@ void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *ch
  * the parent blob, and decouples parent updating dependencies of blob to
  * its ancestor.
  *
- * If blob have no parent -EINVAL error is reported.
+ * If blob have no parent -EINVAL error is reported. That includes clones of an
+ * external snapshot, which have no parent blob. A blob whose parent is a clone
+ * of an external snapshot becomes a clone of that external snapshot.
  *
  * \param bs blobstore.
  * \param channel IO channel used to inflate blob.
@@ -588,6 +675,100 @@ void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 void spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 				  spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg);
 
+/* Default number of clusters a background copy works on at the same time */
+#define SPDK_BLOB_COPY_DEFAULT_QUEUE_DEPTH 4
+
+struct spdk_blob_copy_opts {
+	/* Number of clusters copied at the same time */
+	uint32_t queue_depth;
+
+	/* Maximum copy rate in megabytes per second, 0 for unlimited */
+	uint64_t mbytes_per_sec;
+};
+
+/**
+ * Initialize a spdk_blob_copy_opts structure to the default option values.
+ *
+ * \param opts spdk_blob_copy_opts structure to initialize.
+ */
+void spdk_blob_copy_opts_init(struct spdk_blob_copy_opts *opts);
+
+/**
+ * Same as spdk_bs_inflate_blob(), but with options controlling how fast the
+ * clusters are copied so that the inflate competes less with other I/O.
+ *
+ * \param bs blobstore.
+ * \param channel IO channel used to inflate blob.
+ * \param blobid The id of the blob to inflate.
+ * \param opts Copy options, NULL for the defaults.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			      spdk_blob_id blobid, const struct spdk_blob_copy_opts *opts,
+			      spdk_blob_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Same as spdk_bs_blob_decouple_parent(), but with options controlling how fast
+ * the clusters are copied.
+ *
+ * \param bs blobstore.
+ * \param channel IO channel used to inflate blob.
+ * \param blobid The id of the blob.
+ * \param opts Copy options, NULL for the defaults.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_blob_decouple_parent_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+				      spdk_blob_id blobid, const struct spdk_blob_copy_opts *opts,
+				      spdk_blob_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Copy the data a blob holds itself to a device, leaving the parts of the
+ * device where the blob reads from its parent or backing device untouched.
+ * The data is written at the same offset it has in the blob.
+ *
+ * The blob must be read-only, typically a snapshot, and the device must be at
+ * least as large as the blob, with a block size that divides the io_unit size.
+ *
+ * \param bs blobstore.
+ * \param channel IO channel used to read the blob.
+ * \param blobid The id of the blob.
+ * \param ext_dev Device to copy to.
+ * \param opts Copy options, NULL for the defaults.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			       spdk_blob_id blobid, struct spdk_bs_dev *ext_dev,
+			       const struct spdk_blob_copy_opts *opts,
+			       spdk_blob_op_complete cb_fn, void *cb_arg);
+
+struct spdk_blob_copy_progress {
+	/* Number of clusters to copy, may grow while the copy runs */
+	uint64_t clusters_total;
+
+	/* Number of clusters copied so far */
+	uint64_t clusters_done;
+
+	/* Time since the copy started */
+	uint64_t elapsed_ms;
+
+	/* Estimated time until the copy completes, 0 until the first cluster is copied */
+	uint64_t eta_ms;
+};
+
+/**
+ * Get the progress of an inflate, decouple parent or shallow copy of a blob.
+ * Must be called on the metadata thread.
+ *
+ * \param blob Blob.
+ * \param progress Filled in with the progress of the copy.
+ *
+ * \return 0 on success, -ENOENT if no copy of the blob is in progress.
+ */
+int spdk_blob_get_copy_progress(struct spdk_blob *blob, struct spdk_blob_copy_progress *progress);
+
 struct spdk_blob_open_opts {
 	enum blob_clear_method  clear_method;
 };
@@ -749,6 +930,9 @@ void spdk_blob_io_readv(struct spdk_blob *blob, struct spdk_io_channel *channel,
  * Unmap 'length' io_units beginning at 'offset' io_units on the blob as unused. Unmapped
  * io_units may allow the underlying storage media to behave more effciently.
  *
+ * Clusters of a thin provisioned blob without a parent that are entirely covered
+ * by the unmap are released back to the blobstore. They read as zeroes afterwards.
+ *
  * \param blob Blob to unmap.
  * \param channel I/O channel used to submit requests.
  * \param offset Offset is in io units from the beginning of the blob.
@@ -762,6 +946,9 @@ void spdk_blob_io_unmap(struct spdk_blob *blob, struct spdk_io_channel *channel,
 /**
  * Write zeros into area of a blob.
  *
+ * Clusters of a thin provisioned blob without a parent that are entirely covered
+ * are released back to the blobstore instead of being written.
+ *
  * \param blob Blob to write.
  * \param channel I/O channel used to submit requests.
  * \param offset Offset is in io units from the beginning of the blob.
@@ -795,6 +982,34 @@ void spdk_bs_iter_first(struct spdk_blob_store *bs,
 void spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *blob,
 		       spdk_blob_op_with_handle_complete cb_fn, void *cb_arg);
 
+/**
+ * Called by spdk_bs_for_each_blob() for every blob of the blobstore.
+ *
+ * \param cb_arg Argument passed to spdk_bs_for_each_blob().
+ * \param blob The opened blob. It is closed once this function returns.
+ *
+ * \return 0 to continue, negative errno to stop the traversal.
+ */
+typedef int (*spdk_blob_iter_fn)(void *cb_arg, struct spdk_blob *blob);
+
+/**
+ * Open every blob of the blobstore and pass it to the function fn. Unlike
+ * spdk_bs_iter_first()/spdk_bs_iter_next(), up to queue_depth blobs are
+ * opened at the same time, so blobs are not visited in any particular order.
+ *
+ * Blobs that fail to open are skipped. The traversal stops at the first blob
+ * for which fn returns an error, cb_fn is called with that error once all
+ * blobs opened so far are closed.
+ *
+ * \param bs blobstore to traverse.
+ * \param queue_depth Maximum number of blobs open at the same time.
+ * \param fn Called for each blob.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to functions fn and cb_fn.
+ */
+void spdk_bs_for_each_blob(struct spdk_blob_store *bs, uint32_t queue_depth,
+			   spdk_blob_iter_fn fn, spdk_bs_op_complete cb_fn, void *cb_arg);
+
 /**
  * Set an extended attribute for the given blob.
  *
@@ -61,6 +61,21 @@ struct spdk_bdev_module;
 struct spdk_bs_dev *spdk_bdev_create_bs_dev(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb,
 		void *remove_ctx);
 
+/**
+ * Create a read-only blobstore block device from a bdev.
+ *
+ * The bdev is opened without write access, so it can be shared, e.g. as
+ * the external snapshot of blobs in one or more blobstores.
+ *
+ * \param bdev Bdev to use.
+ * \param remove_cb Called when the block device is removed.
+ * \param remove_ctx Argument passed to function remove_cb.
+ *
+ * \return a pointer to the blobstore block device on success or NULL otherwise.
+ */
+struct spdk_bs_dev *spdk_bdev_create_bs_dev_ro(struct spdk_bdev *bdev,
+		spdk_bdev_remove_cb_t remove_cb, void *remove_ctx);
+
 /**
  * Claim the bdev module for the given blobstore.
  *
@@ -133,6 +133,30 @@ int spdk_copy_submit(struct spdk_copy_task *copy_req, struct spdk_io_channel *ch
 int spdk_copy_submit_fill(struct spdk_copy_task *copy_req, struct spdk_io_channel *ch,
 			  void *dst, uint8_t fill, uint64_t nbytes, spdk_copy_completion_cb cb);
 
+/**
+ * Submit a CRC-32C calculation request.
+ *
+ * This operation will calculate the partial CRC-32C checksum of the data
+ * described by the iovec array, starting from the given seed, exactly like
+ * spdk_crc32c_update() would. Requests submitted on the same channel may be
+ * batched and completed together, so the buffers must stay valid until the
+ * completion callback is called.
+ *
+ * \param copy_req Copy request task.
+ * \param ch I/O channel to submit request to the copy engine. This channel can
+ * be obtained by the function spdk_copy_engine_get_io_channel().
+ * \param dst Destination to write the CRC-32C value to.
+ * \param iovs The io vector array describing the data to checksum.
+ * \param iovcnt The size of the io vector array.
+ * \param seed Initial CRC-32C value.
+ * \param cb Called when this CRC-32C operation completes.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_copy_submit_crc32c(struct spdk_copy_task *copy_req, struct spdk_io_channel *ch,
+			    uint32_t *dst, struct iovec *iovs, uint32_t iovcnt, uint32_t seed,
+			    spdk_copy_completion_cb cb);
+
 /**
  * Get the size of copy task.
  *
@@ -102,6 +102,21 @@ uint32_t spdk_crc32_ieee_update(const void *buf, size_t len, uint32_t crc);
  */
 uint32_t spdk_crc32c_update(const void *buf, size_t len, uint32_t crc);
 
+/**
+ * Calculate partial CRC-32C checksums of several independent buffers.
+ *
+ * Where the CPU provides a CRC-32C instruction, the buffers are checksummed
+ * in an interleaved fashion, which hides the latency of the instruction and
+ * is considerably faster than checksumming the buffers one after another.
+ *
+ * \param bufs Array of count data buffers to checksum.
+ * \param lens Array of count buffer lengths in bytes.
+ * \param crcs Array of count previous CRC-32C values, updated in place.
+ * \param count Number of buffers.
+ */
+void spdk_crc32c_update_multi(const void *const *bufs, const size_t *lens, uint32_t *crcs,
+			      uint32_t count);
+
 #ifdef __cplusplus
 }
 #endif
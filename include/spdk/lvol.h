@@ -73,6 +73,15 @@ struct spdk_lvs_opts {
 	uint32_t		cluster_sz;
 	enum lvs_clear_method	clear_method;
 	char			name[SPDK_LVS_NAME_MAX];
+
+	/**
+	 * Creates the device backing lvols that are clones of an external
+	 * snapshot. See spdk_bs_opts.esnap_bs_dev_create.
+	 */
+	spdk_bs_esnap_dev_create esnap_bs_dev_create;
+
+	/** Context passed to esnap_bs_dev_create. */
+	void			*esnap_ctx;
 };
 
 /**
@@ -210,6 +219,26 @@ void spdk_lvol_create_snapshot(struct spdk_lvol *lvol, const char *snapshot_name
 void spdk_lvol_create_clone(struct spdk_lvol *lvol, const char *clone_name,
 			    spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg);
 
+/**
+ * Create clone of an external snapshot.
+ *
+ * Clusters that were not written yet are read from the device created by the
+ * esnap_bs_dev_create callback of the lvolstore for esnap_id.
+ *
+ * \param esnap_id Opaque identifier of the external snapshot.
+ * \param id_len Length of esnap_id in bytes.
+ * \param size_bytes Size of the clone, must be a multiple of the cluster size.
+ * \param lvs Handle to lvolstore.
+ * \param clone_name Name of created clone.
+ * \param cb_fn Completion callback.
+ * \param cb_arg Completion callback custom arguments.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_lvol_create_esnap_clone(const void *esnap_id, uint32_t id_len, uint64_t size_bytes,
+				 struct spdk_lvol_store *lvs, const char *clone_name,
+				 spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg);
+
 /**
  * Rename lvol with new_name.
  *
@@ -265,6 +294,20 @@ struct spdk_io_channel *spdk_lvol_get_io_channel(struct spdk_lvol *lvol);
 void spdk_lvs_load(struct spdk_bs_dev *bs_dev, spdk_lvs_op_with_handle_complete cb_fn,
 		   void *cb_arg);
 
+/**
+ * Load lvolstore from the given blobstore device with options.
+ *
+ * Only the external snapshot options are used, everything else is read from
+ * the lvolstore.
+ *
+ * \param bs_dev Pointer to the blobstore device.
+ * \param o Options for lvolstore.
+ * \param cb_fn Completion callback.
+ * \param cb_arg Completion callback custom arguments.
+ */
+void spdk_lvs_load_ext(struct spdk_bs_dev *bs_dev, const struct spdk_lvs_opts *o,
+		       spdk_lvs_op_with_handle_complete cb_fn, void *cb_arg);
+
 /**
  * Open a lvol.
  *
@@ -292,6 +335,43 @@ void spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void
  */
 void spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Inflate lvol, copying its clusters at the pace set by the copy options.
+ *
+ * \param lvol Handle to lvol
+ * \param opts Copy options, NULL for the defaults
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_inflate_ext(struct spdk_lvol *lvol, const struct spdk_blob_copy_opts *opts,
+			   spdk_lvol_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Decouple parent of lvol, copying its clusters at the pace set by the copy
+ * options.
+ *
+ * \param lvol Handle to lvol
+ * \param opts Copy options, NULL for the defaults
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_decouple_parent_ext(struct spdk_lvol *lvol, const struct spdk_blob_copy_opts *opts,
+				   spdk_lvol_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Copy the clusters a read-only lvol holds itself to a device, at the same
+ * offsets. Used to back up a snapshot without the data of its parents.
+ *
+ * \param lvol Handle to lvol
+ * \param ext_dev Device to copy to
+ * \param opts Copy options, NULL for the defaults
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
+			    const struct spdk_blob_copy_opts *opts,
+			    spdk_lvol_op_complete cb_fn, void *cb_arg);
+
 #ifdef __cplusplus
 }
 #endif
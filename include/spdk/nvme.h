@@ -152,7 +152,9 @@ struct spdk_nvme_ctrlr_opts {
 	 *
 	 * If the requested command set is not supported, the controller
 	 * initialization process will not proceed. By default, the NVM
-	 * command set is used.
+	 * command set is used, unless the controller supports selecting all of
+	 * its I/O command sets (\ref SPDK_NVME_CC_CSS_IOCS), which is then
+	 * selected instead so that zoned namespaces can be accessed.
 	 */
 	enum spdk_nvme_cc_css command_set;
 
@@ -323,6 +325,7 @@ enum spdk_nvme_ctrlr_flags {
 	SPDK_NVME_CTRLR_SGL_SUPPORTED			= 0x1, /**< The SGL is supported */
 	SPDK_NVME_CTRLR_SECURITY_SEND_RECV_SUPPORTED	= 0x2, /**< security send/receive is supported */
 	SPDK_NVME_CTRLR_WRR_SUPPORTED			= 0x4, /**< Weighted Round Robin is supported */
+	SPDK_NVME_CTRLR_CMB_IO_DATA_SUPPORTED		= 0x8, /**< CMB can hold I/O data buffers */
 };
 
 /**
@@ -646,7 +649,8 @@ struct spdk_nvme_probe_ctx *spdk_nvme_probe_async(const struct spdk_nvme_transpo
  * is also freed and no longer valid.
  * \return -EAGAIN if there are still pending probe operations; user must call
  * spdk_nvme_probe_poll_async again to continue progress.
- * \return value other than 0 and -EAGAIN probe error with one controller.
+ * \return value other than 0 and -EAGAIN if one or more controllers failed to
+ * initialize. The other controllers have been attached and the probe_ctx is freed.
  */
 int spdk_nvme_probe_poll_async(struct spdk_nvme_probe_ctx *probe_ctx);
 
@@ -1271,6 +1275,32 @@ int spdk_nvme_ctrlr_cmd_abort(struct spdk_nvme_ctrlr *ctrlr,
 			      spdk_nvme_cmd_cb cb_fn,
 			      void *cb_arg);
 
+/**
+ * Abort previously submitted NVMe commands by the callback argument they were
+ * submitted with.
+ *
+ * All commands on the queue pair whose callback argument matches cmd_cb_arg are
+ * aborted. This includes every child of a request that was split by the driver.
+ * Matching requests that were not yet sent to the controller are completed right
+ * away with SPDK_NVME_SC_ABORTED_BY_REQUEST status.
+ *
+ * \param ctrlr NVMe controller to which the commands were submitted.
+ * \param qpair NVMe queue pair to which the commands were submitted. For admin
+ *  commands, pass NULL for the qpair.
+ * \param cmd_cb_arg Callback argument of the commands to abort.
+ * \param cb_fn Callback function to invoke when all aborts have completed. Bit 0
+ * of dword 0 of the completion is set if any of the commands was not aborted.
+ * \param cb_arg Argument to pass to the callback function.
+ *
+ * \return 0 if successfully submitted, -ENOENT if no command matched cmd_cb_arg,
+ * negated errno value otherwise.
+ */
+int spdk_nvme_ctrlr_cmd_abort_ext(struct spdk_nvme_ctrlr *ctrlr,
+				  struct spdk_nvme_qpair *qpair,
+				  void *cmd_cb_arg,
+				  spdk_nvme_cmd_cb cb_fn,
+				  void *cb_arg);
+
 /**
  * Set specific feature for the given NVMe controller.
  *
@@ -1435,6 +1465,43 @@ int spdk_nvme_ctrlr_security_send(struct spdk_nvme_ctrlr *ctrlr, uint8_t secp,
  */
 uint64_t spdk_nvme_ctrlr_get_flags(struct spdk_nvme_ctrlr *ctrlr);
 
+/**
+ * Time spent in each phase of the controller initialization, in microseconds.
+ */
+struct spdk_nvme_ctrlr_init_stats {
+	/** Transport specific construction, including the connection of the admin queue. */
+	uint64_t construct_us;
+
+	/** Controller reset and enable (CC.EN and CSTS.RDY handshake). */
+	uint64_t enable_us;
+
+	/** Identify Controller and negotiation of the number of I/O queues. */
+	uint64_t identify_us;
+
+	/** Retrieval of the active namespace list and of the namespace identify data. */
+	uint64_t namespaces_us;
+
+	/** Asynchronous events, log pages, features, doorbell buffer, keep alive and host ID. */
+	uint64_t configure_us;
+
+	/** Sum of all of the phases above. */
+	uint64_t total_us;
+};
+
+/**
+ * Get the time spent in each phase of the controller initialization.
+ *
+ * The construction time refers to the attach of the controller. The other
+ * phases refer to the most recent initialization, which is the attach or the
+ * latest reset of the controller. Phases that have not completed yet are
+ * reported as 0.
+ *
+ * \param ctrlr NVMe controller to query.
+ * \param stats Filled with the initialization timings.
+ */
+void spdk_nvme_ctrlr_get_init_stats(struct spdk_nvme_ctrlr *ctrlr,
+				    struct spdk_nvme_ctrlr_init_stats *stats);
+
 /**
  * Attach the specified namespace to controllers.
  *
@@ -1552,7 +1619,7 @@ int spdk_nvme_ctrlr_update_firmware(struct spdk_nvme_ctrlr *ctrlr, void *payload
 volatile struct spdk_nvme_registers *spdk_nvme_ctrlr_get_registers(struct spdk_nvme_ctrlr *ctrlr);
 
 /**
- * Allocate an I/O buffer from the controller memory buffer (Experimental).
+ * Allocate an I/O buffer from the controller memory buffer.
  *
  * This function allocates registered memory which belongs to the Controller
  * Memory Buffer (CMB) of the specified NVMe controller. Note that the CMB has
@@ -1560,6 +1627,9 @@ volatile struct spdk_nvme_registers *spdk_nvme_ctrlr_get_registers(struct spdk_n
  * Also, due to vtophys contraints the CMB must be at least 4MiB in size. Free
  * memory allocated with this function using spdk_nvme_ctrlr_free_cmb_io_buffer().
  *
+ * Buffers allocated here may be used as the data buffers of I/O submitted to
+ * the same controller. Allocations are rounded up to 4KiB.
+ *
  * \param ctrlr Controller from which to allocate memory buffer.
  * \param size Size of buffer to allocate in bytes.
  *
@@ -1569,14 +1639,14 @@ volatile struct spdk_nvme_registers *spdk_nvme_ctrlr_get_registers(struct spdk_n
 void *spdk_nvme_ctrlr_alloc_cmb_io_buffer(struct spdk_nvme_ctrlr *ctrlr, size_t size);
 
 /**
- * Free a controller memory I/O buffer (Experimental).
+ * Free a controller memory I/O buffer.
  *
- * Note this function is currently a NOP which is one reason why this and
- * spdk_nvme_ctrlr_alloc_cmb_io_buffer() are currently marked as experimental.
+ * The space is returned to the controller memory buffer and may be handed out
+ * again by a later call to spdk_nvme_ctrlr_alloc_cmb_io_buffer().
  *
  * \param ctrlr Controller from which the buffer was allocated.
  * \param buf Buffer previously allocated by spdk_nvme_ctrlr_alloc_cmb_io_buffer().
- * \param size Size of buf in bytes.
+ * \param size Size of buf in bytes. Must match the size passed at allocation time.
  */
 void spdk_nvme_ctrlr_free_cmb_io_buffer(struct spdk_nvme_ctrlr *ctrlr, void *buf, size_t size);
 
@@ -1774,6 +1844,16 @@ uint32_t spdk_nvme_ns_get_optimal_io_boundary(struct spdk_nvme_ns *ns);
  */
 const struct spdk_uuid *spdk_nvme_ns_get_uuid(const struct spdk_nvme_ns *ns);
 
+/**
+ * Get the Command Set Identifier for the given namespace.
+ *
+ * \param ns Namespace to query.
+ *
+ * \return the namespace Command Set Identifier. Namespaces that do not report
+ * one use the NVM command set.
+ */
+enum spdk_nvme_csi spdk_nvme_ns_get_csi(const struct spdk_nvme_ns *ns);
+
 /**
  * \brief Namespace command support flags.
  */
@@ -116,14 +116,14 @@ SPDK_STATIC_ASSERT(sizeof(union spdk_nvme_cap_register) == 8, "Incorrect size");
 
 /**
  * I/O Command Set Selected
- *
- * Only a single command set is defined as of NVMe 1.3 (NVM).
  */
 enum spdk_nvme_cc_css {
 	SPDK_NVME_CC_CSS_NVM		= 0x0,	/**< NVM command set */
+	SPDK_NVME_CC_CSS_IOCS		= 0x6,	/**< All supported I/O command sets */
 };
 
 #define SPDK_NVME_CAP_CSS_NVM (1u << SPDK_NVME_CC_CSS_NVM) /**< NVM command set supported */
+#define SPDK_NVME_CAP_CSS_IOCS (1u << SPDK_NVME_CC_CSS_IOCS) /**< One or more I/O command sets supported */
 
 union spdk_nvme_cc_register {
 	uint32_t	raw;
@@ -676,6 +676,9 @@ enum spdk_nvme_media_error_status_code {
  */
 enum spdk_nvme_path_status_code {
 	SPDK_NVME_SC_INTERNAL_PATH_ERROR		= 0x00,
+	SPDK_NVME_SC_ASYMMETRIC_ACCESS_PERSISTENT_LOSS	= 0x01,
+	SPDK_NVME_SC_ASYMMETRIC_ACCESS_INACCESSIBLE	= 0x02,
+	SPDK_NVME_SC_ASYMMETRIC_ACCESS_TRANSITION	= 0x03,
 
 	SPDK_NVME_SC_CONTROLLER_PATH_ERROR		= 0x60,
 
@@ -877,6 +880,12 @@ enum spdk_nvme_identify_cns {
 	/** List namespace identification descriptors */
 	SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST	= 0x03,
 
+	/** Identify I/O command set specific namespace data for CDW11.CSI */
+	SPDK_NVME_IDENTIFY_NS_IOCS			= 0x05,
+
+	/** Identify I/O command set specific controller data for CDW11.CSI */
+	SPDK_NVME_IDENTIFY_CTRLR_IOCS			= 0x06,
+
 	/** List allocated NSIDs greater than CDW1.NSID */
 	SPDK_NVME_IDENTIFY_ALLOCATED_NS_LIST		= 0x10,
 
@@ -964,7 +973,8 @@ struct __attribute__((packed)) __attribute__((aligned)) spdk_nvme_ctrlr_data {
 		uint8_t multi_port	: 1;
 		uint8_t multi_host	: 1;
 		uint8_t sr_iov		: 1;
-		uint8_t reserved	: 5;
+		uint8_t ana_reporting	: 1;
+		uint8_t reserved	: 4;
 	} cmic;
 
 	/** maximum data transfer size */
@@ -992,7 +1002,12 @@ struct __attribute__((packed)) __attribute__((aligned)) spdk_nvme_ctrlr_data {
 		/** Supports sending Firmware Activation Notices. */
 		uint32_t	fw_activation_notices : 1;
 
-		uint32_t	reserved2 : 22;
+		uint32_t	reserved2 : 1;
+
+		/** Supports Asymmetric Namespace Access Change Notices. */
+		uint32_t	ana_change_notices : 1;
+
+		uint32_t	reserved3 : 20;
 	} oaes;
 
 	/** controller attributes */
@@ -1192,7 +1207,54 @@ struct __attribute__((packed)) __attribute__((aligned)) spdk_nvme_ctrlr_data {
 		} bits;
 	} sanicap;
 
-	uint8_t			reserved3[180];
+	/** Host memory buffer minimum descriptor entry size */
+	uint32_t		hmminds;
+
+	/** NVM set identifier maximum */
+	uint16_t		nsetidmax;
+
+	/** Endurance group identifier maximum */
+	uint16_t		endgidmax;
+
+	/** ANA transition time, in seconds */
+	uint8_t			anatt;
+
+	/** Asymmetric namespace access capabilities */
+	union {
+		uint8_t		raw;
+		struct {
+			/** reports ANA optimized state */
+			uint8_t	ana_optimized_state : 1;
+
+			/** reports ANA non-optimized state */
+			uint8_t	ana_non_optimized_state : 1;
+
+			/** reports ANA inaccessible state */
+			uint8_t	ana_inaccessible_state : 1;
+
+			/** reports ANA persistent loss state */
+			uint8_t	ana_persistent_loss_state : 1;
+
+			/** reports ANA change state */
+			uint8_t	ana_change_state : 1;
+
+			uint8_t	reserved : 1;
+
+			/** ANAGRPID field in the Identify Namespace does not change */
+			uint8_t	no_change_anagrpid : 1;
+
+			/** non-zero ANAGRPID field in the Identify Namespace is supported */
+			uint8_t	non_zero_anagrpid : 1;
+		} bits;
+	} anacap;
+
+	/** ANA group identifier maximum */
+	uint32_t		anagrpmax;
+
+	/** Number of ANA group identifiers */
+	uint32_t		nanagrpid;
+
+	uint8_t			reserved3[162];
 
 	/* bytes 512-703: nvm command set attributes */
 
@@ -1554,7 +1616,26 @@ struct spdk_nvme_ns_data {
 	/** NVM capacity */
 	uint64_t		nvmcap[2];
 
-	uint8_t			reserved64[40];
+	uint8_t			reserved64[28];
+
+	/** ANA group identifier */
+	uint32_t		anagrpid;
+
+	uint8_t			reserved96[3];
+
+	/** namespace attributes */
+	struct {
+		/** namespace is currently write protected */
+		uint8_t		write_protected : 1;
+
+		uint8_t		reserved : 7;
+	} nsattr;
+
+	/** NVM set identifier */
+	uint16_t		nvmsetid;
+
+	/** Endurance group identifier */
+	uint16_t		endgid;
 
 	/** namespace globally unique identifier */
 	uint8_t			nguid[16];
@@ -1798,7 +1879,12 @@ enum spdk_nvme_log_page {
 	/** Controller initiated telemetry log (optional) */
 	SPDK_NVME_LOG_TELEMETRY_CTRLR_INITIATED	= 0x08,
 
-	/* 0x09-0x6F - reserved */
+	/* 0x09-0x0B - reserved */
+
+	/** Asymmetric namespace access (optional) */
+	SPDK_NVME_LOG_ASYMMETRIC_NAMESPACE_ACCESS	= 0x0C,
+
+	/* 0x0D-0x6F - reserved */
 
 	/** Discovery(refer to the NVMe over Fabrics specification) */
 	SPDK_NVME_LOG_DISCOVERY		= 0x70,
@@ -2060,8 +2146,10 @@ enum spdk_nvme_async_event_info_notice {
 	SPDK_NVME_ASYNC_EVENT_FW_ACTIVATION_START	= 0x1,
 	/* Telemetry Log Changed */
 	SPDK_NVME_ASYNC_EVENT_TELEMETRY_LOG_CHANGED	= 0x2,
+	/* Asymmetric Namespace Access Change */
+	SPDK_NVME_ASYNC_EVENT_ANA_CHANGE		= 0x3,
 
-	/* 0x3 - 0xFF Reserved */
+	/* 0x4 - 0xFF Reserved */
 };
 
 /**
@@ -2270,7 +2358,8 @@ union spdk_nvme_feat_async_event_configuration {
 		uint32_t ns_attr_notice		: 1;
 		uint32_t fw_activation_notice	: 1;
 		uint32_t telemetry_log_notice	: 1;
-		uint32_t reserved		: 21;
+		uint32_t ana_change_notice	: 1;
+		uint32_t reserved		: 20;
 	} bits;
 };
 SPDK_STATIC_ASSERT(sizeof(union spdk_nvme_feat_async_event_configuration) == 4, "Incorrect size");
@@ -2397,6 +2486,48 @@ struct spdk_nvme_firmware_page {
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_firmware_page) == 512, "Incorrect size");
 
+/**
+ * Asymmetric Namespace Access states
+ */
+enum spdk_nvme_ana_state {
+	SPDK_NVME_ANA_OPTIMIZED_STATE		= 0x1,
+	SPDK_NVME_ANA_NON_OPTIMIZED_STATE	= 0x2,
+	SPDK_NVME_ANA_INACCESSIBLE_STATE	= 0x3,
+	SPDK_NVME_ANA_PERSISTENT_LOSS_STATE	= 0x4,
+	SPDK_NVME_ANA_CHANGE_STATE		= 0xF,
+};
+
+/**
+ * ANA group descriptor, following the header of the
+ * asymmetric namespace access log page (\ref SPDK_NVME_LOG_ASYMMETRIC_NAMESPACE_ACCESS)
+ */
+struct spdk_nvme_ana_group_descriptor {
+	uint32_t	ana_group_id;
+	uint32_t	num_of_nsid;
+	uint64_t	change_count;
+
+	uint8_t		ana_state : 4;
+	uint8_t		reserved0 : 4;
+
+	uint8_t		reserved1[15];
+
+	uint32_t	nsid[];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ana_group_descriptor) == 32, "Incorrect size");
+
+/**
+ * Asymmetric namespace access log page header (\ref SPDK_NVME_LOG_ASYMMETRIC_NAMESPACE_ACCESS)
+ */
+struct spdk_nvme_ana_page {
+	uint64_t	change_count;
+	uint16_t	num_ana_group_desc;
+	uint8_t		reserved[6];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ana_page) == 16, "Incorrect size");
+
+/* Get Log Page LSP field: return only the ANA group descriptors, without the namespace lists */
+#define SPDK_NVME_ANA_LOG_RGO	0x1
+
 /**
  * Namespace attachment Type Encoding
  */
@@ -2442,6 +2573,23 @@ enum spdk_nvme_nidt {
 
 	/** Namespace UUID */
 	SPDK_NVME_NIDT_UUID		= 0x03,
+
+	/** Command Set Identifier */
+	SPDK_NVME_NIDT_CSI		= 0x04,
+};
+
+/**
+ * Command Set Identifier (CSI)
+ */
+enum spdk_nvme_csi {
+	/** NVM command set */
+	SPDK_NVME_CSI_NVM		= 0x0,
+
+	/** Key Value command set */
+	SPDK_NVME_CSI_KV		= 0x1,
+
+	/** Zoned Namespace command set */
+	SPDK_NVME_CSI_ZNS		= 0x2,
 };
 
 struct spdk_nvme_ns_id_desc {
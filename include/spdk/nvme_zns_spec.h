@@ -0,0 +1,262 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * Zoned Namespace Command Set specification definitions
+ */
+
+#ifndef SPDK_NVME_ZNS_SPEC_H
+#define SPDK_NVME_ZNS_SPEC_H
+
+#include "spdk/stdinc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "spdk/assert.h"
+#include "spdk/nvme_spec.h"
+
+/**
+ * Zoned Namespace Command Set opcodes
+ */
+enum spdk_nvme_zns_opcode {
+	SPDK_NVME_OPC_ZONE_MGMT_SEND			= 0x79,
+	SPDK_NVME_OPC_ZONE_MGMT_RECV			= 0x7a,
+	SPDK_NVME_OPC_ZONE_APPEND			= 0x7d,
+};
+
+/**
+ * Zoned Namespace Command Set specific status codes
+ * (status code type \ref SPDK_NVME_SCT_COMMAND_SPECIFIC)
+ */
+enum spdk_nvme_zns_status_code {
+	SPDK_NVME_SC_ZONE_BOUNDARY_ERROR		= 0xb8,
+	SPDK_NVME_SC_ZONE_IS_FULL			= 0xb9,
+	SPDK_NVME_SC_ZONE_IS_READ_ONLY			= 0xba,
+	SPDK_NVME_SC_ZONE_IS_OFFLINE			= 0xbb,
+	SPDK_NVME_SC_ZONE_INVALID_WRITE			= 0xbc,
+	SPDK_NVME_SC_TOO_MANY_ACTIVE_ZONES		= 0xbd,
+	SPDK_NVME_SC_TOO_MANY_OPEN_ZONES		= 0xbe,
+	SPDK_NVME_SC_INVALID_ZONE_STATE_TRANSITION	= 0xbf,
+};
+
+/**
+ * Zone Send Action (ZSA) of the Zone Management Send command
+ */
+enum spdk_nvme_zns_zone_send_action {
+	SPDK_NVME_ZONE_CLOSE				= 0x1,
+	SPDK_NVME_ZONE_FINISH				= 0x2,
+	SPDK_NVME_ZONE_OPEN				= 0x3,
+	SPDK_NVME_ZONE_RESET				= 0x4,
+	SPDK_NVME_ZONE_OFFLINE				= 0x5,
+	SPDK_NVME_ZONE_SET_ZDE				= 0x10,
+};
+
+/**
+ * Zone Receive Action (ZRA) of the Zone Management Receive command
+ */
+enum spdk_nvme_zns_zone_receive_action {
+	SPDK_NVME_ZONE_REPORT				= 0x0,
+	SPDK_NVME_ZONE_EXTENDED_REPORT			= 0x1,
+};
+
+/**
+ * Zone Receive Action Specific field (zone state filter) of a zone report
+ */
+enum spdk_nvme_zns_zra_report_opts {
+	SPDK_NVME_ZRA_LIST_ALL				= 0x0,
+	SPDK_NVME_ZRA_LIST_ZSE				= 0x1,
+	SPDK_NVME_ZRA_LIST_ZSIO				= 0x2,
+	SPDK_NVME_ZRA_LIST_ZSEO				= 0x3,
+	SPDK_NVME_ZRA_LIST_ZSC				= 0x4,
+	SPDK_NVME_ZRA_LIST_ZSF				= 0x5,
+	SPDK_NVME_ZRA_LIST_ZSRO				= 0x6,
+	SPDK_NVME_ZRA_LIST_ZSO				= 0x7,
+};
+
+/**
+ * Zone type reported in a zone descriptor
+ */
+enum spdk_nvme_zns_zone_type {
+	SPDK_NVME_ZONE_TYPE_SEQWR			= 0x2,
+};
+
+/**
+ * Zone state reported in a zone descriptor
+ */
+enum spdk_nvme_zns_zone_state {
+	SPDK_NVME_ZONE_STATE_EMPTY			= 0x1,
+	SPDK_NVME_ZONE_STATE_IOPEN			= 0x2,
+	SPDK_NVME_ZONE_STATE_EOPEN			= 0x3,
+	SPDK_NVME_ZONE_STATE_CLOSED			= 0x4,
+	SPDK_NVME_ZONE_STATE_RONLY			= 0xd,
+	SPDK_NVME_ZONE_STATE_FULL			= 0xe,
+	SPDK_NVME_ZONE_STATE_OFFLINE			= 0xf,
+};
+
+/**
+ * Identify Namespace data structure for the Zoned Namespace Command Set
+ * (CNS 05h, CSI 02h)
+ */
+struct spdk_nvme_zns_ns_data {
+	/** zone operation characteristics */
+	struct {
+		/** variable zone capacity */
+		uint16_t variable_zone_capacity	: 1;
+
+		/** zone active excursions */
+		uint16_t zone_active_excursions	: 1;
+
+		uint16_t reserved		: 14;
+	} zoc;
+
+	/** optional zoned command support */
+	struct {
+		/** read across zone boundaries supported */
+		uint16_t read_across_zone_boundaries	: 1;
+
+		uint16_t reserved			: 15;
+	} ozcs;
+
+	/** maximum active resources (0's based, 0xffffffff means no limit) */
+	uint32_t	mar;
+
+	/** maximum open resources (0's based, 0xffffffff means no limit) */
+	uint32_t	mor;
+
+	/** reset recommended limit */
+	uint32_t	rrl;
+
+	/** finish recommended limit */
+	uint32_t	frl;
+
+	uint8_t		reserved20[2796];
+
+	/** LBA format extensions, indexed like the LBA formats of the Identify Namespace data */
+	struct {
+		/** zone size in logical blocks */
+		uint64_t	zsze;
+
+		/** zone descriptor extension size in 64 byte units */
+		uint8_t		zdes;
+
+		uint8_t		reserved9[7];
+	} lbafe[16];
+
+	uint8_t		reserved3072[768];
+
+	/** vendor specific */
+	uint8_t		vendor_specific[256];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_ns_data) == 4096, "Incorrect size");
+
+/**
+ * Identify Controller data structure for the Zoned Namespace Command Set
+ * (CNS 06h, CSI 02h)
+ */
+struct spdk_nvme_zns_ctrlr_data {
+	/** zone append size limit, a power of two in units of the minimum memory page size */
+	uint8_t		zasl;
+
+	uint8_t		reserved1[4095];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_ctrlr_data) == 4096, "Incorrect size");
+
+/**
+ * Zone descriptor returned by the Zone Management Receive command
+ */
+struct spdk_nvme_zns_zone_desc {
+	/** zone type, see \ref spdk_nvme_zns_zone_type */
+	uint8_t		zt		: 4;
+	uint8_t		reserved0	: 4;
+
+	uint8_t		reserved1	: 4;
+	/** zone state, see \ref spdk_nvme_zns_zone_state */
+	uint8_t		zs		: 4;
+
+	/** zone attributes */
+	union {
+		uint8_t raw;
+
+		struct {
+			/** zone finished by controller */
+			uint8_t zfc	: 1;
+
+			/** finish zone recommended */
+			uint8_t fzr	: 1;
+
+			/** reset zone recommended */
+			uint8_t rzr	: 1;
+
+			uint8_t reserved3 : 4;
+
+			/** zone descriptor extension valid */
+			uint8_t zdev	: 1;
+		} bits;
+	} za;
+
+	uint8_t		reserved3[5];
+
+	/** zone capacity in logical blocks */
+	uint64_t	zcap;
+
+	/** zone start logical block address */
+	uint64_t	zslba;
+
+	/** write pointer */
+	uint64_t	wp;
+
+	uint8_t		reserved32[32];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_zone_desc) == 64, "Incorrect size");
+
+/**
+ * Zone report returned by the Zone Management Receive command
+ */
+struct spdk_nvme_zns_zone_report {
+	/** number of zone descriptors following the header */
+	uint64_t				nr_zones;
+
+	uint8_t					reserved8[56];
+
+	struct spdk_nvme_zns_zone_desc		descs[];
+};
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_zns_zone_report) == 64, "Incorrect size");
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -84,6 +84,7 @@ struct spdk_nvmf_transport_opts {
 	bool		c2h_success;
 	bool		dif_insert_or_strip;
 	uint32_t	sock_priority;
+	uint32_t	max_inline_data_size;
 };
 
 struct spdk_nvmf_poll_group_stat {
@@ -101,10 +102,22 @@ struct spdk_nvmf_rdma_device_stat {
 	uint64_t pending_free_request;
 	uint64_t pending_rdma_read;
 	uint64_t pending_rdma_write;
+	uint64_t inline_data_wrs;
+	uint64_t send_wrs;
+	uint64_t send_doorbells;
+	uint64_t recv_wrs;
+	uint64_t recv_doorbells;
 };
 
 struct spdk_nvmf_transport_poll_group_stat {
 	spdk_nvme_transport_type_t trtype;
+	/* NUMA socket of the data buffer pool, -1 if it isn't bound to one */
+	int32_t numa_socket;
+	uint32_t buf_cache_size;
+	uint32_t buf_cache_count;
+	uint64_t buf_cache_misses;
+	uint64_t buf_waits;
+	uint64_t buf_pool_exhausted;
 	union {
 		struct {
 			uint64_t pending_data_buffer;
@@ -587,6 +600,39 @@ struct spdk_nvmf_listener *spdk_nvmf_subsystem_get_next_listener(
 const struct spdk_nvme_transport_id *spdk_nvmf_listener_get_trid(
 	struct spdk_nvmf_listener *listener);
 
+/**
+ * Get the asymmetric namespace access state of an ANA group as reported
+ * through a listen address.
+ *
+ * \param listener This listener.
+ * \param anagrpid ANA group ID to query.
+ *
+ * \return the ANA state of the group on this listener.
+ */
+enum spdk_nvme_ana_state spdk_nvmf_listener_get_ana_state(struct spdk_nvmf_listener *listener,
+		uint32_t anagrpid);
+
+/**
+ * Change the asymmetric namespace access state of a listen address.
+ *
+ * The subsystem does not need to be paused. Every controller that connected
+ * through the listen address is sent an ANA change asynchronous event.
+ *
+ * \param subsystem Subsystem the listener belongs to.
+ * \param trid The listen address to update.
+ * \param ana_state New ANA state. SPDK_NVME_ANA_CHANGE_STATE may not be set directly.
+ * \param anagrpid ANA group ID to update, or 0 to update all ANA groups.
+ * \param cb_fn A function that will be called once all controllers were notified.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, or negated errno on failure. The callback provided will only
+ * be called on success.
+ */
+int spdk_nvmf_subsystem_set_ana_state(struct spdk_nvmf_subsystem *subsystem,
+				      const struct spdk_nvme_transport_id *trid,
+				      enum spdk_nvme_ana_state ana_state, uint32_t anagrpid,
+				      spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg);
+
 /** NVMe-oF target namespace creation options */
 struct spdk_nvmf_ns_opts {
 	/**
@@ -616,6 +662,13 @@ struct spdk_nvmf_ns_opts {
 	 * Fill with 0s if not specified.
 	 */
 	struct spdk_uuid uuid;
+
+	/**
+	 * ANA group ID
+	 *
+	 * Set to 0 to use the namespace ID as the ANA group ID.
+	 */
+	uint32_t anagrpid;
 };
 
 /**
@@ -655,6 +708,50 @@ uint32_t spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struc
  */
 int spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid);
 
+/**
+ * Add a namespace to a subsystem without pausing it.
+ *
+ * On an ACTIVE subsystem the namespace is attached to each poll group in
+ * turn while the other namespaces keep serving I/O, and connected hosts are
+ * notified with a Namespace Attribute Changed event. On PAUSED or INACTIVE
+ * subsystems this behaves like spdk_nvmf_subsystem_add_ns().
+ *
+ * \param subsystem Subsystem to add namespace to.
+ * \param bdev Block device to add as a namespace.
+ * \param opts Namespace options, or NULL to use defaults.
+ * \param opts_size sizeof(*opts)
+ * \param ptpl_file Persist through power loss file path.
+ * \param cb_fn Function to call once every poll group can access the namespace.
+ * Only called if a valid NSID is returned.
+ * \param cb_arg Argument to pass to cb_fn.
+ *
+ * \return newly added NSID on success, or 0 on failure.
+ */
+uint32_t spdk_nvmf_subsystem_hot_add_ns(struct spdk_nvmf_subsystem *subsystem,
+					struct spdk_bdev *bdev,
+					const struct spdk_nvmf_ns_opts *opts, size_t opts_size,
+					const char *ptpl_file,
+					spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg);
+
+/**
+ * Remove a namespace from a subsystem without pausing it.
+ *
+ * On an ACTIVE subsystem the namespace is detached from each poll group once
+ * the I/O outstanding to it there has completed, while the other namespaces
+ * keep serving I/O. On PAUSED or INACTIVE subsystems this behaves like
+ * spdk_nvmf_subsystem_remove_ns().
+ *
+ * \param subsystem Subsystem the namespace belong to.
+ * \param nsid Namespace ID to be removed.
+ * \param cb_fn Function to call once the namespace has been released.
+ * Only called if 0 is returned.
+ * \param cb_arg Argument to pass to cb_fn.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_nvmf_subsystem_hot_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				      spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg);
+
 /**
  * Get the first allocated namespace in a subsystem.
  *
@@ -725,6 +822,214 @@ struct spdk_bdev *spdk_nvmf_ns_get_bdev(struct spdk_nvmf_ns *ns);
 void spdk_nvmf_ns_get_opts(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_opts *opts,
 			   size_t opts_size);
 
+/** Default number of I/O a poll group dispatches to a scheduled namespace at once */
+#define SPDK_NVMF_NS_SCHED_DEFAULT_MAX_OUTSTANDING	128
+
+/** Namespace I/O scheduler options */
+struct spdk_nvmf_ns_sched_opts {
+	/**
+	 * Queue the I/O to the namespace per host and dispatch it in weighted
+	 * round robin order.
+	 */
+	bool enabled;
+
+	/**
+	 * I/O each poll group dispatches to the namespace before the rest is
+	 * queued. 0 for no limit, in which case only the host rate limits apply.
+	 */
+	uint32_t max_outstanding;
+};
+
+/** Namespace I/O scheduler options of a single host */
+struct spdk_nvmf_ns_sched_host_opts {
+	/** Share of the namespace relative to the other hosts. 0 selects the default of 1. */
+	uint32_t weight;
+
+	/** I/O per second the host may send to the namespace, 0 for no limit */
+	uint64_t rw_ios_per_sec;
+
+	/** Megabytes per second the host may transfer to and from the namespace, 0 for no limit */
+	uint64_t rw_mbytes_per_sec;
+};
+
+/** Namespace I/O scheduler statistics of a single host */
+struct spdk_nvmf_ns_sched_host_stat {
+	char hostnqn[SPDK_NVMF_NQN_MAX_LEN + 1];
+
+	/** I/O dispatched to the namespace */
+	uint64_t ios;
+
+	/** I/O that had to be queued before it was dispatched */
+	uint64_t queued_ios;
+
+	/** I/O queued because the host exceeded its rate limit */
+	uint64_t throttled_ios;
+
+	/** Total and longest time the I/O spent queued, in ticks */
+	uint64_t queue_ticks;
+	uint64_t max_queue_ticks;
+
+	/** I/O currently queued */
+	uint32_t queue_depth;
+};
+
+/**
+ * Configure the I/O scheduler of a namespace.
+ *
+ * May only be performed on subsystems in the PAUSED or INACTIVE states. The
+ * poll groups pick up the new configuration when the subsystem is resumed.
+ *
+ * The scheduler queues the I/O to the namespace per host and, once
+ * max_outstanding I/O are in flight on a poll group, dispatches it in deficit
+ * round robin order. Each round a host may dispatch its weight times the
+ * arbitration burst its controller set with the Arbitration feature.
+ *
+ * \param subsystem Subsystem the namespace belongs to.
+ * \param nsid Namespace ID to configure.
+ * \param opts Scheduler options.
+ * \param cb_fn Function to call once the configuration was stored.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, or negated errno on failure. The callback provided will only
+ * be called on success.
+ */
+int spdk_nvmf_subsystem_set_ns_sched(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				     const struct spdk_nvmf_ns_sched_opts *opts,
+				     spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg);
+
+/**
+ * Configure the share and rate limits of a host in the I/O scheduler of a namespace.
+ *
+ * May only be performed on subsystems in the PAUSED or INACTIVE states. Hosts
+ * that were not configured get a weight of 1 and no rate limits. The rate
+ * limits are split evenly across the poll groups.
+ *
+ * \param subsystem Subsystem the namespace belongs to.
+ * \param nsid Namespace ID to configure.
+ * \param hostnqn NQN of the host.
+ * \param opts Host options.
+ *
+ * \return 0 on success, or negated errno on failure.
+ */
+int spdk_nvmf_subsystem_set_ns_sched_host(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+		const char *hostnqn,
+		const struct spdk_nvmf_ns_sched_host_opts *opts);
+
+/**
+ * Get the I/O scheduler options of a namespace.
+ *
+ * \param ns Namespace to query.
+ * \param opts Output parameter for options.
+ */
+void spdk_nvmf_ns_get_sched_opts(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_sched_opts *opts);
+
+/**
+ * Function to be called with the I/O scheduler statistics of a namespace.
+ *
+ * \param cb_arg Argument passed to spdk_nvmf_subsystem_get_ns_sched_stats().
+ * \param status 0 on success, or negated errno on failure.
+ * \param stats Statistics of each host that sent I/O to the namespace, summed
+ * over all poll groups. Only valid for the duration of the call.
+ * \param num_stats Number of entries in stats.
+ */
+typedef void (*spdk_nvmf_ns_sched_stats_fn)(void *cb_arg, int status,
+		const struct spdk_nvmf_ns_sched_host_stat *stats,
+		uint32_t num_stats);
+
+/**
+ * Collect the I/O scheduler statistics of a namespace from all poll groups.
+ *
+ * \param subsystem Subsystem the namespace belongs to.
+ * \param nsid Namespace ID to query.
+ * \param cb_fn Function to call with the statistics.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, or negated errno on failure. The callback provided will only
+ * be called on success.
+ */
+int spdk_nvmf_subsystem_get_ns_sched_stats(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+		spdk_nvmf_ns_sched_stats_fn cb_fn, void *cb_arg);
+
+#define SPDK_NVMF_NS_CACHE_DEFAULT_LINE_SIZE	(64 * 1024)
+
+/** Namespace read cache options */
+struct spdk_nvmf_ns_cache_opts {
+	/** Memory the cache may use for data, in megabytes. 0 disables the cache. */
+	uint64_t size_mb;
+
+	/**
+	 * Unit the namespace is cached in, in bytes. Must be a multiple of the
+	 * block size. 0 selects SPDK_NVMF_NS_CACHE_DEFAULT_LINE_SIZE.
+	 */
+	uint32_t line_size;
+};
+
+/** Namespace read cache statistics */
+struct spdk_nvmf_ns_cache_stats {
+	/** Reads served entirely from the cache */
+	uint64_t hits;
+
+	/** Reads that filled at least one line from the bdev */
+	uint64_t misses;
+
+	/** Reads that went straight to the bdev, e.g. because the cache was full of in-use lines */
+	uint64_t bypassed;
+
+	/** Lines read from the bdev into the cache */
+	uint64_t fills;
+
+	/** Lines dropped to make room for others */
+	uint64_t evictions;
+
+	/** Lines dropped because they were written, unmapped or the reservation changed */
+	uint64_t invalidations;
+
+	/** Lines currently cached and the memory they use, in bytes */
+	uint64_t lines;
+	uint64_t bytes;
+};
+
+/**
+ * Configure the read cache of a namespace.
+ *
+ * May only be performed on subsystems in the PAUSED or INACTIVE states. The
+ * cache is shared by all poll groups and is split into shards by LBA to keep
+ * them from contending. Reads are served from it in units of whole lines, which
+ * are filled from the bdev on a miss. Lines are dropped when they are written,
+ * unmapped or zeroed through the target, and the whole cache is dropped when
+ * the reservation of the namespace changes. Writes that bypass the target are
+ * not seen by the cache.
+ *
+ * Changing the options drops the cached data.
+ *
+ * \param subsystem Subsystem the namespace belongs to.
+ * \param nsid Namespace ID to configure.
+ * \param opts Cache options. A size_mb of 0 disables the cache.
+ *
+ * \return 0 on success, or negated errno on failure.
+ */
+int spdk_nvmf_subsystem_set_ns_cache(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				     const struct spdk_nvmf_ns_cache_opts *opts);
+
+/**
+ * Get the read cache options of a namespace.
+ *
+ * \param ns Namespace to query.
+ * \param opts Output parameter for options.
+ */
+void spdk_nvmf_ns_get_cache_opts(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_cache_opts *opts);
+
+/**
+ * Get the read cache statistics of a namespace.
+ *
+ * \param ns Namespace to query.
+ * \param stats Output parameter for the statistics.
+ *
+ * \return 0 on success, or -ENOENT if the namespace has no read cache.
+ */
+int spdk_nvmf_ns_get_cache_stats(const struct spdk_nvmf_ns *ns,
+				 struct spdk_nvmf_ns_cache_stats *stats);
+
 /**
  * Get the serial number of the specified subsystem.
  *
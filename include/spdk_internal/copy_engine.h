@@ -49,6 +49,9 @@ struct spdk_copy_engine {
 			uint64_t nbytes, spdk_copy_completion_cb cb);
 	int	(*fill)(void *cb_arg, struct spdk_io_channel *ch, void *dst, uint8_t fill,
 			uint64_t nbytes, spdk_copy_completion_cb cb);
+	/* Optional, the software engine is used for engines that don't provide it. */
+	int	(*crc32c)(void *cb_arg, struct spdk_io_channel *ch, uint32_t *dst, struct iovec *iovs,
+			  uint32_t iovcnt, uint32_t seed, spdk_copy_completion_cb cb);
 	struct spdk_io_channel *(*get_io_channel)(void);
 };
 
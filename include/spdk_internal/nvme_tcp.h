@@ -101,6 +101,8 @@ struct nvme_tcp_pdu {
 	union nvme_tcp_pdu_hdr				*hdr;
 	bool						has_hdgst;
 	bool						ddgst_enable;
+	/* The data digest is still being calculated, data_digest is not valid yet */
+	bool						ddgst_pending;
 	uint8_t						data_digest[SPDK_NVME_TCP_DIGEST_LEN];
 	int32_t						padding_valid_bytes;
 
@@ -140,6 +142,9 @@ enum nvme_tcp_pdu_recv_state {
 	/* Active tqpair waiting for payload */
 	NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD,
 
+	/* Active tqpair waiting for the data digest of the payload to be verified */
+	NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_DDGST,
+
 	/* Active tqpair does not wait for payload */
 	NVME_TCP_PDU_RECV_STATE_ERROR,
 };
@@ -182,21 +187,15 @@ _update_crc32c_iov(struct iovec *iov, int iovcnt, uint32_t crc32c)
 	return crc32c;
 }
 
+/*
+ * Finish a data digest whose CRC-32C over the data iovecs, seeded with
+ * SPDK_CRC32C_XOR, was calculated separately.
+ */
 static uint32_t
-nvme_tcp_pdu_calc_data_digest(struct nvme_tcp_pdu *pdu)
+nvme_tcp_pdu_finish_data_digest(struct nvme_tcp_pdu *pdu, uint32_t crc32c)
 {
-	uint32_t crc32c = SPDK_CRC32C_XOR;
 	uint32_t mod;
 
-	assert(pdu->data_len != 0);
-
-	if (spdk_likely(!pdu->dif_ctx)) {
-		crc32c = _update_crc32c_iov(pdu->data_iov, pdu->data_iovcnt, crc32c);
-	} else {
-		spdk_dif_update_crc32c_stream(pdu->data_iov, pdu->data_iovcnt,
-					      0, pdu->data_len, &crc32c, pdu->dif_ctx);
-	}
-
 	mod = pdu->data_len % SPDK_NVME_TCP_DIGEST_ALIGNMENT;
 	if (mod != 0) {
 		uint32_t pad_length = SPDK_NVME_TCP_DIGEST_ALIGNMENT - mod;
@@ -210,6 +209,23 @@ nvme_tcp_pdu_calc_data_digest(struct nvme_tcp_pdu *pdu)
 	return crc32c;
 }
 
+static uint32_t
+nvme_tcp_pdu_calc_data_digest(struct nvme_tcp_pdu *pdu)
+{
+	uint32_t crc32c = SPDK_CRC32C_XOR;
+
+	assert(pdu->data_len != 0);
+
+	if (spdk_likely(!pdu->dif_ctx)) {
+		crc32c = _update_crc32c_iov(pdu->data_iov, pdu->data_iovcnt, crc32c);
+	} else {
+		spdk_dif_update_crc32c_stream(pdu->data_iov, pdu->data_iovcnt,
+					      0, pdu->data_len, &crc32c, pdu->dif_ctx);
+	}
+
+	return nvme_tcp_pdu_finish_data_digest(pdu, crc32c);
+}
+
 static inline void
 _nvme_tcp_sgl_init(struct _nvme_tcp_sgl *s, struct iovec *iov, int iovcnt,
 		   uint32_t iov_offset)
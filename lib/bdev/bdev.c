@@ -255,6 +255,12 @@ struct spdk_bdev_channel {
 	 */
 	uint64_t		io_outstanding;
 
+	/*
+	 * List of spdk_bdev_io allocated on this channel and not freed yet, used to
+	 *  look up the I/O targeted by an abort request.
+	 */
+	bdev_io_tailq_t		io_submitted;
+
 	bdev_io_tailq_t		queued_resets;
 
 	uint32_t		flags;
@@ -536,7 +542,8 @@ _bdev_io_set_bounce_buf(struct spdk_bdev_io *bdev_io, void *buf, size_t len)
 	bdev_io->u.bdev.iovs[0].iov_base = buf;
 	bdev_io->u.bdev.iovs[0].iov_len = len;
 	/* if this is write path, copy data from original buffer to bounce buffer */
-	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE ||
+	    bdev_io->type == SPDK_BDEV_IO_TYPE_ZONE_APPEND) {
 		_copy_iovs_to_buf(buf, len, bdev_io->internal.orig_iovs, bdev_io->internal.orig_iovcnt);
 	}
 }
@@ -549,7 +556,8 @@ _bdev_io_set_bounce_md_buf(struct spdk_bdev_io *bdev_io, void *md_buf, size_t le
 	/* set bounce md_buf */
 	bdev_io->u.bdev.md_buf = md_buf;
 
-	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) {
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE ||
+	    bdev_io->type == SPDK_BDEV_IO_TYPE_ZONE_APPEND) {
 		memcpy(md_buf, bdev_io->internal.orig_md_buf, len);
 	}
 }
@@ -1298,6 +1306,10 @@ spdk_bdev_get_io(struct spdk_bdev_channel *channel)
 		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
 	}
 
+	if (bdev_io != NULL) {
+		TAILQ_INSERT_TAIL(&channel->io_submitted, bdev_io, internal.ch_link);
+	}
+
 	return bdev_io;
 }
 
@@ -1311,6 +1323,8 @@ spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
 
 	ch = bdev_io->internal.ch->shared_resource->mgmt_ch;
 
+	TAILQ_REMOVE(&bdev_io->internal.ch->io_submitted, bdev_io, internal.ch_link);
+
 	if (bdev_io->internal.buf != NULL) {
 		spdk_bdev_io_put_buf(bdev_io);
 	}
@@ -1358,6 +1372,7 @@ _spdk_bdev_qos_io_to_limit(struct spdk_bdev_io *bdev_io)
 	case SPDK_BDEV_IO_TYPE_NVME_IO_MD:
 	case SPDK_BDEV_IO_TYPE_READ:
 	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
 		return true;
 	default:
 		return false;
@@ -1394,6 +1409,7 @@ _spdk_bdev_get_io_size_in_byte(struct spdk_bdev_io *bdev_io)
 		return bdev_io->u.nvme_passthru.nbytes;
 	case SPDK_BDEV_IO_TYPE_READ:
 	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
 		return bdev_io->u.bdev.num_blocks * bdev->blocklen;
 	default:
 		return 0;
@@ -2148,6 +2164,7 @@ spdk_bdev_channel_create(void *io_device, void *ctx_buf)
 	memset(&ch->stat, 0, sizeof(ch->stat));
 	ch->stat.ticks_rate = spdk_get_ticks_hz();
 	ch->io_outstanding = 0;
+	TAILQ_INIT(&ch->io_submitted);
 	TAILQ_INIT(&ch->queued_resets);
 	ch->flags = 0;
 	ch->shared_resource = shared_resource;
@@ -2496,6 +2513,38 @@ spdk_bdev_get_uuid(const struct spdk_bdev *bdev)
 	return &bdev->uuid;
 }
 
+bool
+spdk_bdev_is_zoned(const struct spdk_bdev *bdev)
+{
+	return bdev->zoned;
+}
+
+uint64_t
+spdk_bdev_get_zone_size(const struct spdk_bdev *bdev)
+{
+	return bdev->zoned ? bdev->zone_size : 0;
+}
+
+uint32_t
+spdk_bdev_get_max_open_zones(const struct spdk_bdev *bdev)
+{
+	return bdev->zoned ? bdev->max_open_zones : 0;
+}
+
+uint32_t
+spdk_bdev_get_optimal_open_zones(const struct spdk_bdev *bdev)
+{
+	return bdev->zoned ? bdev->optimal_open_zones : 0;
+}
+
+uint64_t
+spdk_bdev_get_zone_id(const struct spdk_bdev *bdev, uint64_t offset_blocks)
+{
+	assert(bdev->zoned && bdev->zone_size != 0);
+
+	return offset_blocks - offset_blocks % bdev->zone_size;
+}
+
 uint32_t
 spdk_bdev_get_md_size(const struct spdk_bdev *bdev)
 {
@@ -3432,6 +3481,260 @@ spdk_bdev_reset(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 	return 0;
 }
 
+static struct spdk_bdev_io *
+_spdk_bdev_find_io_to_abort(struct spdk_bdev_channel *channel, void *bio_cb_arg)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	TAILQ_FOREACH(bdev_io, &channel->io_submitted, internal.ch_link) {
+		if (bdev_io->internal.caller_ctx == bio_cb_arg &&
+		    bdev_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING &&
+		    bdev_io->type != SPDK_BDEV_IO_TYPE_ABORT &&
+		    bdev_io->type != SPDK_BDEV_IO_TYPE_RESET) {
+			return bdev_io;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * An I/O waiting on the nomem_io queue has not reached the bdev module yet,
+ *  so it can be aborted without involving the module.
+ */
+static bool
+_spdk_bdev_abort_nomem_io(struct spdk_bdev_channel *channel, struct spdk_bdev_io *bio_to_abort)
+{
+	struct spdk_bdev_shared_resource *shared_resource = channel->shared_resource;
+	struct spdk_bdev_io *bdev_io;
+
+	TAILQ_FOREACH(bdev_io, &shared_resource->nomem_io, internal.link) {
+		if (bdev_io == bio_to_abort) {
+			TAILQ_REMOVE(&shared_resource->nomem_io, bdev_io, internal.link);
+			/* Account for the decrement done by spdk_bdev_io_complete(). */
+			bdev_io->internal.ch->io_outstanding++;
+			shared_resource->io_outstanding++;
+			/* Defer the completion callback, the caller is in the middle of submitting. */
+			bdev_io->internal.in_submit_request = true;
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_ABORTED);
+			bdev_io->internal.in_submit_request = false;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int
+spdk_bdev_abort(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		void *bio_cb_arg, spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	struct spdk_bdev_io *bdev_io, *bio_to_abort;
+	struct spdk_bdev_channel *channel = spdk_io_channel_get_ctx(ch);
+
+	if (bio_cb_arg == NULL) {
+		return -EINVAL;
+	}
+
+	if (!spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ABORT)) {
+		return -ENOTSUP;
+	}
+
+	bio_to_abort = _spdk_bdev_find_io_to_abort(channel, bio_cb_arg);
+	if (bio_to_abort == NULL) {
+		return -ENOENT;
+	}
+
+	bdev_io = spdk_bdev_get_io(channel);
+	if (!bdev_io) {
+		return -ENOMEM;
+	}
+
+	bdev_io->internal.ch = channel;
+	bdev_io->internal.desc = desc;
+	bdev_io->type = SPDK_BDEV_IO_TYPE_ABORT;
+	bdev_io->u.abort.bio_cb_arg = bio_cb_arg;
+	bdev_io->u.abort.bio_to_abort = bio_to_abort;
+	spdk_bdev_io_init(bdev_io, bdev, cb_arg, cb);
+
+	if (_spdk_bdev_abort_nomem_io(channel, bio_to_abort)) {
+		/* Complete through the regular path to defer the callback. */
+		channel->io_outstanding++;
+		channel->shared_resource->io_outstanding++;
+		bdev_io->internal.in_submit_request = true;
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		bdev_io->internal.in_submit_request = false;
+		return 0;
+	}
+
+	spdk_bdev_io_submit(bdev_io);
+	return 0;
+}
+
+static bool
+_spdk_bdev_is_zone_start(const struct spdk_bdev *bdev, uint64_t zone_id)
+{
+	return zone_id < bdev->blockcnt && zone_id % bdev->zone_size == 0;
+}
+
+int
+spdk_bdev_get_zone_info(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			uint64_t zone_id, size_t num_zones, struct spdk_bdev_zone_info *info,
+			spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	struct spdk_bdev_io *bdev_io;
+	struct spdk_bdev_channel *channel = spdk_io_channel_get_ctx(ch);
+
+	if (!bdev->zoned || !spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_GET_ZONE_INFO)) {
+		return -ENOTSUP;
+	}
+
+	if (info == NULL || num_zones == 0 || num_zones > UINT32_MAX ||
+	    !_spdk_bdev_is_zone_start(bdev, zone_id) ||
+	    !spdk_bdev_io_valid_blocks(bdev, zone_id, num_zones * bdev->zone_size)) {
+		return -EINVAL;
+	}
+
+	bdev_io = spdk_bdev_get_io(channel);
+	if (!bdev_io) {
+		return -ENOMEM;
+	}
+
+	bdev_io->internal.ch = channel;
+	bdev_io->internal.desc = desc;
+	bdev_io->type = SPDK_BDEV_IO_TYPE_GET_ZONE_INFO;
+	bdev_io->u.zone_mgmt.zone_id = zone_id;
+	bdev_io->u.zone_mgmt.num_zones = num_zones;
+	bdev_io->u.zone_mgmt.buf = info;
+	spdk_bdev_io_init(bdev_io, bdev, cb_arg, cb);
+
+	spdk_bdev_io_submit(bdev_io);
+	return 0;
+}
+
+int
+spdk_bdev_zone_management(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			  uint64_t zone_id, enum spdk_bdev_zone_action action,
+			  spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	struct spdk_bdev_io *bdev_io;
+	struct spdk_bdev_channel *channel = spdk_io_channel_get_ctx(ch);
+
+	if (!desc->write) {
+		return -EBADF;
+	}
+
+	if (!bdev->zoned || !spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT)) {
+		return -ENOTSUP;
+	}
+
+	if (!_spdk_bdev_is_zone_start(bdev, zone_id)) {
+		return -EINVAL;
+	}
+
+	bdev_io = spdk_bdev_get_io(channel);
+	if (!bdev_io) {
+		return -ENOMEM;
+	}
+
+	bdev_io->internal.ch = channel;
+	bdev_io->internal.desc = desc;
+	bdev_io->type = SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT;
+	bdev_io->u.zone_mgmt.zone_id = zone_id;
+	bdev_io->u.zone_mgmt.num_zones = 1;
+	bdev_io->u.zone_mgmt.zone_action = action;
+	bdev_io->u.zone_mgmt.buf = NULL;
+	spdk_bdev_io_init(bdev_io, bdev, cb_arg, cb);
+
+	spdk_bdev_io_submit(bdev_io);
+	return 0;
+}
+
+static int
+_spdk_bdev_zone_append(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       struct iovec *iov, int iovcnt, void *buf, uint64_t zone_id,
+		       uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	struct spdk_bdev_io *bdev_io;
+	struct spdk_bdev_channel *channel = spdk_io_channel_get_ctx(ch);
+
+	if (!desc->write) {
+		return -EBADF;
+	}
+
+	if (!bdev->zoned || !spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZONE_APPEND)) {
+		return -ENOTSUP;
+	}
+
+	if (num_blocks == 0 || num_blocks > bdev->zone_size ||
+	    !_spdk_bdev_is_zone_start(bdev, zone_id) ||
+	    !spdk_bdev_io_valid_blocks(bdev, zone_id, num_blocks)) {
+		return -EINVAL;
+	}
+
+	bdev_io = spdk_bdev_get_io(channel);
+	if (!bdev_io) {
+		return -ENOMEM;
+	}
+
+	bdev_io->internal.ch = channel;
+	bdev_io->internal.desc = desc;
+	bdev_io->type = SPDK_BDEV_IO_TYPE_ZONE_APPEND;
+	if (buf != NULL) {
+		bdev_io->iov.iov_base = buf;
+		bdev_io->iov.iov_len = num_blocks * bdev->blocklen;
+		bdev_io->u.bdev.iovs = &bdev_io->iov;
+		bdev_io->u.bdev.iovcnt = 1;
+	} else {
+		bdev_io->u.bdev.iovs = iov;
+		bdev_io->u.bdev.iovcnt = iovcnt;
+	}
+	bdev_io->u.bdev.md_buf = NULL;
+	bdev_io->u.bdev.num_blocks = num_blocks;
+	/* The module replaces this with the actual location when the append completes. */
+	bdev_io->u.bdev.offset_blocks = zone_id;
+	spdk_bdev_io_init(bdev_io, bdev, cb_arg, cb);
+
+	spdk_bdev_io_submit(bdev_io);
+	return 0;
+}
+
+int
+spdk_bdev_zone_append(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		      void *buf, uint64_t zone_id, uint64_t num_blocks,
+		      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	if (buf == NULL) {
+		return -EINVAL;
+	}
+
+	return _spdk_bdev_zone_append(desc, ch, NULL, 0, buf, zone_id, num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_zone_appendv(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       struct iovec *iov, int iovcnt, uint64_t zone_id, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	if (iov == NULL || iovcnt <= 0) {
+		return -EINVAL;
+	}
+
+	return _spdk_bdev_zone_append(desc, ch, iov, iovcnt, NULL, zone_id, num_blocks, cb, cb_arg);
+}
+
+uint64_t
+spdk_bdev_io_get_append_location(struct spdk_bdev_io *bdev_io)
+{
+	assert(bdev_io->type == SPDK_BDEV_IO_TYPE_ZONE_APPEND);
+
+	return bdev_io->u.bdev.offset_blocks;
+}
+
 void
 spdk_bdev_get_io_stat(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
 		      struct spdk_bdev_io_stat *stat)
@@ -3699,6 +4002,7 @@ _spdk_bdev_io_complete(void *ctx)
 			bdev_io->internal.ch->stat.read_latency_ticks += tsc_diff;
 			break;
 		case SPDK_BDEV_IO_TYPE_WRITE:
+		case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
 			bdev_io->internal.ch->stat.bytes_written += bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
 			bdev_io->internal.ch->stat.num_write_ops++;
 			bdev_io->internal.ch->stat.write_latency_ticks += tsc_diff;
@@ -3899,6 +4203,9 @@ spdk_bdev_io_get_nvme_status(const struct spdk_bdev_io *bdev_io, int *sct, int *
 	} else if (bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS) {
 		*sct = SPDK_NVME_SCT_GENERIC;
 		*sc = SPDK_NVME_SC_SUCCESS;
+	} else if (bdev_io->internal.status == SPDK_BDEV_IO_STATUS_ABORTED) {
+		*sct = SPDK_NVME_SCT_GENERIC;
+		*sc = SPDK_NVME_SC_ABORTED_BY_REQUEST;
 	} else {
 		*sct = SPDK_NVME_SCT_GENERIC;
 		*sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
@@ -4044,6 +4351,11 @@ spdk_bdev_init(struct spdk_bdev *bdev)
 		return -EEXIST;
 	}
 
+	if (bdev->zoned && (bdev->zone_size == 0 || bdev->blockcnt % bdev->zone_size != 0)) {
+		SPDK_ERRLOG("Bdev %s: blockcnt is not a multiple of the zone size\n", bdev->name);
+		return -EINVAL;
+	}
+
 	/* Users often register their own I/O devices using the bdev name. In
 	 * order to avoid conflicts, prepend bdev_. */
 	bdev_name = spdk_sprintf_alloc("bdev_%s", bdev->name);
@@ -4521,6 +4833,7 @@ spdk_bdev_io_get_iovec(struct spdk_bdev_io *bdev_io, struct iovec **iovp, int *i
 	case SPDK_BDEV_IO_TYPE_READ:
 	case SPDK_BDEV_IO_TYPE_WRITE:
 	case SPDK_BDEV_IO_TYPE_ZCOPY:
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
 		iovs = bdev_io->u.bdev.iovs;
 		iovcnt = bdev_io->u.bdev.iovcnt;
 		break;
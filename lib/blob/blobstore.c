@@ -52,8 +52,14 @@
 static int spdk_bs_register_md_thread(struct spdk_blob_store *bs);
 static int spdk_bs_unregister_md_thread(struct spdk_blob_store *bs);
 static void _spdk_blob_close_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
-static void _spdk_blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
-		uint64_t cluster, spdk_blob_op_complete cb_fn, void *cb_arg);
+static void _spdk_blob_insert_cluster_on_md_thread(struct spdk_bs_channel *ch,
+		struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster,
+		spdk_blob_op_complete cb_fn, void *cb_arg);
+static void _spdk_blob_fill_subclusters_on_md_thread(struct spdk_bs_channel *ch,
+		struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster, uint64_t filled,
+		spdk_blob_op_complete cb_fn, void *cb_arg);
+static void _spdk_blob_release_clusters_msg(void *arg);
+static void _spdk_blob_submit_releases(struct spdk_blob *blob);
 
 static int _spdk_blob_set_xattr(struct spdk_blob *blob, const char *name, const void *value,
 				uint16_t value_len, bool internal);
@@ -69,18 +75,168 @@ _spdk_blob_verify_md_op(struct spdk_blob *blob)
 	assert(blob->state != SPDK_BLOB_STATE_LOADING);
 }
 
+#define SPDK_BLOB_HASH_INITIAL_BUCKETS	64
+
+static int
+_spdk_blob_hash_init(struct spdk_blob_hash *hash)
+{
+	hash->buckets = calloc(SPDK_BLOB_HASH_INITIAL_BUCKETS, sizeof(*hash->buckets));
+	if (hash->buckets == NULL) {
+		return -ENOMEM;
+	}
+
+	hash->mask = SPDK_BLOB_HASH_INITIAL_BUCKETS - 1;
+	hash->count = 0;
+	return 0;
+}
+
+static void
+_spdk_blob_hash_free(struct spdk_blob_hash *hash)
+{
+	free(hash->buckets);
+	hash->buckets = NULL;
+}
+
+static inline uint32_t
+_spdk_blob_hash_index(uint32_t mask, spdk_blob_id id)
+{
+	/* The lower half of a blob id is its metadata page index, so it is spread well enough */
+	return (uint32_t)id & mask;
+}
+
+static void
+_spdk_blob_hash_grow(struct spdk_blob_hash *hash)
+{
+	struct spdk_blob_hash_bucket *buckets;
+	struct spdk_blob_hash_entry *entry;
+	uint32_t mask = hash->mask * 2 + 1;
+	uint32_t i;
+
+	buckets = calloc((size_t)mask + 1, sizeof(*buckets));
+	if (buckets == NULL) {
+		/* Lookups get slower, but keep working with the current buckets */
+		return;
+	}
+
+	for (i = 0; i <= hash->mask; i++) {
+		while ((entry = LIST_FIRST(&hash->buckets[i])) != NULL) {
+			LIST_REMOVE(entry, link);
+			LIST_INSERT_HEAD(&buckets[_spdk_blob_hash_index(mask, entry->id)], entry, link);
+		}
+	}
+
+	free(hash->buckets);
+	hash->buckets = buckets;
+	hash->mask = mask;
+}
+
+static void
+_spdk_blob_hash_insert(struct spdk_blob_hash *hash, struct spdk_blob_hash_entry *entry,
+		       spdk_blob_id id)
+{
+	if (hash->count > hash->mask && hash->mask < UINT32_MAX / 2) {
+		_spdk_blob_hash_grow(hash);
+	}
+
+	entry->id = id;
+	LIST_INSERT_HEAD(&hash->buckets[_spdk_blob_hash_index(hash->mask, id)], entry, link);
+	hash->count++;
+}
+
+static void
+_spdk_blob_hash_remove(struct spdk_blob_hash *hash, struct spdk_blob_hash_entry *entry)
+{
+	assert(hash->count > 0);
+	assert(entry->link.le_prev != NULL);
+
+	LIST_REMOVE(entry, link);
+	entry->link.le_prev = NULL;
+	hash->count--;
+}
+
+static inline bool
+_spdk_blob_hash_entry_is_linked(const struct spdk_blob_hash_entry *entry)
+{
+	return entry->link.le_prev != NULL;
+}
+
+static struct spdk_blob_hash_entry *
+_spdk_blob_hash_find(struct spdk_blob_hash *hash, spdk_blob_id id)
+{
+	struct spdk_blob_hash_entry *entry;
+
+	LIST_FOREACH(entry, &hash->buckets[_spdk_blob_hash_index(hash->mask, id)], link) {
+		if (entry->id == id) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
 static struct spdk_blob_list *
 _spdk_bs_get_snapshot_entry(struct spdk_blob_store *bs, spdk_blob_id blobid)
 {
-	struct spdk_blob_list *snapshot_entry = NULL;
+	struct spdk_blob_hash_entry *entry;
 
-	TAILQ_FOREACH(snapshot_entry, &bs->snapshots, link) {
-		if (snapshot_entry->id == blobid) {
-			break;
-		}
+	entry = _spdk_blob_hash_find(&bs->snapshot_hash, blobid);
+	if (entry == NULL) {
+		return NULL;
+	}
+
+	return SPDK_CONTAINEROF(entry, struct spdk_blob_list, hash_entry);
+}
+
+static struct spdk_blob_list *
+_spdk_bs_get_clone_entry(struct spdk_blob_store *bs, spdk_blob_id blobid)
+{
+	struct spdk_blob_hash_entry *entry;
+
+	entry = _spdk_blob_hash_find(&bs->clone_hash, blobid);
+	if (entry == NULL) {
+		return NULL;
 	}
 
-	return snapshot_entry;
+	return SPDK_CONTAINEROF(entry, struct spdk_blob_list, hash_entry);
+}
+
+static void
+_spdk_bs_remove_snapshot_entry(struct spdk_blob_store *bs, struct spdk_blob_list *snapshot_entry)
+{
+	assert(TAILQ_EMPTY(&snapshot_entry->clones));
+
+	TAILQ_REMOVE(&bs->snapshots, snapshot_entry, link);
+	_spdk_blob_hash_remove(&bs->snapshot_hash, &snapshot_entry->hash_entry);
+	free(snapshot_entry);
+}
+
+static void
+_spdk_bs_add_clone_entry(struct spdk_blob_list *snapshot_entry, struct spdk_blob_list *clone_entry)
+{
+	clone_entry->parent = snapshot_entry;
+	TAILQ_INSERT_TAIL(&snapshot_entry->clones, clone_entry, link);
+	snapshot_entry->clone_count++;
+}
+
+static void
+_spdk_bs_unlink_clone_entry(struct spdk_blob_list *clone_entry)
+{
+	struct spdk_blob_list *snapshot_entry = clone_entry->parent;
+
+	assert(snapshot_entry != NULL);
+	assert(snapshot_entry->clone_count > 0);
+
+	TAILQ_REMOVE(&snapshot_entry->clones, clone_entry, link);
+	snapshot_entry->clone_count--;
+	clone_entry->parent = NULL;
+}
+
+static void
+_spdk_bs_remove_clone_entry(struct spdk_blob_store *bs, struct spdk_blob_list *clone_entry)
+{
+	_spdk_bs_unlink_clone_entry(clone_entry);
+	_spdk_blob_hash_remove(&bs->clone_hash, &clone_entry->hash_entry);
+	free(clone_entry);
 }
 
 static void
@@ -96,6 +252,49 @@ _spdk_bs_claim_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
 	bs->num_free_clusters--;
 }
 
+/* Grow the sub-cluster mask array to at least size entries */
+static int
+_spdk_blob_grow_subcluster_masks(struct spdk_blob *blob, size_t size)
+{
+	uint64_t	*tmp;
+
+	if (size <= blob->subcluster_mask_array_size) {
+		return 0;
+	}
+
+	size = spdk_max(size, blob->active.cluster_array_size);
+	tmp = realloc(blob->subcluster_masks, size * sizeof(uint64_t));
+	if (tmp == NULL) {
+		return -ENOMEM;
+	}
+	memset(tmp + blob->subcluster_mask_array_size, 0,
+	       (size - blob->subcluster_mask_array_size) * sizeof(uint64_t));
+	blob->subcluster_masks = tmp;
+	blob->subcluster_mask_array_size = size;
+
+	return 0;
+}
+
+static int
+_spdk_blob_set_subcluster_mask(struct spdk_blob *blob, uint64_t cluster_num, uint64_t mask)
+{
+	int rc;
+
+	if (cluster_num >= blob->subcluster_mask_array_size) {
+		if (mask == 0) {
+			return 0;
+		}
+
+		rc = _spdk_blob_grow_subcluster_masks(blob, cluster_num + 1);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	blob->subcluster_masks[cluster_num] = mask;
+	return 0;
+}
+
 static int
 _spdk_blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster)
 {
@@ -108,6 +307,40 @@ _spdk_blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t
 	}
 
 	*cluster_lba = _spdk_bs_cluster_to_lba(blob->bs, cluster);
+	_spdk_blob_set_subcluster_mask(blob, cluster_num, 0);
+	return 0;
+}
+
+/* Mark the sub-clusters in filled as copied, inserting the cluster first if
+ * it was not allocated yet. mask_changed is set if the persisted masks have
+ * to be updated, as opposed to only the cluster map.
+ */
+static int
+_spdk_blob_fill_subclusters(struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster,
+			    uint64_t filled, bool *mask_changed)
+{
+	uint64_t	*cluster_lba = &blob->active.clusters[cluster_num];
+	uint64_t	lba = _spdk_bs_cluster_to_lba(blob->bs, cluster);
+	uint64_t	mask;
+	int		rc;
+
+	_spdk_blob_verify_md_op(blob);
+
+	if (*cluster_lba == 0) {
+		mask = _spdk_bs_subcluster_full_mask(blob->bs);
+	} else if (*cluster_lba == lba) {
+		mask = _spdk_blob_subcluster_mask(blob, cluster_num);
+	} else {
+		return -EEXIST;
+	}
+
+	rc = _spdk_blob_set_subcluster_mask(blob, cluster_num, mask & ~filled);
+	if (rc != 0) {
+		return rc;
+	}
+
+	*mask_changed = (mask & ~filled) != (*cluster_lba == 0 ? 0 : mask);
+	*cluster_lba = lba;
 	return 0;
 }
 
@@ -150,6 +383,81 @@ _spdk_bs_release_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
 	pthread_mutex_unlock(&bs->used_clusters_mutex);
 }
 
+/* Claim up to SPDK_BS_CHANNEL_CLUSTER_POOL_SIZE clusters for the channel,
+ * taking used_clusters_mutex once for the whole batch.
+ */
+static void
+_spdk_bs_channel_refill_clusters(struct spdk_bs_channel *ch)
+{
+	struct spdk_blob_store *bs = ch->bs;
+	uint32_t cluster_num = 0;
+	uint32_t count = 0;
+	uint32_t i, tmp;
+
+	assert(ch->cluster_pool_count == 0);
+
+	pthread_mutex_lock(&bs->used_clusters_mutex);
+	while (count < SPDK_BS_CHANNEL_CLUSTER_POOL_SIZE) {
+		cluster_num = spdk_bit_array_find_first_clear(bs->used_clusters, cluster_num);
+		if (cluster_num == UINT32_MAX) {
+			break;
+		}
+		_spdk_bs_claim_cluster(bs, cluster_num);
+		ch->cluster_pool[count++] = cluster_num;
+	}
+	__atomic_fetch_add(&bs->num_reserved_clusters, count, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&bs->used_clusters_mutex);
+
+	/* Clusters are taken from the end of the pool, so reverse it to hand
+	 * out the lowest clusters first. */
+	for (i = 0; i < count / 2; i++) {
+		tmp = ch->cluster_pool[i];
+		ch->cluster_pool[i] = ch->cluster_pool[count - 1 - i];
+		ch->cluster_pool[count - 1 - i] = tmp;
+	}
+	ch->cluster_pool_count = count;
+}
+
+static int
+_spdk_bs_channel_take_cluster(struct spdk_bs_channel *ch, uint64_t *cluster)
+{
+	if (ch->cluster_pool_count == 0) {
+		_spdk_bs_channel_refill_clusters(ch);
+		if (ch->cluster_pool_count == 0) {
+			/* No more free clusters. Cannot satisfy the request */
+			return -ENOSPC;
+		}
+	}
+
+	*cluster = ch->cluster_pool[--ch->cluster_pool_count];
+	__atomic_fetch_sub(&ch->bs->num_reserved_clusters, 1, __ATOMIC_RELAXED);
+
+	SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Taking cluster %lu from channel pool\n", *cluster);
+	return 0;
+}
+
+/* Return an unused cluster to the channel pool, or to the blobstore if the pool is full. */
+static void
+_spdk_bs_channel_put_cluster(struct spdk_bs_channel *ch, uint64_t cluster)
+{
+	if (ch->cluster_pool_count < SPDK_BS_CHANNEL_CLUSTER_POOL_SIZE) {
+		ch->cluster_pool[ch->cluster_pool_count++] = cluster;
+		__atomic_fetch_add(&ch->bs->num_reserved_clusters, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	_spdk_bs_release_cluster(ch->bs, cluster);
+}
+
+static void
+_spdk_bs_channel_release_clusters(struct spdk_bs_channel *ch)
+{
+	while (ch->cluster_pool_count > 0) {
+		_spdk_bs_release_cluster(ch->bs, ch->cluster_pool[--ch->cluster_pool_count]);
+		__atomic_fetch_sub(&ch->bs->num_reserved_clusters, 1, __ATOMIC_RELAXED);
+	}
+}
+
 static void
 _spdk_blob_xattrs_init(struct spdk_blob_xattr_opts *xattrs)
 {
@@ -165,6 +473,10 @@ spdk_blob_opts_init(struct spdk_blob_opts *opts)
 	opts->num_clusters = 0;
 	opts->thin_provision = false;
 	_spdk_blob_xattrs_init(&opts->xattrs);
+	opts->use_extent_table = true;
+	opts->use_subcluster_cow = false;
+	opts->esnap_id = NULL;
+	opts->esnap_id_len = 0;
 }
 
 void
@@ -200,6 +512,9 @@ _spdk_blob_alloc(struct spdk_blob_store *bs, spdk_blob_id id)
 
 	TAILQ_INIT(&blob->xattrs);
 	TAILQ_INIT(&blob->xattrs_internal);
+	TAILQ_INIT(&blob->cow_claims);
+	TAILQ_INIT(&blob->pending_releases);
+	TAILQ_INIT(&blob->inflight_releases);
 
 	return blob;
 }
@@ -217,15 +532,30 @@ _spdk_xattrs_free(struct spdk_xattr_tailq *xattrs)
 	}
 }
 
+/* Called whenever the snapshots a blob reads through, or the clusters they hold,
+ * may have changed, so that channels stop using the cluster locations they cached.
+ */
+static inline void
+_spdk_bs_topology_changed(struct spdk_blob_store *bs)
+{
+	bs->topology_gen++;
+}
+
 static void
 _spdk_blob_free(struct spdk_blob *blob)
 {
 	assert(blob != NULL);
 
+	/* The memory may be reused for another blob */
+	_spdk_bs_topology_changed(blob->bs);
+
 	free(blob->active.clusters);
 	free(blob->clean.clusters);
 	free(blob->active.pages);
 	free(blob->clean.pages);
+	free(blob->active.extent_pages);
+	free(blob->clean.extent_pages);
+	free(blob->subcluster_masks);
 
 	_spdk_xattrs_free(&blob->xattrs);
 	_spdk_xattrs_free(&blob->xattrs_internal);
@@ -341,6 +671,7 @@ _spdk_blob_mark_clean(struct spdk_blob *blob)
 {
 	uint64_t *clusters = NULL;
 	uint32_t *pages = NULL;
+	uint32_t *extent_pages = NULL;
 
 	assert(blob != NULL);
 
@@ -363,16 +694,34 @@ _spdk_blob_mark_clean(struct spdk_blob *blob)
 		memcpy(pages, blob->active.pages, blob->active.num_pages * sizeof(*pages));
 	}
 
+	if (blob->active.num_extent_pages) {
+		assert(blob->active.extent_pages);
+		extent_pages = calloc(blob->active.num_extent_pages, sizeof(*blob->active.extent_pages));
+		if (!extent_pages) {
+			free(clusters);
+			free(pages);
+			return -ENOMEM;
+		}
+		memcpy(extent_pages, blob->active.extent_pages,
+		       blob->active.num_extent_pages * sizeof(*extent_pages));
+	}
+
 	free(blob->clean.clusters);
 	free(blob->clean.pages);
+	free(blob->clean.extent_pages);
 
 	blob->clean.num_clusters = blob->active.num_clusters;
 	blob->clean.clusters = blob->active.clusters;
 	blob->clean.num_pages = blob->active.num_pages;
 	blob->clean.pages = blob->active.pages;
+	blob->clean.num_extent_pages = blob->active.num_extent_pages;
+	blob->clean.extent_pages = blob->active.extent_pages;
+	blob->clean.extent_pages_array_size = blob->active.extent_pages_array_size;
 
 	blob->active.clusters = clusters;
 	blob->active.pages = pages;
+	blob->active.extent_pages = extent_pages;
+	blob->active.extent_pages_array_size = blob->active.num_extent_pages;
 
 	/* If the metadata was dirtied again while the metadata was being written to disk,
 	 *  we do not want to revert the DIRTY state back to CLEAN here.
@@ -473,6 +822,8 @@ _spdk_blob_parse_page(const struct spdk_blob_md_page *page, struct spdk_blob *bl
 			blob->invalid_flags = desc_flags->invalid_flags;
 			blob->data_ro_flags = desc_flags->data_ro_flags;
 			blob->md_ro_flags = desc_flags->md_ro_flags;
+			blob->use_extent_table = !!(desc_flags->invalid_flags & SPDK_BLOB_EXTENT_TABLE);
+			blob->use_subcluster_cow = !!(desc_flags->invalid_flags & SPDK_BLOB_SUBCLUSTER_COW);
 
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT) {
 			struct spdk_blob_md_descriptor_extent	*desc_extent;
@@ -521,6 +872,120 @@ _spdk_blob_parse_page(const struct spdk_blob_md_page *page, struct spdk_blob *bl
 				}
 			}
 
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_TABLE) {
+			struct spdk_blob_md_descriptor_extent_table	*desc_extent_table;
+			uint64_t					num_extent_pages;
+			unsigned int					i, j;
+
+			desc_extent_table = (struct spdk_blob_md_descriptor_extent_table *)desc;
+
+			if (!blob->use_extent_table ||
+			    desc_extent_table->length < sizeof(desc_extent_table->num_clusters) ||
+			    (desc_extent_table->length - sizeof(desc_extent_table->num_clusters)) %
+			    sizeof(desc_extent_table->extent_page[0]) != 0) {
+				return -EINVAL;
+			}
+
+			num_extent_pages = spdk_divide_round_up(desc_extent_table->num_clusters,
+							       SPDK_EXTENTS_PER_EP);
+
+			if (blob->active.extent_pages_array_size == 0) {
+				/* First extent table descriptor - size the cluster map. The
+				 *  clusters themselves are filled in from the extent pages.
+				 */
+				if (num_extent_pages != 0) {
+					blob->active.clusters = calloc(desc_extent_table->num_clusters,
+								       sizeof(uint64_t));
+					blob->active.extent_pages = calloc(num_extent_pages, sizeof(uint32_t));
+					if (blob->active.clusters == NULL || blob->active.extent_pages == NULL) {
+						return -ENOMEM;
+					}
+					blob->active.cluster_array_size = desc_extent_table->num_clusters;
+					blob->active.extent_pages_array_size = num_extent_pages;
+				}
+				blob->active.num_clusters = desc_extent_table->num_clusters;
+			} else if (desc_extent_table->num_clusters != blob->active.num_clusters) {
+				return -EINVAL;
+			}
+
+			for (i = 0; i < (desc_extent_table->length - sizeof(desc_extent_table->num_clusters)) /
+			     sizeof(desc_extent_table->extent_page[0]); i++) {
+				uint32_t page_idx = desc_extent_table->extent_page[i].page_idx;
+
+				for (j = 0; j < desc_extent_table->extent_page[i].num_pages; j++) {
+					if (blob->active.num_extent_pages >= blob->active.extent_pages_array_size) {
+						return -EINVAL;
+					}
+					blob->active.extent_pages[blob->active.num_extent_pages++] =
+						page_idx == 0 ? 0 : page_idx + j;
+				}
+			}
+
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE) {
+			struct spdk_blob_md_descriptor_extent_page	*desc_extent_page;
+			uint64_t					start_cluster;
+			unsigned int					i, cluster_count;
+
+			desc_extent_page = (struct spdk_blob_md_descriptor_extent_page *)desc;
+
+			if (!blob->use_extent_table ||
+			    desc_extent_page->length < sizeof(desc_extent_page->start_cluster_idx) ||
+			    (desc_extent_page->length - sizeof(desc_extent_page->start_cluster_idx)) %
+			    sizeof(desc_extent_page->cluster_idx[0]) != 0) {
+				return -EINVAL;
+			}
+
+			start_cluster = desc_extent_page->start_cluster_idx;
+			cluster_count = (desc_extent_page->length - sizeof(desc_extent_page->start_cluster_idx)) /
+					sizeof(desc_extent_page->cluster_idx[0]);
+
+			if (start_cluster % SPDK_EXTENTS_PER_EP != 0 ||
+			    cluster_count > SPDK_EXTENTS_PER_EP ||
+			    start_cluster + cluster_count > blob->active.num_clusters) {
+				return -EINVAL;
+			}
+
+			for (i = 0; i < cluster_count; i++) {
+				uint32_t cluster_idx = desc_extent_page->cluster_idx[i];
+
+				if (cluster_idx == 0) {
+					continue;
+				}
+				if (!spdk_bit_array_get(blob->bs->used_clusters, cluster_idx)) {
+					return -EINVAL;
+				}
+				blob->active.clusters[start_cluster + i] = _spdk_bs_cluster_to_lba(blob->bs,
+						cluster_idx);
+			}
+
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_SUBCLUSTER_MASK) {
+			struct spdk_blob_md_descriptor_subcluster_mask	*desc_mask;
+			uint64_t					full_mask;
+			unsigned int					i;
+			int						rc;
+
+			desc_mask = (struct spdk_blob_md_descriptor_subcluster_mask *)desc;
+
+			if (!blob->use_subcluster_cow ||
+			    desc_mask->length % sizeof(desc_mask->clusters[0]) != 0) {
+				return -EINVAL;
+			}
+
+			/* The masks are serialized after the extents, so the cluster count is known */
+			full_mask = _spdk_bs_subcluster_full_mask(blob->bs);
+			for (i = 0; i < desc_mask->length / sizeof(desc_mask->clusters[0]); i++) {
+				if (desc_mask->clusters[i].cluster_idx >= blob->active.num_clusters ||
+				    (desc_mask->clusters[i].mask & ~full_mask)) {
+					return -EINVAL;
+				}
+
+				rc = _spdk_blob_set_subcluster_mask(blob, desc_mask->clusters[i].cluster_idx,
+								    desc_mask->clusters[i].mask);
+				if (rc != 0) {
+					return rc;
+				}
+			}
+
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR) {
 			int rc;
 
@@ -592,9 +1057,27 @@ _spdk_blob_parse(const struct spdk_blob_md_page *pages, uint32_t page_count,
 		}
 	}
 
+	if (blob->use_extent_table && blob->active.num_extent_pages !=
+	    spdk_divide_round_up(blob->active.num_clusters, SPDK_EXTENTS_PER_EP)) {
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
+static uint32_t
+_spdk_blob_md_page_calc_crc(void *page)
+{
+	uint32_t		crc;
+
+	crc = BLOB_CRC32C_INITIAL;
+	crc = spdk_crc32c_update(page, SPDK_BS_PAGE_SIZE - 4, crc);
+	crc ^= BLOB_CRC32C_INITIAL;
+
+	return crc;
+
+}
+
 static int
 _spdk_blob_serialize_add_page(const struct spdk_blob *blob,
 			      struct spdk_blob_md_page **pages,
@@ -732,27 +1215,130 @@ _spdk_blob_serialize_extent(const struct spdk_blob *blob,
 	return;
 }
 
-static void
-_spdk_blob_serialize_flags(const struct spdk_blob *blob,
-			   uint8_t *buf, size_t *buf_sz)
+/* Serialize as much of the extent table, starting at extent page start_ep, as
+ * fits into buf. Returns false if buf did not have room for any of it.
+ */
+static bool
+_spdk_blob_serialize_extent_table(const struct spdk_blob *blob,
+				  uint64_t start_ep, uint64_t *next_ep,
+				  uint8_t *buf, size_t buf_sz)
 {
-	struct spdk_blob_md_descriptor_flags *desc;
+	struct spdk_blob_md_descriptor_extent_table *desc;
+	size_t cur_sz;
+	uint64_t i, et_idx;
+	uint32_t ep_idx, ep_len;
 
-	/*
-	 * Flags get serialized first, so we should always have room for the flags
-	 *  descriptor.
-	 */
-	assert(*buf_sz >= sizeof(*desc));
+	/* The buffer must have room for the cluster count and at least one extent page run */
+	cur_sz = sizeof(struct spdk_blob_md_descriptor) + sizeof(desc->num_clusters) +
+		 sizeof(desc->extent_page[0]);
+	if (buf_sz < cur_sz) {
+		*next_ep = start_ep;
+		return false;
+	}
 
-	desc = (struct spdk_blob_md_descriptor_flags *)buf;
-	desc->type = SPDK_MD_DESCRIPTOR_TYPE_FLAGS;
-	desc->length = sizeof(*desc) - sizeof(struct spdk_blob_md_descriptor);
-	desc->invalid_flags = blob->invalid_flags;
-	desc->data_ro_flags = blob->data_ro_flags;
-	desc->md_ro_flags = blob->md_ro_flags;
+	desc = (struct spdk_blob_md_descriptor_extent_table *)buf;
+	desc->type = SPDK_MD_DESCRIPTOR_TYPE_EXTENT_TABLE;
+	desc->num_clusters = blob->active.num_clusters;
 
-	*buf_sz -= sizeof(*desc);
-}
+	if (start_ep == blob->active.num_extent_pages) {
+		/* A blob without any clusters only needs the cluster count */
+		desc->length = sizeof(desc->num_clusters);
+		*next_ep = start_ep;
+		return true;
+	}
+
+	ep_idx = blob->active.extent_pages[start_ep];
+	ep_len = 1;
+	et_idx = 0;
+	for (i = start_ep + 1; i < blob->active.num_extent_pages; i++) {
+		if (ep_idx == 0 && blob->active.extent_pages[i] == 0) {
+			ep_len++;
+			continue;
+		} else if (ep_idx != 0 && blob->active.extent_pages[i] == ep_idx + ep_len) {
+			ep_len++;
+			continue;
+		}
+		desc->extent_page[et_idx].page_idx = ep_idx;
+		desc->extent_page[et_idx].num_pages = ep_len;
+		et_idx++;
+
+		cur_sz += sizeof(desc->extent_page[et_idx]);
+
+		if (buf_sz < cur_sz) {
+			/* If we ran out of buffer space, return */
+			desc->length = sizeof(desc->num_clusters) + sizeof(desc->extent_page[0]) * et_idx;
+			*next_ep = i;
+			return true;
+		}
+
+		ep_idx = blob->active.extent_pages[i];
+		ep_len = 1;
+	}
+
+	desc->extent_page[et_idx].page_idx = ep_idx;
+	desc->extent_page[et_idx].num_pages = ep_len;
+	et_idx++;
+
+	desc->length = sizeof(desc->num_clusters) + sizeof(desc->extent_page[0]) * et_idx;
+	*next_ep = blob->active.num_extent_pages;
+
+	return true;
+}
+
+/* Build the on-disk extent page describing clusters [ep * SPDK_EXTENTS_PER_EP,
+ * (ep + 1) * SPDK_EXTENTS_PER_EP). Extent pages are not part of the metadata
+ * page chain, so they always carry sequence number 0.
+ */
+static void
+_spdk_blob_serialize_extent_page(const struct spdk_blob *blob, uint64_t ep,
+				 struct spdk_blob_md_page *page)
+{
+	struct spdk_blob_md_descriptor_extent_page *desc;
+	uint64_t start_cluster, end_cluster, i;
+
+	start_cluster = ep * SPDK_EXTENTS_PER_EP;
+	end_cluster = spdk_min(start_cluster + SPDK_EXTENTS_PER_EP, blob->active.num_clusters);
+	assert(start_cluster < end_cluster);
+
+	memset(page, 0, sizeof(*page));
+	page->id = blob->id;
+	page->sequence_num = 0;
+	page->next = SPDK_INVALID_MD_PAGE;
+
+	desc = (struct spdk_blob_md_descriptor_extent_page *)page->descriptors;
+	desc->type = SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE;
+	desc->start_cluster_idx = start_cluster;
+	for (i = start_cluster; i < end_cluster; i++) {
+		desc->cluster_idx[i - start_cluster] = _spdk_bs_lba_to_cluster(blob->bs,
+						       blob->active.clusters[i]);
+	}
+	desc->length = sizeof(desc->start_cluster_idx) +
+		       sizeof(desc->cluster_idx[0]) * (end_cluster - start_cluster);
+
+	page->crc = _spdk_blob_md_page_calc_crc(page);
+}
+
+static void
+_spdk_blob_serialize_flags(const struct spdk_blob *blob,
+			   uint8_t *buf, size_t *buf_sz)
+{
+	struct spdk_blob_md_descriptor_flags *desc;
+
+	/*
+	 * Flags get serialized first, so we should always have room for the flags
+	 *  descriptor.
+	 */
+	assert(*buf_sz >= sizeof(*desc));
+
+	desc = (struct spdk_blob_md_descriptor_flags *)buf;
+	desc->type = SPDK_MD_DESCRIPTOR_TYPE_FLAGS;
+	desc->length = sizeof(*desc) - sizeof(struct spdk_blob_md_descriptor);
+	desc->invalid_flags = blob->invalid_flags;
+	desc->data_ro_flags = blob->data_ro_flags;
+	desc->md_ro_flags = blob->md_ro_flags;
+
+	*buf_sz -= sizeof(*desc);
+}
 
 static int
 _spdk_blob_serialize_xattrs(const struct spdk_blob *blob,
@@ -806,6 +1392,59 @@ _spdk_blob_serialize_xattrs(const struct spdk_blob *blob,
 	return 0;
 }
 
+static int
+_spdk_blob_serialize_subcluster_masks(const struct spdk_blob *blob,
+				      struct spdk_blob_md_page **pages,
+				      struct spdk_blob_md_page *cur_page,
+				      uint32_t *page_count, uint8_t **buf,
+				      size_t *remaining_sz)
+{
+	struct spdk_blob_md_descriptor_subcluster_mask	*desc = NULL;
+	size_t						entry_sz = sizeof(desc->clusters[0]);
+	uint64_t					i, num_clusters;
+	uint32_t					idx;
+	int						rc;
+
+	num_clusters = spdk_min(blob->subcluster_mask_array_size, blob->active.num_clusters);
+	for (i = 0; i < num_clusters; i++) {
+		if (blob->subcluster_masks[i] == 0 || blob->active.clusters[i] == 0) {
+			continue;
+		}
+
+		if (desc == NULL || *remaining_sz < entry_sz) {
+			if (*remaining_sz < sizeof(struct spdk_blob_md_descriptor) + entry_sz) {
+				/* Need to add a new page to the chain */
+				rc = _spdk_blob_serialize_add_page(blob, pages, page_count,
+								   &cur_page);
+				if (rc < 0) {
+					spdk_free(*pages);
+					*pages = NULL;
+					*page_count = 0;
+					return rc;
+				}
+
+				*buf = (uint8_t *)cur_page->descriptors;
+				*remaining_sz = sizeof(cur_page->descriptors);
+			}
+
+			desc = (struct spdk_blob_md_descriptor_subcluster_mask *)*buf;
+			desc->type = SPDK_MD_DESCRIPTOR_TYPE_SUBCLUSTER_MASK;
+			desc->length = 0;
+			*buf += sizeof(struct spdk_blob_md_descriptor);
+			*remaining_sz -= sizeof(struct spdk_blob_md_descriptor);
+		}
+
+		idx = desc->length / entry_sz;
+		desc->clusters[idx].cluster_idx = i;
+		desc->clusters[idx].mask = blob->subcluster_masks[i];
+		desc->length += entry_sz;
+		*buf += entry_sz;
+		*remaining_sz -= entry_sz;
+	}
+
+	return 0;
+}
+
 static int
 _spdk_blob_serialize(const struct spdk_blob *blob, struct spdk_blob_md_page **pages,
 		     uint32_t *page_count)
@@ -815,6 +1454,8 @@ _spdk_blob_serialize(const struct spdk_blob *blob, struct spdk_blob_md_page **pa
 	uint8_t					*buf;
 	size_t					remaining_sz;
 	uint64_t				last_cluster;
+	uint64_t				last_ep;
+	struct spdk_blob_md_descriptor		*desc;
 
 	assert(pages != NULL);
 	assert(page_count != NULL);
@@ -851,27 +1492,57 @@ _spdk_blob_serialize(const struct spdk_blob *blob, struct spdk_blob_md_page **pa
 		return rc;
 	}
 
-	/* Serialize extents */
-	last_cluster = 0;
-	while (last_cluster < blob->active.num_clusters) {
-		_spdk_blob_serialize_extent(blob, last_cluster, &last_cluster,
-					    buf, remaining_sz);
+	if (blob->use_extent_table) {
+		/* Serialize extent table */
+		last_ep = 0;
+		while (!_spdk_blob_serialize_extent_table(blob, last_ep, &last_ep, buf, remaining_sz) ||
+		       last_ep < blob->active.num_extent_pages) {
+			rc = _spdk_blob_serialize_add_page(blob, pages, page_count,
+							   &cur_page);
+			if (rc < 0) {
+				return rc;
+			}
 
-		if (last_cluster == blob->active.num_clusters) {
-			break;
+			buf = (uint8_t *)cur_page->descriptors;
+			remaining_sz = sizeof(cur_page->descriptors);
 		}
+	} else {
+		/* Serialize extents */
+		last_cluster = 0;
+		while (last_cluster < blob->active.num_clusters) {
+			_spdk_blob_serialize_extent(blob, last_cluster, &last_cluster,
+						    buf, remaining_sz);
 
-		rc = _spdk_blob_serialize_add_page(blob, pages, page_count,
-						   &cur_page);
-		if (rc < 0) {
-			return rc;
+			if (last_cluster == blob->active.num_clusters) {
+				break;
+			}
+
+			rc = _spdk_blob_serialize_add_page(blob, pages, page_count,
+							   &cur_page);
+			if (rc < 0) {
+				return rc;
+			}
+
+			buf = (uint8_t *)cur_page->descriptors;
+			remaining_sz = sizeof(cur_page->descriptors);
 		}
+	}
+
+	if (!blob->use_subcluster_cow) {
+		return 0;
+	}
 
-		buf = (uint8_t *)cur_page->descriptors;
-		remaining_sz = sizeof(cur_page->descriptors);
+	/* Sub-cluster masks go after the last extent descriptor, so that the
+	 * cluster count is known when they are parsed.
+	 */
+	if (blob->use_extent_table || blob->active.num_clusters > 0) {
+		desc = (struct spdk_blob_md_descriptor *)buf;
+		buf += sizeof(*desc) + desc->length;
+		remaining_sz -= sizeof(*desc) + desc->length;
 	}
 
-	return 0;
+	return _spdk_blob_serialize_subcluster_masks(blob, pages, cur_page, page_count,
+			&buf, &remaining_sz);
 }
 
 struct spdk_blob_load_ctx {
@@ -879,25 +1550,14 @@ struct spdk_blob_load_ctx {
 
 	struct spdk_blob_md_page	*pages;
 	uint32_t			num_pages;
+	struct spdk_blob_md_page	*extent_page;
+	uint64_t			next_extent_page;
 	spdk_bs_sequence_t	        *seq;
 
 	spdk_bs_sequence_cpl		cb_fn;
 	void				*cb_arg;
 };
 
-static uint32_t
-_spdk_blob_md_page_calc_crc(void *page)
-{
-	uint32_t		crc;
-
-	crc = BLOB_CRC32C_INITIAL;
-	crc = spdk_crc32c_update(page, SPDK_BS_PAGE_SIZE - 4, crc);
-	crc ^= BLOB_CRC32C_INITIAL;
-
-	return crc;
-
-}
-
 static void
 _spdk_blob_load_final(void *cb_arg, int bserrno)
 {
@@ -941,14 +1601,103 @@ error:
 	free(ctx);
 }
 
+static void _spdk_blob_load_backing_dev(spdk_bs_sequence_t *seq, struct spdk_blob_load_ctx *ctx);
+
+static void
+_spdk_blob_load_extent_page_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
+
+static void
+_spdk_blob_load_extent_pages(spdk_bs_sequence_t *seq, struct spdk_blob_load_ctx *ctx)
+{
+	struct spdk_blob	*blob = ctx->blob;
+	struct spdk_blob_store	*bs = blob->bs;
+	uint32_t		page_num;
+	uint64_t		i;
+
+	while (ctx->next_extent_page < blob->active.num_extent_pages) {
+		page_num = blob->active.extent_pages[ctx->next_extent_page++];
+		if (page_num == 0) {
+			/* None of the clusters in this range are allocated */
+			continue;
+		}
+
+		if (page_num >= bs->md_len) {
+			_spdk_blob_load_extent_page_cpl(seq, ctx, -EINVAL);
+			return;
+		}
+
+		if (ctx->extent_page == NULL) {
+			ctx->extent_page = spdk_malloc(SPDK_BS_PAGE_SIZE, SPDK_BS_PAGE_SIZE, NULL,
+						       SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+			if (ctx->extent_page == NULL) {
+				_spdk_blob_load_extent_page_cpl(seq, ctx, -ENOMEM);
+				return;
+			}
+		}
+
+		spdk_bs_sequence_read_dev(seq, ctx->extent_page,
+					  _spdk_bs_page_to_lba(bs, bs->md_start + page_num),
+					  _spdk_bs_byte_to_lba(bs, SPDK_BS_PAGE_SIZE),
+					  _spdk_blob_load_extent_page_cpl, ctx);
+		return;
+	}
+
+	spdk_free(ctx->extent_page);
+	ctx->extent_page = NULL;
+
+	if (!spdk_blob_is_thin_provisioned(blob)) {
+		/* Every cluster of a thick provisioned blob must be allocated */
+		for (i = 0; i < blob->active.num_clusters; i++) {
+			if (blob->active.clusters[i] == 0) {
+				_spdk_blob_free(blob);
+				ctx->cb_fn(seq, NULL, -EINVAL);
+				spdk_free(ctx->pages);
+				free(ctx);
+				return;
+			}
+		}
+	}
+
+	_spdk_blob_load_backing_dev(seq, ctx);
+}
+
+static void
+_spdk_blob_load_extent_page_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_load_ctx	*ctx = cb_arg;
+	struct spdk_blob		*blob = ctx->blob;
+	struct spdk_blob_md_page	*page = ctx->extent_page;
+
+	if (bserrno == 0) {
+		if (_spdk_blob_md_page_calc_crc(page) != page->crc) {
+			SPDK_ERRLOG("Extent page %" PRIu64 " crc mismatch\n", ctx->next_extent_page - 1);
+			bserrno = -EINVAL;
+		} else if (page->id != blob->id || page->sequence_num != 0) {
+			bserrno = -EINVAL;
+		} else {
+			bserrno = _spdk_blob_parse_page(page, blob);
+		}
+	}
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("Failed to load extent page of blob %" PRIu64 ": %d\n", blob->id, bserrno);
+		_spdk_blob_free(blob);
+		ctx->cb_fn(seq, NULL, bserrno);
+		spdk_free(ctx->extent_page);
+		spdk_free(ctx->pages);
+		free(ctx);
+		return;
+	}
+
+	_spdk_blob_load_extent_pages(seq, ctx);
+}
+
 static void
 _spdk_blob_load_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob_load_ctx	*ctx = cb_arg;
 	struct spdk_blob		*blob = ctx->blob;
 	struct spdk_blob_md_page	*page;
-	const void			*value;
-	size_t				len;
 	int				rc;
 	uint32_t			crc;
 
@@ -1007,10 +1756,74 @@ _spdk_blob_load_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		free(ctx);
 		return;
 	}
-	ctx->seq = seq;
 
+	if (blob->use_extent_table) {
+		_spdk_blob_load_extent_pages(seq, ctx);
+		return;
+	}
+
+	_spdk_blob_load_backing_dev(seq, ctx);
+}
+
+static int
+_spdk_blob_load_esnap_dev(struct spdk_blob *blob)
+{
+	struct spdk_blob_store		*bs = blob->bs;
+	struct spdk_bs_dev		*bs_dev = NULL;
+	const void			*esnap_id;
+	size_t				id_len;
+	int				rc;
+
+	if (bs->esnap_bs_dev_create == NULL) {
+		SPDK_ERRLOG("Blob 0x%" PRIx64 " is a clone of an external snapshot, "
+			    "but no external snapshot device callback was provided\n", blob->id);
+		return -ENOTSUP;
+	}
+
+	rc = _spdk_blob_get_xattr_value(blob, BLOB_EXTERNAL_SNAPSHOT_ID, &esnap_id, &id_len, true);
+	if (rc != 0) {
+		SPDK_ERRLOG("Blob 0x%" PRIx64 " has no external snapshot id\n", blob->id);
+		return -EINVAL;
+	}
+
+	rc = bs->esnap_bs_dev_create(bs->esnap_ctx, blob, esnap_id, id_len, &bs_dev);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to create external snapshot device of blob 0x%" PRIx64 ": %d\n",
+			    blob->id, rc);
+		return rc;
+	}
+
+	if (bs_dev->blocklen > bs->io_unit_size || bs->io_unit_size % bs_dev->blocklen != 0) {
+		SPDK_ERRLOG("External snapshot block size %" PRIu32 " does not divide io unit size %"
+			    PRIu32 "\n", bs_dev->blocklen, bs->io_unit_size);
+		bs_dev->destroy(bs_dev);
+		return -EINVAL;
+	}
+
+	blob->back_bs_dev = bs_dev;
+	return 0;
+}
+
+static void
+_spdk_blob_load_backing_dev(spdk_bs_sequence_t *seq, struct spdk_blob_load_ctx *ctx)
+{
+	struct spdk_blob		*blob = ctx->blob;
+	const void			*value;
+	size_t				len;
+	int				rc;
+
+	ctx->seq = seq;
 
-	if (spdk_blob_is_thin_provisioned(blob)) {
+	if (blob->invalid_flags & SPDK_BLOB_EXTERNAL_SNAPSHOT) {
+		rc = _spdk_blob_load_esnap_dev(blob);
+		if (rc != 0) {
+			_spdk_blob_free(blob);
+			ctx->cb_fn(seq, NULL, rc);
+			spdk_free(ctx->pages);
+			free(ctx);
+			return;
+		}
+	} else if (spdk_blob_is_thin_provisioned(blob)) {
 		rc = _spdk_blob_get_xattr_value(blob, BLOB_SNAPSHOT, &value, &len, true);
 		if (rc == 0) {
 			if (len != sizeof(spdk_blob_id)) {
@@ -1033,7 +1846,7 @@ _spdk_blob_load_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		/* standard blob */
 		blob->back_bs_dev = NULL;
 	}
-	_spdk_blob_load_final(ctx, bserrno);
+	_spdk_blob_load_final(ctx, 0);
 }
 
 /* Load a blob from disk given a blobid */
@@ -1077,74 +1890,281 @@ _spdk_blob_load(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 				  _spdk_blob_load_cpl, ctx);
 }
 
-struct spdk_blob_persist_ctx {
-	struct spdk_blob		*blob;
+/* Metadata writes submitted close together, by one or many blobs, are written
+ * as a group: sorted by page, with adjacent pages merged into single writes.
+ */
+struct spdk_bs_md_commit_group {
+	struct spdk_blob_store		*bs;
+	TAILQ_HEAD(, spdk_bs_md_commit)	commits;
+	struct iovec			iovs[0];
+};
 
-	struct spdk_bs_super_block	*super;
+static void _spdk_bs_md_commit_flush(struct spdk_blob_store *bs);
 
-	struct spdk_blob_md_page	*pages;
+static int
+_spdk_bs_md_write_cmp(const void *a, const void *b)
+{
+	const struct spdk_bs_md_write *wa = *(struct spdk_bs_md_write *const *)a;
+	const struct spdk_bs_md_write *wb = *(struct spdk_bs_md_write *const *)b;
 
-	uint64_t			idx;
+	if (wa->page_idx != wb->page_idx) {
+		return wa->page_idx < wb->page_idx ? -1 : 1;
+	}
 
-	spdk_bs_sequence_t		*seq;
-	spdk_bs_sequence_cpl		cb_fn;
-	void				*cb_arg;
-};
+	return wa->order < wb->order ? -1 : (wa->order > wb->order);
+}
 
 static void
-spdk_bs_batch_clear_dev(struct spdk_blob_persist_ctx *ctx, spdk_bs_batch_t *batch, uint64_t lba,
-			uint32_t lba_count)
+_spdk_bs_md_commit_fail(struct spdk_blob_store *bs, int bserrno)
 {
-	if (ctx->blob->clear_method == BLOB_CLEAR_WITH_DEFAULT ||
-	    ctx->blob->clear_method == BLOB_CLEAR_WITH_UNMAP) {
-		spdk_bs_batch_unmap_dev(batch, lba, lba_count);
-	} else if (ctx->blob->clear_method == BLOB_CLEAR_WITH_WRITE_ZEROES) {
-		spdk_bs_batch_write_zeroes_dev(batch, lba, lba_count);
+	struct spdk_bs_md_commit *commit;
+	TAILQ_HEAD(, spdk_bs_md_commit) commits;
+
+	TAILQ_INIT(&commits);
+	TAILQ_SWAP(&commits, &bs->md_commits, spdk_bs_md_commit, link);
+
+	while ((commit = TAILQ_FIRST(&commits))) {
+		TAILQ_REMOVE(&commits, commit, link);
+		commit->cb_fn(commit->seq, commit->cb_arg, bserrno);
 	}
 }
 
 static void
-_spdk_blob_persist_complete(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+_spdk_bs_md_commit_flush_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
-	struct spdk_blob_persist_ctx	*ctx = cb_arg;
-	struct spdk_blob		*blob = ctx->blob;
+	struct spdk_bs_md_commit_group	*group = cb_arg;
+	struct spdk_blob_store		*bs = group->bs;
+	struct spdk_bs_md_commit	*commit;
 
-	if (bserrno == 0) {
-		_spdk_blob_mark_clean(blob);
+	/* Anything submitted from the callbacks, like the root pages written
+	 * after the rest of a page chain, waits for the next group commit.
+	 */
+	while ((commit = TAILQ_FIRST(&group->commits))) {
+		TAILQ_REMOVE(&group->commits, commit, link);
+		commit->cb_fn(commit->seq, commit->cb_arg, bserrno);
 	}
 
-	/* Call user callback */
-	ctx->cb_fn(seq, ctx->cb_arg, bserrno);
+	free(group);
 
-	/* Free the memory */
-	spdk_free(ctx->pages);
-	free(ctx);
+	bs->md_commit_inflight = false;
+	_spdk_bs_md_commit_flush(bs);
 }
 
 static void
-_spdk_blob_persist_clear_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+_spdk_bs_md_commit_flush(struct spdk_blob_store *bs)
 {
-	struct spdk_blob_persist_ctx	*ctx = cb_arg;
-	struct spdk_blob		*blob = ctx->blob;
-	struct spdk_blob_store		*bs = blob->bs;
-	size_t				i;
+	struct spdk_bs_md_commit_group	*group;
+	struct spdk_bs_md_commit	*commit;
+	struct spdk_bs_md_write		**writes;
+	spdk_bs_batch_t			*batch;
+	uint64_t			lba_count;
+	uint32_t			num_writes = 0;
+	uint32_t			run_idx = 0, run_len = 0, iovcnt = 0;
+	uint32_t			i;
 
-	/* Release all clusters that were truncated */
-	for (i = blob->active.num_clusters; i < blob->active.cluster_array_size; i++) {
-		uint32_t cluster_num = _spdk_bs_lba_to_cluster(bs, blob->active.clusters[i]);
+	assert(!bs->md_commit_inflight);
+	spdk_poller_unregister(&bs->md_commit_poller);
 
-		/* Nothing to release if it was not allocated */
-		if (blob->active.clusters[i] != 0) {
-			_spdk_bs_release_cluster(bs, cluster_num);
-		}
+	if (TAILQ_EMPTY(&bs->md_commits)) {
+		return;
 	}
 
-	if (blob->active.num_clusters == 0) {
-		free(blob->active.clusters);
-		blob->active.clusters = NULL;
-		blob->active.cluster_array_size = 0;
-	} else if (blob->active.num_clusters != blob->active.cluster_array_size) {
-#ifndef __clang_analyzer__
+	TAILQ_FOREACH(commit, &bs->md_commits, link) {
+		num_writes += commit->num_writes;
+	}
+
+	group = calloc(1, sizeof(*group) + num_writes * sizeof(struct iovec));
+	writes = calloc(num_writes, sizeof(*writes));
+	if (!group || !writes) {
+		free(group);
+		free(writes);
+		_spdk_bs_md_commit_fail(bs, -ENOMEM);
+		return;
+	}
+
+	group->bs = bs;
+	TAILQ_INIT(&group->commits);
+	TAILQ_SWAP(&group->commits, &bs->md_commits, spdk_bs_md_commit, link);
+	bs->md_commit_inflight = true;
+
+	num_writes = 0;
+	TAILQ_FOREACH(commit, &group->commits, link) {
+		for (i = 0; i < commit->num_writes; i++) {
+			commit->writes[i].order = num_writes;
+			writes[num_writes++] = &commit->writes[i];
+		}
+	}
+	qsort(writes, num_writes, sizeof(*writes), _spdk_bs_md_write_cmp);
+
+	lba_count = _spdk_bs_byte_to_lba(bs, SPDK_BS_PAGE_SIZE);
+
+	/* The group is written using the sequence of its first commit */
+	commit = TAILQ_FIRST(&group->commits);
+	batch = spdk_bs_sequence_to_batch(commit->seq, _spdk_bs_md_commit_flush_cpl, group);
+
+	for (i = 0; i < num_writes; i++) {
+		/* Only the last write of a page submitted to the group matters */
+		if (i + 1 < num_writes && writes[i + 1]->page_idx == writes[i]->page_idx) {
+			continue;
+		}
+
+		if (run_len > 0 && (writes[i]->page_idx != run_idx + run_len ||
+				    run_len == SPDK_BS_MD_COMMIT_MAX_RUN)) {
+			spdk_bs_batch_writev_dev(batch, &group->iovs[iovcnt - run_len], run_len,
+						 _spdk_bs_page_to_lba(bs, bs->md_start + run_idx),
+						 run_len * lba_count);
+			run_len = 0;
+		}
+
+		if (run_len == 0) {
+			run_idx = writes[i]->page_idx;
+		}
+		group->iovs[iovcnt].iov_base = writes[i]->page;
+		group->iovs[iovcnt].iov_len = SPDK_BS_PAGE_SIZE;
+		iovcnt++;
+		run_len++;
+	}
+
+	if (run_len > 0) {
+		spdk_bs_batch_writev_dev(batch, &group->iovs[iovcnt - run_len], run_len,
+					 _spdk_bs_page_to_lba(bs, bs->md_start + run_idx),
+					 run_len * lba_count);
+	}
+
+	free(writes);
+	spdk_bs_batch_close(batch);
+}
+
+static int
+_spdk_bs_md_commit_window_expired(void *arg)
+{
+	struct spdk_blob_store *bs = arg;
+
+	_spdk_bs_md_commit_flush(bs);
+
+	return 1;
+}
+
+/* Queue metadata page writes for the next group commit. Must be called on
+ * the metadata thread, with a sequence started on the metadata channel.
+ */
+static void
+_spdk_bs_md_commit_submit(struct spdk_blob_store *bs, struct spdk_bs_md_commit *commit)
+{
+	if (commit->num_writes == 0) {
+		commit->cb_fn(commit->seq, commit->cb_arg, 0);
+		return;
+	}
+
+	TAILQ_INSERT_TAIL(&bs->md_commits, commit, link);
+
+	if (bs->md_commit_inflight || bs->md_commit_poller != NULL) {
+		return;
+	}
+
+	if (bs->md_commit_window_us != 0) {
+		bs->md_commit_poller = spdk_poller_register(_spdk_bs_md_commit_window_expired, bs,
+				       bs->md_commit_window_us);
+		if (bs->md_commit_poller != NULL) {
+			return;
+		}
+	}
+
+	_spdk_bs_md_commit_flush(bs);
+}
+
+struct spdk_blob_persist_ctx {
+	struct spdk_blob		*blob;
+
+	struct spdk_bs_super_block	*super;
+
+	struct spdk_blob_md_page	*pages;
+
+	/* Extent pages that changed since the last sync, and their md page offsets */
+	struct spdk_blob_md_page	*extent_pages;
+	uint32_t			*extent_page_idx;
+	uint64_t			num_extent_pages;
+
+	/* Page writes handed to the group commit, the root page first */
+	struct spdk_bs_md_write		*md_writes;
+	struct spdk_bs_md_commit	commit;
+
+	uint64_t			idx;
+
+	spdk_bs_sequence_t		*seq;
+	spdk_bs_sequence_cpl		cb_fn;
+	void				*cb_arg;
+};
+
+static void
+spdk_bs_batch_clear_dev(struct spdk_blob_persist_ctx *ctx, spdk_bs_batch_t *batch, uint64_t lba,
+			uint32_t lba_count)
+{
+	if (ctx->blob->clear_method == BLOB_CLEAR_WITH_DEFAULT ||
+	    ctx->blob->clear_method == BLOB_CLEAR_WITH_UNMAP) {
+		spdk_bs_batch_unmap_dev(batch, lba, lba_count);
+	} else if (ctx->blob->clear_method == BLOB_CLEAR_WITH_WRITE_ZEROES) {
+		spdk_bs_batch_write_zeroes_dev(batch, lba, lba_count);
+	}
+}
+
+static void
+_spdk_blob_persist_complete(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_persist_ctx	*ctx = cb_arg;
+	struct spdk_blob		*blob = ctx->blob;
+
+	if (bserrno == 0) {
+		_spdk_blob_mark_clean(blob);
+	}
+
+	/* Cluster releases queued up behind this write can go now. This has to
+	 * happen before the user callback, which may free the blob.
+	 */
+	assert(blob->persists_in_progress > 0);
+	blob->persists_in_progress--;
+	_spdk_blob_submit_releases(blob);
+
+	/* Call user callback */
+	ctx->cb_fn(seq, ctx->cb_arg, bserrno);
+
+	/* Free the memory */
+	spdk_free(ctx->pages);
+	spdk_free(ctx->extent_pages);
+	free(ctx->extent_page_idx);
+	free(ctx->md_writes);
+	free(ctx);
+}
+
+static void
+_spdk_blob_persist_clear_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_persist_ctx	*ctx = cb_arg;
+	struct spdk_blob		*blob = ctx->blob;
+	struct spdk_blob_store		*bs = blob->bs;
+	size_t				i;
+
+	/* Release all clusters that were truncated */
+	for (i = blob->active.num_clusters; i < blob->active.cluster_array_size; i++) {
+		uint32_t cluster_num = _spdk_bs_lba_to_cluster(bs, blob->active.clusters[i]);
+
+		/* Nothing to release if it was not allocated */
+		if (blob->active.clusters[i] != 0) {
+			_spdk_bs_release_cluster(bs, cluster_num);
+		}
+	}
+
+	/* Masks of the truncated clusters must not apply if the blob grows again */
+	if (blob->subcluster_mask_array_size > blob->active.num_clusters) {
+		blob->subcluster_mask_array_size = blob->active.num_clusters;
+	}
+
+	if (blob->active.num_clusters == 0) {
+		free(blob->active.clusters);
+		blob->active.clusters = NULL;
+		blob->active.cluster_array_size = 0;
+	} else if (blob->active.num_clusters != blob->active.cluster_array_size) {
+#ifndef __clang_analyzer__
 		void *tmp;
 
 		/* scan-build really can't figure reallocs, workaround it */
@@ -1212,6 +2232,26 @@ _spdk_blob_persist_clear_clusters(spdk_bs_sequence_t *seq, void *cb_arg, int bse
 	spdk_bs_batch_close(batch);
 }
 
+/* Whether the clean extent page at index ep is no longer used once the
+ * blob metadata currently being persisted is on disk.
+ */
+static bool
+_spdk_blob_extent_page_is_released(const struct spdk_blob *blob, uint64_t ep)
+{
+	uint32_t page_num = blob->clean.extent_pages[ep];
+
+	if (page_num == 0) {
+		return false;
+	}
+
+	/* Deleting the blob releases all of its metadata */
+	if (blob->active.num_pages == 0) {
+		return true;
+	}
+
+	return ep >= blob->active.num_extent_pages || blob->active.extent_pages[ep] != page_num;
+}
+
 static void
 _spdk_blob_persist_zero_pages_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
@@ -1235,6 +2275,12 @@ _spdk_blob_persist_zero_pages_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bse
 		spdk_bit_array_clear(bs->used_md_pages, page_num);
 	}
 
+	for (i = 0; i < blob->clean.num_extent_pages; i++) {
+		if (_spdk_blob_extent_page_is_released(blob, i)) {
+			spdk_bit_array_clear(bs->used_md_pages, blob->clean.extent_pages[i]);
+		}
+	}
+
 	/* Move on to clearing clusters */
 	_spdk_blob_persist_clear_clusters(seq, ctx, 0);
 }
@@ -1275,6 +2321,16 @@ _spdk_blob_persist_zero_pages(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno
 		spdk_bs_batch_write_zeroes_dev(batch, lba, lba_count);
 	}
 
+	/* Like the rest of the chain, changed extent pages were written to new
+	 * locations, so the ones the clean extent table points to can go now.
+	 */
+	for (i = 0; i < blob->clean.num_extent_pages; i++) {
+		if (_spdk_blob_extent_page_is_released(blob, i)) {
+			lba = _spdk_bs_page_to_lba(bs, bs->md_start + blob->clean.extent_pages[i]);
+			spdk_bs_batch_write_zeroes_dev(batch, lba, lba_count);
+		}
+	}
+
 	spdk_bs_batch_close(batch);
 }
 
@@ -1283,10 +2339,6 @@ _spdk_blob_persist_write_page_root(spdk_bs_sequence_t *seq, void *cb_arg, int bs
 {
 	struct spdk_blob_persist_ctx	*ctx = cb_arg;
 	struct spdk_blob		*blob = ctx->blob;
-	struct spdk_blob_store		*bs = blob->bs;
-	uint64_t			lba;
-	uint32_t			lba_count;
-	struct spdk_blob_md_page	*page;
 
 	if (blob->active.num_pages == 0) {
 		/* Move on to the next step */
@@ -1294,14 +2346,16 @@ _spdk_blob_persist_write_page_root(spdk_bs_sequence_t *seq, void *cb_arg, int bs
 		return;
 	}
 
-	lba_count = _spdk_bs_byte_to_lba(bs, sizeof(*page));
-
-	page = &ctx->pages[0];
 	/* The first page in the metadata goes where the blobid indicates */
-	lba = _spdk_bs_page_to_lba(bs, bs->md_start + _spdk_bs_blobid_to_page(blob->id));
+	ctx->md_writes[0].page = &ctx->pages[0];
+	ctx->md_writes[0].page_idx = _spdk_bs_blobid_to_page(blob->id);
 
-	spdk_bs_sequence_write_dev(seq, page, lba, lba_count,
-				   _spdk_blob_persist_zero_pages, ctx);
+	ctx->commit.seq = seq;
+	ctx->commit.cb_fn = _spdk_blob_persist_zero_pages;
+	ctx->commit.cb_arg = ctx;
+	ctx->commit.writes = ctx->md_writes;
+	ctx->commit.num_writes = 1;
+	_spdk_bs_md_commit_submit(blob->bs, &ctx->commit);
 }
 
 static void
@@ -1309,34 +2363,39 @@ _spdk_blob_persist_write_page_chain(spdk_bs_sequence_t *seq, void *cb_arg, int b
 {
 	struct spdk_blob_persist_ctx	*ctx = cb_arg;
 	struct spdk_blob		*blob = ctx->blob;
-	struct spdk_blob_store		*bs = blob->bs;
-	uint64_t			lba;
-	uint32_t			lba_count;
-	struct spdk_blob_md_page	*page;
-	spdk_bs_batch_t			*batch;
+	struct spdk_bs_md_write		*write = &ctx->md_writes[1];
 	size_t				i;
 
 	/* Clusters don't move around in blobs. The list shrinks or grows
 	 * at the end, but no changes ever occur in the middle of the list.
 	 */
 
-	lba_count = _spdk_bs_byte_to_lba(bs, sizeof(*page));
-
-	batch = spdk_bs_sequence_to_batch(seq, _spdk_blob_persist_write_page_root, ctx);
-
 	/* This starts at 1. The root page is not written until
 	 * all of the others are finished
 	 */
 	for (i = 1; i < blob->active.num_pages; i++) {
-		page = &ctx->pages[i];
-		assert(page->sequence_num == i);
+		assert(ctx->pages[i].sequence_num == i);
 
-		lba = _spdk_bs_page_to_lba(bs, bs->md_start + blob->active.pages[i]);
+		write->page = &ctx->pages[i];
+		write->page_idx = blob->active.pages[i];
+		write++;
+	}
 
-		spdk_bs_batch_write_dev(batch, page, lba, lba_count);
+	/* Extent pages referenced by the new extent table must also be on
+	 * disk before the root page.
+	 */
+	for (i = 0; i < ctx->num_extent_pages; i++) {
+		write->page = &ctx->extent_pages[i];
+		write->page_idx = ctx->extent_page_idx[i];
+		write++;
 	}
 
-	spdk_bs_batch_close(batch);
+	ctx->commit.seq = seq;
+	ctx->commit.cb_fn = _spdk_blob_persist_write_page_root;
+	ctx->commit.cb_arg = ctx;
+	ctx->commit.writes = &ctx->md_writes[1];
+	ctx->commit.num_writes = write - &ctx->md_writes[1];
+	_spdk_bs_md_commit_submit(blob->bs, &ctx->commit);
 }
 
 static int
@@ -1371,6 +2430,12 @@ _spdk_blob_resize(struct spdk_blob *blob, uint64_t sz)
 	 * and another to actually claim them.
 	 */
 
+	if (spdk_blob_is_thin_provisioned(blob) == false && sz > num_clusters && bs->md_channel) {
+		/* Clusters parked in the metadata thread's channel pool still count
+		 * as free, so give them back before looking for room. */
+		_spdk_bs_channel_release_clusters(spdk_io_channel_get_ctx(bs->md_channel));
+	}
+
 	if (spdk_blob_is_thin_provisioned(blob) == false) {
 		lfc = 0;
 		for (i = num_clusters; i < sz; i++) {
@@ -1412,6 +2477,112 @@ _spdk_blob_resize(struct spdk_blob *blob, uint64_t sz)
 	return 0;
 }
 
+static bool
+_spdk_blob_extent_page_is_dirty(const struct spdk_blob *blob, uint64_t ep)
+{
+	uint64_t start_cluster, active_end, clean_end;
+
+	start_cluster = ep * SPDK_EXTENTS_PER_EP;
+	active_end = spdk_min(start_cluster + SPDK_EXTENTS_PER_EP, blob->active.num_clusters);
+	clean_end = spdk_min(start_cluster + SPDK_EXTENTS_PER_EP, blob->clean.num_clusters);
+
+	if (active_end != clean_end) {
+		return true;
+	}
+
+	return memcmp(&blob->active.clusters[start_cluster], &blob->clean.clusters[start_cluster],
+		      (active_end - start_cluster) * sizeof(uint64_t)) != 0;
+}
+
+/* Write every extent page whose clusters changed since the last sync to a
+ * newly allocated metadata page, so that the blob either refers to the old or
+ * to the new extent pages until the root page has been written. Extent pages
+ * of unchanged ranges are left untouched on disk and ranges without any
+ * allocated cluster do not need an extent page at all.
+ */
+static int
+_spdk_blob_persist_prepare_extent_pages(struct spdk_blob_persist_ctx *ctx)
+{
+	struct spdk_blob	*blob = ctx->blob;
+	struct spdk_blob_store	*bs = blob->bs;
+	uint64_t		num_extent_pages, start_cluster, end_cluster;
+	uint64_t		i, j;
+	uint32_t		page_num;
+	uint32_t		*tmp;
+
+	num_extent_pages = spdk_divide_round_up(blob->active.num_clusters, SPDK_EXTENTS_PER_EP);
+
+	if (num_extent_pages > blob->active.extent_pages_array_size) {
+		tmp = realloc(blob->active.extent_pages, num_extent_pages * sizeof(*tmp));
+		if (tmp == NULL) {
+			return -ENOMEM;
+		}
+		memset(tmp + blob->active.extent_pages_array_size, 0,
+		       (num_extent_pages - blob->active.extent_pages_array_size) * sizeof(*tmp));
+		blob->active.extent_pages = tmp;
+		blob->active.extent_pages_array_size = num_extent_pages;
+	}
+	blob->active.num_extent_pages = num_extent_pages;
+
+	if (num_extent_pages == 0) {
+		return 0;
+	}
+
+	ctx->extent_page_idx = calloc(num_extent_pages, sizeof(*ctx->extent_page_idx));
+	if (ctx->extent_page_idx == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_extent_pages; i++) {
+		if (blob->active.extent_pages[i] != 0 && i < blob->clean.num_extent_pages &&
+		    blob->active.extent_pages[i] == blob->clean.extent_pages[i] &&
+		    !_spdk_blob_extent_page_is_dirty(blob, i)) {
+			continue;
+		}
+
+		start_cluster = i * SPDK_EXTENTS_PER_EP;
+		end_cluster = spdk_min(start_cluster + SPDK_EXTENTS_PER_EP, blob->active.num_clusters);
+		for (j = start_cluster; j < end_cluster; j++) {
+			if (blob->active.clusters[j] != 0) {
+				break;
+			}
+		}
+		if (j == end_cluster) {
+			/* No clusters allocated in this range */
+			blob->active.extent_pages[i] = 0;
+			continue;
+		}
+
+		/* Page 0 is never used for extent pages, 0 marks an unallocated one */
+		page_num = spdk_bit_array_find_first_clear(bs->used_md_pages, 1);
+		if (page_num == UINT32_MAX) {
+			return -ENOMEM;
+		}
+		spdk_bit_array_set(bs->used_md_pages, page_num);
+		SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Claiming extent page %u for blob %lu\n", page_num, blob->id);
+		blob->active.extent_pages[i] = page_num;
+		ctx->extent_page_idx[ctx->num_extent_pages++] = i;
+	}
+
+	if (ctx->num_extent_pages == 0) {
+		return 0;
+	}
+
+	ctx->extent_pages = spdk_malloc(SPDK_BS_PAGE_SIZE * ctx->num_extent_pages, SPDK_BS_PAGE_SIZE,
+					NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (ctx->extent_pages == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < ctx->num_extent_pages; i++) {
+		_spdk_blob_serialize_extent_page(blob, ctx->extent_page_idx[i], &ctx->extent_pages[i]);
+		/* From here on only the md page offset is needed */
+		ctx->extent_page_idx[i] = blob->active.extent_pages[ctx->extent_page_idx[i]];
+	}
+
+	return 0;
+}
+
 static void
 _spdk_blob_persist_start(struct spdk_blob_persist_ctx *ctx)
 {
@@ -1434,6 +2605,14 @@ _spdk_blob_persist_start(struct spdk_blob_persist_ctx *ctx)
 
 	}
 
+	if (blob->use_extent_table) {
+		rc = _spdk_blob_persist_prepare_extent_pages(ctx);
+		if (rc < 0) {
+			_spdk_blob_persist_complete(seq, ctx, rc);
+			return;
+		}
+	}
+
 	/* Generate the new metadata */
 	rc = _spdk_blob_serialize(blob, &ctx->pages, &blob->active.num_pages);
 	if (rc < 0) {
@@ -1451,6 +2630,13 @@ _spdk_blob_persist_start(struct spdk_blob_persist_ctx *ctx)
 	}
 	blob->active.pages = tmp;
 
+	ctx->md_writes = calloc(blob->active.num_pages + ctx->num_extent_pages,
+				sizeof(*ctx->md_writes));
+	if (!ctx->md_writes) {
+		_spdk_blob_persist_complete(seq, ctx, -ENOMEM);
+		return;
+	}
+
 	/* Assign this metadata to pages. This requires two passes -
 	 * one to verify that there are enough pages and a second
 	 * to actually claim them. */
@@ -1538,11 +2724,13 @@ _spdk_blob_persist(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 	ctx->seq = seq;
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
+	blob->persists_in_progress++;
 
 	if (blob->bs->clean) {
 		ctx->super = spdk_zmalloc(sizeof(*ctx->super), 0x1000, NULL,
 					  SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
 		if (!ctx->super) {
+			blob->persists_in_progress--;
 			cb_fn(seq, cb_arg, -ENOMEM);
 			free(ctx);
 			return;
@@ -1558,26 +2746,45 @@ _spdk_blob_persist(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 
 struct spdk_blob_copy_cluster_ctx {
 	struct spdk_blob *blob;
+	struct spdk_bs_channel *channel;
 	uint8_t *buf;
 	uint64_t page;
+	uint32_t cluster_num;
 	uint64_t new_cluster;
 	spdk_bs_sequence_t *seq;
+	/* User ops waiting for this cluster to be allocated */
+	TAILQ_HEAD(, spdk_bs_request_set) requests;
+	TAILQ_ENTRY(spdk_blob_copy_cluster_ctx) link;
+
+	/* Sub-cluster copies only. The user op that triggered the copy is written
+	 * along with the parts of the cluster that it does not cover.
+	 */
+	spdk_bs_user_op_t *op;
+	bool op_written;
+	bool cluster_taken;
+	uint64_t filled;
+	uint32_t num_copies;
+	struct {
+		uint64_t offset; /* In io units from the beginning of the cluster */
+		uint64_t length;
+	} copies[SPDK_BLOB_MAX_SUBCLUSTERS];
+	struct spdk_thread *thread;
+	/* Copies of the same cluster waiting for this one, on the metadata thread */
+	TAILQ_HEAD(, spdk_blob_copy_cluster_ctx) claim_waiters;
+	TAILQ_ENTRY(spdk_blob_copy_cluster_ctx) claim_link;
 };
 
 static void
 _spdk_blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
 {
 	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
-	struct spdk_bs_request_set *set = (struct spdk_bs_request_set *)ctx->seq;
-	TAILQ_HEAD(, spdk_bs_request_set) requests;
 	spdk_bs_user_op_t *op;
 
-	TAILQ_INIT(&requests);
-	TAILQ_SWAP(&set->channel->need_cluster_alloc, &requests, spdk_bs_request_set, link);
+	TAILQ_REMOVE(&ctx->channel->pending_allocs, ctx, link);
 
-	while (!TAILQ_EMPTY(&requests)) {
-		op = TAILQ_FIRST(&requests);
-		TAILQ_REMOVE(&requests, op, link);
+	while (!TAILQ_EMPTY(&ctx->requests)) {
+		op = TAILQ_FIRST(&ctx->requests);
+		TAILQ_REMOVE(&ctx->requests, op, link);
 		if (bserrno == 0) {
 			spdk_bs_user_op_execute(op);
 		} else {
@@ -1601,7 +2808,7 @@ _spdk_blob_insert_cluster_cpl(void *cb_arg, int bserrno)
 			 * but continue without error. */
 			bserrno = 0;
 		}
-		_spdk_bs_release_cluster(ctx->blob->bs, ctx->new_cluster);
+		_spdk_bs_channel_put_cluster(ctx->channel, ctx->new_cluster);
 	}
 
 	spdk_bs_sequence_finish(ctx->seq, bserrno);
@@ -1611,7 +2818,6 @@ static void
 _spdk_blob_write_copy_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
-	uint32_t cluster_number;
 
 	if (bserrno) {
 		/* The write failed, so jump to the final completion handler */
@@ -1619,10 +2825,8 @@ _spdk_blob_write_copy_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		return;
 	}
 
-	cluster_number = _spdk_bs_page_to_cluster(ctx->blob->bs, ctx->page);
-
-	_spdk_blob_insert_cluster_on_md_thread(ctx->blob, cluster_number, ctx->new_cluster,
-					       _spdk_blob_insert_cluster_cpl, ctx);
+	_spdk_blob_insert_cluster_on_md_thread(ctx->channel, ctx->blob, ctx->cluster_num,
+					       ctx->new_cluster, _spdk_blob_insert_cluster_cpl, ctx);
 }
 
 static void
@@ -1643,47 +2847,381 @@ _spdk_blob_write_copy(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 				   _spdk_blob_write_copy_cpl, ctx);
 }
 
+static void _spdk_blob_copy_subclusters(void *arg);
+
 static void
-_spdk_bs_allocate_and_copy_cluster(struct spdk_blob *blob,
-				   struct spdk_io_channel *_ch,
-				   uint64_t io_unit, spdk_bs_user_op_t *op)
+_spdk_blob_release_cow_claim_msg(void *arg)
 {
-	struct spdk_bs_cpl cpl;
-	struct spdk_bs_channel *ch;
-	struct spdk_blob_copy_cluster_ctx *ctx;
-	uint32_t cluster_start_page;
-	uint32_t cluster_number;
-	int rc;
+	struct spdk_blob_copy_cluster_ctx *ctx = arg;
+	struct spdk_blob_copy_cluster_ctx *next;
 
-	ch = spdk_io_channel_get_ctx(_ch);
+	TAILQ_REMOVE(&ctx->blob->cow_claims, ctx, claim_link);
 
-	if (!TAILQ_EMPTY(&ch->need_cluster_alloc)) {
-		/* There are already operations pending. Queue this user op
-		 * and return because it will be re-executed when the outstanding
-		 * cluster allocation completes. */
-		TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
-		return;
+	next = TAILQ_FIRST(&ctx->claim_waiters);
+	if (next != NULL) {
+		TAILQ_REMOVE(&ctx->claim_waiters, next, claim_link);
+		TAILQ_SWAP(&next->claim_waiters, &ctx->claim_waiters, spdk_blob_copy_cluster_ctx, claim_link);
+		TAILQ_INSERT_TAIL(&ctx->blob->cow_claims, next, claim_link);
+		spdk_thread_send_msg(next->thread, _spdk_blob_copy_subclusters, next);
 	}
 
-	/* Round the io_unit offset down to the first page in the cluster */
-	cluster_start_page = _spdk_bs_io_unit_to_cluster_start(blob, io_unit);
+	free(ctx);
+}
 
-	/* Calculate which index in the metadata cluster array the corresponding
-	 * cluster is supposed to be at. */
-	cluster_number = _spdk_bs_io_unit_to_cluster_number(blob, io_unit);
+static void
+_spdk_blob_copy_subclusters_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+	spdk_bs_user_op_t *op;
 
-	ctx = calloc(1, sizeof(*ctx));
-	if (!ctx) {
-		spdk_bs_user_op_abort(op);
-		return;
-	}
+	TAILQ_REMOVE(&ctx->channel->pending_allocs, ctx, link);
 
-	assert(blob->bs->cluster_sz % blob->back_bs_dev->blocklen == 0);
+	if (ctx->cluster_taken && bserrno != 0) {
+		_spdk_bs_channel_put_cluster(ctx->channel, ctx->new_cluster);
+	}
+
+	if (bserrno != 0 || ctx->op_written) {
+		spdk_bs_user_op_complete(ctx->op, bserrno);
+	} else {
+		spdk_bs_user_op_execute(ctx->op);
+	}
+
+	while (!TAILQ_EMPTY(&ctx->requests)) {
+		op = TAILQ_FIRST(&ctx->requests);
+		TAILQ_REMOVE(&ctx->requests, op, link);
+		if (bserrno == 0) {
+			spdk_bs_user_op_execute(op);
+		} else {
+			spdk_bs_user_op_abort(op);
+		}
+	}
+
+	spdk_free(ctx->buf);
+	ctx->buf = NULL;
+
+	spdk_thread_send_msg(ctx->blob->bs->md_thread, _spdk_blob_release_cow_claim_msg, ctx);
+}
+
+static void
+_spdk_blob_fill_subclusters_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+
+	if (bserrno == -EEXIST) {
+		/* Another thread allocated the cluster first. Free ours and
+		 * write the user op to the allocated one instead. */
+		_spdk_bs_channel_put_cluster(ctx->channel, ctx->new_cluster);
+		ctx->cluster_taken = false;
+		ctx->op_written = false;
+		bserrno = 0;
+	}
+
+	spdk_bs_sequence_finish(ctx->seq, bserrno);
+}
+
+static void
+_spdk_blob_write_subclusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		spdk_bs_sequence_finish(seq, bserrno);
+		return;
+	}
+
+	_spdk_blob_fill_subclusters_on_md_thread(ctx->channel, ctx->blob, ctx->cluster_num,
+			ctx->new_cluster, ctx->filled,
+			_spdk_blob_fill_subclusters_cpl, ctx);
+}
+
+static void
+_spdk_blob_write_subclusters(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+	struct spdk_bs_user_op_args *args = &((struct spdk_bs_request_set *)ctx->op)->u.user_op;
+	struct spdk_blob_store *bs = ctx->blob->bs;
+	spdk_bs_batch_t *batch;
+	uint64_t lba, io_units_per_cluster, buf_offset;
+	uint32_t i;
+
+	if (bserrno != 0) {
+		/* The read failed, so jump to the final completion handler */
+		spdk_bs_sequence_finish(seq, bserrno);
+		return;
+	}
+
+	batch = spdk_bs_sequence_to_batch(seq, _spdk_blob_write_subclusters_cpl, ctx);
+
+	lba = _spdk_bs_cluster_to_lba(bs, ctx->new_cluster);
+	io_units_per_cluster = _spdk_bs_io_unit_per_page(bs) * bs->pages_per_cluster;
+
+	buf_offset = 0;
+	for (i = 0; i < ctx->num_copies; i++) {
+		spdk_bs_batch_write_dev(batch, ctx->buf + buf_offset * bs->io_unit_size,
+					lba + ctx->copies[i].offset, ctx->copies[i].length);
+		buf_offset += ctx->copies[i].length;
+	}
+
+	if (ctx->op_written && args->length > 0) {
+		lba += args->offset % io_units_per_cluster;
+		switch (args->type) {
+		case SPDK_BLOB_WRITE:
+			spdk_bs_batch_write_dev(batch, args->payload, lba, args->length);
+			break;
+		case SPDK_BLOB_WRITEV:
+			spdk_bs_batch_writev_dev(batch, args->payload, args->iovcnt, lba, args->length);
+			break;
+		case SPDK_BLOB_WRITE_ZEROES:
+			spdk_bs_batch_write_zeroes_dev(batch, lba, args->length);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+
+	spdk_bs_batch_close(batch);
+}
+
+static void
+_spdk_blob_add_subcluster_copy(struct spdk_blob_copy_cluster_ctx *ctx, uint64_t start,
+			       uint64_t end)
+{
+	if (ctx->num_copies > 0 &&
+	    ctx->copies[ctx->num_copies - 1].offset + ctx->copies[ctx->num_copies - 1].length == start) {
+		ctx->copies[ctx->num_copies - 1].length += end - start;
+		return;
+	}
+
+	assert(ctx->num_copies < SPDK_BLOB_MAX_SUBCLUSTERS);
+	ctx->copies[ctx->num_copies].offset = start;
+	ctx->copies[ctx->num_copies].length = end - start;
+	ctx->num_copies++;
+}
+
+/* Runs on the channel thread once the cluster is claimed. Only the parts of
+ * the sub-clusters touched by the user op, that the op does not overwrite
+ * itself, are read from the backing device.
+ */
+static void
+_spdk_blob_copy_subclusters(void *arg)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = arg;
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_blob_store *bs = blob->bs;
+	struct spdk_bs_user_op_args *args = &((struct spdk_bs_request_set *)ctx->op)->u.user_op;
+	uint64_t io_units_per_cluster, io_units_per_subcluster;
+	uint64_t cluster_lba, missing, touched;
+	uint64_t start, end, sub_start, sub_end, copy_len;
+	spdk_bs_batch_t *batch;
+	uint32_t i;
+	int rc;
+
+	io_units_per_cluster = _spdk_bs_io_unit_per_page(bs) * bs->pages_per_cluster;
+	io_units_per_subcluster = _spdk_bs_io_units_per_subcluster(bs);
+
+	/* Other channels may have copied parts of the cluster while this one was waiting */
+	cluster_lba = blob->active.clusters[ctx->cluster_num];
+	if (cluster_lba == 0) {
+		missing = _spdk_bs_subcluster_full_mask(bs);
+	} else {
+		missing = _spdk_blob_subcluster_mask(blob, ctx->cluster_num);
+	}
+
+	start = args->offset - (uint64_t)ctx->cluster_num * io_units_per_cluster;
+	end = start + args->length;
+
+	touched = 0;
+	for (i = 0; i < bs->subclusters_per_cluster; i++) {
+		sub_start = i * io_units_per_subcluster;
+		sub_end = spdk_min(sub_start + io_units_per_subcluster, io_units_per_cluster);
+		if (!(missing & (1ULL << i)) ||
+		    (args->length > 0 && (sub_end <= start || sub_start >= end))) {
+			continue;
+		}
+
+		touched |= 1ULL << i;
+		if (args->length == 0) {
+			_spdk_blob_add_subcluster_copy(ctx, sub_start, sub_end);
+			continue;
+		}
+		if (sub_start < start) {
+			_spdk_blob_add_subcluster_copy(ctx, sub_start, start);
+		}
+		if (sub_end > end) {
+			_spdk_blob_add_subcluster_copy(ctx, end, sub_end);
+		}
+	}
+
+	/* A zero length write only touches the cluster, so it is done once all of it is copied */
+	ctx->op_written = args->length == 0;
+
+	if (touched == 0) {
+		spdk_bs_sequence_finish(ctx->seq, 0);
+		return;
+	}
+
+	ctx->op_written = true;
+	ctx->filled = touched;
+
+	if (cluster_lba == 0) {
+		rc = _spdk_bs_channel_take_cluster(ctx->channel, &ctx->new_cluster);
+		if (rc != 0) {
+			spdk_bs_sequence_finish(ctx->seq, rc);
+			return;
+		}
+		ctx->cluster_taken = true;
+	} else {
+		ctx->new_cluster = _spdk_bs_lba_to_cluster(bs, cluster_lba);
+	}
+
+	if (ctx->num_copies == 0) {
+		_spdk_blob_write_subclusters(ctx->seq, ctx, 0);
+		return;
+	}
+
+	copy_len = 0;
+	for (i = 0; i < ctx->num_copies; i++) {
+		copy_len += ctx->copies[i].length;
+	}
+
+	ctx->buf = spdk_malloc(copy_len * bs->io_unit_size, blob->back_bs_dev->blocklen,
+			       NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!ctx->buf) {
+		SPDK_ERRLOG("DMA allocation for sub-cluster copy of size = %" PRIu64 " failed.\n",
+			    copy_len * bs->io_unit_size);
+		spdk_bs_sequence_finish(ctx->seq, -ENOMEM);
+		return;
+	}
+
+	batch = spdk_bs_sequence_to_batch(ctx->seq, _spdk_blob_write_subclusters, ctx);
+
+	copy_len = 0;
+	for (i = 0; i < ctx->num_copies; i++) {
+		uint64_t io_unit = (uint64_t)ctx->cluster_num * io_units_per_cluster + ctx->copies[i].offset;
+
+		spdk_bs_batch_read_bs_dev(batch, blob->back_bs_dev, ctx->buf + copy_len * bs->io_unit_size,
+					  _spdk_bs_io_unit_to_back_dev_lba(blob, io_unit),
+					  _spdk_bs_io_unit_to_back_dev_lba(blob, ctx->copies[i].length));
+		copy_len += ctx->copies[i].length;
+	}
+
+	spdk_bs_batch_close(batch);
+}
+
+static void
+_spdk_blob_claim_cow_cluster_msg(void *arg)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = arg;
+	struct spdk_blob_copy_cluster_ctx *owner;
+
+	TAILQ_FOREACH(owner, &ctx->blob->cow_claims, claim_link) {
+		if (owner->cluster_num == ctx->cluster_num) {
+			TAILQ_INSERT_TAIL(&owner->claim_waiters, ctx, claim_link);
+			return;
+		}
+	}
+
+	TAILQ_INSERT_TAIL(&ctx->blob->cow_claims, ctx, claim_link);
+	spdk_thread_send_msg(ctx->thread, _spdk_blob_copy_subclusters, ctx);
+}
+
+/* Copy only the missing parts of the cluster that the user op touches. Copies
+ * of the same cluster from different channels are serialized by claiming the
+ * cluster on the metadata thread, so that a copy never overwrites data written
+ * by another one.
+ */
+static void
+_spdk_bs_copy_subclusters(struct spdk_blob *blob, struct spdk_io_channel *_ch,
+			  uint32_t cluster_number, spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_cpl cpl;
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(_ch);
+	struct spdk_blob_copy_cluster_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_bs_user_op_abort(op);
+		return;
+	}
 
 	ctx->blob = blob;
+	ctx->channel = ch;
+	ctx->cluster_num = cluster_number;
+	ctx->op = op;
+	ctx->thread = spdk_get_thread();
+	TAILQ_INIT(&ctx->requests);
+	TAILQ_INIT(&ctx->claim_waiters);
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = _spdk_blob_copy_subclusters_cpl;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	ctx->seq = spdk_bs_sequence_start(_ch, &cpl);
+	if (!ctx->seq) {
+		free(ctx);
+		spdk_bs_user_op_abort(op);
+		return;
+	}
+
+	/* Block other incoming operations on this cluster on this channel */
+	TAILQ_INSERT_TAIL(&ch->pending_allocs, ctx, link);
+
+	spdk_thread_send_msg(blob->bs->md_thread, _spdk_blob_claim_cow_cluster_msg, ctx);
+}
+
+static void
+_spdk_bs_allocate_and_copy_cluster(struct spdk_blob *blob,
+				   struct spdk_io_channel *_ch,
+				   uint64_t io_unit, spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_cpl cpl;
+	struct spdk_bs_channel *ch;
+	struct spdk_blob_copy_cluster_ctx *ctx;
+	uint32_t cluster_start_page;
+	uint32_t cluster_number;
+	int rc;
+
+	ch = spdk_io_channel_get_ctx(_ch);
+
+	/* Calculate which index in the metadata cluster array the corresponding
+	 * cluster is supposed to be at. */
+	cluster_number = _spdk_bs_io_unit_to_cluster_number(blob, io_unit);
+
+	TAILQ_FOREACH(ctx, &ch->pending_allocs, link) {
+		if (ctx->blob == blob && ctx->cluster_num == cluster_number) {
+			/* This cluster is already being allocated. Queue this user op
+			 * and return because it will be re-executed when the outstanding
+			 * cluster allocation completes. */
+			TAILQ_INSERT_TAIL(&ctx->requests, op, link);
+			return;
+		}
+	}
+
+	if (blob->use_subcluster_cow && (_spdk_blob_has_parent(blob) ||
+					 _spdk_blob_subcluster_mask(blob, cluster_number) != 0)) {
+		_spdk_bs_copy_subclusters(blob, _ch, cluster_number, op);
+		return;
+	}
+
+	/* Round the io_unit offset down to the first page in the cluster */
+	cluster_start_page = _spdk_bs_io_unit_to_cluster_start(blob, io_unit);
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_bs_user_op_abort(op);
+		return;
+	}
+
+	assert(blob->bs->cluster_sz % blob->back_bs_dev->blocklen == 0);
+
+	ctx->blob = blob;
+	ctx->channel = ch;
 	ctx->page = cluster_start_page;
+	ctx->cluster_num = cluster_number;
+	TAILQ_INIT(&ctx->requests);
 
-	if (blob->parent_id != SPDK_BLOBID_INVALID) {
+	if (_spdk_blob_has_parent(blob)) {
 		ctx->buf = spdk_malloc(blob->bs->cluster_sz, blob->back_bs_dev->blocklen,
 				       NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
 		if (!ctx->buf) {
@@ -1695,7 +3233,7 @@ _spdk_bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 		}
 	}
 
-	rc = _spdk_bs_allocate_cluster(blob, cluster_number, &ctx->new_cluster, false);
+	rc = _spdk_bs_channel_take_cluster(ch, &ctx->new_cluster);
 	if (rc != 0) {
 		spdk_free(ctx->buf);
 		free(ctx);
@@ -1709,35 +3247,167 @@ _spdk_bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 
 	ctx->seq = spdk_bs_sequence_start(_ch, &cpl);
 	if (!ctx->seq) {
-		_spdk_bs_release_cluster(blob->bs, ctx->new_cluster);
+		_spdk_bs_channel_put_cluster(ch, ctx->new_cluster);
 		spdk_free(ctx->buf);
 		free(ctx);
 		spdk_bs_user_op_abort(op);
 		return;
 	}
 
-	/* Queue the user op to block other incoming operations */
-	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
+	/* Queue the user op to block other incoming operations on this cluster */
+	TAILQ_INSERT_TAIL(&ctx->requests, op, link);
+	TAILQ_INSERT_TAIL(&ch->pending_allocs, ctx, link);
 
-	if (blob->parent_id != SPDK_BLOBID_INVALID) {
+	if (_spdk_blob_has_parent(blob)) {
 		/* Read cluster from backing device */
 		spdk_bs_sequence_read_bs_dev(ctx->seq, blob->back_bs_dev, ctx->buf,
 					     _spdk_bs_dev_page_to_lba(blob->back_bs_dev, cluster_start_page),
 					     _spdk_bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz),
 					     _spdk_blob_write_copy, ctx);
 	} else {
-		_spdk_blob_insert_cluster_on_md_thread(ctx->blob, cluster_number, ctx->new_cluster,
+		_spdk_blob_insert_cluster_on_md_thread(ch, ctx->blob, cluster_number, ctx->new_cluster,
 						       _spdk_blob_insert_cluster_cpl, ctx);
 	}
 }
 
+/* Follow the snapshots a clone is backed by to the one holding the data at
+ * io_unit, or to the device backing the oldest of them. Returns the number of
+ * io_units found at the same place. Snapshots that are frozen or smaller than
+ * their clone are not looked into, the read then goes through the back_bs_dev
+ * as usual and the result must not be cached.
+ */
+static uint64_t
+_spdk_blob_resolve_back_io_unit(struct spdk_blob *blob, uint64_t io_unit,
+				struct spdk_bs_dev **dev, uint64_t *lba, bool *cacheable)
+{
+	struct spdk_blob	*parent;
+	uint64_t		count;
+
+	count = _spdk_bs_num_io_units_to_valid_boundary(blob, io_unit);
+	*cacheable = true;
+
+	while (blob->parent_id != SPDK_BLOBID_INVALID) {
+		parent = ((struct spdk_blob_bs_dev *)blob->back_bs_dev)->blob;
+		if (parent->frozen_refcnt ||
+		    io_unit >= _spdk_bs_cluster_to_lba(parent->bs, parent->active.num_clusters)) {
+			*cacheable = false;
+			break;
+		}
+
+		blob = parent;
+		count = spdk_min(count, _spdk_bs_num_io_units_to_valid_boundary(blob, io_unit));
+		if (_spdk_bs_io_unit_is_valid(blob, io_unit)) {
+			*dev = NULL;
+			*lba = _spdk_bs_blob_io_unit_to_lba(blob, io_unit);
+			return count;
+		}
+	}
+
+	assert(blob->back_bs_dev != NULL);
+	*dev = blob->back_bs_dev;
+	*lba = _spdk_bs_io_unit_to_back_dev_lba(blob, io_unit);
+	return count;
+}
+
+/* Same as _spdk_blob_resolve_back_io_unit(), but looks up clusters the blob does
+ * not hold at all in the channel's location cache first.
+ */
+static uint64_t
+_spdk_blob_lookup_back_io_unit(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+			       uint64_t io_unit, struct spdk_bs_dev **dev, uint64_t *lba)
+{
+	struct spdk_blob_store		*bs = blob->bs;
+	struct spdk_bs_cluster_location	*location;
+	uint64_t			io_units_per_cluster;
+	uint64_t			cluster_num;
+	uint64_t			offset;
+	uint64_t			count;
+	bool				cacheable;
+
+	if (_spdk_bs_io_unit_is_allocated(blob, io_unit)) {
+		/* Only some sub-clusters are missing, don't bother caching */
+		return _spdk_blob_resolve_back_io_unit(blob, io_unit, dev, lba, &cacheable);
+	}
+
+	io_units_per_cluster = _spdk_bs_io_unit_per_page(bs) * bs->pages_per_cluster;
+	cluster_num = _spdk_bs_io_unit_to_cluster_number(blob, io_unit);
+	offset = io_unit % io_units_per_cluster;
+
+	location = &ch->location_cache[(blob->id ^ cluster_num) &
+						(SPDK_BS_CHANNEL_LOCATION_CACHE_SIZE - 1)];
+	if (location->blob != blob || location->cluster_num != cluster_num ||
+	    location->topology_gen != bs->topology_gen) {
+		count = _spdk_blob_resolve_back_io_unit(blob, io_unit - offset, dev, lba, &cacheable);
+		if (!cacheable || count < io_units_per_cluster) {
+			return _spdk_blob_resolve_back_io_unit(blob, io_unit, dev, lba, &cacheable);
+		}
+
+		location->blob = blob;
+		location->cluster_num = cluster_num;
+		location->topology_gen = bs->topology_gen;
+		location->dev = *dev;
+		location->lba = *lba;
+	}
+
+	*dev = location->dev;
+	*lba = location->lba + _spdk_bs_io_units_to_dev_lba(bs, location->dev, offset);
+	return io_units_per_cluster - offset;
+}
+
+struct spdk_blob_read_extent {
+	/* NULL for the blobstore device */
+	struct spdk_bs_dev	*dev;
+	uint64_t		lba;
+	uint64_t		io_units;
+};
+
+/* Find the longest run of io_units starting at offset that can be read with a
+ * single I/O, merging clusters that end up next to each other on the same device.
+ */
+static void
+_spdk_blob_next_read_extent(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+			    uint64_t offset, uint64_t length, struct spdk_blob_read_extent *extent)
+{
+	struct spdk_blob_store	*bs = blob->bs;
+	struct spdk_bs_dev	*dev;
+	uint64_t		lba;
+	uint64_t		count;
+
+	extent->dev = NULL;
+	extent->lba = 0;
+	extent->io_units = 0;
+
+	while (extent->io_units < length) {
+		if (_spdk_bs_io_unit_is_valid(blob, offset)) {
+			dev = NULL;
+			lba = _spdk_bs_blob_io_unit_to_lba(blob, offset);
+			count = _spdk_bs_num_io_units_to_valid_boundary(blob, offset);
+		} else {
+			count = _spdk_blob_lookup_back_io_unit(ch, blob, offset, &dev, &lba);
+		}
+		count = spdk_min(count, length - extent->io_units);
+
+		if (extent->io_units == 0) {
+			extent->dev = dev;
+			extent->lba = lba;
+		} else if (dev != extent->dev ||
+			   lba != extent->lba + _spdk_bs_io_units_to_dev_lba(bs, dev, extent->io_units) ||
+			   _spdk_bs_io_units_to_dev_lba(bs, dev, extent->io_units + count) > UINT32_MAX) {
+			break;
+		}
+
+		extent->io_units += count;
+		offset += count;
+	}
+}
+
 static void
 _spdk_blob_calculate_lba_and_lba_count(struct spdk_blob *blob, uint64_t io_unit, uint64_t length,
 				       uint64_t *lba,	uint32_t *lba_count)
 {
 	*lba_count = length;
 
-	if (!_spdk_bs_io_unit_is_allocated(blob, io_unit)) {
+	if (!_spdk_bs_io_unit_is_valid(blob, io_unit)) {
 		assert(blob->back_bs_dev != NULL);
 		*lba = _spdk_bs_io_unit_to_back_dev_lba(blob, io_unit);
 		*lba_count = _spdk_bs_io_unit_to_back_dev_lba(blob, *lba_count);
@@ -1774,7 +3444,7 @@ _spdk_blob_request_submit_op_split_next(void *cb_arg, int bserrno)
 		return;
 	}
 
-	op_length = spdk_min(length, _spdk_bs_num_io_units_to_cluster_boundary(blob,
+	op_length = spdk_min(length, _spdk_bs_num_io_units_to_valid_boundary(blob,
 			     offset));
 
 	/* Update length and payload for next operation */
@@ -1884,6 +3554,8 @@ _spdk_blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blo
 
 	switch (op_type) {
 	case SPDK_BLOB_READ: {
+		struct spdk_bs_channel *bs_channel = spdk_io_channel_get_ctx(_ch);
+		struct spdk_blob_read_extent extent;
 		spdk_bs_batch_t *batch;
 
 		batch = spdk_bs_batch_open(_ch, &cpl);
@@ -1892,12 +3564,22 @@ _spdk_blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blo
 			return;
 		}
 
-		if (_spdk_bs_io_unit_is_allocated(blob, offset)) {
-			/* Read from the blob */
-			spdk_bs_batch_read_dev(batch, payload, lba, lba_count);
-		} else {
-			/* Read from the backing block device */
-			spdk_bs_batch_read_bs_dev(batch, blob->back_bs_dev, payload, lba, lba_count);
+		/* Reads may span clusters, each run of them that is contiguous on the blobstore
+		 * device or on the device backing the oldest snapshot gets a single I/O.
+		 */
+		while (length > 0) {
+			_spdk_blob_next_read_extent(bs_channel, blob, offset, length, &extent);
+
+			lba_count = _spdk_bs_io_units_to_dev_lba(blob->bs, extent.dev, extent.io_units);
+			if (extent.dev == NULL) {
+				spdk_bs_batch_read_dev(batch, payload, extent.lba, lba_count);
+			} else {
+				spdk_bs_batch_read_bs_dev(batch, extent.dev, payload, extent.lba, lba_count);
+			}
+
+			payload += extent.io_units * blob->bs->io_unit_size;
+			offset += extent.io_units;
+			length -= extent.io_units;
 		}
 
 		spdk_bs_batch_close(batch);
@@ -1905,7 +3587,14 @@ _spdk_blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blo
 	}
 	case SPDK_BLOB_WRITE:
 	case SPDK_BLOB_WRITE_ZEROES: {
-		if (_spdk_bs_io_unit_is_allocated(blob, offset)) {
+		if (op_type == SPDK_BLOB_WRITE_ZEROES && !_spdk_blob_has_parent(blob) &&
+		    !_spdk_bs_io_unit_is_allocated(blob, offset)) {
+			/* Unallocated clusters without a parent read as zeroes already */
+			cb_fn(cb_arg, 0);
+			return;
+		}
+
+		if (!_spdk_blob_io_unit_needs_copy(blob, offset, length)) {
 			/* Write to the blob */
 			spdk_bs_batch_t *batch;
 
@@ -1950,7 +3639,7 @@ _spdk_blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blo
 			return;
 		}
 
-		if (_spdk_bs_io_unit_is_allocated(blob, offset)) {
+		if (_spdk_bs_io_unit_is_valid(blob, offset)) {
 			spdk_bs_batch_unmap_dev(batch, lba, lba_count);
 		}
 
@@ -1965,6 +3654,144 @@ _spdk_blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blo
 	}
 }
 
+struct spdk_blob_release_ctx {
+	struct spdk_blob	*blob;
+	struct spdk_io_channel	*channel;
+	struct spdk_thread	*thread;
+	enum spdk_blob_op_type	op_type;
+	/* Whole clusters covered by the unmap or write zeroes */
+	uint64_t		start_cluster;
+	uint64_t		end_cluster;
+	/* Parts of the request still in progress on the submitting thread */
+	uint32_t		outstanding;
+	int			rc;
+	/* Set on the metadata thread. -EBUSY if the clusters could not be
+	 * released and have to go through the device instead.
+	 */
+	int			md_rc;
+	uint32_t		*released;
+	uint64_t		num_released;
+	spdk_blob_op_complete	cb_fn;
+	void			*cb_arg;
+	TAILQ_ENTRY(spdk_blob_release_ctx) link;
+};
+
+/* Whether whole-cluster unmaps and write zeroes may release the clusters of
+ * blob, instead of only going to the device. Clusters a clone does not hold
+ * read from its parent, so this is limited to thin provisioned blobs without
+ * one. Checked again on the metadata thread before anything is released.
+ */
+static bool
+_spdk_blob_can_release_clusters(struct spdk_blob *blob)
+{
+	return spdk_blob_is_thin_provisioned(blob) && !_spdk_blob_has_parent(blob) &&
+	       blob->frozen_refcnt == 0 && !blob->locked_operation_in_progress;
+}
+
+static bool
+_spdk_blob_range_covers_cluster(struct spdk_blob *blob, uint64_t offset, uint64_t length)
+{
+	uint64_t io_units_per_cluster;
+
+	io_units_per_cluster = _spdk_bs_io_unit_per_page(blob->bs) * blob->bs->pages_per_cluster;
+
+	return (spdk_divide_round_up(offset, io_units_per_cluster) + 1) * io_units_per_cluster <=
+	       offset + length;
+}
+
+static void
+_spdk_blob_release_io_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_release_ctx *ctx = cb_arg;
+
+	if (bserrno != 0 && ctx->rc == 0) {
+		ctx->rc = bserrno;
+	}
+
+	assert(ctx->outstanding > 0);
+	if (--ctx->outstanding > 0) {
+		return;
+	}
+
+	ctx->cb_fn(ctx->cb_arg, ctx->rc);
+	free(ctx);
+}
+
+/* Back on the submitting thread, once the metadata thread is done with the clusters */
+static void
+_spdk_blob_release_clusters_cpl(void *arg)
+{
+	struct spdk_blob_release_ctx *ctx = arg;
+	struct spdk_blob_store *bs = ctx->blob->bs;
+	uint64_t io_units_per_cluster;
+	uint64_t offset, length;
+
+	if (ctx->md_rc != -EBUSY) {
+		_spdk_blob_release_io_cpl(ctx, ctx->md_rc);
+		return;
+	}
+
+	/* The blob changed in the meantime, so do what the request asked for on the device */
+	io_units_per_cluster = _spdk_bs_io_unit_per_page(bs) * bs->pages_per_cluster;
+	offset = ctx->start_cluster * io_units_per_cluster;
+	length = (ctx->end_cluster - ctx->start_cluster) * io_units_per_cluster;
+
+	if (ctx->op_type == SPDK_BLOB_UNMAP) {
+		spdk_blob_io_unmap(ctx->blob, ctx->channel, offset, length,
+				   _spdk_blob_release_io_cpl, ctx);
+	} else {
+		spdk_blob_io_write_zeroes(ctx->blob, ctx->channel, offset, length,
+					  _spdk_blob_release_io_cpl, ctx);
+	}
+}
+
+/* Unmap or write zeroes to a range covering at least one whole cluster of a
+ * thin provisioned blob. The whole clusters are released on the metadata
+ * thread, partial ones at either end of the range go to the device as usual.
+ */
+static void
+_spdk_blob_request_submit_release(struct spdk_io_channel *_ch, struct spdk_blob *blob,
+				  uint64_t offset, uint64_t length,
+				  spdk_blob_op_complete cb_fn, void *cb_arg, enum spdk_blob_op_type op_type)
+{
+	struct spdk_blob_release_ctx *ctx;
+	uint64_t io_units_per_cluster;
+	uint64_t head, tail;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	io_units_per_cluster = _spdk_bs_io_unit_per_page(blob->bs) * blob->bs->pages_per_cluster;
+
+	ctx->blob = blob;
+	ctx->channel = _ch;
+	ctx->thread = spdk_get_thread();
+	ctx->op_type = op_type;
+	ctx->start_cluster = spdk_divide_round_up(offset, io_units_per_cluster);
+	ctx->end_cluster = (offset + length) / io_units_per_cluster;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	head = ctx->start_cluster * io_units_per_cluster - offset;
+	tail = offset + length - ctx->end_cluster * io_units_per_cluster;
+
+	ctx->outstanding = 1 + (head > 0) + (tail > 0);
+
+	if (head > 0) {
+		_spdk_blob_request_submit_op_single(_ch, blob, NULL, offset, head,
+						    _spdk_blob_release_io_cpl, ctx, op_type);
+	}
+	if (tail > 0) {
+		_spdk_blob_request_submit_op_single(_ch, blob, NULL, offset + length - tail, tail,
+						    _spdk_blob_release_io_cpl, ctx, op_type);
+	}
+
+	spdk_thread_send_msg(blob->bs->md_thread, _spdk_blob_release_clusters_msg, ctx);
+}
+
 static void
 _spdk_blob_request_submit_op(struct spdk_blob *blob, struct spdk_io_channel *_channel,
 			     void *payload, uint64_t offset, uint64_t length,
@@ -1981,7 +3808,16 @@ _spdk_blob_request_submit_op(struct spdk_blob *blob, struct spdk_io_channel *_ch
 		cb_fn(cb_arg, -EINVAL);
 		return;
 	}
-	if (length <= _spdk_bs_num_io_units_to_cluster_boundary(blob, offset)) {
+
+	if ((op_type == SPDK_BLOB_UNMAP || op_type == SPDK_BLOB_WRITE_ZEROES) &&
+	    _spdk_blob_can_release_clusters(blob) &&
+	    _spdk_blob_range_covers_cluster(blob, offset, length)) {
+		_spdk_blob_request_submit_release(_channel, blob, offset, length,
+						  cb_fn, cb_arg, op_type);
+		return;
+	}
+	if (op_type == SPDK_BLOB_READ ||
+	    length <= _spdk_bs_num_io_units_to_valid_boundary(blob, offset)) {
 		_spdk_blob_request_submit_op_single(_channel, blob, payload, offset, length,
 						    cb_fn, cb_arg, op_type);
 	} else {
@@ -1995,7 +3831,6 @@ struct rw_iov_ctx {
 	struct spdk_io_channel *channel;
 	spdk_blob_op_complete cb_fn;
 	void *cb_arg;
-	bool read;
 	int iovcnt;
 	struct iovec *orig_iov;
 	uint64_t io_unit_offset;
@@ -2029,7 +3864,7 @@ _spdk_rw_iov_split_next(void *cb_arg, int bserrno)
 	}
 
 	io_unit_offset = ctx->io_unit_offset;
-	io_units_to_boundary = _spdk_bs_num_io_units_to_cluster_boundary(blob, io_unit_offset);
+	io_units_to_boundary = _spdk_bs_num_io_units_to_valid_boundary(blob, io_unit_offset);
 	io_units_count = spdk_min(ctx->io_units_remaining, io_units_to_boundary);
 	/*
 	 * Get index and offset into the original iov array for our current position in the I/O sequence.
@@ -2072,13 +3907,150 @@ _spdk_rw_iov_split_next(void *cb_arg, int bserrno)
 	ctx->io_units_done += io_units_count;
 	iov = &ctx->iov[0];
 
-	if (ctx->read) {
-		spdk_blob_io_readv(ctx->blob, ctx->channel, iov, iovcnt, io_unit_offset,
-				   io_units_count, _spdk_rw_iov_split_next, ctx);
-	} else {
-		spdk_blob_io_writev(ctx->blob, ctx->channel, iov, iovcnt, io_unit_offset,
-				    io_units_count, _spdk_rw_iov_split_next, ctx);
+	spdk_blob_io_writev(ctx->blob, ctx->channel, iov, iovcnt, io_unit_offset,
+			    io_units_count, _spdk_rw_iov_split_next, ctx);
+}
+
+struct readv_ctx {
+	spdk_blob_op_complete cb_fn;
+	void *cb_arg;
+	struct iovec iov[0];
+};
+
+static void
+_spdk_blob_readv_done(void *cb_arg, int bserrno)
+{
+	struct readv_ctx *ctx = cb_arg;
+
+	ctx->cb_fn(ctx->cb_arg, bserrno);
+	free(ctx);
+}
+
+static void
+_spdk_blob_request_submit_readv(struct spdk_blob *blob, struct spdk_io_channel *_channel,
+				struct iovec *iov, int iovcnt, uint64_t offset, uint64_t length,
+				spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_bs_channel		*bs_channel = spdk_io_channel_get_ctx(_channel);
+	struct spdk_blob_read_extent	extent;
+	struct readv_ctx		*ctx = NULL;
+	struct spdk_bs_cpl		cpl;
+	spdk_bs_batch_t			*batch;
+	struct iovec			*extent_iov;
+	uint64_t			io_unit, remaining;
+	uint64_t			byte_count;
+	size_t				orig_iovoff;
+	int				num_extents, extent_iovcnt;
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = cb_fn;
+	cpl.u.blob_basic.cb_arg = cb_arg;
+
+	if (blob->frozen_refcnt) {
+		/* This blob I/O is frozen */
+		spdk_bs_user_op_t *op;
+
+		op = spdk_bs_user_op_alloc(_channel, &cpl, SPDK_BLOB_READV, blob, iov, iovcnt,
+					   offset, length);
+		if (!op) {
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+
+		TAILQ_INSERT_TAIL(&bs_channel->queued_io, op, link);
+
+		return;
+	}
+
+	_spdk_blob_next_read_extent(bs_channel, blob, offset, length, &extent);
+	if (spdk_likely(extent.io_units == length)) {
+		batch = spdk_bs_batch_open(_channel, &cpl);
+		if (!batch) {
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+
+		if (extent.dev == NULL) {
+			spdk_bs_batch_readv_dev(batch, iov, iovcnt, extent.lba,
+						_spdk_bs_io_units_to_dev_lba(blob->bs, NULL, length));
+		} else {
+			spdk_bs_batch_readv_bs_dev(batch, extent.dev, iov, iovcnt, extent.lba,
+						   _spdk_bs_io_units_to_dev_lba(blob->bs, extent.dev, length));
+		}
+
+		spdk_bs_batch_close(batch);
+		return;
+	}
+
+	/*
+	 * The I/O spans several extents that are not contiguous on the same device. Every extent
+	 *  boundary splits at most one of the iovs in two, so count the extents first to size
+	 *  a single iov array for all of them, then issue them in a batch.
+	 */
+	num_extents = 1;
+	io_unit = offset + extent.io_units;
+	while (io_unit < offset + length) {
+		_spdk_blob_next_read_extent(bs_channel, blob, io_unit, offset + length - io_unit, &extent);
+		io_unit += extent.io_units;
+		num_extents++;
+	}
+
+	ctx = calloc(1, sizeof(*ctx) + (iovcnt + num_extents) * sizeof(struct iovec));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	cpl.u.blob_basic.cb_fn = _spdk_blob_readv_done;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	batch = spdk_bs_batch_open(_channel, &cpl);
+	if (!batch) {
+		free(ctx);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	extent_iov = &ctx->iov[0];
+	orig_iovoff = 0;
+	io_unit = offset;
+	remaining = length;
+	while (remaining > 0) {
+		_spdk_blob_next_read_extent(bs_channel, blob, io_unit, remaining, &extent);
+
+		/* Build the iovs for this extent out of the original iov array */
+		byte_count = extent.io_units * blob->bs->io_unit_size;
+		extent_iovcnt = 0;
+		while (byte_count > 0) {
+			extent_iov[extent_iovcnt].iov_len = spdk_min(byte_count, iov->iov_len - orig_iovoff);
+			extent_iov[extent_iovcnt].iov_base = iov->iov_base + orig_iovoff;
+			byte_count -= extent_iov[extent_iovcnt].iov_len;
+			orig_iovoff += extent_iov[extent_iovcnt].iov_len;
+			if (orig_iovoff == iov->iov_len) {
+				orig_iovoff = 0;
+				iov++;
+			}
+			extent_iovcnt++;
+		}
+		assert(extent_iov + extent_iovcnt <= &ctx->iov[iovcnt + num_extents]);
+
+		if (extent.dev == NULL) {
+			spdk_bs_batch_readv_dev(batch, extent_iov, extent_iovcnt, extent.lba,
+						_spdk_bs_io_units_to_dev_lba(blob->bs, NULL, extent.io_units));
+		} else {
+			spdk_bs_batch_readv_bs_dev(batch, extent.dev, extent_iov, extent_iovcnt, extent.lba,
+						   _spdk_bs_io_units_to_dev_lba(blob->bs, extent.dev,
+								   extent.io_units));
+		}
+
+		extent_iov += extent_iovcnt;
+		io_unit += extent.io_units;
+		remaining -= extent.io_units;
 	}
+
+	spdk_bs_batch_close(batch);
 }
 
 static void
@@ -2105,8 +4077,13 @@ _spdk_blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel
 		return;
 	}
 
+	if (read) {
+		_spdk_blob_request_submit_readv(blob, _channel, iov, iovcnt, offset, length, cb_fn, cb_arg);
+		return;
+	}
+
 	/*
-	 * For now, we implement readv/writev using a sequence (instead of a batch) to account for having
+	 * For now, we implement writev using a sequence (instead of a batch) to account for having
 	 *  to split a request that spans a cluster boundary.  For I/O that do not span a cluster boundary,
 	 *  there will be no noticeable difference compared to using a batch.  For I/O that do span a cluster
 	 *  boundary, the target LBAs (after blob offset to LBA translation) may not be contiguous, so we need
@@ -2114,12 +4091,9 @@ _spdk_blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel
 	 *  smaller I/O cross a cluster boundary.  These smaller I/O will be issued in sequence (not in parallel)
 	 *  but since this case happens very infrequently, any performance impact will be negligible.
 	 *
-	 * This could be optimized in the future to allocate a big enough iov array to account for all of the iovs
-	 *  for all of the smaller I/Os, pre-build all of the iov arrays for the smaller I/Os, then issue them
-	 *  in a batch.  That would also require creating an intermediate spdk_bs_cpl that would get called
-	 *  when the batch was completed, to allow for freeing the memory for the iov arrays.
+	 * Reads are issued in a batch instead, see _spdk_blob_request_submit_readv().
 	 */
-	if (spdk_likely(length <= _spdk_bs_num_io_units_to_cluster_boundary(blob, offset))) {
+	if (spdk_likely(length <= _spdk_bs_num_io_units_to_valid_boundary(blob, offset))) {
 		uint32_t lba_count;
 		uint64_t lba;
 
@@ -2129,12 +4103,11 @@ _spdk_blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel
 
 		if (blob->frozen_refcnt) {
 			/* This blob I/O is frozen */
-			enum spdk_blob_op_type op_type;
 			spdk_bs_user_op_t *op;
 			struct spdk_bs_channel *bs_channel = spdk_io_channel_get_ctx(_channel);
 
-			op_type = read ? SPDK_BLOB_READV : SPDK_BLOB_WRITEV;
-			op = spdk_bs_user_op_alloc(_channel, &cpl, op_type, blob, iov, iovcnt, offset, length);
+			op = spdk_bs_user_op_alloc(_channel, &cpl, SPDK_BLOB_WRITEV, blob, iov, iovcnt,
+						   offset, length);
 			if (!op) {
 				cb_fn(cb_arg, -ENOMEM);
 				return;
@@ -2147,7 +4120,7 @@ _spdk_blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel
 
 		_spdk_blob_calculate_lba_and_lba_count(blob, offset, length, &lba, &lba_count);
 
-		if (read) {
+		if (!_spdk_blob_io_unit_needs_copy(blob, offset, length)) {
 			spdk_bs_sequence_t *seq;
 
 			seq = spdk_bs_sequence_start(_channel, &cpl);
@@ -2156,36 +4129,19 @@ _spdk_blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel
 				return;
 			}
 
-			if (_spdk_bs_io_unit_is_allocated(blob, offset)) {
-				spdk_bs_sequence_readv_dev(seq, iov, iovcnt, lba, lba_count, _spdk_rw_iov_done, NULL);
-			} else {
-				spdk_bs_sequence_readv_bs_dev(seq, blob->back_bs_dev, iov, iovcnt, lba, lba_count,
-							      _spdk_rw_iov_done, NULL);
-			}
+			spdk_bs_sequence_writev_dev(seq, iov, iovcnt, lba, lba_count, _spdk_rw_iov_done, NULL);
 		} else {
-			if (_spdk_bs_io_unit_is_allocated(blob, offset)) {
-				spdk_bs_sequence_t *seq;
-
-				seq = spdk_bs_sequence_start(_channel, &cpl);
-				if (!seq) {
-					cb_fn(cb_arg, -ENOMEM);
-					return;
-				}
-
-				spdk_bs_sequence_writev_dev(seq, iov, iovcnt, lba, lba_count, _spdk_rw_iov_done, NULL);
-			} else {
-				/* Queue this operation and allocate the cluster */
-				spdk_bs_user_op_t *op;
-
-				op = spdk_bs_user_op_alloc(_channel, &cpl, SPDK_BLOB_WRITEV, blob, iov, iovcnt, offset,
-							   length);
-				if (!op) {
-					cb_fn(cb_arg, -ENOMEM);
-					return;
-				}
+			/* Queue this operation and allocate the cluster */
+			spdk_bs_user_op_t *op;
 
-				_spdk_bs_allocate_and_copy_cluster(blob, _channel, offset, op);
+			op = spdk_bs_user_op_alloc(_channel, &cpl, SPDK_BLOB_WRITEV, blob, iov, iovcnt, offset,
+						   length);
+			if (!op) {
+				cb_fn(cb_arg, -ENOMEM);
+				return;
 			}
+
+			_spdk_bs_allocate_and_copy_cluster(blob, _channel, offset, op);
 		}
 	} else {
 		struct rw_iov_ctx *ctx;
@@ -2200,7 +4156,6 @@ _spdk_blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel
 		ctx->channel = _channel;
 		ctx->cb_fn = cb_fn;
 		ctx->cb_arg = cb_arg;
-		ctx->read = read;
 		ctx->orig_iov = iov;
 		ctx->iovcnt = iovcnt;
 		ctx->io_unit_offset = offset;
@@ -2214,15 +4169,35 @@ _spdk_blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel
 static struct spdk_blob *
 _spdk_blob_lookup(struct spdk_blob_store *bs, spdk_blob_id blobid)
 {
-	struct spdk_blob *blob;
+	struct spdk_blob_hash_entry *entry;
 
-	TAILQ_FOREACH(blob, &bs->blobs, link) {
-		if (blob->id == blobid) {
-			return blob;
-		}
+	entry = _spdk_blob_hash_find(&bs->open_blobs, blobid);
+	if (entry == NULL) {
+		return NULL;
 	}
 
-	return NULL;
+	return SPDK_CONTAINEROF(entry, struct spdk_blob, hash_entry);
+}
+
+static void
+_spdk_bs_add_open_blob(struct spdk_blob_store *bs, struct spdk_blob *blob)
+{
+	assert(_spdk_blob_lookup(bs, blob->id) == NULL);
+
+	TAILQ_INSERT_HEAD(&bs->blobs, blob, link);
+	_spdk_blob_hash_insert(&bs->open_blobs, &blob->hash_entry, blob->id);
+}
+
+static void
+_spdk_bs_remove_open_blob(struct spdk_blob_store *bs, struct spdk_blob *blob)
+{
+	if (!_spdk_blob_hash_entry_is_linked(&blob->hash_entry)) {
+		/* Already taken off the list by a delete that has failed since */
+		return;
+	}
+
+	TAILQ_REMOVE(&bs->blobs, blob, link);
+	_spdk_blob_hash_remove(&bs->open_blobs, &blob->hash_entry);
 }
 
 static void
@@ -2237,20 +4212,12 @@ _spdk_blob_get_snapshot_and_clone_entries(struct spdk_blob *blob,
 		return;
 	}
 
-	TAILQ_FOREACH(*snapshot_entry, &blob->bs->snapshots, link) {
-		if ((*snapshot_entry)->id == blob->parent_id) {
-			break;
-		}
-	}
-
+	*snapshot_entry = _spdk_bs_get_snapshot_entry(blob->bs, blob->parent_id);
 	if (*snapshot_entry != NULL) {
-		TAILQ_FOREACH(*clone_entry, &(*snapshot_entry)->clones, link) {
-			if ((*clone_entry)->id == blob->id) {
-				break;
-			}
-		}
+		*clone_entry = _spdk_bs_get_clone_entry(blob->bs, blob->id);
 
-		assert(clone_entry != NULL);
+		assert(*clone_entry != NULL);
+		assert((*clone_entry)->parent == *snapshot_entry);
 	}
 }
 
@@ -2280,38 +4247,158 @@ _spdk_bs_channel_create(void *io_device, void *ctx_buf)
 	channel->dev = dev;
 	channel->dev_channel = dev->create_channel(dev);
 
-	if (!channel->dev_channel) {
-		SPDK_ERRLOG("Failed to create device channel.\n");
-		free(channel->req_mem);
-		return -1;
+	if (!channel->dev_channel) {
+		SPDK_ERRLOG("Failed to create device channel.\n");
+		free(channel->req_mem);
+		return -1;
+	}
+
+	TAILQ_INIT(&channel->pending_allocs);
+	TAILQ_INIT(&channel->pending_inserts);
+	TAILQ_INIT(&channel->inflight_inserts);
+	TAILQ_INIT(&channel->queued_io);
+	TAILQ_INIT(&channel->back_channels);
+
+	return 0;
+}
+
+static void
+_spdk_bs_put_back_channel(struct spdk_bs_channel *channel, struct spdk_bs_back_channel *back_ch)
+{
+	TAILQ_REMOVE(&channel->back_channels, back_ch, link);
+	back_ch->dev->destroy_channel(back_ch->dev, back_ch->channel);
+	free(back_ch);
+}
+
+static void
+_spdk_bs_channel_destroy(void *io_device, void *ctx_buf)
+{
+	struct spdk_bs_channel *channel = ctx_buf;
+	struct spdk_blob_copy_cluster_ctx *alloc_ctx;
+	spdk_bs_user_op_t *op;
+
+	TAILQ_FOREACH(alloc_ctx, &channel->pending_allocs, link) {
+		while (!TAILQ_EMPTY(&alloc_ctx->requests)) {
+			op = TAILQ_FIRST(&alloc_ctx->requests);
+			TAILQ_REMOVE(&alloc_ctx->requests, op, link);
+			spdk_bs_user_op_abort(op);
+		}
+	}
+
+	_spdk_bs_channel_release_clusters(channel);
+
+	while (!TAILQ_EMPTY(&channel->queued_io)) {
+		op = TAILQ_FIRST(&channel->queued_io);
+		TAILQ_REMOVE(&channel->queued_io, op, link);
+		spdk_bs_user_op_abort(op);
+	}
+
+	while (!TAILQ_EMPTY(&channel->back_channels)) {
+		_spdk_bs_put_back_channel(channel, TAILQ_FIRST(&channel->back_channels));
+	}
+
+	free(channel->req_mem);
+	channel->dev->destroy_channel(channel->dev, channel->dev_channel);
+}
+
+static inline bool
+_spdk_bs_dev_uses_channels(struct spdk_bs_dev *dev)
+{
+	/* Zeroes and snapshot devices are accessed through the blobstore channel */
+	return dev != NULL && dev->create_channel != NULL;
+}
+
+struct spdk_io_channel *
+spdk_bs_channel_get_back_channel(struct spdk_bs_channel *channel, struct spdk_bs_dev *back_bs_dev)
+{
+	struct spdk_bs_back_channel *back_ch;
+
+	if (!_spdk_bs_dev_uses_channels(back_bs_dev)) {
+		return spdk_io_channel_from_ctx(channel);
+	}
+
+	TAILQ_FOREACH(back_ch, &channel->back_channels, link) {
+		if (back_ch->dev == back_bs_dev) {
+			return back_ch->channel;
+		}
+	}
+
+	back_ch = calloc(1, sizeof(*back_ch));
+	if (back_ch == NULL) {
+		return NULL;
+	}
+
+	back_ch->channel = back_bs_dev->create_channel(back_bs_dev);
+	if (back_ch->channel == NULL) {
+		SPDK_ERRLOG("Failed to create external snapshot device channel.\n");
+		free(back_ch);
+		return NULL;
+	}
+
+	back_ch->dev = back_bs_dev;
+	TAILQ_INSERT_HEAD(&channel->back_channels, back_ch, link);
+
+	return back_ch->channel;
+}
+
+struct spdk_bs_put_back_channels_ctx {
+	struct spdk_bs_dev	*dev;
+	spdk_blob_op_complete	cb_fn;
+	void			*cb_arg;
+};
+
+static void
+_spdk_bs_put_back_channels_cpl(struct spdk_io_channel_iter *i, int status)
+{
+	struct spdk_bs_put_back_channels_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	ctx->cb_fn(ctx->cb_arg, status);
+	free(ctx);
+}
+
+static void
+_spdk_bs_put_back_channels_msg(struct spdk_io_channel_iter *i)
+{
+	struct spdk_bs_put_back_channels_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_bs_channel *channel = spdk_io_channel_get_ctx(_ch);
+	struct spdk_bs_back_channel *back_ch;
+
+	TAILQ_FOREACH(back_ch, &channel->back_channels, link) {
+		if (back_ch->dev == ctx->dev) {
+			_spdk_bs_put_back_channel(channel, back_ch);
+			break;
+		}
 	}
 
-	TAILQ_INIT(&channel->need_cluster_alloc);
-	TAILQ_INIT(&channel->queued_io);
-
-	return 0;
+	spdk_for_each_channel_continue(i, 0);
 }
 
+/* Put the channels all threads hold on the backing device of a blob, so that
+ * the device can be destroyed. No I/O to the blob may be outstanding.
+ */
 static void
-_spdk_bs_channel_destroy(void *io_device, void *ctx_buf)
+_spdk_blob_put_back_channels(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
-	struct spdk_bs_channel *channel = ctx_buf;
-	spdk_bs_user_op_t *op;
+	struct spdk_bs_put_back_channels_ctx *ctx;
 
-	while (!TAILQ_EMPTY(&channel->need_cluster_alloc)) {
-		op = TAILQ_FIRST(&channel->need_cluster_alloc);
-		TAILQ_REMOVE(&channel->need_cluster_alloc, op, link);
-		spdk_bs_user_op_abort(op);
+	if (!_spdk_bs_dev_uses_channels(blob->back_bs_dev)) {
+		cb_fn(cb_arg, 0);
+		return;
 	}
 
-	while (!TAILQ_EMPTY(&channel->queued_io)) {
-		op = TAILQ_FIRST(&channel->queued_io);
-		TAILQ_REMOVE(&channel->queued_io, op, link);
-		spdk_bs_user_op_abort(op);
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
 	}
 
-	free(channel->req_mem);
-	channel->dev->destroy_channel(channel->dev, channel->dev_channel);
+	ctx->dev = blob->back_bs_dev;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_for_each_channel(blob->bs, _spdk_bs_put_back_channels_msg, ctx,
+			      _spdk_bs_put_back_channels_cpl);
 }
 
 static void
@@ -2323,10 +4410,14 @@ _spdk_bs_dev_destroy(void *io_device)
 	bs->dev->destroy(bs->dev);
 
 	TAILQ_FOREACH_SAFE(blob, &bs->blobs, link, blob_tmp) {
-		TAILQ_REMOVE(&bs->blobs, blob, link);
+		_spdk_bs_remove_open_blob(bs, blob);
 		_spdk_blob_free(blob);
 	}
 
+	_spdk_blob_hash_free(&bs->open_blobs);
+	_spdk_blob_hash_free(&bs->snapshot_hash);
+	_spdk_blob_hash_free(&bs->clone_hash);
+
 	pthread_mutex_destroy(&bs->used_clusters_mutex);
 
 	spdk_bit_array_free(&bs->used_blobids);
@@ -2365,12 +4456,10 @@ _spdk_bs_blob_list_add(struct spdk_blob *blob)
 		snapshot_entry->id = snapshot_id;
 		TAILQ_INIT(&snapshot_entry->clones);
 		TAILQ_INSERT_TAIL(&blob->bs->snapshots, snapshot_entry, link);
+		_spdk_blob_hash_insert(&blob->bs->snapshot_hash, &snapshot_entry->hash_entry, snapshot_id);
 	} else {
-		TAILQ_FOREACH(clone_entry, &snapshot_entry->clones, link) {
-			if (clone_entry->id == blob->id) {
-				break;
-			}
-		}
+		clone_entry = _spdk_bs_get_clone_entry(blob->bs, blob->id);
+		assert(clone_entry == NULL || clone_entry->parent == snapshot_entry);
 	}
 
 	if (clone_entry == NULL) {
@@ -2381,8 +4470,8 @@ _spdk_bs_blob_list_add(struct spdk_blob *blob)
 		}
 		clone_entry->id = blob->id;
 		TAILQ_INIT(&clone_entry->clones);
-		TAILQ_INSERT_TAIL(&snapshot_entry->clones, clone_entry, link);
-		snapshot_entry->clone_count++;
+		_spdk_blob_hash_insert(&blob->bs->clone_hash, &clone_entry->hash_entry, blob->id);
+		_spdk_bs_add_clone_entry(snapshot_entry, clone_entry);
 	}
 
 	return 0;
@@ -2401,10 +4490,7 @@ _spdk_bs_blob_list_remove(struct spdk_blob *blob)
 	}
 
 	blob->parent_id = SPDK_BLOBID_INVALID;
-	TAILQ_REMOVE(&snapshot_entry->clones, clone_entry, link);
-	free(clone_entry);
-
-	snapshot_entry->clone_count--;
+	_spdk_bs_remove_clone_entry(blob->bs, clone_entry);
 }
 
 static int
@@ -2417,11 +4503,9 @@ _spdk_bs_blob_list_free(struct spdk_blob_store *bs)
 
 	TAILQ_FOREACH_SAFE(snapshot_entry, &bs->snapshots, link, snapshot_entry_tmp) {
 		TAILQ_FOREACH_SAFE(clone_entry, &snapshot_entry->clones, link, clone_entry_tmp) {
-			TAILQ_REMOVE(&snapshot_entry->clones, clone_entry, link);
-			free(clone_entry);
+			_spdk_bs_remove_clone_entry(bs, clone_entry);
 		}
-		TAILQ_REMOVE(&bs->snapshots, snapshot_entry, link);
-		free(snapshot_entry);
+		_spdk_bs_remove_snapshot_entry(bs, snapshot_entry);
 	}
 
 	return 0;
@@ -2430,6 +4514,9 @@ _spdk_bs_blob_list_free(struct spdk_blob_store *bs)
 static void
 _spdk_bs_free(struct spdk_blob_store *bs)
 {
+	assert(TAILQ_EMPTY(&bs->md_commits));
+	spdk_poller_unregister(&bs->md_commit_poller);
+
 	_spdk_bs_blob_list_free(bs);
 
 	spdk_bs_unregister_md_thread(bs);
@@ -2447,6 +4534,9 @@ spdk_bs_opts_init(struct spdk_bs_opts *opts)
 	memset(&opts->bstype, 0, sizeof(opts->bstype));
 	opts->iter_cb_fn = NULL;
 	opts->iter_cb_arg = NULL;
+	opts->esnap_bs_dev_create = NULL;
+	opts->esnap_ctx = NULL;
+	opts->md_commit_window_us = 0;
 }
 
 static int
@@ -2461,6 +4551,18 @@ _spdk_bs_opts_verify(struct spdk_bs_opts *opts)
 	return 0;
 }
 
+/* Split clusters into at most SPDK_BLOB_MAX_SUBCLUSTERS equally sized parts,
+ * except for the last one, for sub-cluster copy-on-write.
+ */
+static void
+_spdk_bs_init_subcluster_geometry(struct spdk_blob_store *bs)
+{
+	bs->pages_per_subcluster = spdk_divide_round_up(bs->pages_per_cluster,
+				   SPDK_BLOB_MAX_SUBCLUSTERS);
+	bs->subclusters_per_cluster = spdk_divide_round_up(bs->pages_per_cluster,
+				      bs->pages_per_subcluster);
+}
+
 static int
 _spdk_bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_store **_bs)
 {
@@ -2488,6 +4590,15 @@ _spdk_bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_b
 
 	TAILQ_INIT(&bs->blobs);
 	TAILQ_INIT(&bs->snapshots);
+	if (_spdk_blob_hash_init(&bs->open_blobs) != 0 ||
+	    _spdk_blob_hash_init(&bs->snapshot_hash) != 0 ||
+	    _spdk_blob_hash_init(&bs->clone_hash) != 0) {
+		_spdk_blob_hash_free(&bs->open_blobs);
+		_spdk_blob_hash_free(&bs->snapshot_hash);
+		_spdk_blob_hash_free(&bs->clone_hash);
+		free(bs);
+		return -ENOMEM;
+	}
 	bs->dev = dev;
 	bs->md_thread = spdk_get_thread();
 	assert(bs->md_thread != NULL);
@@ -2499,15 +4610,24 @@ _spdk_bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_b
 	bs->cluster_sz = opts->cluster_sz;
 	bs->total_clusters = dev->blockcnt / (bs->cluster_sz / dev->blocklen);
 	bs->pages_per_cluster = bs->cluster_sz / SPDK_BS_PAGE_SIZE;
+	_spdk_bs_init_subcluster_geometry(bs);
 	bs->num_free_clusters = bs->total_clusters;
 	bs->used_clusters = spdk_bit_array_create(bs->total_clusters);
 	bs->io_unit_size = dev->blocklen;
 	if (bs->used_clusters == NULL) {
+		_spdk_blob_hash_free(&bs->open_blobs);
+		_spdk_blob_hash_free(&bs->snapshot_hash);
+		_spdk_blob_hash_free(&bs->clone_hash);
 		free(bs);
 		return -ENOMEM;
 	}
 
 	bs->max_channel_ops = opts->max_channel_ops;
+	bs->esnap_bs_dev_create = opts->esnap_bs_dev_create;
+	bs->esnap_ctx = opts->esnap_ctx;
+	bs->md_commit_window_us = opts->md_commit_window_us;
+	TAILQ_INIT(&bs->md_commits);
+	bs->topology_gen = 1;
 	bs->super_blob = SPDK_BLOBID_INVALID;
 	memcpy(&bs->bstype, &opts->bstype, sizeof(opts->bstype));
 
@@ -2526,6 +4646,9 @@ _spdk_bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_b
 		spdk_bit_array_free(&bs->used_blobids);
 		spdk_bit_array_free(&bs->used_md_pages);
 		spdk_bit_array_free(&bs->used_clusters);
+		_spdk_blob_hash_free(&bs->open_blobs);
+		_spdk_blob_hash_free(&bs->snapshot_hash);
+		_spdk_blob_hash_free(&bs->clone_hash);
 		free(bs);
 		/* FIXME: this is a lie but don't know how to get a proper error code here */
 		return -ENOMEM;
@@ -2537,21 +4660,52 @@ _spdk_bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_b
 
 /* START spdk_bs_load, spdk_bs_load_ctx will used for both load and unload. */
 
+/* After a dirty shutdown the whole metadata region is scanned for blobs. It is
+ * read in windows of SPDK_BS_LOAD_REPLAY_WINDOW_PAGES pages, each split into
+ * SPDK_BS_LOAD_REPLAY_READ_PAGES sized reads that are all issued at once.
+ * The chain and extent pages found along the way are then read in batches of
+ * up to SPDK_BS_LOAD_REPLAY_FOLLOW_DEPTH single page reads.
+ */
+#define SPDK_BS_LOAD_REPLAY_WINDOW_PAGES	512
+#define SPDK_BS_LOAD_REPLAY_READ_PAGES		64
+#define SPDK_BS_LOAD_REPLAY_FOLLOW_DEPTH	64
+
+/* Number of blobs examined at the same time once the metadata is loaded */
+#define SPDK_BS_LOAD_EXAMINE_QUEUE_DEPTH	64
+
 struct spdk_bs_load_ctx {
 	struct spdk_blob_store		*bs;
 	struct spdk_bs_super_block	*super;
 
 	struct spdk_bs_md_mask		*mask;
-	bool				in_page_chain;
 	uint32_t			page_index;
 	uint32_t			cur_page;
 	struct spdk_blob_md_page	*page;
 
+	/* Extent pages, and pages continuing a metadata page chain, that
+	 * still have to be read while replaying the metadata
+	 */
+	uint32_t			*extent_page_num;
+	uint64_t			num_extent_pages;
+	uint32_t			*chain_page_num;
+	uint64_t			num_chain_pages;
+
+	/* Metadata pages read by the current replay batch */
+	struct spdk_blob_md_page	*replay_pages;
+	uint32_t			replay_page_num[SPDK_BS_LOAD_REPLAY_FOLLOW_DEPTH];
+	bool				replay_page_is_extent[SPDK_BS_LOAD_REPLAY_FOLLOW_DEPTH];
+	uint32_t			replay_count;
+
 	spdk_bs_sequence_t			*seq;
 	spdk_blob_op_with_handle_complete	iter_cb_fn;
 	void					*iter_cb_arg;
 	struct spdk_blob			*blob;
 	spdk_blob_id				blobid;
+
+	/* Snapshots left behind by an interrupted snapshot operation */
+	spdk_blob_id				*repair_blobids;
+	uint64_t				num_repair_blobids;
+	uint64_t				repair_idx;
 };
 
 static void
@@ -2560,6 +4714,9 @@ _spdk_bs_load_ctx_fail(spdk_bs_sequence_t *seq, struct spdk_bs_load_ctx *ctx, in
 	assert(bserrno != 0);
 
 	spdk_free(ctx->super);
+	spdk_free(ctx->replay_pages);
+	free(ctx->extent_page_num);
+	free(ctx->chain_page_num);
 	spdk_bs_sequence_finish(seq, bserrno);
 	_spdk_bs_free(ctx->bs);
 	free(ctx);
@@ -2708,28 +4865,22 @@ _spdk_blob_set_thin_provision(struct spdk_blob *blob)
 	blob->state = SPDK_BLOB_STATE_DIRTY;
 }
 
-static void _spdk_bs_load_iter(void *arg, struct spdk_blob *blob, int bserrno);
+static void _spdk_bs_load_repair_next(struct spdk_bs_load_ctx *ctx);
 
 static void
-_spdk_bs_delete_corrupted_blob_cpl(void *cb_arg, int bserrno)
+_spdk_bs_load_repair_close_cpl(void *cb_arg, int bserrno)
 {
 	struct spdk_bs_load_ctx *ctx = cb_arg;
-	spdk_blob_id id;
-	int64_t page_num;
 
-	/* Iterate to next blob (we can't use spdk_bs_iter_next function as our
-	 * last blob has been removed */
-	page_num = _spdk_bs_blobid_to_page(ctx->blobid);
-	page_num++;
-	page_num = spdk_bit_array_find_first_set(ctx->bs->used_blobids, page_num);
-	if (page_num >= spdk_bit_array_capacity(ctx->bs->used_blobids)) {
-		_spdk_bs_load_iter(ctx, NULL, -ENOENT);
-		return;
-	}
+	_spdk_bs_load_repair_next(ctx);
+}
 
-	id = _spdk_bs_page_to_blobid(page_num);
+static void
+_spdk_bs_delete_corrupted_blob_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
 
-	spdk_bs_open_blob(ctx->bs, id, _spdk_bs_load_iter, ctx);
+	_spdk_bs_load_repair_next(ctx);
 }
 
 static void
@@ -2739,7 +4890,7 @@ _spdk_bs_delete_corrupted_close_cb(void *cb_arg, int bserrno)
 
 	if (bserrno != 0) {
 		SPDK_ERRLOG("Failed to close corrupted blob\n");
-		spdk_bs_iter_next(ctx->bs, ctx->blob, _spdk_bs_load_iter, ctx);
+		_spdk_bs_load_repair_next(ctx);
 		return;
 	}
 
@@ -2754,7 +4905,7 @@ _spdk_bs_delete_corrupted_blob(void *cb_arg, int bserrno)
 
 	if (bserrno != 0) {
 		SPDK_ERRLOG("Failed to close clone of a corrupted blob\n");
-		spdk_bs_iter_next(ctx->bs, ctx->blob, _spdk_bs_load_iter, ctx);
+		spdk_blob_close(ctx->blob, _spdk_bs_load_repair_close_cpl, ctx);
 		return;
 	}
 
@@ -2782,7 +4933,7 @@ _spdk_bs_update_corrupted_blob(void *cb_arg, int bserrno)
 
 	if (bserrno != 0) {
 		SPDK_ERRLOG("Failed to close clone of a corrupted blob\n");
-		spdk_bs_iter_next(ctx->bs, ctx->blob, _spdk_bs_load_iter, ctx);
+		spdk_blob_close(ctx->blob, _spdk_bs_load_repair_close_cpl, ctx);
 		return;
 	}
 
@@ -2796,7 +4947,7 @@ _spdk_bs_update_corrupted_blob(void *cb_arg, int bserrno)
 	}
 	_spdk_bs_blob_list_add(ctx->blob);
 
-	spdk_bs_iter_next(ctx->bs, ctx->blob, _spdk_bs_load_iter, ctx);
+	spdk_blob_close(ctx->blob, _spdk_bs_load_repair_close_cpl, ctx);
 }
 
 static void
@@ -2806,7 +4957,7 @@ _spdk_bs_examine_clone(void *cb_arg, struct spdk_blob *blob, int bserrno)
 
 	if (bserrno != 0) {
 		SPDK_ERRLOG("Failed to open clone of a corrupted blob\n");
-		spdk_bs_iter_next(ctx->bs, ctx->blob, _spdk_bs_load_iter, ctx);
+		spdk_blob_close(ctx->blob, _spdk_bs_load_repair_close_cpl, ctx);
 		return;
 	}
 
@@ -2821,65 +4972,119 @@ _spdk_bs_examine_clone(void *cb_arg, struct spdk_blob *blob, int bserrno)
 	}
 }
 
-static void
-_spdk_bs_load_iter(void *arg, struct spdk_blob *blob, int bserrno)
+static int
+_spdk_bs_load_get_pending_clone(struct spdk_blob *blob, const void **value)
 {
-	struct spdk_bs_load_ctx *ctx = arg;
-	const void *value;
 	size_t len;
-	int rc = 0;
+	int rc;
 
-	if (bserrno == 0) {
-		/* Examine blob if it is corrupted after power failure. Fix
-		 * the ones that can be fixed and remove any other corrupted
-		 * ones. If it is not corrupted just process it */
-		rc = _spdk_blob_get_xattr_value(blob, SNAPSHOT_PENDING_REMOVAL, &value, &len, true);
-		if (rc != 0) {
-			rc = _spdk_blob_get_xattr_value(blob, SNAPSHOT_IN_PROGRESS, &value, &len, true);
-			if (rc != 0) {
-				/* Not corrupted - process it and continue with iterating through blobs */
-				if (ctx->iter_cb_fn) {
-					ctx->iter_cb_fn(ctx->iter_cb_arg, blob, 0);
-				}
-				_spdk_bs_blob_list_add(blob);
-				spdk_bs_iter_next(ctx->bs, blob, _spdk_bs_load_iter, ctx);
-				return;
-			}
+	rc = _spdk_blob_get_xattr_value(blob, SNAPSHOT_PENDING_REMOVAL, value, &len, true);
+	if (rc != 0) {
+		rc = _spdk_blob_get_xattr_value(blob, SNAPSHOT_IN_PROGRESS, value, &len, true);
+	}
 
-		}
+	assert(rc != 0 || len == sizeof(spdk_blob_id));
+	return rc;
+}
 
-		assert(len == sizeof(spdk_blob_id));
+static void
+_spdk_bs_load_repair_blob(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
+	const void *value;
 
-		ctx->blob = blob;
+	if (bserrno != 0) {
+		SPDK_ERRLOG("Failed to open corrupted blob\n");
+		_spdk_bs_load_repair_next(ctx);
+		return;
+	}
+
+	ctx->blob = blob;
 
-		/* Open clone to check if we are able to fix this blob or should we remove it */
-		spdk_bs_open_blob(ctx->bs, *(spdk_blob_id *)value, _spdk_bs_examine_clone, ctx);
+	if (_spdk_bs_load_get_pending_clone(blob, &value) != 0) {
+		/* Already fixed up while repairing another blob */
+		spdk_blob_close(blob, _spdk_bs_load_repair_close_cpl, ctx);
 		return;
-	} else if (bserrno == -ENOENT) {
-		bserrno = 0;
-	} else {
-		/*
-		 * This case needs to be looked at further.  Same problem
-		 *  exists with applications that rely on explicit blob
-		 *  iteration.  We should just skip the blob that failed
-		 *  to load and continue on to the next one.
-		 */
-		SPDK_ERRLOG("Error in iterating blobs\n");
 	}
 
+	/* Open clone to check if we are able to fix this blob or should we remove it */
+	spdk_bs_open_blob(ctx->bs, *(spdk_blob_id *)value, _spdk_bs_examine_clone, ctx);
+}
+
+static void
+_spdk_bs_load_finish(struct spdk_bs_load_ctx *ctx, int bserrno)
+{
 	ctx->iter_cb_fn = NULL;
 
+	free(ctx->repair_blobids);
 	spdk_free(ctx->super);
 	spdk_free(ctx->mask);
 	spdk_bs_sequence_finish(ctx->seq, bserrno);
 	free(ctx);
 }
 
+/* Fix the snapshots one at a time, as doing so opens and may delete other blobs */
+static void
+_spdk_bs_load_repair_next(struct spdk_bs_load_ctx *ctx)
+{
+	if (ctx->repair_idx == ctx->num_repair_blobids) {
+		_spdk_bs_load_finish(ctx, 0);
+		return;
+	}
+
+	spdk_bs_open_blob(ctx->bs, ctx->repair_blobids[ctx->repair_idx++],
+			  _spdk_bs_load_repair_blob, ctx);
+}
+
+static void
+_spdk_bs_load_examine_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("Error in iterating blobs\n");
+		_spdk_bs_load_finish(ctx, bserrno);
+		return;
+	}
+
+	ctx->repair_idx = 0;
+	_spdk_bs_load_repair_next(ctx);
+}
+
+static int
+_spdk_bs_load_examine_blob(void *cb_arg, struct spdk_blob *blob)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
+	spdk_blob_id *tmp;
+	const void *value;
+
+	/* Examine blob if it is corrupted after power failure. The ones that
+	 * are get fixed or removed once all blobs have been examined. If it is
+	 * not corrupted just process it */
+	if (_spdk_bs_load_get_pending_clone(blob, &value) != 0) {
+		if (ctx->iter_cb_fn) {
+			ctx->iter_cb_fn(ctx->iter_cb_arg, blob, 0);
+		}
+		_spdk_bs_blob_list_add(blob);
+		return 0;
+	}
+
+	tmp = realloc(ctx->repair_blobids, (ctx->num_repair_blobids + 1) * sizeof(*tmp));
+	if (tmp == NULL) {
+		return -ENOMEM;
+	}
+
+	tmp[ctx->num_repair_blobids++] = blob->id;
+	ctx->repair_blobids = tmp;
+	return 0;
+}
+
 static void
 _spdk_bs_load_complete(spdk_bs_sequence_t *seq, struct spdk_bs_load_ctx *ctx, int bserrno)
 {
 	ctx->seq = seq;
-	spdk_bs_iter_first(ctx->bs, _spdk_bs_load_iter, ctx);
+	spdk_bs_for_each_blob(ctx->bs, SPDK_BS_LOAD_EXAMINE_QUEUE_DEPTH, _spdk_bs_load_examine_blob,
+			      _spdk_bs_load_examine_cpl, ctx);
 }
 
 static void
@@ -3010,8 +5215,9 @@ _spdk_bs_load_read_used_pages(spdk_bs_sequence_t *seq, void *cb_arg)
 }
 
 static int
-_spdk_bs_load_replay_md_parse_page(const struct spdk_blob_md_page *page, struct spdk_blob_store *bs)
+_spdk_bs_load_replay_md_parse_page(struct spdk_bs_load_ctx *ctx, const struct spdk_blob_md_page *page)
 {
+	struct spdk_blob_store *bs = ctx->bs;
 	struct spdk_blob_md_descriptor *desc;
 	size_t	cur_desc = 0;
 
@@ -3050,6 +5256,62 @@ _spdk_bs_load_replay_md_parse_page(const struct spdk_blob_md_page *page, struct
 			if (cluster_count == 0) {
 				return -EINVAL;
 			}
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_TABLE) {
+			struct spdk_blob_md_descriptor_extent_table	*desc_extent_table;
+			unsigned int					i, j;
+			uint32_t					*tmp;
+
+			desc_extent_table = (struct spdk_blob_md_descriptor_extent_table *)desc;
+
+			if (desc_extent_table->length < sizeof(desc_extent_table->num_clusters)) {
+				return -EINVAL;
+			}
+
+			/* Remember the allocated extent pages, their clusters are claimed
+			 * once the whole metadata page chain has been replayed.
+			 */
+			for (i = 0; i < (desc_extent_table->length - sizeof(desc_extent_table->num_clusters)) /
+			     sizeof(desc_extent_table->extent_page[0]); i++) {
+				if (desc_extent_table->extent_page[i].page_idx == 0) {
+					continue;
+				}
+				tmp = realloc(ctx->extent_page_num, (ctx->num_extent_pages +
+								     desc_extent_table->extent_page[i].num_pages) * sizeof(*tmp));
+				if (tmp == NULL) {
+					return -ENOMEM;
+				}
+				ctx->extent_page_num = tmp;
+				for (j = 0; j < desc_extent_table->extent_page[i].num_pages; j++) {
+					ctx->extent_page_num[ctx->num_extent_pages++] =
+						desc_extent_table->extent_page[i].page_idx + j;
+				}
+			}
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE) {
+			struct spdk_blob_md_descriptor_extent_page	*desc_extent_page;
+			unsigned int					i;
+			uint32_t					cluster_idx;
+
+			desc_extent_page = (struct spdk_blob_md_descriptor_extent_page *)desc;
+
+			if (desc_extent_page->length < sizeof(desc_extent_page->start_cluster_idx)) {
+				return -EINVAL;
+			}
+
+			for (i = 0; i < (desc_extent_page->length - sizeof(desc_extent_page->start_cluster_idx)) /
+			     sizeof(desc_extent_page->cluster_idx[0]); i++) {
+				cluster_idx = desc_extent_page->cluster_idx[i];
+				/*
+				 * cluster_idx = 0 means an unallocated cluster - don't mark that
+				 * in the used cluster map.
+				 */
+				if (cluster_idx != 0) {
+					spdk_bit_array_set(bs->used_clusters, cluster_idx);
+					if (bs->num_free_clusters == 0) {
+						return -ENOSPC;
+					}
+					bs->num_free_clusters--;
+				}
+			}
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR) {
 			/* Skip this item */
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR_INTERNAL) {
@@ -3070,25 +5332,6 @@ _spdk_bs_load_replay_md_parse_page(const struct spdk_blob_md_page *page, struct
 	return 0;
 }
 
-static bool _spdk_bs_load_cur_md_page_valid(struct spdk_bs_load_ctx *ctx)
-{
-	uint32_t crc;
-
-	crc = _spdk_blob_md_page_calc_crc(ctx->page);
-	if (crc != ctx->page->crc) {
-		return false;
-	}
-
-	if (ctx->page->sequence_num == 0 &&
-	    _spdk_bs_page_to_blobid(ctx->cur_page) != ctx->page->id) {
-		return false;
-	}
-	return true;
-}
-
-static void
-_spdk_bs_load_replay_cur_md_page(spdk_bs_sequence_t *seq, void *cb_arg);
-
 static void
 _spdk_bs_load_write_used_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
@@ -3125,70 +5368,214 @@ _spdk_bs_load_write_used_md(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	_spdk_bs_write_used_md(seq, cb_arg, _spdk_bs_load_write_used_pages_cpl);
 }
 
+static int
+_spdk_bs_load_replay_push_page(uint32_t **page_nums, uint64_t *count, uint32_t page_num)
+{
+	uint32_t *tmp;
+
+	tmp = realloc(*page_nums, (*count + 1) * sizeof(*tmp));
+	if (tmp == NULL) {
+		return -ENOMEM;
+	}
+
+	tmp[(*count)++] = page_num;
+	*page_nums = tmp;
+	return 0;
+}
+
+/* Claim a page belonging to a blob and account for everything it describes. */
+static int
+_spdk_bs_load_replay_md_page(struct spdk_bs_load_ctx *ctx, const struct spdk_blob_md_page *page,
+			     uint32_t page_num)
+{
+	uint64_t num_extent_pages, i;
+
+	if (spdk_bit_array_get(ctx->bs->used_md_pages, page_num)) {
+		/* Two chains can't share a page */
+		return -EILSEQ;
+	}
+	spdk_bit_array_set(ctx->bs->used_md_pages, page_num);
+
+	num_extent_pages = ctx->num_extent_pages;
+	if (_spdk_bs_load_replay_md_parse_page(ctx, page)) {
+		return -EILSEQ;
+	}
+
+	for (i = num_extent_pages; i < ctx->num_extent_pages; i++) {
+		if (ctx->extent_page_num[i] >= ctx->super->md_len) {
+			return -EILSEQ;
+		}
+	}
+
+	if (page->next != SPDK_INVALID_MD_PAGE) {
+		if (page->next >= ctx->super->md_len) {
+			return -EILSEQ;
+		}
+		return _spdk_bs_load_replay_push_page(&ctx->chain_page_num, &ctx->num_chain_pages,
+						      page->next);
+	}
+
+	return 0;
+}
+
 static void
-_spdk_bs_load_replay_md_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+_spdk_bs_load_replay_finish(spdk_bs_sequence_t *seq, struct spdk_bs_load_ctx *ctx)
 {
-	struct spdk_bs_load_ctx *ctx = cb_arg;
 	uint64_t num_md_clusters;
 	uint64_t i;
-	uint32_t page_num;
+
+	spdk_free(ctx->replay_pages);
+	ctx->replay_pages = NULL;
+	free(ctx->extent_page_num);
+	ctx->extent_page_num = NULL;
+	free(ctx->chain_page_num);
+	ctx->chain_page_num = NULL;
+
+	/* Claim all of the clusters used by the metadata */
+	num_md_clusters = spdk_divide_round_up(ctx->super->md_start + ctx->super->md_len,
+					       ctx->bs->pages_per_cluster);
+	for (i = 0; i < num_md_clusters; i++) {
+		_spdk_bs_claim_cluster(ctx->bs, i);
+	}
+
+	_spdk_bs_load_write_used_md(seq, ctx, 0);
+}
+
+static void _spdk_bs_load_replay_follow(spdk_bs_sequence_t *seq, struct spdk_bs_load_ctx *ctx);
+
+static void
+_spdk_bs_load_replay_follow_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
+	struct spdk_blob_md_page *page;
+	uint32_t i;
+	int rc;
 
 	if (bserrno != 0) {
 		_spdk_bs_load_ctx_fail(seq, ctx, bserrno);
 		return;
 	}
 
-	page_num = ctx->cur_page;
-	if (_spdk_bs_load_cur_md_page_valid(ctx) == true) {
-		if (ctx->page->sequence_num == 0 || ctx->in_page_chain == true) {
-			spdk_bit_array_set(ctx->bs->used_md_pages, page_num);
-			if (ctx->page->sequence_num == 0) {
-				spdk_bit_array_set(ctx->bs->used_blobids, page_num);
-			}
-			if (_spdk_bs_load_replay_md_parse_page(ctx->page, ctx->bs)) {
+	for (i = 0; i < ctx->replay_count; i++) {
+		page = &ctx->replay_pages[i];
+
+		if (ctx->replay_page_is_extent[i]) {
+			if (_spdk_blob_md_page_calc_crc(page) != page->crc || page->sequence_num != 0) {
 				_spdk_bs_load_ctx_fail(seq, ctx, -EILSEQ);
 				return;
 			}
-			if (ctx->page->next != SPDK_INVALID_MD_PAGE) {
-				ctx->in_page_chain = true;
-				ctx->cur_page = ctx->page->next;
-				_spdk_bs_load_replay_cur_md_page(seq, cb_arg);
-				return;
-			}
+		} else if (_spdk_blob_md_page_calc_crc(page) != page->crc) {
+			/* A torn write cut the chain short, the rest of it is lost */
+			continue;
+		}
+
+		rc = _spdk_bs_load_replay_md_page(ctx, page, ctx->replay_page_num[i]);
+		if (rc != 0) {
+			_spdk_bs_load_ctx_fail(seq, ctx, rc);
+			return;
 		}
 	}
 
-	ctx->in_page_chain = false;
+	_spdk_bs_load_replay_follow(seq, ctx);
+}
 
-	do {
-		ctx->page_index++;
-	} while (spdk_bit_array_get(ctx->bs->used_md_pages, ctx->page_index) == true);
+/* Read the chain and extent pages found so far, which may turn up more of them. */
+static void
+_spdk_bs_load_replay_follow(spdk_bs_sequence_t *seq, struct spdk_bs_load_ctx *ctx)
+{
+	spdk_bs_batch_t *batch;
+	uint32_t page_num;
+	bool is_extent;
 
-	if (ctx->page_index < ctx->super->md_len) {
-		ctx->cur_page = ctx->page_index;
-		_spdk_bs_load_replay_cur_md_page(seq, cb_arg);
-	} else {
-		/* Claim all of the clusters used by the metadata */
-		num_md_clusters = spdk_divide_round_up(ctx->super->md_len, ctx->bs->pages_per_cluster);
-		for (i = 0; i < num_md_clusters; i++) {
-			_spdk_bs_claim_cluster(ctx->bs, i);
+	if (ctx->num_chain_pages == 0 && ctx->num_extent_pages == 0) {
+		_spdk_bs_load_replay_finish(seq, ctx);
+		return;
+	}
+
+	batch = spdk_bs_sequence_to_batch(seq, _spdk_bs_load_replay_follow_cpl, ctx);
+
+	ctx->replay_count = 0;
+	while (ctx->replay_count < SPDK_BS_LOAD_REPLAY_FOLLOW_DEPTH &&
+	       (ctx->num_chain_pages != 0 || ctx->num_extent_pages != 0)) {
+		is_extent = ctx->num_chain_pages == 0;
+		if (is_extent) {
+			page_num = ctx->extent_page_num[--ctx->num_extent_pages];
+		} else {
+			page_num = ctx->chain_page_num[--ctx->num_chain_pages];
+		}
+
+		ctx->replay_page_num[ctx->replay_count] = page_num;
+		ctx->replay_page_is_extent[ctx->replay_count] = is_extent;
+		spdk_bs_batch_read_dev(batch, &ctx->replay_pages[ctx->replay_count],
+				       _spdk_bs_page_to_lba(ctx->bs, ctx->super->md_start + page_num),
+				       _spdk_bs_byte_to_lba(ctx->bs, SPDK_BS_PAGE_SIZE));
+		ctx->replay_count++;
+	}
+
+	spdk_bs_batch_close(batch);
+}
+
+static void _spdk_bs_load_replay_window(spdk_bs_sequence_t *seq, struct spdk_bs_load_ctx *ctx);
+
+static void
+_spdk_bs_load_replay_window_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
+	struct spdk_blob_md_page *page;
+	uint32_t page_num;
+	uint32_t i;
+	int rc;
+
+	if (bserrno != 0) {
+		_spdk_bs_load_ctx_fail(seq, ctx, bserrno);
+		return;
+	}
+
+	/* Every valid first page of a chain starts a blob. The rest of the chain
+	 * and its extent pages are read once the whole region has been scanned. */
+	for (i = 0; i < ctx->replay_count; i++) {
+		page = &ctx->replay_pages[i];
+		page_num = ctx->page_index + i;
+
+		if (page->sequence_num != 0 || _spdk_bs_page_to_blobid(page_num) != page->id ||
+		    _spdk_blob_md_page_calc_crc(page) != page->crc) {
+			continue;
+		}
+
+		spdk_bit_array_set(ctx->bs->used_blobids, page_num);
+		rc = _spdk_bs_load_replay_md_page(ctx, page, page_num);
+		if (rc != 0) {
+			_spdk_bs_load_ctx_fail(seq, ctx, rc);
+			return;
 		}
-		spdk_free(ctx->page);
-		_spdk_bs_load_write_used_md(seq, ctx, bserrno);
 	}
+
+	ctx->page_index += ctx->replay_count;
+	_spdk_bs_load_replay_window(seq, ctx);
 }
 
 static void
-_spdk_bs_load_replay_cur_md_page(spdk_bs_sequence_t *seq, void *cb_arg)
+_spdk_bs_load_replay_window(spdk_bs_sequence_t *seq, struct spdk_bs_load_ctx *ctx)
 {
-	struct spdk_bs_load_ctx *ctx = cb_arg;
-	uint64_t lba;
+	spdk_bs_batch_t *batch;
+	uint32_t offset, num_pages;
 
-	assert(ctx->cur_page < ctx->super->md_len);
-	lba = _spdk_bs_page_to_lba(ctx->bs, ctx->super->md_start + ctx->cur_page);
-	spdk_bs_sequence_read_dev(seq, ctx->page, lba,
-				  _spdk_bs_byte_to_lba(ctx->bs, SPDK_BS_PAGE_SIZE),
-				  _spdk_bs_load_replay_md_cpl, ctx);
+	if (ctx->page_index >= ctx->super->md_len) {
+		_spdk_bs_load_replay_follow(seq, ctx);
+		return;
+	}
+
+	ctx->replay_count = spdk_min(SPDK_BS_LOAD_REPLAY_WINDOW_PAGES,
+				     ctx->super->md_len - ctx->page_index);
+
+	batch = spdk_bs_sequence_to_batch(seq, _spdk_bs_load_replay_window_cpl, ctx);
+	for (offset = 0; offset < ctx->replay_count; offset += num_pages) {
+		num_pages = spdk_min(SPDK_BS_LOAD_REPLAY_READ_PAGES, ctx->replay_count - offset);
+		spdk_bs_batch_read_dev(batch, &ctx->replay_pages[offset],
+				       _spdk_bs_page_to_lba(ctx->bs, ctx->super->md_start + ctx->page_index + offset),
+				       _spdk_bs_page_to_lba(ctx->bs, num_pages));
+	}
+	spdk_bs_batch_close(batch);
 }
 
 static void
@@ -3196,15 +5583,18 @@ _spdk_bs_load_replay_md(spdk_bs_sequence_t *seq, void *cb_arg)
 {
 	struct spdk_bs_load_ctx *ctx = cb_arg;
 
+	SPDK_STATIC_ASSERT(SPDK_BS_LOAD_REPLAY_FOLLOW_DEPTH <= SPDK_BS_LOAD_REPLAY_WINDOW_PAGES,
+			   "Replay buffer must fit a batch of follow up reads");
+
 	ctx->page_index = 0;
-	ctx->cur_page = 0;
-	ctx->page = spdk_zmalloc(SPDK_BS_PAGE_SIZE, SPDK_BS_PAGE_SIZE,
-				 NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (!ctx->page) {
+	ctx->replay_pages = spdk_zmalloc(SPDK_BS_LOAD_REPLAY_WINDOW_PAGES * SPDK_BS_PAGE_SIZE,
+					 SPDK_BS_PAGE_SIZE, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!ctx->replay_pages) {
 		_spdk_bs_load_ctx_fail(seq, ctx, -ENOMEM);
 		return;
 	}
-	_spdk_bs_load_replay_cur_md_page(seq, cb_arg);
+
+	_spdk_bs_load_replay_window(seq, ctx);
 }
 
 static void
@@ -3293,6 +5683,7 @@ _spdk_bs_load_super_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	ctx->bs->cluster_sz = ctx->super->cluster_size;
 	ctx->bs->total_clusters = ctx->super->size / ctx->super->cluster_size;
 	ctx->bs->pages_per_cluster = ctx->bs->cluster_sz / SPDK_BS_PAGE_SIZE;
+	_spdk_bs_init_subcluster_geometry(ctx->bs);
 	ctx->bs->io_unit_size = ctx->super->io_unit_size;
 	rc = spdk_bit_array_resize(&ctx->bs->used_clusters, ctx->bs->total_clusters);
 	if (rc < 0) {
@@ -3467,6 +5858,42 @@ _spdk_bs_dump_print_md_page(struct spdk_bs_dump_ctx *ctx)
 				fprintf(ctx->fp, " Length: %" PRIu32, desc_extent->extents[i].length);
 				fprintf(ctx->fp, "\n");
 			}
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_TABLE) {
+			struct spdk_blob_md_descriptor_extent_table	*desc_extent_table;
+			unsigned int					i;
+
+			desc_extent_table = (struct spdk_blob_md_descriptor_extent_table *)desc;
+
+			fprintf(ctx->fp, "Extent Table - Clusters: %" PRIu64 "\n", desc_extent_table->num_clusters);
+			for (i = 0; i < (desc_extent_table->length - sizeof(desc_extent_table->num_clusters)) /
+			     sizeof(desc_extent_table->extent_page[0]); i++) {
+				if (desc_extent_table->extent_page[i].page_idx != 0) {
+					fprintf(ctx->fp, "Allocated Extent Pages - Start: %" PRIu32,
+						desc_extent_table->extent_page[i].page_idx);
+				} else {
+					fprintf(ctx->fp, "Unallocated Extent Pages - ");
+				}
+				fprintf(ctx->fp, " Length: %" PRIu32, desc_extent_table->extent_page[i].num_pages);
+				fprintf(ctx->fp, "\n");
+			}
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE) {
+			struct spdk_blob_md_descriptor_extent_page	*desc_extent_page;
+			unsigned int					i;
+
+			desc_extent_page = (struct spdk_blob_md_descriptor_extent_page *)desc;
+
+			fprintf(ctx->fp, "Extent Page - Start Cluster: %" PRIu32 "\n",
+				desc_extent_page->start_cluster_idx);
+			for (i = 0; i < (desc_extent_page->length - sizeof(desc_extent_page->start_cluster_idx)) /
+			     sizeof(desc_extent_page->cluster_idx[0]); i++) {
+				if (desc_extent_page->cluster_idx[i] != 0) {
+					fprintf(ctx->fp, "Allocated Cluster - Index: %" PRIu32,
+						desc_extent_page->cluster_idx[i]);
+				} else {
+					fprintf(ctx->fp, "Unallocated Cluster - ");
+				}
+				fprintf(ctx->fp, "\n");
+			}
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR) {
 			struct spdk_blob_md_descriptor_xattr *desc_xattr;
 			uint32_t i;
@@ -4010,6 +6437,28 @@ _spdk_bs_unload_read_super_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrn
 	_spdk_bs_write_used_md(seq, cb_arg, _spdk_bs_unload_write_used_pages_cpl);
 }
 
+static void
+_spdk_bs_unload_release_clusters(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+
+	_spdk_bs_channel_release_clusters(spdk_io_channel_get_ctx(_ch));
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+_spdk_bs_unload_release_clusters_cpl(struct spdk_io_channel_iter *i, int status)
+{
+	struct spdk_bs_load_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	assert(ctx->bs->num_reserved_clusters == 0);
+
+	/* Read super block */
+	spdk_bs_sequence_read_dev(ctx->seq, ctx->super, _spdk_bs_page_to_lba(ctx->bs, 0),
+				  _spdk_bs_byte_to_lba(ctx->bs, sizeof(*ctx->super)),
+				  _spdk_bs_unload_read_super_cpl, ctx);
+}
+
 void
 spdk_bs_unload(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_arg)
 {
@@ -4053,10 +6502,11 @@ spdk_bs_unload(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_a
 		return;
 	}
 
-	/* Read super block */
-	spdk_bs_sequence_read_dev(seq, ctx->super, _spdk_bs_page_to_lba(bs, 0),
-				  _spdk_bs_byte_to_lba(bs, sizeof(*ctx->super)),
-				  _spdk_bs_unload_read_super_cpl, ctx);
+	ctx->seq = seq;
+
+	/* Clusters still held in channel pools must not be persisted as used */
+	spdk_for_each_channel(bs, _spdk_bs_unload_release_clusters, ctx,
+			      _spdk_bs_unload_release_clusters_cpl);
 }
 
 /* END spdk_bs_unload */
@@ -4180,7 +6630,8 @@ spdk_bs_get_io_unit_size(struct spdk_blob_store *bs)
 uint64_t
 spdk_bs_free_cluster_count(struct spdk_blob_store *bs)
 {
-	return bs->num_free_clusters;
+	/* Clusters sitting in channel pools are not in use yet, so report them as free */
+	return bs->num_free_clusters + __atomic_load_n(&bs->num_reserved_clusters, __ATOMIC_RELAXED);
 }
 
 uint64_t
@@ -4335,6 +6786,37 @@ _spdk_bs_create_blob(struct spdk_blob_store *bs,
 		_spdk_blob_set_thin_provision(blob);
 	}
 
+	if (opts->use_extent_table) {
+		blob->invalid_flags |= SPDK_BLOB_EXTENT_TABLE;
+		blob->use_extent_table = true;
+	}
+
+	if (opts->use_subcluster_cow) {
+		blob->invalid_flags |= SPDK_BLOB_SUBCLUSTER_COW;
+		blob->use_subcluster_cow = true;
+	}
+
+	if (opts->esnap_id != NULL) {
+		if (bs->esnap_bs_dev_create == NULL || opts->esnap_id_len == 0 ||
+		    opts->esnap_id_len > UINT16_MAX) {
+			_spdk_blob_free(blob);
+			cb_fn(cb_arg, 0, -EINVAL);
+			return;
+		}
+
+		rc = _spdk_blob_set_xattr(blob, BLOB_EXTERNAL_SNAPSHOT_ID, opts->esnap_id,
+					  opts->esnap_id_len, true);
+		if (rc < 0) {
+			_spdk_blob_free(blob);
+			cb_fn(cb_arg, 0, rc);
+			return;
+		}
+
+		/* The device is created when the blob is opened */
+		_spdk_blob_set_thin_provision(blob);
+		blob->invalid_flags |= SPDK_BLOB_EXTERNAL_SNAPSHOT;
+	}
+
 	rc = _spdk_blob_resize(blob, opts->num_clusters);
 	if (rc < 0) {
 		_spdk_blob_free(blob);
@@ -4370,6 +6852,254 @@ void spdk_bs_create_blob_ext(struct spdk_blob_store *bs, const struct spdk_blob_
 
 /* END spdk_bs_create_blob */
 
+/* START background cluster copy */
+
+/* Period at which a rate limited copy gets a new budget */
+#define SPDK_BLOB_COPY_TIMESLICE_US 10000
+
+struct spdk_blob_bg_copy;
+
+struct spdk_blob_bg_copy_op {
+	struct spdk_blob_bg_copy	*copy;
+	uint64_t			cluster;
+
+	/* Used by shallow copy only */
+	void				*buf;
+	uint64_t			io_unit;
+	uint64_t			io_unit_end;
+	uint64_t			run;
+	struct spdk_bs_dev_cb_args	cb_args;
+
+	TAILQ_ENTRY(spdk_blob_bg_copy_op) link;
+};
+
+/* Walks the clusters of a blob and copies the ones selected by next_cluster,
+ * keeping up to queue_depth of them in flight and, if asked to, no more than
+ * mbytes_per_sec worth of them per second. Passes over the blob are repeated
+ * for as long as rescan is set and the previous pass found anything to copy.
+ */
+struct spdk_blob_bg_copy {
+	struct spdk_blob		*blob;
+	struct spdk_io_channel		*channel;
+	struct spdk_blob_copy_opts	opts;
+	bool				rescan;
+
+	/* Look for a cluster to copy starting at next, returns false at the end of the blob */
+	bool (*next_cluster)(struct spdk_blob_bg_copy *copy, uint64_t *cluster);
+	void (*copy_cluster)(struct spdk_blob_bg_copy_op *op);
+	spdk_blob_op_complete		cb_fn;
+	void				*cb_arg;
+
+	uint64_t			next;
+	bool				pass_done;
+	bool				pass_found;
+	bool				in_submit;
+	uint32_t			outstanding;
+	int				bserrno;
+
+	/* Bytes that may still be copied in the current time slice */
+	int64_t				budget;
+	struct spdk_poller		*poller;
+
+	struct spdk_blob_bg_copy_op	*ops;
+	TAILQ_HEAD(, spdk_blob_bg_copy_op) free_ops;
+
+	uint64_t			clusters_total;
+	uint64_t			clusters_done;
+	uint64_t			start_ticks;
+};
+
+void
+spdk_blob_copy_opts_init(struct spdk_blob_copy_opts *opts)
+{
+	opts->queue_depth = SPDK_BLOB_COPY_DEFAULT_QUEUE_DEPTH;
+	opts->mbytes_per_sec = 0;
+}
+
+static int64_t
+_spdk_blob_bg_copy_slice_bytes(struct spdk_blob_bg_copy *copy)
+{
+	return copy->opts.mbytes_per_sec * 1024 * 1024 * SPDK_BLOB_COPY_TIMESLICE_US / SPDK_SEC_TO_USEC;
+}
+
+static void
+_spdk_blob_bg_copy_finish(struct spdk_blob_bg_copy *copy)
+{
+	spdk_poller_unregister(&copy->poller);
+	copy->blob->bg_copy = NULL;
+
+	copy->cb_fn(copy->cb_arg, copy->bserrno);
+}
+
+static void
+_spdk_blob_bg_copy_submit(struct spdk_blob_bg_copy *copy)
+{
+	struct spdk_blob_bg_copy_op *op;
+	uint64_t cluster;
+
+	/* Clusters may complete right away, they then leave it to this loop to go on */
+	copy->in_submit = true;
+
+	while (true) {
+		while (copy->bserrno == 0 && !copy->pass_done &&
+		       copy->outstanding < copy->opts.queue_depth &&
+		       (copy->opts.mbytes_per_sec == 0 || copy->budget > 0)) {
+			if (!copy->next_cluster(copy, &cluster)) {
+				copy->pass_done = true;
+				break;
+			}
+
+			op = TAILQ_FIRST(&copy->free_ops);
+			assert(op != NULL);
+			TAILQ_REMOVE(&copy->free_ops, op, link);
+
+			op->cluster = cluster;
+			copy->pass_found = true;
+			copy->budget -= copy->blob->bs->cluster_sz;
+			copy->outstanding++;
+			copy->copy_cluster(op);
+		}
+
+		if (copy->outstanding > 0 || copy->bserrno != 0 || !copy->pass_done ||
+		    !copy->rescan || !copy->pass_found) {
+			break;
+		}
+
+		/* Writes that raced with the pass may have left clusters behind */
+		copy->next = 0;
+		copy->pass_done = false;
+		copy->pass_found = false;
+	}
+
+	copy->in_submit = false;
+
+	if (copy->outstanding == 0 && (copy->bserrno != 0 || copy->pass_done)) {
+		_spdk_blob_bg_copy_finish(copy);
+	}
+}
+
+static void
+_spdk_blob_bg_copy_op_done(struct spdk_blob_bg_copy_op *op, int bserrno)
+{
+	struct spdk_blob_bg_copy *copy = op->copy;
+
+	assert(copy->outstanding > 0);
+	copy->outstanding--;
+	TAILQ_INSERT_TAIL(&copy->free_ops, op, link);
+
+	if (bserrno != 0) {
+		if (copy->bserrno == 0) {
+			copy->bserrno = bserrno;
+		}
+	} else {
+		copy->clusters_done++;
+		copy->clusters_total = spdk_max(copy->clusters_total, copy->clusters_done);
+	}
+
+	if (!copy->in_submit) {
+		_spdk_blob_bg_copy_submit(copy);
+	}
+}
+
+static int
+_spdk_blob_bg_copy_refill(void *arg)
+{
+	struct spdk_blob_bg_copy *copy = arg;
+	int64_t slice = _spdk_blob_bg_copy_slice_bytes(copy);
+
+	/* Don't let an idle copy save up for a burst */
+	copy->budget = spdk_min(copy->budget + slice, slice);
+	if (copy->budget > 0 && !copy->in_submit) {
+		_spdk_blob_bg_copy_submit(copy);
+	}
+
+	return 1;
+}
+
+static int
+_spdk_blob_bg_copy_init(struct spdk_blob_bg_copy *copy, struct spdk_blob *blob,
+			struct spdk_io_channel *channel, const struct spdk_blob_copy_opts *opts)
+{
+	uint32_t i;
+
+	copy->blob = blob;
+	copy->channel = channel;
+	if (opts) {
+		copy->opts = *opts;
+	} else {
+		spdk_blob_copy_opts_init(&copy->opts);
+	}
+
+	if (copy->opts.queue_depth == 0) {
+		SPDK_ERRLOG("Copy queue depth cannot be 0\n");
+		return -EINVAL;
+	}
+
+	copy->ops = calloc(copy->opts.queue_depth, sizeof(*copy->ops));
+	if (copy->ops == NULL) {
+		return -ENOMEM;
+	}
+
+	TAILQ_INIT(&copy->free_ops);
+	for (i = 0; i < copy->opts.queue_depth; i++) {
+		copy->ops[i].copy = copy;
+		TAILQ_INSERT_TAIL(&copy->free_ops, &copy->ops[i], link);
+	}
+
+	return 0;
+}
+
+static void
+_spdk_blob_bg_copy_fini(struct spdk_blob_bg_copy *copy)
+{
+	free(copy->ops);
+	copy->ops = NULL;
+}
+
+static void
+_spdk_blob_bg_copy_start(struct spdk_blob_bg_copy *copy)
+{
+	assert(copy->blob->bg_copy == NULL);
+
+	copy->blob->bg_copy = copy;
+	copy->start_ticks = spdk_get_ticks();
+
+	if (copy->opts.mbytes_per_sec != 0) {
+		copy->budget = _spdk_blob_bg_copy_slice_bytes(copy);
+		copy->poller = spdk_poller_register(_spdk_blob_bg_copy_refill, copy,
+						    SPDK_BLOB_COPY_TIMESLICE_US);
+	}
+
+	_spdk_blob_bg_copy_submit(copy);
+}
+
+int
+spdk_blob_get_copy_progress(struct spdk_blob *blob, struct spdk_blob_copy_progress *progress)
+{
+	struct spdk_blob_bg_copy *copy = blob->bg_copy;
+	uint64_t elapsed_us;
+
+	if (copy == NULL) {
+		return -ENOENT;
+	}
+
+	elapsed_us = (spdk_get_ticks() - copy->start_ticks) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+
+	progress->clusters_total = copy->clusters_total;
+	progress->clusters_done = copy->clusters_done;
+	progress->elapsed_ms = elapsed_us / 1000;
+	if (copy->clusters_done == 0) {
+		progress->eta_ms = 0;
+	} else {
+		progress->eta_ms = elapsed_us / copy->clusters_done *
+				   (copy->clusters_total - copy->clusters_done) / 1000;
+	}
+
+	return 0;
+}
+
+/* END background cluster copy */
+
 /* START blob_cleanup */
 
 struct spdk_clone_snapshot_ctx {
@@ -4379,8 +7109,9 @@ struct spdk_clone_snapshot_ctx {
 
 	struct spdk_io_channel *channel;
 
-	/* Current cluster for inflate operation */
-	uint64_t cluster;
+	/* Copies the clusters for inflate operation */
+	struct spdk_blob_copy_opts copy_opts;
+	struct spdk_blob_bg_copy copy;
 
 	/* For inflation force allocation of all unallocated clusters and remove
 	 * thin-provisioning. Otherwise only decouple parent and keep clone thin. */
@@ -4426,6 +7157,7 @@ _spdk_bs_clone_snapshot_cleanup_finish(void *cb_arg, int bserrno)
 		break;
 	}
 
+	_spdk_blob_bg_copy_fini(&ctx->copy);
 	free(ctx);
 }
 
@@ -4492,6 +7224,34 @@ _spdk_bs_clone_snapshot_newblob_cleanup(void *cb_arg, int bserrno)
 
 /* END blob_cleanup */
 
+/* Make dst a clone of the same external snapshot as src, if src is one.
+ * The caller hands over the backing device.
+ */
+static int
+_spdk_blob_copy_esnap_id(struct spdk_blob *src, struct spdk_blob *dst)
+{
+	const void *esnap_id;
+	size_t id_len;
+	int rc;
+
+	if (!(src->invalid_flags & SPDK_BLOB_EXTERNAL_SNAPSHOT)) {
+		return 0;
+	}
+
+	rc = _spdk_blob_get_xattr_value(src, BLOB_EXTERNAL_SNAPSHOT_ID, &esnap_id, &id_len, true);
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = _spdk_blob_set_xattr(dst, BLOB_EXTERNAL_SNAPSHOT_ID, esnap_id, id_len, true);
+	if (rc != 0) {
+		return rc;
+	}
+
+	dst->invalid_flags |= SPDK_BLOB_EXTERNAL_SNAPSHOT | SPDK_BLOB_THIN_PROV;
+	return 0;
+}
+
 /* START spdk_bs_create_snapshot */
 
 static void
@@ -4499,9 +7259,19 @@ _spdk_bs_snapshot_swap_cluster_maps(struct spdk_blob *blob1, struct spdk_blob *b
 {
 	uint64_t *cluster_temp;
 
+	uint64_t *mask_temp;
+	size_t mask_size_temp;
+
 	cluster_temp = blob1->active.clusters;
 	blob1->active.clusters = blob2->active.clusters;
 	blob2->active.clusters = cluster_temp;
+
+	mask_temp = blob1->subcluster_masks;
+	mask_size_temp = blob1->subcluster_mask_array_size;
+	blob1->subcluster_masks = blob2->subcluster_masks;
+	blob1->subcluster_mask_array_size = blob2->subcluster_mask_array_size;
+	blob2->subcluster_masks = mask_temp;
+	blob2->subcluster_mask_array_size = mask_size_temp;
 }
 
 static void
@@ -4557,6 +7327,7 @@ _spdk_bs_snapshot_newblob_sync_cpl(void *cb_arg, int bserrno)
 
 	_spdk_bs_blob_list_remove(origblob);
 	origblob->parent_id = newblob->id;
+	_spdk_bs_topology_changed(origblob->bs);
 
 	/* Create new back_bs_dev for snapshot */
 	origblob->back_bs_dev = spdk_bs_create_blob_bs_dev(newblob);
@@ -4567,6 +7338,11 @@ _spdk_bs_snapshot_newblob_sync_cpl(void *cb_arg, int bserrno)
 		return;
 	}
 
+	if (origblob->invalid_flags & SPDK_BLOB_EXTERNAL_SNAPSHOT) {
+		_spdk_blob_remove_xattr(origblob, BLOB_EXTERNAL_SNAPSHOT_ID, true);
+		origblob->invalid_flags &= ~SPDK_BLOB_EXTERNAL_SNAPSHOT;
+	}
+
 	/* set clone blob as thin provisioned */
 	_spdk_blob_set_thin_provision(origblob);
 
@@ -4608,6 +7384,13 @@ _spdk_bs_snapshot_freeze_cpl(void *cb_arg, int rc)
 		}
 	}
 
+	/* the snapshot becomes the clone of the external snapshot instead */
+	bserrno = _spdk_blob_copy_esnap_id(origblob, newblob);
+	if (bserrno != 0) {
+		_spdk_bs_clone_snapshot_newblob_cleanup(ctx, bserrno);
+		return;
+	}
+
 	/* swap cluster maps */
 	_spdk_bs_snapshot_swap_cluster_maps(newblob, origblob);
 
@@ -4704,6 +7487,8 @@ _spdk_bs_snapshot_origblob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int b
 	 * but do not allocate clusters */
 	opts.thin_provision = true;
 	opts.num_clusters = spdk_blob_get_num_clusters(_blob);
+	opts.use_extent_table = _blob->use_extent_table;
+	opts.use_subcluster_cow = _blob->use_subcluster_cow;
 
 	/* If there are any xattrs specified for snapshot, set them now */
 	if (ctx->xattrs) {
@@ -4812,6 +7597,8 @@ _spdk_bs_clone_origblob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bser
 
 	opts.thin_provision = true;
 	opts.num_clusters = spdk_blob_get_num_clusters(_blob);
+	opts.use_extent_table = _blob->use_extent_table;
+	opts.use_subcluster_cow = _blob->use_subcluster_cow;
 	if (ctx->xattrs) {
 		memcpy(&opts.xattrs, ctx->xattrs, sizeof(*ctx->xattrs));
 	}
@@ -4867,6 +7654,7 @@ _spdk_bs_inflate_blob_set_parent_cpl(void *cb_arg, struct spdk_blob *_parent, in
 
 	_spdk_bs_blob_list_remove(_blob);
 	_blob->parent_id = _parent->id;
+	_spdk_bs_topology_changed(_blob->bs);
 	_spdk_blob_set_xattr(_blob, BLOB_SNAPSHOT, &_blob->parent_id,
 			     sizeof(spdk_blob_id), true);
 
@@ -4877,12 +7665,38 @@ _spdk_bs_inflate_blob_set_parent_cpl(void *cb_arg, struct spdk_blob *_parent, in
 	spdk_blob_sync_md(_blob, _spdk_bs_clone_snapshot_origblob_cleanup, ctx);
 }
 
+static void
+_spdk_bs_inflate_blob_remove_parent(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+	struct spdk_blob *_blob = ctx->original.blob;
+
+	if (bserrno != 0) {
+		_spdk_bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
+		return;
+	}
+
+	/* remove thin provisioning */
+	_spdk_bs_blob_list_remove(_blob);
+	_spdk_blob_remove_xattr(_blob, BLOB_SNAPSHOT, true);
+	_spdk_blob_remove_xattr(_blob, BLOB_EXTERNAL_SNAPSHOT_ID, true);
+	_blob->invalid_flags = _blob->invalid_flags & ~(SPDK_BLOB_THIN_PROV | SPDK_BLOB_EXTERNAL_SNAPSHOT);
+	_blob->back_bs_dev->destroy(_blob->back_bs_dev);
+	_blob->back_bs_dev = NULL;
+	_blob->parent_id = SPDK_BLOBID_INVALID;
+	_spdk_bs_topology_changed(_blob->bs);
+
+	_blob->state = SPDK_BLOB_STATE_DIRTY;
+	spdk_blob_sync_md(_blob, _spdk_bs_clone_snapshot_origblob_cleanup, ctx);
+}
+
 static void
 _spdk_bs_inflate_blob_done(void *cb_arg, int bserrno)
 {
 	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
 	struct spdk_blob *_blob = ctx->original.blob;
 	struct spdk_blob *_parent;
+	struct spdk_bs_dev *parent_dev;
 
 	if (bserrno != 0) {
 		_spdk_bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
@@ -4890,48 +7704,82 @@ _spdk_bs_inflate_blob_done(void *cb_arg, int bserrno)
 	}
 
 	if (ctx->allocate_all) {
-		/* remove thin provisioning */
-		_spdk_bs_blob_list_remove(_blob);
-		_spdk_blob_remove_xattr(_blob, BLOB_SNAPSHOT, true);
-		_blob->invalid_flags = _blob->invalid_flags & ~SPDK_BLOB_THIN_PROV;
-		_blob->back_bs_dev->destroy(_blob->back_bs_dev);
-		_blob->back_bs_dev = NULL;
-		_blob->parent_id = SPDK_BLOBID_INVALID;
-	} else {
-		_parent = ((struct spdk_blob_bs_dev *)(_blob->back_bs_dev))->blob;
-		if (_parent->parent_id != SPDK_BLOBID_INVALID) {
-			/* We must change the parent of the inflated blob */
-			spdk_bs_open_blob(_blob->bs, _parent->parent_id,
-					  _spdk_bs_inflate_blob_set_parent_cpl, ctx);
+		/* All clusters are allocated now, so nothing reads from an external
+		 * snapshot device anymore and its channels can be put. */
+		_spdk_blob_put_back_channels(_blob, _spdk_bs_inflate_blob_remove_parent, ctx);
+		return;
+	}
+
+	parent_dev = _blob->back_bs_dev;
+	_parent = ((struct spdk_blob_bs_dev *)parent_dev)->blob;
+	if (_parent->parent_id != SPDK_BLOBID_INVALID) {
+		/* We must change the parent of the inflated blob */
+		spdk_bs_open_blob(_blob->bs, _parent->parent_id,
+				  _spdk_bs_inflate_blob_set_parent_cpl, ctx);
+		return;
+	}
+
+	if (_parent->invalid_flags & SPDK_BLOB_EXTERNAL_SNAPSHOT) {
+		/* Clusters the parent did not have are still read from its external snapshot */
+		bserrno = _spdk_blob_copy_esnap_id(_parent, _blob);
+		if (bserrno == 0) {
+			bserrno = _spdk_blob_load_esnap_dev(_blob);
+		}
+		if (bserrno != 0) {
+			_spdk_blob_remove_xattr(_blob, BLOB_EXTERNAL_SNAPSHOT_ID, true);
+			_blob->invalid_flags &= ~SPDK_BLOB_EXTERNAL_SNAPSHOT;
+			_blob->back_bs_dev = parent_dev;
+			_spdk_bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
 			return;
 		}
-
-		_spdk_bs_blob_list_remove(_blob);
-		_spdk_blob_remove_xattr(_blob, BLOB_SNAPSHOT, true);
-		_blob->parent_id = SPDK_BLOBID_INVALID;
-		_blob->back_bs_dev->destroy(_blob->back_bs_dev);
+	} else {
 		_blob->back_bs_dev = spdk_bs_create_zeroes_dev();
 	}
 
+	_spdk_bs_blob_list_remove(_blob);
+	_spdk_blob_remove_xattr(_blob, BLOB_SNAPSHOT, true);
+	_blob->parent_id = SPDK_BLOBID_INVALID;
+	_spdk_bs_topology_changed(_blob->bs);
+	parent_dev->destroy(parent_dev);
+
 	_blob->state = SPDK_BLOB_STATE_DIRTY;
 	spdk_blob_sync_md(_blob, _spdk_bs_clone_snapshot_origblob_cleanup, ctx);
 }
 
 /* Check if cluster needs allocation */
 static inline bool
-_spdk_bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool allocate_all)
+_spdk_bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool allocate_all)
+{
+	struct spdk_blob_bs_dev *b;
+
+	assert(blob != NULL);
+
+	if (blob->active.clusters[cluster] != 0) {
+		/* Cluster is already allocated */
+		return false;
+	}
+
+	if (blob->parent_id == SPDK_BLOBID_INVALID) {
+		/* Blob have no parent blob */
+		return allocate_all;
+	}
+
+	b = (struct spdk_blob_bs_dev *)blob->back_bs_dev;
+	return (allocate_all || b->blob->active.clusters[cluster] != 0);
+}
+
+/* Check if an allocated cluster still needs sub-clusters copied from the parent */
+static inline bool
+_spdk_bs_cluster_needs_fill(struct spdk_blob *blob, uint64_t cluster, bool allocate_all)
 {
 	struct spdk_blob_bs_dev *b;
 
-	assert(blob != NULL);
-
-	if (blob->active.clusters[cluster] != 0) {
-		/* Cluster is already allocated */
+	if (blob->active.clusters[cluster] == 0 || _spdk_blob_subcluster_mask(blob, cluster) == 0) {
 		return false;
 	}
 
 	if (blob->parent_id == SPDK_BLOBID_INVALID) {
-		/* Blob have no parent blob */
+		/* The rest of the cluster reads as zeroes */
 		return allocate_all;
 	}
 
@@ -4939,36 +7787,47 @@ _spdk_bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool
 	return (allocate_all || b->blob->active.clusters[cluster] != 0);
 }
 
-static void
-_spdk_bs_inflate_blob_touch_next(void *cb_arg, int bserrno)
+static inline bool
+_spdk_bs_cluster_needs_touch(struct spdk_blob *blob, uint64_t cluster, bool allocate_all)
 {
-	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
-	struct spdk_blob *_blob = ctx->original.blob;
-	uint64_t offset;
+	return _spdk_bs_cluster_needs_allocation(blob, cluster, allocate_all) ||
+	       _spdk_bs_cluster_needs_fill(blob, cluster, allocate_all);
+}
 
-	if (bserrno != 0) {
-		_spdk_bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
-		return;
-	}
+static bool
+_spdk_bs_inflate_blob_next_cluster(struct spdk_blob_bg_copy *copy, uint64_t *cluster)
+{
+	struct spdk_clone_snapshot_ctx *ctx = SPDK_CONTAINEROF(copy, struct spdk_clone_snapshot_ctx,
+					      copy);
+	struct spdk_blob *_blob = copy->blob;
 
-	for (; ctx->cluster < _blob->active.num_clusters; ctx->cluster++) {
-		if (_spdk_bs_cluster_needs_allocation(_blob, ctx->cluster, ctx->allocate_all)) {
-			break;
+	for (; copy->next < _blob->active.num_clusters; copy->next++) {
+		if (_spdk_bs_cluster_needs_touch(_blob, copy->next, ctx->allocate_all)) {
+			*cluster = copy->next++;
+			return true;
 		}
 	}
 
-	if (ctx->cluster < _blob->active.num_clusters) {
-		offset = _spdk_bs_cluster_to_lba(_blob->bs, ctx->cluster);
+	return false;
+}
 
-		/* We may safely increment a cluster before write */
-		ctx->cluster++;
+static void
+_spdk_bs_inflate_blob_touch_cpl(void *cb_arg, int bserrno)
+{
+	_spdk_blob_bg_copy_op_done(cb_arg, bserrno);
+}
 
-		/* Use zero length write to touch a cluster */
-		spdk_blob_io_write(_blob, ctx->channel, NULL, offset, 0,
-				   _spdk_bs_inflate_blob_touch_next, ctx);
-	} else {
-		_spdk_bs_inflate_blob_done(cb_arg, bserrno);
-	}
+static void
+_spdk_bs_inflate_blob_touch_cluster(struct spdk_blob_bg_copy_op *op)
+{
+	struct spdk_blob_bg_copy *copy = op->copy;
+	uint64_t offset;
+
+	offset = _spdk_bs_cluster_to_lba(copy->blob->bs, op->cluster);
+
+	/* Use zero length write to touch a cluster */
+	spdk_blob_io_write(copy->blob, copy->channel, NULL, offset, 0,
+			   _spdk_bs_inflate_blob_touch_cpl, op);
 }
 
 static void
@@ -5007,6 +7866,12 @@ _spdk_bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrn
 		return;
 	}
 
+	bserrno = _spdk_blob_bg_copy_init(&ctx->copy, _blob, ctx->channel, &ctx->copy_opts);
+	if (bserrno != 0) {
+		_spdk_bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
+		return;
+	}
+
 	/* Do two passes - one to verify that we can obtain enough clusters
 	 * and another to actually claim them.
 	 */
@@ -5020,16 +7885,24 @@ _spdk_bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrn
 				return;
 			}
 			lfc++;
+			ctx->copy.clusters_total++;
+		} else if (_spdk_bs_cluster_needs_fill(_blob, i, ctx->allocate_all)) {
+			ctx->copy.clusters_total++;
 		}
 	}
 
-	ctx->cluster = 0;
-	_spdk_bs_inflate_blob_touch_next(ctx, 0);
+	ctx->copy.rescan = _blob->use_subcluster_cow;
+	ctx->copy.next_cluster = _spdk_bs_inflate_blob_next_cluster;
+	ctx->copy.copy_cluster = _spdk_bs_inflate_blob_touch_cluster;
+	ctx->copy.cb_fn = _spdk_bs_inflate_blob_done;
+	ctx->copy.cb_arg = ctx;
+	_spdk_blob_bg_copy_start(&ctx->copy);
 }
 
 static void
 _spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
-		      spdk_blob_id blobid, bool allocate_all, spdk_blob_op_complete cb_fn, void *cb_arg)
+		      spdk_blob_id blobid, bool allocate_all, const struct spdk_blob_copy_opts *opts,
+		      spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_clone_snapshot_ctx *ctx = calloc(1, sizeof(*ctx));
 
@@ -5044,6 +7917,11 @@ _spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channe
 	ctx->original.id = blobid;
 	ctx->channel = channel;
 	ctx->allocate_all = allocate_all;
+	if (opts) {
+		ctx->copy_opts = *opts;
+	} else {
+		spdk_blob_copy_opts_init(&ctx->copy_opts);
+	}
 
 	spdk_bs_open_blob(bs, ctx->original.id, _spdk_bs_inflate_blob_open_cpl, ctx);
 }
@@ -5052,17 +7930,274 @@ void
 spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 		     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
-	_spdk_bs_inflate_blob(bs, channel, blobid, true, cb_fn, cb_arg);
+	_spdk_bs_inflate_blob(bs, channel, blobid, true, NULL, cb_fn, cb_arg);
+}
+
+void
+spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			 spdk_blob_id blobid, const struct spdk_blob_copy_opts *opts,
+			 spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	_spdk_bs_inflate_blob(bs, channel, blobid, true, opts, cb_fn, cb_arg);
 }
 
 void
 spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 			     spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
-	_spdk_bs_inflate_blob(bs, channel, blobid, false, cb_fn, cb_arg);
+	_spdk_bs_inflate_blob(bs, channel, blobid, false, NULL, cb_fn, cb_arg);
+}
+
+void
+spdk_bs_blob_decouple_parent_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+				 spdk_blob_id blobid, const struct spdk_blob_copy_opts *opts,
+				 spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	_spdk_bs_inflate_blob(bs, channel, blobid, false, opts, cb_fn, cb_arg);
 }
 /* END spdk_bs_inflate_blob */
 
+/* START spdk_bs_blob_shallow_copy */
+
+struct shallow_copy_ctx {
+	struct spdk_bs_cpl		cpl;
+	int				bserrno;
+
+	struct spdk_blob		*blob;
+	struct spdk_io_channel		*channel;
+	struct spdk_blob_copy_opts	opts;
+	struct spdk_blob_bg_copy	copy;
+
+	struct spdk_bs_dev		*ext_dev;
+	struct spdk_io_channel		*ext_channel;
+};
+
+static void
+_spdk_bs_shallow_copy_cleanup_finish(void *cb_arg, int bserrno)
+{
+	struct shallow_copy_ctx *ctx = cb_arg;
+	uint32_t i;
+
+	if (bserrno != 0 && ctx->bserrno == 0) {
+		ctx->bserrno = bserrno;
+	}
+
+	if (ctx->copy.ops != NULL) {
+		for (i = 0; i < ctx->copy.opts.queue_depth; i++) {
+			spdk_free(ctx->copy.ops[i].buf);
+		}
+	}
+	_spdk_blob_bg_copy_fini(&ctx->copy);
+
+	if (ctx->ext_channel != NULL) {
+		ctx->ext_dev->destroy_channel(ctx->ext_dev, ctx->ext_channel);
+	}
+
+	ctx->cpl.u.blob_basic.cb_fn(ctx->cpl.u.blob_basic.cb_arg, ctx->bserrno);
+	free(ctx);
+}
+
+static void
+_spdk_bs_shallow_copy_cleanup(void *cb_arg, int bserrno)
+{
+	struct shallow_copy_ctx *ctx = cb_arg;
+
+	if (bserrno != 0 && ctx->bserrno == 0) {
+		ctx->bserrno = bserrno;
+	}
+
+	ctx->blob->locked_operation_in_progress = false;
+	spdk_blob_close(ctx->blob, _spdk_bs_shallow_copy_cleanup_finish, ctx);
+}
+
+static bool
+_spdk_bs_shallow_copy_next_cluster(struct spdk_blob_bg_copy *copy, uint64_t *cluster)
+{
+	struct spdk_blob *blob = copy->blob;
+
+	for (; copy->next < blob->active.num_clusters; copy->next++) {
+		if (blob->active.clusters[copy->next] != 0) {
+			*cluster = copy->next++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void _spdk_bs_shallow_copy_next_run(struct spdk_blob_bg_copy_op *op);
+
+static void
+_spdk_bs_shallow_copy_write_cpl(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_bg_copy_op *op = cb_arg;
+
+	if (bserrno != 0) {
+		_spdk_blob_bg_copy_op_done(op, bserrno);
+		return;
+	}
+
+	op->io_unit += op->run;
+	_spdk_bs_shallow_copy_next_run(op);
+}
+
+static void
+_spdk_bs_shallow_copy_read_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_bg_copy_op *op = cb_arg;
+	struct shallow_copy_ctx *ctx = SPDK_CONTAINEROF(op->copy, struct shallow_copy_ctx, copy);
+	struct spdk_blob_store *bs = ctx->blob->bs;
+
+	if (bserrno != 0) {
+		_spdk_blob_bg_copy_op_done(op, bserrno);
+		return;
+	}
+
+	op->cb_args.cb_fn = _spdk_bs_shallow_copy_write_cpl;
+	op->cb_args.channel = ctx->ext_channel;
+	op->cb_args.cb_arg = op;
+
+	ctx->ext_dev->write(ctx->ext_dev, ctx->ext_channel, op->buf,
+			    _spdk_bs_io_units_to_dev_lba(bs, ctx->ext_dev, op->io_unit),
+			    _spdk_bs_io_units_to_dev_lba(bs, ctx->ext_dev, op->run), &op->cb_args);
+}
+
+/* Copy the next run of io_units of the cluster the blob holds itself, the
+ * sub-clusters it still reads from its parent are skipped.
+ */
+static void
+_spdk_bs_shallow_copy_next_run(struct spdk_blob_bg_copy_op *op)
+{
+	struct spdk_blob_bg_copy *copy = op->copy;
+	struct spdk_blob *blob = copy->blob;
+
+	while (op->io_unit < op->io_unit_end && !_spdk_bs_io_unit_is_valid(blob, op->io_unit)) {
+		op->io_unit += _spdk_bs_num_io_units_to_valid_boundary(blob, op->io_unit);
+	}
+
+	if (op->io_unit >= op->io_unit_end) {
+		_spdk_blob_bg_copy_op_done(op, 0);
+		return;
+	}
+
+	op->run = spdk_min(_spdk_bs_num_io_units_to_valid_boundary(blob, op->io_unit),
+			   op->io_unit_end - op->io_unit);
+
+	spdk_blob_io_read(blob, copy->channel, op->buf, op->io_unit, op->run,
+			  _spdk_bs_shallow_copy_read_cpl, op);
+}
+
+static void
+_spdk_bs_shallow_copy_cluster(struct spdk_blob_bg_copy_op *op)
+{
+	struct spdk_blob_store *bs = op->copy->blob->bs;
+
+	op->io_unit = _spdk_bs_cluster_to_lba(bs, op->cluster);
+	op->io_unit_end = op->io_unit + _spdk_bs_cluster_to_lba(bs, 1);
+	_spdk_bs_shallow_copy_next_run(op);
+}
+
+static void
+_spdk_bs_shallow_copy_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct shallow_copy_ctx *ctx = cb_arg;
+	struct spdk_blob_store *bs;
+	uint64_t i;
+
+	if (bserrno != 0) {
+		_spdk_bs_shallow_copy_cleanup_finish(ctx, bserrno);
+		return;
+	}
+
+	ctx->blob = blob;
+	bs = blob->bs;
+
+	if (blob->locked_operation_in_progress) {
+		SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Cannot copy blob - another operation in progress\n");
+		ctx->bserrno = -EBUSY;
+		spdk_blob_close(blob, _spdk_bs_shallow_copy_cleanup_finish, ctx);
+		return;
+	}
+
+	blob->locked_operation_in_progress = true;
+
+	if (!spdk_blob_is_read_only(blob)) {
+		SPDK_ERRLOG("Cannot shallow copy blob that is not read-only\n");
+		_spdk_bs_shallow_copy_cleanup(ctx, -EPERM);
+		return;
+	}
+
+	if (bs->io_unit_size % ctx->ext_dev->blocklen != 0 ||
+	    ctx->ext_dev->blockcnt * ctx->ext_dev->blocklen <
+	    spdk_blob_get_num_clusters(blob) * bs->cluster_sz) {
+		SPDK_ERRLOG("Device is too small or has an incompatible block size for shallow copy\n");
+		_spdk_bs_shallow_copy_cleanup(ctx, -EINVAL);
+		return;
+	}
+
+	bserrno = _spdk_blob_bg_copy_init(&ctx->copy, blob, ctx->channel, &ctx->opts);
+	if (bserrno != 0) {
+		_spdk_bs_shallow_copy_cleanup(ctx, bserrno);
+		return;
+	}
+
+	for (i = 0; i < ctx->copy.opts.queue_depth; i++) {
+		ctx->copy.ops[i].buf = spdk_malloc(bs->cluster_sz, ctx->ext_dev->blocklen, NULL,
+						   SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+		if (ctx->copy.ops[i].buf == NULL) {
+			_spdk_bs_shallow_copy_cleanup(ctx, -ENOMEM);
+			return;
+		}
+	}
+
+	ctx->ext_channel = ctx->ext_dev->create_channel(ctx->ext_dev);
+	if (ctx->ext_channel == NULL) {
+		_spdk_bs_shallow_copy_cleanup(ctx, -ENOMEM);
+		return;
+	}
+
+	for (i = 0; i < blob->active.num_clusters; i++) {
+		if (blob->active.clusters[i] != 0) {
+			ctx->copy.clusters_total++;
+		}
+	}
+
+	ctx->copy.next_cluster = _spdk_bs_shallow_copy_next_cluster;
+	ctx->copy.copy_cluster = _spdk_bs_shallow_copy_cluster;
+	ctx->copy.cb_fn = _spdk_bs_shallow_copy_cleanup;
+	ctx->copy.cb_arg = ctx;
+	_spdk_blob_bg_copy_start(&ctx->copy);
+}
+
+void
+spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			  spdk_blob_id blobid, struct spdk_bs_dev *ext_dev,
+			  const struct spdk_blob_copy_opts *opts,
+			  spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct shallow_copy_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	ctx->cpl.u.blob_basic.cb_fn = cb_fn;
+	ctx->cpl.u.blob_basic.cb_arg = cb_arg;
+	ctx->channel = channel;
+	ctx->ext_dev = ext_dev;
+	if (opts) {
+		ctx->opts = *opts;
+	} else {
+		spdk_blob_copy_opts_init(&ctx->opts);
+	}
+
+	spdk_bs_open_blob(bs, blobid, _spdk_bs_shallow_copy_open_cpl, ctx);
+}
+/* END spdk_bs_blob_shallow_copy */
+
 /* START spdk_blob_resize */
 struct spdk_bs_resize_ctx {
 	spdk_blob_op_complete cb_fn;
@@ -5192,6 +8327,8 @@ struct delete_snapshot_ctx {
 	bool snapshot_md_ro;
 	struct spdk_blob *clone;
 	bool clone_md_ro;
+	/* Next clone cluster to check for sub-clusters still read from the snapshot */
+	uint64_t cluster;
 	spdk_blob_op_with_handle_complete cb_fn;
 	void *cb_arg;
 	int bserrno;
@@ -5230,7 +8367,7 @@ _spdk_delete_snapshot_cleanup_snapshot(void *cb_arg, int bserrno)
 	 * open_ref == 2 menas that clone has opened this snapshot as well,
 	 * so we have to add it back to the blobs list */
 	if (ctx->snapshot->open_ref == 2) {
-		TAILQ_INSERT_HEAD(&ctx->snapshot->bs->blobs, ctx->snapshot, link);
+		_spdk_bs_add_open_blob(ctx->snapshot->bs, ctx->snapshot);
 	}
 
 	ctx->snapshot->locked_operation_in_progress = false;
@@ -5289,8 +8426,7 @@ _spdk_delete_snapshot_sync_snapshot_cpl(void *cb_arg, int bserrno)
 	/* Remove clone entry in this snapshot (at this point there can be only one clone) */
 	clone_entry = TAILQ_FIRST(&snapshot_entry->clones);
 	assert(clone_entry != NULL);
-	TAILQ_REMOVE(&snapshot_entry->clones, clone_entry, link);
-	snapshot_entry->clone_count--;
+	_spdk_bs_unlink_clone_entry(clone_entry);
 	assert(TAILQ_EMPTY(&snapshot_entry->clones));
 
 	if (ctx->snapshot->parent_id != SPDK_BLOBID_INVALID) {
@@ -5304,11 +8440,11 @@ _spdk_delete_snapshot_sync_snapshot_cpl(void *cb_arg, int bserrno)
 				&snapshot_clone_entry);
 
 		/* Switch clone entry in parent snapshot */
-		TAILQ_INSERT_TAIL(&parent_snapshot_entry->clones, clone_entry, link);
-		TAILQ_REMOVE(&parent_snapshot_entry->clones, snapshot_clone_entry, link);
-		free(snapshot_clone_entry);
+		_spdk_bs_add_clone_entry(parent_snapshot_entry, clone_entry);
+		_spdk_bs_remove_clone_entry(ctx->snapshot->bs, snapshot_clone_entry);
 	} else {
 		/* No parent snapshot - just remove clone entry */
+		_spdk_blob_hash_remove(&ctx->snapshot->bs->clone_hash, &clone_entry->hash_entry);
 		free(clone_entry);
 	}
 
@@ -5351,7 +8487,9 @@ _spdk_delete_snapshot_sync_clone_cpl(void *cb_arg, int bserrno)
 
 	ctx->snapshot->state = SPDK_BLOB_STATE_DIRTY;
 
-	if (ctx->parent_snapshot_entry != NULL) {
+	if (ctx->parent_snapshot_entry != NULL ||
+	    (ctx->snapshot->invalid_flags & SPDK_BLOB_EXTERNAL_SNAPSHOT)) {
+		/* The backing device was handed over to the clone */
 		ctx->snapshot->back_bs_dev = NULL;
 	}
 
@@ -5375,32 +8513,116 @@ _spdk_delete_snapshot_sync_snapshot_xattr_cpl(void *cb_arg, int bserrno)
 		return;
 	}
 
+	/* Clusters taken over from the snapshot keep reading the parts it did not copy
+	 * from its parent, so make room for their masks in the clone. */
+	bserrno = _spdk_blob_grow_subcluster_masks(ctx->clone,
+			spdk_min(ctx->snapshot->subcluster_mask_array_size, ctx->clone->active.num_clusters));
+	if (bserrno) {
+		ctx->bserrno = bserrno;
+		_spdk_delete_snapshot_cleanup_clone(ctx, 0);
+		return;
+	}
+
 	/* Copy snapshot map to clone map (only unallocated clusters in clone) */
 	for (i = 0; i < ctx->snapshot->active.num_clusters && i < ctx->clone->active.num_clusters; i++) {
 		if (ctx->clone->active.clusters[i] == 0) {
 			ctx->clone->active.clusters[i] = ctx->snapshot->active.clusters[i];
+			_spdk_blob_set_subcluster_mask(ctx->clone, i, _spdk_blob_subcluster_mask(ctx->snapshot, i));
 		}
 	}
 
 	/* Delete old backing bs_dev from clone (related to snapshot that will be removed) */
 	ctx->clone->back_bs_dev->destroy(ctx->clone->back_bs_dev);
+	_spdk_bs_topology_changed(ctx->clone->bs);
+
+	/* Set/remove snapshot xattr and switch parent ID and backing bs_dev on clone... */
+	if (ctx->parent_snapshot_entry != NULL) {
+		/* ...to parent snapshot */
+		ctx->clone->parent_id = ctx->parent_snapshot_entry->id;
+		ctx->clone->back_bs_dev = ctx->snapshot->back_bs_dev;
+		_spdk_blob_set_xattr(ctx->clone, BLOB_SNAPSHOT, &ctx->parent_snapshot_entry->id,
+				     sizeof(spdk_blob_id),
+				     true);
+	} else if (ctx->snapshot->invalid_flags & SPDK_BLOB_EXTERNAL_SNAPSHOT) {
+		/* ...to external snapshot of the snapshot */
+		ctx->clone->parent_id = SPDK_BLOBID_INVALID;
+		ctx->clone->back_bs_dev = ctx->snapshot->back_bs_dev;
+		_spdk_blob_remove_xattr(ctx->clone, BLOB_SNAPSHOT, true);
+		_spdk_blob_copy_esnap_id(ctx->snapshot, ctx->clone);
+	} else {
+		/* ...to blobid invalid and zeroes dev */
+		ctx->clone->parent_id = SPDK_BLOBID_INVALID;
+		ctx->clone->back_bs_dev = spdk_bs_create_zeroes_dev();
+		_spdk_blob_remove_xattr(ctx->clone, BLOB_SNAPSHOT, true);
+	}
+
+	spdk_blob_sync_md(ctx->clone, _spdk_delete_snapshot_sync_clone_cpl, ctx);
+}
+
+static void
+_spdk_delete_snapshot_mark_pending_removal(struct delete_snapshot_ctx *ctx)
+{
+	/* Temporarily override md_ro flag for snapshot for MD modification */
+	ctx->snapshot_md_ro = ctx->snapshot->md_ro;
+	ctx->snapshot->md_ro = false;
+
+	/* Mark blob as pending for removal for power failure safety, use clone id for recovery */
+	ctx->bserrno = _spdk_blob_set_xattr(ctx->snapshot, SNAPSHOT_PENDING_REMOVAL, &ctx->clone->id,
+					    sizeof(spdk_blob_id), true);
+	if (ctx->bserrno != 0) {
+		_spdk_delete_snapshot_cleanup_clone(ctx, 0);
+		return;
+	}
+
+	spdk_blob_sync_md(ctx->snapshot, _spdk_delete_snapshot_sync_snapshot_xattr_cpl, ctx);
+}
+
+/* Clone clusters that are only partially copied from the snapshot would read
+ * the rest from the wrong parent once the snapshot is gone, so copy the rest
+ * of them first. Clone I/O is frozen at this point, so the copies bypass the
+ * user I/O path.
+ */
+static void
+_spdk_delete_snapshot_fill_clone_next(void *cb_arg, int bserrno)
+{
+	struct delete_snapshot_ctx *ctx = cb_arg;
+	struct spdk_blob *clone = ctx->clone;
+	struct spdk_blob_store *bs = clone->bs;
+	struct spdk_bs_cpl cpl;
+	spdk_bs_user_op_t *op;
+	uint64_t offset;
+
+	if (bserrno) {
+		SPDK_ERRLOG("Failed to copy clone clusters from snapshot\n");
+		ctx->bserrno = bserrno;
+		_spdk_delete_snapshot_cleanup_clone(ctx, 0);
+		return;
+	}
+
+	for (; ctx->cluster < clone->active.num_clusters; ctx->cluster++) {
+		if (_spdk_bs_cluster_needs_fill(clone, ctx->cluster, false)) {
+			break;
+		}
+	}
+
+	if (ctx->cluster == clone->active.num_clusters) {
+		_spdk_delete_snapshot_mark_pending_removal(ctx);
+		return;
+	}
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = _spdk_delete_snapshot_fill_clone_next;
+	cpl.u.blob_basic.cb_arg = ctx;
 
-	/* Set/remove snapshot xattr and switch parent ID and backing bs_dev on clone... */
-	if (ctx->parent_snapshot_entry != NULL) {
-		/* ...to parent snapshot */
-		ctx->clone->parent_id = ctx->parent_snapshot_entry->id;
-		ctx->clone->back_bs_dev = ctx->snapshot->back_bs_dev;
-		_spdk_blob_set_xattr(ctx->clone, BLOB_SNAPSHOT, &ctx->parent_snapshot_entry->id,
-				     sizeof(spdk_blob_id),
-				     true);
-	} else {
-		/* ...to blobid invalid and zeroes dev */
-		ctx->clone->parent_id = SPDK_BLOBID_INVALID;
-		ctx->clone->back_bs_dev = spdk_bs_create_zeroes_dev();
-		_spdk_blob_remove_xattr(ctx->clone, BLOB_SNAPSHOT, true);
+	offset = _spdk_bs_cluster_to_lba(bs, ctx->cluster);
+	op = spdk_bs_user_op_alloc(bs->md_channel, &cpl, SPDK_BLOB_WRITE, clone, NULL, 0, offset, 0);
+	if (!op) {
+		_spdk_delete_snapshot_fill_clone_next(ctx, -ENOMEM);
+		return;
 	}
 
-	spdk_blob_sync_md(ctx->clone, _spdk_delete_snapshot_sync_clone_cpl, ctx);
+	ctx->cluster++;
+	_spdk_bs_allocate_and_copy_cluster(clone, bs->md_channel, offset, op);
 }
 
 static void
@@ -5415,19 +8637,8 @@ _spdk_delete_snapshot_freeze_io_cb(void *cb_arg, int bserrno)
 		return;
 	}
 
-	/* Temporarily override md_ro flag for snapshot for MD modification */
-	ctx->snapshot_md_ro = ctx->snapshot->md_ro;
-	ctx->snapshot->md_ro = false;
-
-	/* Mark blob as pending for removal for power failure safety, use clone id for recovery */
-	ctx->bserrno = _spdk_blob_set_xattr(ctx->snapshot, SNAPSHOT_PENDING_REMOVAL, &ctx->clone->id,
-					    sizeof(spdk_blob_id), true);
-	if (ctx->bserrno != 0) {
-		_spdk_delete_snapshot_cleanup_clone(ctx, 0);
-		return;
-	}
-
-	spdk_blob_sync_md(ctx->snapshot, _spdk_delete_snapshot_sync_snapshot_xattr_cpl, ctx);
+	ctx->cluster = 0;
+	_spdk_delete_snapshot_fill_clone_next(ctx, 0);
 }
 
 static void
@@ -5497,8 +8708,7 @@ _spdk_bs_delete_blob_finish(void *cb_arg, struct spdk_blob *blob, int bserrno)
 	/* Remove snapshot from the list */
 	snapshot_entry = _spdk_bs_get_snapshot_entry(blob->bs, blob->id);
 	if (snapshot_entry != NULL) {
-		TAILQ_REMOVE(&blob->bs->snapshots, snapshot_entry, link);
-		free(snapshot_entry);
+		_spdk_bs_remove_snapshot_entry(blob->bs, snapshot_entry);
 	}
 
 	page_num = _spdk_bs_blobid_to_page(blob->id);
@@ -5610,7 +8820,7 @@ _spdk_bs_delete_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
 	 * Remove the blob from the blob_store list now, to ensure it does not
 	 *  get returned after this point by _spdk_blob_lookup().
 	 */
-	TAILQ_REMOVE(&blob->bs->blobs, blob, link);
+	_spdk_bs_remove_open_blob(blob->bs, blob);
 
 	if (update_clone) {
 		/* This blob is a snapshot with active clone - update clone first */
@@ -5665,7 +8875,7 @@ _spdk_bs_open_blob_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 
 	blob->open_ref++;
 
-	TAILQ_INSERT_HEAD(&blob->bs->blobs, blob, link);
+	_spdk_bs_add_open_blob(blob->bs, blob);
 
 	spdk_bs_sequence_finish(seq, bserrno);
 }
@@ -5721,150 +8931,574 @@ static void _spdk_bs_open_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
 		return;
 	}
 
-	_spdk_blob_load(seq, blob, _spdk_bs_open_blob_cpl, blob);
+	_spdk_blob_load(seq, blob, _spdk_bs_open_blob_cpl, blob);
+}
+
+void spdk_bs_open_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
+		       spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
+{
+	_spdk_bs_open_blob(bs, blobid, NULL, cb_fn, cb_arg);
+}
+
+void spdk_bs_open_blob_ext(struct spdk_blob_store *bs, spdk_blob_id blobid,
+			   struct spdk_blob_open_opts *opts, spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
+{
+	_spdk_bs_open_blob(bs, blobid, opts, cb_fn, cb_arg);
+}
+
+/* END spdk_bs_open_blob */
+
+/* START spdk_blob_set_read_only */
+int spdk_blob_set_read_only(struct spdk_blob *blob)
+{
+	_spdk_blob_verify_md_op(blob);
+
+	blob->data_ro_flags |= SPDK_BLOB_READ_ONLY;
+
+	blob->state = SPDK_BLOB_STATE_DIRTY;
+	return 0;
+}
+/* END spdk_blob_set_read_only */
+
+/* START spdk_blob_sync_md */
+
+static void
+_spdk_blob_sync_md_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob *blob = cb_arg;
+
+	if (bserrno == 0 && (blob->data_ro_flags & SPDK_BLOB_READ_ONLY)) {
+		blob->data_ro = true;
+		blob->md_ro = true;
+	}
+
+	spdk_bs_sequence_finish(seq, bserrno);
+}
+
+static void
+_spdk_blob_sync_md(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_bs_cpl	cpl;
+	spdk_bs_sequence_t	*seq;
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = cb_fn;
+	cpl.u.blob_basic.cb_arg = cb_arg;
+
+	seq = spdk_bs_sequence_start(blob->bs->md_channel, &cpl);
+	if (!seq) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	_spdk_blob_persist(seq, blob, _spdk_blob_sync_md_cpl, blob);
+}
+
+void
+spdk_blob_sync_md(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	_spdk_blob_verify_md_op(blob);
+
+	SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Syncing blob %lu\n", blob->id);
+
+	if (blob->md_ro) {
+		assert(blob->state == SPDK_BLOB_STATE_CLEAN);
+		cb_fn(cb_arg, 0);
+		return;
+	}
+
+	_spdk_blob_sync_md(blob, cb_fn, cb_arg);
+}
+
+/* END spdk_blob_sync_md */
+
+struct spdk_blob_insert_cluster_ctx {
+	struct spdk_bs_channel	*channel;
+	struct spdk_blob	*blob;
+	uint32_t		cluster_num;	/* cluster index in blob */
+	uint32_t		cluster;	/* cluster on disk */
+	/* Sub-clusters copied into the cluster, 0 if the whole cluster was */
+	uint64_t		filled;
+	int			rc;
+	/* Set for the first insert of each metadata update issued for the batch */
+	bool			owner;
+	/* Whole blob gets synced, instead of only the extent page covering the cluster */
+	bool			full_sync;
+	spdk_blob_op_complete	cb_fn;
+	void			*cb_arg;
+	TAILQ_ENTRY(spdk_blob_insert_cluster_ctx) link;
+};
+
+struct spdk_blob_write_extent_page_ctx {
+	struct spdk_blob		*blob;
+	struct spdk_blob_md_page	*page;
+	struct spdk_bs_md_write		write;
+	struct spdk_bs_md_commit	commit;
+};
+
+static void
+_spdk_blob_write_extent_page_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_write_extent_page_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_blob_md_descriptor_extent_page *desc;
+	uint64_t i, start_cluster, num_clusters;
+
+	/* The clusters written are on disk now. Without this, a cluster released
+	 * later would match the stale clean copy and its extent page be skipped.
+	 */
+	if (bserrno == 0) {
+		desc = (struct spdk_blob_md_descriptor_extent_page *)ctx->page->descriptors;
+		start_cluster = desc->start_cluster_idx;
+		num_clusters = (desc->length - sizeof(desc->start_cluster_idx)) /
+			       sizeof(desc->cluster_idx[0]);
+		for (i = 0; i < num_clusters && start_cluster + i < blob->clean.num_clusters; i++) {
+			blob->clean.clusters[start_cluster + i] = _spdk_bs_cluster_to_lba(blob->bs,
+					desc->cluster_idx[i]);
+		}
+	}
+
+	spdk_free(ctx->page);
+	free(ctx);
+	spdk_bs_sequence_finish(seq, bserrno);
+}
+
+/* Rewrite a single, already allocated, extent page in place. */
+static void
+_spdk_blob_write_extent_page(struct spdk_blob *blob, uint64_t ep,
+			     spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_store			*bs = blob->bs;
+	struct spdk_blob_write_extent_page_ctx	*ctx;
+	struct spdk_bs_cpl			cpl;
+	spdk_bs_sequence_t			*seq;
+
+	assert(ep < blob->active.num_extent_pages);
+	assert(blob->active.extent_pages[ep] != 0);
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->page = spdk_malloc(SPDK_BS_PAGE_SIZE, SPDK_BS_PAGE_SIZE, NULL,
+				SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!ctx->page) {
+		free(ctx);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = cb_fn;
+	cpl.u.blob_basic.cb_arg = cb_arg;
+
+	seq = spdk_bs_sequence_start(bs->md_channel, &cpl);
+	if (!seq) {
+		spdk_free(ctx->page);
+		free(ctx);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	_spdk_blob_serialize_extent_page(blob, ep, ctx->page);
+
+	ctx->blob = blob;
+	ctx->write.page = ctx->page;
+	ctx->write.page_idx = blob->active.extent_pages[ep];
+	ctx->commit.seq = seq;
+	ctx->commit.cb_fn = _spdk_blob_write_extent_page_cpl;
+	ctx->commit.cb_arg = ctx;
+	ctx->commit.writes = &ctx->write;
+	ctx->commit.num_writes = 1;
+	_spdk_bs_md_commit_submit(bs, &ctx->commit);
+}
+
+/* If the on-disk extent table already points to an extent page covering
+ * the cluster, updating that page in place is all that is needed. Otherwise
+ * the extent table has to change as well, so the whole blob must be synced.
+ * The blob must be clean, so that the on-disk extent table matches the
+ * in-memory cluster count, and the blobstore must already be marked dirty,
+ * so that the used cluster mask gets rebuilt after a crash.
+ */
+static bool
+_spdk_blob_can_write_extent_page(struct spdk_blob *blob, uint64_t ep)
+{
+	return blob->use_extent_table && blob->state == SPDK_BLOB_STATE_CLEAN && !blob->bs->clean &&
+	       ep < blob->active.num_extent_pages && ep < blob->clean.num_extent_pages &&
+	       blob->active.extent_pages[ep] != 0 &&
+	       blob->active.extent_pages[ep] == blob->clean.extent_pages[ep];
+}
+
+/* Whether the metadata update issued for owner also persists ctx's cluster. */
+static bool
+_spdk_blob_insert_cluster_same_update(struct spdk_blob_insert_cluster_ctx *owner,
+				      struct spdk_blob_insert_cluster_ctx *ctx)
+{
+	return owner->blob == ctx->blob &&
+	       (owner->full_sync ||
+		owner->cluster_num / SPDK_EXTENTS_PER_EP == ctx->cluster_num / SPDK_EXTENTS_PER_EP);
+}
+
+static void _spdk_bs_channel_submit_inserts(struct spdk_bs_channel *ch);
+
+static void
+_spdk_bs_insert_clusters_cpl(void *arg)
+{
+	struct spdk_bs_channel *ch = arg;
+	struct spdk_blob_insert_cluster_ctx *ctx;
+	TAILQ_HEAD(, spdk_blob_insert_cluster_ctx) inserted;
+
+	TAILQ_INIT(&inserted);
+	TAILQ_SWAP(&ch->inflight_inserts, &inserted, spdk_blob_insert_cluster_ctx, link);
+
+	while (!TAILQ_EMPTY(&inserted)) {
+		ctx = TAILQ_FIRST(&inserted);
+		TAILQ_REMOVE(&inserted, ctx, link);
+		ctx->cb_fn(ctx->cb_arg, ctx->rc);
+		free(ctx);
+	}
+
+	/* Everything queued up while this batch was in flight goes out as the next one */
+	ch->insert_in_progress = false;
+	_spdk_bs_channel_submit_inserts(ch);
+}
+
+static void
+_spdk_bs_insert_clusters_put_op(struct spdk_bs_channel *ch)
+{
+	assert(ch->inflight_insert_ops > 0);
+	if (--ch->inflight_insert_ops > 0) {
+		return;
+	}
+
+	spdk_thread_send_msg(spdk_io_channel_get_thread(spdk_io_channel_from_ctx(ch)),
+			     _spdk_bs_insert_clusters_cpl, ch);
+}
+
+static void
+_spdk_bs_insert_clusters_op_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_insert_cluster_ctx *owner = cb_arg;
+	struct spdk_bs_channel *ch = owner->channel;
+	struct spdk_blob_insert_cluster_ctx *ctx;
+
+	if (bserrno != 0) {
+		/* Fail every insert that this metadata update was persisting */
+		TAILQ_FOREACH(ctx, &ch->inflight_inserts, link) {
+			if (ctx->rc == 0 && _spdk_blob_insert_cluster_same_update(owner, ctx)) {
+				ctx->rc = bserrno;
+			}
+		}
+	}
+
+	_spdk_bs_insert_clusters_put_op(ch);
+}
+
+static void
+_spdk_bs_insert_clusters_msg(void *arg)
+{
+	struct spdk_bs_channel *ch = arg;
+	struct spdk_blob_insert_cluster_ctx *ctx, *prev;
+
+	/* Hold an extra reference, so the batch can't complete while updates are issued */
+	ch->inflight_insert_ops = 1;
+
+	TAILQ_FOREACH(ctx, &ch->inflight_inserts, link) {
+		bool mask_changed = false;
+
+		if (ctx->filled != 0) {
+			ctx->rc = _spdk_blob_fill_subclusters(ctx->blob, ctx->cluster_num, ctx->cluster,
+							      ctx->filled, &mask_changed);
+		} else {
+			ctx->rc = _spdk_blob_insert_cluster(ctx->blob, ctx->cluster_num, ctx->cluster);
+		}
+
+		/* Sub-cluster masks live in the metadata page chain */
+		if (ctx->rc == 0 && (mask_changed ||
+				     !_spdk_blob_can_write_extent_page(ctx->blob, ctx->cluster_num / SPDK_EXTENTS_PER_EP))) {
+			ctx->blob->state = SPDK_BLOB_STATE_DIRTY;
+		}
+	}
+
+	/* A dirty blob is synced once for all of its clusters in the batch. Otherwise
+	 * each extent page touched by the batch is written once. */
+	TAILQ_FOREACH(ctx, &ch->inflight_inserts, link) {
+		if (ctx->rc != 0) {
+			continue;
+		}
+
+		ctx->full_sync = ctx->blob->state != SPDK_BLOB_STATE_CLEAN;
+		ctx->owner = true;
+		TAILQ_FOREACH(prev, &ch->inflight_inserts, link) {
+			if (prev == ctx) {
+				break;
+			}
+			if (prev->rc == 0 && _spdk_blob_insert_cluster_same_update(prev, ctx)) {
+				ctx->owner = false;
+				break;
+			}
+		}
+	}
+
+	TAILQ_FOREACH(ctx, &ch->inflight_inserts, link) {
+		if (ctx->rc != 0 || !ctx->owner) {
+			continue;
+		}
+
+		ch->inflight_insert_ops++;
+		if (ctx->full_sync) {
+			_spdk_blob_sync_md(ctx->blob, _spdk_bs_insert_clusters_op_cpl, ctx);
+		} else {
+			_spdk_blob_write_extent_page(ctx->blob, ctx->cluster_num / SPDK_EXTENTS_PER_EP,
+						     _spdk_bs_insert_clusters_op_cpl, ctx);
+		}
+	}
+
+	_spdk_bs_insert_clusters_put_op(ch);
+}
+
+static void
+_spdk_bs_channel_submit_inserts(struct spdk_bs_channel *ch)
+{
+	if (ch->insert_in_progress || TAILQ_EMPTY(&ch->pending_inserts)) {
+		return;
+	}
+
+	ch->insert_in_progress = true;
+	TAILQ_SWAP(&ch->inflight_inserts, &ch->pending_inserts, spdk_blob_insert_cluster_ctx, link);
+	spdk_thread_send_msg(ch->bs->md_thread, _spdk_bs_insert_clusters_msg, ch);
+}
+
+static void
+_spdk_blob_queue_insert(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+			uint32_t cluster_num, uint64_t cluster, uint64_t filled,
+			spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_insert_cluster_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->channel = ch;
+	ctx->blob = blob;
+	ctx->cluster_num = cluster_num;
+	ctx->cluster = cluster;
+	ctx->filled = filled;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	TAILQ_INSERT_TAIL(&ch->pending_inserts, ctx, link);
+	_spdk_bs_channel_submit_inserts(ch);
 }
 
-void spdk_bs_open_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
-		       spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
+/* Queue a cluster insert on the channel. Inserts are sent to the metadata
+ * thread in batches, one batch per channel at a time.
+ */
+static void
+_spdk_blob_insert_cluster_on_md_thread(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+				       uint32_t cluster_num, uint64_t cluster,
+				       spdk_blob_op_complete cb_fn, void *cb_arg)
 {
-	_spdk_bs_open_blob(bs, blobid, NULL, cb_fn, cb_arg);
+	_spdk_blob_queue_insert(ch, blob, cluster_num, cluster, 0, cb_fn, cb_arg);
 }
 
-void spdk_bs_open_blob_ext(struct spdk_blob_store *bs, spdk_blob_id blobid,
-			   struct spdk_blob_open_opts *opts, spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
+/* Queue marking the filled sub-clusters of a cluster as copied, inserting the
+ * cluster first if it was not allocated yet. Goes through the same batches as
+ * whole cluster inserts.
+ */
+static void
+_spdk_blob_fill_subclusters_on_md_thread(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+		uint32_t cluster_num, uint64_t cluster, uint64_t filled,
+		spdk_blob_op_complete cb_fn, void *cb_arg)
 {
-	_spdk_bs_open_blob(bs, blobid, opts, cb_fn, cb_arg);
+	assert(filled != 0);
+	_spdk_blob_queue_insert(ch, blob, cluster_num, cluster, filled, cb_fn, cb_arg);
 }
 
-/* END spdk_bs_open_blob */
-
-/* START spdk_blob_set_read_only */
-int spdk_blob_set_read_only(struct spdk_blob *blob)
+static void
+_spdk_blob_releases_done(struct spdk_blob *blob, int bserrno)
 {
-	_spdk_blob_verify_md_op(blob);
+	struct spdk_blob_release_ctx *ctx;
+	TAILQ_HEAD(, spdk_blob_release_ctx) done;
 
-	blob->data_ro_flags |= SPDK_BLOB_READ_ONLY;
+	TAILQ_INIT(&done);
+	TAILQ_SWAP(&blob->inflight_releases, &done, spdk_blob_release_ctx, link);
 
-	blob->state = SPDK_BLOB_STATE_DIRTY;
-	return 0;
-}
-/* END spdk_blob_set_read_only */
+	while (!TAILQ_EMPTY(&done)) {
+		ctx = TAILQ_FIRST(&done);
+		TAILQ_REMOVE(&done, ctx, link);
+		if (ctx->md_rc == 0) {
+			ctx->md_rc = bserrno;
+		}
+		free(ctx->released);
+		ctx->released = NULL;
+		spdk_thread_send_msg(ctx->thread, _spdk_blob_release_clusters_cpl, ctx);
+	}
 
-/* START spdk_blob_sync_md */
+	/* Releases queued up while these were synced go out as the next batch */
+	_spdk_blob_submit_releases(blob);
+}
 
 static void
-_spdk_blob_sync_md_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+_spdk_blob_release_clusters_unmap_cpl(void *cb_arg, int bserrno)
 {
 	struct spdk_blob *blob = cb_arg;
+	struct spdk_blob_release_ctx *ctx;
+	uint64_t i;
 
-	if (bserrno == 0 && (blob->data_ro_flags & SPDK_BLOB_READ_ONLY)) {
-		blob->data_ro = true;
-		blob->md_ro = true;
+	/* The metadata no longer refers to the clusters, whether the unmap
+	 * worked or not, so they can be handed out again.
+	 */
+	TAILQ_FOREACH(ctx, &blob->inflight_releases, link) {
+		for (i = 0; i < ctx->num_released; i++) {
+			_spdk_bs_release_cluster(blob->bs, ctx->released[i]);
+		}
 	}
 
-	spdk_bs_sequence_finish(seq, bserrno);
+	_spdk_blob_releases_done(blob, 0);
 }
 
+/* Every channel went through a message since the clusters were taken out of
+ * the cluster map, so I/O translated with the old map was submitted before.
+ */
 static void
-_spdk_blob_sync_md(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg)
+_spdk_blob_release_clusters_barrier_cpl(struct spdk_io_channel_iter *iter, int status)
 {
-	struct spdk_bs_cpl	cpl;
-	spdk_bs_sequence_t	*seq;
+	struct spdk_blob *blob = spdk_io_channel_iter_get_ctx(iter);
+	struct spdk_blob_store *bs = blob->bs;
+	struct spdk_blob_release_ctx *ctx;
+	struct spdk_bs_cpl cpl;
+	spdk_bs_batch_t *batch;
+	uint64_t lba, i;
+	uint32_t lba_count;
 
 	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
-	cpl.u.blob_basic.cb_fn = cb_fn;
-	cpl.u.blob_basic.cb_arg = cb_arg;
+	cpl.u.blob_basic.cb_fn = _spdk_blob_release_clusters_unmap_cpl;
+	cpl.u.blob_basic.cb_arg = blob;
 
-	seq = spdk_bs_sequence_start(blob->bs->md_channel, &cpl);
-	if (!seq) {
-		cb_fn(cb_arg, -ENOMEM);
+	batch = spdk_bs_batch_open(bs->md_channel, &cpl);
+	if (batch == NULL) {
+		_spdk_blob_release_clusters_unmap_cpl(blob, -ENOMEM);
 		return;
 	}
 
-	_spdk_blob_persist(seq, blob, _spdk_blob_sync_md_cpl, blob);
+	/* Let the device know the clusters are unused, merging contiguous ones */
+	TAILQ_FOREACH(ctx, &blob->inflight_releases, link) {
+		lba = 0;
+		lba_count = 0;
+		for (i = 0; i < ctx->num_released; i++) {
+			uint64_t next_lba = _spdk_bs_cluster_to_lba(bs, ctx->released[i]);
+
+			if (lba_count > 0 && lba + lba_count == next_lba) {
+				lba_count += _spdk_bs_cluster_to_lba(bs, 1);
+				continue;
+			}
+			if (lba_count > 0) {
+				spdk_bs_batch_unmap_dev(batch, lba, lba_count);
+			}
+			lba = next_lba;
+			lba_count = _spdk_bs_cluster_to_lba(bs, 1);
+		}
+		if (lba_count > 0) {
+			spdk_bs_batch_unmap_dev(batch, lba, lba_count);
+		}
+	}
+
+	spdk_bs_batch_close(batch);
 }
 
-void
-spdk_blob_sync_md(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg)
+static void
+_spdk_blob_release_clusters_sync_cpl(void *cb_arg, int bserrno)
 {
-	_spdk_blob_verify_md_op(blob);
-
-	SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Syncing blob %lu\n", blob->id);
+	struct spdk_blob *blob = cb_arg;
 
-	if (blob->md_ro) {
-		assert(blob->state == SPDK_BLOB_STATE_CLEAN);
-		cb_fn(cb_arg, 0);
+	if (bserrno != 0) {
+		/* The clusters may still be referred to on disk, so keep them
+		 * claimed. They are released when the blobstore is loaded again.
+		 */
+		SPDK_ERRLOG("Failed to sync metadata of blob 0x%" PRIx64 " after releasing clusters\n",
+			    blob->id);
+		_spdk_blob_releases_done(blob, bserrno);
 		return;
 	}
 
-	_spdk_blob_sync_md(blob, cb_fn, cb_arg);
+	/* I/O on other threads may still be using the old cluster map. Wait for
+	 * all channels before the clusters are unmapped and can be reallocated.
+	 */
+	spdk_for_each_channel(blob->bs, _spdk_blob_io_sync, blob,
+			      _spdk_blob_release_clusters_barrier_cpl);
 }
 
-/* END spdk_blob_sync_md */
-
-struct spdk_blob_insert_cluster_ctx {
-	struct spdk_thread	*thread;
-	struct spdk_blob	*blob;
-	uint32_t		cluster_num;	/* cluster index in blob */
-	uint32_t		cluster;	/* cluster on disk */
-	int			rc;
-	spdk_blob_op_complete	cb_fn;
-	void			*cb_arg;
-};
-
+/* Take the clusters of all pending releases out of the cluster map and sync the
+ * metadata once for all of them. Metadata writes of the blob already in flight
+ * are waited for, so that the one issued here is the first to see the clusters
+ * gone, and releases arriving meanwhile are batched up for the next sync.
+ */
 static void
-_spdk_blob_insert_cluster_msg_cpl(void *arg)
+_spdk_blob_submit_releases(struct spdk_blob *blob)
 {
-	struct spdk_blob_insert_cluster_ctx *ctx = arg;
+	struct spdk_blob_release_ctx *ctx;
+	uint64_t i;
+	bool changed = false;
 
-	ctx->cb_fn(ctx->cb_arg, ctx->rc);
-	free(ctx);
-}
+	if (blob->persists_in_progress > 0 || !TAILQ_EMPTY(&blob->inflight_releases) ||
+	    TAILQ_EMPTY(&blob->pending_releases)) {
+		return;
+	}
 
-static void
-_spdk_blob_insert_cluster_msg_cb(void *arg, int bserrno)
-{
-	struct spdk_blob_insert_cluster_ctx *ctx = arg;
+	TAILQ_SWAP(&blob->inflight_releases, &blob->pending_releases, spdk_blob_release_ctx, link);
 
-	ctx->rc = bserrno;
-	spdk_thread_send_msg(ctx->thread, _spdk_blob_insert_cluster_msg_cpl, ctx);
-}
+	TAILQ_FOREACH(ctx, &blob->inflight_releases, link) {
+		if (!_spdk_blob_can_release_clusters(blob) || blob->data_ro ||
+		    ctx->end_cluster > blob->active.num_clusters) {
+			ctx->md_rc = -EBUSY;
+			continue;
+		}
 
-static void
-_spdk_blob_insert_cluster_msg(void *arg)
-{
-	struct spdk_blob_insert_cluster_ctx *ctx = arg;
+		ctx->released = calloc(ctx->end_cluster - ctx->start_cluster, sizeof(*ctx->released));
+		if (ctx->released == NULL) {
+			ctx->md_rc = -EBUSY;
+			continue;
+		}
 
-	ctx->rc = _spdk_blob_insert_cluster(ctx->blob, ctx->cluster_num, ctx->cluster);
-	if (ctx->rc != 0) {
-		spdk_thread_send_msg(ctx->thread, _spdk_blob_insert_cluster_msg_cpl, ctx);
+		for (i = ctx->start_cluster; i < ctx->end_cluster; i++) {
+			if (blob->active.clusters[i] == 0) {
+				continue;
+			}
+
+			ctx->released[ctx->num_released++] = _spdk_bs_lba_to_cluster(blob->bs,
+							     blob->active.clusters[i]);
+			blob->active.clusters[i] = 0;
+			_spdk_blob_set_subcluster_mask(blob, i, 0);
+		}
+
+		changed |= ctx->num_released > 0;
+	}
+
+	if (!changed) {
+		_spdk_blob_releases_done(blob, 0);
 		return;
 	}
 
-	ctx->blob->state = SPDK_BLOB_STATE_DIRTY;
-	_spdk_blob_sync_md(ctx->blob, _spdk_blob_insert_cluster_msg_cb, ctx);
+	SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Syncing blob %lu to release clusters\n", blob->id);
+
+	blob->state = SPDK_BLOB_STATE_DIRTY;
+	_spdk_blob_sync_md(blob, _spdk_blob_release_clusters_sync_cpl, blob);
 }
 
 static void
-_spdk_blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
-				       uint64_t cluster, spdk_blob_op_complete cb_fn, void *cb_arg)
+_spdk_blob_release_clusters_msg(void *arg)
 {
-	struct spdk_blob_insert_cluster_ctx *ctx;
-
-	ctx = calloc(1, sizeof(*ctx));
-	if (ctx == NULL) {
-		cb_fn(cb_arg, -ENOMEM);
-		return;
-	}
-
-	ctx->thread = spdk_get_thread();
-	ctx->blob = blob;
-	ctx->cluster_num = cluster_num;
-	ctx->cluster = cluster;
-	ctx->cb_fn = cb_fn;
-	ctx->cb_arg = cb_arg;
+	struct spdk_blob_release_ctx *ctx = arg;
+	struct spdk_blob *blob = ctx->blob;
 
-	spdk_thread_send_msg(blob->bs->md_thread, _spdk_blob_insert_cluster_msg, ctx);
+	TAILQ_INSERT_TAIL(&blob->pending_releases, ctx, link);
+	_spdk_blob_submit_releases(blob);
 }
 
 /* START spdk_blob_close */
@@ -5884,7 +9518,7 @@ _spdk_blob_close_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 			 *  remove them again.
 			 */
 			if (blob->active.num_pages > 0) {
-				TAILQ_REMOVE(&blob->bs->blobs, blob, link);
+				_spdk_bs_remove_open_blob(blob->bs, blob);
 			}
 			_spdk_blob_free(blob);
 		}
@@ -5893,11 +9527,49 @@ _spdk_blob_close_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	spdk_bs_sequence_finish(seq, bserrno);
 }
 
-void spdk_blob_close(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg)
+static void
+_spdk_blob_close(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_bs_cpl	cpl;
 	spdk_bs_sequence_t	*seq;
 
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = cb_fn;
+	cpl.u.blob_basic.cb_arg = cb_arg;
+
+	seq = spdk_bs_sequence_start(blob->bs->md_channel, &cpl);
+	if (!seq) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	/* Sync metadata */
+	_spdk_blob_persist(seq, blob, _spdk_blob_close_cpl, blob);
+}
+
+struct spdk_blob_close_ctx {
+	struct spdk_blob	*blob;
+	spdk_blob_op_complete	cb_fn;
+	void			*cb_arg;
+};
+
+static void
+_spdk_blob_close_put_back_channels_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_close_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		ctx->cb_fn(ctx->cb_arg, bserrno);
+	} else {
+		_spdk_blob_close(ctx->blob, ctx->cb_fn, ctx->cb_arg);
+	}
+	free(ctx);
+}
+
+void spdk_blob_close(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_close_ctx *ctx;
+
 	_spdk_blob_verify_md_op(blob);
 
 	SPDK_DEBUGLOG(SPDK_LOG_BLOB, "Closing blob %lu\n", blob->id);
@@ -5907,18 +9579,22 @@ void spdk_blob_close(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *
 		return;
 	}
 
-	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
-	cpl.u.blob_basic.cb_fn = cb_fn;
-	cpl.u.blob_basic.cb_arg = cb_arg;
+	if (blob->open_ref == 1 && _spdk_bs_dev_uses_channels(blob->back_bs_dev)) {
+		/* The external snapshot device goes away with the last reference */
+		ctx = calloc(1, sizeof(*ctx));
+		if (ctx == NULL) {
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
 
-	seq = spdk_bs_sequence_start(blob->bs->md_channel, &cpl);
-	if (!seq) {
-		cb_fn(cb_arg, -ENOMEM);
+		ctx->blob = blob;
+		ctx->cb_fn = cb_fn;
+		ctx->cb_arg = cb_arg;
+		_spdk_blob_put_back_channels(blob, _spdk_blob_close_put_back_channels_cpl, ctx);
 		return;
 	}
 
-	/* Sync metadata */
-	_spdk_blob_persist(seq, blob, _spdk_blob_close_cpl, blob);
+	_spdk_blob_close(blob, cb_fn, cb_arg);
 }
 
 /* END spdk_blob_close */
@@ -6062,6 +9738,108 @@ spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *blob,
 	spdk_blob_close(blob, _spdk_bs_iter_close_cpl, ctx);
 }
 
+struct spdk_bs_for_each_blob_ctx {
+	struct spdk_blob_store *bs;
+	int64_t page_num;
+	uint32_t queue_depth;
+	uint32_t outstanding;
+	bool submitting;
+	int bserrno;
+
+	spdk_blob_iter_fn fn;
+	spdk_bs_op_complete cb_fn;
+	void *cb_arg;
+};
+
+static void _spdk_bs_for_each_blob_submit(struct spdk_bs_for_each_blob_ctx *ctx);
+
+static void
+_spdk_bs_for_each_blob_close_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_for_each_blob_ctx *ctx = cb_arg;
+
+	if (bserrno != 0 && ctx->bserrno == 0) {
+		ctx->bserrno = bserrno;
+	}
+
+	ctx->outstanding--;
+	_spdk_bs_for_each_blob_submit(ctx);
+}
+
+static void
+_spdk_bs_for_each_blob_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct spdk_bs_for_each_blob_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		/* Skip blobs that can't be opened, the same as spdk_bs_iter_next() does */
+		ctx->outstanding--;
+		_spdk_bs_for_each_blob_submit(ctx);
+		return;
+	}
+
+	if (ctx->bserrno == 0) {
+		ctx->bserrno = ctx->fn(ctx->cb_arg, blob);
+	}
+
+	spdk_blob_close(blob, _spdk_bs_for_each_blob_close_cpl, ctx);
+}
+
+static void
+_spdk_bs_for_each_blob_submit(struct spdk_bs_for_each_blob_ctx *ctx)
+{
+	struct spdk_blob_store *bs = ctx->bs;
+	uint32_t capacity = spdk_bit_array_capacity(bs->used_blobids);
+
+	/* Opens may complete inline, let the outermost call do the submitting */
+	if (ctx->submitting) {
+		return;
+	}
+
+	ctx->submitting = true;
+	while (ctx->bserrno == 0 && ctx->outstanding < ctx->queue_depth &&
+	       ctx->page_num < capacity) {
+		ctx->page_num = spdk_bit_array_find_first_set(bs->used_blobids, ctx->page_num + 1);
+		if (ctx->page_num >= capacity) {
+			break;
+		}
+
+		ctx->outstanding++;
+		spdk_bs_open_blob(bs, _spdk_bs_page_to_blobid(ctx->page_num),
+				  _spdk_bs_for_each_blob_open_cpl, ctx);
+	}
+	ctx->submitting = false;
+
+	if (ctx->outstanding == 0) {
+		ctx->cb_fn(ctx->cb_arg, ctx->bserrno);
+		free(ctx);
+	}
+}
+
+void
+spdk_bs_for_each_blob(struct spdk_blob_store *bs, uint32_t queue_depth,
+		      spdk_blob_iter_fn fn, spdk_bs_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_bs_for_each_blob_ctx *ctx;
+
+	assert(queue_depth > 0);
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->bs = bs;
+	ctx->page_num = -1;
+	ctx->queue_depth = queue_depth;
+	ctx->fn = fn;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	_spdk_bs_for_each_blob_submit(ctx);
+}
+
 static int
 _spdk_blob_set_xattr(struct spdk_blob *blob, const char *name, const void *value,
 		     uint16_t value_len, bool internal)
@@ -6297,6 +10075,25 @@ spdk_blob_is_clone(struct spdk_blob *blob)
 	return false;
 }
 
+bool
+spdk_blob_is_esnap_clone(const struct spdk_blob *blob)
+{
+	assert(blob != NULL);
+	return !!(blob->invalid_flags & SPDK_BLOB_EXTERNAL_SNAPSHOT);
+}
+
+int
+spdk_blob_get_esnap_id(struct spdk_blob *blob, const void **id, size_t *len)
+{
+	assert(blob != NULL);
+
+	if (!spdk_blob_is_esnap_clone(blob)) {
+		return -EINVAL;
+	}
+
+	return _spdk_blob_get_xattr_value(blob, BLOB_EXTERNAL_SNAPSHOT_ID, id, len, true);
+}
+
 bool
 spdk_blob_is_thin_provisioned(struct spdk_blob *blob)
 {
@@ -6307,18 +10104,14 @@ spdk_blob_is_thin_provisioned(struct spdk_blob *blob)
 spdk_blob_id
 spdk_blob_get_parent_snapshot(struct spdk_blob_store *bs, spdk_blob_id blob_id)
 {
-	struct spdk_blob_list *snapshot_entry = NULL;
-	struct spdk_blob_list *clone_entry = NULL;
+	struct spdk_blob_list *clone_entry;
 
-	TAILQ_FOREACH(snapshot_entry, &bs->snapshots, link) {
-		TAILQ_FOREACH(clone_entry, &snapshot_entry->clones, link) {
-			if (clone_entry->id == blob_id) {
-				return snapshot_entry->id;
-			}
-		}
+	clone_entry = _spdk_bs_get_clone_entry(bs, blob_id);
+	if (clone_entry == NULL) {
+		return SPDK_BLOBID_INVALID;
 	}
 
-	return SPDK_BLOBID_INVALID;
+	return clone_entry->parent->id;
 }
 
 int
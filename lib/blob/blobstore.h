@@ -52,6 +52,9 @@
 #define SPDK_BLOB_OPTS_DEFAULT_CHANNEL_OPS 512
 #define SPDK_BLOB_BLOBID_HIGH_BIT (1ULL << 32)
 
+/* Blobs using sub-cluster copy-on-write track at most this many parts of each cluster */
+#define SPDK_BLOB_MAX_SUBCLUSTERS 64
+
 struct spdk_xattr {
 	uint32_t	index;
 	uint16_t	value_len;
@@ -84,6 +87,21 @@ struct spdk_blob_mut_data {
 	 * the order of the metadata page sequence.
 	 */
 	uint32_t	*pages;
+
+	/* Number of extent pages. Only used by blobs with an extent table. */
+	uint64_t	num_extent_pages;
+
+	/* Array of metadata page offsets of the extent pages, in the
+	 * order of the clusters they describe. An entry of 0 means
+	 * that none of the clusters in that range has been allocated
+	 * yet, so no extent page was needed.
+	 */
+	uint32_t	*extent_pages;
+
+	/* The size of the extent_pages array. This is greater than or
+	 * equal to 'num_extent_pages'.
+	 */
+	size_t		extent_pages_array_size;
 };
 
 enum spdk_blob_state {
@@ -104,11 +122,30 @@ enum spdk_blob_state {
 
 TAILQ_HEAD(spdk_xattr_tailq, spdk_xattr);
 
+/* Entry of a hash table indexed by blob id, embedded in the indexed object */
+struct spdk_blob_hash_entry {
+	spdk_blob_id				id;
+	LIST_ENTRY(spdk_blob_hash_entry)	link;
+};
+
+LIST_HEAD(spdk_blob_hash_bucket, spdk_blob_hash_entry);
+
+/* The bucket array doubles whenever there are more entries than buckets */
+struct spdk_blob_hash {
+	struct spdk_blob_hash_bucket	*buckets;
+	uint32_t			mask;
+	uint32_t			count;
+};
+
 struct spdk_blob_list {
 	spdk_blob_id id;
 	size_t clone_count;
 	TAILQ_HEAD(, spdk_blob_list) clones;
 	TAILQ_ENTRY(spdk_blob_list) link;
+
+	/* For clone entries, the snapshot entry whose clones list holds this entry */
+	struct spdk_blob_list *parent;
+	struct spdk_blob_hash_entry hash_entry;
 };
 
 struct spdk_blob {
@@ -132,6 +169,8 @@ struct spdk_blob {
 	bool		invalid;
 	bool		data_ro;
 	bool		md_ro;
+	bool		use_extent_table;
+	bool		use_subcluster_cow;
 
 	uint64_t	invalid_flags;
 	uint64_t	data_ro_flags;
@@ -139,6 +178,29 @@ struct spdk_blob {
 
 	struct spdk_bs_dev *back_bs_dev;
 
+	/* For blobs using sub-cluster copy-on-write, a mask per allocated cluster
+	 * of the sub-clusters that were not copied from the parent yet, indexed
+	 * like active.clusters. Clusters past the end of the array, or with a
+	 * zero mask, hold all of their data.
+	 */
+	uint64_t	*subcluster_masks;
+	size_t		subcluster_mask_array_size;
+
+	/* Clusters with a sub-cluster copy in progress. Only accessed on the
+	 * metadata thread.
+	 */
+	TAILQ_HEAD(, spdk_blob_copy_cluster_ctx) cow_claims;
+
+	/* Whole-cluster unmaps and write zeroes releasing clusters of a thin
+	 * provisioned blob. Pending ones wait until no metadata write of the
+	 * blob is in flight, then all of them are synced at once. Their clusters
+	 * go back to the blobstore once the metadata no longer refers to them.
+	 * Only accessed on the metadata thread.
+	 */
+	TAILQ_HEAD(, spdk_blob_release_ctx) pending_releases;
+	TAILQ_HEAD(, spdk_blob_release_ctx) inflight_releases;
+	uint32_t	persists_in_progress;
+
 	/* TODO: The xattrs are mutable, but we don't want to be
 	 * copying them unnecessarily. Figure this out.
 	 */
@@ -146,10 +208,14 @@ struct spdk_blob {
 	struct spdk_xattr_tailq xattrs_internal;
 
 	TAILQ_ENTRY(spdk_blob) link;
+	struct spdk_blob_hash_entry hash_entry;
 
 	uint32_t frozen_refcnt;
 	bool locked_operation_in_progress;
 	enum blob_clear_method clear_method;
+
+	/* Inflate, decouple parent or shallow copy in progress, if any */
+	struct spdk_blob_bg_copy *bg_copy;
 };
 
 struct spdk_blob_store {
@@ -173,7 +239,12 @@ struct spdk_blob_store {
 	uint64_t			total_clusters;
 	uint64_t			total_data_clusters;
 	uint64_t			num_free_clusters;
+	/* Clusters claimed in used_clusters, but still unused in channel pools */
+	uint64_t			num_reserved_clusters;
 	uint64_t			pages_per_cluster;
+	/* Pages covered by each bit of a sub-cluster mask */
+	uint64_t			pages_per_subcluster;
+	uint32_t			subclusters_per_cluster;
 	uint32_t			io_unit_size;
 
 	spdk_blob_id			super_blob;
@@ -185,9 +256,76 @@ struct spdk_blob_store {
 	TAILQ_HEAD(, spdk_blob)		blobs;
 	TAILQ_HEAD(, spdk_blob_list)	snapshots;
 
+	/* Open blobs, snapshot entries and clone entries indexed by blob id */
+	struct spdk_blob_hash		open_blobs;
+	struct spdk_blob_hash		snapshot_hash;
+	struct spdk_blob_hash		clone_hash;
+
+	/* Creates the devices external snapshot clones read their parent data from */
+	spdk_bs_esnap_dev_create	esnap_bs_dev_create;
+	void				*esnap_ctx;
+
+	/* Changed on the metadata thread whenever the snapshots a blob is cloned
+	 * from, or the clusters they hold, may have changed. Invalidates the
+	 * cluster locations cached by all channels.
+	 */
+	uint64_t			topology_gen;
+
+	/* Metadata page writes waiting for the next group commit. Only one group
+	 * commit is written at a time; writes submitted meanwhile wait for the
+	 * next one, or for the commit window to expire when nothing is in flight.
+	 */
+	TAILQ_HEAD(, spdk_bs_md_commit)	md_commits;
+	bool				md_commit_inflight;
+	struct spdk_poller		*md_commit_poller;
+	uint32_t			md_commit_window_us;
+
 	bool                            clean;
 };
 
+/* Number of clusters an I/O channel claims at once for thin provisioned writes */
+#define SPDK_BS_CHANNEL_CLUSTER_POOL_SIZE 16
+
+/* Number of cluster locations cached by each I/O channel */
+#define SPDK_BS_CHANNEL_LOCATION_CACHE_SIZE 256
+
+/* Maximum number of adjacent metadata pages merged into a single group commit write */
+#define SPDK_BS_MD_COMMIT_MAX_RUN 32
+
+/* A metadata page to be written, and its offset in the metadata region */
+struct spdk_bs_md_write {
+	struct spdk_blob_md_page	*page;
+	uint32_t			page_idx;
+
+	/* Submission order within the group commit */
+	uint32_t			order;
+};
+
+/* Metadata page writes of one step of a metadata update. All of them are on
+ * disk when cb_fn is called.
+ */
+struct spdk_bs_md_commit {
+	spdk_bs_sequence_t		*seq;
+	spdk_bs_sequence_cpl		cb_fn;
+	void				*cb_arg;
+
+	struct spdk_bs_md_write		*writes;
+	uint32_t			num_writes;
+
+	TAILQ_ENTRY(spdk_bs_md_commit)	link;
+};
+
+/* Where the data of a cluster a blob does not hold itself is read from */
+struct spdk_bs_cluster_location {
+	const struct spdk_blob		*blob;
+	uint64_t			cluster_num;
+	uint64_t			topology_gen;
+
+	/* Device and LBA of the start of the cluster, NULL for the blobstore device */
+	struct spdk_bs_dev		*dev;
+	uint64_t			lba;
+};
+
 struct spdk_bs_channel {
 	struct spdk_bs_request_set	*req_mem;
 	TAILQ_HEAD(, spdk_bs_request_set) reqs;
@@ -197,8 +335,40 @@ struct spdk_bs_channel {
 	struct spdk_bs_dev		*dev;
 	struct spdk_io_channel		*dev_channel;
 
-	TAILQ_HEAD(, spdk_bs_request_set) need_cluster_alloc;
+	/* Clusters claimed in bulk from used_clusters, handed out to thin
+	 * provisioned writes on this channel without taking used_clusters_mutex.
+	 */
+	uint32_t			cluster_pool[SPDK_BS_CHANNEL_CLUSTER_POOL_SIZE];
+	uint32_t			cluster_pool_count;
+
+	/* Cluster allocations in progress on this channel */
+	TAILQ_HEAD(, spdk_blob_copy_cluster_ctx) pending_allocs;
+
+	/* Allocated clusters waiting to be inserted into the blob metadata.
+	 * Only one batch of them is handed to the metadata thread at a time.
+	 */
+	TAILQ_HEAD(, spdk_blob_insert_cluster_ctx) pending_inserts;
+	TAILQ_HEAD(, spdk_blob_insert_cluster_ctx) inflight_inserts;
+	uint32_t			inflight_insert_ops;
+	bool				insert_in_progress;
+
 	TAILQ_HEAD(, spdk_bs_request_set) queued_io;
+
+	/* Channels of external snapshot devices used on this channel, created on
+	 * first read and put when the blob owning the device is closed.
+	 */
+	TAILQ_HEAD(, spdk_bs_back_channel) back_channels;
+
+	/* Unallocated clusters of clones resolved to the snapshot or external
+	 * snapshot holding their data, indexed by a hash of blob and cluster.
+	 */
+	struct spdk_bs_cluster_location	location_cache[SPDK_BS_CHANNEL_LOCATION_CACHE_SIZE];
+};
+
+struct spdk_bs_back_channel {
+	struct spdk_bs_dev		*dev;
+	struct spdk_io_channel		*channel;
+	TAILQ_ENTRY(spdk_bs_back_channel) link;
 };
 
 /** operation type */
@@ -216,6 +386,7 @@ enum spdk_blob_op_type {
 #define BLOB_SNAPSHOT "SNAP"
 #define SNAPSHOT_IN_PROGRESS "SNAPTMP"
 #define SNAPSHOT_PENDING_REMOVAL "SNAPRM"
+#define BLOB_EXTERNAL_SNAPSHOT_ID "EXTSNAP"
 
 struct spdk_blob_bs_dev {
 	struct spdk_bs_dev bs_dev;
@@ -246,6 +417,9 @@ struct spdk_bs_md_mask {
 #define SPDK_MD_DESCRIPTOR_TYPE_XATTR 2
 #define SPDK_MD_DESCRIPTOR_TYPE_FLAGS 3
 #define SPDK_MD_DESCRIPTOR_TYPE_XATTR_INTERNAL 4
+#define SPDK_MD_DESCRIPTOR_TYPE_EXTENT_TABLE 5
+#define SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE 6
+#define SPDK_MD_DESCRIPTOR_TYPE_SUBCLUSTER_MASK 7
 
 struct spdk_blob_md_descriptor_xattr {
 	uint8_t		type;
@@ -268,9 +442,59 @@ struct spdk_blob_md_descriptor_extent {
 	} extents[0];
 };
 
+/*
+ * Blobs with an extent table keep their cluster map in separate extent pages,
+ *  each describing SPDK_EXTENTS_PER_EP clusters. The metadata page chain only
+ *  holds the table of extent page offsets, so allocating a cluster only
+ *  requires rewriting the extent page that covers it.
+ */
+struct spdk_blob_md_descriptor_extent_table {
+	uint8_t		type;
+	uint32_t	length;
+
+	/* Number of data clusters in the blob */
+	uint64_t	num_clusters;
+
+	struct {
+		uint32_t	page_idx; /* 0 if the extent pages are not allocated */
+		uint32_t	num_pages; /* In units of extent pages */
+	} extent_page[0];
+};
+
+struct spdk_blob_md_descriptor_extent_page {
+	uint8_t		type;
+	uint32_t	length;
+
+	/* Index of the first cluster in the blob described by this page */
+	uint32_t	start_cluster_idx;
+	uint32_t	cluster_idx[0]; /* 0 if the cluster is not allocated */
+};
+
+#define SPDK_EXTENTS_PER_EP 512
+
+/*
+ * Allocated clusters of a blob using sub-cluster copy-on-write, that still
+ *  read some of their sub-clusters from the parent. A set bit means the
+ *  sub-cluster was not copied yet. Clusters not listed hold all of their data.
+ */
+struct spdk_blob_md_descriptor_subcluster_mask {
+	uint8_t		type;
+	uint32_t	length;
+
+	struct {
+		uint32_t	cluster_idx; /* Index of the cluster in the blob */
+		uint64_t	mask;
+	} clusters[0];
+};
+
 #define SPDK_BLOB_THIN_PROV (1ULL << 0)
 #define SPDK_BLOB_INTERNAL_XATTR (1ULL << 1)
-#define SPDK_BLOB_INVALID_FLAGS_MASK	(SPDK_BLOB_THIN_PROV | SPDK_BLOB_INTERNAL_XATTR)
+#define SPDK_BLOB_EXTENT_TABLE (1ULL << 2)
+#define SPDK_BLOB_SUBCLUSTER_COW (1ULL << 3)
+#define SPDK_BLOB_EXTERNAL_SNAPSHOT (1ULL << 4)
+#define SPDK_BLOB_INVALID_FLAGS_MASK	(SPDK_BLOB_THIN_PROV | SPDK_BLOB_INTERNAL_XATTR | \
+					 SPDK_BLOB_EXTENT_TABLE | SPDK_BLOB_SUBCLUSTER_COW | \
+					 SPDK_BLOB_EXTERNAL_SNAPSHOT)
 
 #define SPDK_BLOB_READ_ONLY (1ULL << 0)
 #define SPDK_BLOB_DATA_RO_FLAGS_MASK	SPDK_BLOB_READ_ONLY
@@ -322,6 +546,9 @@ struct spdk_blob_md_page {
 SPDK_STATIC_ASSERT(SPDK_BS_PAGE_SIZE == sizeof(struct spdk_blob_md_page), "Invalid md page size");
 
 #define SPDK_BS_MAX_DESC_SIZE sizeof(((struct spdk_blob_md_page*)0)->descriptors)
+SPDK_STATIC_ASSERT(sizeof(struct spdk_blob_md_descriptor_extent_page) +
+		   SPDK_EXTENTS_PER_EP * sizeof(uint32_t) <= SPDK_BS_MAX_DESC_SIZE,
+		   "Invalid number of extents per extent page");
 
 #define SPDK_BS_SUPER_BLOCK_SIG "SPDKBLOB"
 
@@ -360,6 +587,8 @@ SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_super_block) == 0x1000, "Invalid super
 
 struct spdk_bs_dev *spdk_bs_create_zeroes_dev(void);
 struct spdk_bs_dev *spdk_bs_create_blob_bs_dev(struct spdk_blob *blob);
+struct spdk_io_channel *spdk_bs_channel_get_back_channel(struct spdk_bs_channel *channel,
+		struct spdk_bs_dev *back_bs_dev);
 
 /* Unit Conversions
  *
@@ -452,6 +681,20 @@ _spdk_bs_io_unit_to_back_dev_lba(struct spdk_blob *blob, uint64_t io_unit)
 	return io_unit * (blob->bs->io_unit_size / blob->back_bs_dev->blocklen);
 }
 
+/* Given a number of io_units, look up the number of LBAs they take on a device,
+ * where a NULL device stands for the blobstore device.
+ */
+static inline uint64_t
+_spdk_bs_io_units_to_dev_lba(struct spdk_blob_store *bs, struct spdk_bs_dev *dev,
+			     uint64_t io_units)
+{
+	if (dev == NULL) {
+		return io_units;
+	}
+
+	return io_units * (bs->io_unit_size / dev->blocklen);
+}
+
 static inline uint64_t
 _spdk_bs_back_dev_lba_to_io_unit(struct spdk_blob *blob, uint64_t lba)
 {
@@ -460,6 +703,16 @@ _spdk_bs_back_dev_lba_to_io_unit(struct spdk_blob *blob, uint64_t lba)
 
 /* End basic conversions */
 
+/* Check if unallocated clusters of the blob are read from a parent, either
+ * a snapshot in this blobstore or an external snapshot.
+ */
+static inline bool
+_spdk_blob_has_parent(struct spdk_blob *blob)
+{
+	return blob->parent_id != SPDK_BLOBID_INVALID ||
+	       (blob->invalid_flags & SPDK_BLOB_EXTERNAL_SNAPSHOT) != 0;
+}
+
 static inline uint64_t
 _spdk_bs_blobid_to_page(spdk_blob_id id)
 {
@@ -573,4 +826,115 @@ _spdk_bs_io_unit_is_allocated(struct spdk_blob *blob, uint64_t io_unit)
 	}
 }
 
+static inline uint64_t
+_spdk_bs_io_units_per_subcluster(struct spdk_blob_store *bs)
+{
+	return bs->pages_per_subcluster * _spdk_bs_io_unit_per_page(bs);
+}
+
+/* Mask with a bit set for every sub-cluster of a cluster */
+static inline uint64_t
+_spdk_bs_subcluster_full_mask(struct spdk_blob_store *bs)
+{
+	if (bs->subclusters_per_cluster == SPDK_BLOB_MAX_SUBCLUSTERS) {
+		return UINT64_MAX;
+	}
+
+	return (1ULL << bs->subclusters_per_cluster) - 1;
+}
+
+/* Given a cluster index into a blob, look up the sub-clusters that were not copied yet. */
+static inline uint64_t
+_spdk_blob_subcluster_mask(const struct spdk_blob *blob, uint64_t cluster_num)
+{
+	if (cluster_num >= blob->subcluster_mask_array_size) {
+		return 0;
+	}
+
+	return blob->subcluster_masks[cluster_num];
+}
+
+/* Given an io unit offset into a blob, look up if its data is held by the blob
+ * itself, rather than by the backing device.
+ */
+static inline bool
+_spdk_bs_io_unit_is_valid(struct spdk_blob *blob, uint64_t io_unit)
+{
+	uint64_t	mask;
+	uint64_t	io_units_per_cluster;
+
+	if (!_spdk_bs_io_unit_is_allocated(blob, io_unit)) {
+		return false;
+	}
+
+	mask = _spdk_blob_subcluster_mask(blob, _spdk_bs_io_unit_to_cluster_number(blob, io_unit));
+	if (mask == 0) {
+		return true;
+	}
+
+	io_units_per_cluster = _spdk_bs_io_unit_per_page(blob->bs) * blob->bs->pages_per_cluster;
+
+	return !(mask & (1ULL << ((io_unit % io_units_per_cluster) /
+				  _spdk_bs_io_units_per_subcluster(blob->bs))));
+}
+
+/* Given an io unit offset into a blob, look up if writing there first requires
+ * allocating its cluster or copying data from the backing device. A zero length
+ * write touches the whole cluster, so that it gets all of its data copied.
+ */
+static inline bool
+_spdk_blob_io_unit_needs_copy(struct spdk_blob *blob, uint64_t io_unit, uint64_t length)
+{
+	if (!_spdk_bs_io_unit_is_allocated(blob, io_unit)) {
+		return true;
+	}
+
+	if (length == 0) {
+		return _spdk_blob_subcluster_mask(blob,
+						  _spdk_bs_io_unit_to_cluster_number(blob, io_unit)) != 0;
+	}
+
+	return !_spdk_bs_io_unit_is_valid(blob, io_unit);
+}
+
+/* Given an io_unit offset into a blob, look up the number of io_units until the
+ * next cluster boundary, or until the data switches between the blob and the
+ * backing device within a partially copied cluster.
+ */
+static inline uint32_t
+_spdk_bs_num_io_units_to_valid_boundary(struct spdk_blob *blob, uint64_t io_unit)
+{
+	uint64_t	io_units_per_cluster;
+	uint64_t	io_units_per_subcluster;
+	uint64_t	to_boundary;
+	uint64_t	count;
+	uint64_t	mask;
+	uint64_t	missing;
+	uint32_t	subcluster;
+
+	to_boundary = _spdk_bs_num_io_units_to_cluster_boundary(blob, io_unit);
+
+	if (!_spdk_bs_io_unit_is_allocated(blob, io_unit)) {
+		return to_boundary;
+	}
+
+	mask = _spdk_blob_subcluster_mask(blob, _spdk_bs_io_unit_to_cluster_number(blob, io_unit));
+	if (mask == 0) {
+		return to_boundary;
+	}
+
+	io_units_per_cluster = _spdk_bs_io_unit_per_page(blob->bs) * blob->bs->pages_per_cluster;
+	io_units_per_subcluster = _spdk_bs_io_units_per_subcluster(blob->bs);
+
+	subcluster = (io_unit % io_units_per_cluster) / io_units_per_subcluster;
+	missing = (mask >> subcluster) & 1;
+	count = (subcluster + 1) * io_units_per_subcluster - (io_unit % io_units_per_cluster);
+
+	for (subcluster++; count < to_boundary && ((mask >> subcluster) & 1) == missing; subcluster++) {
+		count += io_units_per_subcluster;
+	}
+
+	return spdk_min(count, to_boundary);
+}
+
 #endif
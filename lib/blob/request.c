@@ -132,6 +132,7 @@ spdk_bs_sequence_read_bs_dev(spdk_bs_sequence_t *seq, struct spdk_bs_dev *bs_dev
 {
 	struct spdk_bs_request_set      *set = (struct spdk_bs_request_set *)seq;
 	struct spdk_bs_channel       *channel = set->channel;
+	struct spdk_io_channel       *back_channel;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BLOB_RW, "Reading %" PRIu32 " blocks from LBA %" PRIu64 "\n", lba_count,
 		      lba);
@@ -139,7 +140,13 @@ spdk_bs_sequence_read_bs_dev(spdk_bs_sequence_t *seq, struct spdk_bs_dev *bs_dev
 	set->u.sequence.cb_fn = cb_fn;
 	set->u.sequence.cb_arg = cb_arg;
 
-	bs_dev->read(bs_dev, spdk_io_channel_from_ctx(channel), payload, lba, lba_count, &set->cb_args);
+	back_channel = spdk_bs_channel_get_back_channel(channel, bs_dev);
+	if (back_channel == NULL) {
+		set->cb_args.cb_fn(set->cb_args.channel, set->cb_args.cb_arg, -ENOMEM);
+		return;
+	}
+
+	bs_dev->read(bs_dev, back_channel, payload, lba, lba_count, &set->cb_args);
 }
 
 void
@@ -184,6 +191,7 @@ spdk_bs_sequence_readv_bs_dev(spdk_bs_sequence_t *seq, struct spdk_bs_dev *bs_de
 {
 	struct spdk_bs_request_set      *set = (struct spdk_bs_request_set *)seq;
 	struct spdk_bs_channel       *channel = set->channel;
+	struct spdk_io_channel       *back_channel;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BLOB_RW, "Reading %" PRIu32 " blocks from LBA %" PRIu64 "\n", lba_count,
 		      lba);
@@ -191,8 +199,13 @@ spdk_bs_sequence_readv_bs_dev(spdk_bs_sequence_t *seq, struct spdk_bs_dev *bs_de
 	set->u.sequence.cb_fn = cb_fn;
 	set->u.sequence.cb_arg = cb_arg;
 
-	bs_dev->readv(bs_dev, spdk_io_channel_from_ctx(channel), iov, iovcnt, lba, lba_count,
-		      &set->cb_args);
+	back_channel = spdk_bs_channel_get_back_channel(channel, bs_dev);
+	if (back_channel == NULL) {
+		set->cb_args.cb_fn(set->cb_args.channel, set->cb_args.cb_arg, -ENOMEM);
+		return;
+	}
+
+	bs_dev->readv(bs_dev, back_channel, iov, iovcnt, lba, lba_count, &set->cb_args);
 }
 
 void
@@ -340,12 +353,20 @@ spdk_bs_batch_read_bs_dev(spdk_bs_batch_t *batch, struct spdk_bs_dev *bs_dev,
 {
 	struct spdk_bs_request_set	*set = (struct spdk_bs_request_set *)batch;
 	struct spdk_bs_channel		*channel = set->channel;
+	struct spdk_io_channel		*back_channel;
 
 	SPDK_DEBUGLOG(SPDK_LOG_BLOB_RW, "Reading %" PRIu32 " blocks from LBA %" PRIu64 "\n", lba_count,
 		      lba);
 
 	set->u.batch.outstanding_ops++;
-	bs_dev->read(bs_dev, spdk_io_channel_from_ctx(channel), payload, lba, lba_count, &set->cb_args);
+
+	back_channel = spdk_bs_channel_get_back_channel(channel, bs_dev);
+	if (back_channel == NULL) {
+		set->cb_args.cb_fn(set->cb_args.channel, set->cb_args.cb_arg, -ENOMEM);
+		return;
+	}
+
+	bs_dev->read(bs_dev, back_channel, payload, lba, lba_count, &set->cb_args);
 }
 
 void
@@ -362,6 +383,43 @@ spdk_bs_batch_read_dev(spdk_bs_batch_t *batch, void *payload,
 	channel->dev->read(channel->dev, channel->dev_channel, payload, lba, lba_count, &set->cb_args);
 }
 
+void
+spdk_bs_batch_readv_bs_dev(spdk_bs_batch_t *batch, struct spdk_bs_dev *bs_dev,
+			   struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count)
+{
+	struct spdk_bs_request_set	*set = (struct spdk_bs_request_set *)batch;
+	struct spdk_bs_channel		*channel = set->channel;
+	struct spdk_io_channel		*back_channel;
+
+	SPDK_DEBUGLOG(SPDK_LOG_BLOB_RW, "Reading %" PRIu32 " blocks from LBA %" PRIu64 "\n", lba_count,
+		      lba);
+
+	set->u.batch.outstanding_ops++;
+
+	back_channel = spdk_bs_channel_get_back_channel(channel, bs_dev);
+	if (back_channel == NULL) {
+		set->cb_args.cb_fn(set->cb_args.channel, set->cb_args.cb_arg, -ENOMEM);
+		return;
+	}
+
+	bs_dev->readv(bs_dev, back_channel, iov, iovcnt, lba, lba_count, &set->cb_args);
+}
+
+void
+spdk_bs_batch_readv_dev(spdk_bs_batch_t *batch, struct iovec *iov, int iovcnt,
+			uint64_t lba, uint32_t lba_count)
+{
+	struct spdk_bs_request_set	*set = (struct spdk_bs_request_set *)batch;
+	struct spdk_bs_channel		*channel = set->channel;
+
+	SPDK_DEBUGLOG(SPDK_LOG_BLOB_RW, "Reading %" PRIu32 " blocks from LBA %" PRIu64 "\n", lba_count,
+		      lba);
+
+	set->u.batch.outstanding_ops++;
+	channel->dev->readv(channel->dev, channel->dev_channel, iov, iovcnt, lba, lba_count,
+			    &set->cb_args);
+}
+
 void
 spdk_bs_batch_write_dev(spdk_bs_batch_t *batch, void *payload,
 			uint64_t lba, uint32_t lba_count)
@@ -376,6 +434,20 @@ spdk_bs_batch_write_dev(spdk_bs_batch_t *batch, void *payload,
 			    &set->cb_args);
 }
 
+void
+spdk_bs_batch_writev_dev(spdk_bs_batch_t *batch, struct iovec *iov, int iovcnt,
+			 uint64_t lba, uint32_t lba_count)
+{
+	struct spdk_bs_request_set	*set = (struct spdk_bs_request_set *)batch;
+	struct spdk_bs_channel		*channel = set->channel;
+
+	SPDK_DEBUGLOG(SPDK_LOG_BLOB_RW, "Writing %" PRIu32 " blocks to LBA %" PRIu64 "\n", lba_count, lba);
+
+	set->u.batch.outstanding_ops++;
+	channel->dev->writev(channel->dev, channel->dev_channel, iov, iovcnt, lba, lba_count,
+			     &set->cb_args);
+}
+
 void
 spdk_bs_batch_unmap_dev(spdk_bs_batch_t *batch,
 			uint64_t lba, uint32_t lba_count)
@@ -531,16 +603,22 @@ spdk_bs_user_op_execute(spdk_bs_user_op_t *op)
 }
 
 void
-spdk_bs_user_op_abort(spdk_bs_user_op_t *op)
+spdk_bs_user_op_complete(spdk_bs_user_op_t *op, int bserrno)
 {
 	struct spdk_bs_request_set	*set;
 
 	set = (struct spdk_bs_request_set *)op;
 
-	set->cpl.u.blob_basic.cb_fn(set->cpl.u.blob_basic.cb_arg, -EIO);
+	set->cpl.u.blob_basic.cb_fn(set->cpl.u.blob_basic.cb_arg, bserrno);
 	TAILQ_INSERT_TAIL(&set->channel->reqs, set, link);
 }
 
+void
+spdk_bs_user_op_abort(spdk_bs_user_op_t *op)
+{
+	spdk_bs_user_op_complete(op, -EIO);
+}
+
 void
 spdk_bs_sequence_to_batch_completion(void *cb_arg, int bserrno)
 {
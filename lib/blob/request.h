@@ -193,9 +193,18 @@ void spdk_bs_batch_read_bs_dev(spdk_bs_batch_t *batch, struct spdk_bs_dev *bs_de
 void spdk_bs_batch_read_dev(spdk_bs_batch_t *batch, void *payload,
 			    uint64_t lba, uint32_t lba_count);
 
+void spdk_bs_batch_readv_bs_dev(spdk_bs_batch_t *batch, struct spdk_bs_dev *bs_dev,
+				struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count);
+
+void spdk_bs_batch_readv_dev(spdk_bs_batch_t *batch, struct iovec *iov, int iovcnt,
+			     uint64_t lba, uint32_t lba_count);
+
 void spdk_bs_batch_write_dev(spdk_bs_batch_t *batch, void *payload,
 			     uint64_t lba, uint32_t lba_count);
 
+void spdk_bs_batch_writev_dev(spdk_bs_batch_t *batch, struct iovec *iov, int iovcnt,
+			      uint64_t lba, uint32_t lba_count);
+
 void spdk_bs_batch_unmap_dev(spdk_bs_batch_t *batch,
 			     uint64_t lba, uint32_t lba_count);
 
@@ -216,6 +225,8 @@ spdk_bs_user_op_t *spdk_bs_user_op_alloc(struct spdk_io_channel *channel, struct
 
 void spdk_bs_user_op_execute(spdk_bs_user_op_t *op);
 
+void spdk_bs_user_op_complete(spdk_bs_user_op_t *op, int bserrno);
+
 void spdk_bs_user_op_abort(spdk_bs_user_op_t *op);
 
 void spdk_bs_sequence_to_batch_completion(void *cb_arg, int bserrno);
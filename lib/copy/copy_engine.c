@@ -35,6 +35,7 @@
 
 #include "spdk_internal/copy_engine.h"
 
+#include "spdk/crc32.h"
 #include "spdk/env.h"
 #include "spdk/event.h"
 #include "spdk/log.h"
@@ -52,6 +53,26 @@ static TAILQ_HEAD(, spdk_copy_module_if) spdk_copy_module_list =
 struct copy_io_channel {
 	struct spdk_copy_engine	*engine;
 	struct spdk_io_channel	*ch;
+	/* Engine and channel serving CRC-32C requests, may differ from the above. */
+	struct spdk_copy_engine	*crc32c_engine;
+	struct spdk_io_channel	*crc32c_ch;
+};
+
+/* Maximum number of CRC-32C requests checksummed side by side. */
+#define MEM_CRC32C_BATCH_SIZE 32
+
+struct mem_crc32c_task {
+	uint32_t			*dst;
+	struct iovec			*iovs;
+	uint32_t			iovcnt;
+	uint32_t			iov_index;
+	uint32_t			crc;
+	spdk_copy_completion_cb		cb;
+	TAILQ_ENTRY(mem_crc32c_task)	link;
+};
+
+struct mem_io_channel {
+	TAILQ_HEAD(, mem_crc32c_task)	crc32c_tasks;
 };
 
 static struct spdk_copy_module_if *g_copy_engine_module = NULL;
@@ -110,6 +131,19 @@ spdk_copy_submit_fill(struct spdk_copy_task *copy_req, struct spdk_io_channel *c
 				     copy_engine_done);
 }
 
+int
+spdk_copy_submit_crc32c(struct spdk_copy_task *copy_req, struct spdk_io_channel *ch,
+			uint32_t *dst, struct iovec *iovs, uint32_t iovcnt, uint32_t seed,
+			spdk_copy_completion_cb cb)
+{
+	struct spdk_copy_task *req = copy_req;
+	struct copy_io_channel *copy_ch = spdk_io_channel_get_ctx(ch);
+
+	req->cb = cb;
+	return copy_ch->crc32c_engine->crc32c(req->offload_ctx, copy_ch->crc32c_ch, dst, iovs,
+					      iovcnt, seed, copy_engine_done);
+}
+
 /* memcpy default copy engine */
 static int
 mem_copy_submit(void *cb_arg, struct spdk_io_channel *ch, void *dst, void *src, uint64_t nbytes,
@@ -139,23 +173,109 @@ mem_copy_fill(void *cb_arg, struct spdk_io_channel *ch, void *dst, uint8_t fill,
 	return 0;
 }
 
+static void
+mem_crc32c_flush(void *arg)
+{
+	struct mem_io_channel *mem_ch = arg;
+	struct mem_crc32c_task *tasks[MEM_CRC32C_BATCH_SIZE], *task;
+	const void *bufs[MEM_CRC32C_BATCH_SIZE];
+	size_t lens[MEM_CRC32C_BATCH_SIZE];
+	uint32_t crcs[MEM_CRC32C_BATCH_SIZE];
+	uint32_t lanes[MEM_CRC32C_BATCH_SIZE];
+	uint32_t count, active, i;
+
+	while (!TAILQ_EMPTY(&mem_ch->crc32c_tasks)) {
+		count = 0;
+		while (count < MEM_CRC32C_BATCH_SIZE && !TAILQ_EMPTY(&mem_ch->crc32c_tasks)) {
+			task = TAILQ_FIRST(&mem_ch->crc32c_tasks);
+			TAILQ_REMOVE(&mem_ch->crc32c_tasks, task, link);
+			tasks[count++] = task;
+		}
+
+		/*
+		 * Checksum the n-th element of every request's iovec array in one
+		 * multi-buffer pass, until all of the requests are exhausted.
+		 */
+		do {
+			active = 0;
+			for (i = 0; i < count; i++) {
+				task = tasks[i];
+				if (task->iov_index == task->iovcnt) {
+					continue;
+				}
+				bufs[active] = task->iovs[task->iov_index].iov_base;
+				lens[active] = task->iovs[task->iov_index].iov_len;
+				crcs[active] = task->crc;
+				lanes[active] = i;
+				active++;
+			}
+
+			spdk_crc32c_update_multi(bufs, lens, crcs, active);
+
+			for (i = 0; i < active; i++) {
+				task = tasks[lanes[i]];
+				task->crc = crcs[i];
+				task->iov_index++;
+			}
+		} while (active > 0);
+
+		for (i = 0; i < count; i++) {
+			task = tasks[i];
+			*task->dst = task->crc;
+			task->cb((void *)((uintptr_t)task - offsetof(struct spdk_copy_task, offload_ctx)), 0);
+		}
+	}
+}
+
+static int
+mem_copy_crc32c(void *cb_arg, struct spdk_io_channel *ch, uint32_t *dst, struct iovec *iovs,
+		uint32_t iovcnt, uint32_t seed, spdk_copy_completion_cb cb)
+{
+	struct mem_io_channel *mem_ch = spdk_io_channel_get_ctx(ch);
+	struct mem_crc32c_task *task = cb_arg;
+
+	task->dst = dst;
+	task->iovs = iovs;
+	task->iovcnt = iovcnt;
+	task->iov_index = 0;
+	task->crc = seed;
+	task->cb = cb;
+
+	/*
+	 * Defer the calculation, so that all of the requests submitted during this
+	 * poll are checksummed together.
+	 */
+	if (TAILQ_EMPTY(&mem_ch->crc32c_tasks)) {
+		spdk_thread_send_msg(spdk_get_thread(), mem_crc32c_flush, mem_ch);
+	}
+	TAILQ_INSERT_TAIL(&mem_ch->crc32c_tasks, task, link);
+
+	return 0;
+}
+
 static struct spdk_io_channel *mem_get_io_channel(void);
 
 static struct spdk_copy_engine memcpy_copy_engine = {
 	.copy		= mem_copy_submit,
 	.fill		= mem_copy_fill,
+	.crc32c		= mem_copy_crc32c,
 	.get_io_channel	= mem_get_io_channel,
 };
 
 static int
 memcpy_create_cb(void *io_device, void *ctx_buf)
 {
+	struct mem_io_channel *mem_ch = ctx_buf;
+
+	TAILQ_INIT(&mem_ch->crc32c_tasks);
 	return 0;
 }
 
 static void
 memcpy_destroy_cb(void *io_device, void *ctx_buf)
 {
+	/* The flush message was sent before the channel release, so it already ran. */
+	assert(TAILQ_EMPTY(&((struct mem_io_channel *)ctx_buf)->crc32c_tasks));
 }
 
 static struct spdk_io_channel *mem_get_io_channel(void)
@@ -166,7 +286,7 @@ static struct spdk_io_channel *mem_get_io_channel(void)
 static size_t
 copy_engine_mem_get_ctx_size(void)
 {
-	return sizeof(struct spdk_copy_task);
+	return sizeof(struct spdk_copy_task) + sizeof(struct mem_crc32c_task);
 }
 
 size_t
@@ -188,17 +308,28 @@ copy_create_cb(void *io_device, void *ctx_buf)
 {
 	struct copy_io_channel	*copy_ch = ctx_buf;
 
+	copy_ch->ch = NULL;
 	if (hw_copy_engine != NULL) {
 		copy_ch->ch = hw_copy_engine->get_io_channel();
-		if (copy_ch->ch != NULL) {
-			copy_ch->engine = hw_copy_engine;
-			return 0;
-		}
+		copy_ch->engine = hw_copy_engine;
+	}
+
+	if (copy_ch->ch == NULL) {
+		copy_ch->ch = mem_copy_engine->get_io_channel();
+		assert(copy_ch->ch != NULL);
+		copy_ch->engine = mem_copy_engine;
+	}
+
+	if (copy_ch->engine->crc32c != NULL) {
+		copy_ch->crc32c_ch = copy_ch->ch;
+		copy_ch->crc32c_engine = copy_ch->engine;
+	} else {
+		/* Fall back to the software multi-buffer implementation. */
+		copy_ch->crc32c_ch = mem_copy_engine->get_io_channel();
+		assert(copy_ch->crc32c_ch != NULL);
+		copy_ch->crc32c_engine = mem_copy_engine;
 	}
 
-	copy_ch->ch = mem_copy_engine->get_io_channel();
-	assert(copy_ch->ch != NULL);
-	copy_ch->engine = mem_copy_engine;
 	return 0;
 }
 
@@ -207,6 +338,9 @@ copy_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct copy_io_channel	*copy_ch = ctx_buf;
 
+	if (copy_ch->crc32c_ch != copy_ch->ch) {
+		spdk_put_io_channel(copy_ch->crc32c_ch);
+	}
 	spdk_put_io_channel(copy_ch->ch);
 }
 
@@ -220,8 +354,8 @@ static int
 copy_engine_mem_init(void)
 {
 	spdk_memcpy_register(&memcpy_copy_engine);
-	spdk_io_device_register(&memcpy_copy_engine, memcpy_create_cb, memcpy_destroy_cb, 0,
-				"memcpy_engine");
+	spdk_io_device_register(&memcpy_copy_engine, memcpy_create_cb, memcpy_destroy_cb,
+				sizeof(struct mem_io_channel), "memcpy_engine");
 
 	return 0;
 }
@@ -41,6 +41,9 @@
 /* Default blob channel opts for lvol */
 #define SPDK_LVOL_BLOB_OPTS_CHANNEL_OPS 512
 
+/* Number of blobs opened at the same time while loading an lvol store */
+#define SPDK_LVS_LOAD_QUEUE_DEPTH 64
+
 #define LVOL_NAME "name"
 
 SPDK_LOG_REGISTER_COMPONENT("lvol", SPDK_LOG_LVOL)
@@ -158,43 +161,29 @@ _spdk_bs_unload_with_error_cb(void *cb_arg, int lvolerrno)
 	free(req);
 }
 
-static void
-_spdk_load_next_lvol(void *cb_arg, struct spdk_blob *blob, int lvolerrno)
+static int
+_spdk_load_lvol(void *cb_arg, struct spdk_blob *blob)
 {
 	struct spdk_lvs_with_handle_req *req = cb_arg;
 	struct spdk_lvol_store *lvs = req->lvol_store;
-	struct spdk_blob_store *bs = lvs->blobstore;
-	struct spdk_lvol *lvol, *tmp;
+	struct spdk_lvol *lvol;
 	spdk_blob_id blob_id;
 	const char *attr;
 	const enum blob_clear_method *clear_method;
 	size_t value_len;
 	int rc;
 
-	if (lvolerrno == -ENOENT) {
-		/* Finished iterating */
-		req->cb_fn(req->cb_arg, lvs, 0);
-		free(req);
-		return;
-	} else if (lvolerrno < 0) {
-		SPDK_ERRLOG("Failed to fetch blobs list\n");
-		req->lvserrno = lvolerrno;
-		goto invalid;
-	}
-
 	blob_id = spdk_blob_get_id(blob);
 
 	if (blob_id == lvs->super_blob_id) {
 		SPDK_INFOLOG(SPDK_LOG_LVOL, "found superblob %"PRIu64"\n", (uint64_t)blob_id);
-		spdk_bs_iter_next(bs, blob, _spdk_load_next_lvol, req);
-		return;
+		return 0;
 	}
 
 	lvol = calloc(1, sizeof(*lvol));
 	if (!lvol) {
 		SPDK_ERRLOG("Cannot alloc memory for lvol base pointer\n");
-		req->lvserrno = -ENOMEM;
-		goto invalid;
+		return -ENOMEM;
 	}
 
 	lvol->blob = blob;
@@ -222,8 +211,7 @@ _spdk_load_next_lvol(void *cb_arg, struct spdk_blob *blob, int lvolerrno)
 	if (rc != 0 || value_len > SPDK_LVOL_NAME_MAX) {
 		SPDK_ERRLOG("Cannot assign lvol name\n");
 		_spdk_lvol_free(lvol);
-		req->lvserrno = -EINVAL;
-		goto invalid;
+		return -EINVAL;
 	}
 
 	rc = spdk_blob_get_xattr_value(blob, "clear_method", (const void **)&clear_method, &value_len);
@@ -241,11 +229,26 @@ _spdk_load_next_lvol(void *cb_arg, struct spdk_blob *blob, int lvolerrno)
 
 	SPDK_INFOLOG(SPDK_LOG_LVOL, "added lvol %s (%s)\n", lvol->unique_id, lvol->uuid_str);
 
-	spdk_bs_iter_next(bs, blob, _spdk_load_next_lvol, req);
+	return 0;
+}
+
+static void
+_spdk_load_lvols_cpl(void *cb_arg, int lvolerrno)
+{
+	struct spdk_lvs_with_handle_req *req = cb_arg;
+	struct spdk_lvol_store *lvs = req->lvol_store;
+	struct spdk_blob_store *bs = lvs->blobstore;
+	struct spdk_lvol *lvol, *tmp;
 
-	return;
+	if (lvolerrno == 0) {
+		req->cb_fn(req->cb_arg, lvs, 0);
+		free(req);
+		return;
+	}
+
+	SPDK_ERRLOG("Failed to load lvols\n");
+	req->lvserrno = lvolerrno;
 
-invalid:
 	TAILQ_FOREACH_SAFE(lvol, &lvs->lvols, link, tmp) {
 		TAILQ_REMOVE(&lvs->lvols, lvol, link);
 		free(lvol);
@@ -271,7 +274,8 @@ _spdk_close_super_cb(void *cb_arg, int lvolerrno)
 	}
 
 	/* Start loading lvols */
-	spdk_bs_iter_first(lvs->blobstore, _spdk_load_next_lvol, req);
+	spdk_bs_for_each_blob(lvs->blobstore, SPDK_LVS_LOAD_QUEUE_DEPTH, _spdk_load_lvol,
+			      _spdk_load_lvols_cpl, req);
 }
 
 static void
@@ -397,7 +401,8 @@ spdk_lvs_bs_opts_init(struct spdk_bs_opts *opts)
 }
 
 void
-spdk_lvs_load(struct spdk_bs_dev *bs_dev, spdk_lvs_op_with_handle_complete cb_fn, void *cb_arg)
+spdk_lvs_load_ext(struct spdk_bs_dev *bs_dev, const struct spdk_lvs_opts *o,
+		  spdk_lvs_op_with_handle_complete cb_fn, void *cb_arg)
 {
 	struct spdk_lvs_with_handle_req *req;
 	struct spdk_bs_opts opts = {};
@@ -423,10 +428,20 @@ spdk_lvs_load(struct spdk_bs_dev *bs_dev, spdk_lvs_op_with_handle_complete cb_fn
 
 	spdk_lvs_bs_opts_init(&opts);
 	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "LVOLSTORE");
+	if (o != NULL) {
+		opts.esnap_bs_dev_create = o->esnap_bs_dev_create;
+		opts.esnap_ctx = o->esnap_ctx;
+	}
 
 	spdk_bs_load(bs_dev, &opts, _spdk_lvs_load_cb, req);
 }
 
+void
+spdk_lvs_load(struct spdk_bs_dev *bs_dev, spdk_lvs_op_with_handle_complete cb_fn, void *cb_arg)
+{
+	spdk_lvs_load_ext(bs_dev, NULL, cb_fn, cb_arg);
+}
+
 static void
 _spdk_remove_bs_on_error_cb(void *cb_arg, int bserrno)
 {
@@ -568,6 +583,8 @@ spdk_lvs_opts_init(struct spdk_lvs_opts *o)
 	o->cluster_sz = SPDK_LVS_OPTS_CLUSTER_SZ;
 	o->clear_method = LVS_CLEAR_WITH_UNMAP;
 	memset(o->name, 0, sizeof(o->name));
+	o->esnap_bs_dev_create = NULL;
+	o->esnap_ctx = NULL;
 }
 
 static void
@@ -577,6 +594,8 @@ _spdk_setup_lvs_opts(struct spdk_bs_opts *bs_opts, struct spdk_lvs_opts *o)
 	spdk_lvs_bs_opts_init(bs_opts);
 	bs_opts->cluster_sz = o->cluster_sz;
 	bs_opts->clear_method = (enum bs_clear_method)o->clear_method;
+	bs_opts->esnap_bs_dev_create = o->esnap_bs_dev_create;
+	bs_opts->esnap_ctx = o->esnap_ctx;
 }
 
 int
@@ -1077,6 +1096,8 @@ spdk_lvol_create(struct spdk_lvol_store *lvs, const char *name, uint64_t sz,
 	spdk_blob_opts_init(&opts);
 	opts.thin_provision = thin_provision;
 	opts.num_clusters = num_clusters;
+	/* Keep the copy-on-write cost of writes to snapshotted lvols and clones low */
+	opts.use_subcluster_cow = true;
 	opts.xattrs.count = SPDK_COUNTOF(xattr_names);
 	opts.xattrs.names = xattr_names;
 	opts.xattrs.ctx = lvol;
@@ -1087,6 +1108,81 @@ spdk_lvol_create(struct spdk_lvol_store *lvs, const char *name, uint64_t sz,
 	return 0;
 }
 
+int
+spdk_lvol_create_esnap_clone(const void *esnap_id, uint32_t id_len, uint64_t size_bytes,
+			     struct spdk_lvol_store *lvs, const char *clone_name,
+			     spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol_with_handle_req *req;
+	struct spdk_blob_store *bs;
+	struct spdk_lvol *lvol;
+	struct spdk_blob_opts opts;
+	uint64_t cluster_sz;
+	char *xattr_names[] = {LVOL_NAME, "uuid"};
+	int rc;
+
+	if (lvs == NULL) {
+		SPDK_ERRLOG("lvol store does not exist\n");
+		return -EINVAL;
+	}
+
+	if (esnap_id == NULL || id_len == 0) {
+		SPDK_ERRLOG("external snapshot id not provided\n");
+		return -EINVAL;
+	}
+
+	bs = lvs->blobstore;
+	cluster_sz = spdk_bs_get_cluster_size(bs);
+	if (size_bytes == 0 || size_bytes % cluster_sz != 0) {
+		SPDK_ERRLOG("Cannot create '%s/%s': size %" PRIu64 " is not an integer multiple of "
+			    "cluster size %" PRIu64 "\n", lvs->name, clone_name, size_bytes, cluster_sz);
+		return -EINVAL;
+	}
+
+	rc = _spdk_lvs_verify_lvol_name(lvs, clone_name);
+	if (rc < 0) {
+		return rc;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (!req) {
+		SPDK_ERRLOG("Cannot alloc memory for lvol request pointer\n");
+		return -ENOMEM;
+	}
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+
+	lvol = calloc(1, sizeof(*lvol));
+	if (!lvol) {
+		free(req);
+		SPDK_ERRLOG("Cannot alloc memory for lvol base pointer\n");
+		return -ENOMEM;
+	}
+	lvol->lvol_store = lvs;
+	lvol->thin_provision = true;
+	lvol->clear_method = BLOB_CLEAR_WITH_DEFAULT;
+	snprintf(lvol->name, sizeof(lvol->name), "%s", clone_name);
+	TAILQ_INSERT_TAIL(&lvol->lvol_store->pending_lvols, lvol, link);
+	spdk_uuid_generate(&lvol->uuid);
+	spdk_uuid_fmt_lower(lvol->uuid_str, sizeof(lvol->uuid_str), &lvol->uuid);
+	req->lvol = lvol;
+
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = size_bytes / cluster_sz;
+	opts.use_subcluster_cow = true;
+	opts.esnap_id = esnap_id;
+	opts.esnap_id_len = id_len;
+	opts.xattrs.count = SPDK_COUNTOF(xattr_names);
+	opts.xattrs.names = xattr_names;
+	opts.xattrs.ctx = lvol;
+	opts.xattrs.get_value = spdk_lvol_get_xattr_value;
+
+	spdk_bs_create_blob_ext(bs, &opts, _spdk_lvol_create_cb, req);
+
+	return 0;
+}
+
 void
 spdk_lvol_create_snapshot(struct spdk_lvol *origlvol, const char *snapshot_name,
 			  spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg)
@@ -1446,8 +1542,9 @@ _spdk_lvol_inflate_cb(void *cb_arg, int lvolerrno)
 	free(req);
 }
 
-void
-spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
+static void
+_spdk_lvol_inflate(struct spdk_lvol *lvol, bool decouple_parent,
+		   const struct spdk_blob_copy_opts *opts, spdk_lvol_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_lvol_req *req;
 	spdk_blob_id blob_id;
@@ -1478,12 +1575,60 @@ spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_
 	}
 
 	blob_id = spdk_blob_get_id(lvol->blob);
-	spdk_bs_inflate_blob(lvol->lvol_store->blobstore, req->channel, blob_id, _spdk_lvol_inflate_cb,
-			     req);
+	if (decouple_parent) {
+		spdk_bs_blob_decouple_parent_ext(lvol->lvol_store->blobstore, req->channel, blob_id,
+						 opts, _spdk_lvol_inflate_cb, req);
+	} else {
+		spdk_bs_inflate_blob_ext(lvol->lvol_store->blobstore, req->channel, blob_id,
+					 opts, _spdk_lvol_inflate_cb, req);
+	}
+}
+
+void
+spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	_spdk_lvol_inflate(lvol, false, NULL, cb_fn, cb_arg);
+}
+
+void
+spdk_lvol_inflate_ext(struct spdk_lvol *lvol, const struct spdk_blob_copy_opts *opts,
+		      spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	_spdk_lvol_inflate(lvol, false, opts, cb_fn, cb_arg);
 }
 
 void
 spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	_spdk_lvol_inflate(lvol, true, NULL, cb_fn, cb_arg);
+}
+
+void
+spdk_lvol_decouple_parent_ext(struct spdk_lvol *lvol, const struct spdk_blob_copy_opts *opts,
+			      spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	_spdk_lvol_inflate(lvol, true, opts, cb_fn, cb_arg);
+}
+
+static void
+_spdk_lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
+{
+	struct spdk_lvol_req *req = cb_arg;
+
+	spdk_bs_free_io_channel(req->channel);
+
+	if (lvolerrno < 0) {
+		SPDK_ERRLOG("Could not make shallow copy of lvol\n");
+	}
+
+	req->cb_fn(req->cb_arg, lvolerrno);
+	free(req);
+}
+
+void
+spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
+		       const struct spdk_blob_copy_opts *opts,
+		       spdk_lvol_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_lvol_req *req;
 	spdk_blob_id blob_id;
@@ -1507,13 +1652,13 @@ spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, v
 	req->cb_arg = cb_arg;
 	req->channel = spdk_bs_alloc_io_channel(lvol->lvol_store->blobstore);
 	if (req->channel == NULL) {
-		SPDK_ERRLOG("Cannot alloc io channel for lvol inflate request\n");
+		SPDK_ERRLOG("Cannot alloc io channel for lvol shallow copy request\n");
 		free(req);
 		cb_fn(cb_arg, -ENOMEM);
 		return;
 	}
 
 	blob_id = spdk_blob_get_id(lvol->blob);
-	spdk_bs_blob_decouple_parent(lvol->lvol_store->blobstore, req->channel, blob_id,
-				     _spdk_lvol_inflate_cb, req);
+	spdk_bs_blob_shallow_copy(lvol->lvol_store->blobstore, req->channel, blob_id, ext_dev,
+				  opts, _spdk_lvol_shallow_copy_cb, req);
 }
@@ -250,12 +250,9 @@ nvme_request_check_timeout(struct nvme_request *req, uint16_t cid,
 			   struct spdk_nvme_ctrlr_process *active_proc,
 			   uint64_t now_tick)
 {
-	struct spdk_nvme_qpair *qpair = req->qpair;
-	struct spdk_nvme_ctrlr *ctrlr = qpair->ctrlr;
-
 	assert(active_proc->timeout_cb_fn != NULL);
 
-	if (req->timed_out || req->submit_tick == 0) {
+	if (!nvme_request_has_timeout(req)) {
 		return 0;
 	}
 
@@ -263,15 +260,32 @@ nvme_request_check_timeout(struct nvme_request *req, uint16_t cid,
 		return 0;
 	}
 
-	if (nvme_qpair_is_admin_queue(qpair) &&
-	    req->cmd.opc == SPDK_NVME_OPC_ASYNC_EVENT_REQUEST) {
-		return 0;
-	}
-
 	if (req->submit_tick + active_proc->timeout_ticks > now_tick) {
 		return 1;
 	}
 
+	nvme_request_timeout(req, cid, active_proc);
+	return 0;
+}
+
+/**
+ * Mark a request as timed out and invoke the timeout callback of the process
+ * that submitted it.
+ *
+ * \param req request whose deadline has passed.
+ * \param cid command ID for command submitted by req (will be passed to timeout_cb_fn)
+ * \param active_proc per-process data for the controller associated with req
+ */
+void
+nvme_request_timeout(struct nvme_request *req, uint16_t cid,
+		     struct spdk_nvme_ctrlr_process *active_proc)
+{
+	struct spdk_nvme_qpair *qpair = req->qpair;
+	struct spdk_nvme_ctrlr *ctrlr = qpair->ctrlr;
+
+	assert(active_proc->timeout_cb_fn != NULL);
+	assert(!req->timed_out);
+
 	req->timed_out = true;
 
 	/*
@@ -282,7 +296,6 @@ nvme_request_check_timeout(struct nvme_request *req, uint16_t cid,
 	active_proc->timeout_cb_fn(active_proc->timeout_cb_arg, ctrlr,
 				   nvme_qpair_is_admin_queue(qpair) ? NULL : qpair,
 				   cid);
-	return 0;
 }
 
 int
@@ -604,6 +617,7 @@ spdk_nvme_probe_ctx_init(struct spdk_nvme_probe_ctx *probe_ctx,
 	probe_ctx->attach_cb = attach_cb;
 	probe_ctx->remove_cb = remove_cb;
 	TAILQ_INIT(&probe_ctx->init_ctrlrs);
+	probe_ctx->rc = 0;
 }
 
 int
@@ -1093,18 +1107,23 @@ spdk_nvme_probe_poll_async(struct spdk_nvme_probe_ctx *probe_ctx)
 		return 0;
 	}
 
+	/*
+	 * Each controller only advances its state machine by a step and never waits,
+	 *  so all of the controllers in the context are initialized in parallel.
+	 *  A controller that fails is removed from the list without holding up the others.
+	 */
 	TAILQ_FOREACH_SAFE(ctrlr, &probe_ctx->init_ctrlrs, tailq, ctrlr_tmp) {
 		rc = nvme_ctrlr_poll_internal(ctrlr, probe_ctx);
 		if (rc != 0) {
-			rc = -EIO;
-			break;
+			probe_ctx->rc = -EIO;
 		}
 	}
 
-	if (rc != 0 || TAILQ_EMPTY(&probe_ctx->init_ctrlrs)) {
+	if (TAILQ_EMPTY(&probe_ctx->init_ctrlrs)) {
 		nvme_robust_mutex_lock(&g_spdk_nvme_driver->lock);
 		g_spdk_nvme_driver->initialized = true;
 		nvme_robust_mutex_unlock(&g_spdk_nvme_driver->lock);
+		rc = probe_ctx->rc;
 		free(probe_ctx);
 		return rc;
 	}
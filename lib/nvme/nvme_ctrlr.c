@@ -42,6 +42,9 @@ static int nvme_ctrlr_construct_and_submit_aer(struct spdk_nvme_ctrlr *ctrlr,
 		struct nvme_async_event_request *aer);
 static int nvme_ctrlr_identify_ns_async(struct spdk_nvme_ns *ns);
 static int nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ns *ns);
+static void nvme_ctrlr_destruct_namespaces(struct spdk_nvme_ctrlr *ctrlr);
+static void nvme_ctrlr_set_state(struct spdk_nvme_ctrlr *ctrlr, enum nvme_ctrlr_state state,
+				 uint64_t timeout_in_ms);
 
 static int
 nvme_ctrlr_get_cc(struct spdk_nvme_ctrlr *ctrlr, union spdk_nvme_cc_register *cc)
@@ -449,37 +452,63 @@ nvme_ctrlr_construct_intel_support_log_page_list(struct spdk_nvme_ctrlr *ctrlr,
 	}
 }
 
+struct nvme_intel_log_page_dir_ctx {
+	struct spdk_nvme_intel_log_page_directory	directory;
+	struct spdk_nvme_ctrlr				*ctrlr;
+};
+
+static void
+nvme_ctrlr_set_intel_support_log_pages_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_intel_log_page_dir_ctx *ctx = arg;
+	struct spdk_nvme_ctrlr *ctrlr = ctx->ctrlr;
+
+	if (ctrlr->state != NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_LOG_PAGES) {
+		/* Timed out, initialization already went on without the directory. */
+		spdk_free(ctx);
+		return;
+	}
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_WARNLOG("Intel log pages not supported on Intel drive!\n");
+	} else {
+		nvme_ctrlr_construct_intel_support_log_page_list(ctrlr, &ctx->directory);
+	}
+
+	spdk_free(ctx);
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES,
+			     ctrlr->opts.admin_timeout_ms);
+}
+
 static int nvme_ctrlr_set_intel_support_log_pages(struct spdk_nvme_ctrlr *ctrlr)
 {
 	int rc = 0;
-	struct nvme_completion_poll_status	status;
-	struct spdk_nvme_intel_log_page_directory *log_page_directory;
+	struct nvme_intel_log_page_dir_ctx *ctx;
 
-	log_page_directory = spdk_zmalloc(sizeof(struct spdk_nvme_intel_log_page_directory),
-					  64, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (log_page_directory == NULL) {
+	ctx = spdk_zmalloc(sizeof(*ctx), 64, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (ctx == NULL) {
 		SPDK_ERRLOG("could not allocate log_page_directory\n");
 		return -ENXIO;
 	}
+	ctx->ctrlr = ctrlr;
+
+	/*
+	 * Don't wait for the directory here, so other controllers being
+	 *  initialized at the same time keep making progress.
+	 */
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_LOG_PAGES,
+			     ctrlr->opts.admin_timeout_ms);
 
 	rc = spdk_nvme_ctrlr_cmd_get_log_page(ctrlr, SPDK_NVME_INTEL_LOG_PAGE_DIRECTORY,
-					      SPDK_NVME_GLOBAL_NS_TAG, log_page_directory,
+					      SPDK_NVME_GLOBAL_NS_TAG, &ctx->directory,
 					      sizeof(struct spdk_nvme_intel_log_page_directory),
-					      0, nvme_completion_poll_cb, &status);
+					      0, nvme_ctrlr_set_intel_support_log_pages_done, ctx);
 	if (rc != 0) {
-		spdk_free(log_page_directory);
+		spdk_free(ctx);
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
 		return rc;
 	}
 
-	if (spdk_nvme_wait_for_completion_timeout(ctrlr->adminq, &status,
-			ctrlr->opts.admin_timeout_ms / 1000)) {
-		spdk_free(log_page_directory);
-		SPDK_WARNLOG("Intel log pages not supported on Intel drive!\n");
-		return 0;
-	}
-
-	nvme_ctrlr_construct_intel_support_log_page_list(ctrlr, log_page_directory);
-	spdk_free(log_page_directory);
 	return 0;
 }
 
@@ -498,6 +527,9 @@ nvme_ctrlr_set_supported_log_pages(struct spdk_nvme_ctrlr *ctrlr)
 	}
 	if (ctrlr->cdata.vid == SPDK_PCI_VID_INTEL && !(ctrlr->quirks & NVME_INTEL_QUIRK_NO_LOG_PAGES)) {
 		rc = nvme_ctrlr_set_intel_support_log_pages(ctrlr);
+	} else {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES,
+				     ctrlr->opts.admin_timeout_ms);
 	}
 
 	return rc;
@@ -655,6 +687,16 @@ nvme_ctrlr_enable(struct spdk_nvme_ctrlr *ctrlr)
 		ctrlr->cap.bits.css = SPDK_NVME_CAP_CSS_NVM;
 	}
 
+	if (ctrlr->opts.command_set == SPDK_NVME_CC_CSS_NVM &&
+	    (ctrlr->cap.bits.css & SPDK_NVME_CAP_CSS_IOCS)) {
+		/*
+		 * Selecting all supported I/O command sets keeps NVM namespaces
+		 * working and makes zoned namespaces accessible as well.
+		 */
+		SPDK_DEBUGLOG(SPDK_LOG_NVME, "Controller supports I/O command sets, selecting IOCS\n");
+		ctrlr->opts.command_set = SPDK_NVME_CC_CSS_IOCS;
+	}
+
 	if (!(ctrlr->cap.bits.css & (1u << ctrlr->opts.command_set))) {
 		SPDK_DEBUGLOG(SPDK_LOG_NVME, "Requested I/O command set %u but supported mask is 0x%x\n",
 			      ctrlr->opts.command_set, ctrlr->cap.bits.css);
@@ -749,6 +791,8 @@ nvme_ctrlr_state_string(enum nvme_ctrlr_state state)
 		return "construct namespaces";
 	case NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS:
 		return "identify active ns";
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS:
+		return "wait for identify active ns";
 	case NVME_CTRLR_STATE_IDENTIFY_NS:
 		return "identify ns";
 	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS:
@@ -757,12 +801,18 @@ nvme_ctrlr_state_string(enum nvme_ctrlr_state state)
 		return "identify namespace id descriptors";
 	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ID_DESCS:
 		return "wait for identify namespace id descriptors";
+	case NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC:
+		return "identify I/O command set specific data";
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC:
+		return "wait for identify I/O command set specific data";
 	case NVME_CTRLR_STATE_CONFIGURE_AER:
 		return "configure AER";
 	case NVME_CTRLR_STATE_WAIT_FOR_CONFIGURE_AER:
 		return "wait for configure aer";
 	case NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES:
 		return "set supported log pages";
+	case NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_LOG_PAGES:
+		return "wait for supported log pages";
 	case NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES:
 		return "set supported features";
 	case NVME_CTRLR_STATE_SET_DB_BUF_CFG:
@@ -786,11 +836,60 @@ nvme_ctrlr_state_string(enum nvme_ctrlr_state state)
 };
 #endif /* DEBUG */
 
+static enum nvme_ctrlr_init_phase
+nvme_ctrlr_state_init_phase(enum nvme_ctrlr_state state)
+{
+	if (state <= NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1) {
+		return NVME_CTRLR_INIT_PHASE_ENABLE;
+	} else if (state <= NVME_CTRLR_STATE_WAIT_FOR_GET_NUM_QUEUES) {
+		return NVME_CTRLR_INIT_PHASE_IDENTIFY;
+	} else if (state <= NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC) {
+		return NVME_CTRLR_INIT_PHASE_NAMESPACES;
+	} else if (state <= NVME_CTRLR_STATE_WAIT_FOR_HOST_ID) {
+		return NVME_CTRLR_INIT_PHASE_CONFIGURE;
+	}
+
+	return NVME_CTRLR_INIT_PHASE_DONE;
+}
+
+/*
+ * Charge the time since the last phase change to the phase the controller is
+ *  leaving. A reset of an initialized controller starts a new set of timings,
+ *  keeping only the construction time of the original attach.
+ */
+static void
+nvme_ctrlr_update_init_phase(struct spdk_nvme_ctrlr *ctrlr)
+{
+	enum nvme_ctrlr_init_phase phase;
+	uint64_t now;
+
+	if (ctrlr->init_phase == NVME_CTRLR_INIT_PHASE_CONSTRUCT) {
+		/* Stays in the construct phase until the state machine is first polled. */
+		return;
+	}
+
+	phase = nvme_ctrlr_state_init_phase(ctrlr->state);
+	if (phase == ctrlr->init_phase) {
+		return;
+	}
+
+	now = spdk_get_ticks();
+	if (ctrlr->init_phase == NVME_CTRLR_INIT_PHASE_DONE) {
+		memset(&ctrlr->init_phase_ticks[NVME_CTRLR_INIT_PHASE_ENABLE], 0,
+		       sizeof(ctrlr->init_phase_ticks) - sizeof(ctrlr->init_phase_ticks[0]));
+	} else {
+		ctrlr->init_phase_ticks[ctrlr->init_phase] += now - ctrlr->init_phase_start_tsc;
+	}
+	ctrlr->init_phase = phase;
+	ctrlr->init_phase_start_tsc = now;
+}
+
 static void
 nvme_ctrlr_set_state(struct spdk_nvme_ctrlr *ctrlr, enum nvme_ctrlr_state state,
 		     uint64_t timeout_in_ms)
 {
 	ctrlr->state = state;
+	nvme_ctrlr_update_init_phase(ctrlr);
 	if (timeout_in_ms == 0) {
 		SPDK_DEBUGLOG(SPDK_LOG_NVME, "setting state to %s (no timeout)\n",
 			      nvme_ctrlr_state_string(ctrlr->state));
@@ -823,6 +922,8 @@ nvme_ctrlr_set_doorbell_buffer_config_done(void *arg, const struct spdk_nvme_cpl
 
 	if (spdk_nvme_cpl_is_error(cpl)) {
 		SPDK_WARNLOG("Doorbell buffer config failed\n");
+		/* Fall back to MMIO doorbells, the controller does not look at the buffers. */
+		nvme_ctrlr_free_doorbell_buffer(ctrlr);
 	} else {
 		SPDK_INFOLOG(SPDK_LOG_NVME, "NVMe controller: %s doorbell buffer config enabled\n",
 			     ctrlr->trid.traddr);
@@ -1043,7 +1144,7 @@ nvme_ctrlr_identify(struct spdk_nvme_ctrlr *ctrlr)
 	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY,
 			     ctrlr->opts.admin_timeout_ms);
 
-	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_CTRLR, 0, 0,
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_CTRLR, 0, 0, 0,
 				     &ctrlr->cdata, sizeof(ctrlr->cdata),
 				     nvme_ctrlr_identify_done, ctrlr);
 	if (rc != 0) {
@@ -1054,80 +1155,200 @@ nvme_ctrlr_identify(struct spdk_nvme_ctrlr *ctrlr)
 	return 0;
 }
 
-int
-nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
+enum nvme_active_ns_state {
+	NVME_ACTIVE_NS_STATE_PROCESSING,
+	NVME_ACTIVE_NS_STATE_DONE,
+	NVME_ACTIVE_NS_STATE_ERROR,
+};
+
+struct nvme_active_ns_ctx;
+typedef void (*nvme_active_ns_ctx_done_fn)(struct nvme_active_ns_ctx *ctx);
+
+/*
+ * Context of an Identify Active Namespace List sequence. The list is retrieved
+ *  one 1024-entry page at a time, so it is only swapped into the controller once
+ *  all of the pages have been retrieved.
+ */
+struct nvme_active_ns_ctx {
+	struct spdk_nvme_ctrlr		*ctrlr;
+	uint32_t			page;
+	uint32_t			num_pages;
+	uint32_t			next_nsid;
+	uint32_t			*new_ns_list;
+	enum nvme_active_ns_state	state;
+	nvme_active_ns_ctx_done_fn	done_fn;
+};
+
+static void
+nvme_active_ns_ctx_finish(struct nvme_active_ns_ctx *ctx, enum nvme_active_ns_state state)
 {
-	struct nvme_completion_poll_status	status;
-	int					rc;
-	uint32_t				i;
-	uint32_t				num_pages;
-	uint32_t				next_nsid = 0;
-	uint32_t				*new_ns_list = NULL;
+	struct spdk_nvme_ctrlr *ctrlr = ctx->ctrlr;
 
-	if (ctrlr->num_ns == 0) {
+	if (state == NVME_ACTIVE_NS_STATE_DONE) {
+		/*
+		 * Now that that the list is properly setup, we can swap it in to the ctrlr and
+		 * free up the previous one.
+		 */
 		spdk_free(ctrlr->active_ns_list);
-		ctrlr->active_ns_list = NULL;
+		ctrlr->active_ns_list = ctx->new_ns_list;
+	} else {
+		spdk_free(ctx->new_ns_list);
+	}
+	ctx->new_ns_list = NULL;
+	ctx->state = state;
 
-		return 0;
+	if (ctx->done_fn) {
+		ctx->done_fn(ctx);
 	}
+}
 
-	/*
-	 * The allocated size must be a multiple of sizeof(struct spdk_nvme_ns_list)
-	 */
-	num_pages = (ctrlr->num_ns * sizeof(new_ns_list[0]) - 1) / sizeof(struct spdk_nvme_ns_list) + 1;
-	new_ns_list = spdk_zmalloc(num_pages * sizeof(struct spdk_nvme_ns_list), ctrlr->page_size,
-				   NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA | SPDK_MALLOC_SHARE);
-	if (!new_ns_list) {
-		SPDK_ERRLOG("Failed to allocate active_ns_list!\n");
-		return -ENOMEM;
+static void nvme_ctrlr_identify_active_ns_async(struct nvme_active_ns_ctx *ctx);
+
+static void
+nvme_ctrlr_identify_active_ns_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_active_ns_ctx *ctx = arg;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_ERRLOG("nvme_ctrlr_cmd_identify_active_ns_list failed!\n");
+		nvme_active_ns_ctx_finish(ctx, NVME_ACTIVE_NS_STATE_ERROR);
+		return;
 	}
 
-	if (ctrlr->vs.raw >= SPDK_NVME_VERSION(1, 1, 0) && !(ctrlr->quirks & NVME_QUIRK_IDENTIFY_CNS)) {
+	ctx->next_nsid = ctx->new_ns_list[1024 * ctx->page + 1023];
+	if (ctx->next_nsid == 0 || ++ctx->page == ctx->num_pages) {
 		/*
-		 * Iterate through the pages and fetch each chunk of 1024 namespaces until
-		 * there are no more active namespaces
+		 * No more active namespaces found, no need to fetch additional chunks
 		 */
-		for (i = 0; i < num_pages; i++) {
-			rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST, 0, next_nsid,
-						     &new_ns_list[1024 * i], sizeof(struct spdk_nvme_ns_list),
-						     nvme_completion_poll_cb, &status);
-			if (rc != 0) {
-				goto fail;
-			}
-			if (spdk_nvme_wait_for_completion(ctrlr->adminq, &status)) {
-				SPDK_ERRLOG("nvme_ctrlr_cmd_identify_active_ns_list failed!\n");
-				rc = -ENXIO;
-				goto fail;
-			}
-			next_nsid = new_ns_list[1024 * i + 1023];
-			if (next_nsid == 0) {
-				/*
-				 * No more active namespaces found, no need to fetch additional chunks
-				 */
-				break;
-			}
-		}
+		nvme_active_ns_ctx_finish(ctx, NVME_ACTIVE_NS_STATE_DONE);
+		return;
+	}
 
-	} else {
+	nvme_ctrlr_identify_active_ns_async(ctx);
+}
+
+static void
+nvme_ctrlr_identify_active_ns_async(struct nvme_active_ns_ctx *ctx)
+{
+	struct spdk_nvme_ctrlr *ctrlr = ctx->ctrlr;
+	uint32_t i;
+	int rc;
+
+	if (ctrlr->num_ns == 0) {
+		nvme_active_ns_ctx_finish(ctx, NVME_ACTIVE_NS_STATE_DONE);
+		return;
+	}
+
+	if (ctx->new_ns_list == NULL) {
 		/*
-		 * Controller doesn't support active ns list CNS 0x02 so dummy up
-		 * an active ns list
+		 * The allocated size must be a multiple of sizeof(struct spdk_nvme_ns_list)
 		 */
-		for (i = 0; i < ctrlr->num_ns; i++) {
-			new_ns_list[i] = i + 1;
+		ctx->num_pages = (ctrlr->num_ns * sizeof(ctx->new_ns_list[0]) - 1) /
+				 sizeof(struct spdk_nvme_ns_list) + 1;
+		ctx->new_ns_list = spdk_zmalloc(ctx->num_pages * sizeof(struct spdk_nvme_ns_list),
+						ctrlr->page_size, NULL, SPDK_ENV_LCORE_ID_ANY,
+						SPDK_MALLOC_DMA | SPDK_MALLOC_SHARE);
+		if (!ctx->new_ns_list) {
+			SPDK_ERRLOG("Failed to allocate active_ns_list!\n");
+			nvme_active_ns_ctx_finish(ctx, NVME_ACTIVE_NS_STATE_ERROR);
+			return;
+		}
+
+		if (ctrlr->vs.raw < SPDK_NVME_VERSION(1, 1, 0) || (ctrlr->quirks & NVME_QUIRK_IDENTIFY_CNS)) {
+			/*
+			 * Controller doesn't support active ns list CNS 0x02 so dummy up
+			 * an active ns list
+			 */
+			for (i = 0; i < ctrlr->num_ns; i++) {
+				ctx->new_ns_list[i] = i + 1;
+			}
+			nvme_active_ns_ctx_finish(ctx, NVME_ACTIVE_NS_STATE_DONE);
+			return;
 		}
 	}
 
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST, 0, ctx->next_nsid, 0,
+				     &ctx->new_ns_list[1024 * ctx->page], sizeof(struct spdk_nvme_ns_list),
+				     nvme_ctrlr_identify_active_ns_async_done, ctx);
+	if (rc != 0) {
+		nvme_active_ns_ctx_finish(ctx, NVME_ACTIVE_NS_STATE_ERROR);
+	}
+}
+
+static void
+nvme_ctrlr_init_active_ns_done(struct nvme_active_ns_ctx *ctx)
+{
+	struct spdk_nvme_ctrlr *ctrlr = ctx->ctrlr;
+
 	/*
-	 * Now that that the list is properly setup, we can swap it in to the ctrlr and
-	 * free up the previous one.
+	 * The synchronous version used to move on to IDENTIFY_NS, but also returned
+	 *  the error from nvme_ctrlr_process_init(), which failed the controller.
+	 *  Failing it through the ERROR state keeps that outcome.
 	 */
-	spdk_free(ctrlr->active_ns_list);
-	ctrlr->active_ns_list = new_ns_list;
+	if (ctx->state == NVME_ACTIVE_NS_STATE_ERROR) {
+		nvme_ctrlr_destruct_namespaces(ctrlr);
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	} else {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS,
+				     ctrlr->opts.admin_timeout_ms);
+	}
+
+	free(ctx);
+}
+
+/*
+ * Used by the initialization state machine, so the controller doesn't block
+ *  the initialization of other controllers while the list pages are retrieved.
+ */
+static int
+nvme_ctrlr_identify_active_ns_start(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct nvme_active_ns_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+		return -ENOMEM;
+	}
+	ctx->ctrlr = ctrlr;
+	ctx->done_fn = nvme_ctrlr_init_active_ns_done;
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS,
+			     ctrlr->opts.admin_timeout_ms);
+	nvme_ctrlr_identify_active_ns_async(ctx);
 
 	return 0;
-fail:
-	spdk_free(new_ns_list);
+}
+
+static void
+nvme_active_ns_ctx_free(struct nvme_active_ns_ctx *ctx)
+{
+	free(ctx);
+}
+
+int
+nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct nvme_active_ns_ctx *ctx;
+	int rc;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+	ctx->ctrlr = ctrlr;
+
+	nvme_ctrlr_identify_active_ns_async(ctx);
+	while (ctx->state == NVME_ACTIVE_NS_STATE_PROCESSING) {
+		if (spdk_nvme_qpair_process_completions(ctrlr->adminq, 0) < 0) {
+			/* The outstanding command still references ctx, let its completion free it. */
+			ctx->done_fn = nvme_active_ns_ctx_free;
+			return -ENXIO;
+		}
+	}
+
+	rc = ctx->state == NVME_ACTIVE_NS_STATE_DONE ? 0 : -ENXIO;
+	free(ctx);
 	return rc;
 }
 
@@ -1173,7 +1394,7 @@ nvme_ctrlr_identify_ns_async(struct spdk_nvme_ns *ns)
 
 	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_NS,
 			     ctrlr->opts.admin_timeout_ms);
-	return nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id,
+	return nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id, 0,
 				       nsdata, sizeof(*nsdata),
 				       nvme_ctrlr_identify_ns_async_done, ns);
 }
@@ -1214,16 +1435,18 @@ nvme_ctrlr_identify_id_desc_async_done(void *arg, const struct spdk_nvme_cpl *cp
 	int rc;
 
 	if (spdk_nvme_cpl_is_error(cpl)) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC,
 				     ctrlr->opts.admin_timeout_ms);
 		return;
 	}
 
+	nvme_ns_set_id_desc_list_data(ns);
+
 	/* move on to the next active NS */
 	nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
 	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
 	if (ns == NULL) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC,
 				     ctrlr->opts.admin_timeout_ms);
 		return;
 	}
@@ -1240,11 +1463,12 @@ nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ns *ns)
 	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
 
 	memset(ns->id_desc_list, 0, sizeof(ns->id_desc_list));
+	ns->csi = SPDK_NVME_CSI_NVM;
 
 	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ID_DESCS,
 			     ctrlr->opts.admin_timeout_ms);
 	return nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST,
-				       0, ns->id, ns->id_desc_list, sizeof(ns->id_desc_list),
+				       0, ns->id, 0, ns->id_desc_list, sizeof(ns->id_desc_list),
 				       nvme_ctrlr_identify_id_desc_async_done, ns);
 }
 
@@ -1280,6 +1504,129 @@ nvme_ctrlr_identify_id_desc_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 	return rc;
 }
 
+static struct spdk_nvme_ns *
+nvme_ctrlr_get_next_zns_ns(struct spdk_nvme_ctrlr *ctrlr, uint32_t prev_nsid)
+{
+	struct spdk_nvme_ns *ns;
+	uint32_t nsid;
+
+	if (prev_nsid == 0) {
+		nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
+	} else {
+		nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, prev_nsid);
+	}
+
+	while (nsid != 0) {
+		ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
+		if (ns != NULL && ns->csi == SPDK_NVME_CSI_ZNS) {
+			return ns;
+		}
+		nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, nsid);
+	}
+
+	return NULL;
+}
+
+static int nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ns *ns);
+
+static void
+nvme_ctrlr_identify_ns_iocs_specific_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
+	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
+	int rc;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_ERRLOG("Failed to retrieve ZNS Identify Namespace data for ns %u\n", ns->id);
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+		return;
+	}
+
+	/* move on to the next zoned NS */
+	ns = nvme_ctrlr_get_next_zns_ns(ctrlr, ns->id);
+	if (ns == NULL) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+				     ctrlr->opts.admin_timeout_ms);
+		return;
+	}
+
+	rc = nvme_ctrlr_identify_ns_iocs_specific_async(ns);
+	if (rc) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	}
+}
+
+static int
+nvme_ctrlr_identify_ns_iocs_specific_async(struct spdk_nvme_ns *ns)
+{
+	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
+
+	if (ns->nsdata_zns == NULL) {
+		ns->nsdata_zns = spdk_zmalloc(sizeof(*ns->nsdata_zns), 64, NULL,
+					      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+		if (ns->nsdata_zns == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC,
+			     ctrlr->opts.admin_timeout_ms);
+	return nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_NS_IOCS, 0, ns->id, ns->csi,
+				       ns->nsdata_zns, sizeof(*ns->nsdata_zns),
+				       nvme_ctrlr_identify_ns_iocs_specific_async_done, ns);
+}
+
+static void
+nvme_ctrlr_identify_zns_ctrlr_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_ctrlr *ctrlr = (struct spdk_nvme_ctrlr *)arg;
+	int rc;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_ERRLOG("Failed to retrieve ZNS Identify Controller data\n");
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+		return;
+	}
+
+	rc = nvme_ctrlr_identify_ns_iocs_specific_async(nvme_ctrlr_get_next_zns_ns(ctrlr, 0));
+	if (rc) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	}
+}
+
+static int
+nvme_ctrlr_identify_iocs_specific(struct spdk_nvme_ctrlr *ctrlr)
+{
+	int rc;
+
+	if (nvme_ctrlr_get_next_zns_ns(ctrlr, 0) == NULL) {
+		/* Only the NVM command set is in use, move on to the next state */
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_CONFIGURE_AER,
+				     ctrlr->opts.admin_timeout_ms);
+		return 0;
+	}
+
+	if (ctrlr->cdata_zns == NULL) {
+		ctrlr->cdata_zns = spdk_zmalloc(sizeof(*ctrlr->cdata_zns), 64, NULL,
+						SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+		if (ctrlr->cdata_zns == NULL) {
+			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+			return -ENOMEM;
+		}
+	}
+
+	nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC,
+			     ctrlr->opts.admin_timeout_ms);
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_CTRLR_IOCS, 0, 0, SPDK_NVME_CSI_ZNS,
+				     ctrlr->cdata_zns, sizeof(*ctrlr->cdata_zns),
+				     nvme_ctrlr_identify_zns_ctrlr_async_done, ctrlr);
+	if (rc) {
+		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	}
+
+	return rc;
+}
+
 static void
 nvme_ctrlr_set_num_queues_done(void *arg, const struct spdk_nvme_cpl *cpl)
 {
@@ -2037,11 +2384,19 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 	 * Check sleep_timeout_tsc > 0 for unit test.
 	 */
 	if ((ctrlr->sleep_timeout_tsc > 0) &&
-	    (spdk_get_ticks() <= ctrlr->sleep_timeout_tsc)) {
+	    (spdk_get_ticks() < ctrlr->sleep_timeout_tsc)) {
 		return 0;
 	}
 	ctrlr->sleep_timeout_tsc = 0;
 
+	if (spdk_unlikely(ctrlr->init_phase == NVME_CTRLR_INIT_PHASE_CONSTRUCT)) {
+		/* First poll of the state machine, the transport construction has completed. */
+		ctrlr->init_phase_ticks[NVME_CTRLR_INIT_PHASE_CONSTRUCT] =
+			spdk_get_ticks() - ctrlr->init_phase_start_tsc;
+		ctrlr->init_phase = NVME_CTRLR_INIT_PHASE_DONE;
+		nvme_ctrlr_update_init_phase(ctrlr);
+	}
+
 	if (nvme_ctrlr_get_cc(ctrlr, &cc) ||
 	    nvme_ctrlr_get_csts(ctrlr, &csts)) {
 		if (ctrlr->state_timeout_tsc != NVME_TIMEOUT_INFINITE) {
@@ -2146,8 +2501,9 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 			/*
 			 * Delay 100us before setting CC.EN = 1.  Some NVMe SSDs miss CC.EN getting
 			 *  set to 1 if it is too soon after CSTS.RDY is reported as 0.
+			 *  Sleep without spinning so other controllers keep initializing.
 			 */
-			spdk_delay_us(100);
+			ctrlr->sleep_timeout_tsc = spdk_get_ticks() + (100 * spdk_get_ticks_hz() / 1000000);
 			return 0;
 		}
 		break;
@@ -2208,12 +2564,11 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 		break;
 
 	case NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS:
-		rc = nvme_ctrlr_identify_active_ns(ctrlr);
-		if (rc < 0) {
-			nvme_ctrlr_destruct_namespaces(ctrlr);
-		}
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS,
-				     ctrlr->opts.admin_timeout_ms);
+		rc = nvme_ctrlr_identify_active_ns_start(ctrlr);
+		break;
+
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS:
+		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
 		break;
 
 	case NVME_CTRLR_STATE_IDENTIFY_NS:
@@ -2232,6 +2587,14 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
 		break;
 
+	case NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC:
+		rc = nvme_ctrlr_identify_iocs_specific(ctrlr);
+		break;
+
+	case NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC:
+		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
+		break;
+
 	case NVME_CTRLR_STATE_CONFIGURE_AER:
 		rc = nvme_ctrlr_configure_aer(ctrlr);
 		break;
@@ -2242,8 +2605,10 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 
 	case NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES:
 		rc = nvme_ctrlr_set_supported_log_pages(ctrlr);
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES,
-				     ctrlr->opts.admin_timeout_ms);
+		break;
+
+	case NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_LOG_PAGES:
+		spdk_nvme_qpair_process_completions(ctrlr->adminq, 0);
 		break;
 
 	case NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES:
@@ -2293,6 +2658,14 @@ nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
 init_timeout:
 	if (ctrlr->state_timeout_tsc != NVME_TIMEOUT_INFINITE &&
 	    spdk_get_ticks() > ctrlr->state_timeout_tsc) {
+		if (ctrlr->state == NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_LOG_PAGES) {
+			/* The Intel log page directory is optional. */
+			SPDK_WARNLOG("Intel log pages not supported on Intel drive!\n");
+			nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES,
+					     ctrlr->opts.admin_timeout_ms);
+			return rc;
+		}
+
 		SPDK_ERRLOG("Initialization timed out in state %d\n", ctrlr->state);
 		nvme_ctrlr_fail(ctrlr, false);
 		return -1;
@@ -2327,6 +2700,10 @@ nvme_ctrlr_construct(struct spdk_nvme_ctrlr *ctrlr)
 {
 	int rc;
 
+	memset(ctrlr->init_phase_ticks, 0, sizeof(ctrlr->init_phase_ticks));
+	ctrlr->init_phase = NVME_CTRLR_INIT_PHASE_CONSTRUCT;
+	ctrlr->init_phase_start_tsc = spdk_get_ticks();
+
 	if (ctrlr->trid.trtype == SPDK_NVME_TRANSPORT_PCIE) {
 		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_INIT_DELAY, NVME_TIMEOUT_INFINITE);
 	} else {
@@ -2408,6 +2785,9 @@ nvme_ctrlr_destruct(struct spdk_nvme_ctrlr *ctrlr)
 
 	nvme_ctrlr_destruct_namespaces(ctrlr);
 
+	spdk_free(ctrlr->cdata_zns);
+	ctrlr->cdata_zns = NULL;
+
 	spdk_bit_array_free(&ctrlr->free_io_qids);
 
 	nvme_transport_ctrlr_destruct(ctrlr);
@@ -2953,6 +3333,22 @@ spdk_nvme_ctrlr_get_flags(struct spdk_nvme_ctrlr *ctrlr)
 	return ctrlr->flags;
 }
 
+void
+spdk_nvme_ctrlr_get_init_stats(struct spdk_nvme_ctrlr *ctrlr,
+			       struct spdk_nvme_ctrlr_init_stats *stats)
+{
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint64_t *ticks = ctrlr->init_phase_ticks;
+
+	stats->construct_us = ticks[NVME_CTRLR_INIT_PHASE_CONSTRUCT] * SPDK_SEC_TO_USEC / ticks_hz;
+	stats->enable_us = ticks[NVME_CTRLR_INIT_PHASE_ENABLE] * SPDK_SEC_TO_USEC / ticks_hz;
+	stats->identify_us = ticks[NVME_CTRLR_INIT_PHASE_IDENTIFY] * SPDK_SEC_TO_USEC / ticks_hz;
+	stats->namespaces_us = ticks[NVME_CTRLR_INIT_PHASE_NAMESPACES] * SPDK_SEC_TO_USEC / ticks_hz;
+	stats->configure_us = ticks[NVME_CTRLR_INIT_PHASE_CONFIGURE] * SPDK_SEC_TO_USEC / ticks_hz;
+	stats->total_us = stats->construct_us + stats->enable_us + stats->identify_us +
+			  stats->namespaces_us + stats->configure_us;
+}
+
 const struct spdk_nvme_transport_id *
 spdk_nvme_ctrlr_get_transport_id(struct spdk_nvme_ctrlr *ctrlr)
 {
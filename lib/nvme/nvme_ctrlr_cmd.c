@@ -126,7 +126,7 @@ spdk_nvme_ctrlr_cmd_admin_raw(struct spdk_nvme_ctrlr *ctrlr,
 
 int
 nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cntid, uint32_t nsid,
-			void *payload, size_t payload_size,
+			uint8_t csi, void *payload, size_t payload_size,
 			spdk_nvme_cmd_cb cb_fn, void *cb_arg)
 {
 	struct nvme_request *req;
@@ -142,6 +142,7 @@ nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cnt
 	cmd = &req->cmd;
 	cmd->opc = SPDK_NVME_OPC_IDENTIFY;
 	cmd->cdw10 = cns | ((uint32_t)cntid << 16);
+	cmd->cdw11 = (uint32_t)csi << 24;
 	cmd->nsid = nsid;
 
 	return nvme_ctrlr_submit_admin_request(ctrlr, req);
@@ -608,6 +609,187 @@ spdk_nvme_ctrlr_cmd_abort(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair
 	return rc;
 }
 
+struct nvme_ctrlr_abort_ext_ctx {
+	struct spdk_nvme_ctrlr	*ctrlr;
+	struct spdk_nvme_qpair	*qpair;
+	void			*cmd_cb_arg;
+	spdk_nvme_cmd_cb	cb_fn;
+	void			*cb_arg;
+	uint32_t		outstanding;
+	uint32_t		num_aborted;
+	int			rc;
+	struct spdk_nvme_cpl	cpl;
+};
+
+STAILQ_HEAD(nvme_abort_ext_reqs, nvme_request);
+
+static void
+nvme_ctrlr_cmd_abort_ext_done(struct nvme_ctrlr_abort_ext_ctx *ctx)
+{
+	ctx->cb_fn(ctx->cb_arg, &ctx->cpl);
+	free(ctx);
+}
+
+static void
+nvme_ctrlr_cmd_abort_ext_cpl(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_ctrlr_abort_ext_ctx *ctx = arg;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		ctx->cpl.status = cpl->status;
+	}
+	/* Bit 0 of dword 0 is set if the command was not aborted. */
+	ctx->cpl.cdw0 |= cpl->cdw0 & 0x1;
+
+	assert(ctx->outstanding > 0);
+	if (--ctx->outstanding == 0) {
+		nvme_ctrlr_cmd_abort_ext_done(ctx);
+	}
+}
+
+static int
+nvme_ctrlr_cmd_abort_ext_iter(struct nvme_request *req, void *arg)
+{
+	struct nvme_ctrlr_abort_ext_ctx *ctx = arg;
+	int rc;
+
+	if (req->cb_arg != ctx->cmd_cb_arg &&
+	    (req->parent == NULL || req->parent->cb_arg != ctx->cmd_cb_arg)) {
+		return 0;
+	}
+
+	rc = spdk_nvme_ctrlr_cmd_abort(ctx->ctrlr, ctx->qpair, req->cmd.cid,
+				       nvme_ctrlr_cmd_abort_ext_cpl, ctx);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit abort for cid %u: rc = %d\n", req->cmd.cid, rc);
+		ctx->rc = rc;
+		return rc;
+	}
+
+	ctx->outstanding++;
+	return 0;
+}
+
+/*
+ * Requests still waiting on the qpair's queue have no command ID yet, so they
+ *  are taken off the queue here and completed by the caller instead of being
+ *  aborted by the controller.
+ */
+static void
+nvme_ctrlr_dequeue_queued_reqs(struct spdk_nvme_qpair *qpair, struct nvme_ctrlr_abort_ext_ctx *ctx,
+			       struct nvme_abort_ext_reqs *aborting)
+{
+	STAILQ_HEAD(, nvme_request) tmp;
+	struct nvme_request *req;
+
+	STAILQ_INIT(&tmp);
+
+	while (!STAILQ_EMPTY(&qpair->queued_req)) {
+		req = STAILQ_FIRST(&qpair->queued_req);
+		STAILQ_REMOVE_HEAD(&qpair->queued_req, stailq);
+		if (req->cb_arg == ctx->cmd_cb_arg ||
+		    (req->parent != NULL && req->parent->cb_arg == ctx->cmd_cb_arg)) {
+			STAILQ_INSERT_TAIL(aborting, req, stailq);
+			ctx->num_aborted++;
+		} else {
+			STAILQ_INSERT_TAIL(&tmp, req, stailq);
+		}
+	}
+	STAILQ_SWAP(&tmp, &qpair->queued_req, nvme_request);
+}
+
+static void
+nvme_ctrlr_complete_aborted_reqs(struct spdk_nvme_qpair *qpair,
+				 struct nvme_abort_ext_reqs *aborting)
+{
+	struct nvme_request *req;
+	struct spdk_nvme_cpl cpl;
+
+	memset(&cpl, 0, sizeof(cpl));
+	cpl.sqid = qpair->id;
+	cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+	cpl.status.sc = SPDK_NVME_SC_ABORTED_BY_REQUEST;
+	cpl.status.dnr = 1;
+
+	while (!STAILQ_EMPTY(aborting)) {
+		req = STAILQ_FIRST(aborting);
+		STAILQ_REMOVE_HEAD(aborting, stailq);
+		nvme_complete_request(req->cb_fn, req->cb_arg, qpair, req, &cpl);
+		nvme_free_request(req);
+	}
+}
+
+int
+spdk_nvme_ctrlr_cmd_abort_ext(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair,
+			      void *cmd_cb_arg, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct nvme_ctrlr_abort_ext_ctx *ctx;
+	struct spdk_nvme_qpair *target_qpair;
+	struct nvme_abort_ext_reqs aborting;
+	bool submitted;
+	int rc;
+
+	if (cmd_cb_arg == NULL || cb_fn == NULL) {
+		return -EINVAL;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->ctrlr = ctrlr;
+	ctx->qpair = qpair;
+	ctx->cmd_cb_arg = cmd_cb_arg;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+	ctx->cpl.status.sc = SPDK_NVME_SC_SUCCESS;
+
+	target_qpair = qpair ? qpair : ctrlr->adminq;
+	STAILQ_INIT(&aborting);
+
+	nvme_robust_mutex_lock(&ctrlr->ctrlr_lock);
+
+	nvme_ctrlr_dequeue_queued_reqs(target_qpair, ctx, &aborting);
+
+	/*
+	 * Hold an extra reference so that aborts completing while the qpair is
+	 *  still being iterated cannot complete the whole request early.
+	 */
+	ctx->outstanding = 1;
+	nvme_transport_qpair_iterate_requests(target_qpair, nvme_ctrlr_cmd_abort_ext_iter, ctx);
+	rc = ctx->rc;
+	submitted = ctx->outstanding > 1;
+
+	nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
+
+	/* Completion callbacks may submit new requests, so they run without the lock held. */
+	nvme_ctrlr_complete_aborted_reqs(target_qpair, &aborting);
+
+	if (!submitted) {
+		if (ctx->num_aborted == 0) {
+			/* Nothing matched, or no abort could be submitted at all. */
+			free(ctx);
+			return rc != 0 ? rc : -ENOENT;
+		}
+
+		/* Only queued requests were found and they are all aborted already. */
+		nvme_ctrlr_cmd_abort_ext_done(ctx);
+		return 0;
+	}
+
+	if (rc != 0) {
+		ctx->cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+	}
+
+	/* Drop the extra reference, the aborts may all have completed already. */
+	if (--ctx->outstanding == 0) {
+		nvme_ctrlr_cmd_abort_ext_done(ctx);
+	}
+	return 0;
+}
+
 int
 nvme_ctrlr_cmd_fw_commit(struct spdk_nvme_ctrlr *ctrlr,
 			 const struct spdk_nvme_fw_commit *fw_commit,
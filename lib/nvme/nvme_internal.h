@@ -52,6 +52,7 @@
 #include "spdk/util.h"
 #include "spdk/nvme_intel.h"
 #include "spdk/nvmf_spec.h"
+#include "spdk/nvme_zns_spec.h"
 #include "spdk/uuid.h"
 
 #include "spdk_internal/assert.h"
@@ -394,8 +395,14 @@ struct spdk_nvme_ns {
 	uint32_t			id;
 	uint16_t			flags;
 
+	/* Command Set Identifier reported in the Namespace Identification Descriptor List */
+	enum spdk_nvme_csi		csi;
+
 	/* Namespace Identification Descriptor List (CNS = 03h) */
 	uint8_t				id_desc_list[4096];
+
+	/* Zoned Namespace Command Set specific Identify Namespace data (CNS = 05h, CSI = 02h) */
+	struct spdk_nvme_zns_ns_data	*nsdata_zns;
 };
 
 /**
@@ -477,6 +484,11 @@ enum nvme_ctrlr_state {
 	 */
 	NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS,
 
+	/**
+	 * Waiting for the Identify Active Namespace commands to be completed.
+	 */
+	NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ACTIVE_NS,
+
 	/**
 	 * Get Identify Namespace Data structure for each NS.
 	 */
@@ -498,6 +510,16 @@ enum nvme_ctrlr_state {
 	 */
 	NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_ID_DESCS,
 
+	/**
+	 * Get I/O Command Set specific Identify data of the controller and namespaces.
+	 */
+	NVME_CTRLR_STATE_IDENTIFY_IOCS_SPECIFIC,
+
+	/**
+	 * Waiting for the I/O Command Set specific Identify commands to be completed.
+	 */
+	NVME_CTRLR_STATE_WAIT_FOR_IDENTIFY_IOCS_SPECIFIC,
+
 	/**
 	 * Configure AER of the controller.
 	 */
@@ -513,6 +535,11 @@ enum nvme_ctrlr_state {
 	 */
 	NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES,
 
+	/**
+	 * Waiting for the vendor specific log page directory to be retrieved.
+	 */
+	NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_LOG_PAGES,
+
 	/**
 	 * Set supported features of the controller.
 	 */
@@ -561,6 +588,29 @@ enum nvme_ctrlr_state {
 
 #define NVME_TIMEOUT_INFINITE	UINT64_MAX
 
+/**
+ * Phases of controller initialization, used to account the time spent in each of them.
+ */
+enum nvme_ctrlr_init_phase {
+	/** Transport specific construction, including the admin queue connection. */
+	NVME_CTRLR_INIT_PHASE_CONSTRUCT,
+
+	/** Controller reset and enable (CC.EN / CSTS.RDY handshake). */
+	NVME_CTRLR_INIT_PHASE_ENABLE,
+
+	/** Identify Controller and I/O queue count negotiation. */
+	NVME_CTRLR_INIT_PHASE_IDENTIFY,
+
+	/** Active namespace list and per namespace identify data. */
+	NVME_CTRLR_INIT_PHASE_NAMESPACES,
+
+	/** AER, log pages, features, doorbell buffer, keep alive and host ID. */
+	NVME_CTRLR_INIT_PHASE_CONFIGURE,
+
+	/** Initialization has completed or failed. */
+	NVME_CTRLR_INIT_PHASE_DONE,
+};
+
 /*
  * Used to track properties for all processes accessing the controller.
  */
@@ -673,6 +723,12 @@ struct spdk_nvme_ctrlr {
 	 */
 	struct spdk_nvme_ctrlr_data	cdata;
 
+	/**
+	 * Zoned Namespace Command Set specific Identify Controller data,
+	 * only retrieved if the controller has zoned namespaces.
+	 */
+	struct spdk_nvme_zns_ctrlr_data	*cdata_zns;
+
 	/**
 	 * Keep track of active namespaces
 	 */
@@ -695,6 +751,11 @@ struct spdk_nvme_ctrlr {
 	/* Extra sleep time during controller initialization */
 	uint64_t			sleep_timeout_tsc;
 
+	/* Time spent in each phase of the most recent initialization, in ticks */
+	uint64_t			init_phase_ticks[NVME_CTRLR_INIT_PHASE_DONE];
+	enum nvme_ctrlr_init_phase	init_phase;
+	uint64_t			init_phase_start_tsc;
+
 	/** Track all the processes manage this controller */
 	TAILQ_HEAD(, spdk_nvme_ctrlr_process)	active_procs;
 
@@ -710,6 +771,8 @@ struct spdk_nvme_probe_ctx {
 	spdk_nvme_attach_cb			attach_cb;
 	spdk_nvme_remove_cb			remove_cb;
 	TAILQ_HEAD(, spdk_nvme_ctrlr)		init_ctrlrs;
+	/* Set once any of the controllers failed to initialize */
+	int					rc;
 };
 
 struct nvme_driver {
@@ -762,7 +825,7 @@ nvme_robust_mutex_unlock(pthread_mutex_t *mtx)
 
 /* Admin functions */
 int	nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr,
-				uint8_t cns, uint16_t cntid, uint32_t nsid,
+				uint8_t cns, uint16_t cntid, uint32_t nsid, uint8_t csi,
 				void *payload, size_t payload_size,
 				spdk_nvme_cmd_cb cb_fn, void *cb_arg);
 int	nvme_ctrlr_cmd_set_num_queues(struct spdk_nvme_ctrlr *ctrlr,
@@ -851,6 +914,7 @@ int	nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 
 int	nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr);
 void	nvme_ns_set_identify_data(struct spdk_nvme_ns *ns);
+void	nvme_ns_set_id_desc_list_data(struct spdk_nvme_ns *ns);
 int	nvme_ns_construct(struct spdk_nvme_ns *ns, uint32_t id,
 			  struct spdk_nvme_ctrlr *ctrlr);
 void	nvme_ns_destruct(struct spdk_nvme_ns *ns);
@@ -1049,8 +1113,30 @@ nvme_request_free_children(struct nvme_request *req)
 	}
 }
 
+/*
+ * Returns false if a request can never hit the controller timeout, either
+ *  because it already did, it was submitted while timeouts were disabled or
+ *  it is an AER, which is expected to stay outstanding indefinitely.
+ */
+static inline bool
+nvme_request_has_timeout(struct nvme_request *req)
+{
+	if (req->timed_out || req->submit_tick == 0) {
+		return false;
+	}
+
+	if (nvme_qpair_is_admin_queue(req->qpair) &&
+	    req->cmd.opc == SPDK_NVME_OPC_ASYNC_EVENT_REQUEST) {
+		return false;
+	}
+
+	return true;
+}
+
 int	nvme_request_check_timeout(struct nvme_request *req, uint16_t cid,
 				   struct spdk_nvme_ctrlr_process *active_proc, uint64_t now_tick);
+void	nvme_request_timeout(struct nvme_request *req, uint16_t cid,
+			     struct spdk_nvme_ctrlr_process *active_proc);
 uint64_t nvme_get_quirks(const struct spdk_pci_id *id);
 
 int	nvme_robust_mutex_init_shared(pthread_mutex_t *mtx);
@@ -1083,6 +1169,7 @@ struct spdk_nvme_ctrlr *spdk_nvme_get_ctrlr_by_trid_unsafe(
 	void nvme_ ## name ## _ctrlr_disconnect_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair); \
 	void nvme_ ## name ## _qpair_abort_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr); \
 	int nvme_ ## name ## _qpair_reset(struct spdk_nvme_qpair *qpair); \
+	int nvme_ ## name ## _qpair_iterate_requests(struct spdk_nvme_qpair *qpair, int (*iter_fn)(struct nvme_request *req, void *arg), void *arg); \
 	int nvme_ ## name ## _qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req); \
 	int32_t nvme_ ## name ## _qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_completions); \
 	void nvme_ ## name ## _admin_qpair_abort_aers(struct spdk_nvme_qpair *qpair); \
@@ -110,7 +110,7 @@ nvme_ctrlr_identify_ns(struct spdk_nvme_ns *ns)
 	int					rc;
 
 	nsdata = _nvme_ns_get_data(ns);
-	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id,
+	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS, 0, ns->id, 0,
 				     nsdata, sizeof(*nsdata),
 				     nvme_completion_poll_cb, &status);
 	if (rc != 0) {
@@ -145,7 +145,7 @@ nvme_ctrlr_identify_id_desc(struct spdk_nvme_ns *ns)
 	}
 
 	SPDK_DEBUGLOG(SPDK_LOG_NVME, "Attempting to retrieve NS ID Descriptor List\n");
-	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST, 0, ns->id,
+	rc = nvme_ctrlr_cmd_identify(ns->ctrlr, SPDK_NVME_IDENTIFY_NS_ID_DESCRIPTOR_LIST, 0, ns->id, 0,
 				     ns->id_desc_list, sizeof(ns->id_desc_list),
 				     nvme_completion_poll_cb, &status);
 	if (rc < 0) {
@@ -158,9 +158,69 @@ nvme_ctrlr_identify_id_desc(struct spdk_nvme_ns *ns)
 		memset(ns->id_desc_list, 0, sizeof(ns->id_desc_list));
 	}
 
+	nvme_ns_set_id_desc_list_data(ns);
+
 	return rc;
 }
 
+static int
+nvme_ctrlr_identify_ns_iocs_specific(struct spdk_nvme_ns *ns)
+{
+	struct spdk_nvme_ctrlr			*ctrlr = ns->ctrlr;
+	struct nvme_completion_poll_status	status;
+	int					rc;
+
+	if (ns->csi != SPDK_NVME_CSI_ZNS) {
+		return 0;
+	}
+
+	if (ctrlr->cdata_zns == NULL) {
+		ctrlr->cdata_zns = spdk_zmalloc(sizeof(*ctrlr->cdata_zns), 64, NULL,
+						SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+		if (ctrlr->cdata_zns == NULL) {
+			return -ENOMEM;
+		}
+
+		rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_CTRLR_IOCS, 0, 0, SPDK_NVME_CSI_ZNS,
+					     ctrlr->cdata_zns, sizeof(*ctrlr->cdata_zns),
+					     nvme_completion_poll_cb, &status);
+		if (rc == 0) {
+			rc = spdk_nvme_wait_for_completion_robust_lock(ctrlr->adminq, &status,
+					&ctrlr->ctrlr_lock) ? -ENXIO : 0;
+		}
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to retrieve ZNS Identify Controller data\n");
+			spdk_free(ctrlr->cdata_zns);
+			ctrlr->cdata_zns = NULL;
+			return rc;
+		}
+	}
+
+	if (ns->nsdata_zns == NULL) {
+		ns->nsdata_zns = spdk_zmalloc(sizeof(*ns->nsdata_zns), 64, NULL,
+					      SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+		if (ns->nsdata_zns == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	rc = nvme_ctrlr_cmd_identify(ctrlr, SPDK_NVME_IDENTIFY_NS_IOCS, 0, ns->id, ns->csi,
+				     ns->nsdata_zns, sizeof(*ns->nsdata_zns),
+				     nvme_completion_poll_cb, &status);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (spdk_nvme_wait_for_completion_robust_lock(ctrlr->adminq, &status, &ctrlr->ctrlr_lock)) {
+		SPDK_ERRLOG("Failed to retrieve ZNS Identify Namespace data for ns %u\n", ns->id);
+		spdk_free(ns->nsdata_zns);
+		ns->nsdata_zns = NULL;
+		return -ENXIO;
+	}
+
+	return 0;
+}
+
 uint32_t
 spdk_nvme_ns_get_id(struct spdk_nvme_ns *ns)
 {
@@ -308,6 +368,30 @@ _spdk_nvme_ns_find_id_desc(const struct spdk_nvme_ns *ns, enum spdk_nvme_nidt ty
 	return NULL;
 }
 
+/**
+ * Update the Command Set Identifier of the namespace based on
+ * its Namespace Identification Descriptor List.
+ */
+void
+nvme_ns_set_id_desc_list_data(struct spdk_nvme_ns *ns)
+{
+	const uint8_t *csi;
+	size_t csi_size;
+
+	csi = _spdk_nvme_ns_find_id_desc(ns, SPDK_NVME_NIDT_CSI, &csi_size);
+	if (csi == NULL || csi_size != sizeof(*csi)) {
+		ns->csi = SPDK_NVME_CSI_NVM;
+		return;
+	}
+
+	ns->csi = (enum spdk_nvme_csi)*csi;
+}
+
+enum spdk_nvme_csi
+spdk_nvme_ns_get_csi(const struct spdk_nvme_ns *ns) {
+	return ns->csi;
+}
+
 const struct spdk_uuid *
 spdk_nvme_ns_get_uuid(const struct spdk_nvme_ns *ns)
 {
@@ -337,7 +421,12 @@ int nvme_ns_construct(struct spdk_nvme_ns *ns, uint32_t id,
 		return rc;
 	}
 
-	return nvme_ctrlr_identify_id_desc(ns);
+	rc = nvme_ctrlr_identify_id_desc(ns);
+	if (rc != 0) {
+		return rc;
+	}
+
+	return nvme_ctrlr_identify_ns_iocs_specific(ns);
 }
 
 void nvme_ns_destruct(struct spdk_nvme_ns *ns)
@@ -357,4 +446,8 @@ void nvme_ns_destruct(struct spdk_nvme_ns *ns)
 	ns->sectors_per_max_io = 0;
 	ns->sectors_per_stripe = 0;
 	ns->flags = 0;
+	ns->csi = SPDK_NVME_CSI_NVM;
+
+	spdk_free(ns->nsdata_zns);
+	ns->nsdata_zns = NULL;
 }
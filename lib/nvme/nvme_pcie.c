@@ -37,6 +37,7 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/bit_array.h"
 #include "spdk/env.h"
 #include "spdk/likely.h"
 #include "nvme_internal.h"
@@ -51,6 +52,12 @@
 
 #define NVME_ADMIN_ENTRIES	(128)
 
+/*
+ * Granularity of controller memory buffer allocations.  Both submission
+ *  queues and I/O data buffers are carved out of the CMB in units of this size.
+ */
+#define NVME_PCIE_CMB_PAGE_SIZE	(0x1000)
+
 /*
  * NVME_MAX_SGL_DESCRIPTORS defines the maximum number of descriptors in one SGL
  *  segment.
@@ -84,12 +91,18 @@ struct nvme_pcie_ctrlr {
 	/* Controller memory buffer size in Bytes */
 	uint64_t cmb_size;
 
-	/* Current offset of controller memory buffer, relative to start of BAR virt addr */
+	/* First allocatable offset of controller memory buffer, relative to start of BAR virt addr */
 	uint64_t cmb_current_offset;
 
 	/* Last valid offset into CMB, this differs if CMB memory registration occurs or not */
 	uint64_t cmb_max_offset;
 
+	/* One bit per NVME_PCIE_CMB_PAGE_SIZE page of the CMB, starting at cmb_current_offset */
+	struct spdk_bit_array *cmb_page_map;
+
+	/* No page below this index is free, allocations start searching here */
+	uint32_t cmb_first_free_page;
+
 	void *cmb_mem_register_addr;
 	size_t cmb_mem_register_size;
 
@@ -114,7 +127,9 @@ struct nvme_tracker {
 	struct nvme_request		*req;
 	uint16_t			cid;
 
-	uint16_t			rsvd0;
+	/* Set if the tracker is on the qpair's untimed_tr list instead of outstanding_tr. */
+	uint16_t			untimed : 1;
+	uint16_t			rsvd0 : 15;
 	uint32_t			rsvd1;
 
 	spdk_nvme_cmd_cb		cb_fn;
@@ -149,8 +164,20 @@ struct nvme_pcie_qpair {
 	struct spdk_nvme_cpl *cpl;
 
 	TAILQ_HEAD(, nvme_tracker) free_tr;
+
+	/*
+	 * Outstanding trackers whose requests may still time out, ordered by submit
+	 *  tick so that the timeout check can stop at the first request that has not
+	 *  expired yet.
+	 */
 	TAILQ_HEAD(nvme_outstanding_tr_head, nvme_tracker) outstanding_tr;
 
+	/*
+	 * Outstanding trackers whose requests cannot time out (anymore): AERs, requests
+	 *  submitted while timeouts were disabled and requests that already timed out.
+	 */
+	struct nvme_outstanding_tr_head untimed_tr;
+
 	/* Array of trackers indexed by command ID. */
 	struct nvme_tracker *tr;
 
@@ -470,6 +497,33 @@ nvme_pcie_ctrlr_get_max_sges(struct spdk_nvme_ctrlr *ctrlr)
 	return NVME_MAX_SGL_DESCRIPTORS;
 }
 
+static int
+nvme_pcie_ctrlr_init_cmb_page_map(struct nvme_pcie_ctrlr *pctrlr)
+{
+	uint64_t start, num_pages;
+
+	start = (pctrlr->cmb_current_offset + NVME_PCIE_CMB_PAGE_SIZE - 1) & ~((uint64_t)NVME_PCIE_CMB_PAGE_SIZE - 1);
+	if (start >= pctrlr->cmb_max_offset) {
+		return -EINVAL;
+	}
+
+	num_pages = (pctrlr->cmb_max_offset - start) / NVME_PCIE_CMB_PAGE_SIZE;
+	if (num_pages == 0 || num_pages >= UINT32_MAX) {
+		return -EINVAL;
+	}
+
+	pctrlr->cmb_page_map = spdk_bit_array_create(num_pages);
+	if (pctrlr->cmb_page_map == NULL) {
+		SPDK_ERRLOG("Failed to allocate CMB page map\n");
+		return -ENOMEM;
+	}
+
+	pctrlr->cmb_current_offset = start;
+	pctrlr->cmb_first_free_page = 0;
+
+	return 0;
+}
+
 static void
 nvme_pcie_ctrlr_map_cmb(struct nvme_pcie_ctrlr *pctrlr)
 {
@@ -530,6 +584,9 @@ nvme_pcie_ctrlr_map_cmb(struct nvme_pcie_ctrlr *pctrlr)
 
 	/* If only SQS is supported use legacy mapping */
 	if (cmbsz.bits.sqs && !(cmbsz.bits.wds || cmbsz.bits.rds)) {
+		if (nvme_pcie_ctrlr_init_cmb_page_map(pctrlr) != 0) {
+			goto exit;
+		}
 		return;
 	}
 
@@ -550,7 +607,14 @@ nvme_pcie_ctrlr_map_cmb(struct nvme_pcie_ctrlr *pctrlr)
 	}
 	pctrlr->cmb_current_offset = mem_register_start - ((uint64_t)pctrlr->cmb_bar_virt_addr);
 	pctrlr->cmb_max_offset = mem_register_end - ((uint64_t)pctrlr->cmb_bar_virt_addr);
+
+	if (nvme_pcie_ctrlr_init_cmb_page_map(pctrlr) != 0) {
+		spdk_mem_unregister(pctrlr->cmb_mem_register_addr, pctrlr->cmb_mem_register_size);
+		pctrlr->cmb_mem_register_addr = NULL;
+		goto exit;
+	}
 	pctrlr->cmb_io_data_supported = true;
+	pctrlr->ctrlr.flags |= SPDK_NVME_CTRLR_CMB_IO_DATA_SUPPORTED;
 
 	return;
 exit:
@@ -571,6 +635,8 @@ nvme_pcie_ctrlr_unmap_cmb(struct nvme_pcie_ctrlr *pctrlr)
 			spdk_mem_unregister(pctrlr->cmb_mem_register_addr, pctrlr->cmb_mem_register_size);
 		}
 
+		spdk_bit_array_free(&pctrlr->cmb_page_map);
+
 		if (nvme_pcie_ctrlr_get_cmbloc(pctrlr, &cmbloc)) {
 			SPDK_ERRLOG("get_cmbloc() failed\n");
 			return -EIO;
@@ -585,21 +651,72 @@ nvme_pcie_ctrlr_alloc_cmb(struct spdk_nvme_ctrlr *ctrlr, uint64_t length, uint64
 			  uint64_t *offset)
 {
 	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(ctrlr);
+	struct spdk_bit_array *map = pctrlr->cmb_page_map;
 	uint64_t round_offset;
+	uint32_t first_free, first, used, num_pages, num_total, i;
 
-	round_offset = pctrlr->cmb_current_offset;
-	round_offset = (round_offset + (aligned - 1)) & ~(aligned - 1);
-
-	/* CMB may only consume part of the BAR, calculate accordingly */
-	if (round_offset + length > pctrlr->cmb_max_offset) {
-		SPDK_ERRLOG("Tried to allocate past valid CMB range!\n");
+	if (map == NULL || length == 0) {
 		return -1;
 	}
 
-	*offset = round_offset;
-	pctrlr->cmb_current_offset = round_offset + length;
+	aligned = spdk_max(aligned, NVME_PCIE_CMB_PAGE_SIZE);
+	num_pages = SPDK_CEIL_DIV(length, NVME_PCIE_CMB_PAGE_SIZE);
+	num_total = spdk_bit_array_capacity(map);
 
-	return 0;
+	/*
+	 * First fit search over the runs of free CMB pages. Both ends of a run
+	 *  are found a word of the page map at a time.
+	 */
+	first_free = spdk_bit_array_find_first_clear(map, pctrlr->cmb_first_free_page);
+	first = first_free;
+	while (first != UINT32_MAX) {
+		round_offset = pctrlr->cmb_current_offset + (uint64_t)first * NVME_PCIE_CMB_PAGE_SIZE;
+		round_offset = (round_offset + (aligned - 1)) & ~(aligned - 1);
+		first = (round_offset - pctrlr->cmb_current_offset) / NVME_PCIE_CMB_PAGE_SIZE;
+
+		/* CMB may only consume part of the BAR, calculate accordingly */
+		if ((uint64_t)first + num_pages > num_total) {
+			break;
+		}
+
+		used = spdk_bit_array_find_first_set(map, first);
+		if (used == UINT32_MAX || used >= first + num_pages) {
+			for (i = first; i < first + num_pages; i++) {
+				spdk_bit_array_set(map, i);
+			}
+			if (first == first_free) {
+				pctrlr->cmb_first_free_page = first + num_pages;
+			}
+			*offset = round_offset;
+			return 0;
+		}
+
+		first = spdk_bit_array_find_first_clear(map, used);
+	}
+
+	SPDK_DEBUGLOG(SPDK_LOG_NVME, "No free CMB range for %" PRIu64 " bytes\n", length);
+	return -1;
+}
+
+static void
+nvme_pcie_ctrlr_free_cmb(struct spdk_nvme_ctrlr *ctrlr, uint64_t offset, uint64_t length)
+{
+	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(ctrlr);
+	uint32_t first, num_pages, i;
+
+	assert(pctrlr->cmb_page_map != NULL);
+	assert(offset >= pctrlr->cmb_current_offset);
+	assert(offset + length <= pctrlr->cmb_max_offset);
+
+	first = (offset - pctrlr->cmb_current_offset) / NVME_PCIE_CMB_PAGE_SIZE;
+	num_pages = SPDK_CEIL_DIV(length, NVME_PCIE_CMB_PAGE_SIZE);
+
+	for (i = first; i < first + num_pages; i++) {
+		assert(spdk_bit_array_get(pctrlr->cmb_page_map, i));
+		spdk_bit_array_clear(pctrlr->cmb_page_map, i);
+	}
+
+	pctrlr->cmb_first_free_page = spdk_min(pctrlr->cmb_first_free_page, first);
 }
 
 volatile struct spdk_nvme_registers *
@@ -637,12 +754,23 @@ nvme_pcie_ctrlr_alloc_cmb_io_buffer(struct spdk_nvme_ctrlr *ctrlr, size_t size)
 int
 nvme_pcie_ctrlr_free_cmb_io_buffer(struct spdk_nvme_ctrlr *ctrlr, void *buf, size_t size)
 {
-	/*
-	 * Do nothing for now.
-	 * TODO: Track free space so buffers may be reused.
-	 */
-	SPDK_ERRLOG("%s: no deallocation for CMB buffers yet!\n",
-		    __func__);
+	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(ctrlr);
+	uint64_t offset;
+
+	if (pctrlr->cmb_bar_virt_addr == NULL || !pctrlr->cmb_io_data_supported) {
+		return -EINVAL;
+	}
+
+	offset = (uintptr_t)buf - (uintptr_t)pctrlr->cmb_bar_virt_addr;
+	if ((uintptr_t)buf < (uintptr_t)pctrlr->cmb_bar_virt_addr ||
+	    offset < pctrlr->cmb_current_offset ||
+	    offset + size > pctrlr->cmb_max_offset) {
+		SPDK_ERRLOG("%p is not a CMB buffer of this controller\n", buf);
+		return -EINVAL;
+	}
+
+	nvme_pcie_ctrlr_free_cmb(ctrlr, offset, size);
+
 	return 0;
 }
 
@@ -1117,6 +1245,7 @@ nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 
 	TAILQ_INIT(&pqpair->free_tr);
 	TAILQ_INIT(&pqpair->outstanding_tr);
+	TAILQ_INIT(&pqpair->untimed_tr);
 
 	for (i = 0; i < num_trackers; i++) {
 		tr = &pqpair->tr[i];
@@ -1211,10 +1340,14 @@ nvme_pcie_qpair_complete_pending_admin_request(struct spdk_nvme_qpair *qpair)
 	}
 }
 
+/*
+ * The controller asks to be notified through MMIO once the doorbell moves
+ *  past its EventIdx, i.e. when event_idx lies in [old, new_idx).
+ */
 static inline int
 nvme_pcie_qpair_need_event(uint16_t event_idx, uint16_t new_idx, uint16_t old)
 {
-	return (uint16_t)(new_idx - event_idx) <= (uint16_t)(new_idx - old);
+	return (uint16_t)(new_idx - event_idx - 1) < (uint16_t)(new_idx - old);
 }
 
 static bool
@@ -1228,9 +1361,18 @@ nvme_pcie_qpair_update_mmio_required(struct spdk_nvme_qpair *qpair, uint16_t val
 		return true;
 	}
 
+	/* Queue entries must be visible before the shadow doorbell moves. */
+	spdk_wmb();
+
 	old = *shadow_db;
 	*shadow_db = value;
 
+	/*
+	 * Make sure the shadow doorbell update is visible before EventIdx is read,
+	 *  otherwise a controller that just went idle could miss the update.
+	 */
+	spdk_mb();
+
 	if (!nvme_pcie_qpair_need_event(*eventidx, value, old)) {
 		return false;
 	}
@@ -1348,7 +1490,11 @@ nvme_pcie_qpair_complete_tracker(struct spdk_nvme_qpair *qpair, struct nvme_trac
 
 		tr->req = NULL;
 
-		TAILQ_REMOVE(&pqpair->outstanding_tr, tr, tq_list);
+		if (tr->untimed) {
+			TAILQ_REMOVE(&pqpair->untimed_tr, tr, tq_list);
+		} else {
+			TAILQ_REMOVE(&pqpair->outstanding_tr, tr, tq_list);
+		}
 		TAILQ_INSERT_HEAD(&pqpair->free_tr, tr, tq_list);
 
 		/*
@@ -1382,15 +1528,15 @@ nvme_pcie_qpair_manual_complete_tracker(struct spdk_nvme_qpair *qpair,
 }
 
 static void
-nvme_pcie_qpair_abort_trackers(struct spdk_nvme_qpair *qpair, uint32_t dnr)
+nvme_pcie_qpair_abort_tracker_list(struct spdk_nvme_qpair *qpair,
+				   struct nvme_outstanding_tr_head *head, uint32_t dnr)
 {
-	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
 	struct nvme_tracker *tr, *temp, *last;
 
-	last = TAILQ_LAST(&pqpair->outstanding_tr, nvme_outstanding_tr_head);
+	last = TAILQ_LAST(head, nvme_outstanding_tr_head);
 
 	/* Abort previously submitted (outstanding) trs */
-	TAILQ_FOREACH_SAFE(tr, &pqpair->outstanding_tr, tq_list, temp) {
+	TAILQ_FOREACH_SAFE(tr, head, tq_list, temp) {
 		if (!qpair->ctrlr->opts.disable_error_logging) {
 			SPDK_ERRLOG("aborting outstanding command\n");
 		}
@@ -1403,26 +1549,68 @@ nvme_pcie_qpair_abort_trackers(struct spdk_nvme_qpair *qpair, uint32_t dnr)
 	}
 }
 
+static void
+nvme_pcie_qpair_abort_trackers(struct spdk_nvme_qpair *qpair, uint32_t dnr)
+{
+	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
+
+	nvme_pcie_qpair_abort_tracker_list(qpair, &pqpair->outstanding_tr, dnr);
+	nvme_pcie_qpair_abort_tracker_list(qpair, &pqpair->untimed_tr, dnr);
+}
+
 void
 nvme_pcie_admin_qpair_abort_aers(struct spdk_nvme_qpair *qpair)
 {
 	struct nvme_pcie_qpair	*pqpair = nvme_pcie_qpair(qpair);
 	struct nvme_tracker	*tr;
 
-	tr = TAILQ_FIRST(&pqpair->outstanding_tr);
+	/* AERs never time out, so they are always on the untimed list. */
+	tr = TAILQ_FIRST(&pqpair->untimed_tr);
 	while (tr != NULL) {
 		assert(tr->req != NULL);
 		if (tr->req->cmd.opc == SPDK_NVME_OPC_ASYNC_EVENT_REQUEST) {
 			nvme_pcie_qpair_manual_complete_tracker(qpair, tr,
 								SPDK_NVME_SCT_GENERIC, SPDK_NVME_SC_ABORTED_SQ_DELETION, 0,
 								false);
-			tr = TAILQ_FIRST(&pqpair->outstanding_tr);
+			tr = TAILQ_FIRST(&pqpair->untimed_tr);
 		} else {
 			tr = TAILQ_NEXT(tr, tq_list);
 		}
 	}
 }
 
+int
+nvme_pcie_qpair_iterate_requests(struct spdk_nvme_qpair *qpair,
+				 int (*iter_fn)(struct nvme_request *req, void *arg),
+				 void *arg)
+{
+	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
+	struct nvme_tracker *tr, *tmp;
+	int rc;
+
+	assert(iter_fn != NULL);
+
+	TAILQ_FOREACH_SAFE(tr, &pqpair->outstanding_tr, tq_list, tmp) {
+		assert(tr->req != NULL);
+
+		rc = iter_fn(tr->req, arg);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	TAILQ_FOREACH_SAFE(tr, &pqpair->untimed_tr, tq_list, tmp) {
+		assert(tr->req != NULL);
+
+		rc = iter_fn(tr->req, arg);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
 static void
 nvme_pcie_admin_qpair_destroy(struct spdk_nvme_qpair *qpair)
 {
@@ -1433,6 +1621,7 @@ static int
 nvme_pcie_qpair_destroy(struct spdk_nvme_qpair *qpair)
 {
 	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
+	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(qpair->ctrlr);
 
 	if (nvme_qpair_is_admin_queue(qpair)) {
 		nvme_pcie_admin_qpair_destroy(qpair);
@@ -1441,10 +1630,14 @@ nvme_pcie_qpair_destroy(struct spdk_nvme_qpair *qpair)
 	 * We check sq_vaddr and cq_vaddr to see if the user specified the memory
 	 * buffers when creating the I/O queue.
 	 * If the user specified them, we cannot free that memory.
-	 * Nor do we free it if it's in the CMB.
+	 * Submission queues placed in the CMB are returned to the CMB allocator.
 	 */
 	if (!pqpair->sq_vaddr && pqpair->cmd && !pqpair->sq_in_cmb) {
 		spdk_free(pqpair->cmd);
+	} else if (pqpair->sq_in_cmb && pctrlr->cmb_page_map != NULL) {
+		nvme_pcie_ctrlr_free_cmb(qpair->ctrlr,
+					 (uintptr_t)pqpair->cmd - (uintptr_t)pctrlr->cmb_bar_virt_addr,
+					 pqpair->num_entries * sizeof(struct spdk_nvme_cmd));
 	}
 	if (!pqpair->cq_vaddr && pqpair->cpl) {
 		spdk_free(pqpair->cpl);
@@ -1972,6 +2165,37 @@ nvme_pcie_qpair_build_prps_sgl_request(struct spdk_nvme_qpair *qpair, struct nvm
 	return 0;
 }
 
+/*
+ * Put a newly submitted tracker on the outstanding list matching its request.
+ *  Requests are usually submitted in submit tick order, but requests that had
+ *  to wait for a free tracker keep the tick of their first submission, so walk
+ *  back from the tail to keep outstanding_tr sorted by deadline.
+ */
+static inline void
+nvme_pcie_qpair_track_timeout(struct nvme_pcie_qpair *pqpair, struct nvme_tracker *tr,
+			      struct nvme_request *req)
+{
+	struct nvme_tracker *prev;
+
+	if (!nvme_request_has_timeout(req)) {
+		tr->untimed = 1;
+		TAILQ_INSERT_TAIL(&pqpair->untimed_tr, tr, tq_list);
+		return;
+	}
+
+	tr->untimed = 0;
+	prev = TAILQ_LAST(&pqpair->outstanding_tr, nvme_outstanding_tr_head);
+	while (spdk_unlikely(prev != NULL && prev->req->submit_tick > req->submit_tick)) {
+		prev = TAILQ_PREV(prev, nvme_outstanding_tr_head, tq_list);
+	}
+
+	if (prev == NULL) {
+		TAILQ_INSERT_HEAD(&pqpair->outstanding_tr, tr, tq_list);
+	} else {
+		TAILQ_INSERT_AFTER(&pqpair->outstanding_tr, prev, tr, tq_list);
+	}
+}
+
 int
 nvme_pcie_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
 {
@@ -1998,7 +2222,7 @@ nvme_pcie_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_reques
 	}
 
 	TAILQ_REMOVE(&pqpair->free_tr, tr, tq_list); /* remove tr from free_tr */
-	TAILQ_INSERT_TAIL(&pqpair->outstanding_tr, tr, tq_list);
+	nvme_pcie_qpair_track_timeout(pqpair, tr, req);
 	tr->req = req;
 	tr->cb_fn = req->cb_fn;
 	tr->cb_arg = req->cb_arg;
@@ -2049,7 +2273,8 @@ static void
 nvme_pcie_qpair_check_timeout(struct spdk_nvme_qpair *qpair)
 {
 	uint64_t t02;
-	struct nvme_tracker *tr, *tmp;
+	struct nvme_tracker *tr;
+	struct nvme_request *req;
 	struct nvme_pcie_qpair *pqpair = nvme_pcie_qpair(qpair);
 	struct spdk_nvme_ctrlr *ctrlr = qpair->ctrlr;
 	struct spdk_nvme_ctrlr_process *active_proc;
@@ -2070,17 +2295,43 @@ nvme_pcie_qpair_check_timeout(struct spdk_nvme_qpair *qpair)
 		return;
 	}
 
+	if (TAILQ_EMPTY(&pqpair->outstanding_tr)) {
+		return;
+	}
+
 	t02 = spdk_get_ticks();
-	TAILQ_FOREACH_SAFE(tr, &pqpair->outstanding_tr, tq_list, tmp) {
-		assert(tr->req != NULL);
+	tr = TAILQ_FIRST(&pqpair->outstanding_tr);
+	while (tr != NULL) {
+		req = tr->req;
+		assert(req != NULL);
+		assert(nvme_request_has_timeout(req));
 
-		if (nvme_request_check_timeout(tr->req, tr->cid, active_proc, t02)) {
+		if (spdk_unlikely(req->pid != g_spdk_nvme_pid)) {
+			/* Admin request of another process, which will check it itself. */
+			tr = TAILQ_NEXT(tr, tq_list);
+			continue;
+		}
+
+		if (req->submit_tick + active_proc->timeout_ticks > t02) {
 			/*
-			 * The requests are in order, so as soon as one has not timed out,
-			 * stop iterating.
+			 * The requests are sorted by deadline, so as soon as one has not
+			 * timed out, stop iterating.
 			 */
 			break;
 		}
+
+		/*
+		 * Move the tracker out of the way before calling the user, so that it
+		 * is never looked at again by this check.
+		 */
+		TAILQ_REMOVE(&pqpair->outstanding_tr, tr, tq_list);
+		tr->untimed = 1;
+		TAILQ_INSERT_TAIL(&pqpair->untimed_tr, tr, tq_list);
+
+		nvme_request_timeout(req, tr->cid, active_proc);
+
+		/* The callback may have completed or submitted requests, so start over. */
+		tr = TAILQ_FIRST(&pqpair->outstanding_tr);
 	}
 }
 
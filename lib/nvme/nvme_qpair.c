@@ -33,6 +33,7 @@
 
 #include "nvme_internal.h"
 #include "spdk/nvme_ocssd.h"
+#include "spdk/nvme_zns.h"
 
 static void nvme_qpair_abort_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr);
 
@@ -88,6 +89,9 @@ static const struct nvme_string io_opcode[] = {
 	{ SPDK_OCSSD_OPC_VECTOR_WRITE, "OCSSD / VECTOR WRITE" },
 	{ SPDK_OCSSD_OPC_VECTOR_READ, "OCSSD / VECTOR READ" },
 	{ SPDK_OCSSD_OPC_VECTOR_COPY, "OCSSD / VECTOR COPY" },
+	{ SPDK_NVME_OPC_ZONE_MGMT_SEND, "ZONE MANAGEMENT SEND" },
+	{ SPDK_NVME_OPC_ZONE_MGMT_RECV, "ZONE MANAGEMENT RECEIVE" },
+	{ SPDK_NVME_OPC_ZONE_APPEND, "ZONE APPEND" },
 	{ 0xFFFF, "IO COMMAND" }
 };
 
@@ -240,6 +244,14 @@ static const struct nvme_string command_specific_status[] = {
 	{ SPDK_NVME_SC_CONFLICTING_ATTRIBUTES, "CONFLICTING ATTRIBUTES" },
 	{ SPDK_NVME_SC_INVALID_PROTECTION_INFO, "INVALID PROTECTION INFO" },
 	{ SPDK_NVME_SC_ATTEMPTED_WRITE_TO_RO_RANGE, "WRITE TO RO RANGE" },
+	{ SPDK_NVME_SC_ZONE_BOUNDARY_ERROR, "ZONE BOUNDARY ERROR" },
+	{ SPDK_NVME_SC_ZONE_IS_FULL, "ZONE IS FULL" },
+	{ SPDK_NVME_SC_ZONE_IS_READ_ONLY, "ZONE IS READ ONLY" },
+	{ SPDK_NVME_SC_ZONE_IS_OFFLINE, "ZONE IS OFFLINE" },
+	{ SPDK_NVME_SC_ZONE_INVALID_WRITE, "ZONE INVALID WRITE" },
+	{ SPDK_NVME_SC_TOO_MANY_ACTIVE_ZONES, "TOO MANY ACTIVE ZONES" },
+	{ SPDK_NVME_SC_TOO_MANY_OPEN_ZONES, "TOO MANY OPEN ZONES" },
+	{ SPDK_NVME_SC_INVALID_ZONE_STATE_TRANSITION, "INVALID ZONE STATE TRANSITION" },
 	{ 0xFFFF, "COMMAND SPECIFIC" }
 };
 
@@ -216,6 +216,14 @@ nvme_transport_qpair_reset(struct spdk_nvme_qpair *qpair)
 	NVME_TRANSPORT_CALL(qpair->trtype, qpair_reset, (qpair));
 }
 
+int
+nvme_transport_qpair_iterate_requests(struct spdk_nvme_qpair *qpair,
+				      int (*iter_fn)(struct nvme_request *req, void *arg),
+				      void *arg)
+{
+	NVME_TRANSPORT_CALL(qpair->trtype, qpair_iterate_requests, (qpair, iter_fn, arg));
+}
+
 int
 nvme_transport_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
 {
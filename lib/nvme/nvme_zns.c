@@ -0,0 +1,331 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/nvme_zns.h"
+#include "nvme_internal.h"
+
+const struct spdk_nvme_zns_ns_data *
+spdk_nvme_zns_ns_get_data(struct spdk_nvme_ns *ns)
+{
+	return ns->nsdata_zns;
+}
+
+uint64_t
+spdk_nvme_zns_ns_get_zone_size_sectors(struct spdk_nvme_ns *ns)
+{
+	const struct spdk_nvme_ns_data *nsdata = spdk_nvme_ns_get_data(ns);
+
+	if (ns->nsdata_zns == NULL) {
+		return 0;
+	}
+
+	return ns->nsdata_zns->lbafe[nsdata->flbas.format].zsze;
+}
+
+uint64_t
+spdk_nvme_zns_ns_get_zone_size(struct spdk_nvme_ns *ns)
+{
+	return spdk_nvme_zns_ns_get_zone_size_sectors(ns) * spdk_nvme_ns_get_sector_size(ns);
+}
+
+uint64_t
+spdk_nvme_zns_ns_get_num_zones(struct spdk_nvme_ns *ns)
+{
+	uint64_t zone_size = spdk_nvme_zns_ns_get_zone_size_sectors(ns);
+
+	if (zone_size == 0) {
+		return 0;
+	}
+
+	return spdk_nvme_ns_get_num_sectors(ns) / zone_size;
+}
+
+uint32_t
+spdk_nvme_zns_ns_get_max_open_zones(struct spdk_nvme_ns *ns)
+{
+	if (ns->nsdata_zns == NULL || ns->nsdata_zns->mor == UINT32_MAX) {
+		return 0;
+	}
+
+	/* MOR is a 0's based value */
+	return ns->nsdata_zns->mor + 1;
+}
+
+uint32_t
+spdk_nvme_zns_ns_get_max_active_zones(struct spdk_nvme_ns *ns)
+{
+	if (ns->nsdata_zns == NULL || ns->nsdata_zns->mar == UINT32_MAX) {
+		return 0;
+	}
+
+	/* MAR is a 0's based value */
+	return ns->nsdata_zns->mar + 1;
+}
+
+const struct spdk_nvme_zns_ctrlr_data *
+spdk_nvme_zns_ctrlr_get_data(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return ctrlr->cdata_zns;
+}
+
+uint32_t
+spdk_nvme_zns_ctrlr_get_max_zone_append_size(const struct spdk_nvme_ctrlr *ctrlr)
+{
+	uint64_t zasl_size;
+
+	if (ctrlr->cdata_zns == NULL || ctrlr->cdata_zns->zasl == 0) {
+		/* A ZASL of 0 means the limit is the Maximum Data Transfer Size */
+		return ctrlr->max_xfer_size;
+	}
+
+	zasl_size = (uint64_t)ctrlr->min_page_size << ctrlr->cdata_zns->zasl;
+
+	return spdk_min(ctrlr->max_xfer_size, zasl_size);
+}
+
+static int
+_nvme_zns_zone_append(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+		      const struct nvme_payload *payload, uint64_t zslba, uint32_t lba_count,
+		      spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags,
+		      uint16_t apptag_mask, uint16_t apptag)
+{
+	struct nvme_request	*req;
+	struct spdk_nvme_cmd	*cmd;
+	uint32_t		sector_size;
+
+	if (io_flags & 0xFFFF) {
+		/* The bottom 16 bits must be empty */
+		SPDK_ERRLOG("io_flags 0x%x bottom 16 bits is not empty\n", io_flags);
+		return -EINVAL;
+	}
+
+	sector_size = ns->extended_lba_size;
+	if ((io_flags & SPDK_NVME_IO_FLAGS_PRACT) &&
+	    (ns->flags & SPDK_NVME_NS_EXTENDED_LBA_SUPPORTED) &&
+	    (ns->flags & SPDK_NVME_NS_DPS_PI_SUPPORTED) &&
+	    (ns->md_size == 8)) {
+		sector_size -= 8;
+	}
+
+	/*
+	 * The LBA a zone append is written to is only known once it completes,
+	 *  so unlike reads and writes it can never be split into child requests.
+	 */
+	if (lba_count == 0 ||
+	    (uint64_t)lba_count * sector_size > spdk_nvme_zns_ctrlr_get_max_zone_append_size(ns->ctrlr)) {
+		return -EINVAL;
+	}
+
+	req = nvme_allocate_request(qpair, payload, lba_count * sector_size, cb_fn, cb_arg);
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+
+	cmd = &req->cmd;
+	cmd->opc = SPDK_NVME_OPC_ZONE_APPEND;
+	cmd->nsid = ns->id;
+
+	*(uint64_t *)&cmd->cdw10 = zslba;
+
+	if (ns->flags & SPDK_NVME_NS_DPS_PI_SUPPORTED) {
+		switch (ns->pi_type) {
+		case SPDK_NVME_FMT_NVM_PROTECTION_TYPE1:
+		case SPDK_NVME_FMT_NVM_PROTECTION_TYPE2:
+			cmd->cdw14 = (uint32_t)zslba;
+			break;
+		}
+	}
+
+	cmd->cdw12 = lba_count - 1;
+	cmd->cdw12 |= io_flags;
+
+	cmd->cdw15 = apptag_mask;
+	cmd->cdw15 = (cmd->cdw15 << 16 | apptag);
+
+	return nvme_qpair_submit_request(qpair, req);
+}
+
+int
+spdk_nvme_zns_zone_append(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			  void *buffer, uint64_t zslba,
+			  uint32_t lba_count, spdk_nvme_cmd_cb cb_fn, void *cb_arg,
+			  uint32_t io_flags)
+{
+	struct nvme_payload payload;
+
+	payload = NVME_PAYLOAD_CONTIG(buffer, NULL);
+
+	return _nvme_zns_zone_append(ns, qpair, &payload, zslba, lba_count, cb_fn, cb_arg,
+				     io_flags, 0, 0);
+}
+
+int
+spdk_nvme_zns_zone_append_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+				  void *buffer, void *metadata, uint64_t zslba,
+				  uint32_t lba_count, spdk_nvme_cmd_cb cb_fn, void *cb_arg,
+				  uint32_t io_flags, uint16_t apptag_mask, uint16_t apptag)
+{
+	struct nvme_payload payload;
+
+	payload = NVME_PAYLOAD_CONTIG(buffer, metadata);
+
+	return _nvme_zns_zone_append(ns, qpair, &payload, zslba, lba_count, cb_fn, cb_arg,
+				     io_flags, apptag_mask, apptag);
+}
+
+int
+spdk_nvme_zns_zone_appendv_with_md(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+				   uint64_t zslba, uint32_t lba_count,
+				   spdk_nvme_cmd_cb cb_fn, void *cb_arg, uint32_t io_flags,
+				   spdk_nvme_req_reset_sgl_cb reset_sgl_fn,
+				   spdk_nvme_req_next_sge_cb next_sge_fn, void *metadata,
+				   uint16_t apptag_mask, uint16_t apptag)
+{
+	struct nvme_payload payload;
+
+	if (reset_sgl_fn == NULL || next_sge_fn == NULL) {
+		return -EINVAL;
+	}
+
+	payload = NVME_PAYLOAD_SGL(reset_sgl_fn, next_sge_fn, cb_arg, metadata);
+
+	return _nvme_zns_zone_append(ns, qpair, &payload, zslba, lba_count, cb_fn, cb_arg,
+				     io_flags, apptag_mask, apptag);
+}
+
+static int
+nvme_zns_zone_mgmt_send(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			uint64_t slba, bool select_all, enum spdk_nvme_zns_zone_send_action zsa,
+			spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct nvme_request	*req;
+	struct spdk_nvme_cmd	*cmd;
+
+	req = nvme_allocate_request_null(qpair, cb_fn, cb_arg);
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+
+	cmd = &req->cmd;
+	cmd->opc = SPDK_NVME_OPC_ZONE_MGMT_SEND;
+	cmd->nsid = ns->id;
+
+	if (!select_all) {
+		*(uint64_t *)&cmd->cdw10 = slba;
+	}
+
+	/* Zone Send Action in bits 7:0, Select All in bit 8 */
+	cmd->cdw13 = zsa | ((uint32_t)select_all << 8);
+
+	return nvme_qpair_submit_request(qpair, req);
+}
+
+int
+spdk_nvme_zns_close_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			 uint64_t slba, bool select_all,
+			 spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgmt_send(ns, qpair, slba, select_all, SPDK_NVME_ZONE_CLOSE,
+				       cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_finish_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			  uint64_t slba, bool select_all,
+			  spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgmt_send(ns, qpair, slba, select_all, SPDK_NVME_ZONE_FINISH,
+				       cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_open_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			uint64_t slba, bool select_all,
+			spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgmt_send(ns, qpair, slba, select_all, SPDK_NVME_ZONE_OPEN,
+				       cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_reset_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			 uint64_t slba, bool select_all,
+			 spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgmt_send(ns, qpair, slba, select_all, SPDK_NVME_ZONE_RESET,
+				       cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_offline_zone(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			   uint64_t slba, bool select_all,
+			   spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	return nvme_zns_zone_mgmt_send(ns, qpair, slba, select_all, SPDK_NVME_ZONE_OFFLINE,
+				       cb_fn, cb_arg);
+}
+
+int
+spdk_nvme_zns_report_zones(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
+			   void *payload, uint32_t payload_size, uint64_t slba,
+			   enum spdk_nvme_zns_zra_report_opts report_opts, bool partial_report,
+			   spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct nvme_request	*req;
+	struct spdk_nvme_cmd	*cmd;
+
+	if (payload == NULL || payload_size < sizeof(struct spdk_nvme_zns_zone_report) ||
+	    payload_size % sizeof(uint32_t) != 0) {
+		return -EINVAL;
+	}
+
+	req = nvme_allocate_request_contig(qpair, payload, payload_size, cb_fn, cb_arg);
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+
+	cmd = &req->cmd;
+	cmd->opc = SPDK_NVME_OPC_ZONE_MGMT_RECV;
+	cmd->nsid = ns->id;
+
+	*(uint64_t *)&cmd->cdw10 = slba;
+
+	/* Number of dwords is a 0's based value */
+	cmd->cdw12 = payload_size / sizeof(uint32_t) - 1;
+
+	/* Zone Receive Action in bits 7:0, its specific field in 15:8, Partial Report in bit 16 */
+	cmd->cdw13 = SPDK_NVME_ZONE_REPORT | ((uint32_t)report_opts << 8) |
+		     ((uint32_t)partial_report << 16);
+
+	return nvme_qpair_submit_request(qpair, req);
+}
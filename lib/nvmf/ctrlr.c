@@ -262,6 +262,7 @@ spdk_nvmf_ctrlr_create(struct spdk_nvmf_subsystem *subsystem,
 {
 	struct spdk_nvmf_ctrlr	*ctrlr;
 	struct spdk_nvmf_transport *transport;
+	struct spdk_nvme_transport_id listen_trid = {};
 
 	ctrlr = calloc(1, sizeof(*ctrlr));
 	if (ctrlr == NULL) {
@@ -273,6 +274,11 @@ spdk_nvmf_ctrlr_create(struct spdk_nvmf_subsystem *subsystem,
 	ctrlr->subsys = subsystem;
 	ctrlr->thread = req->qpair->group->thread;
 
+	/* The listener determines the ANA state this controller reports. */
+	if (spdk_nvmf_qpair_get_listen_trid(req->qpair, &listen_trid) == 0) {
+		ctrlr->listener = spdk_nvmf_subsystem_find_listener(subsystem, &listen_trid);
+	}
+
 	transport = req->qpair->transport;
 	ctrlr->qpair_mask = spdk_bit_array_create(transport->opts.max_qpairs_per_ctrlr);
 	if (!ctrlr->qpair_mask) {
@@ -289,6 +295,7 @@ spdk_nvmf_ctrlr_create(struct spdk_nvmf_subsystem *subsystem,
 			KAS_DEFAULT_VALUE * KAS_TIME_UNIT_IN_MS) *
 			KAS_DEFAULT_VALUE * KAS_TIME_UNIT_IN_MS;
 	ctrlr->feat.async_event_configuration.bits.ns_attr_notice = 1;
+	ctrlr->feat.async_event_configuration.bits.ana_change_notice = 1;
 	ctrlr->feat.volatile_write_cache.bits.wce = 1;
 
 	if (ctrlr->subsys->subtype == SPDK_NVMF_SUBTYPE_DISCOVERY) {
@@ -389,14 +396,31 @@ spdk_nvmf_ctrlr_add_io_qpair(void *ctx)
 {
 	struct spdk_nvmf_request *req = ctx;
 	struct spdk_nvmf_fabric_connect_rsp *rsp = &req->rsp->connect_rsp;
+	struct spdk_nvmf_fabric_connect_data *data = req->data;
 	struct spdk_nvmf_qpair *qpair = req->qpair;
 	struct spdk_nvmf_ctrlr *ctrlr = qpair->ctrlr;
+	struct spdk_nvmf_subsystem *subsystem;
 
 	/* Unit test will check qpair->ctrlr after calling spdk_nvmf_ctrlr_connect.
 	  * For error case, the value should be NULL. So set it to NULL at first.
 	  */
 	qpair->ctrlr = NULL;
 
+	/*
+	 * The controller was looked up without synchronizing with the subsystem
+	 * thread and may have been freed since. Controllers are only freed on this
+	 * thread after being removed from the subsystem, so check that it is still
+	 * published before touching it. Once that holds, it stays valid for the
+	 * rest of this message.
+	 */
+	subsystem = spdk_nvmf_tgt_find_subsystem(qpair->transport->tgt, data->subnqn);
+	if (subsystem == NULL || spdk_nvmf_subsystem_get_ctrlr(subsystem, data->cntlid) != ctrlr ||
+	    ctrlr->qpair_mask == NULL || ctrlr->admin_qpair == NULL) {
+		SPDK_ERRLOG("Controller ID 0x%x went away during I/O connect\n", data->cntlid);
+		SPDK_NVMF_INVALID_CONNECT_DATA(rsp, cntlid);
+		goto end;
+	}
+
 	if (ctrlr->subsys->subtype == SPDK_NVMF_SUBTYPE_DISCOVERY) {
 		SPDK_ERRLOG("I/O connect not allowed on discovery controller\n");
 		SPDK_NVMF_INVALID_CONNECT_CMD(rsp, qid);
@@ -428,37 +452,6 @@ end:
 	spdk_thread_send_msg(qpair->group->thread, _spdk_nvmf_request_complete, req);
 }
 
-static void
-_spdk_nvmf_ctrlr_add_io_qpair(void *ctx)
-{
-	struct spdk_nvmf_request *req = ctx;
-	struct spdk_nvmf_fabric_connect_rsp *rsp = &req->rsp->connect_rsp;
-	struct spdk_nvmf_fabric_connect_data *data = req->data;
-	struct spdk_nvmf_ctrlr *ctrlr;
-	struct spdk_nvmf_qpair *qpair = req->qpair;
-	struct spdk_nvmf_qpair *admin_qpair;
-	struct spdk_nvmf_tgt *tgt = qpair->transport->tgt;
-	struct spdk_nvmf_subsystem *subsystem;
-
-	SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Connect I/O Queue for controller id 0x%x\n", data->cntlid);
-
-	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, data->subnqn);
-	/* We already checked this in spdk_nvmf_ctrlr_connect */
-	assert(subsystem != NULL);
-
-	ctrlr = spdk_nvmf_subsystem_get_ctrlr(subsystem, data->cntlid);
-	if (ctrlr == NULL) {
-		SPDK_ERRLOG("Unknown controller ID 0x%x\n", data->cntlid);
-		SPDK_NVMF_INVALID_CONNECT_DATA(rsp, cntlid);
-		spdk_thread_send_msg(qpair->group->thread, _spdk_nvmf_request_complete, req);
-		return;
-	}
-
-	admin_qpair = ctrlr->admin_qpair;
-	qpair->ctrlr = ctrlr;
-	spdk_thread_send_msg(admin_qpair->group->thread, spdk_nvmf_ctrlr_add_io_qpair, req);
-}
-
 static int
 spdk_nvmf_ctrlr_connect(struct spdk_nvmf_request *req)
 {
@@ -620,7 +613,24 @@ spdk_nvmf_ctrlr_connect(struct spdk_nvmf_request *req)
 			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
 		}
 	} else {
-		spdk_thread_send_msg(subsystem->thread, _spdk_nvmf_ctrlr_add_io_qpair, req);
+		struct spdk_thread *ctrlr_thread = NULL;
+
+		SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Connect I/O Queue for controller id 0x%x\n", data->cntlid);
+
+		/*
+		 * I/O queues are attached on the controller's own thread rather than
+		 * the subsystem thread, so reconnects to different controllers proceed
+		 * in parallel.
+		 */
+		ctrlr = spdk_nvmf_subsystem_lookup_ctrlr(subsystem, data->cntlid, &ctrlr_thread);
+		if (ctrlr == NULL) {
+			SPDK_ERRLOG("Unknown controller ID 0x%x\n", data->cntlid);
+			SPDK_NVMF_INVALID_CONNECT_DATA(rsp, cntlid);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+		}
+
+		qpair->ctrlr = ctrlr;
+		spdk_thread_send_msg(ctrlr_thread, spdk_nvmf_ctrlr_add_io_qpair, req);
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
 	}
 }
@@ -1247,12 +1257,36 @@ spdk_nvmf_ctrlr_set_features_async_event_configuration(struct spdk_nvmf_request
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 }
 
+static union spdk_nvme_async_event_completion
+spdk_nvmf_ctrlr_notice_event(uint8_t info)
+{
+	union spdk_nvme_async_event_completion event = {0};
+
+	event.bits.async_event_type = SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE;
+	event.bits.async_event_info = info;
+
+	switch (info) {
+	case SPDK_NVME_ASYNC_EVENT_NS_ATTR_CHANGED:
+		event.bits.log_page_identifier = SPDK_NVME_LOG_CHANGED_NS_LIST;
+		break;
+	case SPDK_NVME_ASYNC_EVENT_ANA_CHANGE:
+		event.bits.log_page_identifier = SPDK_NVME_LOG_ASYMMETRIC_NAMESPACE_ACCESS;
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	return event;
+}
+
 static int
 spdk_nvmf_ctrlr_async_event_request(struct spdk_nvmf_request *req)
 {
 	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
 	struct spdk_nvme_cpl *rsp = &req->rsp->nvme_cpl;
 	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	uint8_t info;
 
 	SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Async Event Request\n");
 
@@ -1264,10 +1298,10 @@ spdk_nvmf_ctrlr_async_event_request(struct spdk_nvmf_request *req)
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	}
 
-	if (ctrlr->notice_event.bits.async_event_type ==
-	    SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE) {
-		rsp->cdw0 = ctrlr->notice_event.raw;
-		ctrlr->notice_event.raw = 0;
+	if (ctrlr->pending_notices != 0) {
+		info = __builtin_ctz(ctrlr->pending_notices);
+		ctrlr->pending_notices &= ~(1u << info);
+		rsp->cdw0 = spdk_nvmf_ctrlr_notice_event(info).raw;
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	}
 
@@ -1445,6 +1479,95 @@ spdk_nvmf_get_reservation_notification_log_page(struct spdk_nvmf_ctrlr *ctrlr,
 	return;
 }
 
+static void
+spdk_nvmf_get_ana_log_page(struct spdk_nvmf_ctrlr *ctrlr, void *data,
+			   uint64_t offset, uint32_t length, bool rgo)
+{
+	struct spdk_nvmf_subsystem *subsystem = ctrlr->subsys;
+	struct spdk_nvme_ana_page *ana_hdr;
+	struct spdk_nvme_ana_group_descriptor *ana_desc;
+	struct spdk_nvmf_ns *ns;
+	size_t *desc_offset;
+	uint32_t *num_nsid;
+	uint32_t nsid, i, num_ana_group_desc = 0;
+	size_t page_size, copy_len = 0;
+	char *page;
+
+	num_nsid = calloc(subsystem->max_nsid + 1, sizeof(*num_nsid));
+	desc_offset = calloc(subsystem->max_nsid + 1, sizeof(*desc_offset));
+	if (num_nsid == NULL || desc_offset == NULL) {
+		goto out;
+	}
+
+	/* Only ANA groups with at least one namespace are reported. */
+	for (nsid = 1; nsid <= subsystem->max_nsid; nsid++) {
+		ns = _spdk_nvmf_subsystem_get_ns(subsystem, nsid);
+		if (ns == NULL) {
+			continue;
+		}
+		assert(ns->opts.anagrpid > 0 && ns->opts.anagrpid <= subsystem->max_nsid);
+		num_nsid[ns->opts.anagrpid - 1]++;
+	}
+
+	page_size = sizeof(*ana_hdr);
+	for (i = 0; i < subsystem->max_nsid; i++) {
+		if (num_nsid[i] == 0) {
+			continue;
+		}
+		desc_offset[i] = page_size;
+		page_size += sizeof(*ana_desc);
+		if (!rgo) {
+			page_size += num_nsid[i] * sizeof(uint32_t);
+		}
+		num_ana_group_desc++;
+	}
+
+	page = calloc(1, page_size);
+	if (page == NULL) {
+		goto out;
+	}
+
+	ana_hdr = (struct spdk_nvme_ana_page *)page;
+	ana_hdr->change_count = ctrlr->listener ? ctrlr->listener->ana_state_change_count : 0;
+	ana_hdr->num_ana_group_desc = num_ana_group_desc;
+
+	for (i = 0; i < subsystem->max_nsid; i++) {
+		if (num_nsid[i] == 0) {
+			continue;
+		}
+		ana_desc = (struct spdk_nvme_ana_group_descriptor *)(page + desc_offset[i]);
+		ana_desc->ana_group_id = i + 1;
+		ana_desc->change_count = ana_hdr->change_count;
+		ana_desc->ana_state = _spdk_nvmf_ctrlr_get_ana_state(ctrlr, i + 1);
+	}
+
+	/* Namespaces are visited in NSID order, so each list comes out sorted. */
+	if (!rgo) {
+		for (nsid = 1; nsid <= subsystem->max_nsid; nsid++) {
+			ns = _spdk_nvmf_subsystem_get_ns(subsystem, nsid);
+			if (ns == NULL) {
+				continue;
+			}
+			ana_desc = (struct spdk_nvme_ana_group_descriptor *)
+				   (page + desc_offset[ns->opts.anagrpid - 1]);
+			ana_desc->nsid[ana_desc->num_of_nsid++] = ns->nsid;
+		}
+	}
+
+	if (offset < page_size) {
+		copy_len = spdk_min(page_size - offset, length);
+		memcpy(data, page + offset, copy_len);
+	}
+	free(page);
+
+out:
+	free(num_nsid);
+	free(desc_offset);
+	if (copy_len < length) {
+		memset((char *)data + copy_len, 0, length - copy_len);
+	}
+}
+
 static int
 spdk_nvmf_ctrlr_get_log_page(struct spdk_nvmf_request *req)
 {
@@ -1513,6 +1636,10 @@ spdk_nvmf_ctrlr_get_log_page(struct spdk_nvmf_request *req)
 		case SPDK_NVME_LOG_RESERVATION_NOTIFICATION:
 			spdk_nvmf_get_reservation_notification_log_page(ctrlr, req->data, offset, len);
 			return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+		case SPDK_NVME_LOG_ASYMMETRIC_NAMESPACE_ACCESS:
+			spdk_nvmf_get_ana_log_page(ctrlr, req->data, offset, len,
+						   ((cmd->cdw10 >> 8) & 0xF) & SPDK_NVME_ANA_LOG_RGO);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 		default:
 			goto invalid_log_page;
 		}
@@ -1556,6 +1683,7 @@ spdk_nvmf_ctrlr_identify_ns(struct spdk_nvmf_ctrlr *ctrlr,
 	}
 
 	spdk_nvmf_bdev_ctrlr_identify_ns(ns, nsdata, ctrlr->dif_insert_or_strip);
+	nsdata->anagrpid = ns->opts.anagrpid;
 
 	/* Due to bug in the Linux kernel NVMe driver we have to set noiob no larger than mdts */
 	max_num_blocks = ctrlr->admin_qpair->transport->opts.max_io_size /
@@ -1603,7 +1731,9 @@ spdk_nvmf_ctrlr_identify_ctrlr(struct spdk_nvmf_ctrlr *ctrlr, struct spdk_nvme_c
 		cdata->rab = 6;
 		cdata->cmic.multi_port = 1;
 		cdata->cmic.multi_host = 1;
+		cdata->cmic.ana_reporting = 1;
 		cdata->oaes.ns_attribute_notices = 1;
+		cdata->oaes.ana_change_notices = 1;
 		cdata->ctratt.host_id_exhid_supported = 1;
 		cdata->aerl = 0;
 		cdata->frmw.slot1_ro = 1;
@@ -1619,6 +1749,17 @@ spdk_nvmf_ctrlr_identify_ctrlr(struct spdk_nvmf_ctrlr *ctrlr, struct spdk_nvme_c
 		cdata->vwc.present = 1;
 		cdata->vwc.flush_broadcast = SPDK_NVME_FLUSH_BROADCAST_NOT_SUPPORTED;
 
+		/* ANA state changes take effect immediately, ANATT only bounds how long hosts wait. */
+		cdata->anatt = 10;
+		cdata->anacap.bits.ana_optimized_state = 1;
+		cdata->anacap.bits.ana_non_optimized_state = 1;
+		cdata->anacap.bits.ana_inaccessible_state = 1;
+		cdata->anacap.bits.ana_persistent_loss_state = 1;
+		cdata->anacap.bits.no_change_anagrpid = 1;
+		cdata->anacap.bits.non_zero_anagrpid = 1;
+		cdata->anagrpmax = subsystem->max_nsid;
+		cdata->nanagrpid = subsystem->max_nsid;
+
 		cdata->nvmf_specific.ioccsz = sizeof(struct spdk_nvme_cmd) / 16;
 		cdata->nvmf_specific.iorcsz = sizeof(struct spdk_nvme_cpl) / 16;
 		cdata->nvmf_specific.icdoff = 0; /* offset starts directly after SQE */
@@ -2111,44 +2252,52 @@ spdk_nvmf_ctrlr_process_fabrics_cmd(struct spdk_nvmf_request *req)
 	}
 }
 
-int
-spdk_nvmf_ctrlr_async_event_ns_notice(struct spdk_nvmf_ctrlr *ctrlr)
+static void
+spdk_nvmf_ctrlr_async_event_notice(struct spdk_nvmf_ctrlr *ctrlr,
+				   enum spdk_nvme_async_event_info_notice info)
 {
 	struct spdk_nvmf_request *req;
 	struct spdk_nvme_cpl *rsp;
-	union spdk_nvme_async_event_completion event = {0};
-
-	/* Users may disable the event notification */
-	if (!ctrlr->feat.async_event_configuration.bits.ns_attr_notice) {
-		return 0;
-	}
-
-	event.bits.async_event_type = SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE;
-	event.bits.async_event_info = SPDK_NVME_ASYNC_EVENT_NS_ATTR_CHANGED;
-	event.bits.log_page_identifier = SPDK_NVME_LOG_CHANGED_NS_LIST;
 
 	/* If there is no outstanding AER request, queue the event.  Then
 	 * if an AER is later submitted, this event can be sent as a
-	 * response.
+	 * response. Each notice type is reported once until it is sent.
 	 */
 	if (!ctrlr->aer_req) {
-		if (ctrlr->notice_event.bits.async_event_type ==
-		    SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE) {
-			return 0;
-		}
-
-		ctrlr->notice_event.raw = event.raw;
-		return 0;
+		ctrlr->pending_notices |= 1u << info;
+		return;
 	}
 
 	req = ctrlr->aer_req;
 	rsp = &req->rsp->nvme_cpl;
 
-	rsp->cdw0 = event.raw;
+	rsp->cdw0 = spdk_nvmf_ctrlr_notice_event(info).raw;
 
 	spdk_nvmf_request_complete(req);
 	ctrlr->aer_req = NULL;
+}
 
+int
+spdk_nvmf_ctrlr_async_event_ns_notice(struct spdk_nvmf_ctrlr *ctrlr)
+{
+	/* Users may disable the event notification */
+	if (!ctrlr->feat.async_event_configuration.bits.ns_attr_notice) {
+		return 0;
+	}
+
+	spdk_nvmf_ctrlr_async_event_notice(ctrlr, SPDK_NVME_ASYNC_EVENT_NS_ATTR_CHANGED);
+	return 0;
+}
+
+int
+spdk_nvmf_ctrlr_async_event_ana_change_notice(struct spdk_nvmf_ctrlr *ctrlr)
+{
+	/* Users may disable the event notification */
+	if (!ctrlr->feat.async_event_configuration.bits.ana_change_notice) {
+		return 0;
+	}
+
+	spdk_nvmf_ctrlr_async_event_notice(ctrlr, SPDK_NVME_ASYNC_EVENT_ANA_CHANGE);
 	return 0;
 }
 
@@ -2380,6 +2529,20 @@ exit:
 	return 0;
 }
 
+static uint8_t
+spdk_nvmf_ana_state_to_path_status(enum spdk_nvme_ana_state ana_state)
+{
+	switch (ana_state) {
+	case SPDK_NVME_ANA_INACCESSIBLE_STATE:
+		return SPDK_NVME_SC_ASYMMETRIC_ACCESS_INACCESSIBLE;
+	case SPDK_NVME_ANA_PERSISTENT_LOSS_STATE:
+		return SPDK_NVME_SC_ASYMMETRIC_ACCESS_PERSISTENT_LOSS;
+	case SPDK_NVME_ANA_CHANGE_STATE:
+	default:
+		return SPDK_NVME_SC_ASYMMETRIC_ACCESS_TRANSITION;
+	}
+}
+
 int
 spdk_nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req)
 {
@@ -2392,7 +2555,9 @@ spdk_nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req)
 	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
 	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
 	struct spdk_nvme_cpl *response = &req->rsp->nvme_cpl;
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
 	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+	enum spdk_nvme_ana_state ana_state;
 
 	/* pre-set response details for this command */
 	response->status.sc = SPDK_NVME_SC_SUCCESS;
@@ -2420,20 +2585,56 @@ spdk_nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req)
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	}
 
+	ana_state = _spdk_nvmf_ctrlr_get_ana_state(ctrlr, ns->opts.anagrpid);
+	if (spdk_unlikely(ana_state != SPDK_NVME_ANA_OPTIMIZED_STATE &&
+			  ana_state != SPDK_NVME_ANA_NON_OPTIMIZED_STATE)) {
+		SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Fail I/O command for nsid %u due to ANA state %d\n",
+			      nsid, ana_state);
+		response->status.sct = SPDK_NVME_SCT_PATH;
+		response->status.sc = spdk_nvmf_ana_state_to_path_status(ana_state);
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
 	/* scan-build falsely reporting dereference of null pointer */
 	assert(group != NULL && group->sgroups != NULL);
-	ns_info = &group->sgroups[ctrlr->subsys->id].ns_info[nsid - 1];
+	sgroup = &group->sgroups[ctrlr->subsys->id];
+	if (spdk_unlikely(nsid > sgroup->num_ns || sgroup->ns_info[nsid - 1].channel == NULL)) {
+		/* A hot added namespace that is not attached to this poll group yet. */
+		SPDK_DEBUGLOG(SPDK_LOG_NVMF, "nsid %u is not attached to this poll group\n", nsid);
+		response->status.sc = SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	ns_info = &sgroup->ns_info[nsid - 1];
 	if (nvmf_ns_reservation_request_check(ns_info, ctrlr, req)) {
 		SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Reservation Conflict for nsid %u, opcode %u\n",
 			      cmd->nsid, cmd->opc);
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	}
 
+	/* Resubmitted requests are already counted, and were already scheduled. */
+	if (!req->ns_io_tracked) {
+		req->ns_io_tracked = true;
+		ns_info->io_outstanding++;
+
+		if (ns_info->sched != NULL && !spdk_nvmf_ns_sched_submit(ns_info->sched, req)) {
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+		}
+	}
+
 	bdev = ns->bdev;
 	desc = ns->desc;
 	ch = ns_info->channel;
+	if (ns->cache != NULL && cmd->opc != SPDK_NVME_OPC_READ) {
+		/* Reads from here on miss what the command changes, see also nvmf_request_ns_io_done() */
+		spdk_nvmf_ns_cache_invalidate_cmd(ns->cache, req);
+	}
+
 	switch (cmd->opc) {
 	case SPDK_NVME_OPC_READ:
+		if (ns->cache != NULL) {
+			return spdk_nvmf_bdev_ctrlr_cache_read_cmd(bdev, desc, ch, ns->cache, req);
+		}
 		return spdk_nvmf_bdev_ctrlr_read_cmd(bdev, desc, ch, req);
 	case SPDK_NVME_OPC_WRITE:
 		return spdk_nvmf_bdev_ctrlr_write_cmd(bdev, desc, ch, req);
@@ -2483,6 +2684,135 @@ spdk_nvmf_request_free(struct spdk_nvmf_request *req)
 	return 0;
 }
 
+static void
+nvmf_request_ns_io_done(struct spdk_nvmf_qpair *qpair, struct spdk_nvmf_subsystem_poll_group *sgroup,
+			struct spdk_nvmf_request *req)
+{
+	uint32_t nsid = req->cmd->nvme_cmd.nsid;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info = &sgroup->ns_info[nsid - 1];
+	struct spdk_nvmf_ns *ns;
+
+	if (req->cmd->nvme_cmd.opc != SPDK_NVME_OPC_READ) {
+		ns = _spdk_nvmf_subsystem_get_ns(qpair->ctrlr->subsys, nsid);
+		if (ns != NULL && ns->cache != NULL) {
+			/* Drop whatever reads filled while the command was running */
+			spdk_nvmf_ns_cache_invalidate_cmd(ns->cache, req);
+		}
+	}
+
+	req->ns_io_tracked = false;
+	assert(ns_info->io_outstanding > 0);
+	ns_info->io_outstanding--;
+	if (req->sched_flow != NULL) {
+		spdk_nvmf_ns_sched_request_done(ns_info->sched, req);
+	}
+	if (ns_info->io_outstanding == 0 && ns_info->remove_cb_fn != NULL) {
+		spdk_nvmf_poll_group_remove_ns_done(qpair->group, qpair->ctrlr->subsys, nsid);
+	}
+}
+
+static void
+nvmf_sgroup_request_done(struct spdk_nvmf_qpair *qpair, struct spdk_nvmf_subsystem_poll_group *sgroup,
+			 struct spdk_nvmf_request *req)
+{
+	assert(sgroup->io_outstanding > 0);
+	sgroup->io_outstanding--;
+	if (req->ns_io_tracked) {
+		nvmf_request_ns_io_done(qpair, sgroup, req);
+	}
+	if (sgroup->state == SPDK_NVMF_SUBSYSTEM_PAUSING &&
+	    sgroup->io_outstanding == 0) {
+		sgroup->state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+		sgroup->cb_fn(sgroup->cb_arg, 0);
+	}
+}
+
+int
+spdk_nvmf_request_zcopy_start(struct spdk_nvmf_request *req, spdk_nvmf_request_zcopy_cb cb_fn)
+{
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+	struct spdk_nvmf_ctrlr *ctrlr = qpair->ctrlr;
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+	struct spdk_nvmf_ns *ns;
+	uint32_t nsid = cmd->nsid;
+	int rc;
+
+	if (ctrlr == NULL || spdk_nvmf_qpair_is_admin_queue(qpair) ||
+	    qpair->state != SPDK_NVMF_QPAIR_ACTIVE ||
+	    cmd->opc != SPDK_NVME_OPC_WRITE || cmd->fuse != 0) {
+		return -EINVAL;
+	}
+
+	sgroup = &qpair->group->sgroups[ctrlr->subsys->id];
+	if (sgroup->state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		return -EBUSY;
+	}
+
+	ns = _spdk_nvmf_subsystem_get_ns(ctrlr->subsys, nsid);
+	if (ns == NULL || ns->bdev == NULL || nsid > sgroup->num_ns ||
+	    sgroup->ns_info[nsid - 1].channel == NULL) {
+		return -EINVAL;
+	}
+	ns_info = &sgroup->ns_info[nsid - 1];
+	if (ns_info->sched != NULL) {
+		/* The buffers would be taken before the scheduler decides when the write may run. */
+		return -EBUSY;
+	}
+
+	/*
+	 * The buffers pin the namespace, so the request counts as outstanding from
+	 * now on. spdk_nvmf_request_exec() knows not to count it a second time.
+	 */
+	sgroup->io_outstanding++;
+	req->ns_io_tracked = true;
+	ns_info->io_outstanding++;
+	req->zcopy_cb_fn = cb_fn;
+	TAILQ_INSERT_TAIL(&qpair->outstanding, req, link);
+
+	rc = spdk_nvmf_bdev_ctrlr_zcopy_start(ns->bdev, ns->desc, ns_info->channel, req);
+	if (rc != 0) {
+		TAILQ_REMOVE(&qpair->outstanding, req, link);
+		req->zcopy_cb_fn = NULL;
+		nvmf_sgroup_request_done(qpair, sgroup, req);
+	}
+
+	return rc;
+}
+
+void
+spdk_nvmf_request_zcopy_start_done(struct spdk_nvmf_request *req, int status)
+{
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+	spdk_nvmf_request_zcopy_cb cb_fn = req->zcopy_cb_fn;
+
+	/* Keeping the request outstanding until here holds off the qpair teardown */
+	TAILQ_REMOVE(&qpair->outstanding, req, link);
+	req->zcopy_cb_fn = NULL;
+
+	if (status == 0 && qpair->state != SPDK_NVMF_QPAIR_ACTIVE) {
+		spdk_nvmf_request_zcopy_release(req);
+		status = -ECONNABORTED;
+	} else if (status != 0) {
+		nvmf_sgroup_request_done(qpair, &qpair->group->sgroups[qpair->ctrlr->subsys->id], req);
+	}
+
+	cb_fn(req, status);
+
+	spdk_nvmf_qpair_request_cleanup(qpair);
+}
+
+void
+spdk_nvmf_request_zcopy_release(struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+
+	assert(qpair->ctrlr != NULL);
+	spdk_nvmf_bdev_ctrlr_zcopy_release(req);
+	nvmf_sgroup_request_done(qpair, &qpair->group->sgroups[qpair->ctrlr->subsys->id], req);
+}
+
 int
 spdk_nvmf_request_complete(struct spdk_nvmf_request *req)
 {
@@ -2509,17 +2839,16 @@ spdk_nvmf_request_complete(struct spdk_nvmf_request *req)
 		SPDK_ERRLOG("Transport request completion error!\n");
 	}
 
+	if (spdk_unlikely(req->zcopy_bdev_io != NULL)) {
+		/* Failed before the data could be committed */
+		spdk_nvmf_bdev_ctrlr_zcopy_release(req);
+	}
+
 	/* AER cmd and fabric connect are exceptions */
 	if (sgroup != NULL && qpair->ctrlr->aer_req != req &&
 	    !(req->cmd->nvmf_cmd.opcode == SPDK_NVME_OPC_FABRIC &&
 	      req->cmd->nvmf_cmd.fctype == SPDK_NVMF_FABRIC_COMMAND_CONNECT)) {
-		assert(sgroup->io_outstanding > 0);
-		sgroup->io_outstanding--;
-		if (sgroup->state == SPDK_NVMF_SUBSYSTEM_PAUSING &&
-		    sgroup->io_outstanding == 0) {
-			sgroup->state = SPDK_NVMF_SUBSYSTEM_PAUSED;
-			sgroup->cb_fn(sgroup->cb_arg, 0);
-		}
+		nvmf_sgroup_request_done(qpair, sgroup, req);
 	}
 
 	spdk_nvmf_qpair_request_cleanup(qpair);
@@ -2571,6 +2900,14 @@ nvmf_trace_command(union nvmf_h2c_msg *h2c_msg, bool is_admin_queue)
 	}
 }
 
+void
+spdk_nvmf_request_exec_scheduled(struct spdk_nvmf_request *req)
+{
+	if (spdk_nvmf_ctrlr_process_io_cmd(req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE) {
+		spdk_nvmf_request_complete(req);
+	}
+}
+
 void
 spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 {
@@ -2590,7 +2927,7 @@ spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 		/* Place the request on the outstanding list so we can keep track of it */
 		TAILQ_INSERT_TAIL(&qpair->outstanding, req, link);
 		/* Still increment io_outstanding because request_complete decrements it */
-		if (sgroup != NULL) {
+		if (sgroup != NULL && req->zcopy_bdev_io == NULL) {
 			sgroup->io_outstanding++;
 		}
 		spdk_nvmf_request_complete(req);
@@ -2598,7 +2935,7 @@ spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 	}
 
 	/* Check if the subsystem is paused (if there is a subsystem) */
-	if (sgroup != NULL) {
+	if (sgroup != NULL && req->zcopy_bdev_io == NULL) {
 		if (sgroup->state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
 			/* The subsystem is not currently active. Queue this request. */
 			TAILQ_INSERT_TAIL(&sgroup->queued, req, link);
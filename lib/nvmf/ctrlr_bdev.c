@@ -196,7 +196,10 @@ spdk_nvmf_ctrlr_process_io_cmd_resubmit(void *arg)
 {
 	struct spdk_nvmf_request *req = arg;
 
-	spdk_nvmf_ctrlr_process_io_cmd(req);
+	/* The namespace may have gone away while the request waited. */
+	if (spdk_nvmf_ctrlr_process_io_cmd(req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE) {
+		spdk_nvmf_request_complete(req);
+	}
 }
 
 static void
@@ -260,6 +263,136 @@ spdk_nvmf_bdev_ctrlr_read_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *des
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
 }
 
+static void
+nvmf_bdev_ctrlr_cache_read_done(struct spdk_nvmf_ns_cache_hold *hold)
+{
+	struct spdk_nvmf_request *req = spdk_nvmf_ns_cache_hold_get_ctx(hold);
+	struct spdk_nvme_cpl *rsp = &req->rsp->nvme_cpl;
+	uint64_t start_lba;
+	uint64_t num_blocks;
+
+	if (spdk_likely(spdk_nvmf_ns_cache_hold_is_valid(hold))) {
+		nvmf_bdev_ctrlr_get_rw_params(&req->cmd->nvme_cmd, &start_lba, &num_blocks);
+		spdk_nvmf_ns_cache_request_serve(req, hold, start_lba, num_blocks);
+		spdk_nvmf_request_complete(req);
+		return;
+	}
+
+	spdk_nvmf_ns_cache_hold_put(hold);
+	if (rsp->status.sct == SPDK_NVME_SCT_GENERIC && rsp->status.sc == SPDK_NVME_SC_SUCCESS) {
+		/* Only ran out of bdev_ios. The lines that did get filled will hit next time. */
+		spdk_thread_send_msg(spdk_get_thread(), spdk_nvmf_ctrlr_process_io_cmd_resubmit, req);
+		return;
+	}
+
+	spdk_nvmf_request_complete(req);
+}
+
+static void
+nvmf_bdev_ctrlr_cache_fill_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_nvmf_ns_cache_hold	*hold;
+	struct spdk_nvmf_request	*req;
+	struct spdk_nvme_cpl		*rsp;
+	int				sc, sct;
+	bool				done;
+
+	done = spdk_nvmf_ns_cache_fill_done(cb_arg, success, &hold);
+	req = spdk_nvmf_ns_cache_hold_get_ctx(hold);
+	rsp = &req->rsp->nvme_cpl;
+	if (!success && rsp->status.sct == SPDK_NVME_SCT_GENERIC &&
+	    rsp->status.sc == SPDK_NVME_SC_SUCCESS) {
+		spdk_bdev_io_get_nvme_status(bdev_io, &sct, &sc);
+		rsp->status.sc = sc;
+		rsp->status.sct = sct;
+	}
+	spdk_bdev_free_io(bdev_io);
+
+	if (done) {
+		nvmf_bdev_ctrlr_cache_read_done(hold);
+	}
+}
+
+int
+spdk_nvmf_bdev_ctrlr_cache_read_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+				    struct spdk_io_channel *ch, struct spdk_nvmf_ns_cache *cache,
+				    struct spdk_nvmf_request *req)
+{
+	uint64_t bdev_num_blocks = spdk_bdev_get_num_blocks(bdev);
+	uint32_t block_size = spdk_bdev_get_block_size(bdev);
+	uint32_t line_blocks = spdk_nvmf_ns_cache_get_line_blocks(cache);
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	struct spdk_nvme_cpl *rsp = &req->rsp->nvme_cpl;
+	struct spdk_nvmf_ns_cache_hold *hold;
+	uint64_t start_lba;
+	uint64_t num_blocks;
+	uint64_t lba;
+	uint32_t i, num_lines, num_fills, fills_handled;
+	void *fill_ctx;
+	void *buf;
+	int rc = 0;
+
+	nvmf_bdev_ctrlr_get_rw_params(cmd, &start_lba, &num_blocks);
+
+	/* Errors, and reads the cache can't hold, are left to a plain read. */
+	if (spdk_unlikely(!nvmf_bdev_ctrlr_lba_in_range(bdev_num_blocks, start_lba, num_blocks) ||
+			  num_blocks * block_size != req->length ||
+			  spdk_bdev_get_md_size(bdev) != 0 ||
+			  req->qpair->ctrlr->dif_insert_or_strip ||
+			  spdk_divide_round_up(start_lba + num_blocks, line_blocks) * line_blocks >
+			  bdev_num_blocks)) {
+		return spdk_nvmf_bdev_ctrlr_read_cmd(bdev, desc, ch, req);
+	}
+
+	hold = spdk_nvmf_ns_cache_hold_get(cache, start_lba, num_blocks, req);
+	if (hold == NULL) {
+		return spdk_nvmf_bdev_ctrlr_read_cmd(bdev, desc, ch, req);
+	}
+
+	num_lines = spdk_nvmf_ns_cache_hold_get_num_lines(hold);
+	num_fills = 0;
+	for (i = 0; i < num_lines; i++) {
+		spdk_nvmf_ns_cache_hold_get_line(hold, i, &lba, &fill_ctx);
+		if (fill_ctx != NULL) {
+			num_fills++;
+		}
+	}
+
+	if (num_fills == 0) {
+		spdk_nvmf_ns_cache_request_serve(req, hold, start_lba, num_blocks);
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	/* The hold may be gone once the last fill is handled, so stop there. */
+	fills_handled = 0;
+	for (i = 0; fills_handled < num_fills; i++) {
+		buf = spdk_nvmf_ns_cache_hold_get_line(hold, i, &lba, &fill_ctx);
+		if (fill_ctx == NULL) {
+			continue;
+		}
+		fills_handled++;
+
+		if (rc == 0) {
+			rc = spdk_bdev_read_blocks(desc, ch, buf, lba, line_blocks,
+						   nvmf_bdev_ctrlr_cache_fill_done, fill_ctx);
+			if (spdk_likely(rc == 0)) {
+				continue;
+			}
+			if (rc != -ENOMEM) {
+				rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+				rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+			}
+		}
+
+		/* This and the remaining lines could not be submitted */
+		if (spdk_nvmf_ns_cache_fill_done(fill_ctx, false, &hold)) {
+			nvmf_bdev_ctrlr_cache_read_done(hold);
+		}
+	}
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+}
+
 int
 spdk_nvmf_bdev_ctrlr_write_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 			       struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
@@ -289,6 +422,18 @@ spdk_nvmf_bdev_ctrlr_write_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *de
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	}
 
+	if (req->zcopy_bdev_io != NULL) {
+		/* The data was received straight into the bdev's buffers, hand them back */
+		rc = spdk_bdev_zcopy_end(req->zcopy_bdev_io, true, nvmf_bdev_ctrlr_complete_cmd, req);
+		if (spdk_likely(rc == 0)) {
+			req->zcopy_bdev_io = NULL;
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+		}
+		rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+		rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
 	rc = spdk_bdev_writev_blocks(desc, ch, req->iov, req->iovcnt, start_lba, num_blocks,
 				     nvmf_bdev_ctrlr_complete_cmd, req);
 	if (spdk_unlikely(rc)) {
@@ -304,6 +449,85 @@ spdk_nvmf_bdev_ctrlr_write_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *de
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
 }
 
+static void
+nvmf_bdev_ctrlr_zcopy_start_complete(struct spdk_bdev_io *bdev_io, bool success,
+				     void *cb_arg)
+{
+	struct spdk_nvmf_request	*req = cb_arg;
+	struct iovec			*iovs;
+	int				iovcnt, i;
+
+	if (!success) {
+		spdk_bdev_free_io(bdev_io);
+		spdk_nvmf_request_zcopy_start_done(req, -EIO);
+		return;
+	}
+
+	spdk_bdev_io_get_iovec(bdev_io, &iovs, &iovcnt);
+	if (spdk_unlikely(iovcnt <= 0 || iovcnt > NVMF_REQ_MAX_BUFFERS)) {
+		req->zcopy_bdev_io = bdev_io;
+		spdk_nvmf_bdev_ctrlr_zcopy_release(req);
+		spdk_nvmf_request_zcopy_start_done(req, -EINVAL);
+		return;
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		req->iov[i] = iovs[i];
+	}
+	req->iovcnt = iovcnt;
+	req->data = req->iov[0].iov_base;
+	req->zcopy_bdev_io = bdev_io;
+
+	spdk_nvmf_request_zcopy_start_done(req, 0);
+}
+
+int
+spdk_nvmf_bdev_ctrlr_zcopy_start(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+				 struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
+{
+	uint64_t bdev_num_blocks = spdk_bdev_get_num_blocks(bdev);
+	uint32_t block_size = spdk_bdev_get_block_size(bdev);
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	uint64_t start_lba;
+	uint64_t num_blocks;
+
+	if (!spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZCOPY)) {
+		return -ENOTSUP;
+	}
+
+	nvmf_bdev_ctrlr_get_rw_params(cmd, &start_lba, &num_blocks);
+
+	/* Malformed commands take the regular path, which reports the right status */
+	if (!nvmf_bdev_ctrlr_lba_in_range(bdev_num_blocks, start_lba, num_blocks) ||
+	    num_blocks * block_size != req->length) {
+		return -EINVAL;
+	}
+
+	return spdk_bdev_zcopy_start(desc, ch, start_lba, num_blocks, false,
+				     nvmf_bdev_ctrlr_zcopy_start_complete, req);
+}
+
+static void
+nvmf_bdev_ctrlr_zcopy_release_done(struct spdk_bdev_io *bdev_io, bool success,
+				   void *cb_arg)
+{
+	spdk_bdev_free_io(bdev_io);
+}
+
+void
+spdk_nvmf_bdev_ctrlr_zcopy_release(struct spdk_nvmf_request *req)
+{
+	struct spdk_bdev_io *bdev_io = req->zcopy_bdev_io;
+
+	assert(bdev_io != NULL);
+	req->zcopy_bdev_io = NULL;
+
+	/* Nothing was written, so the buffers are simply dropped */
+	if (spdk_bdev_zcopy_end(bdev_io, false, nvmf_bdev_ctrlr_zcopy_release_done, NULL) != 0) {
+		spdk_bdev_free_io(bdev_io);
+	}
+}
+
 int
 spdk_nvmf_bdev_ctrlr_write_zeroes_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 				      struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
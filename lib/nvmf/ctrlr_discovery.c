@@ -48,59 +48,77 @@
 #include "spdk/bdev_module.h"
 #include "spdk_internal/log.h"
 
-static struct spdk_nvmf_discovery_log_page *
-nvmf_generate_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn, size_t *log_page_size)
+struct spdk_nvmf_discovery_cache {
+	uint64_t					genctr;
+	uint64_t					numrec;
+	struct spdk_nvmf_discovery_log_page_entry	*entries;
+	/* Subsystem of each entry, to filter the entries by host */
+	struct spdk_nvmf_subsystem			**subsystems;
+};
+
+static bool
+nvmf_subsystem_discoverable(struct spdk_nvmf_subsystem *subsystem)
+{
+	return subsystem != NULL &&
+	       subsystem->state != SPDK_NVMF_SUBSYSTEM_INACTIVE &&
+	       subsystem->state != SPDK_NVMF_SUBSYSTEM_DEACTIVATING &&
+	       subsystem->subtype != SPDK_NVMF_SUBTYPE_DISCOVERY;
+}
+
+static struct spdk_nvmf_discovery_cache *
+nvmf_generate_discovery_cache(struct spdk_nvmf_tgt *tgt)
 {
 	uint64_t numrec = 0;
 	struct spdk_nvmf_subsystem *subsystem;
 	struct spdk_nvmf_listener *listener;
 	struct spdk_nvmf_discovery_log_page_entry *entry;
-	struct spdk_nvmf_discovery_log_page *disc_log;
-	size_t cur_size;
+	struct spdk_nvmf_discovery_cache *cache;
 	uint32_t sid;
 
 	SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Generating log page for genctr %" PRIu64 "\n",
 		      tgt->discovery_genctr);
 
-	cur_size = sizeof(struct spdk_nvmf_discovery_log_page);
-	disc_log = calloc(1, cur_size);
-	if (disc_log == NULL) {
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
 		SPDK_ERRLOG("Discovery log page memory allocation error\n");
 		return NULL;
 	}
 
+	/* Size the entries up front instead of growing them one by one. */
 	for (sid = 0; sid < tgt->max_subsystems; sid++) {
 		subsystem = tgt->subsystems[sid];
-		if ((subsystem == NULL) ||
-		    (subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE) ||
-		    (subsystem->state == SPDK_NVMF_SUBSYSTEM_DEACTIVATING)) {
+		if (!nvmf_subsystem_discoverable(subsystem)) {
 			continue;
 		}
 
-		if (subsystem->subtype == SPDK_NVMF_SUBTYPE_DISCOVERY) {
-			continue;
+		for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem); listener != NULL;
+		     listener = spdk_nvmf_subsystem_get_next_listener(subsystem, listener)) {
+			numrec++;
 		}
+	}
+
+	if (numrec > 0) {
+		cache->entries = calloc(numrec, sizeof(*cache->entries));
+		cache->subsystems = calloc(numrec, sizeof(*cache->subsystems));
+		if (cache->entries == NULL || cache->subsystems == NULL) {
+			SPDK_ERRLOG("Discovery log page memory allocation error\n");
+			free(cache->entries);
+			free(cache->subsystems);
+			free(cache);
+			return NULL;
+		}
+	}
 
-		if (!spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn)) {
+	for (sid = 0; sid < tgt->max_subsystems && cache->numrec < numrec; sid++) {
+		subsystem = tgt->subsystems[sid];
+		if (!nvmf_subsystem_discoverable(subsystem)) {
 			continue;
 		}
 
-		for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem); listener != NULL;
+		for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem);
+		     listener != NULL && cache->numrec < numrec;
 		     listener = spdk_nvmf_subsystem_get_next_listener(subsystem, listener)) {
-			size_t new_size = cur_size + sizeof(*entry);
-			void *new_log_page = realloc(disc_log, new_size);
-
-			if (new_log_page == NULL) {
-				SPDK_ERRLOG("Discovery log page memory allocation error\n");
-				break;
-			}
-
-			disc_log = new_log_page;
-			cur_size = new_size;
-
-			entry = &disc_log->entries[numrec];
-			memset(entry, 0, sizeof(*entry));
-			entry->portid = numrec;
+			entry = &cache->entries[cache->numrec];
 			entry->cntlid = 0xffff;
 			entry->asqsz = listener->transport->opts.max_aq_depth;
 			entry->subtype = subsystem->subtype;
@@ -108,53 +126,131 @@ nvmf_generate_discovery_log(struct spdk_nvmf_tgt *tgt, const char *hostnqn, size
 
 			spdk_nvmf_transport_listener_discover(listener->transport, &listener->trid, entry);
 
-			numrec++;
+			cache->subsystems[cache->numrec++] = subsystem;
 		}
 	}
 
-	disc_log->numrec = numrec;
-	disc_log->genctr = tgt->discovery_genctr;
-	*log_page_size = cur_size;
+	cache->genctr = tgt->discovery_genctr;
+
+	return cache;
+}
 
-	return disc_log;
+static void
+nvmf_discovery_cache_free(struct spdk_nvmf_discovery_cache *cache)
+{
+	if (cache) {
+		free(cache->entries);
+		free(cache->subsystems);
+		free(cache);
+	}
 }
 
 void
-spdk_nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn, struct iovec *iov,
-				 uint32_t iovcnt, uint64_t offset, uint32_t length)
+spdk_nvmf_discovery_cache_free(struct spdk_nvmf_tgt *tgt)
 {
-	size_t copy_len = 0;
-	size_t zero_len = 0;
-	struct iovec *tmp;
-	size_t log_page_size = 0;
-	struct spdk_nvmf_discovery_log_page *discovery_log_page;
+	nvmf_discovery_cache_free(tgt->discovery_cache);
+	tgt->discovery_cache = NULL;
+}
 
-	discovery_log_page = nvmf_generate_discovery_log(tgt, hostnqn, &log_page_size);
+void
+spdk_nvmf_update_discovery_log(struct spdk_nvmf_tgt *tgt)
+{
+	pthread_mutex_lock(&tgt->discovery_lock);
+	tgt->discovery_genctr++;
+	spdk_nvmf_discovery_cache_free(tgt);
+	pthread_mutex_unlock(&tgt->discovery_lock);
+}
 
-	/* Copy the valid part of the discovery log page, if any */
-	if (discovery_log_page) {
-		for (tmp = iov; tmp < iov + iovcnt; tmp++) {
-			copy_len = spdk_min(tmp->iov_len, length);
-			copy_len = spdk_min(log_page_size - offset, copy_len);
+/* Copy the part of [src_offset, src_offset + src_len) that falls in [offset, offset + length) */
+static void
+nvmf_discovery_copy_range(uint8_t *buf, uint64_t offset, uint32_t length,
+			  const void *src, uint64_t src_offset, size_t src_len)
+{
+	uint64_t start = spdk_max(offset, src_offset);
+	uint64_t end = spdk_min(offset + length, src_offset + src_len);
 
-			memcpy(tmp->iov_base, (char *)discovery_log_page + offset, copy_len);
+	if (start < end) {
+		memcpy(buf + (start - offset), (const uint8_t *)src + (start - src_offset), end - start);
+	}
+}
+
+/*
+ * Build the requested part of the log page of a host from the cache. Only the
+ * entries that overlap with the requested range are copied, so reading the
+ * header of a large log doesn't touch its entries.
+ */
+static void
+nvmf_discovery_cache_read(struct spdk_nvmf_discovery_cache *cache, const char *hostnqn,
+			  uint8_t *buf, uint64_t offset, uint32_t length)
+{
+	struct spdk_nvmf_discovery_log_page hdr = {};
+	struct spdk_nvmf_discovery_log_page_entry entry;
+	uint64_t entry_offset;
+	uint64_t i, numrec = 0;
 
-			offset += copy_len;
-			length -= copy_len;
-			zero_len = tmp->iov_len - copy_len;
-			if (log_page_size <= offset || length == 0) {
-				break;
-			}
+	for (i = 0; i < cache->numrec; i++) {
+		if (spdk_nvmf_subsystem_host_allowed(cache->subsystems[i], hostnqn)) {
+			numrec++;
 		}
-		/* Zero out the rest of the payload */
-		if (zero_len) {
-			memset((char *)tmp->iov_base + copy_len, 0, zero_len);
+	}
+
+	hdr.genctr = cache->genctr;
+	hdr.numrec = numrec;
+	nvmf_discovery_copy_range(buf, offset, length, &hdr, 0, sizeof(hdr));
+
+	numrec = 0;
+	for (i = 0; i < cache->numrec; i++) {
+		if (!spdk_nvmf_subsystem_host_allowed(cache->subsystems[i], hostnqn)) {
+			continue;
 		}
 
-		for (++tmp; tmp < iov + iovcnt; tmp++) {
-			memset((char *)tmp->iov_base, 0, tmp->iov_len);
+		entry_offset = sizeof(hdr) + numrec * sizeof(entry);
+		if (entry_offset >= offset + length) {
+			break;
 		}
 
-		free(discovery_log_page);
+		if (entry_offset + sizeof(entry) > offset) {
+			entry = cache->entries[i];
+			entry.portid = numrec;
+			nvmf_discovery_copy_range(buf, offset, length, &entry, entry_offset, sizeof(entry));
+		}
+		numrec++;
 	}
 }
+
+void
+spdk_nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn, struct iovec *iov,
+				 uint32_t iovcnt, uint64_t offset, uint32_t length)
+{
+	struct iovec *tmp;
+	uint8_t *buf;
+	size_t copy_len;
+	uint32_t pos = 0;
+
+	buf = calloc(1, length);
+	if (buf == NULL) {
+		SPDK_ERRLOG("Discovery log page memory allocation error\n");
+		return;
+	}
+
+	pthread_mutex_lock(&tgt->discovery_lock);
+	if (tgt->discovery_cache == NULL || tgt->discovery_cache->genctr != tgt->discovery_genctr) {
+		spdk_nvmf_discovery_cache_free(tgt);
+		tgt->discovery_cache = nvmf_generate_discovery_cache(tgt);
+	}
+
+	if (tgt->discovery_cache) {
+		nvmf_discovery_cache_read(tgt->discovery_cache, hostnqn, buf, offset, length);
+	}
+	pthread_mutex_unlock(&tgt->discovery_lock);
+
+	/* Copy the requested part of the log page, anything past the log page is zeroed. */
+	for (tmp = iov; tmp < iov + iovcnt; tmp++) {
+		copy_len = spdk_min(tmp->iov_len, length - pos);
+		memcpy(tmp->iov_base, buf + pos, copy_len);
+		memset((char *)tmp->iov_base + copy_len, 0, tmp->iov_len - copy_len);
+		pos += copy_len;
+	}
+
+	free(buf);
+}
@@ -0,0 +1,755 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Per namespace read cache
+ *
+ * The namespace is cached in lines of line_size bytes, which are spread over
+ * one shard per core by line index so that poll groups reading different
+ * parts of the namespace don't contend on a lock. All line buffers are
+ * allocated up front. A read pins the lines it covers for as long as it uses
+ * their data, and lines that are not cached yet are filled by the read that
+ * missed them. Reads that find a line being filled by someone else bypass the
+ * cache. Unpinned lines are kept in LRU order and are reused from the tail.
+ *
+ * Invalidated lines are unhashed right away, so that later reads miss them,
+ * and are reused once the last read holding them releases them.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "nvmf_internal.h"
+
+#include "spdk/endian.h"
+#include "spdk/env.h"
+#include "spdk/nvme_spec.h"
+#include "spdk/util.h"
+
+#include "spdk_internal/log.h"
+
+#define NVMF_NS_CACHE_HOLD_POOL_SIZE	2048
+#define NVMF_NS_CACHE_BUF_ALIGN		0x1000
+
+enum nvmf_ns_cache_line_state {
+	NVMF_NS_CACHE_LINE_FREE = 0,
+	NVMF_NS_CACHE_LINE_FILLING,
+	NVMF_NS_CACHE_LINE_VALID,
+};
+
+struct nvmf_ns_cache_shard;
+
+struct nvmf_ns_cache_line {
+	uint64_t				index;
+	enum nvmf_ns_cache_line_state		state;
+	uint32_t				refcnt;
+	/* Dropped from the hash, reused once the last hold releases it */
+	bool					stale;
+	/* Hold responsible for filling the line while it is FILLING */
+	struct spdk_nvmf_ns_cache_hold		*filler;
+	struct nvmf_ns_cache_shard		*shard;
+	void					*buf;
+
+	LIST_ENTRY(nvmf_ns_cache_line)		hash_link;
+	/* Link in the free list, or in the LRU list while unpinned and VALID */
+	TAILQ_ENTRY(nvmf_ns_cache_line)		link;
+};
+
+struct nvmf_ns_cache_shard {
+	pthread_spinlock_t			lock;
+	struct nvmf_ns_cache_line		*lines;
+	uint32_t				num_lines;
+	/* Lines reachable through the hash */
+	uint32_t				num_cached;
+	uint32_t				hash_mask;
+	LIST_HEAD(, nvmf_ns_cache_line)		*hash;
+	TAILQ_HEAD(, nvmf_ns_cache_line)	free_lines;
+	TAILQ_HEAD(nvmf_ns_cache_lru, nvmf_ns_cache_line)	lru;
+	struct spdk_nvmf_ns_cache_stats		stats;
+};
+
+struct spdk_nvmf_ns_cache_hold {
+	struct spdk_nvmf_ns_cache		*cache;
+	void					*ctx;
+	uint64_t				first_line;
+	uint32_t				num_lines;
+	uint32_t				fills_outstanding;
+	bool					failed;
+	/* iovcnt of the request before its iov was pointed at the lines */
+	uint32_t				saved_iovcnt;
+	struct nvmf_ns_cache_line		*lines[NVMF_REQ_MAX_BUFFERS];
+};
+
+struct spdk_nvmf_ns_cache {
+	uint32_t				line_size;
+	uint32_t				line_blocks;
+	uint64_t				total_lines;
+	uint32_t				shard_shift;
+	uint32_t				shard_mask;
+	uint32_t				num_shards;
+	struct nvmf_ns_cache_shard		*shards;
+	struct spdk_mempool			*hold_pool;
+	/* The owner plus one per hold */
+	uint32_t				ref;
+};
+
+static inline uint32_t
+nvmf_ns_cache_align_pow2(uint32_t x)
+{
+	/* spdk_align32pow2() does not handle 1 */
+	return x <= 1 ? 1 : spdk_align32pow2(x);
+}
+
+static inline struct nvmf_ns_cache_shard *
+nvmf_ns_cache_get_shard(struct spdk_nvmf_ns_cache *cache, uint64_t index)
+{
+	return &cache->shards[index & cache->shard_mask];
+}
+
+static inline uint32_t
+nvmf_ns_cache_hash(struct spdk_nvmf_ns_cache *cache, struct nvmf_ns_cache_shard *shard,
+		   uint64_t index)
+{
+	return (uint32_t)(index >> cache->shard_shift) & shard->hash_mask;
+}
+
+static inline bool
+nvmf_ns_cache_line_is_hashed(const struct nvmf_ns_cache_line *line)
+{
+	return line->state != NVMF_NS_CACHE_LINE_FREE && !line->stale;
+}
+
+static void
+nvmf_ns_cache_free(struct spdk_nvmf_ns_cache *cache)
+{
+	struct nvmf_ns_cache_shard *shard;
+	uint32_t i, j;
+
+	if (cache->shards != NULL) {
+		for (i = 0; i < cache->num_shards; i++) {
+			shard = &cache->shards[i];
+			if (shard->lines != NULL) {
+				for (j = 0; j < shard->num_lines; j++) {
+					spdk_free(shard->lines[j].buf);
+				}
+			}
+			free(shard->lines);
+			free(shard->hash);
+			pthread_spin_destroy(&shard->lock);
+		}
+		free(cache->shards);
+	}
+
+	if (cache->hold_pool != NULL) {
+		spdk_mempool_free(cache->hold_pool);
+	}
+	free(cache);
+}
+
+static void
+nvmf_ns_cache_unref(struct spdk_nvmf_ns_cache *cache)
+{
+	if (__atomic_sub_fetch(&cache->ref, 1, __ATOMIC_ACQ_REL) == 0) {
+		nvmf_ns_cache_free(cache);
+	}
+}
+
+static int
+nvmf_ns_cache_shard_init(struct spdk_nvmf_ns_cache *cache, struct nvmf_ns_cache_shard *shard,
+			 uint32_t num_lines)
+{
+	struct nvmf_ns_cache_line *line;
+	uint32_t i;
+
+	if (pthread_spin_init(&shard->lock, PTHREAD_PROCESS_PRIVATE) != 0) {
+		return -ENOMEM;
+	}
+
+	TAILQ_INIT(&shard->free_lines);
+	TAILQ_INIT(&shard->lru);
+
+	shard->hash_mask = nvmf_ns_cache_align_pow2(num_lines) - 1;
+	shard->hash = calloc(shard->hash_mask + 1, sizeof(*shard->hash));
+	shard->lines = calloc(num_lines, sizeof(*shard->lines));
+	if (shard->hash == NULL || shard->lines == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_lines; i++) {
+		line = &shard->lines[i];
+		line->shard = shard;
+		line->buf = spdk_malloc(cache->line_size, NVMF_NS_CACHE_BUF_ALIGN, NULL,
+					SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+		if (line->buf == NULL) {
+			return -ENOMEM;
+		}
+		shard->num_lines++;
+		TAILQ_INSERT_TAIL(&shard->free_lines, line, link);
+	}
+
+	return 0;
+}
+
+struct spdk_nvmf_ns_cache *
+spdk_nvmf_ns_cache_create(const struct spdk_nvmf_ns_cache_opts *opts, uint32_t block_size)
+{
+	struct spdk_nvmf_ns_cache *cache;
+	char pool_name[32];
+	uint32_t i;
+
+	assert(opts->line_size != 0 && opts->line_size % block_size == 0);
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	cache->ref = 1;
+	cache->line_size = opts->line_size;
+	cache->line_blocks = opts->line_size / block_size;
+	cache->total_lines = opts->size_mb * 1024 * 1024 / opts->line_size;
+	if (cache->total_lines == 0 || cache->total_lines > UINT32_MAX) {
+		SPDK_ERRLOG("Unsupported cache size %" PRIu64 " MiB with %" PRIu32 " byte lines\n",
+			    opts->size_mb, opts->line_size);
+		free(cache);
+		return NULL;
+	}
+
+	/* One shard per core, as long as each of them gets a line */
+	cache->num_shards = nvmf_ns_cache_align_pow2(spdk_env_get_core_count());
+	while (cache->num_shards > 1 && cache->total_lines < cache->num_shards) {
+		cache->num_shards >>= 1;
+	}
+	cache->shard_shift = spdk_u32log2(cache->num_shards);
+	cache->shard_mask = cache->num_shards - 1;
+
+	cache->shards = calloc(cache->num_shards, sizeof(*cache->shards));
+	if (cache->shards == NULL) {
+		goto err;
+	}
+
+	for (i = 0; i < cache->num_shards; i++) {
+		if (nvmf_ns_cache_shard_init(cache, &cache->shards[i],
+					     cache->total_lines / cache->num_shards +
+					     (i < cache->total_lines % cache->num_shards ? 1 : 0))) {
+			SPDK_ERRLOG("Unable to allocate %" PRIu64 " MiB of read cache\n", opts->size_mb);
+			goto err;
+		}
+	}
+
+	snprintf(pool_name, sizeof(pool_name), "nvmf_nsc_%p", cache);
+	cache->hold_pool = spdk_mempool_create(pool_name, NVMF_NS_CACHE_HOLD_POOL_SIZE,
+					       sizeof(struct spdk_nvmf_ns_cache_hold),
+					       SPDK_MEMPOOL_DEFAULT_CACHE_SIZE,
+					       SPDK_ENV_SOCKET_ID_ANY);
+	if (cache->hold_pool == NULL) {
+		SPDK_ERRLOG("Unable to allocate read cache hold pool\n");
+		goto err;
+	}
+
+	return cache;
+
+err:
+	nvmf_ns_cache_free(cache);
+	return NULL;
+}
+
+void
+spdk_nvmf_ns_cache_destroy(struct spdk_nvmf_ns_cache *cache)
+{
+	if (cache != NULL) {
+		nvmf_ns_cache_unref(cache);
+	}
+}
+
+uint32_t
+spdk_nvmf_ns_cache_get_line_blocks(const struct spdk_nvmf_ns_cache *cache)
+{
+	return cache->line_blocks;
+}
+
+/* Called with the shard lock held */
+static void
+nvmf_ns_cache_line_drop(struct nvmf_ns_cache_shard *shard, struct nvmf_ns_cache_line *line)
+{
+	assert(nvmf_ns_cache_line_is_hashed(line));
+
+	LIST_REMOVE(line, hash_link);
+	line->stale = true;
+	shard->num_cached--;
+
+	if (line->refcnt == 0) {
+		assert(line->state == NVMF_NS_CACHE_LINE_VALID);
+		TAILQ_REMOVE(&shard->lru, line, link);
+		line->state = NVMF_NS_CACHE_LINE_FREE;
+		TAILQ_INSERT_HEAD(&shard->free_lines, line, link);
+	}
+}
+
+static struct nvmf_ns_cache_line *
+nvmf_ns_cache_line_get(struct spdk_nvmf_ns_cache *cache, struct spdk_nvmf_ns_cache_hold *hold,
+		       uint64_t index)
+{
+	struct nvmf_ns_cache_shard *shard = nvmf_ns_cache_get_shard(cache, index);
+	uint32_t bucket = nvmf_ns_cache_hash(cache, shard, index);
+	struct nvmf_ns_cache_line *line;
+
+	pthread_spin_lock(&shard->lock);
+	LIST_FOREACH(line, &shard->hash[bucket], hash_link) {
+		if (line->index == index) {
+			break;
+		}
+	}
+
+	if (line != NULL) {
+		if (line->state != NVMF_NS_CACHE_LINE_VALID) {
+			/* Someone else is filling it */
+			line = NULL;
+		} else if (line->refcnt++ == 0) {
+			TAILQ_REMOVE(&shard->lru, line, link);
+		}
+		pthread_spin_unlock(&shard->lock);
+		return line;
+	}
+
+	line = TAILQ_FIRST(&shard->free_lines);
+	if (line != NULL) {
+		TAILQ_REMOVE(&shard->free_lines, line, link);
+	} else {
+		line = TAILQ_LAST(&shard->lru, nvmf_ns_cache_lru);
+		if (line == NULL) {
+			/* Every line is in use */
+			pthread_spin_unlock(&shard->lock);
+			return NULL;
+		}
+		TAILQ_REMOVE(&shard->lru, line, link);
+		LIST_REMOVE(line, hash_link);
+		shard->num_cached--;
+		shard->stats.evictions++;
+	}
+
+	line->index = index;
+	line->state = NVMF_NS_CACHE_LINE_FILLING;
+	line->stale = false;
+	line->refcnt = 1;
+	line->filler = hold;
+	LIST_INSERT_HEAD(&shard->hash[bucket], line, hash_link);
+	shard->num_cached++;
+	pthread_spin_unlock(&shard->lock);
+
+	return line;
+}
+
+static void
+nvmf_ns_cache_line_put(struct nvmf_ns_cache_line *line)
+{
+	struct nvmf_ns_cache_shard *shard = line->shard;
+
+	pthread_spin_lock(&shard->lock);
+	assert(line->refcnt > 0);
+	if (--line->refcnt == 0) {
+		if (line->state == NVMF_NS_CACHE_LINE_VALID && !line->stale) {
+			TAILQ_INSERT_HEAD(&shard->lru, line, link);
+		} else {
+			/* Invalidated, or released before it was filled */
+			if (nvmf_ns_cache_line_is_hashed(line)) {
+				LIST_REMOVE(line, hash_link);
+				shard->num_cached--;
+			}
+			line->state = NVMF_NS_CACHE_LINE_FREE;
+			line->filler = NULL;
+			TAILQ_INSERT_HEAD(&shard->free_lines, line, link);
+		}
+	}
+	pthread_spin_unlock(&shard->lock);
+}
+
+static void
+nvmf_ns_cache_count(struct spdk_nvmf_ns_cache *cache, uint64_t index, uint64_t hits,
+		    uint64_t misses, uint64_t bypassed)
+{
+	struct nvmf_ns_cache_shard *shard = nvmf_ns_cache_get_shard(cache, index);
+
+	pthread_spin_lock(&shard->lock);
+	shard->stats.hits += hits;
+	shard->stats.misses += misses;
+	shard->stats.bypassed += bypassed;
+	pthread_spin_unlock(&shard->lock);
+}
+
+struct spdk_nvmf_ns_cache_hold *
+spdk_nvmf_ns_cache_hold_get(struct spdk_nvmf_ns_cache *cache, uint64_t start_lba,
+			    uint64_t num_blocks, void *ctx)
+{
+	struct spdk_nvmf_ns_cache_hold *hold;
+	struct nvmf_ns_cache_line *line;
+	uint64_t first_line, num_lines;
+	uint32_t i;
+
+	assert(num_blocks > 0);
+	first_line = start_lba / cache->line_blocks;
+	num_lines = (start_lba + num_blocks - 1) / cache->line_blocks - first_line + 1;
+
+	if (num_lines > NVMF_REQ_MAX_BUFFERS) {
+		nvmf_ns_cache_count(cache, first_line, 0, 0, 1);
+		return NULL;
+	}
+
+	hold = spdk_mempool_get(cache->hold_pool);
+	if (hold == NULL) {
+		nvmf_ns_cache_count(cache, first_line, 0, 0, 1);
+		return NULL;
+	}
+
+	hold->cache = cache;
+	hold->ctx = ctx;
+	hold->first_line = first_line;
+	hold->num_lines = 0;
+	hold->fills_outstanding = 0;
+	hold->failed = false;
+	hold->saved_iovcnt = 0;
+
+	for (i = 0; i < num_lines; i++) {
+		line = nvmf_ns_cache_line_get(cache, hold, first_line + i);
+		if (line == NULL) {
+			while (hold->num_lines > 0) {
+				line = hold->lines[--hold->num_lines];
+				nvmf_ns_cache_line_put(line);
+			}
+			spdk_mempool_put(cache->hold_pool, hold);
+			nvmf_ns_cache_count(cache, first_line, 0, 0, 1);
+			return NULL;
+		}
+
+		if (line->state == NVMF_NS_CACHE_LINE_FILLING) {
+			hold->fills_outstanding++;
+		}
+		hold->lines[hold->num_lines++] = line;
+	}
+
+	if (hold->fills_outstanding == 0) {
+		nvmf_ns_cache_count(cache, first_line, 1, 0, 0);
+	} else {
+		nvmf_ns_cache_count(cache, first_line, 0, 1, 0);
+	}
+
+	__atomic_fetch_add(&cache->ref, 1, __ATOMIC_RELAXED);
+
+	return hold;
+}
+
+void
+spdk_nvmf_ns_cache_hold_put(struct spdk_nvmf_ns_cache_hold *hold)
+{
+	struct spdk_nvmf_ns_cache *cache = hold->cache;
+	uint32_t i;
+
+	for (i = 0; i < hold->num_lines; i++) {
+		nvmf_ns_cache_line_put(hold->lines[i]);
+	}
+
+	spdk_mempool_put(cache->hold_pool, hold);
+	nvmf_ns_cache_unref(cache);
+}
+
+void *
+spdk_nvmf_ns_cache_hold_get_ctx(const struct spdk_nvmf_ns_cache_hold *hold)
+{
+	return hold->ctx;
+}
+
+uint32_t
+spdk_nvmf_ns_cache_hold_get_num_lines(const struct spdk_nvmf_ns_cache_hold *hold)
+{
+	return hold->num_lines;
+}
+
+void *
+spdk_nvmf_ns_cache_hold_get_line(struct spdk_nvmf_ns_cache_hold *hold, uint32_t idx,
+				 uint64_t *lba, void **fill_ctx)
+{
+	struct nvmf_ns_cache_line *line;
+
+	assert(idx < hold->num_lines);
+	line = hold->lines[idx];
+
+	*lba = (hold->first_line + idx) * hold->cache->line_blocks;
+	/* Only the filler touches these until it reports the fill */
+	*fill_ctx = (line->filler == hold && line->state == NVMF_NS_CACHE_LINE_FILLING) ? line : NULL;
+
+	return line->buf;
+}
+
+bool
+spdk_nvmf_ns_cache_fill_done(void *fill_ctx, bool success, struct spdk_nvmf_ns_cache_hold **_hold)
+{
+	struct nvmf_ns_cache_line *line = fill_ctx;
+	struct nvmf_ns_cache_shard *shard = line->shard;
+	struct spdk_nvmf_ns_cache_hold *hold = line->filler;
+
+	assert(hold != NULL && hold->fills_outstanding > 0);
+
+	pthread_spin_lock(&shard->lock);
+	assert(line->state == NVMF_NS_CACHE_LINE_FILLING);
+	line->filler = NULL;
+	if (success) {
+		/* A stale line still holds what this read asked for, but nobody else gets to see it */
+		line->state = NVMF_NS_CACHE_LINE_VALID;
+		shard->stats.fills++;
+	} else if (!line->stale) {
+		/* Let the next read try again */
+		LIST_REMOVE(line, hash_link);
+		line->stale = true;
+		shard->num_cached--;
+	}
+	pthread_spin_unlock(&shard->lock);
+
+	if (!success) {
+		hold->failed = true;
+	}
+
+	*_hold = hold;
+	return --hold->fills_outstanding == 0;
+}
+
+bool
+spdk_nvmf_ns_cache_hold_is_valid(const struct spdk_nvmf_ns_cache_hold *hold)
+{
+	return !hold->failed && hold->fills_outstanding == 0;
+}
+
+static void
+nvmf_ns_cache_shard_invalidate(struct nvmf_ns_cache_shard *shard, uint64_t first_line,
+			       uint64_t last_line)
+{
+	struct nvmf_ns_cache_line *line;
+	uint32_t i;
+
+	pthread_spin_lock(&shard->lock);
+	for (i = 0; i < shard->num_lines; i++) {
+		line = &shard->lines[i];
+		if (nvmf_ns_cache_line_is_hashed(line) &&
+		    line->index >= first_line && line->index <= last_line) {
+			nvmf_ns_cache_line_drop(shard, line);
+			shard->stats.invalidations++;
+		}
+	}
+	pthread_spin_unlock(&shard->lock);
+}
+
+void
+spdk_nvmf_ns_cache_invalidate(struct spdk_nvmf_ns_cache *cache, uint64_t start_lba,
+			      uint64_t num_blocks)
+{
+	struct nvmf_ns_cache_shard *shard;
+	struct nvmf_ns_cache_line *line;
+	uint64_t first_line, last_line, index;
+	uint32_t i;
+
+	if (num_blocks == 0) {
+		return;
+	}
+
+	first_line = start_lba / cache->line_blocks;
+	if (num_blocks > UINT64_MAX - start_lba) {
+		last_line = UINT64_MAX / cache->line_blocks;
+	} else {
+		last_line = (start_lba + num_blocks - 1) / cache->line_blocks;
+	}
+
+	if (last_line - first_line >= cache->total_lines) {
+		/* Cheaper to go through all the lines than through the range */
+		for (i = 0; i < cache->num_shards; i++) {
+			nvmf_ns_cache_shard_invalidate(&cache->shards[i], first_line, last_line);
+		}
+		return;
+	}
+
+	for (index = first_line; index <= last_line; index++) {
+		shard = nvmf_ns_cache_get_shard(cache, index);
+		pthread_spin_lock(&shard->lock);
+		LIST_FOREACH(line, &shard->hash[nvmf_ns_cache_hash(cache, shard, index)], hash_link) {
+			if (line->index == index) {
+				nvmf_ns_cache_line_drop(shard, line);
+				shard->stats.invalidations++;
+				break;
+			}
+		}
+		pthread_spin_unlock(&shard->lock);
+	}
+}
+
+void
+spdk_nvmf_ns_cache_purge(struct spdk_nvmf_ns_cache *cache)
+{
+	uint32_t i;
+
+	for (i = 0; i < cache->num_shards; i++) {
+		nvmf_ns_cache_shard_invalidate(&cache->shards[i], 0, UINT64_MAX);
+	}
+}
+
+void
+spdk_nvmf_ns_cache_invalidate_cmd(struct spdk_nvmf_ns_cache *cache,
+				  struct spdk_nvmf_request *req)
+{
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	struct spdk_nvme_dsm_range *dsm_range;
+	uint32_t nr, i;
+
+	switch (cmd->opc) {
+	case SPDK_NVME_OPC_READ:
+	case SPDK_NVME_OPC_COMPARE:
+	case SPDK_NVME_OPC_FLUSH:
+	case SPDK_NVME_OPC_RESERVATION_REGISTER:
+	case SPDK_NVME_OPC_RESERVATION_ACQUIRE:
+	case SPDK_NVME_OPC_RESERVATION_RELEASE:
+	case SPDK_NVME_OPC_RESERVATION_REPORT:
+		break;
+	case SPDK_NVME_OPC_WRITE:
+	case SPDK_NVME_OPC_WRITE_UNCORRECTABLE:
+	case SPDK_NVME_OPC_WRITE_ZEROES:
+		spdk_nvmf_ns_cache_invalidate(cache, from_le64(&cmd->cdw10),
+					      (from_le32(&cmd->cdw12) & 0xFFFFu) + 1);
+		break;
+	case SPDK_NVME_OPC_DATASET_MANAGEMENT:
+		if (!(cmd->cdw11 & SPDK_NVME_DSM_ATTR_DEALLOCATE)) {
+			break;
+		}
+		nr = (cmd->cdw10 & 0x000000ff) + 1;
+		if (req->data == NULL || req->length < nr * sizeof(struct spdk_nvme_dsm_range)) {
+			/* The command will fail, but don't count on it */
+			spdk_nvmf_ns_cache_purge(cache);
+			break;
+		}
+		dsm_range = req->data;
+		for (i = 0; i < nr; i++) {
+			spdk_nvmf_ns_cache_invalidate(cache, dsm_range[i].starting_lba,
+						      dsm_range[i].length);
+		}
+		break;
+	default:
+		/* Passthrough commands may change anything */
+		spdk_nvmf_ns_cache_purge(cache);
+		break;
+	}
+}
+
+void
+spdk_nvmf_ns_cache_request_serve(struct spdk_nvmf_request *req,
+				 struct spdk_nvmf_ns_cache_hold *hold,
+				 uint64_t start_lba, uint64_t num_blocks)
+{
+	struct spdk_nvmf_ns_cache *cache = hold->cache;
+	uint32_t block_size = cache->line_size / cache->line_blocks;
+	uint64_t offset = (start_lba - hold->first_line * cache->line_blocks) * block_size;
+	uint64_t remaining = num_blocks * block_size;
+	struct iovec *iov = req->iov;
+	uint32_t iov_off = 0;
+	size_t len, n;
+	uint8_t *src;
+	uint32_t i;
+
+	assert(spdk_nvmf_ns_cache_hold_is_valid(hold));
+	assert(req->cache_hold == NULL);
+
+	if (req->cache_zcopy) {
+		hold->saved_iovcnt = req->iovcnt;
+		req->cache_hold = hold;
+		for (i = 0; i < hold->num_lines; i++) {
+			len = spdk_min(remaining, cache->line_size - offset);
+			req->iov[i].iov_base = (uint8_t *)hold->lines[i]->buf + offset;
+			req->iov[i].iov_len = len;
+			remaining -= len;
+			offset = 0;
+		}
+		req->iovcnt = hold->num_lines;
+		return;
+	}
+
+	for (i = 0; i < hold->num_lines; i++) {
+		src = (uint8_t *)hold->lines[i]->buf + offset;
+		len = spdk_min(remaining, cache->line_size - offset);
+		remaining -= len;
+		offset = 0;
+		while (len > 0) {
+			n = spdk_min(len, iov->iov_len - iov_off);
+			memcpy((uint8_t *)iov->iov_base + iov_off, src, n);
+			src += n;
+			len -= n;
+			iov_off += n;
+			if (iov_off == iov->iov_len) {
+				iov++;
+				iov_off = 0;
+			}
+		}
+	}
+
+	spdk_nvmf_ns_cache_hold_put(hold);
+}
+
+void
+spdk_nvmf_ns_cache_request_release(struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_ns_cache_hold *hold = req->cache_hold;
+
+	if (hold == NULL) {
+		return;
+	}
+
+	req->iovcnt = hold->saved_iovcnt;
+	req->cache_hold = NULL;
+	spdk_nvmf_ns_cache_hold_put(hold);
+}
+
+void
+spdk_nvmf_ns_cache_get_stats(struct spdk_nvmf_ns_cache *cache,
+			     struct spdk_nvmf_ns_cache_stats *stats)
+{
+	struct nvmf_ns_cache_shard *shard;
+	uint32_t i;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < cache->num_shards; i++) {
+		shard = &cache->shards[i];
+		pthread_spin_lock(&shard->lock);
+		stats->hits += shard->stats.hits;
+		stats->misses += shard->stats.misses;
+		stats->bypassed += shard->stats.bypassed;
+		stats->fills += shard->stats.fills;
+		stats->evictions += shard->stats.evictions;
+		stats->invalidations += shard->stats.invalidations;
+		stats->lines += shard->num_cached;
+		pthread_spin_unlock(&shard->lock);
+	}
+	stats->bytes = stats->lines * cache->line_size;
+}
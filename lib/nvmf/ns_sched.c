@@ -0,0 +1,470 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Per namespace I/O scheduler
+ *
+ * Each poll group queues the I/O to a scheduled namespace per host (flow)
+ * once max_outstanding I/O are in flight, and dispatches the queues in
+ * deficit round robin order. A flow may dispatch its weight times the
+ * arbitration burst of the host's controller per round. Flows with rate
+ * limits draw from token buckets that are refilled every timeslice.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "nvmf_internal.h"
+
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "spdk_internal/log.h"
+
+#define NVMF_NS_SCHED_TIMESLICE_USEC	1000
+/* Commands a flow dispatches per round when its arbitration burst is unlimited */
+#define NVMF_NS_SCHED_MAX_BURST		64
+
+struct spdk_nvmf_ns_sched_flow {
+	struct spdk_nvmf_ns_sched_host_stat	stat;
+
+	uint32_t				weight;
+	/* Arbitration burst of the controller that sent the last request */
+	uint32_t				burst;
+	int64_t					deficit;
+
+	/* Token buckets, 0 per slice for no limit */
+	int64_t					ios_per_slice;
+	int64_t					ios_left;
+	int64_t					bytes_per_slice;
+	int64_t					bytes_left;
+
+	/* Set while the flow waits on the throttled list for its tokens */
+	bool					throttled;
+
+	STAILQ_HEAD(, spdk_nvmf_request)	queued;
+	TAILQ_ENTRY(spdk_nvmf_ns_sched_flow)	link;
+	/* Link in the active or the throttled list, only while requests are queued */
+	TAILQ_ENTRY(spdk_nvmf_ns_sched_flow)	sched_link;
+};
+
+struct spdk_nvmf_ns_sched {
+	struct spdk_nvmf_ns_sched_conf		conf;
+	uint32_t				outstanding;
+
+	struct spdk_poller			*poller;
+	bool					dispatching;
+	bool					destroyed;
+
+	TAILQ_HEAD(, spdk_nvmf_ns_sched_flow)	flows;
+	TAILQ_HEAD(, spdk_nvmf_ns_sched_flow)	active;
+	TAILQ_HEAD(, spdk_nvmf_ns_sched_flow)	throttled;
+};
+
+static int64_t
+nvmf_ns_sched_per_slice(uint64_t per_sec, uint32_t num_poll_groups)
+{
+	uint64_t per_slice;
+
+	if (per_sec == 0) {
+		return 0;
+	}
+
+	per_slice = per_sec * NVMF_NS_SCHED_TIMESLICE_USEC / SPDK_SEC_TO_USEC;
+	per_slice /= spdk_max(num_poll_groups, 1);
+
+	return spdk_max(per_slice, 1);
+}
+
+static void
+nvmf_ns_sched_flow_configure(struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_ns_sched_flow *flow)
+{
+	struct spdk_nvmf_ns_sched_host_opts opts = {};
+	uint32_t i;
+
+	for (i = 0; i < sched->conf.num_hosts; i++) {
+		if (strcmp(sched->conf.hosts[i].hostnqn, flow->stat.hostnqn) == 0) {
+			opts = sched->conf.hosts[i].opts;
+			break;
+		}
+	}
+
+	flow->weight = spdk_max(opts.weight, 1);
+	flow->ios_per_slice = nvmf_ns_sched_per_slice(opts.rw_ios_per_sec,
+			      sched->conf.num_poll_groups);
+	flow->bytes_per_slice = nvmf_ns_sched_per_slice(opts.rw_mbytes_per_sec * 1024 * 1024,
+				sched->conf.num_poll_groups);
+	flow->ios_left = flow->ios_per_slice;
+	flow->bytes_left = flow->bytes_per_slice;
+}
+
+static struct spdk_nvmf_ns_sched_flow *
+nvmf_ns_sched_get_flow(struct spdk_nvmf_ns_sched *sched, const char *hostnqn)
+{
+	struct spdk_nvmf_ns_sched_flow *flow;
+
+	TAILQ_FOREACH(flow, &sched->flows, link) {
+		if (strcmp(flow->stat.hostnqn, hostnqn) == 0) {
+			return flow;
+		}
+	}
+
+	flow = calloc(1, sizeof(*flow));
+	if (flow == NULL) {
+		SPDK_ERRLOG("Unable to allocate a scheduler queue for host %s\n", hostnqn);
+		return NULL;
+	}
+
+	snprintf(flow->stat.hostnqn, sizeof(flow->stat.hostnqn), "%s", hostnqn);
+	STAILQ_INIT(&flow->queued);
+	nvmf_ns_sched_flow_configure(sched, flow);
+	TAILQ_INSERT_TAIL(&sched->flows, flow, link);
+
+	return flow;
+}
+
+static inline bool
+nvmf_ns_sched_has_slot(struct spdk_nvmf_ns_sched *sched)
+{
+	return sched->conf.opts.max_outstanding == 0 ||
+	       sched->outstanding < sched->conf.opts.max_outstanding;
+}
+
+static inline bool
+nvmf_ns_sched_flow_has_tokens(struct spdk_nvmf_ns_sched_flow *flow)
+{
+	return (flow->ios_per_slice == 0 || flow->ios_left > 0) &&
+	       (flow->bytes_per_slice == 0 || flow->bytes_left > 0);
+}
+
+static inline int64_t
+nvmf_ns_sched_flow_quantum(struct spdk_nvmf_ns_sched_flow *flow)
+{
+	return (int64_t)flow->weight * flow->burst;
+}
+
+static void
+nvmf_ns_sched_account(struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_ns_sched_flow *flow,
+		      struct spdk_nvmf_request *req, uint64_t queue_ticks)
+{
+	sched->outstanding++;
+
+	if (flow->ios_per_slice != 0) {
+		flow->ios_left--;
+	}
+	/* A large I/O may overdraw the bucket, the debt is paid off in the next timeslices. */
+	if (flow->bytes_per_slice != 0) {
+		flow->bytes_left -= req->length;
+	}
+
+	flow->stat.ios++;
+	flow->stat.queue_ticks += queue_ticks;
+	flow->stat.max_queue_ticks = spdk_max(flow->stat.max_queue_ticks, queue_ticks);
+}
+
+static void
+nvmf_ns_sched_free(struct spdk_nvmf_ns_sched *sched)
+{
+	struct spdk_nvmf_ns_sched_flow *flow;
+
+	while ((flow = TAILQ_FIRST(&sched->flows)) != NULL) {
+		assert(STAILQ_EMPTY(&flow->queued));
+		TAILQ_REMOVE(&sched->flows, flow, link);
+		free(flow);
+	}
+
+	spdk_poller_unregister(&sched->poller);
+	free(sched->conf.hosts);
+	free(sched);
+}
+
+static void
+nvmf_ns_sched_dispatch(struct spdk_nvmf_ns_sched *sched)
+{
+	struct spdk_nvmf_ns_sched_flow *flow;
+	struct spdk_nvmf_request *req;
+	uint64_t now;
+
+	/* Requests completing inline while dispatching land here again. */
+	if (sched->dispatching) {
+		return;
+	}
+	sched->dispatching = true;
+
+	now = spdk_get_ticks();
+	while (!sched->destroyed && nvmf_ns_sched_has_slot(sched)) {
+		flow = TAILQ_FIRST(&sched->active);
+		if (flow == NULL) {
+			break;
+		}
+
+		req = STAILQ_FIRST(&flow->queued);
+		assert(req != NULL);
+
+		/* Requests of disconnecting queue pairs are aborted without waiting for their turn. */
+		if (spdk_likely(req->qpair->state == SPDK_NVMF_QPAIR_ACTIVE)) {
+			if (!nvmf_ns_sched_flow_has_tokens(flow)) {
+				TAILQ_REMOVE(&sched->active, flow, sched_link);
+				TAILQ_INSERT_TAIL(&sched->throttled, flow, sched_link);
+				flow->throttled = true;
+				continue;
+			}
+
+			if (flow->deficit <= 0) {
+				/* The flow used up its round, move it to the back. */
+				flow->deficit += nvmf_ns_sched_flow_quantum(flow);
+				TAILQ_REMOVE(&sched->active, flow, sched_link);
+				TAILQ_INSERT_TAIL(&sched->active, flow, sched_link);
+				continue;
+			}
+		}
+
+		STAILQ_REMOVE_HEAD(&flow->queued, sched_link);
+		flow->stat.queue_depth--;
+		if (STAILQ_EMPTY(&flow->queued)) {
+			TAILQ_REMOVE(&sched->active, flow, sched_link);
+			flow->deficit = 0;
+		}
+
+		if (spdk_unlikely(req->qpair->state != SPDK_NVMF_QPAIR_ACTIVE)) {
+			req->sched_flow = NULL;
+			req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+			req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_ABORTED_SQ_DELETION;
+			spdk_nvmf_request_complete(req);
+			continue;
+		}
+
+		flow->deficit--;
+		nvmf_ns_sched_account(sched, flow, req, now - req->sched_tsc);
+		spdk_nvmf_request_exec_scheduled(req);
+	}
+
+	sched->dispatching = false;
+
+	if (sched->destroyed) {
+		nvmf_ns_sched_free(sched);
+	}
+}
+
+static int
+nvmf_ns_sched_refill(void *ctx)
+{
+	struct spdk_nvmf_ns_sched *sched = ctx;
+	struct spdk_nvmf_ns_sched_flow *flow;
+	int count = 0;
+
+	TAILQ_FOREACH(flow, &sched->flows, link) {
+		if (flow->ios_per_slice != 0) {
+			flow->ios_left = spdk_min(flow->ios_left + flow->ios_per_slice, flow->ios_per_slice);
+		}
+		if (flow->bytes_per_slice != 0) {
+			flow->bytes_left = spdk_min(flow->bytes_left + flow->bytes_per_slice,
+						    flow->bytes_per_slice);
+		}
+	}
+
+	while ((flow = TAILQ_FIRST(&sched->throttled)) != NULL) {
+		TAILQ_REMOVE(&sched->throttled, flow, sched_link);
+		TAILQ_INSERT_TAIL(&sched->active, flow, sched_link);
+		flow->throttled = false;
+		count++;
+	}
+
+	if (!TAILQ_EMPTY(&sched->active)) {
+		nvmf_ns_sched_dispatch(sched);
+	}
+
+	return count;
+}
+
+bool
+spdk_nvmf_ns_sched_submit(struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
+	struct spdk_nvmf_ns_sched_flow *flow;
+	uint32_t ab;
+
+	flow = nvmf_ns_sched_get_flow(sched, ctrlr->hostnqn);
+	if (spdk_unlikely(flow == NULL)) {
+		/* Let the request through unscheduled rather than failing it. */
+		return true;
+	}
+
+	/* An arbitration burst of 111b means there is no limit. */
+	ab = ctrlr->feat.arbitration.bits.ab;
+	flow->burst = ab >= 7 ? NVMF_NS_SCHED_MAX_BURST : spdk_min(1u << ab, NVMF_NS_SCHED_MAX_BURST);
+
+	req->sched_flow = flow;
+
+	if (STAILQ_EMPTY(&flow->queued) && nvmf_ns_sched_has_slot(sched) &&
+	    nvmf_ns_sched_flow_has_tokens(flow)) {
+		nvmf_ns_sched_account(sched, flow, req, 0);
+		return true;
+	}
+
+	req->sched_tsc = spdk_get_ticks();
+	flow->stat.queued_ios++;
+	if (!nvmf_ns_sched_flow_has_tokens(flow)) {
+		flow->stat.throttled_ios++;
+	}
+
+	if (STAILQ_EMPTY(&flow->queued)) {
+		assert(!flow->throttled);
+		flow->deficit = nvmf_ns_sched_flow_quantum(flow);
+		TAILQ_INSERT_TAIL(&sched->active, flow, sched_link);
+	}
+	STAILQ_INSERT_TAIL(&flow->queued, req, sched_link);
+	flow->stat.queue_depth++;
+
+	return false;
+}
+
+void
+spdk_nvmf_ns_sched_request_done(struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_request *req)
+{
+	req->sched_flow = NULL;
+
+	assert(sched->outstanding > 0);
+	sched->outstanding--;
+
+	if (!TAILQ_EMPTY(&sched->active)) {
+		nvmf_ns_sched_dispatch(sched);
+	}
+}
+
+int
+spdk_nvmf_ns_sched_update(struct spdk_nvmf_ns_sched *sched,
+			  const struct spdk_nvmf_ns_sched_conf *conf)
+{
+	struct spdk_nvmf_ns_sched_host *hosts = NULL;
+	struct spdk_nvmf_ns_sched_flow *flow;
+
+	if (conf->num_hosts > 0) {
+		hosts = calloc(conf->num_hosts, sizeof(*hosts));
+		if (hosts == NULL) {
+			return -ENOMEM;
+		}
+		memcpy(hosts, conf->hosts, conf->num_hosts * sizeof(*hosts));
+	}
+
+	free(sched->conf.hosts);
+	sched->conf = *conf;
+	sched->conf.hosts = hosts;
+
+	TAILQ_FOREACH(flow, &sched->flows, link) {
+		nvmf_ns_sched_flow_configure(sched, flow);
+	}
+
+	return 0;
+}
+
+struct spdk_nvmf_ns_sched *
+spdk_nvmf_ns_sched_create(const struct spdk_nvmf_ns_sched_conf *conf)
+{
+	struct spdk_nvmf_ns_sched *sched;
+
+	sched = calloc(1, sizeof(*sched));
+	if (sched == NULL) {
+		return NULL;
+	}
+
+	TAILQ_INIT(&sched->flows);
+	TAILQ_INIT(&sched->active);
+	TAILQ_INIT(&sched->throttled);
+
+	if (spdk_nvmf_ns_sched_update(sched, conf) != 0) {
+		free(sched);
+		return NULL;
+	}
+
+	sched->poller = spdk_poller_register(nvmf_ns_sched_refill, sched, NVMF_NS_SCHED_TIMESLICE_USEC);
+	if (sched->poller == NULL) {
+		free(sched->conf.hosts);
+		free(sched);
+		return NULL;
+	}
+
+	return sched;
+}
+
+void
+spdk_nvmf_ns_sched_destroy(struct spdk_nvmf_ns_sched *sched)
+{
+	/* Freed once the dispatch loop this is called from unwinds. */
+	if (sched->dispatching) {
+		sched->destroyed = true;
+		return;
+	}
+
+	nvmf_ns_sched_free(sched);
+}
+
+int
+spdk_nvmf_ns_sched_get_stats(struct spdk_nvmf_ns_sched *sched,
+			     struct spdk_nvmf_ns_sched_host_stat **stats, uint32_t *num_stats)
+{
+	struct spdk_nvmf_ns_sched_flow *flow;
+	struct spdk_nvmf_ns_sched_host_stat *stat;
+	void *buf;
+	uint32_t i;
+
+	TAILQ_FOREACH(flow, &sched->flows, link) {
+		for (i = 0; i < *num_stats; i++) {
+			if (strcmp((*stats)[i].hostnqn, flow->stat.hostnqn) == 0) {
+				break;
+			}
+		}
+
+		if (i == *num_stats) {
+			buf = realloc(*stats, (*num_stats + 1) * sizeof(**stats));
+			if (buf == NULL) {
+				return -ENOMEM;
+			}
+			*stats = buf;
+			memset(&(*stats)[i], 0, sizeof(**stats));
+			snprintf((*stats)[i].hostnqn, sizeof((*stats)[i].hostnqn), "%s", flow->stat.hostnqn);
+			(*num_stats)++;
+		}
+
+		stat = &(*stats)[i];
+		stat->ios += flow->stat.ios;
+		stat->queued_ios += flow->stat.queued_ios;
+		stat->throttled_ios += flow->stat.throttled_ios;
+		stat->queue_ticks += flow->stat.queue_ticks;
+		stat->max_queue_ticks = spdk_max(stat->max_queue_ticks, flow->stat.max_queue_ticks);
+		stat->queue_depth += flow->stat.queue_depth;
+	}
+
+	return 0;
+}
@@ -169,6 +169,10 @@ spdk_nvmf_tgt_destroy_poll_group(void *io_device, void *ctx_buf)
 				spdk_put_io_channel(sgroup->ns_info[nsid].channel);
 				sgroup->ns_info[nsid].channel = NULL;
 			}
+			if (sgroup->ns_info[nsid].sched) {
+				spdk_nvmf_ns_sched_destroy(sgroup->ns_info[nsid].sched);
+				sgroup->ns_info[nsid].sched = NULL;
+			}
 		}
 
 		free(sgroup->ns_info);
@@ -257,6 +261,13 @@ spdk_nvmf_tgt_create(struct spdk_nvmf_target_opts *opts)
 		return NULL;
 	}
 
+	if (pthread_mutex_init(&tgt->discovery_lock, NULL)) {
+		SPDK_ERRLOG("pthread_mutex_init() failed\n");
+		free(tgt->subsystems);
+		free(tgt);
+		return NULL;
+	}
+
 	TAILQ_INSERT_HEAD(&g_nvmf_tgts, tgt, link);
 
 	spdk_io_device_register(tgt,
@@ -291,6 +302,9 @@ spdk_nvmf_tgt_destroy_cb(void *io_device)
 		spdk_nvmf_transport_destroy(transport);
 	}
 
+	spdk_nvmf_discovery_cache_free(tgt);
+	pthread_mutex_destroy(&tgt->discovery_lock);
+
 	destroy_cb_fn = tgt->destroy_cb_fn;
 	destroy_cb_arg = tgt->destroy_cb_arg;
 
@@ -342,6 +356,69 @@ spdk_nvmf_get_tgt(const char *name)
 	return NULL;
 }
 
+static void
+spdk_nvmf_write_ns_sched_config_json(struct spdk_json_write_ctx *w,
+				     struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_ns *ns)
+{
+	struct spdk_nvmf_ns_sched_host *host;
+	uint32_t i;
+
+	for (i = 0; i < ns->sched_conf.num_hosts; i++) {
+		host = &ns->sched_conf.hosts[i];
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "nvmf_subsystem_set_ns_sched_host");
+
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
+		spdk_json_write_named_uint32(w, "nsid", spdk_nvmf_ns_get_id(ns));
+		spdk_json_write_named_string(w, "host", host->hostnqn);
+		spdk_json_write_named_uint32(w, "weight", host->opts.weight);
+		spdk_json_write_named_uint64(w, "rw_ios_per_sec", host->opts.rw_ios_per_sec);
+		spdk_json_write_named_uint64(w, "rw_mbytes_per_sec", host->opts.rw_mbytes_per_sec);
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_object_end(w);
+	}
+
+	if (!ns->sched_conf.opts.enabled) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "nvmf_subsystem_set_ns_sched");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
+	spdk_json_write_named_uint32(w, "nsid", spdk_nvmf_ns_get_id(ns));
+	spdk_json_write_named_bool(w, "enable", true);
+	spdk_json_write_named_uint32(w, "max_outstanding", ns->sched_conf.opts.max_outstanding);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
+static void
+spdk_nvmf_write_ns_cache_config_json(struct spdk_json_write_ctx *w,
+				     struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_ns *ns)
+{
+	if (ns->cache == NULL) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "nvmf_subsystem_set_ns_cache");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
+	spdk_json_write_named_uint32(w, "nsid", spdk_nvmf_ns_get_id(ns));
+	spdk_json_write_named_uint64(w, "size_mb", ns->cache_opts.size_mb);
+	spdk_json_write_named_uint32(w, "line_size", ns->cache_opts.line_size);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
 static void
 spdk_nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 				      struct spdk_nvmf_subsystem *subsystem)
@@ -470,6 +547,10 @@ spdk_nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 			spdk_json_write_named_string(w, "uuid",  uuid_str);
 		}
 
+		if (ns_opts.anagrpid != spdk_nvmf_ns_get_id(ns)) {
+			spdk_json_write_named_uint32(w, "anagrpid", ns_opts.anagrpid);
+		}
+
 		/*     "namespace" */
 		spdk_json_write_object_end(w);
 
@@ -478,6 +559,9 @@ spdk_nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 
 		/* } */
 		spdk_json_write_object_end(w);
+
+		spdk_nvmf_write_ns_sched_config_json(w, subsystem, ns);
+		spdk_nvmf_write_ns_cache_config_json(w, subsystem, ns);
 	}
 }
 
@@ -511,6 +595,8 @@ spdk_nvmf_tgt_write_config_json(struct spdk_json_write_ctx *w, struct spdk_nvmf_
 		spdk_json_write_named_uint32(w, "max_aq_depth", transport->opts.max_aq_depth);
 		if (transport->ops->type == SPDK_NVME_TRANSPORT_RDMA) {
 			spdk_json_write_named_uint32(w, "max_srq_depth", transport->opts.max_srq_depth);
+			spdk_json_write_named_uint32(w, "max_inline_data_size",
+						     transport->opts.max_inline_data_size);
 		}
 		spdk_json_write_object_end(w);
 
@@ -554,7 +640,7 @@ spdk_nvmf_tgt_listen(struct spdk_nvmf_tgt *tgt,
 		return;
 	}
 
-	tgt->discovery_genctr++;
+	spdk_nvmf_update_discovery_log(tgt);
 
 	cb_fn(cb_arg, 0);
 }
@@ -624,18 +710,14 @@ struct spdk_nvmf_subsystem *
 spdk_nvmf_tgt_find_subsystem(struct spdk_nvmf_tgt *tgt, const char *subnqn)
 {
 	struct spdk_nvmf_subsystem	*subsystem;
-	uint32_t sid;
+	uint32_t bucket;
 
 	if (!subnqn) {
 		return NULL;
 	}
 
-	for (sid = 0; sid < tgt->max_subsystems; sid++) {
-		subsystem = tgt->subsystems[sid];
-		if (subsystem == NULL) {
-			continue;
-		}
-
+	bucket = _spdk_nvmf_nqn_hash(subnqn) % SPDK_NVMF_SUBSYSTEM_HASH_BUCKETS;
+	LIST_FOREACH(subsystem, &tgt->subsystem_hash[bucket], hash_link) {
 		if (strcmp(subnqn, subsystem->subnqn) == 0) {
 			return subsystem;
 		}
@@ -903,6 +985,63 @@ spdk_nvmf_poll_group_add_transport(struct spdk_nvmf_poll_group *group,
 	return 0;
 }
 
+static int
+poll_group_update_ns_sched(struct spdk_nvmf_subsystem_pg_ns_info *ns_info,
+			   struct spdk_nvmf_ns *ns)
+{
+	if (!ns->sched_conf.opts.enabled) {
+		if (ns_info->sched) {
+			spdk_nvmf_ns_sched_destroy(ns_info->sched);
+			ns_info->sched = NULL;
+		}
+		return 0;
+	}
+
+	if (ns_info->sched) {
+		return spdk_nvmf_ns_sched_update(ns_info->sched, &ns->sched_conf);
+	}
+
+	ns_info->sched = spdk_nvmf_ns_sched_create(&ns->sched_conf);
+	if (ns_info->sched == NULL) {
+		SPDK_ERRLOG("Could not create the I/O scheduler of nsid %u\n", ns->nsid);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/*
+ * Controllers are linked into the subsystem before their admin queue is set on
+ * their own thread, so skip those without one. Only this poll group's thread
+ * touches the changed namespace list of its controllers, so it can't race a
+ * Get Log Page that reads or clears it.
+ */
+static void
+poll_group_record_ns_changed(struct spdk_nvmf_poll_group *group,
+			     struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
+{
+	struct spdk_nvmf_ctrlr *ctrlr;
+
+	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+		if (ctrlr->admin_qpair != NULL && ctrlr->admin_qpair->group == group) {
+			spdk_nvmf_ctrlr_ns_changed(ctrlr, nsid);
+		}
+	}
+}
+
+static void
+poll_group_notify_ns_changed(struct spdk_nvmf_poll_group *group,
+			     struct spdk_nvmf_subsystem *subsystem)
+{
+	struct spdk_nvmf_ctrlr *ctrlr;
+
+	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+		if (ctrlr->admin_qpair != NULL && ctrlr->admin_qpair->group == group) {
+			spdk_nvmf_ctrlr_async_event_ns_notice(ctrlr);
+		}
+	}
+}
+
 static int
 poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 			    struct spdk_nvmf_subsystem *subsystem)
@@ -910,11 +1049,11 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 	struct spdk_nvmf_subsystem_poll_group *sgroup;
 	uint32_t new_num_ns, old_num_ns;
 	uint32_t i, j;
+	int rc;
 	struct spdk_nvmf_ns *ns;
 	struct spdk_nvmf_registrant *reg, *tmp;
 	struct spdk_io_channel *ch;
 	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
-	struct spdk_nvmf_ctrlr *ctrlr;
 	bool ns_changed;
 
 	/* Make sure our poll group has memory for this subsystem allocated */
@@ -964,6 +1103,10 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 				spdk_put_io_channel(ns_info->channel);
 				ns_info->channel = NULL;
 			}
+			if (ns_info->sched) {
+				spdk_nvmf_ns_sched_destroy(ns_info->sched);
+				ns_info->sched = NULL;
+			}
 		}
 
 		/* Make the array smaller */
@@ -987,16 +1130,23 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 		ns_info = &sgroup->ns_info[i];
 		ch = ns_info->channel;
 
+		if (ns == NULL && ns_info->io_outstanding != 0) {
+			/* A hot removal is draining this namespace and will release it. */
+			continue;
+		}
+
 		if (ns == NULL && ch == NULL) {
 			/* Both NULL. Leave empty */
 		} else if (ns == NULL && ch != NULL) {
 			/* There was a channel here, but the namespace is gone. */
 			ns_changed = true;
+			poll_group_record_ns_changed(group, subsystem, i + 1);
 			spdk_put_io_channel(ch);
 			ns_info->channel = NULL;
 		} else if (ns != NULL && ch == NULL) {
 			/* A namespace appeared but there is no channel yet */
 			ns_changed = true;
+			poll_group_record_ns_changed(group, subsystem, i + 1);
 			ch = spdk_bdev_get_io_channel(ns->desc);
 			if (ch == NULL) {
 				SPDK_ERRLOG("Could not allocate I/O channel.\n");
@@ -1006,7 +1156,11 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 		} else if (spdk_uuid_compare(&ns_info->uuid, spdk_bdev_get_uuid(ns->bdev)) != 0) {
 			/* A namespace was here before, but was replaced by a new one. */
 			ns_changed = true;
+			poll_group_record_ns_changed(group, subsystem, i + 1);
 			spdk_put_io_channel(ns_info->channel);
+			if (ns_info->sched) {
+				spdk_nvmf_ns_sched_destroy(ns_info->sched);
+			}
 			memset(ns_info, 0, sizeof(*ns_info));
 
 			ch = spdk_bdev_get_io_channel(ns->desc);
@@ -1018,8 +1172,16 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 		}
 
 		if (ns == NULL) {
+			if (ns_info->sched) {
+				spdk_nvmf_ns_sched_destroy(ns_info->sched);
+			}
 			memset(ns_info, 0, sizeof(*ns_info));
 		} else {
+			rc = poll_group_update_ns_sched(ns_info, ns);
+			if (rc != 0) {
+				return rc;
+			}
+
 			ns_info->uuid = *spdk_bdev_get_uuid(ns->bdev);
 			ns_info->crkey = ns->crkey;
 			ns_info->rtype = ns->rtype;
@@ -1040,11 +1202,7 @@ poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 	}
 
 	if (ns_changed) {
-		TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
-			if (ctrlr->admin_qpair->group == group) {
-				spdk_nvmf_ctrlr_async_event_ns_notice(ctrlr);
-			}
-		}
+		poll_group_notify_ns_changed(group, subsystem);
 	}
 
 	return 0;
@@ -1057,6 +1215,66 @@ spdk_nvmf_poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 	return poll_group_update_subsystem(group, subsystem);
 }
 
+void
+spdk_nvmf_poll_group_remove_ns_done(struct spdk_nvmf_poll_group *group,
+				    struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
+{
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+	spdk_nvmf_poll_group_mod_done cb_fn;
+	void *cb_arg;
+
+	ns_info = &group->sgroups[subsystem->id].ns_info[nsid - 1];
+	assert(ns_info->io_outstanding == 0);
+
+	cb_fn = ns_info->remove_cb_fn;
+	cb_arg = ns_info->remove_cb_arg;
+
+	if (ns_info->channel) {
+		spdk_put_io_channel(ns_info->channel);
+	}
+	if (ns_info->sched) {
+		spdk_nvmf_ns_sched_destroy(ns_info->sched);
+	}
+	memset(ns_info, 0, sizeof(*ns_info));
+
+	poll_group_record_ns_changed(group, subsystem, nsid);
+	poll_group_notify_ns_changed(group, subsystem);
+
+	if (cb_fn) {
+		cb_fn(cb_arg, 0);
+	}
+}
+
+void
+spdk_nvmf_poll_group_remove_ns(struct spdk_nvmf_poll_group *group,
+			       struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			       spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg)
+{
+	struct spdk_nvmf_subsystem_poll_group *sgroup = &group->sgroups[subsystem->id];
+	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+
+	if (nsid > sgroup->num_ns) {
+		/* The namespace was never attached to this poll group. */
+		poll_group_record_ns_changed(group, subsystem, nsid);
+		poll_group_notify_ns_changed(group, subsystem);
+		cb_fn(cb_arg, 0);
+		return;
+	}
+
+	ns_info = &sgroup->ns_info[nsid - 1];
+	assert(ns_info->remove_cb_fn == NULL);
+	ns_info->remove_cb_fn = cb_fn;
+	ns_info->remove_cb_arg = cb_arg;
+
+	/*
+	 * The namespace is no longer published, so no new I/O can reach it. If
+	 * some is still in flight, the last completion finishes the removal.
+	 */
+	if (ns_info->io_outstanding == 0) {
+		spdk_nvmf_poll_group_remove_ns_done(group, subsystem, nsid);
+	}
+}
+
 int
 spdk_nvmf_poll_group_add_subsystem(struct spdk_nvmf_poll_group *group,
 				   struct spdk_nvmf_subsystem *subsystem,
@@ -1108,6 +1326,10 @@ _nvmf_poll_group_remove_subsystem_cb(void *ctx, int status)
 			spdk_put_io_channel(sgroup->ns_info[nsid].channel);
 			sgroup->ns_info[nsid].channel = NULL;
 		}
+		if (sgroup->ns_info[nsid].sched) {
+			spdk_nvmf_ns_sched_destroy(sgroup->ns_info[nsid].sched);
+			sgroup->ns_info[nsid].sched = NULL;
+		}
 	}
 
 	sgroup->num_ns = 0;
@@ -76,16 +76,38 @@ enum spdk_nvmf_qpair_state {
 
 typedef void (*spdk_nvmf_state_change_done)(void *cb_arg, int status);
 
+#define SPDK_NVMF_SUBSYSTEM_HASH_BUCKETS	1024
+#define SPDK_NVMF_HOST_HASH_BUCKETS		16
+
+/* Controllers are indexed by cntlid in pages allocated on first use */
+#define SPDK_NVMF_CNTLID_PAGE_SHIFT		8
+#define SPDK_NVMF_CNTLID_PAGE_SIZE		(1u << SPDK_NVMF_CNTLID_PAGE_SHIFT)
+#define SPDK_NVMF_CNTLID_NUM_PAGES		(0x10000u >> SPDK_NVMF_CNTLID_PAGE_SHIFT)
+
+struct spdk_nvmf_discovery_cache;
+
 struct spdk_nvmf_tgt {
 	char					name[NVMF_TGT_NAME_MAX_LENGTH];
 
 	uint64_t				discovery_genctr;
 
+	/*
+	 * Discovery log entries of every visible subsystem, built on the first
+	 * discovery request after discovery_genctr changed. Filtered per host
+	 * when it is read. Protected by discovery_lock, as discovery requests
+	 * arrive on all poll groups.
+	 */
+	struct spdk_nvmf_discovery_cache	*discovery_cache;
+	pthread_mutex_t				discovery_lock;
+
 	uint32_t				max_subsystems;
 
 	/* Array of subsystem pointers of size max_subsystems indexed by sid */
 	struct spdk_nvmf_subsystem		**subsystems;
 
+	/* Subsystems hashed by NQN */
+	LIST_HEAD(, spdk_nvmf_subsystem)	subsystem_hash[SPDK_NVMF_SUBSYSTEM_HASH_BUCKETS];
+
 	TAILQ_HEAD(, spdk_nvmf_transport)	transports;
 
 	spdk_nvmf_tgt_destroy_done_fn		*destroy_cb_fn;
@@ -97,11 +119,16 @@ struct spdk_nvmf_tgt {
 struct spdk_nvmf_host {
 	char				nqn[SPDK_NVMF_NQN_MAX_LEN + 1];
 	TAILQ_ENTRY(spdk_nvmf_host)	link;
+	LIST_ENTRY(spdk_nvmf_host)	hash_link;
 };
 
 struct spdk_nvmf_listener {
 	struct spdk_nvme_transport_id	trid;
 	struct spdk_nvmf_transport	*transport;
+	/* ANA state of each ANA group, indexed by anagrpid - 1 */
+	enum spdk_nvme_ana_state	*ana_state;
+	uint32_t			num_ana_groups;
+	uint64_t			ana_state_change_count;
 	TAILQ_ENTRY(spdk_nvmf_listener)	link;
 };
 
@@ -109,13 +136,38 @@ struct spdk_nvmf_transport_pg_cache_buf {
 	STAILQ_ENTRY(spdk_nvmf_transport_pg_cache_buf) link;
 };
 
+struct spdk_nvmf_transport_pg_buf_stat {
+	/* Buffers taken from the pool because the cache was empty */
+	uint64_t	buf_cache_misses;
+	/* Buffer requests that couldn't be satisfied and had to wait */
+	uint64_t	buf_waits;
+	/* Number of times the pool was found exhausted */
+	uint64_t	buf_pool_exhausted;
+};
+
 struct spdk_nvmf_transport_poll_group {
 	struct spdk_nvmf_transport					*transport;
 	/* Requests that are waiting to obtain a data buffer */
 	STAILQ_HEAD(, spdk_nvmf_request)				pending_buf_queue;
+	/* Data buffer pool local to the NUMA socket of this poll group */
+	struct spdk_mempool						*data_buf_pool;
+	int32_t								data_buf_socket_id;
 	STAILQ_HEAD(, spdk_nvmf_transport_pg_cache_buf)			buf_cache;
 	uint32_t							buf_cache_count;
+	/* Current size of the cache, adjusted to demand up to buf_cache_max */
 	uint32_t							buf_cache_size;
+	uint32_t							buf_cache_max;
+	/*
+	 * Buffer requests, most buffers a single request had to take from the pool and
+	 * lowest cache fill since the last adjustment of the cache size
+	 */
+	uint32_t							buf_cache_gets;
+	uint32_t							buf_cache_shortfall;
+	uint32_t							buf_cache_low;
+	/* Adjusts the cache of groups that don't get enough buffer requests to do it themselves */
+	struct spdk_poller						*buf_cache_poller;
+	bool								buf_pool_exhausted;
+	struct spdk_nvmf_transport_pg_buf_stat				buf_stat;
 	struct spdk_nvmf_poll_group					*group;
 	TAILQ_ENTRY(spdk_nvmf_transport_poll_group)			link;
 };
@@ -149,6 +201,13 @@ struct spdk_nvmf_subsystem_pg_ns_info {
 	struct spdk_uuid		holder_id;
 	/* Host ID for the registrants with the namespace */
 	struct spdk_uuid		reg_hostid[SPDK_NVMF_MAX_NUM_REGISTRANTS];
+	/* I/O submitted to the namespace channel and not yet completed */
+	uint64_t			io_outstanding;
+	/* Set while a hot removal waits for io_outstanding to drain */
+	void				(*remove_cb_fn)(void *cb_arg, int status);
+	void				*remove_cb_arg;
+	/* I/O scheduler of the namespace, NULL if it is not enabled */
+	struct spdk_nvmf_ns_sched	*sched;
 };
 
 typedef void(*spdk_nvmf_poll_group_mod_done)(void *cb_arg, int status);
@@ -205,6 +264,14 @@ union nvmf_c2h_msg {
 };
 SPDK_STATIC_ASSERT(sizeof(union nvmf_c2h_msg) == 16, "Incorrect size");
 
+struct spdk_nvmf_request;
+struct spdk_nvmf_ns_sched;
+struct spdk_nvmf_ns_sched_flow;
+struct spdk_nvmf_ns_cache;
+struct spdk_nvmf_ns_cache_hold;
+
+typedef void (*spdk_nvmf_request_zcopy_cb)(struct spdk_nvmf_request *req, int status);
+
 struct spdk_nvmf_request {
 	struct spdk_nvmf_qpair		*qpair;
 	uint32_t			length;
@@ -216,9 +283,26 @@ struct spdk_nvmf_request {
 	struct iovec			iov[NVMF_REQ_MAX_BUFFERS];
 	uint32_t			iovcnt;
 	bool				data_from_pool;
+	/* Counted in the io_outstanding of the namespace it targets */
+	bool				ns_io_tracked;
+	/* Bdev buffers the data was placed into, see spdk_nvmf_request_zcopy_start() */
+	struct spdk_bdev_io		*zcopy_bdev_io;
+	spdk_nvmf_request_zcopy_cb	zcopy_cb_fn;
 	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+	/* Host queue of the namespace I/O scheduler the request went through */
+	struct spdk_nvmf_ns_sched_flow	*sched_flow;
+	uint64_t			sched_tsc;
+	/*
+	 * Set by transports that send read data from iov only once the request
+	 * completes and call spdk_nvmf_ns_cache_request_release() when done with
+	 * it. Read cache hits are then served straight from the cache buffers.
+	 */
+	bool				cache_zcopy;
+	/* Read cache lines iov points into, see cache_zcopy */
+	struct spdk_nvmf_ns_cache_hold	*cache_hold;
 
 	STAILQ_ENTRY(spdk_nvmf_request)	buf_link;
+	STAILQ_ENTRY(spdk_nvmf_request)	sched_link;
 	TAILQ_ENTRY(spdk_nvmf_request)	link;
 };
 
@@ -229,6 +313,19 @@ struct spdk_nvmf_registrant {
 	uint64_t rkey;
 };
 
+struct spdk_nvmf_ns_sched_host {
+	char					hostnqn[SPDK_NVMF_NQN_MAX_LEN + 1];
+	struct spdk_nvmf_ns_sched_host_opts	opts;
+};
+
+struct spdk_nvmf_ns_sched_conf {
+	struct spdk_nvmf_ns_sched_opts		opts;
+	/* Number of poll groups the host rate limits are split across */
+	uint32_t				num_poll_groups;
+	struct spdk_nvmf_ns_sched_host		*hosts;
+	uint32_t				num_hosts;
+};
+
 struct spdk_nvmf_ns {
 	uint32_t nsid;
 	struct spdk_nvmf_subsystem *subsystem;
@@ -251,6 +348,13 @@ struct spdk_nvmf_ns {
 	char *ptpl_file;
 	/* Persist Through Power Loss feature is enabled */
 	bool ptpl_activated;
+	/* I/O scheduler configuration, applied to the poll groups on resume */
+	struct spdk_nvmf_ns_sched_conf sched_conf;
+	/* Read cache shared by all poll groups, NULL if it is not enabled */
+	struct spdk_nvmf_ns_cache *cache;
+	struct spdk_nvmf_ns_cache_opts cache_opts;
+	/* Link in the subsystem's list of namespaces being hot removed */
+	TAILQ_ENTRY(spdk_nvmf_ns) link;
 };
 
 struct spdk_nvmf_qpair {
@@ -309,11 +413,14 @@ struct spdk_nvmf_ctrlr {
 	struct spdk_nvmf_ctrlr_feat feat;
 
 	struct spdk_nvmf_qpair	*admin_qpair;
+	/* Listener the admin queue connected through, NULL if it was removed */
+	struct spdk_nvmf_listener *listener;
 	struct spdk_thread	*thread;
 	struct spdk_bit_array	*qpair_mask;
 
 	struct spdk_nvmf_request *aer_req;
-	union spdk_nvme_async_event_completion notice_event;
+	/* Notices waiting for an AER, one bit per enum spdk_nvme_async_event_info_notice */
+	uint32_t pending_notices;
 	union spdk_nvme_async_event_completion reservation_event;
 	struct spdk_uuid  hostid;
 
@@ -332,6 +439,12 @@ struct spdk_nvmf_ctrlr {
 	TAILQ_ENTRY(spdk_nvmf_ctrlr)	link;
 };
 
+struct spdk_nvmf_ctrlr_slot {
+	struct spdk_nvmf_ctrlr		*ctrlr;
+	/* Thread the controller lives on. Stays valid after the controller is freed. */
+	struct spdk_thread		*thread;
+};
+
 struct spdk_nvmf_subsystem {
 	struct spdk_thread		*thread;
 	uint32_t			id;
@@ -353,13 +466,25 @@ struct spdk_nvmf_subsystem {
 	/* This is the maximum allowed nsid to a subsystem */
 	uint32_t				max_allowed_nsid;
 
+	/* Namespaces unpublished from ns but still being detached from poll groups */
+	TAILQ_HEAD(, spdk_nvmf_ns)		removing_ns;
+
 	TAILQ_HEAD(, spdk_nvmf_ctrlr)		ctrlrs;
+	/*
+	 * The controllers above, indexed by cntlid. Slots are only written on the
+	 * subsystem thread but may be read from any poll group thread, which lets
+	 * I/O queue connects find their controller without a trip through here.
+	 */
+	struct spdk_nvmf_ctrlr_slot		*ctrlr_slots[SPDK_NVMF_CNTLID_NUM_PAGES];
 
 	TAILQ_HEAD(, spdk_nvmf_host)		hosts;
+	/* The hosts above, hashed by NQN for the access checks on connect */
+	LIST_HEAD(, spdk_nvmf_host)		host_hash[SPDK_NVMF_HOST_HASH_BUCKETS];
 
 	TAILQ_HEAD(, spdk_nvmf_listener)	listeners;
 
 	TAILQ_ENTRY(spdk_nvmf_subsystem)	entries;
+	LIST_ENTRY(spdk_nvmf_subsystem)		hash_link;
 };
 
 
@@ -379,6 +504,11 @@ void spdk_nvmf_poll_group_pause_subsystem(struct spdk_nvmf_poll_group *group,
 		struct spdk_nvmf_subsystem *subsystem, spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
 void spdk_nvmf_poll_group_resume_subsystem(struct spdk_nvmf_poll_group *group,
 		struct spdk_nvmf_subsystem *subsystem, spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
+void spdk_nvmf_poll_group_remove_ns(struct spdk_nvmf_poll_group *group,
+				    struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				    spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg);
+void spdk_nvmf_poll_group_remove_ns_done(struct spdk_nvmf_poll_group *group,
+		struct spdk_nvmf_subsystem *subsystem, uint32_t nsid);
 void spdk_nvmf_request_exec(struct spdk_nvmf_request *req);
 int spdk_nvmf_request_free(struct spdk_nvmf_request *req);
 int spdk_nvmf_request_complete(struct spdk_nvmf_request *req);
@@ -394,9 +524,83 @@ int spdk_nvmf_request_get_buffers(struct spdk_nvmf_request *req,
 
 bool spdk_nvmf_request_get_dif_ctx(struct spdk_nvmf_request *req, struct spdk_dif_ctx *dif_ctx);
 
+/*
+ * Ask the bdev targeted by a write command for the buffers its data should be
+ * received into. Returns 0 if cb_fn will be called once req->iov describes
+ * them, or a negative errno if the request can't use zero copy, in which case
+ * the transport provides the buffers itself.
+ */
+int spdk_nvmf_request_zcopy_start(struct spdk_nvmf_request *req,
+				  spdk_nvmf_request_zcopy_cb cb_fn);
+void spdk_nvmf_request_zcopy_start_done(struct spdk_nvmf_request *req, int status);
+/* Drop the zero copy buffers of a request that will not be executed. */
+void spdk_nvmf_request_zcopy_release(struct spdk_nvmf_request *req);
+/* Execute an I/O command the namespace scheduler held back. */
+void spdk_nvmf_request_exec_scheduled(struct spdk_nvmf_request *req);
+
+struct spdk_nvmf_ns_sched *spdk_nvmf_ns_sched_create(const struct spdk_nvmf_ns_sched_conf *conf);
+int spdk_nvmf_ns_sched_update(struct spdk_nvmf_ns_sched *sched,
+			      const struct spdk_nvmf_ns_sched_conf *conf);
+void spdk_nvmf_ns_sched_destroy(struct spdk_nvmf_ns_sched *sched);
+/*
+ * Pass an I/O command through the namespace scheduler. Returns true if it may
+ * be executed right away, otherwise the scheduler executes it later through
+ * spdk_nvmf_request_exec_scheduled().
+ */
+bool spdk_nvmf_ns_sched_submit(struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_request *req);
+void spdk_nvmf_ns_sched_request_done(struct spdk_nvmf_ns_sched *sched,
+				     struct spdk_nvmf_request *req);
+/* Add the per host statistics of the scheduler to the array, merging entries by host NQN. */
+int spdk_nvmf_ns_sched_get_stats(struct spdk_nvmf_ns_sched *sched,
+				 struct spdk_nvmf_ns_sched_host_stat **stats, uint32_t *num_stats);
+
+struct spdk_nvmf_ns_cache *spdk_nvmf_ns_cache_create(const struct spdk_nvmf_ns_cache_opts *opts,
+		uint32_t block_size);
+/* Cached data still in use by requests is freed once they release it. */
+void spdk_nvmf_ns_cache_destroy(struct spdk_nvmf_ns_cache *cache);
+uint32_t spdk_nvmf_ns_cache_get_line_blocks(const struct spdk_nvmf_ns_cache *cache);
+/*
+ * Pin the lines covering the blocks of a read. Returns NULL if the read should
+ * bypass the cache. Lines that were not cached yet come with a fill context and
+ * must be read from the bdev and reported with spdk_nvmf_ns_cache_fill_done()
+ * before the data is used.
+ */
+struct spdk_nvmf_ns_cache_hold *spdk_nvmf_ns_cache_hold_get(struct spdk_nvmf_ns_cache *cache,
+		uint64_t start_lba, uint64_t num_blocks, void *ctx);
+void spdk_nvmf_ns_cache_hold_put(struct spdk_nvmf_ns_cache_hold *hold);
+void *spdk_nvmf_ns_cache_hold_get_ctx(const struct spdk_nvmf_ns_cache_hold *hold);
+uint32_t spdk_nvmf_ns_cache_hold_get_num_lines(const struct spdk_nvmf_ns_cache_hold *hold);
+/* Returns the line buffer, and the fill context if it still has to be filled. */
+void *spdk_nvmf_ns_cache_hold_get_line(struct spdk_nvmf_ns_cache_hold *hold, uint32_t idx,
+				       uint64_t *lba, void **fill_ctx);
+/* Returns true once all lines of the hold are filled or failed. */
+bool spdk_nvmf_ns_cache_fill_done(void *fill_ctx, bool success,
+				  struct spdk_nvmf_ns_cache_hold **hold);
+bool spdk_nvmf_ns_cache_hold_is_valid(const struct spdk_nvmf_ns_cache_hold *hold);
+/* Drop the cached data of a block range, or of the whole namespace. */
+void spdk_nvmf_ns_cache_invalidate(struct spdk_nvmf_ns_cache *cache, uint64_t start_lba,
+				   uint64_t num_blocks);
+void spdk_nvmf_ns_cache_purge(struct spdk_nvmf_ns_cache *cache);
+/* Drop the data a write-like command is about to change, before and after it runs. */
+void spdk_nvmf_ns_cache_invalidate_cmd(struct spdk_nvmf_ns_cache *cache,
+				       struct spdk_nvmf_request *req);
+/*
+ * Return the data of a read whose lines are all filled. Zero-copy requests
+ * keep the hold until spdk_nvmf_ns_cache_request_release(), for the others
+ * the data is copied and the hold released.
+ */
+void spdk_nvmf_ns_cache_request_serve(struct spdk_nvmf_request *req,
+				      struct spdk_nvmf_ns_cache_hold *hold,
+				      uint64_t start_lba, uint64_t num_blocks);
+void spdk_nvmf_ns_cache_request_release(struct spdk_nvmf_request *req);
+void spdk_nvmf_ns_cache_get_stats(struct spdk_nvmf_ns_cache *cache,
+				  struct spdk_nvmf_ns_cache_stats *stats);
+
 void spdk_nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn,
 				      struct iovec *iov,
 				      uint32_t iovcnt, uint64_t offset, uint32_t length);
+void spdk_nvmf_update_discovery_log(struct spdk_nvmf_tgt *tgt);
+void spdk_nvmf_discovery_cache_free(struct spdk_nvmf_tgt *tgt);
 
 void spdk_nvmf_ctrlr_destruct(struct spdk_nvmf_ctrlr *ctrlr);
 int spdk_nvmf_ctrlr_process_fabrics_cmd(struct spdk_nvmf_request *req);
@@ -410,6 +614,9 @@ void spdk_nvmf_bdev_ctrlr_identify_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_
 				      bool dif_insert_or_strip);
 int spdk_nvmf_bdev_ctrlr_read_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 				  struct spdk_io_channel *ch, struct spdk_nvmf_request *req);
+int spdk_nvmf_bdev_ctrlr_cache_read_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, struct spdk_nvmf_ns_cache *cache,
+		struct spdk_nvmf_request *req);
 int spdk_nvmf_bdev_ctrlr_write_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 				   struct spdk_io_channel *ch, struct spdk_nvmf_request *req);
 int spdk_nvmf_bdev_ctrlr_write_zeroes_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
@@ -420,6 +627,9 @@ int spdk_nvmf_bdev_ctrlr_dsm_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *
 				 struct spdk_io_channel *ch, struct spdk_nvmf_request *req);
 int spdk_nvmf_bdev_ctrlr_nvme_passthru_io(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 		struct spdk_io_channel *ch, struct spdk_nvmf_request *req);
+int spdk_nvmf_bdev_ctrlr_zcopy_start(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+				     struct spdk_io_channel *ch, struct spdk_nvmf_request *req);
+void spdk_nvmf_bdev_ctrlr_zcopy_release(struct spdk_nvmf_request *req);
 bool spdk_nvmf_bdev_ctrlr_get_dif_ctx(struct spdk_bdev *bdev, struct spdk_nvme_cmd *cmd,
 				      struct spdk_dif_ctx *dif_ctx);
 
@@ -429,7 +639,18 @@ void spdk_nvmf_subsystem_remove_ctrlr(struct spdk_nvmf_subsystem *subsystem,
 				      struct spdk_nvmf_ctrlr *ctrlr);
 struct spdk_nvmf_ctrlr *spdk_nvmf_subsystem_get_ctrlr(struct spdk_nvmf_subsystem *subsystem,
 		uint16_t cntlid);
+/*
+ * Look up a controller by cntlid from any thread. The controller may only be
+ * dereferenced on the returned thread, and only after checking with
+ * spdk_nvmf_subsystem_get_ctrlr() there that it is still the one published.
+ */
+struct spdk_nvmf_ctrlr *spdk_nvmf_subsystem_lookup_ctrlr(struct spdk_nvmf_subsystem *subsystem,
+		uint16_t cntlid, struct spdk_thread **thread);
+struct spdk_nvmf_listener *spdk_nvmf_subsystem_find_listener(
+	struct spdk_nvmf_subsystem *subsystem,
+	const struct spdk_nvme_transport_id *trid);
 int spdk_nvmf_ctrlr_async_event_ns_notice(struct spdk_nvmf_ctrlr *ctrlr);
+int spdk_nvmf_ctrlr_async_event_ana_change_notice(struct spdk_nvmf_ctrlr *ctrlr);
 void spdk_nvmf_ctrlr_async_event_reservation_notification(struct spdk_nvmf_ctrlr *ctrlr);
 void spdk_nvmf_ns_reservation_request(void *ctx);
 void spdk_nvmf_ctrlr_reservation_notice_log(struct spdk_nvmf_ctrlr *ctrlr,
@@ -451,6 +672,20 @@ void spdk_nvmf_ctrlr_abort_aer(struct spdk_nvmf_ctrlr *ctrlr);
  */
 void spdk_nvmf_qpair_free_aer(struct spdk_nvmf_qpair *qpair);
 
+/* FNV-1a hash of an NQN */
+static inline uint32_t
+_spdk_nvmf_nqn_hash(const char *nqn)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*nqn != '\0') {
+		hash ^= (uint8_t)*nqn++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
 static inline struct spdk_nvmf_ns *
 _spdk_nvmf_subsystem_get_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
 {
@@ -462,6 +697,19 @@ _spdk_nvmf_subsystem_get_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid
 	return subsystem->ns[nsid - 1];
 }
 
+static inline enum spdk_nvme_ana_state
+_spdk_nvmf_ctrlr_get_ana_state(struct spdk_nvmf_ctrlr *ctrlr, uint32_t anagrpid)
+{
+	struct spdk_nvmf_listener *listener = ctrlr->listener;
+
+	/* Controllers whose listener went away keep the pre-ANA behavior. */
+	if (listener == NULL || anagrpid - 1 >= listener->num_ana_groups) {
+		return SPDK_NVME_ANA_OPTIMIZED_STATE;
+	}
+
+	return listener->ana_state[anagrpid - 1];
+}
+
 static inline bool
 spdk_nvmf_qpair_is_admin_queue(struct spdk_nvmf_qpair *qpair)
 {
@@ -291,6 +291,8 @@ dump_nvmf_subsystem(struct spdk_json_write_ctx *w, struct spdk_nvmf_subsystem *s
 				spdk_json_write_named_string(w, "uuid", uuid_str);
 			}
 
+			spdk_json_write_named_uint32(w, "anagrpid", ns_opts.anagrpid);
+
 			spdk_json_write_object_end(w);
 		}
 		spdk_json_write_array_end(w);
@@ -846,6 +848,138 @@ spdk_rpc_nvmf_subsystem_remove_listener(struct spdk_jsonrpc_request *request,
 SPDK_RPC_REGISTER("nvmf_subsystem_remove_listener", spdk_rpc_nvmf_subsystem_remove_listener,
 		  SPDK_RPC_RUNTIME);
 
+struct nvmf_rpc_ana_state_ctx {
+	char				*nqn;
+	char				*tgt_name;
+	struct rpc_listen_address	address;
+	char				*ana_state_str;
+	uint32_t			anagrpid;
+
+	enum spdk_nvme_ana_state	ana_state;
+	struct spdk_jsonrpc_request	*request;
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_set_ana_state_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_ana_state_ctx, nqn), spdk_json_decode_string},
+	{"listen_address", offsetof(struct nvmf_rpc_ana_state_ctx, address), decode_rpc_listen_address},
+	{"ana_state", offsetof(struct nvmf_rpc_ana_state_ctx, ana_state_str), spdk_json_decode_string},
+	{"anagrpid", offsetof(struct nvmf_rpc_ana_state_ctx, anagrpid), spdk_json_decode_uint32, true},
+	{"tgt_name", offsetof(struct nvmf_rpc_ana_state_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+nvmf_rpc_ana_state_ctx_free(struct nvmf_rpc_ana_state_ctx *ctx)
+{
+	free(ctx->nqn);
+	free(ctx->tgt_name);
+	free_rpc_listen_address(&ctx->address);
+	free(ctx->ana_state_str);
+	free(ctx);
+}
+
+static int
+rpc_ana_state_parse(const char *str, enum spdk_nvme_ana_state *ana_state)
+{
+	if (strcasecmp(str, "optimized") == 0) {
+		*ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	} else if (strcasecmp(str, "non_optimized") == 0) {
+		*ana_state = SPDK_NVME_ANA_NON_OPTIMIZED_STATE;
+	} else if (strcasecmp(str, "inaccessible") == 0) {
+		*ana_state = SPDK_NVME_ANA_INACCESSIBLE_STATE;
+	} else if (strcasecmp(str, "persistent_loss") == 0) {
+		*ana_state = SPDK_NVME_ANA_PERSISTENT_LOSS_STATE;
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+nvmf_rpc_ana_state_done(struct spdk_nvmf_subsystem *subsystem,
+			void *cb_arg, int status)
+{
+	struct nvmf_rpc_ana_state_ctx *ctx = cb_arg;
+	struct spdk_jsonrpc_request *request = ctx->request;
+	struct spdk_json_write_ctx *w;
+
+	nvmf_rpc_ana_state_ctx_free(ctx);
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_bool(w, true);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+spdk_rpc_nvmf_subsystem_listener_set_ana_state(struct spdk_jsonrpc_request *request,
+		const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_ana_state_ctx *ctx;
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+	struct spdk_nvme_transport_id trid;
+	int rc;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Out of memory");
+		return;
+	}
+
+	ctx->request = request;
+
+	if (spdk_json_decode_object(params, nvmf_rpc_set_ana_state_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_set_ana_state_decoder),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ana_state_ctx_free(ctx);
+		return;
+	}
+
+	if (rpc_ana_state_parse(ctx->ana_state_str, &ctx->ana_state)) {
+		SPDK_ERRLOG("Invalid ANA state: %s\n", ctx->ana_state_str);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ana_state_ctx_free(ctx);
+		return;
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		nvmf_rpc_ana_state_ctx_free(ctx);
+		return;
+	}
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx->nqn);
+	if (!subsystem) {
+		SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", ctx->nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ana_state_ctx_free(ctx);
+		return;
+	}
+
+	if (rpc_listen_address_to_trid(&ctx->address, &trid)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ana_state_ctx_free(ctx);
+		return;
+	}
+
+	/* ANA states change while I/O is running, so the subsystem is not paused. */
+	rc = spdk_nvmf_subsystem_set_ana_state(subsystem, &trid, ctx->ana_state, ctx->anagrpid,
+					       nvmf_rpc_ana_state_done, ctx);
+	if (rc) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(-rc));
+		nvmf_rpc_ana_state_ctx_free(ctx);
+		return;
+	}
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_listener_set_ana_state",
+		  spdk_rpc_nvmf_subsystem_listener_set_ana_state, SPDK_RPC_RUNTIME);
+
 struct spdk_nvmf_ns_params {
 	char *bdev_name;
 	char *ptpl_file;
@@ -853,6 +987,7 @@ struct spdk_nvmf_ns_params {
 	char nguid[16];
 	char eui64[8];
 	struct spdk_uuid uuid;
+	uint32_t anagrpid;
 };
 
 struct rpc_namespaces {
@@ -868,6 +1003,7 @@ static const struct spdk_json_object_decoder rpc_ns_params_decoders[] = {
 	{"nguid", offsetof(struct spdk_nvmf_ns_params, nguid), decode_ns_nguid, true},
 	{"eui64", offsetof(struct spdk_nvmf_ns_params, eui64), decode_ns_eui64, true},
 	{"uuid", offsetof(struct spdk_nvmf_ns_params, uuid), decode_ns_uuid, true},
+	{"anagrpid", offsetof(struct spdk_nvmf_ns_params, anagrpid), spdk_json_decode_uint32, true},
 };
 
 static int
@@ -886,7 +1022,6 @@ struct nvmf_rpc_ns_ctx {
 	struct spdk_nvmf_ns_params ns_params;
 
 	struct spdk_jsonrpc_request *request;
-	bool response_sent;
 };
 
 static const struct spdk_json_object_decoder nvmf_rpc_subsystem_ns_decoder[] = {
@@ -906,18 +1041,19 @@ nvmf_rpc_ns_ctx_free(struct nvmf_rpc_ns_ctx *ctx)
 }
 
 static void
-nvmf_rpc_ns_resumed(struct spdk_nvmf_subsystem *subsystem,
-		    void *cb_arg, int status)
+nvmf_rpc_ns_added(struct spdk_nvmf_subsystem *subsystem,
+		  void *cb_arg, int status)
 {
 	struct nvmf_rpc_ns_ctx *ctx = cb_arg;
 	struct spdk_jsonrpc_request *request = ctx->request;
 	uint32_t nsid = ctx->ns_params.nsid;
-	bool response_sent = ctx->response_sent;
 	struct spdk_json_write_ctx *w;
 
 	nvmf_rpc_ns_ctx_free(ctx);
 
-	if (response_sent) {
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to attach namespace");
 		return;
 	}
 
@@ -926,54 +1062,6 @@ nvmf_rpc_ns_resumed(struct spdk_nvmf_subsystem *subsystem,
 	spdk_jsonrpc_end_result(request, w);
 }
 
-static void
-nvmf_rpc_ns_paused(struct spdk_nvmf_subsystem *subsystem,
-		   void *cb_arg, int status)
-{
-	struct nvmf_rpc_ns_ctx *ctx = cb_arg;
-	struct spdk_nvmf_ns_opts ns_opts;
-	struct spdk_bdev *bdev;
-
-	bdev = spdk_bdev_get_by_name(ctx->ns_params.bdev_name);
-	if (!bdev) {
-		SPDK_ERRLOG("No bdev with name %s\n", ctx->ns_params.bdev_name);
-		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
-						 "Invalid parameters");
-		ctx->response_sent = true;
-		goto resume;
-	}
-
-	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
-	ns_opts.nsid = ctx->ns_params.nsid;
-
-	SPDK_STATIC_ASSERT(sizeof(ns_opts.nguid) == sizeof(ctx->ns_params.nguid), "size mismatch");
-	memcpy(ns_opts.nguid, ctx->ns_params.nguid, sizeof(ns_opts.nguid));
-
-	SPDK_STATIC_ASSERT(sizeof(ns_opts.eui64) == sizeof(ctx->ns_params.eui64), "size mismatch");
-	memcpy(ns_opts.eui64, ctx->ns_params.eui64, sizeof(ns_opts.eui64));
-
-	if (!spdk_mem_all_zero(&ctx->ns_params.uuid, sizeof(ctx->ns_params.uuid))) {
-		ns_opts.uuid = ctx->ns_params.uuid;
-	}
-
-	ctx->ns_params.nsid = spdk_nvmf_subsystem_add_ns(subsystem, bdev, &ns_opts, sizeof(ns_opts),
-			      ctx->ns_params.ptpl_file);
-	if (ctx->ns_params.nsid == 0) {
-		SPDK_ERRLOG("Unable to add namespace\n");
-		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
-						 "Invalid parameters");
-		ctx->response_sent = true;
-		goto resume;
-	}
-
-resume:
-	if (spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_ns_resumed, ctx)) {
-		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
-		nvmf_rpc_ns_ctx_free(ctx);
-		return;
-	}
-}
-
 static void
 spdk_rpc_nvmf_subsystem_add_ns(struct spdk_jsonrpc_request *request,
 			       const struct spdk_json_val *params)
@@ -981,6 +1069,8 @@ spdk_rpc_nvmf_subsystem_add_ns(struct spdk_jsonrpc_request *request,
 	struct nvmf_rpc_ns_ctx *ctx;
 	struct spdk_nvmf_subsystem *subsystem;
 	struct spdk_nvmf_tgt *tgt;
+	struct spdk_nvmf_ns_opts ns_opts;
+	struct spdk_bdev *bdev;
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (!ctx) {
@@ -998,7 +1088,6 @@ spdk_rpc_nvmf_subsystem_add_ns(struct spdk_jsonrpc_request *request,
 	}
 
 	ctx->request = request;
-	ctx->response_sent = false;
 
 	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
 	if (!tgt) {
@@ -1017,8 +1106,35 @@ spdk_rpc_nvmf_subsystem_add_ns(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
-	if (spdk_nvmf_subsystem_pause(subsystem, nvmf_rpc_ns_paused, ctx)) {
-		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
+	bdev = spdk_bdev_get_by_name(ctx->ns_params.bdev_name);
+	if (!bdev) {
+		SPDK_ERRLOG("No bdev with name %s\n", ctx->ns_params.bdev_name);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_ctx_free(ctx);
+		return;
+	}
+
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	ns_opts.nsid = ctx->ns_params.nsid;
+
+	SPDK_STATIC_ASSERT(sizeof(ns_opts.nguid) == sizeof(ctx->ns_params.nguid), "size mismatch");
+	memcpy(ns_opts.nguid, ctx->ns_params.nguid, sizeof(ns_opts.nguid));
+
+	SPDK_STATIC_ASSERT(sizeof(ns_opts.eui64) == sizeof(ctx->ns_params.eui64), "size mismatch");
+	memcpy(ns_opts.eui64, ctx->ns_params.eui64, sizeof(ns_opts.eui64));
+
+	if (!spdk_mem_all_zero(&ctx->ns_params.uuid, sizeof(ctx->ns_params.uuid))) {
+		ns_opts.uuid = ctx->ns_params.uuid;
+	}
+
+	ns_opts.anagrpid = ctx->ns_params.anagrpid;
+
+	/* The other namespaces of the subsystem keep serving I/O while this one is attached. */
+	ctx->ns_params.nsid = spdk_nvmf_subsystem_hot_add_ns(subsystem, bdev, &ns_opts, sizeof(ns_opts),
+			      ctx->ns_params.ptpl_file, nvmf_rpc_ns_added, ctx);
+	if (ctx->ns_params.nsid == 0) {
+		SPDK_ERRLOG("Unable to add namespace\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
 		nvmf_rpc_ns_ctx_free(ctx);
 		return;
 	}
@@ -1031,7 +1147,6 @@ struct nvmf_rpc_remove_ns_ctx {
 	uint32_t nsid;
 
 	struct spdk_jsonrpc_request *request;
-	bool response_sent;
 };
 
 static const struct spdk_json_object_decoder nvmf_rpc_subsystem_remove_ns_decoder[] = {
@@ -1049,49 +1164,20 @@ nvmf_rpc_remove_ns_ctx_free(struct nvmf_rpc_remove_ns_ctx *ctx)
 }
 
 static void
-nvmf_rpc_remove_ns_resumed(struct spdk_nvmf_subsystem *subsystem,
-			   void *cb_arg, int status)
+nvmf_rpc_remove_ns_done(struct spdk_nvmf_subsystem *subsystem,
+			void *cb_arg, int status)
 {
 	struct nvmf_rpc_remove_ns_ctx *ctx = cb_arg;
 	struct spdk_jsonrpc_request *request = ctx->request;
-	bool response_sent = ctx->response_sent;
 	struct spdk_json_write_ctx *w;
 
 	nvmf_rpc_remove_ns_ctx_free(ctx);
 
-	if (response_sent) {
-		return;
-	}
-
 	w = spdk_jsonrpc_begin_result(request);
 	spdk_json_write_bool(w, true);
 	spdk_jsonrpc_end_result(request, w);
 }
 
-static void
-nvmf_rpc_remove_ns_paused(struct spdk_nvmf_subsystem *subsystem,
-			  void *cb_arg, int status)
-{
-	struct nvmf_rpc_remove_ns_ctx *ctx = cb_arg;
-	int ret;
-
-	ret = spdk_nvmf_subsystem_remove_ns(subsystem, ctx->nsid);
-	if (ret < 0) {
-		SPDK_ERRLOG("Unable to remove namespace ID %u\n", ctx->nsid);
-		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
-						 "Invalid parameters");
-		ctx->response_sent = true;
-	}
-
-	if (spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_remove_ns_resumed, ctx)) {
-		if (!ctx->response_sent) {
-			spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
-		}
-		nvmf_rpc_remove_ns_ctx_free(ctx);
-		return;
-	}
-}
-
 static void
 spdk_rpc_nvmf_subsystem_remove_ns(struct spdk_jsonrpc_request *request,
 				  const struct spdk_json_val *params)
@@ -1099,6 +1185,7 @@ spdk_rpc_nvmf_subsystem_remove_ns(struct spdk_jsonrpc_request *request,
 	struct nvmf_rpc_remove_ns_ctx *ctx;
 	struct spdk_nvmf_subsystem *subsystem;
 	struct spdk_nvmf_tgt *tgt;
+	int rc;
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (!ctx) {
@@ -1125,7 +1212,6 @@ spdk_rpc_nvmf_subsystem_remove_ns(struct spdk_jsonrpc_request *request,
 	}
 
 	ctx->request = request;
-	ctx->response_sent = false;
 
 	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx->nqn);
 	if (!subsystem) {
@@ -1135,8 +1221,10 @@ spdk_rpc_nvmf_subsystem_remove_ns(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
-	if (spdk_nvmf_subsystem_pause(subsystem, nvmf_rpc_remove_ns_paused, ctx)) {
-		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
+	rc = spdk_nvmf_subsystem_hot_remove_ns(subsystem, ctx->nsid, nvmf_rpc_remove_ns_done, ctx);
+	if (rc < 0) {
+		SPDK_ERRLOG("Unable to remove namespace ID %u\n", ctx->nsid);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
 		nvmf_rpc_remove_ns_ctx_free(ctx);
 		return;
 	}
@@ -1397,65 +1485,594 @@ spdk_rpc_nvmf_subsystem_allow_any_host(struct spdk_jsonrpc_request *request,
 SPDK_RPC_REGISTER("nvmf_subsystem_allow_any_host", spdk_rpc_nvmf_subsystem_allow_any_host,
 		  SPDK_RPC_RUNTIME)
 
-struct nvmf_rpc_create_transport_ctx {
-	char				*trtype;
-	char				*tgt_name;
-	struct spdk_nvmf_transport_opts	opts;
-	struct spdk_jsonrpc_request	*request;
+enum nvmf_rpc_ns_sched_op {
+	NVMF_RPC_NS_SCHED_SET,
+	NVMF_RPC_NS_SCHED_SET_HOST,
 };
 
-static const struct spdk_json_object_decoder nvmf_rpc_create_transport_decoder[] = {
-	{	"trtype", offsetof(struct nvmf_rpc_create_transport_ctx, trtype), spdk_json_decode_string},
-	{
-		"max_queue_depth", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_queue_depth),
-		spdk_json_decode_uint16, true
-	},
-	{
-		"max_qpairs_per_ctrlr", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_qpairs_per_ctrlr),
-		spdk_json_decode_uint16, true
-	},
-	{
-		"in_capsule_data_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.in_capsule_data_size),
-		spdk_json_decode_uint32, true
-	},
-	{
-		"max_io_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_io_size),
-		spdk_json_decode_uint32, true
-	},
-	{
-		"io_unit_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.io_unit_size),
-		spdk_json_decode_uint32, true
-	},
-	{
-		"max_aq_depth", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_aq_depth),
-		spdk_json_decode_uint32, true
-	},
-	{
-		"num_shared_buffers", offsetof(struct nvmf_rpc_create_transport_ctx, opts.num_shared_buffers),
-		spdk_json_decode_uint32, true
-	},
-	{
-		"buf_cache_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.buf_cache_size),
-		spdk_json_decode_uint32, true
-	},
-	{
-		"max_srq_depth", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_srq_depth),
-		spdk_json_decode_uint32, true
-	},
-	{
-		"no_srq", offsetof(struct nvmf_rpc_create_transport_ctx, opts.no_srq),
-		spdk_json_decode_bool, true
-	},
-	{
-		"c2h_success", offsetof(struct nvmf_rpc_create_transport_ctx, opts.c2h_success),
-		spdk_json_decode_bool, true
-	},
-	{
-		"dif_insert_or_strip", offsetof(struct nvmf_rpc_create_transport_ctx, opts.dif_insert_or_strip),
-		spdk_json_decode_bool, true
-	},
-	{
-		"sock_priority", offsetof(struct nvmf_rpc_create_transport_ctx, opts.sock_priority),
+struct nvmf_rpc_ns_sched_ctx {
+	struct spdk_jsonrpc_request *request;
+
+	char *nqn;
+	uint32_t nsid;
+	char *host;
+	char *tgt_name;
+
+	enum nvmf_rpc_ns_sched_op op;
+
+	bool enable;
+	uint32_t max_outstanding;
+	struct spdk_nvmf_ns_sched_host_opts host_opts;
+
+	bool response_sent;
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_set_ns_sched_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_ns_sched_ctx, nqn), spdk_json_decode_string},
+	{"nsid", offsetof(struct nvmf_rpc_ns_sched_ctx, nsid), spdk_json_decode_uint32},
+	{"enable", offsetof(struct nvmf_rpc_ns_sched_ctx, enable), spdk_json_decode_bool},
+	{"max_outstanding", offsetof(struct nvmf_rpc_ns_sched_ctx, max_outstanding), spdk_json_decode_uint32, true},
+	{"tgt_name", offsetof(struct nvmf_rpc_ns_sched_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_set_ns_sched_host_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_ns_sched_ctx, nqn), spdk_json_decode_string},
+	{"nsid", offsetof(struct nvmf_rpc_ns_sched_ctx, nsid), spdk_json_decode_uint32},
+	{"host", offsetof(struct nvmf_rpc_ns_sched_ctx, host), spdk_json_decode_string},
+	{"weight", offsetof(struct nvmf_rpc_ns_sched_ctx, host_opts.weight), spdk_json_decode_uint32, true},
+	{"rw_ios_per_sec", offsetof(struct nvmf_rpc_ns_sched_ctx, host_opts.rw_ios_per_sec), spdk_json_decode_uint64, true},
+	{"rw_mbytes_per_sec", offsetof(struct nvmf_rpc_ns_sched_ctx, host_opts.rw_mbytes_per_sec), spdk_json_decode_uint64, true},
+	{"tgt_name", offsetof(struct nvmf_rpc_ns_sched_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+nvmf_rpc_ns_sched_ctx_free(struct nvmf_rpc_ns_sched_ctx *ctx)
+{
+	free(ctx->nqn);
+	free(ctx->host);
+	free(ctx->tgt_name);
+	free(ctx);
+}
+
+static void
+nvmf_rpc_ns_sched_resumed(struct spdk_nvmf_subsystem *subsystem,
+			  void *cb_arg, int status)
+{
+	struct nvmf_rpc_ns_sched_ctx *ctx = cb_arg;
+	struct spdk_jsonrpc_request *request;
+	struct spdk_json_write_ctx *w;
+	bool response_sent = ctx->response_sent;
+
+	request = ctx->request;
+	nvmf_rpc_ns_sched_ctx_free(ctx);
+
+	if (response_sent) {
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_bool(w, true);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+nvmf_rpc_ns_sched_resume(struct spdk_nvmf_subsystem *subsystem,
+			 void *cb_arg, int status)
+{
+	struct nvmf_rpc_ns_sched_ctx *ctx = cb_arg;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(-status));
+		ctx->response_sent = true;
+	}
+
+	/* The poll groups pick up the new configuration while resuming. */
+	if (spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_ns_sched_resumed, ctx)) {
+		if (!ctx->response_sent) {
+			spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
+		}
+		nvmf_rpc_ns_sched_ctx_free(ctx);
+		return;
+	}
+}
+
+static void
+nvmf_rpc_ns_sched_paused(struct spdk_nvmf_subsystem *subsystem,
+			 void *cb_arg, int status)
+{
+	struct nvmf_rpc_ns_sched_ctx *ctx = cb_arg;
+	struct spdk_nvmf_ns_sched_opts opts;
+	int rc = -1;
+
+	switch (ctx->op) {
+	case NVMF_RPC_NS_SCHED_SET:
+		opts.enabled = ctx->enable;
+		opts.max_outstanding = ctx->max_outstanding;
+		rc = spdk_nvmf_subsystem_set_ns_sched(subsystem, ctx->nsid, &opts,
+						      nvmf_rpc_ns_sched_resume, ctx);
+		if (rc == 0) {
+			return;
+		}
+		break;
+	case NVMF_RPC_NS_SCHED_SET_HOST:
+		rc = spdk_nvmf_subsystem_set_ns_sched_host(subsystem, ctx->nsid, ctx->host,
+				&ctx->host_opts);
+		break;
+	}
+
+	nvmf_rpc_ns_sched_resume(subsystem, ctx, rc);
+}
+
+static void
+nvmf_rpc_ns_sched_start(struct spdk_jsonrpc_request *request, struct nvmf_rpc_ns_sched_ctx *ctx)
+{
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+
+	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		nvmf_rpc_ns_sched_ctx_free(ctx);
+		return;
+	}
+
+	ctx->request = request;
+	ctx->response_sent = false;
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx->nqn);
+	if (!subsystem || spdk_nvmf_subsystem_get_ns(subsystem, ctx->nsid) == NULL) {
+		SPDK_ERRLOG("Unable to find namespace %u of subsystem with NQN %s\n", ctx->nsid, ctx->nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_sched_ctx_free(ctx);
+		return;
+	}
+
+	if (spdk_nvmf_subsystem_pause(subsystem, nvmf_rpc_ns_sched_paused, ctx)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
+		nvmf_rpc_ns_sched_ctx_free(ctx);
+		return;
+	}
+}
+
+static void
+spdk_rpc_nvmf_subsystem_set_ns_sched(struct spdk_jsonrpc_request *request,
+				     const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_ns_sched_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Out of memory");
+		return;
+	}
+
+	ctx->op = NVMF_RPC_NS_SCHED_SET;
+	ctx->max_outstanding = SPDK_NVMF_NS_SCHED_DEFAULT_MAX_OUTSTANDING;
+
+	if (spdk_json_decode_object(params, nvmf_rpc_set_ns_sched_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_set_ns_sched_decoder),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_sched_ctx_free(ctx);
+		return;
+	}
+
+	nvmf_rpc_ns_sched_start(request, ctx);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_set_ns_sched", spdk_rpc_nvmf_subsystem_set_ns_sched,
+		  SPDK_RPC_RUNTIME)
+
+static void
+spdk_rpc_nvmf_subsystem_set_ns_sched_host(struct spdk_jsonrpc_request *request,
+		const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_ns_sched_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Out of memory");
+		return;
+	}
+
+	ctx->op = NVMF_RPC_NS_SCHED_SET_HOST;
+
+	if (spdk_json_decode_object(params, nvmf_rpc_set_ns_sched_host_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_set_ns_sched_host_decoder),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_sched_ctx_free(ctx);
+		return;
+	}
+
+	nvmf_rpc_ns_sched_start(request, ctx);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_set_ns_sched_host", spdk_rpc_nvmf_subsystem_set_ns_sched_host,
+		  SPDK_RPC_RUNTIME)
+
+struct nvmf_rpc_ns_sched_stats_ctx {
+	char *nqn;
+	uint32_t nsid;
+	char *tgt_name;
+
+	struct spdk_jsonrpc_request *request;
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_ns_sched_stats_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_ns_sched_stats_ctx, nqn), spdk_json_decode_string},
+	{"nsid", offsetof(struct nvmf_rpc_ns_sched_stats_ctx, nsid), spdk_json_decode_uint32},
+	{"tgt_name", offsetof(struct nvmf_rpc_ns_sched_stats_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+nvmf_rpc_ns_sched_stats_ctx_free(struct nvmf_rpc_ns_sched_stats_ctx *ctx)
+{
+	free(ctx->nqn);
+	free(ctx->tgt_name);
+	free(ctx);
+}
+
+static void
+nvmf_rpc_ns_sched_stats_done(void *cb_arg, int status,
+			     const struct spdk_nvmf_ns_sched_host_stat *stats, uint32_t num_stats)
+{
+	struct nvmf_rpc_ns_sched_stats_ctx *ctx = cb_arg;
+	struct spdk_jsonrpc_request *request = ctx->request;
+	struct spdk_json_write_ctx *w;
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint32_t i;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(-status));
+		nvmf_rpc_ns_sched_stats_ctx_free(ctx);
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint32(w, "nsid", ctx->nsid);
+	spdk_json_write_named_array_begin(w, "hosts");
+	for (i = 0; i < num_stats; i++) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "host", stats[i].hostnqn);
+		spdk_json_write_named_uint64(w, "ios", stats[i].ios);
+		spdk_json_write_named_uint64(w, "queued_ios", stats[i].queued_ios);
+		spdk_json_write_named_uint64(w, "throttled_ios", stats[i].throttled_ios);
+		spdk_json_write_named_uint64(w, "avg_queue_delay_us", stats[i].ios == 0 ? 0 :
+					     stats[i].queue_ticks * SPDK_SEC_TO_USEC / ticks_hz / stats[i].ios);
+		spdk_json_write_named_uint64(w, "max_queue_delay_us",
+					     stats[i].max_queue_ticks * SPDK_SEC_TO_USEC / ticks_hz);
+		spdk_json_write_named_uint32(w, "queue_depth", stats[i].queue_depth);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+
+	nvmf_rpc_ns_sched_stats_ctx_free(ctx);
+}
+
+static void
+spdk_rpc_nvmf_subsystem_get_ns_sched_stats(struct spdk_jsonrpc_request *request,
+		const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_ns_sched_stats_ctx *ctx;
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+	int rc;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Out of memory");
+		return;
+	}
+
+	if (spdk_json_decode_object(params, nvmf_rpc_ns_sched_stats_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_ns_sched_stats_decoder),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_sched_stats_ctx_free(ctx);
+		return;
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		nvmf_rpc_ns_sched_stats_ctx_free(ctx);
+		return;
+	}
+
+	ctx->request = request;
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx->nqn);
+	if (!subsystem) {
+		SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", ctx->nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_sched_stats_ctx_free(ctx);
+		return;
+	}
+
+	rc = spdk_nvmf_subsystem_get_ns_sched_stats(subsystem, ctx->nsid, nvmf_rpc_ns_sched_stats_done, ctx);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(-rc));
+		nvmf_rpc_ns_sched_stats_ctx_free(ctx);
+		return;
+	}
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_get_ns_sched_stats", spdk_rpc_nvmf_subsystem_get_ns_sched_stats,
+		  SPDK_RPC_RUNTIME)
+
+struct nvmf_rpc_ns_cache_ctx {
+	char *nqn;
+	uint32_t nsid;
+	char *tgt_name;
+	struct spdk_nvmf_ns_cache_opts opts;
+
+	struct spdk_jsonrpc_request *request;
+	bool response_sent;
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_set_ns_cache_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_ns_cache_ctx, nqn), spdk_json_decode_string},
+	{"nsid", offsetof(struct nvmf_rpc_ns_cache_ctx, nsid), spdk_json_decode_uint32},
+	{"size_mb", offsetof(struct nvmf_rpc_ns_cache_ctx, opts.size_mb), spdk_json_decode_uint64},
+	{"line_size", offsetof(struct nvmf_rpc_ns_cache_ctx, opts.line_size), spdk_json_decode_uint32, true},
+	{"tgt_name", offsetof(struct nvmf_rpc_ns_cache_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+nvmf_rpc_ns_cache_ctx_free(struct nvmf_rpc_ns_cache_ctx *ctx)
+{
+	free(ctx->nqn);
+	free(ctx->tgt_name);
+	free(ctx);
+}
+
+static void
+nvmf_rpc_ns_cache_resumed(struct spdk_nvmf_subsystem *subsystem,
+			  void *cb_arg, int status)
+{
+	struct nvmf_rpc_ns_cache_ctx *ctx = cb_arg;
+	struct spdk_jsonrpc_request *request;
+	struct spdk_json_write_ctx *w;
+	bool response_sent = ctx->response_sent;
+
+	request = ctx->request;
+	nvmf_rpc_ns_cache_ctx_free(ctx);
+
+	if (response_sent) {
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_bool(w, true);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+nvmf_rpc_ns_cache_paused(struct spdk_nvmf_subsystem *subsystem,
+			 void *cb_arg, int status)
+{
+	struct nvmf_rpc_ns_cache_ctx *ctx = cb_arg;
+	int rc;
+
+	/* No I/O is in flight while the cache is swapped. */
+	rc = spdk_nvmf_subsystem_set_ns_cache(subsystem, ctx->nsid, &ctx->opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(-rc));
+		ctx->response_sent = true;
+	}
+
+	if (spdk_nvmf_subsystem_resume(subsystem, nvmf_rpc_ns_cache_resumed, ctx)) {
+		if (!ctx->response_sent) {
+			spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
+		}
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+}
+
+static void
+spdk_rpc_nvmf_subsystem_set_ns_cache(struct spdk_jsonrpc_request *request,
+				     const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_ns_cache_ctx *ctx;
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_tgt *tgt;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Out of memory");
+		return;
+	}
+
+	if (spdk_json_decode_object(params, nvmf_rpc_set_ns_cache_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_set_ns_cache_decoder),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+
+	ctx->request = request;
+	ctx->response_sent = false;
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx->nqn);
+	if (!subsystem || spdk_nvmf_subsystem_get_ns(subsystem, ctx->nsid) == NULL) {
+		SPDK_ERRLOG("Unable to find namespace %u of subsystem with NQN %s\n", ctx->nsid, ctx->nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+
+	if (spdk_nvmf_subsystem_pause(subsystem, nvmf_rpc_ns_cache_paused, ctx)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_set_ns_cache", spdk_rpc_nvmf_subsystem_set_ns_cache,
+		  SPDK_RPC_RUNTIME)
+
+static const struct spdk_json_object_decoder nvmf_rpc_ns_cache_stats_decoder[] = {
+	{"nqn", offsetof(struct nvmf_rpc_ns_cache_ctx, nqn), spdk_json_decode_string},
+	{"nsid", offsetof(struct nvmf_rpc_ns_cache_ctx, nsid), spdk_json_decode_uint32},
+	{"tgt_name", offsetof(struct nvmf_rpc_ns_cache_ctx, tgt_name), spdk_json_decode_string, true},
+};
+
+static void
+spdk_rpc_nvmf_subsystem_get_ns_cache_stats(struct spdk_jsonrpc_request *request,
+		const struct spdk_json_val *params)
+{
+	struct nvmf_rpc_ns_cache_ctx *ctx;
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_ns_cache_stats stats;
+	struct spdk_nvmf_ns *ns;
+	struct spdk_nvmf_tgt *tgt;
+	struct spdk_json_write_ctx *w;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Out of memory");
+		return;
+	}
+
+	if (spdk_json_decode_object(params, nvmf_rpc_ns_cache_stats_decoder,
+				    SPDK_COUNTOF(nvmf_rpc_ns_cache_stats_decoder),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx->nqn);
+	ns = subsystem ? spdk_nvmf_subsystem_get_ns(subsystem, ctx->nsid) : NULL;
+	if (!ns) {
+		SPDK_ERRLOG("Unable to find namespace %u of subsystem with NQN %s\n", ctx->nsid, ctx->nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+
+	if (spdk_nvmf_ns_get_cache_stats(ns, &stats) != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Namespace has no read cache");
+		nvmf_rpc_ns_cache_ctx_free(ctx);
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint32(w, "nsid", ctx->nsid);
+	spdk_json_write_named_uint64(w, "hits", stats.hits);
+	spdk_json_write_named_uint64(w, "misses", stats.misses);
+	spdk_json_write_named_uint64(w, "bypassed", stats.bypassed);
+	spdk_json_write_named_uint64(w, "fills", stats.fills);
+	spdk_json_write_named_uint64(w, "evictions", stats.evictions);
+	spdk_json_write_named_uint64(w, "invalidations", stats.invalidations);
+	spdk_json_write_named_uint64(w, "lines", stats.lines);
+	spdk_json_write_named_uint64(w, "bytes", stats.bytes);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+
+	nvmf_rpc_ns_cache_ctx_free(ctx);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_get_ns_cache_stats", spdk_rpc_nvmf_subsystem_get_ns_cache_stats,
+		  SPDK_RPC_RUNTIME)
+
+struct nvmf_rpc_create_transport_ctx {
+	char				*trtype;
+	char				*tgt_name;
+	struct spdk_nvmf_transport_opts	opts;
+	struct spdk_jsonrpc_request	*request;
+};
+
+static const struct spdk_json_object_decoder nvmf_rpc_create_transport_decoder[] = {
+	{	"trtype", offsetof(struct nvmf_rpc_create_transport_ctx, trtype), spdk_json_decode_string},
+	{
+		"max_queue_depth", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_queue_depth),
+		spdk_json_decode_uint16, true
+	},
+	{
+		"max_qpairs_per_ctrlr", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_qpairs_per_ctrlr),
+		spdk_json_decode_uint16, true
+	},
+	{
+		"in_capsule_data_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.in_capsule_data_size),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"max_io_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_io_size),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"io_unit_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.io_unit_size),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"max_aq_depth", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_aq_depth),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"num_shared_buffers", offsetof(struct nvmf_rpc_create_transport_ctx, opts.num_shared_buffers),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"buf_cache_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.buf_cache_size),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"max_srq_depth", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_srq_depth),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"no_srq", offsetof(struct nvmf_rpc_create_transport_ctx, opts.no_srq),
+		spdk_json_decode_bool, true
+	},
+	{
+		"c2h_success", offsetof(struct nvmf_rpc_create_transport_ctx, opts.c2h_success),
+		spdk_json_decode_bool, true
+	},
+	{
+		"dif_insert_or_strip", offsetof(struct nvmf_rpc_create_transport_ctx, opts.dif_insert_or_strip),
+		spdk_json_decode_bool, true
+	},
+	{
+		"sock_priority", offsetof(struct nvmf_rpc_create_transport_ctx, opts.sock_priority),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"max_inline_data_size", offsetof(struct nvmf_rpc_create_transport_ctx, opts.max_inline_data_size),
 		spdk_json_decode_uint32, true
 	},
 	{
@@ -1605,6 +2222,7 @@ dump_nvmf_transport(struct spdk_json_write_ctx *w, struct spdk_nvmf_transport *t
 	if (type == SPDK_NVME_TRANSPORT_RDMA) {
 		spdk_json_write_named_uint32(w, "max_srq_depth", opts->max_srq_depth);
 		spdk_json_write_named_bool(w, "no_srq", opts->no_srq);
+		spdk_json_write_named_uint32(w, "max_inline_data_size", opts->max_inline_data_size);
 	} else if (type == SPDK_NVME_TRANSPORT_TCP) {
 		spdk_json_write_named_bool(w, "c2h_success", opts->c2h_success);
 		spdk_json_write_named_bool(w, "dif_insert_or_strip", opts->dif_insert_or_strip);
@@ -1700,6 +2318,12 @@ write_nvmf_transport_stats(struct spdk_json_write_ctx *w,
 	spdk_json_write_object_begin(w);
 	spdk_json_write_named_string(w, "trtype",
 				     spdk_nvme_transport_id_trtype_str(stat->trtype));
+	spdk_json_write_named_int32(w, "numa_socket", stat->numa_socket);
+	spdk_json_write_named_uint32(w, "buf_cache_size", stat->buf_cache_size);
+	spdk_json_write_named_uint32(w, "buf_cache_count", stat->buf_cache_count);
+	spdk_json_write_named_uint64(w, "buf_cache_misses", stat->buf_cache_misses);
+	spdk_json_write_named_uint64(w, "buf_waits", stat->buf_waits);
+	spdk_json_write_named_uint64(w, "buf_pool_exhausted", stat->buf_pool_exhausted);
 	switch (stat->trtype) {
 	case SPDK_NVME_TRANSPORT_RDMA:
 		spdk_json_write_named_uint64(w, "pending_data_buffer", stat->rdma.pending_data_buffer);
@@ -1719,6 +2343,12 @@ write_nvmf_transport_stats(struct spdk_json_write_ctx *w,
 						     stat->rdma.devices[i].pending_rdma_read);
 			spdk_json_write_named_uint64(w, "pending_rdma_write",
 						     stat->rdma.devices[i].pending_rdma_write);
+			spdk_json_write_named_uint64(w, "inline_data_wrs",
+						     stat->rdma.devices[i].inline_data_wrs);
+			spdk_json_write_named_uint64(w, "send_wrs", stat->rdma.devices[i].send_wrs);
+			spdk_json_write_named_uint64(w, "send_doorbells", stat->rdma.devices[i].send_doorbells);
+			spdk_json_write_named_uint64(w, "recv_wrs", stat->rdma.devices[i].recv_wrs);
+			spdk_json_write_named_uint64(w, "recv_doorbells", stat->rdma.devices[i].recv_doorbells);
 			spdk_json_write_object_end(w);
 		}
 		spdk_json_write_array_end(w);
@@ -369,6 +369,9 @@ struct spdk_nvmf_rdma_qpair {
 	/* The maximum number of SGEs per WR on the recv queue */
 	uint32_t				max_recv_sge;
 
+	/* The maximum number of bytes a send WR can carry inline, 0 if inline data is not used */
+	uint32_t				max_inline_data;
+
 	/* The list of pending send requests for a transfer */
 	struct spdk_nvmf_send_wr_list		sends_to_post;
 
@@ -417,6 +420,11 @@ struct spdk_nvmf_rdma_poller_stat {
 	uint64_t				pending_free_request;
 	uint64_t				pending_rdma_read;
 	uint64_t				pending_rdma_write;
+	uint64_t				inline_data_wrs;
+	uint64_t				send_wrs;
+	uint64_t				send_doorbells;
+	uint64_t				recv_wrs;
+	uint64_t				recv_doorbells;
 };
 
 struct spdk_nvmf_rdma_poller {
@@ -644,6 +652,7 @@ nvmf_rdma_request_free_data(struct spdk_nvmf_rdma_request *rdma_req,
 	uint64_t				req_wrid;
 
 	rdma_req->num_outstanding_data_wr = 0;
+	rdma_req->data.wr.send_flags &= ~IBV_SEND_INLINE;
 	data_wr = &rdma_req->data;
 	req_wrid = data_wr->wr.wr_id;
 	while (data_wr && data_wr->wr.wr_id == req_wrid) {
@@ -983,6 +992,7 @@ spdk_nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 					  2 + 1; /* SEND, READ, and WRITE operations + dummy drain WR */
 	ibv_init_attr.cap.max_send_sge	= spdk_min(device->attr.max_sge, NVMF_DEFAULT_TX_SGE);
 	ibv_init_attr.cap.max_recv_sge	= spdk_min(device->attr.max_sge, NVMF_DEFAULT_RX_SGE);
+	ibv_init_attr.cap.max_inline_data = qpair->transport->opts.max_inline_data_size;
 
 	if (rqpair->srq == NULL && nvmf_rdma_resize_cq(rqpair, device) < 0) {
 		SPDK_ERRLOG("Failed to resize the completion queue. Cannot initialize qpair.\n");
@@ -990,6 +1000,14 @@ spdk_nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 	}
 
 	rc = rdma_create_qp(rqpair->cm_id, rqpair->port->device->pd, &ibv_init_attr);
+	if (rc && ibv_init_attr.cap.max_inline_data != 0) {
+		/* The device can't tell the inline limit up front, so fall back to regular sends. */
+		SPDK_NOTICELOG("Device %s does not support %u bytes of inline data, disabling inline sends\n",
+			       ibv_get_device_name(device->context->device),
+			       ibv_init_attr.cap.max_inline_data);
+		ibv_init_attr.cap.max_inline_data = 0;
+		rc = rdma_create_qp(rqpair->cm_id, rqpair->port->device->pd, &ibv_init_attr);
+	}
 	if (rc) {
 		SPDK_ERRLOG("rdma_create_qp failed: errno %d: %s\n", errno, spdk_strerror(errno));
 		goto error;
@@ -999,6 +1017,8 @@ spdk_nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 					  ibv_init_attr.cap.max_send_wr);
 	rqpair->max_send_sge = spdk_min(NVMF_DEFAULT_TX_SGE, ibv_init_attr.cap.max_send_sge);
 	rqpair->max_recv_sge = spdk_min(NVMF_DEFAULT_RX_SGE, ibv_init_attr.cap.max_recv_sge);
+	rqpair->max_inline_data = spdk_min(qpair->transport->opts.max_inline_data_size,
+					   ibv_init_attr.cap.max_inline_data);
 	spdk_trace_record(TRACE_RDMA_QP_CREATE, 0, 0, (uintptr_t)rqpair->cm_id, 0);
 	SPDK_DEBUGLOG(SPDK_LOG_RDMA, "New RDMA Connection: %p\n", qpair);
 
@@ -1046,9 +1066,11 @@ nvmf_rdma_qpair_queue_recv_wrs(struct spdk_nvmf_rdma_qpair *rqpair, struct ibv_r
 {
 	struct ibv_recv_wr *last;
 
+	rqpair->poller->stat.recv_wrs++;
 	last = first;
 	while (last->next != NULL) {
 		last = last->next;
+		rqpair->poller->stat.recv_wrs++;
 	}
 
 	if (rqpair->resources->recvs_to_post.first == NULL) {
@@ -1070,9 +1092,11 @@ nvmf_rdma_qpair_queue_send_wrs(struct spdk_nvmf_rdma_qpair *rqpair, struct ibv_s
 {
 	struct ibv_send_wr *last;
 
+	rqpair->poller->stat.send_wrs++;
 	last = first;
 	while (last->next != NULL) {
 		last = last->next;
+		rqpair->poller->stat.send_wrs++;
 	}
 
 	if (rqpair->sends_to_post.first == NULL) {
@@ -1105,6 +1129,19 @@ request_transfer_in(struct spdk_nvmf_request *req)
 	return 0;
 }
 
+static bool
+nvmf_rdma_wr_fits_inline(struct ibv_send_wr *wr, uint32_t max_inline_data)
+{
+	uint32_t length = 0;
+	int i;
+
+	for (i = 0; i < wr->num_sge; i++) {
+		length += wr->sg_list[i].length;
+	}
+
+	return length <= max_inline_data;
+}
+
 static int
 request_transfer_out(struct spdk_nvmf_request *req, int *data_posted)
 {
@@ -1144,11 +1181,29 @@ request_transfer_out(struct spdk_nvmf_request *req, int *data_posted)
 	 */
 	first = &rdma_req->rsp.wr;
 
+	/*
+	 * Small payloads are copied into the work queue entry by the driver, which
+	 * saves the NIC a DMA read of the buffer before it can put the data on the wire.
+	 * Requests using the shared receive queue may move between qpairs, so the
+	 * response flag is set each time.
+	 */
+	if (rqpair->max_inline_data >= sizeof(*rsp)) {
+		rdma_req->rsp.wr.send_flags |= IBV_SEND_INLINE;
+	} else {
+		rdma_req->rsp.wr.send_flags &= ~IBV_SEND_INLINE;
+	}
+
 	if (rsp->status.sc == SPDK_NVME_SC_SUCCESS &&
 	    req->xfer == SPDK_NVME_DATA_CONTROLLER_TO_HOST) {
 		first = &rdma_req->data.wr;
 		*data_posted = 1;
 		num_outstanding_data_wr = rdma_req->num_outstanding_data_wr;
+
+		if (num_outstanding_data_wr == 1 &&
+		    nvmf_rdma_wr_fits_inline(&rdma_req->data.wr, rqpair->max_inline_data)) {
+			rdma_req->data.wr.send_flags |= IBV_SEND_INLINE;
+			rqpair->poller->stat.inline_data_wrs++;
+		}
 	}
 	nvmf_rdma_qpair_queue_send_wrs(rqpair, first);
 	/* +1 for the rsp wr */
@@ -2044,6 +2099,7 @@ spdk_nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 #define SPDK_NVMF_RDMA_DEFAULT_NUM_SHARED_BUFFERS 4095
 #define SPDK_NVMF_RDMA_DEFAULT_BUFFER_CACHE_SIZE 32
 #define SPDK_NVMF_RDMA_DEFAULT_NO_SRQ false;
+#define SPDK_NVMF_RDMA_DEFAULT_MAX_INLINE_DATA_SIZE 256
 
 static void
 spdk_nvmf_rdma_opts_init(struct spdk_nvmf_transport_opts *opts)
@@ -2058,6 +2114,7 @@ spdk_nvmf_rdma_opts_init(struct spdk_nvmf_transport_opts *opts)
 	opts->buf_cache_size =		SPDK_NVMF_RDMA_DEFAULT_BUFFER_CACHE_SIZE;
 	opts->max_srq_depth =		SPDK_NVMF_RDMA_DEFAULT_SRQ_DEPTH;
 	opts->no_srq =			SPDK_NVMF_RDMA_DEFAULT_NO_SRQ
+	opts->max_inline_data_size =	SPDK_NVMF_RDMA_DEFAULT_MAX_INLINE_DATA_SIZE;
 }
 
 const struct spdk_mem_map_ops g_nvmf_rdma_map_ops = {
@@ -2077,7 +2134,6 @@ spdk_nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 	uint32_t			i;
 	int				flag;
 	uint32_t			sge_count;
-	uint32_t			min_shared_buffers;
 	int				max_device_sge = SPDK_NVMF_MAX_SGL_ENTRIES;
 
 	rtransport = calloc(1, sizeof(*rtransport));
@@ -2100,7 +2156,8 @@ spdk_nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		     "  Transport opts:  max_ioq_depth=%d, max_io_size=%d,\n"
 		     "  max_qpairs_per_ctrlr=%d, io_unit_size=%d,\n"
 		     "  in_capsule_data_size=%d, max_aq_depth=%d,\n"
-		     "  num_shared_buffers=%d, max_srq_depth=%d, no_srq=%d\n",
+		     "  num_shared_buffers=%d, max_srq_depth=%d, no_srq=%d,\n"
+		     "  max_inline_data_size=%d\n",
 		     opts->max_queue_depth,
 		     opts->max_io_size,
 		     opts->max_qpairs_per_ctrlr,
@@ -2109,7 +2166,8 @@ spdk_nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		     opts->max_aq_depth,
 		     opts->num_shared_buffers,
 		     opts->max_srq_depth,
-		     opts->no_srq);
+		     opts->no_srq,
+		     opts->max_inline_data_size);
 
 	/* I/O unit size cannot be larger than max I/O size */
 	if (opts->io_unit_size > opts->max_io_size) {
@@ -2124,12 +2182,7 @@ spdk_nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		return NULL;
 	}
 
-	min_shared_buffers = spdk_thread_get_count() * opts->buf_cache_size;
-	if (min_shared_buffers > opts->num_shared_buffers) {
-		SPDK_ERRLOG("There are not enough buffers to satisfy"
-			    "per-poll group caches for each thread. (%" PRIu32 ")"
-			    "supplied. (%" PRIu32 ") required\n", opts->num_shared_buffers, min_shared_buffers);
-		SPDK_ERRLOG("Please specify a larger number of shared buffers\n");
+	if (spdk_nvmf_transport_calc_buf_cache_max(opts, &rtransport->transport.buf_cache_max) != 0) {
 		spdk_nvmf_rdma_destroy(&rtransport->transport);
 		return NULL;
 	}
@@ -3246,6 +3299,7 @@ _poller_submit_recvs(struct spdk_nvmf_rdma_transport *rtransport,
 
 	if (rpoller->srq) {
 		if (rpoller->resources->recvs_to_post.first != NULL) {
+			rpoller->stat.recv_doorbells++;
 			rc = ibv_post_srq_recv(rpoller->srq, rpoller->resources->recvs_to_post.first, &bad_recv_wr);
 			if (rc) {
 				_poller_reset_failed_recvs(rpoller, bad_recv_wr, rc);
@@ -3257,6 +3311,7 @@ _poller_submit_recvs(struct spdk_nvmf_rdma_transport *rtransport,
 		while (!STAILQ_EMPTY(&rpoller->qpairs_pending_recv)) {
 			rqpair = STAILQ_FIRST(&rpoller->qpairs_pending_recv);
 			assert(rqpair->resources->recvs_to_post.first != NULL);
+			rpoller->stat.recv_doorbells++;
 			rc = ibv_post_recv(rqpair->cm_id->qp, rqpair->resources->recvs_to_post.first, &bad_recv_wr);
 			if (rc) {
 				_qp_reset_failed_recvs(rqpair, bad_recv_wr, rc);
@@ -3340,6 +3395,7 @@ _poller_submit_sends(struct spdk_nvmf_rdma_transport *rtransport,
 	while (!STAILQ_EMPTY(&rpoller->qpairs_pending_send)) {
 		rqpair = STAILQ_FIRST(&rpoller->qpairs_pending_send);
 		assert(rqpair->sends_to_post.first != NULL);
+		rpoller->stat.send_doorbells++;
 		rc = ibv_post_send(rqpair->cm_id->qp, rqpair->sends_to_post.first, &bad_wr);
 
 		/* bad wr always points to the first wr that failed. */
@@ -3486,10 +3542,6 @@ spdk_nvmf_rdma_poller_poll(struct spdk_nvmf_rdma_transport *rtransport,
 		return -1;
 	}
 
-	/* submit outstanding work requests. */
-	_poller_submit_recvs(rtransport, rpoller);
-	_poller_submit_sends(rtransport, rpoller);
-
 	return count;
 }
 
@@ -3505,15 +3557,26 @@ spdk_nvmf_rdma_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 	rgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_rdma_poll_group, group);
 
 	count = 0;
+	rc = 0;
 	TAILQ_FOREACH(rpoller, &rgroup->pollers, link) {
 		rc = spdk_nvmf_rdma_poller_poll(rtransport, rpoller);
 		if (rc < 0) {
-			return rc;
+			break;
 		}
 		count += rc;
 	}
 
-	return count;
+	/*
+	 * Work requests queued while processing the completions above, and by
+	 * requests completed from other contexts since the last poll, are posted
+	 * with a single doorbell per qpair (or shared receive queue).
+	 */
+	TAILQ_FOREACH(rpoller, &rgroup->pollers, link) {
+		_poller_submit_recvs(rtransport, rpoller);
+		_poller_submit_sends(rtransport, rpoller);
+	}
+
+	return rc < 0 ? rc : count;
 }
 
 static int
@@ -3659,6 +3722,11 @@ spdk_nvmf_rdma_poll_group_get_stat(struct spdk_nvmf_tgt *tgt,
 				device_stat->pending_free_request = rpoller->stat.pending_free_request;
 				device_stat->pending_rdma_read = rpoller->stat.pending_rdma_read;
 				device_stat->pending_rdma_write = rpoller->stat.pending_rdma_write;
+				device_stat->inline_data_wrs = rpoller->stat.inline_data_wrs;
+				device_stat->send_wrs = rpoller->stat.send_wrs;
+				device_stat->send_doorbells = rpoller->stat.send_doorbells;
+				device_stat->recv_wrs = rpoller->stat.recv_wrs;
+				device_stat->recv_doorbells = rpoller->stat.recv_doorbells;
 			}
 			return 0;
 		}
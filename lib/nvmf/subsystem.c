@@ -283,6 +283,7 @@ spdk_nvmf_subsystem_create(struct spdk_nvmf_tgt *tgt,
 	TAILQ_INIT(&subsystem->listeners);
 	TAILQ_INIT(&subsystem->hosts);
 	TAILQ_INIT(&subsystem->ctrlrs);
+	TAILQ_INIT(&subsystem->removing_ns);
 
 	if (num_ns != 0) {
 		subsystem->ns = calloc(num_ns, sizeof(struct spdk_nvmf_ns *));
@@ -300,7 +301,10 @@ spdk_nvmf_subsystem_create(struct spdk_nvmf_tgt *tgt,
 		 MODEL_NUMBER_DEFAULT);
 
 	tgt->subsystems[sid] = subsystem;
-	tgt->discovery_genctr++;
+	LIST_INSERT_HEAD(&tgt->subsystem_hash[_spdk_nvmf_nqn_hash(subsystem->subnqn) %
+					      SPDK_NVMF_SUBSYSTEM_HASH_BUCKETS],
+			 subsystem, hash_link);
+	spdk_nvmf_update_discovery_log(tgt);
 
 	return subsystem;
 }
@@ -309,6 +313,7 @@ static void
 _spdk_nvmf_subsystem_remove_host(struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_host *host)
 {
 	TAILQ_REMOVE(&subsystem->hosts, host, link);
+	LIST_REMOVE(host, hash_link);
 	free(host);
 }
 
@@ -317,13 +322,21 @@ _nvmf_subsystem_remove_listener(struct spdk_nvmf_subsystem *subsystem,
 				struct spdk_nvmf_listener *listener)
 {
 	struct spdk_nvmf_transport *transport;
+	struct spdk_nvmf_ctrlr *ctrlr;
 
 	transport = spdk_nvmf_tgt_get_transport(subsystem->tgt, listener->trid.trtype);
 	if (transport != NULL) {
 		spdk_nvmf_transport_stop_listen(transport, &listener->trid);
 	}
 
+	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+		if (ctrlr->listener == listener) {
+			ctrlr->listener = NULL;
+		}
+	}
+
 	TAILQ_REMOVE(&subsystem->listeners, listener, link);
+	free(listener->ana_state);
 	free(listener);
 }
 
@@ -334,6 +347,7 @@ spdk_nvmf_subsystem_destroy(struct spdk_nvmf_subsystem *subsystem)
 	struct spdk_nvmf_host		*host, *host_tmp;
 	struct spdk_nvmf_ctrlr		*ctrlr, *ctrlr_tmp;
 	struct spdk_nvmf_ns		*ns;
+	uint32_t			i;
 
 	if (!subsystem) {
 		return;
@@ -365,8 +379,13 @@ spdk_nvmf_subsystem_destroy(struct spdk_nvmf_subsystem *subsystem)
 
 	free(subsystem->ns);
 
+	for (i = 0; i < SPDK_NVMF_CNTLID_NUM_PAGES; i++) {
+		free(subsystem->ctrlr_slots[i]);
+	}
+
 	subsystem->tgt->subsystems[subsystem->id] = NULL;
-	subsystem->tgt->discovery_genctr++;
+	LIST_REMOVE(subsystem, hash_link);
+	spdk_nvmf_update_discovery_log(subsystem->tgt);
 
 	free(subsystem);
 }
@@ -418,6 +437,12 @@ spdk_nvmf_subsystem_set_state(struct spdk_nvmf_subsystem *subsystem,
 		actual_old_state = __sync_val_compare_and_swap(&subsystem->state, expected_old_state, state);
 	}
 	assert(actual_old_state == expected_old_state);
+
+	/* Only subsystems that are (being) activated are reported in the discovery log. */
+	if (state == SPDK_NVMF_SUBSYSTEM_ACTIVATING || state == SPDK_NVMF_SUBSYSTEM_DEACTIVATING) {
+		spdk_nvmf_update_discovery_log(subsystem->tgt);
+	}
+
 	return actual_old_state - expected_old_state;
 }
 
@@ -614,7 +639,9 @@ _spdk_nvmf_subsystem_find_host(struct spdk_nvmf_subsystem *subsystem, const char
 {
 	struct spdk_nvmf_host *host = NULL;
 
-	TAILQ_FOREACH(host, &subsystem->hosts, link) {
+	uint32_t bucket = _spdk_nvmf_nqn_hash(hostnqn) % SPDK_NVMF_HOST_HASH_BUCKETS;
+
+	LIST_FOREACH(host, &subsystem->host_hash[bucket], hash_link) {
 		if (strcmp(hostnqn, host->nqn) == 0) {
 			return host;
 		}
@@ -650,7 +677,10 @@ spdk_nvmf_subsystem_add_host(struct spdk_nvmf_subsystem *subsystem, const char *
 	snprintf(host->nqn, sizeof(host->nqn), "%s", hostnqn);
 
 	TAILQ_INSERT_HEAD(&subsystem->hosts, host, link);
-	subsystem->tgt->discovery_genctr++;
+	LIST_INSERT_HEAD(&subsystem->host_hash[_spdk_nvmf_nqn_hash(host->nqn) %
+					       SPDK_NVMF_HOST_HASH_BUCKETS],
+			 host, hash_link);
+	spdk_nvmf_update_discovery_log(subsystem->tgt);
 
 	return 0;
 }
@@ -671,6 +701,7 @@ spdk_nvmf_subsystem_remove_host(struct spdk_nvmf_subsystem *subsystem, const cha
 	}
 
 	_spdk_nvmf_subsystem_remove_host(subsystem, host);
+	spdk_nvmf_update_discovery_log(subsystem->tgt);
 	return 0;
 }
 
@@ -682,7 +713,10 @@ spdk_nvmf_subsystem_set_allow_any_host(struct spdk_nvmf_subsystem *subsystem, bo
 		return -EAGAIN;
 	}
 
-	subsystem->allow_any_host = allow_any_host;
+	if (subsystem->allow_any_host != allow_any_host) {
+		subsystem->allow_any_host = allow_any_host;
+		spdk_nvmf_update_discovery_log(subsystem->tgt);
+	}
 
 	return 0;
 }
@@ -727,9 +761,9 @@ spdk_nvmf_host_get_nqn(struct spdk_nvmf_host *host)
 	return host->nqn;
 }
 
-static struct spdk_nvmf_listener *
-_spdk_nvmf_subsystem_find_listener(struct spdk_nvmf_subsystem *subsystem,
-				   const struct spdk_nvme_transport_id *trid)
+struct spdk_nvmf_listener *
+spdk_nvmf_subsystem_find_listener(struct spdk_nvmf_subsystem *subsystem,
+				  const struct spdk_nvme_transport_id *trid)
 {
 	struct spdk_nvmf_listener *listener;
 
@@ -742,6 +776,32 @@ _spdk_nvmf_subsystem_find_listener(struct spdk_nvmf_subsystem *subsystem,
 	return NULL;
 }
 
+static int
+_nvmf_listener_resize_ana_groups(struct spdk_nvmf_listener *listener, uint32_t num_ana_groups)
+{
+	enum spdk_nvme_ana_state *ana_state;
+	uint32_t i;
+
+	if (num_ana_groups <= listener->num_ana_groups) {
+		return 0;
+	}
+
+	ana_state = realloc(listener->ana_state, sizeof(*ana_state) * num_ana_groups);
+	if (ana_state == NULL) {
+		return -ENOMEM;
+	}
+
+	/* ANA groups start out optimized on every listener. */
+	for (i = listener->num_ana_groups; i < num_ana_groups; i++) {
+		ana_state[i] = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	}
+
+	listener->ana_state = ana_state;
+	listener->num_ana_groups = num_ana_groups;
+
+	return 0;
+}
+
 int
 spdk_nvmf_subsystem_add_listener(struct spdk_nvmf_subsystem *subsystem,
 				 struct spdk_nvme_transport_id *trid)
@@ -754,7 +814,7 @@ spdk_nvmf_subsystem_add_listener(struct spdk_nvmf_subsystem *subsystem,
 		return -EAGAIN;
 	}
 
-	if (_spdk_nvmf_subsystem_find_listener(subsystem, trid)) {
+	if (spdk_nvmf_subsystem_find_listener(subsystem, trid)) {
 		/* Listener already exists in this subsystem */
 		return 0;
 	}
@@ -773,7 +833,13 @@ spdk_nvmf_subsystem_add_listener(struct spdk_nvmf_subsystem *subsystem,
 	listener->trid = *trid;
 	listener->transport = transport;
 
+	if (_nvmf_listener_resize_ana_groups(listener, subsystem->max_nsid) != 0) {
+		free(listener);
+		return -ENOMEM;
+	}
+
 	TAILQ_INSERT_HEAD(&subsystem->listeners, listener, link);
+	spdk_nvmf_update_discovery_log(subsystem->tgt);
 
 	return 0;
 }
@@ -789,12 +855,13 @@ spdk_nvmf_subsystem_remove_listener(struct spdk_nvmf_subsystem *subsystem,
 		return -EAGAIN;
 	}
 
-	listener = _spdk_nvmf_subsystem_find_listener(subsystem, trid);
+	listener = spdk_nvmf_subsystem_find_listener(subsystem, trid);
 	if (listener == NULL) {
 		return -ENOENT;
 	}
 
 	_nvmf_subsystem_remove_listener(subsystem, listener);
+	spdk_nvmf_update_discovery_log(subsystem->tgt);
 
 	return 0;
 }
@@ -837,6 +904,111 @@ spdk_nvmf_listener_get_trid(struct spdk_nvmf_listener *listener)
 	return &listener->trid;
 }
 
+enum spdk_nvme_ana_state
+spdk_nvmf_listener_get_ana_state(struct spdk_nvmf_listener *listener, uint32_t anagrpid)
+{
+	if (anagrpid == 0 || anagrpid > listener->num_ana_groups) {
+		return SPDK_NVME_ANA_OPTIMIZED_STATE;
+	}
+
+	return listener->ana_state[anagrpid - 1];
+}
+
+struct subsystem_ana_change_ctx {
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_listener *listener;
+
+	spdk_nvmf_subsystem_state_change_done cb_fn;
+	void *cb_arg;
+};
+
+static void
+subsystem_ana_change_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct subsystem_ana_change_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	if (ctx->cb_fn) {
+		ctx->cb_fn(ctx->subsystem, ctx->cb_arg, status);
+	}
+	free(ctx);
+}
+
+static void
+subsystem_ana_change_on_pg(struct spdk_io_channel_iter *i)
+{
+	struct subsystem_ana_change_ctx *ctx;
+	struct spdk_nvmf_poll_group *group;
+	struct spdk_nvmf_ctrlr *ctrlr;
+
+	ctx = spdk_io_channel_iter_get_ctx(i);
+	group = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	TAILQ_FOREACH(ctrlr, &ctx->subsystem->ctrlrs, link) {
+		if (ctrlr->admin_qpair != NULL && ctrlr->admin_qpair->group == group &&
+		    ctrlr->listener == ctx->listener) {
+			spdk_nvmf_ctrlr_async_event_ana_change_notice(ctrlr);
+		}
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+int
+spdk_nvmf_subsystem_set_ana_state(struct spdk_nvmf_subsystem *subsystem,
+				  const struct spdk_nvme_transport_id *trid,
+				  enum spdk_nvme_ana_state ana_state, uint32_t anagrpid,
+				  spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg)
+{
+	struct spdk_nvmf_listener *listener;
+	struct subsystem_ana_change_ctx *ctx;
+	uint32_t i;
+
+	if (ana_state < SPDK_NVME_ANA_OPTIMIZED_STATE ||
+	    ana_state > SPDK_NVME_ANA_PERSISTENT_LOSS_STATE) {
+		SPDK_ERRLOG("Invalid ANA state %d\n", ana_state);
+		return -EINVAL;
+	}
+
+	listener = spdk_nvmf_subsystem_find_listener(subsystem, trid);
+	if (listener == NULL) {
+		SPDK_ERRLOG("Unable to find listener.\n");
+		return -ENOENT;
+	}
+
+	if (anagrpid > listener->num_ana_groups) {
+		SPDK_ERRLOG("ANA group ID %" PRIu32 " is larger than maximum %" PRIu32 "\n",
+			    anagrpid, listener->num_ana_groups);
+		return -EINVAL;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->listener = listener;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	for (i = 0; i < listener->num_ana_groups; i++) {
+		if (anagrpid == 0 || anagrpid == i + 1) {
+			listener->ana_state[i] = ana_state;
+		}
+	}
+	listener->ana_state_change_count++;
+
+	SPDK_DEBUGLOG(SPDK_LOG_NVMF, "Subsystem %s: ANA group %" PRIu32 " on %s:%s set to state %d\n",
+		      subsystem->subnqn, anagrpid, trid->traddr, trid->trsvcid, ana_state);
+
+	spdk_for_each_channel(subsystem->tgt,
+			      subsystem_ana_change_on_pg,
+			      ctx,
+			      subsystem_ana_change_done);
+
+	return 0;
+}
+
 struct subsystem_update_ns_ctx {
 	struct spdk_nvmf_subsystem *subsystem;
 
@@ -893,11 +1065,29 @@ spdk_nvmf_subsystem_ns_changed(struct spdk_nvmf_subsystem *subsystem, uint32_t n
 	}
 }
 
+static void
+_spdk_nvmf_ns_free(struct spdk_nvmf_ns *ns)
+{
+	struct spdk_nvmf_registrant *reg, *reg_tmp;
+
+	TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, reg_tmp) {
+		TAILQ_REMOVE(&ns->registrants, reg, link);
+		free(reg);
+	}
+	spdk_bdev_module_release_bdev(ns->bdev);
+	spdk_bdev_close(ns->desc);
+	if (ns->ptpl_file) {
+		free(ns->ptpl_file);
+	}
+	free(ns->sched_conf.hosts);
+	spdk_nvmf_ns_cache_destroy(ns->cache);
+	free(ns);
+}
+
 int
 spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
 {
 	struct spdk_nvmf_ns *ns;
-	struct spdk_nvmf_registrant *reg, *reg_tmp;
 
 	assert(subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED ||
 	       subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE);
@@ -918,35 +1108,114 @@ spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t ns
 
 	subsystem->ns[nsid - 1] = NULL;
 
-	TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, reg_tmp) {
-		TAILQ_REMOVE(&ns->registrants, reg, link);
-		free(reg);
-	}
-	spdk_bdev_module_release_bdev(ns->bdev);
-	spdk_bdev_close(ns->desc);
-	if (ns->ptpl_file) {
-		free(ns->ptpl_file);
-	}
-	free(ns);
+	_spdk_nvmf_ns_free(ns);
 
 	spdk_nvmf_subsystem_ns_changed(subsystem, nsid);
 
 	return 0;
 }
 
+struct subsystem_ns_change_ctx {
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_ns *ns;
+	uint32_t nsid;
+
+	spdk_nvmf_subsystem_state_change_done cb_fn;
+	void *cb_arg;
+};
+
+static void
+subsystem_remove_ns_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct subsystem_ns_change_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	/* Every poll group has dropped its channel, so the bdev can be released. */
+	TAILQ_REMOVE(&ctx->subsystem->removing_ns, ctx->ns, link);
+	_spdk_nvmf_ns_free(ctx->ns);
+
+	if (ctx->cb_fn) {
+		ctx->cb_fn(ctx->subsystem, ctx->cb_arg, status);
+	}
+	free(ctx);
+}
+
+static void
+subsystem_remove_ns_on_pg_done(void *cb_arg, int status)
+{
+	struct spdk_io_channel_iter *i = cb_arg;
+
+	spdk_for_each_channel_continue(i, status);
+}
+
 static void
-_spdk_nvmf_ns_hot_remove(struct spdk_nvmf_subsystem *subsystem,
-			 void *cb_arg, int status)
+subsystem_remove_ns_on_pg(struct spdk_io_channel_iter *i)
 {
-	struct spdk_nvmf_ns *ns = cb_arg;
+	struct subsystem_ns_change_ctx *ctx;
+	struct spdk_nvmf_poll_group *group;
+
+	ctx = spdk_io_channel_iter_get_ctx(i);
+	group = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	spdk_nvmf_poll_group_remove_ns(group, ctx->subsystem, ctx->nsid,
+				       subsystem_remove_ns_on_pg_done, i);
+}
+
+int
+spdk_nvmf_subsystem_hot_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				  spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg)
+{
+	struct subsystem_ns_change_ctx *ctx;
+	struct spdk_nvmf_ns *ns;
 	int rc;
 
-	rc = spdk_nvmf_subsystem_remove_ns(subsystem, ns->opts.nsid);
-	if (rc != 0) {
-		SPDK_ERRLOG("Failed to make changes to NVME-oF subsystem with id: %u\n", subsystem->id);
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
+	    subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED) {
+		rc = spdk_nvmf_subsystem_remove_ns(subsystem, nsid);
+		if (rc != 0) {
+			return -ENOENT;
+		}
+
+		if (cb_fn) {
+			cb_fn(subsystem, cb_arg, 0);
+		}
+		return 0;
 	}
 
-	spdk_nvmf_subsystem_resume(subsystem, NULL, NULL);
+	if (subsystem->state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		return -EBUSY;
+	}
+
+	ns = _spdk_nvmf_subsystem_get_ns(subsystem, nsid);
+	if (ns == NULL) {
+		return -ENOENT;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->ns = ns;
+	ctx->nsid = nsid;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	/*
+	 * Unpublish the namespace first so that no poll group submits new I/O to
+	 * it, then let each poll group drop its channel once its own I/O to the
+	 * namespace has drained. The NSID can't be reused until that is done.
+	 * Each poll group records the change in its own controllers.
+	 */
+	subsystem->ns[nsid - 1] = NULL;
+	TAILQ_INSERT_TAIL(&subsystem->removing_ns, ns, link);
+
+	spdk_for_each_channel(subsystem->tgt,
+			      subsystem_remove_ns_on_pg,
+			      ctx,
+			      subsystem_remove_ns_done);
+
+	return 0;
 }
 
 static void
@@ -955,9 +1224,10 @@ spdk_nvmf_ns_hot_remove(void *remove_ctx)
 	struct spdk_nvmf_ns *ns = remove_ctx;
 	int rc;
 
-	rc = spdk_nvmf_subsystem_pause(ns->subsystem, _spdk_nvmf_ns_hot_remove, ns);
+	/* Only this namespace has to stop, the others keep serving I/O. */
+	rc = spdk_nvmf_subsystem_hot_remove_ns(ns->subsystem, ns->opts.nsid, NULL, NULL);
 	if (rc) {
-		SPDK_ERRLOG("Unable to pause subsystem to process namespace removal!\n");
+		SPDK_ERRLOG("Unable to process namespace removal, error=%d\n", rc);
 	}
 }
 
@@ -978,21 +1248,34 @@ spdk_nvmf_ns_load_reservation(const char *file, struct spdk_nvmf_reservation_inf
 static int
 nvmf_ns_reservation_restore(struct spdk_nvmf_ns *ns, struct spdk_nvmf_reservation_info *info);
 
-uint32_t
-spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bdev *bdev,
-			   const struct spdk_nvmf_ns_opts *user_opts, size_t opts_size,
-			   const char *ptpl_file)
+static bool
+_spdk_nvmf_subsystem_nsid_in_use(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
+{
+	struct spdk_nvmf_ns *ns;
+
+	if (_spdk_nvmf_subsystem_get_ns(subsystem, nsid) != NULL) {
+		return true;
+	}
+
+	TAILQ_FOREACH(ns, &subsystem->removing_ns, link) {
+		if (ns->opts.nsid == nsid) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static uint32_t
+_spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bdev *bdev,
+			    const struct spdk_nvmf_ns_opts *user_opts, size_t opts_size,
+			    const char *ptpl_file)
 {
 	struct spdk_nvmf_ns_opts opts;
 	struct spdk_nvmf_ns *ns;
 	struct spdk_nvmf_reservation_info info = {0};
 	int rc;
 
-	if (!(subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
-	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED)) {
-		return 0;
-	}
-
 	if (spdk_bdev_get_md_size(bdev) != 0 && !spdk_bdev_is_md_interleaved(bdev)) {
 		SPDK_ERRLOG("Can't attach bdev with separate metadata.\n");
 		return 0;
@@ -1020,19 +1303,29 @@ spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bd
 		 * expand max_nsid if possible.
 		 */
 		for (opts.nsid = 1; opts.nsid <= subsystem->max_nsid; opts.nsid++) {
-			if (_spdk_nvmf_subsystem_get_ns(subsystem, opts.nsid) == NULL) {
+			if (!_spdk_nvmf_subsystem_nsid_in_use(subsystem, opts.nsid)) {
 				break;
 			}
 		}
 	}
 
-	if (_spdk_nvmf_subsystem_get_ns(subsystem, opts.nsid)) {
+	if (_spdk_nvmf_subsystem_nsid_in_use(subsystem, opts.nsid)) {
 		SPDK_ERRLOG("Requested NSID %" PRIu32 " already in use\n", opts.nsid);
 		return 0;
 	}
 
+	if (opts.anagrpid == 0) {
+		opts.anagrpid = opts.nsid;
+	}
+
+	if (opts.anagrpid > spdk_max(opts.nsid, subsystem->max_nsid)) {
+		SPDK_ERRLOG("ANA group ID %" PRIu32 " is larger than the maximum NSID\n", opts.anagrpid);
+		return 0;
+	}
+
 	if (opts.nsid > subsystem->max_nsid) {
 		struct spdk_nvmf_ns **new_ns_array;
+		struct spdk_nvmf_listener *listener;
 
 		/* If MaxNamespaces was specified, we can't extend max_nsid beyond it. */
 		if (subsystem->max_allowed_nsid > 0 && opts.nsid > subsystem->max_allowed_nsid) {
@@ -1055,6 +1348,15 @@ spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bd
 		memset(new_ns_array + subsystem->max_nsid, 0,
 		       sizeof(struct spdk_nvmf_ns *) * (opts.nsid - subsystem->max_nsid));
 		subsystem->ns = new_ns_array;
+
+		/* Every NSID may be used as an ANA group ID, so listeners track as many groups. */
+		TAILQ_FOREACH(listener, &subsystem->listeners, link) {
+			if (_nvmf_listener_resize_ana_groups(listener, opts.nsid) != 0) {
+				SPDK_ERRLOG("Memory allocation error while resizing ANA group array.\n");
+				return 0;
+			}
+		}
+
 		subsystem->max_nsid = opts.nsid;
 	}
 
@@ -1104,11 +1406,127 @@ spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bd
 		      spdk_bdev_get_name(bdev),
 		      opts.nsid);
 
-	spdk_nvmf_subsystem_ns_changed(subsystem, opts.nsid);
-
 	return opts.nsid;
 }
 
+uint32_t
+spdk_nvmf_subsystem_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bdev *bdev,
+			   const struct spdk_nvmf_ns_opts *user_opts, size_t opts_size,
+			   const char *ptpl_file)
+{
+	uint32_t nsid;
+
+	if (!(subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
+	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED)) {
+		return 0;
+	}
+
+	nsid = _spdk_nvmf_subsystem_add_ns(subsystem, bdev, user_opts, opts_size, ptpl_file);
+	if (nsid != 0) {
+		spdk_nvmf_subsystem_ns_changed(subsystem, nsid);
+	}
+
+	return nsid;
+}
+
+static void
+subsystem_add_ns_rollback_done(struct spdk_nvmf_subsystem *subsystem, void *cb_arg, int status)
+{
+	struct subsystem_ns_change_ctx *ctx = cb_arg;
+
+	if (ctx->cb_fn) {
+		ctx->cb_fn(subsystem, ctx->cb_arg, -ENOMEM);
+	}
+	free(ctx);
+}
+
+static void
+subsystem_add_ns_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct subsystem_ns_change_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	if (status != 0) {
+		SPDK_ERRLOG("Subsystem %s: failed to attach nsid %" PRIu32 " to all poll groups\n",
+			    ctx->subsystem->subnqn, ctx->nsid);
+		if (spdk_nvmf_subsystem_hot_remove_ns(ctx->subsystem, ctx->nsid,
+						      subsystem_add_ns_rollback_done, ctx) == 0) {
+			return;
+		}
+	}
+
+	if (ctx->cb_fn) {
+		ctx->cb_fn(ctx->subsystem, ctx->cb_arg, status);
+	}
+	free(ctx);
+}
+
+static void
+subsystem_add_ns_on_pg(struct spdk_io_channel_iter *i)
+{
+	struct subsystem_ns_change_ctx *ctx;
+	struct spdk_nvmf_poll_group *group;
+	int rc;
+
+	ctx = spdk_io_channel_iter_get_ctx(i);
+	group = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	rc = spdk_nvmf_poll_group_update_subsystem(group, ctx->subsystem);
+	spdk_for_each_channel_continue(i, rc);
+}
+
+uint32_t
+spdk_nvmf_subsystem_hot_add_ns(struct spdk_nvmf_subsystem *subsystem, struct spdk_bdev *bdev,
+			       const struct spdk_nvmf_ns_opts *user_opts, size_t opts_size,
+			       const char *ptpl_file,
+			       spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg)
+{
+	struct subsystem_ns_change_ctx *ctx;
+	uint32_t nsid;
+
+	if (subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
+	    subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED) {
+		nsid = spdk_nvmf_subsystem_add_ns(subsystem, bdev, user_opts, opts_size, ptpl_file);
+		if (nsid != 0 && cb_fn) {
+			cb_fn(subsystem, cb_arg, 0);
+		}
+		return nsid;
+	}
+
+	if (subsystem->state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		return 0;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return 0;
+	}
+
+	nsid = _spdk_nvmf_subsystem_add_ns(subsystem, bdev, user_opts, opts_size, ptpl_file);
+	if (nsid == 0) {
+		free(ctx);
+		return 0;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->nsid = nsid;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	/*
+	 * The namespace is published now, but each poll group only starts to
+	 * serve it once it has grown its own namespace array and opened a
+	 * channel on its thread. Until then the NSID reads as inactive there.
+	 * Each poll group records the change in its own controllers and notifies
+	 * their hosts after it attached the namespace.
+	 */
+	spdk_for_each_channel(subsystem->tgt,
+			      subsystem_add_ns_on_pg,
+			      ctx,
+			      subsystem_add_ns_done);
+
+	return nsid;
+}
+
 static uint32_t
 spdk_nvmf_subsystem_get_next_allocated_nsid(struct spdk_nvmf_subsystem *subsystem,
 		uint32_t prev_nsid)
@@ -1173,6 +1591,271 @@ spdk_nvmf_ns_get_opts(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_opts *o
 	memcpy(opts, &ns->opts, spdk_min(sizeof(ns->opts), opts_size));
 }
 
+void
+spdk_nvmf_ns_get_sched_opts(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_sched_opts *opts)
+{
+	*opts = ns->sched_conf.opts;
+}
+
+struct subsystem_ns_sched_ctx {
+	struct spdk_nvmf_subsystem *subsystem;
+	uint32_t nsid;
+	struct spdk_nvmf_ns_sched_opts opts;
+	uint32_t num_poll_groups;
+
+	spdk_nvmf_subsystem_state_change_done cb_fn;
+	void *cb_arg;
+};
+
+static void
+subsystem_ns_sched_count_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct subsystem_ns_sched_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_nvmf_ns *ns;
+
+	ns = _spdk_nvmf_subsystem_get_ns(ctx->subsystem, ctx->nsid);
+	if (ns == NULL) {
+		/* Removed while the poll groups were counted */
+		status = -ENOENT;
+	} else if (status == 0) {
+		ns->sched_conf.opts = ctx->opts;
+		ns->sched_conf.num_poll_groups = ctx->num_poll_groups;
+	}
+
+	if (ctx->cb_fn) {
+		ctx->cb_fn(ctx->subsystem, ctx->cb_arg, status);
+	}
+	free(ctx);
+}
+
+static void
+subsystem_ns_sched_count_on_pg(struct spdk_io_channel_iter *i)
+{
+	struct subsystem_ns_sched_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	ctx->num_poll_groups++;
+	spdk_for_each_channel_continue(i, 0);
+}
+
+int
+spdk_nvmf_subsystem_set_ns_sched(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				 const struct spdk_nvmf_ns_sched_opts *opts,
+				 spdk_nvmf_subsystem_state_change_done cb_fn, void *cb_arg)
+{
+	struct subsystem_ns_sched_ctx *ctx;
+
+	if (!(subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
+	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED)) {
+		return -EBUSY;
+	}
+
+	if (_spdk_nvmf_subsystem_get_ns(subsystem, nsid) == NULL) {
+		return -ENOENT;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->nsid = nsid;
+	ctx->opts = *opts;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	/* The host rate limits are split evenly across the poll groups. */
+	spdk_for_each_channel(subsystem->tgt,
+			      subsystem_ns_sched_count_on_pg,
+			      ctx,
+			      subsystem_ns_sched_count_done);
+
+	return 0;
+}
+
+int
+spdk_nvmf_subsystem_set_ns_sched_host(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				      const char *hostnqn,
+				      const struct spdk_nvmf_ns_sched_host_opts *opts)
+{
+	struct spdk_nvmf_ns *ns;
+	struct spdk_nvmf_ns_sched_host *host;
+	uint32_t i;
+
+	if (!(subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
+	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED)) {
+		return -EBUSY;
+	}
+
+	ns = _spdk_nvmf_subsystem_get_ns(subsystem, nsid);
+	if (ns == NULL) {
+		return -ENOENT;
+	}
+
+	if (strlen(hostnqn) > SPDK_NVMF_NQN_MAX_LEN) {
+		SPDK_ERRLOG("Host NQN %s is too long\n", hostnqn);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < ns->sched_conf.num_hosts; i++) {
+		if (strcmp(ns->sched_conf.hosts[i].hostnqn, hostnqn) == 0) {
+			ns->sched_conf.hosts[i].opts = *opts;
+			return 0;
+		}
+	}
+
+	host = realloc(ns->sched_conf.hosts, (ns->sched_conf.num_hosts + 1) * sizeof(*host));
+	if (host == NULL) {
+		return -ENOMEM;
+	}
+	ns->sched_conf.hosts = host;
+
+	host = &ns->sched_conf.hosts[ns->sched_conf.num_hosts++];
+	snprintf(host->hostnqn, sizeof(host->hostnqn), "%s", hostnqn);
+	host->opts = *opts;
+
+	return 0;
+}
+
+struct subsystem_ns_sched_stats_ctx {
+	struct spdk_nvmf_subsystem *subsystem;
+	uint32_t nsid;
+	struct spdk_nvmf_ns_sched_host_stat *stats;
+	uint32_t num_stats;
+
+	spdk_nvmf_ns_sched_stats_fn cb_fn;
+	void *cb_arg;
+};
+
+static void
+subsystem_ns_sched_stats_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct subsystem_ns_sched_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	ctx->cb_fn(ctx->cb_arg, status, ctx->stats, ctx->num_stats);
+	free(ctx->stats);
+	free(ctx);
+}
+
+static void
+subsystem_ns_sched_stats_on_pg(struct spdk_io_channel_iter *i)
+{
+	struct subsystem_ns_sched_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_nvmf_poll_group *group;
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_ns_sched *sched = NULL;
+	int rc = 0;
+
+	group = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+	sgroup = &group->sgroups[ctx->subsystem->id];
+
+	if (ctx->nsid <= sgroup->num_ns) {
+		sched = sgroup->ns_info[ctx->nsid - 1].sched;
+	}
+
+	if (sched != NULL) {
+		rc = spdk_nvmf_ns_sched_get_stats(sched, &ctx->stats, &ctx->num_stats);
+	}
+
+	spdk_for_each_channel_continue(i, rc);
+}
+
+int
+spdk_nvmf_subsystem_get_ns_sched_stats(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				       spdk_nvmf_ns_sched_stats_fn cb_fn, void *cb_arg)
+{
+	struct subsystem_ns_sched_stats_ctx *ctx;
+
+	if (_spdk_nvmf_subsystem_get_ns(subsystem, nsid) == NULL) {
+		return -ENOENT;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->nsid = nsid;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_for_each_channel(subsystem->tgt,
+			      subsystem_ns_sched_stats_on_pg,
+			      ctx,
+			      subsystem_ns_sched_stats_done);
+
+	return 0;
+}
+
+int
+spdk_nvmf_subsystem_set_ns_cache(struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+				 const struct spdk_nvmf_ns_cache_opts *opts)
+{
+	struct spdk_nvmf_ns_cache_opts cache_opts = *opts;
+	struct spdk_nvmf_ns_cache *cache = NULL;
+	struct spdk_nvmf_ns *ns;
+	uint32_t block_size;
+
+	if (!(subsystem->state == SPDK_NVMF_SUBSYSTEM_INACTIVE ||
+	      subsystem->state == SPDK_NVMF_SUBSYSTEM_PAUSED)) {
+		return -EBUSY;
+	}
+
+	ns = _spdk_nvmf_subsystem_get_ns(subsystem, nsid);
+	if (ns == NULL) {
+		return -ENOENT;
+	}
+
+	if (cache_opts.line_size == 0) {
+		cache_opts.line_size = SPDK_NVMF_NS_CACHE_DEFAULT_LINE_SIZE;
+	}
+
+	block_size = spdk_bdev_get_block_size(ns->bdev);
+	if (cache_opts.line_size % block_size != 0) {
+		SPDK_ERRLOG("Cache line size %" PRIu32 " is not a multiple of the block size %" PRIu32 "\n",
+			    cache_opts.line_size, block_size);
+		return -EINVAL;
+	}
+
+	if (cache_opts.size_mb != 0) {
+		if (cache_opts.size_mb > UINT32_MAX ||
+		    cache_opts.size_mb * 1024 * 1024 < cache_opts.line_size) {
+			SPDK_ERRLOG("Invalid cache size %" PRIu64 " MiB\n", cache_opts.size_mb);
+			return -EINVAL;
+		}
+
+		cache = spdk_nvmf_ns_cache_create(&cache_opts, block_size);
+		if (cache == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	/* Requests still sending data out of the old cache keep it alive */
+	spdk_nvmf_ns_cache_destroy(ns->cache);
+	ns->cache = cache;
+	ns->cache_opts = cache_opts;
+
+	return 0;
+}
+
+void
+spdk_nvmf_ns_get_cache_opts(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_cache_opts *opts)
+{
+	*opts = ns->cache_opts;
+}
+
+int
+spdk_nvmf_ns_get_cache_stats(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_cache_stats *stats)
+{
+	if (ns->cache == NULL) {
+		return -ENOENT;
+	}
+
+	spdk_nvmf_ns_cache_get_stats(ns->cache, stats);
+	return 0;
+}
+
 const char *
 spdk_nvmf_subsystem_get_sn(const struct spdk_nvmf_subsystem *subsystem)
 {
@@ -1278,9 +1961,26 @@ spdk_nvmf_subsystem_gen_cntlid(struct spdk_nvmf_subsystem *subsystem)
 	return 0xFFFF;
 }
 
+static struct spdk_nvmf_ctrlr_slot *
+spdk_nvmf_subsystem_get_ctrlr_slot(struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid)
+{
+	struct spdk_nvmf_ctrlr_slot *page;
+
+	page = __atomic_load_n(&subsystem->ctrlr_slots[cntlid >> SPDK_NVMF_CNTLID_PAGE_SHIFT],
+			       __ATOMIC_ACQUIRE);
+	if (page == NULL) {
+		return NULL;
+	}
+
+	return &page[cntlid & (SPDK_NVMF_CNTLID_PAGE_SIZE - 1)];
+}
+
 int
 spdk_nvmf_subsystem_add_ctrlr(struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf_ctrlr *ctrlr)
 {
+	struct spdk_nvmf_ctrlr_slot *page, *slot;
+	uint32_t page_idx;
+
 	ctrlr->cntlid = spdk_nvmf_subsystem_gen_cntlid(subsystem);
 	if (ctrlr->cntlid == 0xFFFF) {
 		/* Unable to get a cntlid */
@@ -1288,6 +1988,23 @@ spdk_nvmf_subsystem_add_ctrlr(struct spdk_nvmf_subsystem *subsystem, struct spdk
 		return -EBUSY;
 	}
 
+	page_idx = ctrlr->cntlid >> SPDK_NVMF_CNTLID_PAGE_SHIFT;
+	if (subsystem->ctrlr_slots[page_idx] == NULL) {
+		page = calloc(SPDK_NVMF_CNTLID_PAGE_SIZE, sizeof(*page));
+		if (page == NULL) {
+			SPDK_ERRLOG("Unable to allocate controller slots\n");
+			return -ENOMEM;
+		}
+		__atomic_store_n(&subsystem->ctrlr_slots[page_idx], page, __ATOMIC_RELEASE);
+	}
+
+	slot = spdk_nvmf_subsystem_get_ctrlr_slot(subsystem, ctrlr->cntlid);
+	assert(slot != NULL);
+
+	/* Publish the thread before the controller so lookups never see a stale one. */
+	__atomic_store_n(&slot->thread, ctrlr->thread, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->ctrlr, ctrlr, __ATOMIC_RELEASE);
+
 	TAILQ_INSERT_TAIL(&subsystem->ctrlrs, ctrlr, link);
 
 	return 0;
@@ -1297,22 +2014,49 @@ void
 spdk_nvmf_subsystem_remove_ctrlr(struct spdk_nvmf_subsystem *subsystem,
 				 struct spdk_nvmf_ctrlr *ctrlr)
 {
+	struct spdk_nvmf_ctrlr_slot *slot;
+
 	assert(subsystem == ctrlr->subsys);
+
+	slot = spdk_nvmf_subsystem_get_ctrlr_slot(subsystem, ctrlr->cntlid);
+	if (slot != NULL && slot->ctrlr == ctrlr) {
+		__atomic_store_n(&slot->ctrlr, NULL, __ATOMIC_RELEASE);
+	}
+
 	TAILQ_REMOVE(&subsystem->ctrlrs, ctrlr, link);
 }
 
 struct spdk_nvmf_ctrlr *
 spdk_nvmf_subsystem_get_ctrlr(struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid)
 {
+	struct spdk_nvmf_ctrlr_slot *slot;
+
+	slot = spdk_nvmf_subsystem_get_ctrlr_slot(subsystem, cntlid);
+	if (slot == NULL) {
+		return NULL;
+	}
+
+	return __atomic_load_n(&slot->ctrlr, __ATOMIC_ACQUIRE);
+}
+
+struct spdk_nvmf_ctrlr *
+spdk_nvmf_subsystem_lookup_ctrlr(struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid,
+				 struct spdk_thread **thread)
+{
+	struct spdk_nvmf_ctrlr_slot *slot;
 	struct spdk_nvmf_ctrlr *ctrlr;
 
-	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
-		if (ctrlr->cntlid == cntlid) {
-			return ctrlr;
-		}
+	slot = spdk_nvmf_subsystem_get_ctrlr_slot(subsystem, cntlid);
+	if (slot == NULL) {
+		return NULL;
 	}
 
-	return NULL;
+	ctrlr = __atomic_load_n(&slot->ctrlr, __ATOMIC_ACQUIRE);
+	if (ctrlr != NULL) {
+		*thread = __atomic_load_n(&slot->thread, __ATOMIC_RELAXED);
+	}
+
+	return ctrlr;
 }
 
 uint32_t
@@ -2379,6 +3123,11 @@ spdk_nvmf_ns_reservation_request(void *ctx)
 
 	/* update reservation information to subsystem's poll group */
 	if (update_sgroup) {
+		if (ns->cache != NULL) {
+			/* The namespace changed hands, the new holder may write through other paths */
+			spdk_nvmf_ns_cache_purge(ns->cache);
+		}
+
 		update_ctx = calloc(1, sizeof(*update_ctx));
 		if (update_ctx == NULL) {
 			SPDK_ERRLOG("Can't alloc subsystem poll group update context\n");
@@ -32,6 +32,7 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/copy_engine.h"
 #include "spdk/crc32.h"
 #include "spdk/endian.h"
 #include "spdk/assert.h"
@@ -56,6 +57,7 @@
 #define NVMF_TCP_QPAIR_MAX_C2H_PDU_NUM  64  /* Maximal c2h_data pdu number for ecah tqpair */
 #define SPDK_NVMF_TCP_DEFAULT_MAX_SOCK_PRIORITY 6
 #define SPDK_NVMF_TCP_RECV_BUF_SIZE_FACTOR 4
+#define NVMF_TCP_DIGEST_CTX_NUM 256  /* Maximal number of offloaded data digests per poll group */
 
 /* spdk nvmf related structure */
 enum spdk_nvmf_tcp_req_state {
@@ -69,6 +71,9 @@ enum spdk_nvmf_tcp_req_state {
 	/* The request is queued until a data buffer is available. */
 	TCP_REQUEST_STATE_NEED_BUFFER,
 
+	/* The request is waiting for the bdev to provide the buffers for its data. */
+	TCP_REQUEST_STATE_AWAITING_ZCOPY_START,
+
 	/* The request is currently transferring data from the host to the controller. */
 	TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER,
 
@@ -118,6 +123,7 @@ static const char *spdk_nvmf_tcp_term_req_fes_str[] = {
 #define TRACE_TCP_FLUSH_WRITEBUF_START					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_TCP, 0x9)
 #define TRACE_TCP_FLUSH_WRITEBUF_DONE					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_TCP, 0xA)
 #define TRACE_TCP_READ_FROM_SOCKET_DONE					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_TCP, 0xB)
+#define TRACE_TCP_REQUEST_STATE_AWAIT_ZCOPY_START			SPDK_TPOINT_ID(TRACE_GROUP_NVMF_TCP, 0xC)
 
 SPDK_TRACE_REGISTER_FN(nvmf_tcp_trace, "nvmf_tcp", TRACE_GROUP_NVMF_TCP)
 {
@@ -128,6 +134,9 @@ SPDK_TRACE_REGISTER_FN(nvmf_tcp_trace, "nvmf_tcp", TRACE_GROUP_NVMF_TCP)
 	spdk_trace_register_description("TCP_REQ_NEED_BUFFER",
 					TRACE_TCP_REQUEST_STATE_NEED_BUFFER,
 					OWNER_NONE, OBJECT_NVMF_TCP_IO, 0, 1, "");
+	spdk_trace_register_description("TCP_REQ_AWAIT_ZCOPY",
+					TRACE_TCP_REQUEST_STATE_AWAIT_ZCOPY_START,
+					OWNER_NONE, OBJECT_NVMF_TCP_IO, 0, 1, "");
 	spdk_trace_register_description("TCP_REQ_TX_H_TO_C",
 					TRACE_TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER,
 					OWNER_NONE, OBJECT_NVMF_TCP_IO, 0, 1, "");
@@ -266,14 +275,38 @@ struct spdk_nvmf_tcp_qpair {
 	 */
 	struct spdk_poller			*timeout_poller;
 
+	/* Number of data digests being calculated by the copy engine */
+	uint32_t				num_pending_digests;
+	/* The tqpair is freed once the pending digests complete */
+	bool					destroy_pending;
+
 	TAILQ_ENTRY(spdk_nvmf_tcp_qpair)	link;
 };
 
+struct spdk_nvmf_tcp_digest_ctx {
+	struct spdk_nvmf_tcp_poll_group		*tgroup;
+	struct spdk_nvmf_tcp_qpair		*tqpair;
+	struct nvme_tcp_pdu			*pdu;
+	uint32_t				crc32c;
+	TAILQ_ENTRY(spdk_nvmf_tcp_digest_ctx)	link;
+
+	/* Copy engine task of spdk_copy_task_size() bytes */
+	uint64_t				copy_task[0];
+};
+
 struct spdk_nvmf_tcp_poll_group {
 	struct spdk_nvmf_transport_poll_group	group;
 	struct spdk_sock_group			*sock_group;
 
 	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	qpairs;
+
+	/* Copy engine channel used to calculate data digests, NULL if unavailable */
+	struct spdk_io_channel			*copy_ch;
+	uint8_t					*digest_ctxs;
+	TAILQ_HEAD(, spdk_nvmf_tcp_digest_ctx)	free_digest_ctxs;
+	uint32_t				num_pending_digests;
+	/* The tgroup is freed once the pending digests complete */
+	bool					destroy_pending;
 };
 
 struct spdk_nvmf_tcp_port {
@@ -294,6 +327,8 @@ struct spdk_nvmf_tcp_transport {
 static bool spdk_nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 				      struct spdk_nvmf_tcp_req *tcp_req);
 static void spdk_nvmf_tcp_handle_pending_c2h_data_queue(struct spdk_nvmf_tcp_qpair *tqpair);
+static void spdk_nvmf_tcp_sock_cb(void *arg, struct spdk_sock_group *group,
+				  struct spdk_sock *sock);
 
 static void
 spdk_nvmf_tcp_req_set_state(struct spdk_nvmf_tcp_req *tcp_req,
@@ -465,16 +500,10 @@ nvmf_tcp_dump_qpair_req_contents(struct spdk_nvmf_tcp_qpair *tqpair)
 }
 
 static void
-spdk_nvmf_tcp_qpair_destroy(struct spdk_nvmf_tcp_qpair *tqpair)
+spdk_nvmf_tcp_qpair_free(struct spdk_nvmf_tcp_qpair *tqpair)
 {
 	int err = 0;
 
-	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "enter\n");
-
-	spdk_poller_unregister(&tqpair->flush_poller);
-	spdk_sock_close(&tqpair->sock);
-	spdk_nvmf_tcp_cleanup_all_states(tqpair);
-
 	if (tqpair->free_pdu_num != (tqpair->max_queue_depth + NVMF_TCP_QPAIR_MAX_C2H_PDU_NUM)) {
 		SPDK_ERRLOG("tqpair(%p) free pdu pool num is %u but should be %u\n", tqpair,
 			    tqpair->free_pdu_num,
@@ -506,6 +535,23 @@ spdk_nvmf_tcp_qpair_destroy(struct spdk_nvmf_tcp_qpair *tqpair)
 	spdk_free(tqpair->bufs);
 	free(tqpair->pdu_recv_buf.buf);
 	free(tqpair);
+}
+
+static void
+spdk_nvmf_tcp_qpair_destroy(struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "enter\n");
+
+	spdk_poller_unregister(&tqpair->flush_poller);
+	spdk_sock_close(&tqpair->sock);
+	spdk_nvmf_tcp_cleanup_all_states(tqpair);
+
+	if (tqpair->num_pending_digests > 0) {
+		/* The copy engine still references the PDU buffers of this tqpair. */
+		tqpair->destroy_pending = true;
+	} else {
+		spdk_nvmf_tcp_qpair_free(tqpair);
+	}
 	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "Leave\n");
 }
 
@@ -527,7 +573,6 @@ spdk_nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 {
 	struct spdk_nvmf_tcp_transport *ttransport;
 	uint32_t sge_count;
-	uint32_t min_shared_buffers;
 
 	ttransport = calloc(1, sizeof(*ttransport));
 	if (!ttransport) {
@@ -577,12 +622,7 @@ spdk_nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		return NULL;
 	}
 
-	min_shared_buffers = spdk_thread_get_count() * opts->buf_cache_size;
-	if (min_shared_buffers > opts->num_shared_buffers) {
-		SPDK_ERRLOG("There are not enough buffers to satisfy"
-			    "per-poll group caches for each thread. (%" PRIu32 ")"
-			    "supplied. (%" PRIu32 ") required\n", opts->num_shared_buffers, min_shared_buffers);
-		SPDK_ERRLOG("Please specify a larger number of shared buffers\n");
+	if (spdk_nvmf_transport_calc_buf_cache_max(opts, &ttransport->transport.buf_cache_max) != 0) {
 		spdk_nvmf_tcp_destroy(&ttransport->transport);
 		return NULL;
 	}
@@ -795,9 +835,11 @@ spdk_nvmf_tcp_qpair_flush_pdus_internal(struct spdk_nvmf_tcp_qpair *tqpair)
 
 	/*
 	 * Build up a list of iovecs for the first few PDUs in the
-	 *  tqpair 's send_queue.
+	 *  tqpair 's send_queue. PDUs have to go out in order, so stop at
+	 *  the first one whose data digest is still being calculated.
 	 */
-	while (pdu != NULL && ((array_size - iovcnt) >= (2 + (int)pdu->data_iovcnt))) {
+	while (pdu != NULL && !pdu->ddgst_pending &&
+	       ((array_size - iovcnt) >= (2 + (int)pdu->data_iovcnt))) {
 		iovcnt += nvme_tcp_build_iovs(&iovs[iovcnt],
 					      array_size - iovcnt,
 					      pdu,
@@ -808,6 +850,11 @@ spdk_nvmf_tcp_qpair_flush_pdus_internal(struct spdk_nvmf_tcp_qpair *tqpair)
 		pdu = TAILQ_NEXT(pdu, tailq);
 	}
 
+	if (iovcnt == 0) {
+		/* The digest completion will flush the send_queue again. */
+		return 0;
+	}
+
 	spdk_trace_record(TRACE_TCP_FLUSH_WRITEBUF_START, 0, total_length, 0, iovcnt);
 
 	bytes = spdk_sock_writev(tqpair->sock, iovs, iovcnt);
@@ -853,7 +900,8 @@ spdk_nvmf_tcp_qpair_flush_pdus_internal(struct spdk_nvmf_tcp_qpair *tqpair)
 		spdk_nvmf_tcp_pdu_put(tqpair, pdu);
 	}
 
-	return TAILQ_EMPTY(&tqpair->send_queue) ? 0 : 1;
+	pdu = TAILQ_FIRST(&tqpair->send_queue);
+	return (pdu == NULL || pdu->ddgst_pending) ? 0 : 1;
 }
 
 static int
@@ -894,6 +942,87 @@ spdk_nvmf_tcp_qpair_flush_pdus(void *_tqpair)
 	return -1;
 }
 
+static void spdk_nvmf_tcp_poll_group_free(struct spdk_nvmf_tcp_poll_group *tgroup);
+static void spdk_nvmf_tcp_pdu_payload_digest_done(struct spdk_nvmf_tcp_qpair *tqpair,
+		uint32_t crc32c);
+
+static void
+spdk_nvmf_tcp_digest_done(void *ref, int status)
+{
+	struct spdk_nvmf_tcp_poll_group *tgroup;
+	struct spdk_nvmf_tcp_digest_ctx *ctx;
+	struct spdk_nvmf_tcp_qpair *tqpair;
+	struct nvme_tcp_pdu *pdu;
+	uint32_t crc32c;
+
+	ctx = SPDK_CONTAINEROF(ref, struct spdk_nvmf_tcp_digest_ctx, copy_task);
+	tgroup = ctx->tgroup;
+	tqpair = ctx->tqpair;
+	pdu = ctx->pdu;
+	crc32c = ctx->crc32c;
+
+	TAILQ_INSERT_HEAD(&tgroup->free_digest_ctxs, ctx, link);
+	tgroup->num_pending_digests--;
+	tqpair->num_pending_digests--;
+
+	if (spdk_unlikely(tqpair->destroy_pending)) {
+		if (tqpair->num_pending_digests == 0) {
+			spdk_nvmf_tcp_qpair_free(tqpair);
+		}
+	} else if (spdk_unlikely(status != 0)) {
+		SPDK_ERRLOG("Data digest calculation failed on tqpair=%p, rc %d\n", tqpair, status);
+		tqpair->state = NVME_TCP_QPAIR_STATE_EXITING;
+		spdk_nvmf_qpair_disconnect(&tqpair->qpair, NULL, NULL);
+	} else if (pdu == &tqpair->pdu_in_progress) {
+		spdk_nvmf_tcp_pdu_payload_digest_done(tqpair, nvme_tcp_pdu_finish_data_digest(pdu, crc32c));
+	} else {
+		MAKE_DIGEST_WORD(pdu->data_digest, nvme_tcp_pdu_finish_data_digest(pdu, crc32c));
+		pdu->ddgst_pending = false;
+		spdk_nvmf_tcp_qpair_flush_pdus(tqpair);
+	}
+
+	if (spdk_unlikely(tgroup->destroy_pending) && tgroup->num_pending_digests == 0) {
+		spdk_nvmf_tcp_poll_group_free(tgroup);
+	}
+}
+
+/*
+ * Hand the data digest calculation of a PDU over to the copy engine, which
+ * batches the digests of all PDUs submitted during this poll. Returns false
+ * if the digest has to be calculated in-line.
+ */
+static bool
+spdk_nvmf_tcp_pdu_submit_data_digest(struct spdk_nvmf_tcp_qpair *tqpair,
+				     struct nvme_tcp_pdu *pdu)
+{
+	struct spdk_nvmf_tcp_poll_group *tgroup = tqpair->group;
+	struct spdk_nvmf_tcp_digest_ctx *ctx;
+	int rc;
+
+	if (tgroup == NULL || tgroup->copy_ch == NULL || pdu->dif_ctx != NULL) {
+		return false;
+	}
+
+	ctx = TAILQ_FIRST(&tgroup->free_digest_ctxs);
+	if (ctx == NULL) {
+		return false;
+	}
+
+	ctx->tqpair = tqpair;
+	ctx->pdu = pdu;
+	rc = spdk_copy_submit_crc32c((struct spdk_copy_task *)ctx->copy_task, tgroup->copy_ch,
+				     &ctx->crc32c, pdu->data_iov, pdu->data_iovcnt, SPDK_CRC32C_XOR,
+				     spdk_nvmf_tcp_digest_done);
+	if (rc != 0) {
+		return false;
+	}
+
+	TAILQ_REMOVE(&tgroup->free_digest_ctxs, ctx, link);
+	tgroup->num_pending_digests++;
+	tqpair->num_pending_digests++;
+	return true;
+}
+
 static void
 spdk_nvmf_tcp_qpair_write_pdu(struct spdk_nvmf_tcp_qpair *tqpair,
 			      struct nvme_tcp_pdu *pdu,
@@ -920,8 +1049,12 @@ spdk_nvmf_tcp_qpair_write_pdu(struct spdk_nvmf_tcp_qpair *tqpair,
 
 	/* Data Digest */
 	if (pdu->data_len > 0 && enable_digest && tqpair->host_ddgst_enable) {
-		crc32c = nvme_tcp_pdu_calc_data_digest(pdu);
-		MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+		if (spdk_nvmf_tcp_pdu_submit_data_digest(tqpair, pdu)) {
+			pdu->ddgst_pending = true;
+		} else {
+			crc32c = nvme_tcp_pdu_calc_data_digest(pdu);
+			MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+		}
 	}
 
 	pdu->cb_fn = cb_fn;
@@ -972,6 +1105,8 @@ spdk_nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair, uint16
 		/* Set the cmdn and rsp */
 		tcp_req->req.rsp = (union nvmf_c2h_msg *)&tcp_req->rsp;
 		tcp_req->req.cmd = (union nvmf_h2c_msg *)&tcp_req->cmd;
+		/* Read data is only sent from the iov, and released in the COMPLETED state */
+		tcp_req->req.cache_zcopy = true;
 
 		/* Initialize request state to FREE */
 		tcp_req->state = TCP_REQUEST_STATE_FREE;
@@ -1027,6 +1162,7 @@ spdk_nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair, uint16
 			/* Set the cmdn and rsp */
 			tcp_req->req.rsp = (union nvmf_c2h_msg *)&tcp_req->rsp;
 			tcp_req->req.cmd = (union nvmf_h2c_msg *)&tcp_req->cmd;
+			tcp_req->req.cache_zcopy = true;
 
 			/* Initialize request state to FREE */
 			tcp_req->state = TCP_REQUEST_STATE_FREE;
@@ -1186,6 +1322,42 @@ spdk_nvmf_tcp_discover(struct spdk_nvmf_transport *transport,
 	entry->tsas.tcp.sectype = SPDK_NVME_TCP_SECURITY_NONE;
 }
 
+static size_t
+spdk_nvmf_tcp_digest_ctx_size(void)
+{
+	return sizeof(struct spdk_nvmf_tcp_digest_ctx) + SPDK_CEIL_DIV(spdk_copy_task_size(), 8) * 8;
+}
+
+static void
+spdk_nvmf_tcp_poll_group_init_digest_ctxs(struct spdk_nvmf_tcp_poll_group *tgroup)
+{
+	struct spdk_nvmf_tcp_digest_ctx *ctx;
+	size_t ctx_size;
+	int i;
+
+	TAILQ_INIT(&tgroup->free_digest_ctxs);
+
+	/* Without a copy engine, the data digests are calculated in-line. */
+	tgroup->copy_ch = spdk_copy_engine_get_io_channel();
+	if (tgroup->copy_ch == NULL) {
+		return;
+	}
+
+	ctx_size = spdk_nvmf_tcp_digest_ctx_size();
+	tgroup->digest_ctxs = calloc(NVMF_TCP_DIGEST_CTX_NUM, ctx_size);
+	if (tgroup->digest_ctxs == NULL) {
+		spdk_put_io_channel(tgroup->copy_ch);
+		tgroup->copy_ch = NULL;
+		return;
+	}
+
+	for (i = 0; i < NVMF_TCP_DIGEST_CTX_NUM; i++) {
+		ctx = (struct spdk_nvmf_tcp_digest_ctx *)(tgroup->digest_ctxs + i * ctx_size);
+		ctx->tgroup = tgroup;
+		TAILQ_INSERT_TAIL(&tgroup->free_digest_ctxs, ctx, link);
+	}
+}
+
 static struct spdk_nvmf_transport_poll_group *
 spdk_nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport)
 {
@@ -1202,6 +1374,7 @@ spdk_nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport)
 	}
 
 	TAILQ_INIT(&tgroup->qpairs);
+	spdk_nvmf_tcp_poll_group_init_digest_ctxs(tgroup);
 
 	return &tgroup->group;
 
@@ -1226,6 +1399,16 @@ spdk_nvmf_tcp_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 	return NULL;
 }
 
+static void
+spdk_nvmf_tcp_poll_group_free(struct spdk_nvmf_tcp_poll_group *tgroup)
+{
+	if (tgroup->copy_ch != NULL) {
+		spdk_put_io_channel(tgroup->copy_ch);
+	}
+	free(tgroup->digest_ctxs);
+	free(tgroup);
+}
+
 static void
 spdk_nvmf_tcp_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
 {
@@ -1234,7 +1417,11 @@ spdk_nvmf_tcp_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
 	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
 	spdk_sock_group_close(&tgroup->sock_group);
 
-	free(tgroup);
+	if (tgroup->num_pending_digests > 0) {
+		tgroup->destroy_pending = true;
+	} else {
+		spdk_nvmf_tcp_poll_group_free(tgroup);
+	}
 }
 
 static inline void
@@ -1278,6 +1465,7 @@ spdk_nvmf_tcp_qpair_set_recv_state(struct spdk_nvmf_tcp_qpair *tqpair,
 	case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH:
 	case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH:
 	case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD:
+	case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_DDGST:
 		break;
 	case NVME_TCP_PDU_RECV_STATE_ERROR:
 	case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY:
@@ -1655,31 +1843,10 @@ spdk_nvmf_tcp_h2c_term_req_payload_handle(struct spdk_nvmf_tcp_qpair *tqpair,
 }
 
 static void
-spdk_nvmf_tcp_pdu_payload_handle(struct spdk_nvmf_tcp_qpair *tqpair)
+spdk_nvmf_tcp_pdu_payload_process(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu)
 {
-	int rc = 0;
-	struct nvme_tcp_pdu *pdu;
-	uint32_t crc32c, error_offset = 0;
-	enum spdk_nvme_tcp_term_req_fes fes;
 	struct spdk_nvmf_tcp_transport *ttransport;
 
-	assert(tqpair->recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD);
-	pdu = &tqpair->pdu_in_progress;
-
-	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "enter\n");
-	/* check data digest if need */
-	if (pdu->ddgst_enable) {
-		crc32c = nvme_tcp_pdu_calc_data_digest(pdu);
-		rc = MATCH_DIGEST_WORD(pdu->data_digest, crc32c);
-		if (rc == 0) {
-			SPDK_ERRLOG("Data digest error on tqpair=(%p) with pdu=%p\n", tqpair, pdu);
-			fes = SPDK_NVME_TCP_TERM_REQ_FES_HDGST_ERROR;
-			spdk_nvmf_tcp_send_c2h_term_req(tqpair, pdu, fes, error_offset);
-			return;
-
-		}
-	}
-
 	ttransport = SPDK_CONTAINEROF(tqpair->qpair.transport, struct spdk_nvmf_tcp_transport, transport);
 	switch (pdu->hdr->common.pdu_type) {
 	case SPDK_NVME_TCP_PDU_TYPE_CAPSULE_CMD:
@@ -1700,6 +1867,63 @@ spdk_nvmf_tcp_pdu_payload_handle(struct spdk_nvmf_tcp_qpair *tqpair)
 	}
 }
 
+static bool
+spdk_nvmf_tcp_pdu_check_data_digest(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu,
+				    uint32_t crc32c)
+{
+	uint32_t error_offset = 0;
+	enum spdk_nvme_tcp_term_req_fes fes;
+
+	if (MATCH_DIGEST_WORD(pdu->data_digest, crc32c) == 0) {
+		SPDK_ERRLOG("Data digest error on tqpair=(%p) with pdu=%p\n", tqpair, pdu);
+		fes = SPDK_NVME_TCP_TERM_REQ_FES_HDGST_ERROR;
+		spdk_nvmf_tcp_send_c2h_term_req(tqpair, pdu, fes, error_offset);
+		return false;
+	}
+
+	return true;
+}
+
+static void
+spdk_nvmf_tcp_pdu_payload_digest_done(struct spdk_nvmf_tcp_qpair *tqpair, uint32_t crc32c)
+{
+	struct nvme_tcp_pdu *pdu = &tqpair->pdu_in_progress;
+
+	assert(tqpair->recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_DDGST);
+
+	if (spdk_nvmf_tcp_pdu_check_data_digest(tqpair, pdu, crc32c)) {
+		spdk_nvmf_tcp_pdu_payload_process(tqpair, pdu);
+	}
+
+	/* Resume with whatever the receive buffer still holds. */
+	spdk_nvmf_tcp_sock_cb(tqpair, tqpair->group->sock_group, tqpair->sock);
+}
+
+static void
+spdk_nvmf_tcp_pdu_payload_handle(struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	struct nvme_tcp_pdu *pdu;
+
+	assert(tqpair->recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD);
+	pdu = &tqpair->pdu_in_progress;
+
+	SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "enter\n");
+	/* check data digest if need */
+	if (pdu->ddgst_enable) {
+		if (spdk_nvmf_tcp_pdu_submit_data_digest(tqpair, pdu)) {
+			/* The PDU is processed once the digest is verified. */
+			spdk_nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_DDGST);
+			return;
+		}
+
+		if (!spdk_nvmf_tcp_pdu_check_data_digest(tqpair, pdu, nvme_tcp_pdu_calc_data_digest(pdu))) {
+			return;
+		}
+	}
+
+	spdk_nvmf_tcp_pdu_payload_process(tqpair, pdu);
+}
+
 static void
 spdk_nvmf_tcp_send_icresp_complete(void *cb_arg)
 {
@@ -2096,6 +2320,9 @@ spdk_nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 			/* All of this PDU has now been read from the socket. */
 			spdk_nvmf_tcp_pdu_payload_handle(tqpair);
 			break;
+		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_DDGST:
+			/* Don't read the next PDU before the payload of this one is processed. */
+			return NVME_TCP_PDU_IN_PROGRESS;
 		case NVME_TCP_PDU_RECV_STATE_ERROR:
 			/* Check whether the connection is closed. Each time, we only read 1 byte every time */
 			rc = nvme_tcp_read_data(tqpair->sock, 1, (void *)&pdu->hdr->common);
@@ -2486,7 +2713,7 @@ spdk_nvmf_tcp_pdu_set_buf_from_req(struct spdk_nvmf_tcp_qpair *tqpair,
 {
 	struct nvme_tcp_pdu *pdu;
 
-	if (tcp_req->req.data_from_pool) {
+	if (tcp_req->req.data_from_pool || tcp_req->req.zcopy_bdev_io != NULL) {
 		SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "Will send r2t for tcp_req(%p) on tqpair=%p\n", tcp_req, tqpair);
 		tcp_req->next_expected_r2t_offset = 0;
 		spdk_nvmf_tcp_send_r2t_pdu(tqpair, tcp_req);
@@ -2520,6 +2747,66 @@ spdk_nvmf_tcp_set_incapsule_data(struct spdk_nvmf_tcp_qpair *tqpair,
 	}
 }
 
+static void
+spdk_nvmf_tcp_req_zcopy_start_done(struct spdk_nvmf_request *req, int status)
+{
+	struct spdk_nvmf_tcp_req	*tcp_req;
+	struct spdk_nvmf_tcp_qpair	*tqpair;
+	struct spdk_nvmf_tcp_transport	*ttransport;
+
+	tcp_req = SPDK_CONTAINEROF(req, struct spdk_nvmf_tcp_req, req);
+	tqpair = SPDK_CONTAINEROF(req->qpair, struct spdk_nvmf_tcp_qpair, qpair);
+	ttransport = SPDK_CONTAINEROF(req->qpair->transport, struct spdk_nvmf_tcp_transport, transport);
+
+	assert(tcp_req->state == TCP_REQUEST_STATE_AWAITING_ZCOPY_START);
+
+	if (spdk_unlikely(status != 0)) {
+		SPDK_DEBUGLOG(SPDK_LOG_NVMF_TCP, "zcopy start failed (%d) for tcp_req(%p), use shared buffers\n",
+			      status, tcp_req);
+		spdk_nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_NEED_BUFFER);
+		STAILQ_INSERT_TAIL(&tqpair->group->group.pending_buf_queue, req, buf_link);
+	} else {
+		req->data_from_pool = false;
+		spdk_nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER);
+		spdk_nvmf_tcp_pdu_set_buf_from_req(tqpair, tcp_req);
+	}
+
+	spdk_nvmf_tcp_req_process(ttransport, tcp_req);
+}
+
+/*
+ * Let the H2C data of a write land directly in the buffers of the bdev, so that
+ * it is not copied out of a shared buffer again. In-capsule data is already
+ * sitting in the receive buffer by the time the bdev could provide its buffers,
+ * so only data transferred through R2T is placed this way.
+ */
+static int
+spdk_nvmf_tcp_req_zcopy_start(struct spdk_nvmf_tcp_transport *ttransport,
+			      struct spdk_nvmf_tcp_req *tcp_req)
+{
+	struct spdk_nvme_sgl_descriptor *sgl = &tcp_req->req.cmd->nvme_cmd.dptr.sgl1;
+	int rc;
+
+	if (tcp_req->req.xfer != SPDK_NVME_DATA_HOST_TO_CONTROLLER ||
+	    tcp_req->has_incapsule_data || tcp_req->dif_insert_or_strip ||
+	    sgl->generic.type != SPDK_NVME_SGL_TYPE_TRANSPORT_DATA_BLOCK ||
+	    sgl->unkeyed.subtype != SPDK_NVME_SGL_SUBTYPE_TRANSPORT ||
+	    sgl->unkeyed.length > ttransport->transport.opts.max_io_size) {
+		return -EINVAL;
+	}
+
+	tcp_req->req.length = sgl->unkeyed.length;
+	spdk_nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_AWAITING_ZCOPY_START);
+
+	rc = spdk_nvmf_request_zcopy_start(&tcp_req->req, spdk_nvmf_tcp_req_zcopy_start_done);
+	if (rc != 0) {
+		tcp_req->req.length = 0;
+		spdk_nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_NEW);
+	}
+
+	return rc;
+}
+
 static bool
 spdk_nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 			  struct spdk_nvmf_tcp_req *tcp_req)
@@ -2575,6 +2862,10 @@ spdk_nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 				spdk_nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
 			}
 
+			if (spdk_nvmf_tcp_req_zcopy_start(ttransport, tcp_req) == 0) {
+				break;
+			}
+
 			spdk_nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_NEED_BUFFER);
 			STAILQ_INSERT_TAIL(&group->pending_buf_queue, &tcp_req->req, buf_link);
 			break;
@@ -2620,6 +2911,12 @@ spdk_nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 
 			spdk_nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_READY_TO_EXECUTE);
 			break;
+		case TCP_REQUEST_STATE_AWAITING_ZCOPY_START:
+			spdk_trace_record(TRACE_TCP_REQUEST_STATE_AWAIT_ZCOPY_START, 0, 0, (uintptr_t)tcp_req, 0);
+			/* The zcopy start completion must kick the request into
+			 * TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER or
+			 * TCP_REQUEST_STATE_NEED_BUFFER to escape this state. */
+			break;
 		case TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER:
 			spdk_trace_record(TRACE_TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER, 0, 0,
 					  (uintptr_t)tcp_req, 0);
@@ -2666,9 +2963,14 @@ spdk_nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 			break;
 		case TCP_REQUEST_STATE_COMPLETED:
 			spdk_trace_record(TRACE_TCP_REQUEST_STATE_COMPLETED, 0, 0, (uintptr_t)tcp_req, 0);
+			/* Point the iov back at the request's own buffers before they are freed */
+			spdk_nvmf_ns_cache_request_release(&tcp_req->req);
 			if (tcp_req->req.data_from_pool) {
 				spdk_nvmf_request_free_buffers(&tcp_req->req, group, &ttransport->transport,
 							       tcp_req->req.iovcnt);
+			} else if (spdk_unlikely(tcp_req->req.zcopy_bdev_io != NULL)) {
+				/* The request was dropped before it could be executed */
+				spdk_nvmf_request_zcopy_release(&tcp_req->req);
 			}
 			tcp_req->req.length = 0;
 			tcp_req->req.iovcnt = 0;
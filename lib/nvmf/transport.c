@@ -55,6 +55,12 @@ static const struct spdk_nvmf_transport_ops *const g_transport_ops[] = {
 #define NUM_TRANSPORTS (SPDK_COUNTOF(g_transport_ops))
 #define MAX_MEMPOOL_NAME_LENGTH 40
 
+/* Number of buffer requests after which the size of a poll group's buffer cache is revisited */
+#define NVMF_BUF_CACHE_ADJUST_INTERVAL 1024
+
+/* Period at which the buffer cache of a poll group is revisited regardless of its load */
+#define NVMF_BUF_CACHE_ADJUST_PERIOD_US 1000000
+
 static inline const struct spdk_nvmf_transport_ops *
 spdk_nvmf_get_transport_ops(enum spdk_nvme_transport_type type)
 {
@@ -79,14 +85,233 @@ spdk_nvmf_get_transport_type(struct spdk_nvmf_transport *transport)
 	return transport->ops->type;
 }
 
+static void
+spdk_nvmf_transport_free_data_buf_pools(struct spdk_nvmf_transport *transport)
+{
+	uint32_t i;
+
+	if (transport->socket_data_buf_pools == NULL) {
+		spdk_mempool_free(transport->data_buf_pool);
+		transport->data_buf_pool = NULL;
+		return;
+	}
+
+	for (i = 0; i < transport->num_socket_ids; i++) {
+		spdk_mempool_free(transport->socket_data_buf_pools[i]);
+	}
+	free(transport->socket_data_buf_pools);
+	transport->socket_data_buf_pools = NULL;
+	transport->data_buf_pool = NULL;
+}
+
+/*
+ * Count the cores of the application on each NUMA socket, indexed by socket id.
+ *  Cores without a known socket aren't counted.
+ */
+static uint32_t *
+spdk_nvmf_transport_get_socket_cores(uint32_t *num_socket_ids, uint32_t *num_sockets)
+{
+	uint32_t core, socket_id, *socket_cores;
+
+	*num_socket_ids = 0;
+	*num_sockets = 0;
+
+	SPDK_ENV_FOREACH_CORE(core) {
+		socket_id = spdk_env_get_socket_id(core);
+		if (socket_id != (uint32_t)SPDK_ENV_SOCKET_ID_ANY) {
+			*num_socket_ids = spdk_max(*num_socket_ids, socket_id + 1);
+		}
+	}
+
+	socket_cores = calloc(spdk_max(*num_socket_ids, 1), sizeof(*socket_cores));
+	if (socket_cores == NULL) {
+		return NULL;
+	}
+
+	SPDK_ENV_FOREACH_CORE(core) {
+		socket_id = spdk_env_get_socket_id(core);
+		if (socket_id < *num_socket_ids) {
+			if (socket_cores[socket_id]++ == 0) {
+				(*num_sockets)++;
+			}
+		}
+	}
+
+	return socket_cores;
+}
+
+static int
+spdk_nvmf_transport_fit_buf_cache(const struct spdk_nvmf_transport_opts *opts,
+				  uint32_t pool_size, uint32_t num_groups, uint32_t *buf_cache_max)
+{
+	uint64_t min_shared_buffers;
+
+	if (num_groups == 0) {
+		return 0;
+	}
+
+	min_shared_buffers = (uint64_t)num_groups * opts->buf_cache_size;
+	if (min_shared_buffers > pool_size) {
+		SPDK_ERRLOG("There are not enough buffers to satisfy "
+			    "per-poll group caches for each thread. (%" PRIu32 ") "
+			    "supplied per pool. (%" PRIu64 ") required\n", pool_size, min_shared_buffers);
+		SPDK_ERRLOG("Please specify a larger number of shared buffers\n");
+		return -EINVAL;
+	}
+
+	/* The caches of all the poll groups sharing the pool have to fit in it at their largest */
+	*buf_cache_max = spdk_min(*buf_cache_max, pool_size / num_groups);
+	return 0;
+}
+
+/*
+ * Poll groups only take buffers from the pool of their own socket, so the pool of
+ *  each socket has to hold the caches of all the poll groups running there. Caches
+ *  normally may grow up to twice buf_cache_size, the limit is lowered as needed to
+ *  keep them within their pool.
+ */
+int
+spdk_nvmf_transport_calc_buf_cache_max(const struct spdk_nvmf_transport_opts *opts,
+				       uint32_t *buf_cache_max)
+{
+	uint32_t *socket_cores, num_socket_ids, num_sockets, socket_id, pool_size;
+	int rc = 0;
+
+	*buf_cache_max = 2 * opts->buf_cache_size;
+	if (opts->buf_cache_size == 0) {
+		return 0;
+	}
+
+	socket_cores = spdk_nvmf_transport_get_socket_cores(&num_socket_ids, &num_sockets);
+	if (socket_cores == NULL) {
+		return -ENOMEM;
+	}
+
+	if (num_sockets <= 1) {
+		/* A single pool shared by all poll groups, one per thread */
+		rc = spdk_nvmf_transport_fit_buf_cache(opts, opts->num_shared_buffers,
+						       spdk_thread_get_count(), buf_cache_max);
+	} else {
+		/* One poll group per core */
+		pool_size = SPDK_CEIL_DIV(opts->num_shared_buffers, num_sockets);
+		for (socket_id = 0; socket_id < num_socket_ids && rc == 0; socket_id++) {
+			rc = spdk_nvmf_transport_fit_buf_cache(opts, pool_size, socket_cores[socket_id],
+							       buf_cache_max);
+		}
+	}
+
+	free(socket_cores);
+	return rc;
+}
+
+static int
+spdk_nvmf_transport_create_data_buf_pools(struct spdk_nvmf_transport *transport)
+{
+	const char *trtype = spdk_nvme_transport_id_trtype_str(transport->ops->type);
+	char spdk_mempool_name[MAX_MEMPOOL_NAME_LENGTH];
+	uint32_t socket_id, num_socket_ids, num_sockets;
+	uint32_t *socket_cores;
+	int chars_written;
+
+	socket_cores = spdk_nvmf_transport_get_socket_cores(&num_socket_ids, &num_sockets);
+	if (socket_cores == NULL) {
+		return -ENOMEM;
+	}
+
+	if (num_sockets <= 1) {
+		free(socket_cores);
+
+		chars_written = snprintf(spdk_mempool_name, MAX_MEMPOOL_NAME_LENGTH, "%s_%s_%s", "spdk_nvmf",
+					 trtype, "data");
+		if (chars_written < 0) {
+			SPDK_ERRLOG("Unable to generate transport data buffer pool name.\n");
+			return -EINVAL;
+		}
+
+		transport->data_buf_pool_size = transport->opts.num_shared_buffers;
+		transport->data_buf_pool = spdk_mempool_create(spdk_mempool_name,
+					   transport->data_buf_pool_size,
+					   transport->opts.io_unit_size + NVMF_DATA_BUFFER_ALIGNMENT,
+					   SPDK_MEMPOOL_DEFAULT_CACHE_SIZE,
+					   SPDK_ENV_SOCKET_ID_ANY);
+		return transport->data_buf_pool != NULL ? 0 : -ENOMEM;
+	}
+
+	/*
+	 * Split the shared buffers between the sockets the application runs on, so that
+	 * each poll group moves data through memory local to its own socket.
+	 */
+	transport->socket_data_buf_pools = calloc(num_socket_ids, sizeof(struct spdk_mempool *));
+	if (transport->socket_data_buf_pools == NULL) {
+		free(socket_cores);
+		return -ENOMEM;
+	}
+	transport->num_socket_ids = num_socket_ids;
+	transport->data_buf_pool_size = SPDK_CEIL_DIV(transport->opts.num_shared_buffers, num_sockets);
+
+	for (socket_id = 0; socket_id < num_socket_ids; socket_id++) {
+		if (socket_cores[socket_id] == 0) {
+			continue;
+		}
+
+		chars_written = snprintf(spdk_mempool_name, MAX_MEMPOOL_NAME_LENGTH, "%s_%s_%s_%u",
+					 "spdk_nvmf", trtype, "data", socket_id);
+		if (chars_written < 0) {
+			SPDK_ERRLOG("Unable to generate transport data buffer pool name.\n");
+			break;
+		}
+
+		transport->socket_data_buf_pools[socket_id] = spdk_mempool_create(spdk_mempool_name,
+				transport->data_buf_pool_size,
+				transport->opts.io_unit_size + NVMF_DATA_BUFFER_ALIGNMENT,
+				SPDK_MEMPOOL_DEFAULT_CACHE_SIZE,
+				socket_id);
+		if (transport->socket_data_buf_pools[socket_id] == NULL) {
+			SPDK_ERRLOG("Unable to allocate buffer pool on socket %u\n", socket_id);
+			break;
+		}
+
+		/* Poll groups on a core without a known socket use the first pool */
+		if (transport->data_buf_pool == NULL) {
+			transport->data_buf_pool = transport->socket_data_buf_pools[socket_id];
+		}
+	}
+	free(socket_cores);
+
+	if (socket_id != num_socket_ids) {
+		spdk_nvmf_transport_free_data_buf_pools(transport);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static struct spdk_mempool *
+spdk_nvmf_transport_get_local_data_buf_pool(struct spdk_nvmf_transport *transport,
+		int32_t *socket_id)
+{
+	uint32_t core = spdk_env_get_current_core();
+	uint32_t socket;
+
+	if (transport->socket_data_buf_pools != NULL && core != UINT32_MAX) {
+		socket = spdk_env_get_socket_id(core);
+		if (socket < transport->num_socket_ids &&
+		    transport->socket_data_buf_pools[socket] != NULL) {
+			*socket_id = socket;
+			return transport->socket_data_buf_pools[socket];
+		}
+	}
+
+	*socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	return transport->data_buf_pool;
+}
+
 struct spdk_nvmf_transport *
 spdk_nvmf_transport_create(enum spdk_nvme_transport_type type,
 			   struct spdk_nvmf_transport_opts *opts)
 {
 	const struct spdk_nvmf_transport_ops *ops = NULL;
 	struct spdk_nvmf_transport *transport;
-	char spdk_mempool_name[MAX_MEMPOOL_NAME_LENGTH];
-	int chars_written;
 
 	ops = spdk_nvmf_get_transport_ops(type);
 	if (!ops) {
@@ -104,21 +329,8 @@ spdk_nvmf_transport_create(enum spdk_nvme_transport_type type,
 
 	transport->ops = ops;
 	transport->opts = *opts;
-	chars_written = snprintf(spdk_mempool_name, MAX_MEMPOOL_NAME_LENGTH, "%s_%s_%s", "spdk_nvmf",
-				 spdk_nvme_transport_id_trtype_str(type), "data");
-	if (chars_written < 0) {
-		SPDK_ERRLOG("Unable to generate transport data buffer pool name.\n");
-		ops->destroy(transport);
-		return NULL;
-	}
-
-	transport->data_buf_pool = spdk_mempool_create(spdk_mempool_name,
-				   opts->num_shared_buffers,
-				   opts->io_unit_size + NVMF_DATA_BUFFER_ALIGNMENT,
-				   SPDK_MEMPOOL_DEFAULT_CACHE_SIZE,
-				   SPDK_ENV_SOCKET_ID_ANY);
 
-	if (!transport->data_buf_pool) {
+	if (spdk_nvmf_transport_create_data_buf_pools(transport) != 0) {
 		SPDK_ERRLOG("Unable to allocate buffer pool for poll group\n");
 		ops->destroy(transport);
 		return NULL;
@@ -142,16 +354,19 @@ spdk_nvmf_transport_get_next(struct spdk_nvmf_transport *transport)
 int
 spdk_nvmf_transport_destroy(struct spdk_nvmf_transport *transport)
 {
-	if (transport->data_buf_pool != NULL) {
-		if (spdk_mempool_count(transport->data_buf_pool) !=
-		    transport->opts.num_shared_buffers) {
+	struct spdk_mempool *pool;
+	uint32_t i;
+
+	for (i = 0; i < spdk_max(transport->num_socket_ids, 1); i++) {
+		pool = transport->socket_data_buf_pools ? transport->socket_data_buf_pools[i] :
+		       transport->data_buf_pool;
+		if (pool != NULL && spdk_mempool_count(pool) != transport->data_buf_pool_size) {
 			SPDK_ERRLOG("transport buffer pool count is %zu but should be %u\n",
-				    spdk_mempool_count(transport->data_buf_pool),
-				    transport->opts.num_shared_buffers);
+				    spdk_mempool_count(pool), transport->data_buf_pool_size);
 		}
 	}
 
-	spdk_mempool_free(transport->data_buf_pool);
+	spdk_nvmf_transport_free_data_buf_pools(transport);
 
 	return transport->ops->destroy(transport);
 }
@@ -184,6 +399,48 @@ spdk_nvmf_transport_listener_discover(struct spdk_nvmf_transport *transport,
 	transport->ops->listener_discover(transport, trid, entry);
 }
 
+static void
+spdk_nvmf_transport_pg_buf_cache_adjust(struct spdk_nvmf_transport_poll_group *group)
+{
+	struct spdk_nvmf_transport_pg_cache_buf *buf;
+	uint32_t shrink;
+
+	if (group->buf_cache_shortfall > 0) {
+		/* The cache ran dry, let it keep what a request had to take from the pool */
+		group->buf_cache_size = spdk_min(group->buf_cache_size + group->buf_cache_shortfall,
+						 group->buf_cache_max);
+	} else if (group->buf_cache_low > 0) {
+		/* Part of the cache wasn't touched at all, hand half of it back to the pool */
+		shrink = SPDK_CEIL_DIV(group->buf_cache_low, 2);
+		group->buf_cache_size -= spdk_min(shrink, group->buf_cache_size);
+		while (group->buf_cache_count > group->buf_cache_size) {
+			buf = STAILQ_FIRST(&group->buf_cache);
+			STAILQ_REMOVE_HEAD(&group->buf_cache, link);
+			group->buf_cache_count--;
+			spdk_mempool_put(group->data_buf_pool, buf);
+		}
+	}
+
+	group->buf_cache_gets = 0;
+	group->buf_cache_shortfall = 0;
+	group->buf_cache_low = group->buf_cache_count;
+}
+
+/*
+ * A poll group that went idle after a burst doesn't request buffers anymore, so
+ *  its cache would never be shrunk from the get path.
+ */
+static int
+spdk_nvmf_transport_pg_buf_cache_poll(void *arg)
+{
+	struct spdk_nvmf_transport_poll_group *group = arg;
+	uint32_t buf_cache_count = group->buf_cache_count;
+
+	spdk_nvmf_transport_pg_buf_cache_adjust(group);
+
+	return group->buf_cache_count != buf_cache_count;
+}
+
 struct spdk_nvmf_transport_poll_group *
 spdk_nvmf_transport_poll_group_create(struct spdk_nvmf_transport *transport)
 {
@@ -198,12 +455,17 @@ spdk_nvmf_transport_poll_group_create(struct spdk_nvmf_transport *transport)
 
 	STAILQ_INIT(&group->pending_buf_queue);
 	STAILQ_INIT(&group->buf_cache);
+	group->data_buf_pool = spdk_nvmf_transport_get_local_data_buf_pool(transport,
+			       &group->data_buf_socket_id);
 
 	if (transport->opts.buf_cache_size) {
 		group->buf_cache_count = 0;
 		group->buf_cache_size = transport->opts.buf_cache_size;
+		/* The cache may grow up to twice its configured size under load */
+		group->buf_cache_max = transport->buf_cache_max != 0 ? transport->buf_cache_max :
+				       2 * transport->opts.buf_cache_size;
 		while (group->buf_cache_count < group->buf_cache_size) {
-			buf = (struct spdk_nvmf_transport_pg_cache_buf *)spdk_mempool_get(transport->data_buf_pool);
+			buf = (struct spdk_nvmf_transport_pg_cache_buf *)spdk_mempool_get(group->data_buf_pool);
 			if (!buf) {
 				SPDK_NOTICELOG("Unable to reserve the full number of buffers for the pg buffer cache.\n");
 				break;
@@ -211,6 +473,9 @@ spdk_nvmf_transport_poll_group_create(struct spdk_nvmf_transport *transport)
 			STAILQ_INSERT_HEAD(&group->buf_cache, buf, link);
 			group->buf_cache_count++;
 		}
+		group->buf_cache_low = group->buf_cache_count;
+		group->buf_cache_poller = spdk_poller_register(spdk_nvmf_transport_pg_buf_cache_poll,
+					  group, NVMF_BUF_CACHE_ADJUST_PERIOD_US);
 	}
 	return group;
 }
@@ -235,9 +500,11 @@ spdk_nvmf_transport_poll_group_destroy(struct spdk_nvmf_transport_poll_group *gr
 		SPDK_ERRLOG("Pending I/O list wasn't empty on poll group destruction\n");
 	}
 
+	spdk_poller_unregister(&group->buf_cache_poller);
+
 	STAILQ_FOREACH_SAFE(buf, &group->buf_cache, link, tmp) {
 		STAILQ_REMOVE(&group->buf_cache, buf, spdk_nvmf_transport_pg_cache_buf, link);
-		spdk_mempool_put(group->transport->data_buf_pool, buf);
+		spdk_mempool_put(group->data_buf_pool, buf);
 	}
 	group->transport->ops->poll_group_destroy(group);
 }
@@ -349,11 +616,53 @@ spdk_nvmf_transport_poll_group_get_stat(struct spdk_nvmf_tgt *tgt,
 					struct spdk_nvmf_transport *transport,
 					struct spdk_nvmf_transport_poll_group_stat **stat)
 {
+	struct spdk_io_channel *ch;
+	struct spdk_nvmf_poll_group *group;
+	struct spdk_nvmf_transport_poll_group *tgroup;
+	int rc;
+
+	if (tgt == NULL || transport == NULL || stat == NULL) {
+		return -EINVAL;
+	}
+
+	ch = spdk_get_io_channel(tgt);
+	if (ch == NULL) {
+		return -ENOENT;
+	}
+	group = spdk_io_channel_get_ctx(ch);
+	spdk_put_io_channel(ch);
+
+	TAILQ_FOREACH(tgroup, &group->tgroups, link) {
+		if (tgroup->transport == transport) {
+			break;
+		}
+	}
+	if (tgroup == NULL) {
+		return -ENOENT;
+	}
+
+	/* Data buffer statistics are kept here, so every transport can report them */
 	if (transport->ops->poll_group_get_stat) {
-		return transport->ops->poll_group_get_stat(tgt, stat);
+		rc = transport->ops->poll_group_get_stat(tgt, stat);
+		if (rc != 0) {
+			return rc;
+		}
 	} else {
-		return -ENOTSUP;
+		*stat = calloc(1, sizeof(struct spdk_nvmf_transport_poll_group_stat));
+		if (*stat == NULL) {
+			return -ENOMEM;
+		}
+		(*stat)->trtype = transport->ops->type;
 	}
+
+	(*stat)->numa_socket = tgroup->data_buf_socket_id;
+	(*stat)->buf_cache_size = tgroup->buf_cache_size;
+	(*stat)->buf_cache_count = tgroup->buf_cache_count;
+	(*stat)->buf_cache_misses = tgroup->buf_stat.buf_cache_misses;
+	(*stat)->buf_waits = tgroup->buf_stat.buf_waits;
+	(*stat)->buf_pool_exhausted = tgroup->buf_stat.buf_pool_exhausted;
+
+	return 0;
 }
 
 void
@@ -362,6 +671,8 @@ spdk_nvmf_transport_poll_group_free_stat(struct spdk_nvmf_transport *transport,
 {
 	if (transport->ops->poll_group_free_stat) {
 		transport->ops->poll_group_free_stat(stat);
+	} else {
+		free(stat);
 	}
 }
 
@@ -380,7 +691,7 @@ spdk_nvmf_request_free_buffers(struct spdk_nvmf_request *req,
 					   link);
 			group->buf_cache_count++;
 		} else {
-			spdk_mempool_put(transport->data_buf_pool, req->buffers[i]);
+			spdk_mempool_put(group->data_buf_pool, req->buffers[i]);
 		}
 		req->iov[i].iov_base = NULL;
 		req->buffers[i] = NULL;
@@ -405,17 +716,32 @@ spdk_nvmf_request_get_buffers(struct spdk_nvmf_request *req,
 			assert(req->buffers[i] != NULL);
 			i++;
 		} else {
-			if (spdk_mempool_get_bulk(transport->data_buf_pool, &req->buffers[i],
+			if (spdk_mempool_get_bulk(group->data_buf_pool, &req->buffers[i],
 						  num_buffers - i)) {
 				goto err_exit;
 			}
+			group->buf_stat.buf_cache_misses += num_buffers - i;
+			group->buf_cache_shortfall = spdk_max(group->buf_cache_shortfall, num_buffers - i);
 			i += num_buffers - i;
 		}
 	}
 
+	group->buf_pool_exhausted = false;
+	if (group->buf_cache_count < group->buf_cache_low) {
+		group->buf_cache_low = group->buf_cache_count;
+	}
+	if (group->buf_cache_max != 0 && ++group->buf_cache_gets == NVMF_BUF_CACHE_ADJUST_INTERVAL) {
+		spdk_nvmf_transport_pg_buf_cache_adjust(group);
+	}
+
 	return 0;
 
 err_exit:
 	spdk_nvmf_request_free_buffers(req, group, transport, i);
+	group->buf_stat.buf_waits++;
+	if (!group->buf_pool_exhausted) {
+		group->buf_pool_exhausted = true;
+		group->buf_stat.buf_pool_exhausted++;
+	}
 	return -ENOMEM;
 }
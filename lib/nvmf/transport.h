@@ -47,6 +47,18 @@ struct spdk_nvmf_transport {
 	/* A mempool for transport related data transfers */
 	struct spdk_mempool			*data_buf_pool;
 
+	/*
+	 * If the application runs on more than one NUMA socket, the data buffers are
+	 * split into a pool per socket, indexed by socket id. data_buf_pool then
+	 * points to the pool of the first socket.
+	 */
+	struct spdk_mempool			**socket_data_buf_pools;
+	uint32_t				num_socket_ids;
+	/* Number of buffers in each pool */
+	uint32_t				data_buf_pool_size;
+	/* Largest size of the poll group buffer caches, 0 for twice buf_cache_size */
+	uint32_t				buf_cache_max;
+
 	TAILQ_ENTRY(spdk_nvmf_transport)	link;
 };
 
@@ -223,6 +235,9 @@ int spdk_nvmf_transport_qpair_set_sqsize(struct spdk_nvmf_qpair *qpair);
 bool spdk_nvmf_transport_opts_init(enum spdk_nvme_transport_type type,
 				   struct spdk_nvmf_transport_opts *opts);
 
+int spdk_nvmf_transport_calc_buf_cache_max(const struct spdk_nvmf_transport_opts *opts,
+		uint32_t *buf_cache_max);
+
 extern const struct spdk_nvmf_transport_ops spdk_nvmf_transport_rdma;
 extern const struct spdk_nvmf_transport_ops spdk_nvmf_transport_tcp;
 extern const struct spdk_nvmf_transport_ops spdk_nvmf_transport_fc;
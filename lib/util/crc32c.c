@@ -32,6 +32,7 @@
  */
 
 #include "spdk/crc32.h"
+#include "spdk/util.h"
 
 #if defined(__aarch64__) || defined(__AARCH64__)
 #ifdef __ARM_FEATURE_CRC32
@@ -136,3 +137,96 @@ spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
 }
 
 #endif
+
+#if defined(SPDK_HAVE_SSE4_2) || defined(SPDK_HAVE_ARM_CRC)
+
+#ifdef SPDK_HAVE_SSE4_2
+#define _crc32c_u64(crc, block) ((uint32_t)_mm_crc32_u64((crc), (block)))
+#else
+#define _crc32c_u64(crc, block) __crc32cd((crc), (block))
+#endif
+
+/* Number of independent buffers checksummed in lockstep. */
+#define CRC32C_MULTI_LANES 4
+
+static void
+_crc32c_update_lanes(const uint8_t **bufs, size_t *lens, uint32_t *crcs)
+{
+	uint32_t crc0 = crcs[0], crc1 = crcs[1], crc2 = crcs[2], crc3 = crcs[3];
+	uint64_t block0, block1, block2, block3;
+	size_t count, len, i;
+
+	len = spdk_min(spdk_min(lens[0], lens[1]), spdk_min(lens[2], lens[3]));
+	count = len / 8;
+
+	/*
+	 * The four CRC dependency chains are independent of each other, so the
+	 * CPU can keep several CRC instructions in flight at the same time.
+	 */
+	for (i = 0; i < count; i++) {
+		memcpy(&block0, bufs[0] + i * 8, sizeof(block0));
+		memcpy(&block1, bufs[1] + i * 8, sizeof(block1));
+		memcpy(&block2, bufs[2] + i * 8, sizeof(block2));
+		memcpy(&block3, bufs[3] + i * 8, sizeof(block3));
+		crc0 = _crc32c_u64(crc0, block0);
+		crc1 = _crc32c_u64(crc1, block1);
+		crc2 = _crc32c_u64(crc2, block2);
+		crc3 = _crc32c_u64(crc3, block3);
+	}
+
+	crcs[0] = crc0;
+	crcs[1] = crc1;
+	crcs[2] = crc2;
+	crcs[3] = crc3;
+
+	for (i = 0; i < CRC32C_MULTI_LANES; i++) {
+		bufs[i] += count * 8;
+		lens[i] -= count * 8;
+	}
+}
+
+void
+spdk_crc32c_update_multi(const void *const *bufs, const size_t *lens, uint32_t *crcs,
+			 uint32_t count)
+{
+	const uint8_t *lane_bufs[CRC32C_MULTI_LANES];
+	size_t lane_lens[CRC32C_MULTI_LANES];
+	uint32_t i, j;
+
+	for (i = 0; i + CRC32C_MULTI_LANES <= count; i += CRC32C_MULTI_LANES) {
+		for (j = 0; j < CRC32C_MULTI_LANES; j++) {
+			lane_bufs[j] = bufs[i + j];
+			lane_lens[j] = lens[i + j];
+		}
+
+		_crc32c_update_lanes(lane_bufs, lane_lens, &crcs[i]);
+
+		/* Finish the trailing bytes and whatever is left of the longer buffers. */
+		for (j = 0; j < CRC32C_MULTI_LANES; j++) {
+			crcs[i + j] = spdk_crc32c_update(lane_bufs[j], lane_lens[j], crcs[i + j]);
+		}
+	}
+
+	for (; i < count; i++) {
+		crcs[i] = spdk_crc32c_update(bufs[i], lens[i], crcs[i]);
+	}
+}
+
+#else
+
+void
+spdk_crc32c_update_multi(const void *const *bufs, const size_t *lens, uint32_t *crcs,
+			 uint32_t count)
+{
+	uint32_t i;
+
+	/*
+	 * ISA-L already interleaves several streams within a single buffer and the
+	 * table based implementation has no instruction latency to hide.
+	 */
+	for (i = 0; i < count; i++) {
+		crcs[i] = spdk_crc32c_update(bufs[i], lens[i], crcs[i]);
+	}
+}
+
+#endif
@@ -657,6 +657,8 @@ nvme_worker(void *arg)
 
 		dbbuf_sq = spdk_vhost_nvme_get_queue_head(nvme, sq_offset(qid, 1));
 		sq->sq_tail = (uint16_t)dbbuf_sq;
+		/* The guest wrote the commands before it moved the (shadow) doorbell. */
+		spdk_smp_rmb();
 		count = 0;
 
 		while (sq->sq_head != sq->sq_tail) {
@@ -680,16 +682,21 @@ nvme_worker(void *arg)
 					    sq->sq_tail);
 			}
 
-			/* MMIO Control */
-			if (nvme->dataplane_started) {
-				nvme->dbbuf_eis[sq_offset(qid, 1)] = (uint32_t)(sq->sq_head - 1);
-			}
-
 			/* Maximum batch I/Os to pick up at once */
 			if (count++ == MAX_BATCH_IO) {
 				break;
 			}
 		}
+
+		/*
+		 * MMIO Control: the SQ is polled, so keep EventIdx behind the consumed
+		 *  entries. The guest then only updates its shadow doorbell and never
+		 *  needs to exit to ring the BAR doorbell.
+		 */
+		if (nvme->dataplane_started && count > 0) {
+			nvme->dbbuf_eis[sq_offset(qid, 1)] = (uint32_t)(sq->sq_head - 1);
+			spdk_smp_wmb();
+		}
 	}
 
 	/* Completion Queue */
@@ -56,7 +56,7 @@ DEPDIRS-reduce := log util
 DEPDIRS-thread := log util
 
 DEPDIRS-blob := log util thread
-DEPDIRS-copy := thread
+DEPDIRS-copy := thread util
 DEPDIRS-jsonrpc := log util json
 DEPDIRS-virtio := log util json thread
 
@@ -74,7 +74,7 @@ DEPDIRS-event := log util conf thread $(JSON_LIBS) trace
 
 DEPDIRS-ftl := log util nvme thread trace bdev
 DEPDIRS-nbd := log util thread $(JSON_LIBS) bdev
-DEPDIRS-nvmf := log sock util nvme thread $(JSON_LIBS) trace bdev
+DEPDIRS-nvmf := log sock util nvme thread $(JSON_LIBS) trace bdev copy
 DEPDIRS-scsi := log util thread $(JSON_LIBS) trace bdev
 
 DEPDIRS-iscsi := log sock util conf thread $(JSON_LIBS) trace event scsi
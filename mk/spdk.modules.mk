@@ -32,7 +32,7 @@
 #
 
 BLOCKDEV_MODULES_LIST = bdev_malloc bdev_null bdev_nvme bdev_passthru bdev_lvol
-BLOCKDEV_MODULES_LIST += bdev_raid bdev_error bdev_gpt bdev_split bdev_delay
+BLOCKDEV_MODULES_LIST += bdev_raid bdev_error bdev_gpt bdev_split bdev_delay bdev_zone_block
 BLOCKDEV_MODULES_LIST += blobfs blob_bdev blob lvol vmd nvme
 
 ifeq ($(CONFIG_CRYPTO),y)
@@ -161,6 +161,57 @@ vbdev_lvs_hotremove_cb(void *ctx)
 	}
 }
 
+static struct spdk_bdev *
+vbdev_lvol_get_esnap_bdev(const char *esnap_id)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_uuid uuid;
+
+	if (spdk_uuid_parse(&uuid, esnap_id) != 0) {
+		return NULL;
+	}
+
+	for (bdev = spdk_bdev_first(); bdev != NULL; bdev = spdk_bdev_next(bdev)) {
+		if (spdk_uuid_compare(&uuid, spdk_bdev_get_uuid(bdev)) == 0) {
+			return bdev;
+		}
+	}
+
+	return NULL;
+}
+
+/* External snapshots are identified by the UUID string of their bdev */
+static int
+vbdev_lvol_esnap_dev_create(void *bs_ctx, struct spdk_blob *blob, const void *esnap_id,
+			    uint32_t id_len, struct spdk_bs_dev **_bs_dev)
+{
+	const char *uuid_str = esnap_id;
+	struct spdk_bdev *bdev;
+	struct spdk_bs_dev *bs_dev;
+
+	if (id_len != SPDK_UUID_STRING_LEN || uuid_str[SPDK_UUID_STRING_LEN - 1] != '\0') {
+		SPDK_ERRLOG("Blob 0x%" PRIx64 ": invalid external snapshot id\n", spdk_blob_get_id(blob));
+		return -EINVAL;
+	}
+
+	bdev = vbdev_lvol_get_esnap_bdev(uuid_str);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("Blob 0x%" PRIx64 ": external snapshot bdev %s not found\n",
+			    spdk_blob_get_id(blob), uuid_str);
+		return -ENODEV;
+	}
+
+	bs_dev = spdk_bdev_create_bs_dev_ro(bdev, NULL, NULL);
+	if (bs_dev == NULL) {
+		SPDK_ERRLOG("Blob 0x%" PRIx64 ": cannot open external snapshot bdev %s\n",
+			    spdk_blob_get_id(blob), spdk_bdev_get_name(bdev));
+		return -ENODEV;
+	}
+
+	*_bs_dev = bs_dev;
+	return 0;
+}
+
 static void
 _vbdev_lvs_create_cb(void *cb_arg, struct spdk_lvol_store *lvs, int lvserrno)
 {
@@ -239,6 +290,7 @@ vbdev_lvs_create(struct spdk_bdev *base_bdev, const char *name, uint32_t cluster
 		return -EINVAL;
 	}
 	snprintf(opts.name, sizeof(opts.name), "%s", name);
+	opts.esnap_bs_dev_create = vbdev_lvol_esnap_dev_create;
 
 	lvs_req = calloc(1, sizeof(*lvs_req));
 	if (!lvs_req) {
@@ -664,6 +716,8 @@ vbdev_lvol_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 
 	spdk_json_write_named_bool(w, "clone", spdk_blob_is_clone(blob));
 
+	spdk_json_write_named_bool(w, "esnap_clone", spdk_blob_is_esnap_clone(blob));
+
 	if (spdk_blob_is_clone(blob)) {
 		spdk_blob_id snapshotid = spdk_blob_get_parent_snapshot(lvol->lvol_store->blobstore, lvol->blob_id);
 		if (snapshotid != SPDK_BLOBID_INVALID) {
@@ -1071,6 +1125,118 @@ vbdev_lvol_create_clone(struct spdk_lvol *lvol, const char *clone_name,
 	spdk_lvol_create_clone(lvol, clone_name, _vbdev_lvol_create_cb, req);
 }
 
+int
+vbdev_lvol_create_bdev_clone(const char *esnap_name, struct spdk_lvol_store *lvs,
+			     const char *clone_name, spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol_with_handle_req *req;
+	struct spdk_bdev *bdev;
+	char esnap_id[SPDK_UUID_STRING_LEN];
+	uint64_t sz;
+	int rc;
+
+	bdev = spdk_bdev_get_by_name(esnap_name);
+	if (bdev == NULL) {
+		bdev = vbdev_lvol_get_esnap_bdev(esnap_name);
+	}
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' could not be opened: not found\n", esnap_name);
+		return -ENODEV;
+	}
+
+	if (lvs == NULL) {
+		SPDK_ERRLOG("lvol store does not exist\n");
+		return -EINVAL;
+	}
+
+	/* Clusters past the end of a partial cluster would read beyond the bdev */
+	sz = spdk_bdev_get_num_blocks(bdev) * spdk_bdev_get_block_size(bdev);
+	if (sz % spdk_bs_get_cluster_size(lvs->blobstore) != 0) {
+		SPDK_ERRLOG("bdev '%s' size %" PRIu64 " is not a multiple of the cluster size\n",
+			    esnap_name, sz);
+		return -EINVAL;
+	}
+
+	if (spdk_mem_all_zero(spdk_bdev_get_uuid(bdev), sizeof(struct spdk_uuid))) {
+		SPDK_ERRLOG("bdev '%s' has no UUID to refer to it by\n", esnap_name);
+		return -EINVAL;
+	}
+	spdk_uuid_fmt_lower(esnap_id, sizeof(esnap_id), spdk_bdev_get_uuid(bdev));
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+
+	rc = spdk_lvol_create_esnap_clone(esnap_id, sizeof(esnap_id), sz, lvs, clone_name,
+					  _vbdev_lvol_create_cb, req);
+	if (rc != 0) {
+		free(req);
+	}
+
+	return rc;
+}
+
+struct vbdev_lvol_shallow_copy_req {
+	spdk_lvol_op_complete	cb_fn;
+	void			*cb_arg;
+	struct spdk_bs_dev	*ext_dev;
+};
+
+static void
+_vbdev_lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
+{
+	struct vbdev_lvol_shallow_copy_req *req = cb_arg;
+
+	req->ext_dev->destroy(req->ext_dev);
+	req->cb_fn(req->cb_arg, lvolerrno);
+	free(req);
+}
+
+int
+vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
+			const struct spdk_blob_copy_opts *opts,
+			spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	struct vbdev_lvol_shallow_copy_req *req;
+	struct spdk_bdev *bdev;
+	int rc;
+
+	bdev = spdk_bdev_get_by_name(bdev_name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' could not be opened: not found\n", bdev_name);
+		return -ENODEV;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+
+	req->ext_dev = spdk_bdev_create_bs_dev(bdev, NULL, NULL);
+	if (req->ext_dev == NULL) {
+		SPDK_ERRLOG("Cannot create blobstore device for bdev '%s'\n", bdev_name);
+		free(req);
+		return -ENODEV;
+	}
+
+	/* Nothing else may write to the bdev while it is being copied to */
+	rc = spdk_bs_bdev_claim(req->ext_dev, &g_lvol_if);
+	if (rc != 0) {
+		req->ext_dev->destroy(req->ext_dev);
+		free(req);
+		return -EBUSY;
+	}
+
+	spdk_lvol_shallow_copy(lvol, req->ext_dev, opts, _vbdev_lvol_shallow_copy_cb, req);
+
+	return 0;
+}
+
 static void
 _vbdev_lvol_rename_cb(void *cb_arg, int lvolerrno)
 {
@@ -1327,6 +1493,7 @@ vbdev_lvs_examine(struct spdk_bdev *bdev)
 {
 	struct spdk_bs_dev *bs_dev;
 	struct spdk_lvs_with_handle_req *req;
+	struct spdk_lvs_opts opts;
 
 	req = calloc(1, sizeof(*req));
 	if (req == NULL) {
@@ -1345,7 +1512,10 @@ vbdev_lvs_examine(struct spdk_bdev *bdev)
 
 	req->base_bdev = bdev;
 
-	spdk_lvs_load(bs_dev, _vbdev_lvs_examine_cb, req);
+	spdk_lvs_opts_init(&opts);
+	opts.esnap_bs_dev_create = vbdev_lvol_esnap_dev_create;
+
+	spdk_lvs_load_ext(bs_dev, &opts, _vbdev_lvs_examine_cb, req);
 }
 
 struct spdk_lvol *
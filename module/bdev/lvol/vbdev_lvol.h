@@ -63,6 +63,31 @@ void vbdev_lvol_create_snapshot(struct spdk_lvol *lvol, const char *snapshot_nam
 void vbdev_lvol_create_clone(struct spdk_lvol *lvol, const char *clone_name,
 			     spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg);
 
+/**
+ * \brief Create a clone of a bdev used as its external snapshot
+ * \param esnap_name Name or UUID of the bdev to clone
+ * \param lvs Handle to lvolstore
+ * \param clone_name Name of the clone
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ * \return error
+ */
+int vbdev_lvol_create_bdev_clone(const char *esnap_name, struct spdk_lvol_store *lvs,
+				 const char *clone_name, spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg);
+
+/**
+ * \brief Copy the clusters a read-only lvol holds itself to a bdev
+ * \param lvol Handle to lvol
+ * \param bdev_name Name of the bdev to copy to
+ * \param opts Copy options, NULL for the defaults
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ * \return error
+ */
+int vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
+			    const struct spdk_blob_copy_opts *opts,
+			    spdk_lvol_op_complete cb_fn, void *cb_arg);
+
 /**
  * \brief Change size of lvol
  * \param lvol Handle to lvol
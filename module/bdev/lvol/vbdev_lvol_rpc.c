@@ -567,6 +567,66 @@ cleanup:
 SPDK_RPC_REGISTER("bdev_lvol_clone", spdk_rpc_bdev_lvol_clone, SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_clone, clone_lvol_bdev)
 
+struct rpc_bdev_lvol_clone_bdev {
+	char *bdev;
+	char *uuid;
+	char *lvs_name;
+	char *clone_name;
+};
+
+static void
+free_rpc_bdev_lvol_clone_bdev(struct rpc_bdev_lvol_clone_bdev *req)
+{
+	free(req->bdev);
+	free(req->uuid);
+	free(req->lvs_name);
+	free(req->clone_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_clone_bdev_decoders[] = {
+	{"bdev", offsetof(struct rpc_bdev_lvol_clone_bdev, bdev), spdk_json_decode_string},
+	{"uuid", offsetof(struct rpc_bdev_lvol_clone_bdev, uuid), spdk_json_decode_string, true},
+	{"lvs_name", offsetof(struct rpc_bdev_lvol_clone_bdev, lvs_name), spdk_json_decode_string, true},
+	{"clone_name", offsetof(struct rpc_bdev_lvol_clone_bdev, clone_name), spdk_json_decode_string},
+};
+
+static void
+spdk_rpc_bdev_lvol_clone_bdev(struct spdk_jsonrpc_request *request,
+			      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_clone_bdev req = {};
+	struct spdk_lvol_store *lvs = NULL;
+	int rc;
+
+	SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "Cloning bdev\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_clone_bdev_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_clone_bdev_decoders),
+				    &req)) {
+		SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = vbdev_get_lvol_store_by_uuid_xor_name(req.uuid, req.lvs_name, &lvs);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	rc = vbdev_lvol_create_bdev_clone(req.bdev, lvs, req.clone_name,
+					  _spdk_rpc_bdev_lvol_clone_cb, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+
+cleanup:
+	free_rpc_bdev_lvol_clone_bdev(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_clone_bdev", spdk_rpc_bdev_lvol_clone_bdev, SPDK_RPC_RUNTIME)
+
 struct rpc_bdev_lvol_rename {
 	char *old_name;
 	char *new_name;
@@ -648,6 +708,7 @@ SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_rename, rename_lvol_bdev)
 
 struct rpc_bdev_lvol_inflate {
 	char *name;
+	struct spdk_blob_copy_opts opts;
 };
 
 static void
@@ -658,6 +719,8 @@ free_rpc_bdev_lvol_inflate(struct rpc_bdev_lvol_inflate *req)
 
 static const struct spdk_json_object_decoder rpc_bdev_lvol_inflate_decoders[] = {
 	{"name", offsetof(struct rpc_bdev_lvol_inflate, name), spdk_json_decode_string},
+	{"queue_depth", offsetof(struct rpc_bdev_lvol_inflate, opts.queue_depth), spdk_json_decode_uint32, true},
+	{"mbytes_per_sec", offsetof(struct rpc_bdev_lvol_inflate, opts.mbytes_per_sec), spdk_json_decode_uint64, true},
 };
 
 static void
@@ -690,6 +753,8 @@ spdk_rpc_bdev_lvol_inflate(struct spdk_jsonrpc_request *request,
 
 	SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "Inflating lvol\n");
 
+	spdk_blob_copy_opts_init(&req.opts);
+
 	if (spdk_json_decode_object(params, rpc_bdev_lvol_inflate_decoders,
 				    SPDK_COUNTOF(rpc_bdev_lvol_inflate_decoders),
 				    &req)) {
@@ -713,7 +778,7 @@ spdk_rpc_bdev_lvol_inflate(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
-	spdk_lvol_inflate(lvol, _spdk_rpc_bdev_lvol_inflate_cb, request);
+	spdk_lvol_inflate_ext(lvol, &req.opts, _spdk_rpc_bdev_lvol_inflate_cb, request);
 
 cleanup:
 	free_rpc_bdev_lvol_inflate(&req);
@@ -732,6 +797,8 @@ spdk_rpc_bdev_lvol_decouple_parent(struct spdk_jsonrpc_request *request,
 
 	SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "Decoupling parent of lvol\n");
 
+	spdk_blob_copy_opts_init(&req.opts);
+
 	if (spdk_json_decode_object(params, rpc_bdev_lvol_inflate_decoders,
 				    SPDK_COUNTOF(rpc_bdev_lvol_inflate_decoders),
 				    &req)) {
@@ -755,7 +822,7 @@ spdk_rpc_bdev_lvol_decouple_parent(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
-	spdk_lvol_decouple_parent(lvol, _spdk_rpc_bdev_lvol_inflate_cb, request);
+	spdk_lvol_decouple_parent_ext(lvol, &req.opts, _spdk_rpc_bdev_lvol_inflate_cb, request);
 
 cleanup:
 	free_rpc_bdev_lvol_inflate(&req);
@@ -764,6 +831,144 @@ cleanup:
 SPDK_RPC_REGISTER("bdev_lvol_decouple_parent", spdk_rpc_bdev_lvol_decouple_parent, SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_decouple_parent, decouple_parent_lvol_bdev)
 
+struct rpc_bdev_lvol_shallow_copy {
+	char *src_lvol_name;
+	char *dst_bdev_name;
+	struct spdk_blob_copy_opts opts;
+};
+
+static void
+free_rpc_bdev_lvol_shallow_copy(struct rpc_bdev_lvol_shallow_copy *req)
+{
+	free(req->src_lvol_name);
+	free(req->dst_bdev_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_shallow_copy_decoders[] = {
+	{"src_lvol_name", offsetof(struct rpc_bdev_lvol_shallow_copy, src_lvol_name), spdk_json_decode_string},
+	{"dst_bdev_name", offsetof(struct rpc_bdev_lvol_shallow_copy, dst_bdev_name), spdk_json_decode_string},
+	{"queue_depth", offsetof(struct rpc_bdev_lvol_shallow_copy, opts.queue_depth), spdk_json_decode_uint32, true},
+	{"mbytes_per_sec", offsetof(struct rpc_bdev_lvol_shallow_copy, opts.mbytes_per_sec), spdk_json_decode_uint64, true},
+};
+
+static void
+spdk_rpc_bdev_lvol_shallow_copy(struct spdk_jsonrpc_request *request,
+				const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_shallow_copy req = {};
+	struct spdk_bdev *bdev;
+	struct spdk_lvol *lvol;
+	int rc;
+
+	SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "Shallow copying lvol\n");
+
+	spdk_blob_copy_opts_init(&req.opts);
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_shallow_copy_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_shallow_copy_decoders),
+				    &req)) {
+		SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev = spdk_bdev_get_by_name(req.src_lvol_name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", req.src_lvol_name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	rc = vbdev_lvol_shallow_copy(lvol, req.dst_bdev_name, &req.opts,
+				     _spdk_rpc_bdev_lvol_inflate_cb, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+
+cleanup:
+	free_rpc_bdev_lvol_shallow_copy(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_shallow_copy", spdk_rpc_bdev_lvol_shallow_copy, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_lvol_get_copy_progress {
+	char *name;
+};
+
+static void
+free_rpc_bdev_lvol_get_copy_progress(struct rpc_bdev_lvol_get_copy_progress *req)
+{
+	free(req->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_get_copy_progress_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_lvol_get_copy_progress, name), spdk_json_decode_string},
+};
+
+static void
+spdk_rpc_bdev_lvol_get_copy_progress(struct spdk_jsonrpc_request *request,
+				     const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_get_copy_progress req = {};
+	struct spdk_blob_copy_progress progress;
+	struct spdk_json_write_ctx *w;
+	struct spdk_bdev *bdev;
+	struct spdk_lvol *lvol;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_get_copy_progress_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_get_copy_progress_decoders),
+				    &req)) {
+		SPDK_INFOLOG(SPDK_LOG_LVOL_RPC, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev = spdk_bdev_get_by_name(req.name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", req.name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	rc = spdk_blob_get_copy_progress(lvol->blob, &progress);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "clusters_total", progress.clusters_total);
+	spdk_json_write_named_uint64(w, "clusters_done", progress.clusters_done);
+	spdk_json_write_named_uint64(w, "elapsed_ms", progress.elapsed_ms);
+	spdk_json_write_named_uint64(w, "eta_ms", progress.eta_ms);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_bdev_lvol_get_copy_progress(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_get_copy_progress", spdk_rpc_bdev_lvol_get_copy_progress,
+		  SPDK_RPC_RUNTIME)
+
 struct rpc_bdev_lvol_resize {
 	char *name;
 	uint64_t size;
@@ -43,6 +43,7 @@
 #include "spdk/json.h"
 #include "spdk/nvme.h"
 #include "spdk/nvme_ocssd.h"
+#include "spdk/nvme_zns.h"
 #include "spdk/thread.h"
 #include "spdk/string.h"
 #include "spdk/likely.h"
@@ -82,6 +83,15 @@ struct nvme_bdev_io {
 
 	/** Originating thread */
 	struct spdk_thread *orig_thread;
+
+	/** Controller memory buffer backing a zero copy request, NULL if host memory is used. */
+	void *cmb_buf;
+
+	/** Zone report buffer of a get zone info request. */
+	void *zone_report_buf;
+
+	/** Number of zones already translated for a get zone info request. */
+	uint64_t handled_zones;
 };
 
 struct nvme_probe_ctx {
@@ -93,6 +103,30 @@ struct nvme_probe_ctx {
 	const char *hostnqn;
 };
 
+struct nvme_init_ctx;
+
+/* Connection to an NVMe-oF controller listed in the configuration file */
+struct nvme_init_connect {
+	struct spdk_nvme_ctrlr_opts	opts;
+	struct spdk_nvme_probe_ctx	*probe_ctx;
+	struct nvme_init_ctx		*init_ctx;
+	size_t				index;
+};
+
+/*
+ * All of the controllers listed in the configuration file are attached at
+ *  the same time, so their initialization steps overlap instead of adding up.
+ */
+struct nvme_init_ctx {
+	struct nvme_probe_ctx		probe_ctx;
+	struct nvme_init_connect	connects[NVME_MAX_CONTROLLERS];
+	struct spdk_nvme_probe_ctx	*pcie_probe_ctx;
+	struct spdk_poller		*poller;
+	bool				hotplug_enabled;
+	int64_t				hotplug_period;
+	uint64_t			start_tsc;
+};
+
 struct nvme_probe_skip_entry {
 	struct spdk_nvme_transport_id		trid;
 	TAILQ_ENTRY(nvme_probe_skip_entry)	tailq;
@@ -142,6 +176,22 @@ static int bdev_nvme_io_passthru(struct nvme_bdev *nbdev, struct spdk_io_channel
 static int bdev_nvme_io_passthru_md(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 				    struct nvme_bdev_io *bio,
 				    struct spdk_nvme_cmd *cmd, void *buf, size_t nbytes, void *md_buf, size_t md_len);
+static int bdev_nvme_zcopy_start(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+				 struct nvme_bdev_io *bio);
+static int bdev_nvme_zcopy_end(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+			       struct nvme_bdev_io *bio);
+static void bdev_nvme_zcopy_put_buf(struct nvme_bdev *nbdev, struct nvme_bdev_io *bio);
+static int bdev_nvme_abort(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+			   struct nvme_bdev_io *bio, struct nvme_bdev_io *bio_to_abort);
+static int bdev_nvme_zone_appendv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+				  struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
+				  void *md, uint64_t lba_count, uint64_t zslba);
+static int bdev_nvme_zone_management(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+				     struct nvme_bdev_io *bio, uint64_t zone_id,
+				     enum spdk_bdev_zone_action action);
+static int bdev_nvme_get_zone_info(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+				   struct nvme_bdev_io *bio, uint64_t zone_id, uint32_t num_zones,
+				   struct spdk_bdev_zone_info *info);
 static int nvme_ctrlr_create_bdev(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, uint32_t nsid);
 
 struct spdk_nvme_qpair *
@@ -162,6 +212,7 @@ bdev_nvme_get_ctx_size(void)
 
 static struct spdk_bdev_module nvme_if = {
 	.name = "nvme",
+	.async_init = true,
 	.module_init = bdev_nvme_library_init,
 	.module_fini = bdev_nvme_library_fini,
 	.config_text = bdev_nvme_get_spdk_running_config,
@@ -459,6 +510,44 @@ _bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_
 						bdev_io->u.nvme_passthru.md_buf,
 						bdev_io->u.nvme_passthru.md_len);
 
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		if (bdev_io->u.bdev.zcopy.start) {
+			return bdev_nvme_zcopy_start(nbdev, ch, nbdev_io);
+		} else {
+			return bdev_nvme_zcopy_end(nbdev, ch, nbdev_io);
+		}
+
+	case SPDK_BDEV_IO_TYPE_ABORT:
+		return bdev_nvme_abort(nbdev,
+				       ch,
+				       nbdev_io,
+				       (struct nvme_bdev_io *)bdev_io->u.abort.bio_to_abort->driver_ctx);
+
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
+		return bdev_nvme_zone_appendv(nbdev,
+					      ch,
+					      nbdev_io,
+					      bdev_io->u.bdev.iovs,
+					      bdev_io->u.bdev.iovcnt,
+					      bdev_io->u.bdev.md_buf,
+					      bdev_io->u.bdev.num_blocks,
+					      bdev_io->u.bdev.offset_blocks);
+
+	case SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT:
+		return bdev_nvme_zone_management(nbdev,
+						 ch,
+						 nbdev_io,
+						 bdev_io->u.zone_mgmt.zone_id,
+						 bdev_io->u.zone_mgmt.zone_action);
+
+	case SPDK_BDEV_IO_TYPE_GET_ZONE_INFO:
+		return bdev_nvme_get_zone_info(nbdev,
+					       ch,
+					       nbdev_io,
+					       bdev_io->u.zone_mgmt.zone_id,
+					       bdev_io->u.zone_mgmt.num_zones,
+					       bdev_io->u.zone_mgmt.buf);
+
 	default:
 		return -EINVAL;
 	}
@@ -474,6 +563,10 @@ bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 		if (rc == -ENOMEM) {
 			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
 		} else {
+			if (bdev_io->type == SPDK_BDEV_IO_TYPE_ZCOPY && bdev_io->u.bdev.iovs != NULL) {
+				bdev_nvme_zcopy_put_buf((struct nvme_bdev *)bdev_io->bdev->ctxt,
+							(struct nvme_bdev_io *)bdev_io->driver_ctx);
+			}
 			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
 		}
 	}
@@ -492,6 +585,7 @@ bdev_nvme_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 	case SPDK_BDEV_IO_TYPE_FLUSH:
 	case SPDK_BDEV_IO_TYPE_NVME_ADMIN:
 	case SPDK_BDEV_IO_TYPE_NVME_IO:
+	case SPDK_BDEV_IO_TYPE_ABORT:
 		return true;
 
 	case SPDK_BDEV_IO_TYPE_NVME_IO_MD:
@@ -518,6 +612,19 @@ bdev_nvme_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 		 */
 		return false;
 
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		/*
+		 * Zero copy buffers are carved out of the controller memory buffer, so
+		 * the data never has to be staged in host memory.
+		 */
+		return nbdev->nvme_bdev_ctrlr->cmb_io_data &&
+		       !spdk_bdev_is_md_separate(&nbdev->disk);
+
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
+	case SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT:
+	case SPDK_BDEV_IO_TYPE_GET_ZONE_INFO:
+		return nbdev->disk.zoned;
+
 	default:
 		return false;
 	}
@@ -738,6 +845,14 @@ nvme_ctrlr_create_bdev(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr, uint32_t nsid)
 		bdev->disk.uuid = *uuid;
 	}
 
+	if (spdk_nvme_ns_get_csi(ns) == SPDK_NVME_CSI_ZNS && spdk_nvme_zns_ns_get_data(ns) != NULL) {
+		bdev->disk.zoned = true;
+		bdev->disk.zone_size = spdk_nvme_zns_ns_get_zone_size_sectors(ns);
+		bdev->disk.max_open_zones = spdk_nvme_zns_ns_get_max_open_zones(ns);
+		bdev->disk.optimal_open_zones = bdev->disk.max_open_zones;
+		bdev->disk.product_name = "NVMe ZNS disk";
+	}
+
 	bdev->disk.md_len = spdk_nvme_ns_get_md_size(ns);
 	if (bdev->disk.md_len != 0) {
 		nsdata = spdk_nvme_ns_get_data(ns);
@@ -931,6 +1046,20 @@ aer_cb(void *arg, const struct spdk_nvme_cpl *cpl)
 	}
 }
 
+static void
+bdev_nvme_log_init_stats(struct nvme_bdev_ctrlr *nvme_bdev_ctrlr)
+{
+	struct spdk_nvme_ctrlr_init_stats stats;
+
+	spdk_nvme_ctrlr_get_init_stats(nvme_bdev_ctrlr->ctrlr, &stats);
+	SPDK_INFOLOG(SPDK_LOG_BDEV_NVME, "%s (%s) initialized in %" PRIu64 " us: construct %" PRIu64
+		     " us, enable %" PRIu64 " us, identify %" PRIu64 " us, namespaces %" PRIu64
+		     " us, configure %" PRIu64 " us\n",
+		     nvme_bdev_ctrlr->name, nvme_bdev_ctrlr->trid.traddr, stats.total_us,
+		     stats.construct_us, stats.enable_us, stats.identify_us, stats.namespaces_us,
+		     stats.configure_us);
+}
+
 static int
 create_ctrlr(struct spdk_nvme_ctrlr *ctrlr,
 	     const char *name,
@@ -963,6 +1092,8 @@ create_ctrlr(struct spdk_nvme_ctrlr *ctrlr,
 		return -ENOMEM;
 	}
 	nvme_bdev_ctrlr->prchk_flags = prchk_flags;
+	nvme_bdev_ctrlr->cmb_io_data = !!(spdk_nvme_ctrlr_get_flags(ctrlr) &
+					  SPDK_NVME_CTRLR_CMB_IO_DATA_SUPPORTED);
 
 	spdk_io_device_register(ctrlr, bdev_nvme_create_cb, bdev_nvme_destroy_cb,
 				sizeof(struct nvme_io_channel),
@@ -982,6 +1113,8 @@ create_ctrlr(struct spdk_nvme_ctrlr *ctrlr,
 
 	spdk_nvme_ctrlr_register_aer_callback(ctrlr, aer_cb, nvme_bdev_ctrlr);
 
+	bdev_nvme_log_init_stats(nvme_bdev_ctrlr);
+
 	return 0;
 }
 
@@ -1351,6 +1484,99 @@ spdk_bdev_nvme_delete(const char *name)
 	return 0;
 }
 
+static void
+bdev_nvme_library_init_done(struct nvme_init_ctx *init_ctx)
+{
+	struct nvme_probe_ctx *probe_ctx = &init_ctx->probe_ctx;
+	uint64_t elapsed_us;
+	size_t i;
+	int rc;
+
+	for (i = 0; i < probe_ctx->count; i++) {
+		if (nvme_bdev_ctrlr_get(&probe_ctx->trids[i])) {
+			continue;
+		}
+
+		if (probe_ctx->trids[i].trtype == SPDK_NVME_TRANSPORT_PCIE) {
+			SPDK_ERRLOG("NVMe SSD \"%s\" could not be found.\n", probe_ctx->trids[i].traddr);
+			SPDK_ERRLOG("Check PCIe BDF and that it is attached to UIO/VFIO driver.\n");
+		} else {
+			SPDK_ERRLOG("Unable to connect to provided trid (traddr: %s)\n",
+				    probe_ctx->trids[i].traddr);
+		}
+	}
+
+	elapsed_us = (spdk_get_ticks() - init_ctx->start_tsc) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+	SPDK_INFOLOG(SPDK_LOG_BDEV_NVME, "Attached %zu NVMe controllers in %" PRIu64 " us\n",
+		     probe_ctx->count, elapsed_us);
+
+	/* Hotplug is only enabled now, so it doesn't race with the attach of the listed SSDs. */
+	rc = spdk_bdev_nvme_set_hotplug(init_ctx->hotplug_enabled, init_ctx->hotplug_period, NULL, NULL);
+	if (rc) {
+		SPDK_ERRLOG("Failed to setup hotplug (%d): %s", rc, spdk_strerror(rc));
+	}
+
+	free(init_ctx);
+	spdk_bdev_module_init_done(&nvme_if);
+}
+
+static int
+bdev_nvme_library_init_poll(void *arg)
+{
+	struct nvme_init_ctx *init_ctx = arg;
+	bool done = true;
+	size_t i;
+
+	/* A probe context is freed by the driver once all of its controllers are done. */
+	for (i = 0; i < init_ctx->probe_ctx.count; i++) {
+		if (init_ctx->connects[i].probe_ctx == NULL) {
+			continue;
+		}
+
+		if (spdk_nvme_probe_poll_async(init_ctx->connects[i].probe_ctx) == -EAGAIN) {
+			done = false;
+		} else {
+			init_ctx->connects[i].probe_ctx = NULL;
+		}
+	}
+
+	if (init_ctx->pcie_probe_ctx != NULL) {
+		if (spdk_nvme_probe_poll_async(init_ctx->pcie_probe_ctx) == -EAGAIN) {
+			done = false;
+		} else {
+			init_ctx->pcie_probe_ctx = NULL;
+		}
+	}
+
+	if (!done) {
+		return 1;
+	}
+
+	spdk_poller_unregister(&init_ctx->poller);
+	bdev_nvme_library_init_done(init_ctx);
+
+	return 1;
+}
+
+static void
+bdev_nvme_library_init_attach_cb(void *cb_ctx, const struct spdk_nvme_transport_id *trid,
+				 struct spdk_nvme_ctrlr *ctrlr, const struct spdk_nvme_ctrlr_opts *opts)
+{
+	struct spdk_nvme_ctrlr_opts *user_opts = cb_ctx;
+	struct nvme_init_connect *connect;
+	struct nvme_probe_ctx *probe_ctx;
+	int rc;
+
+	connect = SPDK_CONTAINEROF(user_opts, struct nvme_init_connect, opts);
+	probe_ctx = &connect->init_ctx->probe_ctx;
+
+	rc = create_ctrlr(ctrlr, probe_ctx->names[connect->index], &probe_ctx->trids[connect->index], 0);
+	if (rc) {
+		SPDK_ERRLOG("Failed to create NVMe controller %s (%d)\n", probe_ctx->names[connect->index], rc);
+		spdk_nvme_detach(ctrlr);
+	}
+}
+
 static int
 bdev_nvme_library_init(void)
 {
@@ -1359,7 +1585,9 @@ bdev_nvme_library_init(void)
 	int rc = 0;
 	int64_t intval = 0;
 	size_t i;
-	struct nvme_probe_ctx *probe_ctx = NULL;
+	struct nvme_init_ctx *init_ctx = NULL;
+	struct nvme_probe_ctx *probe_ctx;
+	struct nvme_init_connect *connect;
 	int retry_count;
 	uint32_t local_nvme_num = 0;
 	int64_t hotplug_period;
@@ -1369,15 +1597,17 @@ bdev_nvme_library_init(void)
 
 	sp = spdk_conf_find_section(NULL, "Nvme");
 	if (sp == NULL) {
-		goto end;
+		spdk_bdev_module_init_done(&nvme_if);
+		return 0;
 	}
 
-	probe_ctx = calloc(1, sizeof(*probe_ctx));
-	if (probe_ctx == NULL) {
+	init_ctx = calloc(1, sizeof(*init_ctx));
+	if (init_ctx == NULL) {
 		SPDK_ERRLOG("Failed to allocate probe_ctx\n");
-		rc = -1;
-		goto end;
+		return -1;
 	}
+	init_ctx->start_tsc = spdk_get_ticks();
+	probe_ctx = &init_ctx->probe_ctx;
 
 	retry_count = spdk_conf_section_get_intval(sp, "RetryCount");
 	if (retry_count >= 0) {
@@ -1390,7 +1620,7 @@ bdev_nvme_library_init(void)
 		if (intval < 0) {
 			SPDK_ERRLOG("Invalid TimeoutUsec value\n");
 			rc = -1;
-			goto end;
+			goto err;
 		}
 	}
 
@@ -1426,9 +1656,13 @@ bdev_nvme_library_init(void)
 		hotplug_period = 0;
 	}
 
+	init_ctx->hotplug_enabled = hotplug_enabled;
+	init_ctx->hotplug_period = hotplug_period;
+
 	g_nvme_hostnqn = spdk_conf_section_get_val(sp, "HostNQN");
 	probe_ctx->hostnqn = g_nvme_hostnqn;
 
+	/* Parse and validate the whole section before any controller starts attaching. */
 	for (i = 0; i < NVME_MAX_CONTROLLERS; i++) {
 		val = spdk_conf_section_get_nmval(sp, "TransportID", i, 0);
 		if (val == NULL) {
@@ -1439,21 +1673,21 @@ bdev_nvme_library_init(void)
 		if (rc < 0) {
 			SPDK_ERRLOG("Unable to parse TransportID: %s\n", val);
 			rc = -1;
-			goto end;
+			goto err;
 		}
 
 		rc = spdk_nvme_host_id_parse(&probe_ctx->hostids[i], val);
 		if (rc < 0) {
 			SPDK_ERRLOG("Unable to parse HostID: %s\n", val);
 			rc = -1;
-			goto end;
+			goto err;
 		}
 
 		val = spdk_conf_section_get_nmval(sp, "TransportID", i, 1);
 		if (val == NULL) {
 			SPDK_ERRLOG("No name provided for TransportID\n");
 			rc = -1;
-			goto end;
+			goto err;
 		}
 
 		probe_ctx->names[i] = val;
@@ -1464,87 +1698,71 @@ bdev_nvme_library_init(void)
 			if (rc < 0) {
 				SPDK_ERRLOG("Unable to parse prchk: %s\n", val);
 				rc = -1;
-				goto end;
+				goto err;
 			}
 		}
 
 		probe_ctx->count++;
 
 		if (probe_ctx->trids[i].trtype != SPDK_NVME_TRANSPORT_PCIE) {
-			struct spdk_nvme_ctrlr *ctrlr;
-			struct spdk_nvme_ctrlr_opts opts;
-
 			if (nvme_bdev_ctrlr_get(&probe_ctx->trids[i])) {
 				SPDK_ERRLOG("A controller with the provided trid (traddr: %s) already exists.\n",
 					    probe_ctx->trids[i].traddr);
 				rc = -1;
-				goto end;
+				goto err;
 			}
 
 			if (probe_ctx->trids[i].subnqn[0] == '\0') {
 				SPDK_ERRLOG("Need to provide subsystem nqn\n");
 				rc = -1;
-				goto end;
+				goto err;
 			}
+		} else {
+			local_nvme_num++;
+		}
+	}
 
-			spdk_nvme_ctrlr_get_default_ctrlr_opts(&opts, sizeof(opts));
-			opts.transport_retry_count = g_opts.retry_count;
+	for (i = 0; i < probe_ctx->count; i++) {
+		if (probe_ctx->trids[i].trtype == SPDK_NVME_TRANSPORT_PCIE) {
+			continue;
+		}
 
-			if (probe_ctx->hostnqn != NULL) {
-				snprintf(opts.hostnqn, sizeof(opts.hostnqn), "%s", probe_ctx->hostnqn);
-			}
+		connect = &init_ctx->connects[i];
+		connect->init_ctx = init_ctx;
+		connect->index = i;
 
-			if (probe_ctx->hostids[i].hostaddr[0] != '\0') {
-				snprintf(opts.src_addr, sizeof(opts.src_addr), "%s", probe_ctx->hostids[i].hostaddr);
-			}
+		spdk_nvme_ctrlr_get_default_ctrlr_opts(&connect->opts, sizeof(connect->opts));
+		connect->opts.transport_retry_count = g_opts.retry_count;
 
-			if (probe_ctx->hostids[i].hostsvcid[0] != '\0') {
-				snprintf(opts.src_svcid, sizeof(opts.src_svcid), "%s", probe_ctx->hostids[i].hostsvcid);
-			}
+		if (probe_ctx->hostnqn != NULL) {
+			snprintf(connect->opts.hostnqn, sizeof(connect->opts.hostnqn), "%s", probe_ctx->hostnqn);
+		}
 
-			ctrlr = spdk_nvme_connect(&probe_ctx->trids[i], &opts, sizeof(opts));
-			if (ctrlr == NULL) {
-				SPDK_ERRLOG("Unable to connect to provided trid (traddr: %s)\n",
-					    probe_ctx->trids[i].traddr);
-				rc = -1;
-				goto end;
-			}
+		if (probe_ctx->hostids[i].hostaddr[0] != '\0') {
+			snprintf(connect->opts.src_addr, sizeof(connect->opts.src_addr), "%s",
+				 probe_ctx->hostids[i].hostaddr);
+		}
 
-			rc = create_ctrlr(ctrlr, probe_ctx->names[i], &probe_ctx->trids[i], 0);
-			if (rc) {
-				goto end;
-			}
-		} else {
-			local_nvme_num++;
+		if (probe_ctx->hostids[i].hostsvcid[0] != '\0') {
+			snprintf(connect->opts.src_svcid, sizeof(connect->opts.src_svcid), "%s",
+				 probe_ctx->hostids[i].hostsvcid);
 		}
+
+		/* A failure to connect is reported once all of the controllers are done. */
+		connect->probe_ctx = spdk_nvme_connect_async(&probe_ctx->trids[i], &connect->opts,
+				     bdev_nvme_library_init_attach_cb);
 	}
 
 	if (local_nvme_num > 0) {
 		/* used to probe local NVMe device */
-		if (spdk_nvme_probe(NULL, probe_ctx, probe_cb, attach_cb, NULL)) {
-			rc = -1;
-			goto end;
-		}
-
-		for (i = 0; i < probe_ctx->count; i++) {
-			if (probe_ctx->trids[i].trtype != SPDK_NVME_TRANSPORT_PCIE) {
-				continue;
-			}
-
-			if (!nvme_bdev_ctrlr_get(&probe_ctx->trids[i])) {
-				SPDK_ERRLOG("NVMe SSD \"%s\" could not be found.\n", probe_ctx->trids[i].traddr);
-				SPDK_ERRLOG("Check PCIe BDF and that it is attached to UIO/VFIO driver.\n");
-			}
-		}
+		init_ctx->pcie_probe_ctx = spdk_nvme_probe_async(NULL, probe_ctx, probe_cb, attach_cb, NULL);
 	}
 
-	rc = spdk_bdev_nvme_set_hotplug(hotplug_enabled, hotplug_period, NULL, NULL);
-	if (rc) {
-		SPDK_ERRLOG("Failed to setup hotplug (%d): %s", rc, spdk_strerror(rc));
-		rc = -1;
-	}
-end:
-	free(probe_ctx);
+	init_ctx->poller = spdk_poller_register(bdev_nvme_library_init_poll, init_ctx, 0);
+
+	return 0;
+err:
+	free(init_ctx);
 	return rc;
 }
 
@@ -1734,6 +1952,32 @@ bdev_nvme_admin_passthru_done(void *ref, const struct spdk_nvme_cpl *cpl)
 	spdk_thread_send_msg(bio->orig_thread, bdev_nvme_admin_passthru_completion, bio);
 }
 
+static void
+bdev_nvme_abort_completion(void *ctx)
+{
+	struct nvme_bdev_io *bio = ctx;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+
+	if (spdk_nvme_cpl_is_error(&bio->cpl)) {
+		spdk_bdev_io_complete_nvme_status(bdev_io, bio->cpl.status.sct, bio->cpl.status.sc);
+	} else if (bio->cpl.cdw0 & 0x1) {
+		/* The controller did not abort the command. */
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	} else {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+}
+
+static void
+bdev_nvme_abort_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_bdev_io *bio = ref;
+
+	/* Abort commands complete on the admin queue, so go back to the submitting thread. */
+	bio->cpl = *cpl;
+	spdk_thread_send_msg(bio->orig_thread, bdev_nvme_abort_completion, bio);
+}
+
 static void
 bdev_nvme_queued_reset_sgl(void *ref, uint32_t sgl_offset)
 {
@@ -1860,6 +2104,155 @@ bdev_nvme_writev(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 	return rc;
 }
 
+static void
+bdev_nvme_zcopy_put_buf(struct nvme_bdev *nbdev, struct nvme_bdev_io *bio)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+
+	if (bio->cmb_buf == NULL) {
+		/* Host memory fallback buffers are released by the bdev layer. */
+		return;
+	}
+
+	spdk_nvme_ctrlr_free_cmb_io_buffer(nbdev->nvme_bdev_ctrlr->ctrlr, bio->cmb_buf,
+					   bdev_io->u.bdev.num_blocks * nbdev->disk.blocklen);
+	bio->cmb_buf = NULL;
+}
+
+static void
+bdev_nvme_zcopy_populate_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_bdev_io *bio = ref;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		/* The caller will not end a zero copy request that failed to start. */
+		bdev_nvme_zcopy_put_buf((struct nvme_bdev *)bdev_io->bdev->ctxt, bio);
+	}
+
+	spdk_bdev_io_complete_nvme_status(bdev_io, cpl->status.sct, cpl->status.sc);
+}
+
+static void
+bdev_nvme_zcopy_commit_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_bdev_io *bio = ref;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+
+	bdev_nvme_zcopy_put_buf((struct nvme_bdev *)bdev_io->bdev->ctxt, bio);
+
+	spdk_bdev_io_complete_nvme_status(bdev_io, cpl->status.sct, cpl->status.sc);
+}
+
+static int
+bdev_nvme_zcopy_populate(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+			 struct nvme_bdev_io *bio)
+{
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	int rc;
+
+	if (!bdev_io->u.bdev.zcopy.populate) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		return 0;
+	}
+
+	bio->iovs = bdev_io->u.bdev.iovs;
+	bio->iovcnt = bdev_io->u.bdev.iovcnt;
+	bio->iovpos = 0;
+	bio->iov_offset = 0;
+
+	rc = spdk_nvme_ns_cmd_readv_with_md(nbdev->ns, nvme_ch->qpair,
+					    bdev_io->u.bdev.offset_blocks,
+					    bdev_io->u.bdev.num_blocks,
+					    bdev_nvme_zcopy_populate_done, bio,
+					    nbdev->disk.dif_check_flags,
+					    bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
+					    NULL, 0, 0);
+	if (rc != 0 && rc != -ENOMEM) {
+		SPDK_ERRLOG("zcopy populate failed: rc = %d\n", rc);
+	}
+	return rc;
+}
+
+static void
+bdev_nvme_zcopy_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
+			   bool success)
+{
+	int rc;
+
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	rc = bdev_nvme_zcopy_populate((struct nvme_bdev *)bdev_io->bdev->ctxt, ch,
+				      (struct nvme_bdev_io *)bdev_io->driver_ctx);
+	if (spdk_likely(rc == 0)) {
+		return;
+	} else if (rc == -ENOMEM) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+	} else {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static int
+bdev_nvme_zcopy_start(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+		      struct nvme_bdev_io *bio)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	uint64_t len = bdev_io->u.bdev.num_blocks * nbdev->disk.blocklen;
+
+	if (bdev_io->u.bdev.iovs == NULL || bdev_io->u.bdev.iovs[0].iov_base == NULL) {
+		bio->cmb_buf = spdk_nvme_ctrlr_alloc_cmb_io_buffer(nbdev->nvme_bdev_ctrlr->ctrlr, len);
+		if (bio->cmb_buf == NULL) {
+			/* The CMB is exhausted, stage the data in host memory instead. */
+			spdk_bdev_io_get_buf(bdev_io, bdev_nvme_zcopy_get_buf_cb, len);
+			return 0;
+		}
+
+		spdk_bdev_io_set_buf(bdev_io, bio->cmb_buf, len);
+	}
+
+	return bdev_nvme_zcopy_populate(nbdev, ch, bio);
+}
+
+static int
+bdev_nvme_zcopy_end(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+		    struct nvme_bdev_io *bio)
+{
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	int rc;
+
+	if (!bdev_io->u.bdev.zcopy.commit) {
+		bdev_nvme_zcopy_put_buf(nbdev, bio);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		return 0;
+	}
+
+	SPDK_DEBUGLOG(SPDK_LOG_BDEV_NVME, "zcopy commit %lu blocks with offset %#lx\n",
+		      bdev_io->u.bdev.num_blocks, bdev_io->u.bdev.offset_blocks);
+
+	bio->iovs = bdev_io->u.bdev.iovs;
+	bio->iovcnt = bdev_io->u.bdev.iovcnt;
+	bio->iovpos = 0;
+	bio->iov_offset = 0;
+
+	rc = spdk_nvme_ns_cmd_writev_with_md(nbdev->ns, nvme_ch->qpair,
+					     bdev_io->u.bdev.offset_blocks,
+					     bdev_io->u.bdev.num_blocks,
+					     bdev_nvme_zcopy_commit_done, bio,
+					     nbdev->disk.dif_check_flags,
+					     bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
+					     NULL, 0, 0);
+	if (rc != 0 && rc != -ENOMEM) {
+		SPDK_ERRLOG("zcopy commit failed: rc = %d\n", rc);
+	}
+	return rc;
+}
+
 static int
 bdev_nvme_unmap(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 		struct nvme_bdev_io *bio,
@@ -1980,6 +2373,231 @@ bdev_nvme_io_passthru_md(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
 			(uint32_t)nbytes, md_buf, bdev_nvme_queued_done, bio);
 }
 
+static int
+bdev_nvme_abort(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+		struct nvme_bdev_io *bio, struct nvme_bdev_io *bio_to_abort)
+{
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+	int rc;
+
+	bio->orig_thread = spdk_io_channel_get_thread(ch);
+
+	rc = spdk_nvme_ctrlr_cmd_abort_ext(nbdev->nvme_bdev_ctrlr->ctrlr, nvme_ch->qpair,
+					   bio_to_abort, bdev_nvme_abort_done, bio);
+	if (rc == -ENOENT) {
+		/* The I/O is not outstanding in the NVMe driver, e.g. it is waiting for a buffer. */
+		SPDK_DEBUGLOG(SPDK_LOG_BDEV_NVME, "I/O %p to abort was not found\n", bio_to_abort);
+	}
+
+	return rc;
+}
+
+static void
+bdev_nvme_zone_appendv_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx((struct nvme_bdev_io *)ref);
+
+	if (!spdk_nvme_cpl_is_error(cpl)) {
+		/* The assigned LBA is split between cdw0 (low) and the following dword (high). */
+		bdev_io->u.bdev.offset_blocks = ((uint64_t)cpl->rsvd1 << 32) | cpl->cdw0;
+	}
+
+	spdk_bdev_io_complete_nvme_status(bdev_io, cpl->status.sct, cpl->status.sc);
+}
+
+static int
+bdev_nvme_zone_appendv(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+		       struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
+		       void *md, uint64_t lba_count, uint64_t zslba)
+{
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+	int rc;
+
+	SPDK_DEBUGLOG(SPDK_LOG_BDEV_NVME, "zone append %lu blocks to zone start lba %#lx\n",
+		      lba_count, zslba);
+
+	bio->iovs = iov;
+	bio->iovcnt = iovcnt;
+	bio->iovpos = 0;
+	bio->iov_offset = 0;
+
+	rc = spdk_nvme_zns_zone_appendv_with_md(nbdev->ns, nvme_ch->qpair, zslba, lba_count,
+						bdev_nvme_zone_appendv_done, bio,
+						nbdev->disk.dif_check_flags,
+						bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
+						md, 0, 0);
+
+	if (rc != 0 && rc != -ENOMEM) {
+		SPDK_ERRLOG("zone append failed: rc = %d\n", rc);
+	}
+	return rc;
+}
+
+static int
+bdev_nvme_zone_management(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+			  struct nvme_bdev_io *bio, uint64_t zone_id,
+			  enum spdk_bdev_zone_action action)
+{
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+
+	switch (action) {
+	case SPDK_BDEV_ZONE_CLOSE:
+		return spdk_nvme_zns_close_zone(nbdev->ns, nvme_ch->qpair, zone_id, false,
+						bdev_nvme_queued_done, bio);
+	case SPDK_BDEV_ZONE_FINISH:
+		return spdk_nvme_zns_finish_zone(nbdev->ns, nvme_ch->qpair, zone_id, false,
+						 bdev_nvme_queued_done, bio);
+	case SPDK_BDEV_ZONE_OPEN:
+		return spdk_nvme_zns_open_zone(nbdev->ns, nvme_ch->qpair, zone_id, false,
+					       bdev_nvme_queued_done, bio);
+	case SPDK_BDEV_ZONE_RESET:
+		return spdk_nvme_zns_reset_zone(nbdev->ns, nvme_ch->qpair, zone_id, false,
+						bdev_nvme_queued_done, bio);
+	default:
+		return -EINVAL;
+	}
+}
+
+static int
+bdev_nvme_fill_zone_info(struct spdk_bdev_zone_info *info, const struct spdk_nvme_zns_zone_desc *desc)
+{
+	info->zone_id = desc->zslba;
+	info->write_pointer = desc->wp;
+	info->capacity = desc->zcap;
+
+	switch (desc->zs) {
+	case SPDK_NVME_ZONE_STATE_EMPTY:
+		info->state = SPDK_BDEV_ZONE_STATE_EMPTY;
+		break;
+	case SPDK_NVME_ZONE_STATE_IOPEN:
+	case SPDK_NVME_ZONE_STATE_EOPEN:
+		info->state = SPDK_BDEV_ZONE_STATE_OPEN;
+		break;
+	case SPDK_NVME_ZONE_STATE_CLOSED:
+		info->state = SPDK_BDEV_ZONE_STATE_CLOSED;
+		break;
+	case SPDK_NVME_ZONE_STATE_RONLY:
+		info->state = SPDK_BDEV_ZONE_STATE_READ_ONLY;
+		break;
+	case SPDK_NVME_ZONE_STATE_FULL:
+		info->state = SPDK_BDEV_ZONE_STATE_FULL;
+		break;
+	case SPDK_NVME_ZONE_STATE_OFFLINE:
+		info->state = SPDK_BDEV_ZONE_STATE_OFFLINE;
+		break;
+	default:
+		SPDK_ERRLOG("Invalid zone state: %#x in zone report\n", desc->zs);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int bdev_nvme_get_zone_info_next(struct nvme_bdev *nbdev, struct nvme_io_channel *nvme_ch,
+					struct nvme_bdev_io *bio);
+
+static void
+bdev_nvme_get_zone_info_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_bdev_io *bio = ref;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	struct nvme_bdev *nbdev = (struct nvme_bdev *)bdev_io->bdev->ctxt;
+	struct spdk_io_channel *ch = spdk_bdev_io_get_io_channel(bdev_io);
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_nvme_zns_zone_report *report = bio->zone_report_buf;
+	struct spdk_bdev_zone_info *info = bdev_io->u.zone_mgmt.buf;
+	uint64_t i;
+	int rc;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		goto out_complete_nvme;
+	}
+
+	if (report->nr_zones == 0) {
+		/* The range was validated by the bdev layer, an empty report is a device error. */
+		goto out_complete_failed;
+	}
+
+	for (i = 0; i < report->nr_zones && bio->handled_zones < bdev_io->u.zone_mgmt.num_zones; i++) {
+		rc = bdev_nvme_fill_zone_info(&info[bio->handled_zones], &report->descs[i]);
+		if (rc != 0) {
+			goto out_complete_failed;
+		}
+		bio->handled_zones++;
+	}
+
+	if (bio->handled_zones < bdev_io->u.zone_mgmt.num_zones) {
+		rc = bdev_nvme_get_zone_info_next(nbdev, nvme_ch, bio);
+		if (rc == 0) {
+			return;
+		}
+		goto out_complete_failed;
+	}
+
+out_complete_nvme:
+	spdk_dma_free(bio->zone_report_buf);
+	bio->zone_report_buf = NULL;
+	spdk_bdev_io_complete_nvme_status(bdev_io, cpl->status.sct, cpl->status.sc);
+	return;
+
+out_complete_failed:
+	spdk_dma_free(bio->zone_report_buf);
+	bio->zone_report_buf = NULL;
+	spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+/* Size of the zone report buffer needed for the zones that are still to be reported. */
+static uint32_t
+bdev_nvme_zone_report_size(struct nvme_bdev *nbdev, uint64_t num_zones)
+{
+	uint32_t max_xfer = spdk_nvme_ns_get_max_io_xfer_size(nbdev->ns);
+	uint64_t max_zones;
+
+	max_zones = (max_xfer - sizeof(struct spdk_nvme_zns_zone_report)) /
+		    sizeof(struct spdk_nvme_zns_zone_desc);
+	num_zones = spdk_min(num_zones, max_zones);
+
+	return sizeof(struct spdk_nvme_zns_zone_report) + num_zones * sizeof(struct spdk_nvme_zns_zone_desc);
+}
+
+static int
+bdev_nvme_get_zone_info_next(struct nvme_bdev *nbdev, struct nvme_io_channel *nvme_ch,
+			     struct nvme_bdev_io *bio)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	uint64_t remaining = bdev_io->u.zone_mgmt.num_zones - bio->handled_zones;
+	uint64_t slba = bdev_io->u.zone_mgmt.zone_id + bio->handled_zones * nbdev->disk.zone_size;
+
+	return spdk_nvme_zns_report_zones(nbdev->ns, nvme_ch->qpair, bio->zone_report_buf,
+					  bdev_nvme_zone_report_size(nbdev, remaining), slba,
+					  SPDK_NVME_ZRA_LIST_ALL, true,
+					  bdev_nvme_get_zone_info_done, bio);
+}
+
+static int
+bdev_nvme_get_zone_info(struct nvme_bdev *nbdev, struct spdk_io_channel *ch,
+			struct nvme_bdev_io *bio, uint64_t zone_id, uint32_t num_zones,
+			struct spdk_bdev_zone_info *info)
+{
+	struct nvme_io_channel *nvme_ch = spdk_io_channel_get_ctx(ch);
+	int rc;
+
+	bio->handled_zones = 0;
+	bio->zone_report_buf = spdk_dma_zmalloc(bdev_nvme_zone_report_size(nbdev, num_zones),
+						0x1000, NULL);
+	if (!bio->zone_report_buf) {
+		return -ENOMEM;
+	}
+
+	rc = bdev_nvme_get_zone_info_next(nbdev, nvme_ch, bio);
+	if (rc != 0) {
+		spdk_dma_free(bio->zone_report_buf);
+		bio->zone_report_buf = NULL;
+	}
+
+	return rc;
+}
+
 static void
 bdev_nvme_get_spdk_running_config(FILE *fp)
 {
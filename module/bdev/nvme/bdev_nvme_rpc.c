@@ -332,7 +332,8 @@ static void
 spdk_rpc_dump_nvme_controller_info(struct spdk_json_write_ctx *w,
 				   struct nvme_bdev_ctrlr *nvme_bdev_ctrlr)
 {
-	struct spdk_nvme_transport_id	*trid;
+	struct spdk_nvme_transport_id		*trid;
+	struct spdk_nvme_ctrlr_init_stats	stats;
 
 	trid = &nvme_bdev_ctrlr->trid;
 
@@ -343,6 +344,16 @@ spdk_rpc_dump_nvme_controller_info(struct spdk_json_write_ctx *w,
 	nvme_bdev_dump_trid_json(trid, w);
 	spdk_json_write_object_end(w);
 
+	spdk_nvme_ctrlr_get_init_stats(nvme_bdev_ctrlr->ctrlr, &stats);
+	spdk_json_write_named_object_begin(w, "init_time_us");
+	spdk_json_write_named_uint64(w, "total", stats.total_us);
+	spdk_json_write_named_uint64(w, "construct", stats.construct_us);
+	spdk_json_write_named_uint64(w, "enable", stats.enable_us);
+	spdk_json_write_named_uint64(w, "identify", stats.identify_us);
+	spdk_json_write_named_uint64(w, "namespaces", stats.namespaces_us);
+	spdk_json_write_named_uint64(w, "configure", stats.configure_us);
+	spdk_json_write_object_end(w);
+
 	spdk_json_write_object_end(w);
 }
 
@@ -60,6 +60,8 @@ struct nvme_bdev_ctrlr {
 	 * NVMe controllers are not included.
 	 */
 	uint32_t			prchk_flags;
+	/** True if the controller memory buffer can hold I/O data (zero copy support). */
+	bool				cmb_io_data;
 	uint32_t			num_ns;
 	/** Array of bdevs indexed by nsid - 1 */
 	struct nvme_bdev		*bdevs;
@@ -257,6 +257,13 @@ spdk_rpc_dump_bdev_info(struct spdk_json_write_ctx *w,
 		}
 	}
 
+	if (spdk_bdev_is_zoned(bdev)) {
+		spdk_json_write_named_bool(w, "zoned", true);
+		spdk_json_write_named_uint64(w, "zone_size", spdk_bdev_get_zone_size(bdev));
+		spdk_json_write_named_uint32(w, "max_open_zones", spdk_bdev_get_max_open_zones(bdev));
+		spdk_json_write_named_uint32(w, "optimal_open_zones", spdk_bdev_get_optimal_open_zones(bdev));
+	}
+
 	spdk_json_write_named_object_begin(w, "assigned_rate_limits");
 	spdk_bdev_get_qos_rate_limits(bdev, qos_limits);
 	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
@@ -283,6 +290,16 @@ spdk_rpc_dump_bdev_info(struct spdk_json_write_ctx *w,
 				   spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_NVME_ADMIN));
 	spdk_json_write_named_bool(w, "nvme_io",
 				   spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_NVME_IO));
+	spdk_json_write_named_bool(w, "abort",
+				   spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ABORT));
+	if (spdk_bdev_is_zoned(bdev)) {
+		spdk_json_write_named_bool(w, "get_zone_info",
+					   spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_GET_ZONE_INFO));
+		spdk_json_write_named_bool(w, "zone_management",
+					   spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT));
+		spdk_json_write_named_bool(w, "zone_append",
+					   spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_ZONE_APPEND));
+	}
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_named_object_begin(w, "driver_specific");
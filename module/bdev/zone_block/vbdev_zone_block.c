@@ -0,0 +1,914 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Zoned block device emulator. Exposes a regular bdev as a zoned bdev so
+ * zoned users (zone append, zone management) can be developed and tested
+ * without zoned hardware. Zone state and write pointers are kept in memory
+ * only.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "vbdev_zone_block.h"
+#include "spdk/rpc.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "spdk/bdev_module.h"
+#include "spdk_internal/log.h"
+
+static int zone_block_init(void);
+static void zone_block_finish(void);
+static int zone_block_config_json(struct spdk_json_write_ctx *w);
+static void zone_block_examine(struct spdk_bdev *bdev);
+
+static struct spdk_bdev_module bdev_zoned_if = {
+	.name = "bdev_zoned_block",
+	.module_init = zone_block_init,
+	.module_fini = zone_block_finish,
+	.config_text = NULL,
+	.config_json = zone_block_config_json,
+	.examine_config = zone_block_examine,
+};
+
+SPDK_BDEV_MODULE_REGISTER(bdev_zoned_block, &bdev_zoned_if)
+
+/* List of block vbdev names and their base bdevs via configuration file.
+ * Used so we can parse the conf once at init and use this list in examine().
+ */
+struct bdev_zone_block_config {
+	char					*vbdev_name;
+	char					*bdev_name;
+	uint64_t				zone_capacity;
+	uint64_t				optimal_open_zones;
+	TAILQ_ENTRY(bdev_zone_block_config)	link;
+};
+static TAILQ_HEAD(, bdev_zone_block_config) g_bdev_configs = TAILQ_HEAD_INITIALIZER(g_bdev_configs);
+
+struct block_zone {
+	struct spdk_bdev_zone_info	zone_info;
+	pthread_spinlock_t		lock;
+};
+
+/* List of block vbdevs and associated info for each. */
+struct bdev_zone_block {
+	struct spdk_bdev		bdev;    /* the block zoned bdev */
+	struct spdk_bdev_desc		*base_desc; /* its descriptor we get from open */
+	struct block_zone		*zones; /* array of zones */
+	uint64_t			num_zones; /* number of zones */
+	uint64_t			zone_capacity; /* zone capacity */
+	uint64_t			zone_shift; /* log2 of zone_size */
+	TAILQ_ENTRY(bdev_zone_block)	link;
+};
+static TAILQ_HEAD(, bdev_zone_block) g_bdev_nodes = TAILQ_HEAD_INITIALIZER(g_bdev_nodes);
+
+struct zone_block_io_channel {
+	struct spdk_io_channel	*base_ch; /* IO channel of base device */
+};
+
+static int
+zone_block_init(void)
+{
+	return 0;
+}
+
+static void
+zone_block_remove_config(struct bdev_zone_block_config *name)
+{
+	TAILQ_REMOVE(&g_bdev_configs, name, link);
+	free(name->bdev_name);
+	free(name->vbdev_name);
+	free(name);
+}
+
+static void
+zone_block_finish(void)
+{
+	struct bdev_zone_block_config *name;
+
+	while ((name = TAILQ_FIRST(&g_bdev_configs))) {
+		zone_block_remove_config(name);
+	}
+}
+
+static int
+zone_block_config_json(struct spdk_json_write_ctx *w)
+{
+	struct bdev_zone_block *bdev_node;
+	struct spdk_bdev *base_bdev = NULL;
+
+	TAILQ_FOREACH(bdev_node, &g_bdev_nodes, link) {
+		base_bdev = spdk_bdev_desc_get_bdev(bdev_node->base_desc);
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_zone_block_create");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "base_bdev", spdk_bdev_get_name(base_bdev));
+		spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&bdev_node->bdev));
+		spdk_json_write_named_uint64(w, "zone_capacity", bdev_node->zone_capacity);
+		spdk_json_write_named_uint64(w, "optimal_open_zones", bdev_node->bdev.optimal_open_zones);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+
+	return 0;
+}
+
+/* Callback for unregistering the IO device. */
+static void
+_device_unregister_cb(void *io_device)
+{
+	struct bdev_zone_block *bdev_node = io_device;
+	uint64_t i;
+
+	free(bdev_node->bdev.name);
+	for (i = 0; i < bdev_node->num_zones; i++) {
+		pthread_spin_destroy(&bdev_node->zones[i].lock);
+	}
+	free(bdev_node->zones);
+	free(bdev_node);
+}
+
+static int
+zone_block_destruct(void *ctx)
+{
+	struct bdev_zone_block *bdev_node = (struct bdev_zone_block *)ctx;
+
+	TAILQ_REMOVE(&g_bdev_nodes, bdev_node, link);
+
+	/* Unclaim the underlying bdev. */
+	spdk_bdev_module_release_bdev(spdk_bdev_desc_get_bdev(bdev_node->base_desc));
+
+	/* Close the underlying bdev. */
+	spdk_bdev_close(bdev_node->base_desc);
+
+	/* Unregister the io_device. */
+	spdk_io_device_unregister(bdev_node, _device_unregister_cb);
+
+	return 0;
+}
+
+static struct block_zone *
+zone_block_get_zone_containing_lba(struct bdev_zone_block *bdev_node, uint64_t lba)
+{
+	size_t index = lba >> bdev_node->zone_shift;
+
+	if (index >= bdev_node->num_zones) {
+		return NULL;
+	}
+
+	return &bdev_node->zones[index];
+}
+
+static struct block_zone *
+zone_block_get_zone_by_slba(struct bdev_zone_block *bdev_node, uint64_t start_lba)
+{
+	struct block_zone *zone = zone_block_get_zone_containing_lba(bdev_node, start_lba);
+
+	if (zone && zone->zone_info.zone_id == start_lba) {
+		return zone;
+	} else {
+		return NULL;
+	}
+}
+
+/* Translate an LBA of the zoned bdev into an LBA of the base bdev. Zones are
+ * packed back to back on the base bdev, so the unused tail of each zone (the
+ * difference between zone size and zone capacity) takes no space there.
+ */
+static uint64_t
+zone_block_base_lba(struct bdev_zone_block *bdev_node, uint64_t lba)
+{
+	uint64_t index = lba >> bdev_node->zone_shift;
+	uint64_t offset = lba & (bdev_node->bdev.zone_size - 1);
+
+	return index * bdev_node->zone_capacity + offset;
+}
+
+static int
+zone_block_get_zone_info(struct bdev_zone_block *bdev_node, struct spdk_bdev_io *bdev_io)
+{
+	struct block_zone *zone;
+	struct spdk_bdev_zone_info *zone_info = bdev_io->u.zone_mgmt.buf;
+	uint64_t zone_id = bdev_io->u.zone_mgmt.zone_id;
+	size_t i;
+
+	/* User can request info for more zones than exist, need to check both internal and user
+	 * boundaries
+	 */
+	for (i = 0; i < bdev_io->u.zone_mgmt.num_zones; i++, zone_id += bdev_node->bdev.zone_size) {
+		zone = zone_block_get_zone_by_slba(bdev_node, zone_id);
+		if (!zone) {
+			return -EINVAL;
+		}
+
+		pthread_spin_lock(&zone->lock);
+		memcpy(&zone_info[i], &zone->zone_info, sizeof(*zone_info));
+		pthread_spin_unlock(&zone->lock);
+	}
+
+	return 0;
+}
+
+static int
+zone_block_open_zone(struct block_zone *zone)
+{
+	pthread_spin_lock(&zone->lock);
+
+	switch (zone->zone_info.state) {
+	case SPDK_BDEV_ZONE_STATE_EMPTY:
+	case SPDK_BDEV_ZONE_STATE_OPEN:
+	case SPDK_BDEV_ZONE_STATE_CLOSED:
+		zone->zone_info.state = SPDK_BDEV_ZONE_STATE_OPEN;
+		pthread_spin_unlock(&zone->lock);
+		return 0;
+	default:
+		pthread_spin_unlock(&zone->lock);
+		return -EINVAL;
+	}
+}
+
+static void
+zone_block_reset_zone(struct block_zone *zone)
+{
+	pthread_spin_lock(&zone->lock);
+	zone->zone_info.write_pointer = zone->zone_info.zone_id;
+	zone->zone_info.state = SPDK_BDEV_ZONE_STATE_EMPTY;
+	pthread_spin_unlock(&zone->lock);
+}
+
+static int
+zone_block_close_zone(struct block_zone *zone)
+{
+	pthread_spin_lock(&zone->lock);
+
+	switch (zone->zone_info.state) {
+	case SPDK_BDEV_ZONE_STATE_OPEN:
+		if (zone->zone_info.write_pointer == zone->zone_info.zone_id) {
+			/* A zone that was never written goes back to the empty state. */
+			zone->zone_info.state = SPDK_BDEV_ZONE_STATE_EMPTY;
+		} else {
+			zone->zone_info.state = SPDK_BDEV_ZONE_STATE_CLOSED;
+		}
+		pthread_spin_unlock(&zone->lock);
+		return 0;
+	case SPDK_BDEV_ZONE_STATE_EMPTY:
+	case SPDK_BDEV_ZONE_STATE_CLOSED:
+		pthread_spin_unlock(&zone->lock);
+		return 0;
+	default:
+		pthread_spin_unlock(&zone->lock);
+		return -EINVAL;
+	}
+}
+
+static int
+zone_block_finish_zone(struct block_zone *zone)
+{
+	pthread_spin_lock(&zone->lock);
+
+	switch (zone->zone_info.state) {
+	case SPDK_BDEV_ZONE_STATE_READ_ONLY:
+	case SPDK_BDEV_ZONE_STATE_OFFLINE:
+		pthread_spin_unlock(&zone->lock);
+		return -EINVAL;
+	default:
+		zone->zone_info.write_pointer = zone->zone_info.zone_id + zone->zone_info.capacity;
+		zone->zone_info.state = SPDK_BDEV_ZONE_STATE_FULL;
+		pthread_spin_unlock(&zone->lock);
+		return 0;
+	}
+}
+
+static int
+zone_block_zone_management(struct bdev_zone_block *bdev_node, struct spdk_bdev_io *bdev_io)
+{
+	struct block_zone *zone;
+
+	zone = zone_block_get_zone_by_slba(bdev_node, bdev_io->u.zone_mgmt.zone_id);
+	if (!zone) {
+		return -EINVAL;
+	}
+
+	switch (bdev_io->u.zone_mgmt.zone_action) {
+	case SPDK_BDEV_ZONE_RESET:
+		zone_block_reset_zone(zone);
+		return 0;
+	case SPDK_BDEV_ZONE_OPEN:
+		return zone_block_open_zone(zone);
+	case SPDK_BDEV_ZONE_CLOSE:
+		return zone_block_close_zone(zone);
+	case SPDK_BDEV_ZONE_FINISH:
+		return zone_block_finish_zone(zone);
+	default:
+		return -EINVAL;
+	}
+}
+
+static void
+_zone_block_complete_write(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *orig_io = cb_arg;
+	int status = success ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED;
+
+	/* Complete the original IO and then free the one that we created here
+	 * as a result of issuing an IO via submit_request.
+	 */
+	spdk_bdev_io_complete(orig_io, status);
+	spdk_bdev_free_io(bdev_io);
+}
+
+/*
+ * Reserve room for a write at the write pointer. For regular writes the
+ * request has to start exactly at the write pointer, for appends the write
+ * pointer is where the data goes. The write pointer is advanced before the
+ * data reaches the base bdev so that concurrent appends to the same zone get
+ * disjoint ranges without waiting for each other.
+ */
+static int
+zone_block_reserve(struct block_zone *zone, struct spdk_bdev_io *bdev_io, uint64_t *lba)
+{
+	uint64_t len = bdev_io->u.bdev.num_blocks;
+	uint64_t zone_end;
+
+	pthread_spin_lock(&zone->lock);
+
+	switch (zone->zone_info.state) {
+	case SPDK_BDEV_ZONE_STATE_EMPTY:
+	case SPDK_BDEV_ZONE_STATE_CLOSED:
+	case SPDK_BDEV_ZONE_STATE_OPEN:
+		break;
+	default:
+		pthread_spin_unlock(&zone->lock);
+		return -EINVAL;
+	}
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE &&
+	    bdev_io->u.bdev.offset_blocks != zone->zone_info.write_pointer) {
+		pthread_spin_unlock(&zone->lock);
+		SPDK_ERRLOG("Trying to write to zone with invalid address (lba 0x%" PRIx64 ", wp 0x%" PRIx64 ")\n",
+			    bdev_io->u.bdev.offset_blocks, zone->zone_info.write_pointer);
+		return -EINVAL;
+	}
+
+	zone_end = zone->zone_info.zone_id + zone->zone_info.capacity;
+	if (zone->zone_info.write_pointer + len > zone_end) {
+		pthread_spin_unlock(&zone->lock);
+		SPDK_ERRLOG("Write exceeds zone capacity (lba 0x%" PRIx64 ", len 0x%" PRIx64 ", wp 0x%" PRIx64
+			    ")\n", bdev_io->u.bdev.offset_blocks, len, zone->zone_info.write_pointer);
+		return -EINVAL;
+	}
+
+	/* Writing implicitly opens the zone. */
+	zone->zone_info.state = SPDK_BDEV_ZONE_STATE_OPEN;
+	*lba = zone->zone_info.write_pointer;
+	zone->zone_info.write_pointer += len;
+	if (zone->zone_info.write_pointer == zone_end) {
+		zone->zone_info.state = SPDK_BDEV_ZONE_STATE_FULL;
+	}
+
+	pthread_spin_unlock(&zone->lock);
+
+	return 0;
+}
+
+static int
+zone_block_write(struct bdev_zone_block *bdev_node, struct zone_block_io_channel *ch,
+		 struct spdk_bdev_io *bdev_io)
+{
+	struct block_zone *zone;
+	uint64_t lba;
+	int rc;
+
+	zone = zone_block_get_zone_containing_lba(bdev_node, bdev_io->u.bdev.offset_blocks);
+	if (!zone) {
+		SPDK_ERRLOG("Trying to write to invalid zone (lba 0x%" PRIx64 ")\n",
+			    bdev_io->u.bdev.offset_blocks);
+		return -EINVAL;
+	}
+
+	rc = zone_block_reserve(zone, bdev_io, &lba);
+	if (rc != 0) {
+		return rc;
+	}
+
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_ZONE_APPEND) {
+		/* Reported back through spdk_bdev_io_get_append_location(). */
+		bdev_io->u.bdev.offset_blocks = lba;
+	}
+
+	rc = spdk_bdev_writev_blocks(bdev_node->base_desc, ch->base_ch,
+				     bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+				     zone_block_base_lba(bdev_node, lba), bdev_io->u.bdev.num_blocks,
+				     _zone_block_complete_write, bdev_io);
+	if (rc != 0) {
+		/* Nothing was written, give the reserved range back if it is still the tail. */
+		pthread_spin_lock(&zone->lock);
+		if (zone->zone_info.write_pointer == lba + bdev_io->u.bdev.num_blocks) {
+			zone->zone_info.write_pointer = lba;
+			zone->zone_info.state = SPDK_BDEV_ZONE_STATE_OPEN;
+		}
+		pthread_spin_unlock(&zone->lock);
+	}
+
+	return rc;
+}
+
+static void
+_zone_block_complete_read(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *orig_io = cb_arg;
+	int status = success ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED;
+
+	spdk_bdev_io_complete(orig_io, status);
+	spdk_bdev_free_io(bdev_io);
+}
+
+static int
+zone_block_read(struct bdev_zone_block *bdev_node, struct zone_block_io_channel *ch,
+		struct spdk_bdev_io *bdev_io)
+{
+	struct block_zone *zone;
+	uint64_t len = bdev_io->u.bdev.num_blocks;
+	uint64_t lba = bdev_io->u.bdev.offset_blocks;
+
+	zone = zone_block_get_zone_containing_lba(bdev_node, lba);
+	if (!zone) {
+		SPDK_ERRLOG("Trying to read from invalid zone (lba 0x%" PRIx64 ")\n", lba);
+		return -EINVAL;
+	}
+
+	/* The bdev layer splits I/O on zone boundaries, only the capacity needs checking. */
+	if (lba + len > zone->zone_info.zone_id + zone->zone_info.capacity) {
+		SPDK_ERRLOG("Read exceeds zone capacity (lba 0x%" PRIx64 ", len 0x%" PRIx64 ")\n",
+			    lba, len);
+		return -EINVAL;
+	}
+
+	return spdk_bdev_readv_blocks(bdev_node->base_desc, ch->base_ch,
+				      bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+				      zone_block_base_lba(bdev_node, lba), len,
+				      _zone_block_complete_read, bdev_io);
+}
+
+static void
+zone_block_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
+			   bool success)
+{
+	struct bdev_zone_block *bdev_node = SPDK_CONTAINEROF(bdev_io->bdev, struct bdev_zone_block, bdev);
+	struct zone_block_io_channel *dev_ch = spdk_io_channel_get_ctx(ch);
+	int rc;
+
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	rc = zone_block_read(bdev_node, dev_ch, bdev_io);
+	if (rc == -ENOMEM) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+	} else if (rc != 0) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+zone_block_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_zone_block *bdev_node = SPDK_CONTAINEROF(bdev_io->bdev, struct bdev_zone_block, bdev);
+	struct zone_block_io_channel *dev_ch = spdk_io_channel_get_ctx(ch);
+	int rc = 0;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_GET_ZONE_INFO:
+		rc = zone_block_get_zone_info(bdev_node, bdev_io);
+		if (rc == 0) {
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		}
+		break;
+	case SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT:
+		rc = zone_block_zone_management(bdev_node, bdev_io);
+		if (rc == 0) {
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		}
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
+		rc = zone_block_write(bdev_node, dev_ch, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_READ:
+		spdk_bdev_io_get_buf(bdev_io, zone_block_read_get_buf_cb,
+				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
+		break;
+	default:
+		SPDK_ERRLOG("vbdev_block: unknown I/O type %u\n", bdev_io->type);
+		rc = -ENOTSUP;
+		break;
+	}
+
+	if (rc != 0) {
+		if (rc == -ENOMEM) {
+			/* The bdev layer retries NOMEM requests once resources free up. */
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
+		} else {
+			SPDK_ERRLOG("ERROR on bdev_io submission!\n");
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		}
+	}
+}
+
+static bool
+zone_block_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
+{
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_GET_ZONE_INFO:
+	case SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_ZONE_APPEND:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static struct spdk_io_channel *
+zone_block_get_io_channel(void *ctx)
+{
+	struct bdev_zone_block *bdev_node = (struct bdev_zone_block *)ctx;
+
+	return spdk_get_io_channel(bdev_node);
+}
+
+static int
+zone_block_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+{
+	struct bdev_zone_block *bdev_node = (struct bdev_zone_block *)ctx;
+	struct spdk_bdev *base_bdev = spdk_bdev_desc_get_bdev(bdev_node->base_desc);
+
+	spdk_json_write_name(w, "zoned_block");
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&bdev_node->bdev));
+	spdk_json_write_named_string(w, "base_bdev", spdk_bdev_get_name(base_bdev));
+	spdk_json_write_named_uint64(w, "zone_capacity", bdev_node->zone_capacity);
+	spdk_json_write_named_uint64(w, "optimal_open_zones", bdev_node->bdev.optimal_open_zones);
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+/* When we register our vbdev this is how we specify our entry points. */
+static const struct spdk_bdev_fn_table zone_block_fn_table = {
+	.destruct		= zone_block_destruct,
+	.submit_request		= zone_block_submit_request,
+	.io_type_supported	= zone_block_io_type_supported,
+	.get_io_channel		= zone_block_get_io_channel,
+	.dump_info_json		= zone_block_dump_info_json,
+};
+
+static void
+zone_block_base_bdev_hotremove_cb(void *ctx)
+{
+	struct bdev_zone_block *bdev_node, *tmp;
+	struct spdk_bdev *bdev_find = ctx;
+
+	TAILQ_FOREACH_SAFE(bdev_node, &g_bdev_nodes, link, tmp) {
+		if (bdev_find == spdk_bdev_desc_get_bdev(bdev_node->base_desc)) {
+			spdk_bdev_unregister(&bdev_node->bdev, NULL, NULL);
+		}
+	}
+}
+
+static int
+_zone_block_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	struct zone_block_io_channel *bdev_ch = ctx_buf;
+	struct bdev_zone_block *bdev_node = io_device;
+
+	bdev_ch->base_ch = spdk_bdev_get_io_channel(bdev_node->base_desc);
+	if (!bdev_ch->base_ch) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+_zone_block_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct zone_block_io_channel *bdev_ch = ctx_buf;
+
+	spdk_put_io_channel(bdev_ch->base_ch);
+}
+
+static int
+zone_block_insert_name(const char *bdev_name, const char *vbdev_name, uint64_t zone_capacity,
+		       uint64_t optimal_open_zones)
+{
+	struct bdev_zone_block_config *name;
+
+	TAILQ_FOREACH(name, &g_bdev_configs, link) {
+		if (strcmp(vbdev_name, name->vbdev_name) == 0) {
+			SPDK_ERRLOG("block zoned bdev %s already exists\n", vbdev_name);
+			return -EEXIST;
+		}
+		if (strcmp(bdev_name, name->bdev_name) == 0) {
+			SPDK_ERRLOG("base bdev %s already claimed\n", bdev_name);
+			return -EEXIST;
+		}
+	}
+
+	name = calloc(1, sizeof(*name));
+	if (!name) {
+		SPDK_ERRLOG("could not allocate bdev_names\n");
+		return -ENOMEM;
+	}
+
+	name->bdev_name = strdup(bdev_name);
+	if (!name->bdev_name) {
+		SPDK_ERRLOG("could not allocate name->bdev_name\n");
+		free(name);
+		return -ENOMEM;
+	}
+
+	name->vbdev_name = strdup(vbdev_name);
+	if (!name->vbdev_name) {
+		SPDK_ERRLOG("could not allocate name->vbdev_name\n");
+		free(name->bdev_name);
+		free(name);
+		return -ENOMEM;
+	}
+
+	name->zone_capacity = zone_capacity;
+	name->optimal_open_zones = optimal_open_zones;
+
+	TAILQ_INSERT_TAIL(&g_bdev_configs, name, link);
+
+	return 0;
+}
+
+static int
+zone_block_init_zone_info(struct bdev_zone_block *bdev_node)
+{
+	size_t i;
+	struct block_zone *zone;
+	int rc = 0;
+
+	for (i = 0; i < bdev_node->num_zones; i++) {
+		zone = &bdev_node->zones[i];
+		zone->zone_info.zone_id = bdev_node->bdev.zone_size * i;
+		zone->zone_info.capacity = bdev_node->zone_capacity;
+		zone->zone_info.write_pointer = zone->zone_info.zone_id;
+		zone->zone_info.state = SPDK_BDEV_ZONE_STATE_EMPTY;
+		if (pthread_spin_init(&zone->lock, PTHREAD_PROCESS_PRIVATE)) {
+			SPDK_ERRLOG("pthread_spin_init() failed\n");
+			rc = -ENOMEM;
+			break;
+		}
+	}
+
+	if (rc) {
+		for (; i > 0; i--) {
+			pthread_spin_destroy(&bdev_node->zones[i - 1].lock);
+		}
+	}
+
+	return rc;
+}
+
+static int
+zone_block_register(struct spdk_bdev *base_bdev)
+{
+	struct bdev_zone_block_config *name, *tmp;
+	struct bdev_zone_block *bdev_node = NULL;
+	uint64_t zone_size, i;
+	int rc = 0;
+
+	/* Check our list of names from config versus this bdev and if
+	 * there's a match, create the bdev_node & bdev accordingly.
+	 */
+	TAILQ_FOREACH_SAFE(name, &g_bdev_configs, link, tmp) {
+		if (strcmp(name->bdev_name, base_bdev->name) != 0) {
+			continue;
+		}
+
+		if (spdk_bdev_is_zoned(base_bdev)) {
+			SPDK_ERRLOG("Base bdev %s is already a zoned bdev\n", base_bdev->name);
+			rc = -EEXIST;
+			goto free_config;
+		}
+
+		bdev_node = calloc(1, sizeof(struct bdev_zone_block));
+		if (!bdev_node) {
+			rc = -ENOMEM;
+			SPDK_ERRLOG("could not allocate bdev_node\n");
+			goto free_config;
+		}
+
+		/* The base bdev that we're attaching to. */
+		bdev_node->bdev.name = strdup(name->vbdev_name);
+		if (!bdev_node->bdev.name) {
+			rc = -ENOMEM;
+			SPDK_ERRLOG("could not allocate bdev_node name\n");
+			goto strdup_failed;
+		}
+
+		zone_size = 1ULL << spdk_u64log2(name->zone_capacity);
+		if (zone_size < name->zone_capacity) {
+			zone_size <<= 1;
+		}
+
+		bdev_node->zone_shift = spdk_u64log2(zone_size);
+		bdev_node->num_zones = base_bdev->blockcnt / name->zone_capacity;
+		if (bdev_node->num_zones == 0) {
+			rc = -EINVAL;
+			SPDK_ERRLOG("base bdev %s is smaller than one zone\n", base_bdev->name);
+			goto zones_failed;
+		}
+
+		bdev_node->zones = calloc(bdev_node->num_zones, sizeof(struct block_zone));
+		if (!bdev_node->zones) {
+			rc = -ENOMEM;
+			SPDK_ERRLOG("could not allocate zones\n");
+			goto calloc_failed;
+		}
+
+		bdev_node->bdev.product_name = "zone_block";
+
+		/* Copy some properties from the underlying base bdev. */
+		bdev_node->bdev.write_cache = base_bdev->write_cache;
+		bdev_node->bdev.required_alignment = base_bdev->required_alignment;
+		bdev_node->bdev.blocklen = base_bdev->blocklen;
+		bdev_node->bdev.blockcnt = bdev_node->num_zones * zone_size;
+
+		/* Reads must not cross zones, let the bdev layer split them. */
+		bdev_node->bdev.optimal_io_boundary = zone_size;
+		bdev_node->bdev.split_on_optimal_io_boundary = true;
+
+		bdev_node->bdev.zoned = true;
+		bdev_node->bdev.zone_size = zone_size;
+		bdev_node->zone_capacity = name->zone_capacity;
+		bdev_node->bdev.optimal_open_zones = name->optimal_open_zones;
+		bdev_node->bdev.max_open_zones = 0;
+
+		/* This is the context that is passed to us when the bdev
+		 * layer calls in so we'll save our bdev node here.
+		 */
+		bdev_node->bdev.ctxt = bdev_node;
+		bdev_node->bdev.fn_table = &zone_block_fn_table;
+		bdev_node->bdev.module = &bdev_zoned_if;
+
+		rc = zone_block_init_zone_info(bdev_node);
+		if (rc) {
+			SPDK_ERRLOG("could not init zone info\n");
+			goto zone_info_failed;
+		}
+
+		TAILQ_INSERT_TAIL(&g_bdev_nodes, bdev_node, link);
+
+		spdk_io_device_register(bdev_node, _zone_block_ch_create_cb, _zone_block_ch_destroy_cb,
+					sizeof(struct zone_block_io_channel),
+					name->vbdev_name);
+
+		rc = spdk_bdev_open(base_bdev, true, zone_block_base_bdev_hotremove_cb,
+				    base_bdev, &bdev_node->base_desc);
+		if (rc) {
+			SPDK_ERRLOG("could not open bdev %s\n", spdk_bdev_get_name(base_bdev));
+			goto open_failed;
+		}
+
+		rc = spdk_bdev_module_claim_bdev(base_bdev, bdev_node->base_desc, bdev_node->bdev.module);
+		if (rc) {
+			SPDK_ERRLOG("could not claim bdev %s\n", spdk_bdev_get_name(base_bdev));
+			goto claim_failed;
+		}
+
+		rc = spdk_bdev_register(&bdev_node->bdev);
+		if (rc) {
+			SPDK_ERRLOG("could not register zoned bdev\n");
+			goto register_failed;
+		}
+	}
+
+	return rc;
+
+register_failed:
+	spdk_bdev_module_release_bdev(base_bdev);
+claim_failed:
+	spdk_bdev_close(bdev_node->base_desc);
+open_failed:
+	TAILQ_REMOVE(&g_bdev_nodes, bdev_node, link);
+	spdk_io_device_unregister(bdev_node, NULL);
+	for (i = 0; i < bdev_node->num_zones; i++) {
+		pthread_spin_destroy(&bdev_node->zones[i].lock);
+	}
+zone_info_failed:
+	free(bdev_node->zones);
+calloc_failed:
+zones_failed:
+	free(bdev_node->bdev.name);
+strdup_failed:
+	free(bdev_node);
+free_config:
+	zone_block_remove_config(name);
+	return rc;
+}
+
+int
+spdk_vbdev_zone_block_create(const char *bdev_name, const char *vbdev_name, uint64_t zone_capacity,
+			     uint64_t optimal_open_zones)
+{
+	struct spdk_bdev *bdev = NULL;
+	int rc = 0;
+
+	if (zone_capacity == 0) {
+		SPDK_ERRLOG("Zone capacity can't be 0\n");
+		return -EINVAL;
+	}
+
+	if (optimal_open_zones == 0) {
+		SPDK_ERRLOG("Optimal open zones can't be 0\n");
+		return -EINVAL;
+	}
+
+	/* Insert the bdev into our global name list even if it doesn't exist yet,
+	 * it may show up soon...
+	 */
+	rc = zone_block_insert_name(bdev_name, vbdev_name, zone_capacity, optimal_open_zones);
+	if (rc) {
+		return rc;
+	}
+
+	bdev = spdk_bdev_get_by_name(bdev_name);
+	if (!bdev) {
+		/* This is not an error, even though the bdev is not present at this time it may
+		 * still show up later.
+		 */
+		return 0;
+	}
+
+	return zone_block_register(bdev);
+}
+
+void
+spdk_vbdev_zone_block_delete(const char *name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	struct bdev_zone_block_config *name_node;
+	struct spdk_bdev *bdev = NULL;
+
+	bdev = spdk_bdev_get_by_name(name);
+	if (!bdev || bdev->module != &bdev_zoned_if) {
+		cb_fn(cb_arg, -ENODEV);
+		return;
+	}
+
+	TAILQ_FOREACH(name_node, &g_bdev_configs, link) {
+		if (strcmp(name_node->vbdev_name, bdev->name) == 0) {
+			zone_block_remove_config(name_node);
+			break;
+		}
+	}
+
+	spdk_bdev_unregister(bdev, cb_fn, cb_arg);
+}
+
+static void
+zone_block_examine(struct spdk_bdev *bdev)
+{
+	zone_block_register(bdev);
+
+	spdk_bdev_module_examine_done(&bdev_zoned_if);
+}
+
+SPDK_LOG_REGISTER_COMPONENT("vbdev_zone_block", SPDK_LOG_VBDEV_ZONE_BLOCK)
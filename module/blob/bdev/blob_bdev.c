@@ -319,8 +319,9 @@ bdev_blob_destroy(struct spdk_bs_dev *bs_dev)
 	free(bs_dev);
 }
 
-struct spdk_bs_dev *
-spdk_bdev_create_bs_dev(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb, void *remove_ctx)
+static struct spdk_bs_dev *
+_spdk_bdev_create_bs_dev(struct spdk_bdev *bdev, bool write, spdk_bdev_remove_cb_t remove_cb,
+			 void *remove_ctx)
 {
 	struct blob_bdev *b;
 	struct spdk_bdev_desc *desc;
@@ -333,7 +334,7 @@ spdk_bdev_create_bs_dev(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb,
 		return NULL;
 	}
 
-	rc = spdk_bdev_open(bdev, true, remove_cb, remove_ctx, &desc);
+	rc = spdk_bdev_open(bdev, write, remove_cb, remove_ctx, &desc);
 	if (rc != 0) {
 		free(b);
 		return NULL;
@@ -355,3 +356,15 @@ spdk_bdev_create_bs_dev(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb,
 
 	return &b->bs_dev;
 }
+
+struct spdk_bs_dev *
+spdk_bdev_create_bs_dev(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb, void *remove_ctx)
+{
+	return _spdk_bdev_create_bs_dev(bdev, true, remove_cb, remove_ctx);
+}
+
+struct spdk_bs_dev *
+spdk_bdev_create_bs_dev_ro(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb, void *remove_ctx)
+{
+	return _spdk_bdev_create_bs_dev(bdev, false, remove_cb, remove_ctx);
+}
@@ -593,6 +593,16 @@ spdk_nvmf_parse_transport(struct spdk_nvmf_parse_transport_ctx *ctx)
 		}
 	}
 
+	val = spdk_conf_section_get_intval(ctx->sp, "MaxInlineDataSize");
+	if (val >= 0) {
+		if (trtype == SPDK_NVME_TRANSPORT_RDMA) {
+			opts.max_inline_data_size = val;
+		} else {
+			SPDK_ERRLOG("MaxInlineDataSize is relevant only for RDMA transport '%s'\n", type);
+			goto error_out;
+		}
+	}
+
 	if (trtype == SPDK_NVME_TRANSPORT_TCP) {
 		bval = spdk_conf_section_get_boolval(ctx->sp, "C2HSuccess", true);
 		opts.c2h_success = bval;
@@ -490,6 +490,31 @@ if __name__ == "__main__":
     p.add_argument('latency_us', help='new latency value in microseconds.', type=int)
     p.set_defaults(func=bdev_delay_update_latency)
 
+    def bdev_zone_block_create(args):
+        print_json(rpc.bdev.bdev_zone_block_create(args.client,
+                                                   name=args.name,
+                                                   base_bdev=args.base_bdev,
+                                                   zone_capacity=args.zone_capacity,
+                                                   optimal_open_zones=args.optimal_open_zones))
+
+    p = subparsers.add_parser('bdev_zone_block_create',
+                              help='Create a zoned block device emulator on an existing bdev')
+    p.add_argument('-b', '--name', help="Name of the zoned bdev", required=True)
+    p.add_argument('-n', '--base-bdev', help='Name of the base bdev', required=True)
+    p.add_argument('-z', '--zone-capacity', help='Number of writable blocks in each zone',
+                   required=True, type=int)
+    p.add_argument('-o', '--optimal-open-zones', help='Optimal number of open zones',
+                   required=True, type=int)
+    p.set_defaults(func=bdev_zone_block_create)
+
+    def bdev_zone_block_delete(args):
+        print_json(rpc.bdev.bdev_zone_block_delete(args.client,
+                                                   name=args.name))
+
+    p = subparsers.add_parser('bdev_zone_block_delete', help='Delete a zoned block device emulator')
+    p.add_argument('name', help='Zoned bdev name')
+    p.set_defaults(func=bdev_zone_block_delete)
+
     def bdev_error_create(args):
         print_json(rpc.bdev.bdev_error_create(args.client,
                                               base_name=args.base_name))
@@ -1229,6 +1254,21 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('clone_name', help='lvol clone name')
     p.set_defaults(func=bdev_lvol_clone)
 
+    def bdev_lvol_clone_bdev(args):
+        print_json(rpc.lvol.bdev_lvol_clone_bdev(args.client,
+                                                 bdev=args.bdev,
+                                                 clone_name=args.clone_name,
+                                                 uuid=args.uuid,
+                                                 lvs_name=args.lvs_name))
+
+    p = subparsers.add_parser('bdev_lvol_clone_bdev',
+                              help='Create a clone of any bdev, used as its read-only external snapshot')
+    p.add_argument('-u', '--uuid', help='lvol store UUID', required=False)
+    p.add_argument('-l', '--lvs-name', help='lvol store name', required=False)
+    p.add_argument('bdev', help='name or UUID of the bdev to clone')
+    p.add_argument('clone_name', help='lvol clone name')
+    p.set_defaults(func=bdev_lvol_clone_bdev)
+
     def bdev_lvol_rename(args):
         rpc.lvol.bdev_lvol_rename(args.client,
                                   old_name=args.old_name,
@@ -1242,22 +1282,54 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
 
     def bdev_lvol_inflate(args):
         rpc.lvol.bdev_lvol_inflate(args.client,
-                                   name=args.name)
+                                   name=args.name,
+                                   queue_depth=args.queue_depth,
+                                   mbytes_per_sec=args.mbytes_per_sec)
 
     p = subparsers.add_parser('bdev_lvol_inflate', aliases=['inflate_lvol_bdev'],
                               help='Make thin provisioned lvol a thick provisioned lvol')
     p.add_argument('name', help='lvol bdev name')
+    p.add_argument('-q', '--queue-depth', help='number of clusters copied in parallel', type=int)
+    p.add_argument('-r', '--mbytes-per-sec', help='copy rate limit in MiB/s, 0 for unlimited', type=int)
     p.set_defaults(func=bdev_lvol_inflate)
 
     def bdev_lvol_decouple_parent(args):
         rpc.lvol.bdev_lvol_decouple_parent(args.client,
-                                           name=args.name)
+                                           name=args.name,
+                                           queue_depth=args.queue_depth,
+                                           mbytes_per_sec=args.mbytes_per_sec)
 
     p = subparsers.add_parser('bdev_lvol_decouple_parent', aliases=['decouple_parent_lvol_bdev'],
                               help='Decouple parent of lvol')
     p.add_argument('name', help='lvol bdev name')
+    p.add_argument('-q', '--queue-depth', help='number of clusters copied in parallel', type=int)
+    p.add_argument('-r', '--mbytes-per-sec', help='copy rate limit in MiB/s, 0 for unlimited', type=int)
     p.set_defaults(func=bdev_lvol_decouple_parent)
 
+    def bdev_lvol_shallow_copy(args):
+        rpc.lvol.bdev_lvol_shallow_copy(args.client,
+                                        src_lvol_name=args.src_lvol_name,
+                                        dst_bdev_name=args.dst_bdev_name,
+                                        queue_depth=args.queue_depth,
+                                        mbytes_per_sec=args.mbytes_per_sec)
+
+    p = subparsers.add_parser('bdev_lvol_shallow_copy',
+                              help='Copy clusters allocated by a read-only lvol to a bdev')
+    p.add_argument('src_lvol_name', help='name of the read-only lvol bdev to copy')
+    p.add_argument('dst_bdev_name', help='name of the bdev to copy to')
+    p.add_argument('-q', '--queue-depth', help='number of clusters copied in parallel', type=int)
+    p.add_argument('-r', '--mbytes-per-sec', help='copy rate limit in MiB/s, 0 for unlimited', type=int)
+    p.set_defaults(func=bdev_lvol_shallow_copy)
+
+    def bdev_lvol_get_copy_progress(args):
+        print_json(rpc.lvol.bdev_lvol_get_copy_progress(args.client,
+                                                        name=args.name))
+
+    p = subparsers.add_parser('bdev_lvol_get_copy_progress',
+                              help='Show progress of the copy running on an lvol bdev')
+    p.add_argument('name', help='lvol bdev name')
+    p.set_defaults(func=bdev_lvol_get_copy_progress)
+
     def bdev_lvol_resize(args):
         rpc.lvol.bdev_lvol_resize(args.client,
                                   name=args.name,
@@ -1529,7 +1601,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                        no_srq=args.no_srq,
                                        c2h_success=args.c2h_success,
                                        dif_insert_or_strip=args.dif_insert_or_strip,
-                                       sock_priority=args.sock_priority)
+                                       sock_priority=args.sock_priority,
+                                       max_inline_data_size=args.max_inline_data_size)
 
     p = subparsers.add_parser('nvmf_create_transport', help='Create NVMf transport')
     p.add_argument('-t', '--trtype', help='Transport type (ex. RDMA)', type=str, required=True)
@@ -1547,6 +1620,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-o', '--c2h-success', action='store_false', help='Disable C2H success optimization. Relevant only for TCP transport')
     p.add_argument('-f', '--dif-insert-or-strip', action='store_true', help='Enable DIF insert/strip. Relevant only for TCP transport')
     p.add_argument('-y', '--sock-priority', help='The sock priority of the tcp connection. Relevant only for TCP transport', type=int)
+    p.add_argument('-l', '--max-inline-data-size', help="""Max size of read data sent inline with the
+    RDMA work request, 0 disables inline data. Relevant only for RDMA transport""", type=int)
     p.set_defaults(func=nvmf_create_transport)
 
     def get_nvmf_transports(args):
@@ -1636,6 +1711,29 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-s', '--trsvcid', help='NVMe-oF transport service id: e.g., a port number')
     p.set_defaults(func=nvmf_subsystem_remove_listener)
 
+    def nvmf_subsystem_listener_set_ana_state(args):
+        rpc.nvmf.nvmf_subsystem_listener_set_ana_state(args.client,
+                                                       nqn=args.nqn,
+                                                       ana_state=args.ana_state,
+                                                       trtype=args.trtype,
+                                                       traddr=args.traddr,
+                                                       tgt_name=args.tgt_name,
+                                                       adrfam=args.adrfam,
+                                                       trsvcid=args.trsvcid,
+                                                       anagrpid=args.anagrpid)
+
+    p = subparsers.add_parser('nvmf_subsystem_listener_set_ana_state', help='Set ANA state of a listener for an NVMe-oF subsystem')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('-n', '--ana-state', help='ANA state to set: optimized, non_optimized, inaccessible or persistent_loss',
+                   required=True)
+    p.add_argument('-t', '--trtype', help='NVMe-oF transport type: e.g., rdma', required=True)
+    p.add_argument('-a', '--traddr', help='NVMe-oF transport address: e.g., an ip address', required=True)
+    p.add_argument('-p', '--tgt_name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.add_argument('-f', '--adrfam', help='NVMe-oF transport adrfam: e.g., ipv4, ipv6, ib, fc, intra_host')
+    p.add_argument('-s', '--trsvcid', help='NVMe-oF transport service id: e.g., a port number')
+    p.add_argument('-g', '--anagrpid', help='ANA group ID to change, all ANA groups if omitted (optional)', type=int)
+    p.set_defaults(func=nvmf_subsystem_listener_set_ana_state)
+
     def nvmf_subsystem_add_ns(args):
         rpc.nvmf.nvmf_subsystem_add_ns(args.client,
                                        nqn=args.nqn,
@@ -1645,7 +1743,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                        nsid=args.nsid,
                                        nguid=args.nguid,
                                        eui64=args.eui64,
-                                       uuid=args.uuid)
+                                       uuid=args.uuid,
+                                       anagrpid=args.anagrpid)
 
     p = subparsers.add_parser('nvmf_subsystem_add_ns', help='Add a namespace to an NVMe-oF subsystem')
     p.add_argument('nqn', help='NVMe-oF subsystem NQN')
@@ -1656,6 +1755,7 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-g', '--nguid', help='Namespace globally unique identifier (optional)')
     p.add_argument('-e', '--eui64', help='Namespace EUI-64 identifier (optional)')
     p.add_argument('-u', '--uuid', help='Namespace UUID (optional)')
+    p.add_argument('-a', '--anagrpid', help='ANA group ID, defaults to the NSID (optional)', type=int)
     p.set_defaults(func=nvmf_subsystem_add_ns)
 
     def nvmf_subsystem_remove_ns(args):
@@ -1707,6 +1807,89 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-t', '--tgt_name', help='The name of the parent NVMe-oF target (optional)', type=str)
     p.set_defaults(func=nvmf_subsystem_allow_any_host)
 
+    def nvmf_subsystem_set_ns_sched(args):
+        rpc.nvmf.nvmf_subsystem_set_ns_sched(args.client,
+                                             nqn=args.nqn,
+                                             nsid=args.nsid,
+                                             enable=not args.disable,
+                                             max_outstanding=args.max_outstanding,
+                                             tgt_name=args.tgt_name)
+
+    p = subparsers.add_parser('nvmf_subsystem_set_ns_sched',
+                              help='Configure the per host I/O scheduler of a namespace')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('nsid', help='Namespace ID', type=int)
+    p.add_argument('-d', '--disable', action='store_true', help='Disable the scheduler')
+    p.add_argument('-m', '--max-outstanding', dest='max_outstanding',
+                   help='I/O each poll group dispatches before queueing, 0 for no limit', type=int)
+    p.add_argument('-t', '--tgt_name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_set_ns_sched)
+
+    def nvmf_subsystem_set_ns_sched_host(args):
+        rpc.nvmf.nvmf_subsystem_set_ns_sched_host(args.client,
+                                                  nqn=args.nqn,
+                                                  nsid=args.nsid,
+                                                  host=args.host,
+                                                  weight=args.weight,
+                                                  rw_ios_per_sec=args.rw_ios_per_sec,
+                                                  rw_mbytes_per_sec=args.rw_mbytes_per_sec,
+                                                  tgt_name=args.tgt_name)
+
+    p = subparsers.add_parser('nvmf_subsystem_set_ns_sched_host',
+                              help='Set the share and rate limits of a host in the I/O scheduler of a namespace')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('nsid', help='Namespace ID', type=int)
+    p.add_argument('host', help='Host NQN')
+    p.add_argument('-w', '--weight', help='Share of the namespace relative to the other hosts', type=int)
+    p.add_argument('--rw_ios_per_sec', help='R/W IOs per second limit. 0 means unlimited.', type=int)
+    p.add_argument('--rw_mbytes_per_sec', help='R/W megabytes per second limit. 0 means unlimited.', type=int)
+    p.add_argument('-t', '--tgt_name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_set_ns_sched_host)
+
+    def nvmf_subsystem_get_ns_sched_stats(args):
+        print_dict(rpc.nvmf.nvmf_subsystem_get_ns_sched_stats(args.client,
+                                                              nqn=args.nqn,
+                                                              nsid=args.nsid,
+                                                              tgt_name=args.tgt_name))
+
+    p = subparsers.add_parser('nvmf_subsystem_get_ns_sched_stats',
+                              help='Display the per host I/O count and queueing delay of a namespace')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('nsid', help='Namespace ID', type=int)
+    p.add_argument('-t', '--tgt_name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_get_ns_sched_stats)
+
+    def nvmf_subsystem_set_ns_cache(args):
+        rpc.nvmf.nvmf_subsystem_set_ns_cache(args.client,
+                                             nqn=args.nqn,
+                                             nsid=args.nsid,
+                                             size_mb=args.size_mb,
+                                             line_size=args.line_size,
+                                             tgt_name=args.tgt_name)
+
+    p = subparsers.add_parser('nvmf_subsystem_set_ns_cache',
+                              help='Configure the read cache of a namespace')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('nsid', help='Namespace ID', type=int)
+    p.add_argument('size_mb', help='Memory used for cached data in megabytes, 0 to disable the cache', type=int)
+    p.add_argument('-l', '--line-size', dest='line_size',
+                   help='Size of the unit the namespace is cached in, in bytes', type=int)
+    p.add_argument('-t', '--tgt_name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_set_ns_cache)
+
+    def nvmf_subsystem_get_ns_cache_stats(args):
+        print_dict(rpc.nvmf.nvmf_subsystem_get_ns_cache_stats(args.client,
+                                                              nqn=args.nqn,
+                                                              nsid=args.nsid,
+                                                              tgt_name=args.tgt_name))
+
+    p = subparsers.add_parser('nvmf_subsystem_get_ns_cache_stats',
+                              help='Display the read cache hit and miss counts of a namespace')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('nsid', help='Namespace ID', type=int)
+    p.add_argument('-t', '--tgt_name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_get_ns_cache_stats)
+
     def nvmf_get_stats(args):
         print_dict(rpc.nvmf.nvmf_get_stats(args.client, tgt_name=args.tgt_name))
 
@@ -537,6 +537,37 @@ def bdev_delay_update_latency(client, delay_bdev_name, latency_type, latency_us)
     return client.call('bdev_delay_update_latency', params)
 
 
+def bdev_zone_block_create(client, name, base_bdev, zone_capacity, optimal_open_zones):
+    """Construct a zoned block device emulator on top of an existing bdev.
+
+    Args:
+        name: name of the zoned bdev
+        base_bdev: name of the base bdev
+        zone_capacity: number of writable blocks in each zone
+        optimal_open_zones: optimal number of open zones
+
+    Returns:
+        Name of created block device.
+    """
+    params = {
+        'name': name,
+        'base_bdev': base_bdev,
+        'zone_capacity': zone_capacity,
+        'optimal_open_zones': optimal_open_zones,
+    }
+    return client.call('bdev_zone_block_create', params)
+
+
+def bdev_zone_block_delete(client, name):
+    """Remove a zoned block device emulator from the system.
+
+    Args:
+        name: name of the zoned bdev to delete
+    """
+    params = {'name': name}
+    return client.call('bdev_zone_block_delete', params)
+
+
 @deprecated_alias('delete_error_bdev')
 def bdev_error_delete(client, name):
     """Remove error bdev from the system.
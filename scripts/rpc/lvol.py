@@ -104,6 +104,34 @@ def bdev_lvol_clone(client, snapshot_name, clone_name):
     return client.call('bdev_lvol_clone', params)
 
 
+def bdev_lvol_clone_bdev(client, bdev, clone_name, uuid=None, lvs_name=None):
+    """Create a logical volume based on any bdev, used as its external snapshot.
+
+    Args:
+        bdev: name or UUID of the bdev to clone
+        clone_name: name of logical volume to create
+        uuid: UUID of logical volume store to create logical volume on (optional)
+        lvs_name: name of logical volume store to create logical volume on (optional)
+
+    Either uuid or lvs_name must be specified, but not both.
+
+    Returns:
+        Name of created logical volume clone.
+    """
+    if (uuid and lvs_name) or (not uuid and not lvs_name):
+        raise ValueError("Either uuid or lvs_name must be specified, but not both")
+
+    params = {
+        'bdev': bdev,
+        'clone_name': clone_name
+    }
+    if uuid:
+        params['uuid'] = uuid
+    if lvs_name:
+        params['lvs_name'] = lvs_name
+    return client.call('bdev_lvol_clone_bdev', params)
+
+
 @deprecated_alias('rename_lvol_bdev')
 def bdev_lvol_rename(client, old_name, new_name):
     """Rename a logical volume.
@@ -161,31 +189,76 @@ def bdev_lvol_delete(client, name):
 
 
 @deprecated_alias('inflate_lvol_bdev')
-def bdev_lvol_inflate(client, name):
+def bdev_lvol_inflate(client, name, queue_depth=None, mbytes_per_sec=None):
     """Inflate a logical volume.
 
     Args:
         name: name of logical volume to inflate
+        queue_depth: number of clusters copied in parallel (optional)
+        mbytes_per_sec: copy rate limit in MiB/s, 0 for unlimited (optional)
     """
     params = {
         'name': name,
     }
+    if queue_depth is not None:
+        params['queue_depth'] = queue_depth
+    if mbytes_per_sec is not None:
+        params['mbytes_per_sec'] = mbytes_per_sec
     return client.call('bdev_lvol_inflate', params)
 
 
 @deprecated_alias('decouple_parent_lvol_bdev')
-def bdev_lvol_decouple_parent(client, name):
+def bdev_lvol_decouple_parent(client, name, queue_depth=None, mbytes_per_sec=None):
     """Decouple parent of a logical volume.
 
     Args:
         name: name of logical volume to decouple parent
+        queue_depth: number of clusters copied in parallel (optional)
+        mbytes_per_sec: copy rate limit in MiB/s, 0 for unlimited (optional)
     """
     params = {
         'name': name,
     }
+    if queue_depth is not None:
+        params['queue_depth'] = queue_depth
+    if mbytes_per_sec is not None:
+        params['mbytes_per_sec'] = mbytes_per_sec
     return client.call('bdev_lvol_decouple_parent', params)
 
 
+def bdev_lvol_shallow_copy(client, src_lvol_name, dst_bdev_name, queue_depth=None,
+                           mbytes_per_sec=None):
+    """Copy the clusters allocated by a read-only logical volume itself to a bdev.
+
+    Args:
+        src_lvol_name: name of the read-only logical volume to copy
+        dst_bdev_name: name of the bdev to copy to
+        queue_depth: number of clusters copied in parallel (optional)
+        mbytes_per_sec: copy rate limit in MiB/s, 0 for unlimited (optional)
+    """
+    params = {
+        'src_lvol_name': src_lvol_name,
+        'dst_bdev_name': dst_bdev_name,
+    }
+    if queue_depth is not None:
+        params['queue_depth'] = queue_depth
+    if mbytes_per_sec is not None:
+        params['mbytes_per_sec'] = mbytes_per_sec
+    return client.call('bdev_lvol_shallow_copy', params)
+
+
+def bdev_lvol_get_copy_progress(client, name):
+    """Get progress of the inflate, decouple or shallow copy running on a logical volume.
+
+    Args:
+        name: name of logical volume
+    """
+    params = {
+        'name': name,
+    }
+    return client.call('bdev_lvol_get_copy_progress', params)
+
+
 @deprecated_alias('destroy_lvol_store')
 def bdev_lvol_delete_lvstore(client, uuid=None, lvs_name=None):
     """Destroy a logical volume store.
@@ -50,7 +50,8 @@ def nvmf_create_transport(client,
                           no_srq=False,
                           c2h_success=True,
                           dif_insert_or_strip=None,
-                          sock_priority=None):
+                          sock_priority=None,
+                          max_inline_data_size=None):
     """NVMf Transport Create options.
 
     Args:
@@ -67,6 +68,8 @@ def nvmf_create_transport(client,
         no_srq: Boolean flag to disable SRQ even for devices that support it - RDMA specific (optional)
         c2h_success: Boolean flag to disable the C2H success optimization - TCP specific (optional)
         dif_insert_or_strip: Boolean flag to enable DIF insert/strip for I/O - TCP specific (optional)
+        sock_priority: The sock priority of the tcp connection - TCP specific (optional)
+        max_inline_data_size: Max size of read data sent inline, 0 disables it - RDMA specific (optional)
 
     Returns:
         True or False
@@ -102,6 +105,8 @@ def nvmf_create_transport(client,
         params['dif_insert_or_strip'] = dif_insert_or_strip
     if sock_priority:
         params['sock_priority'] = sock_priority
+    if max_inline_data_size is not None:
+        params['max_inline_data_size'] = max_inline_data_size
     return client.call('nvmf_create_transport', params)
 
 
@@ -252,7 +257,53 @@ def nvmf_subsystem_remove_listener(
     return client.call('nvmf_subsystem_remove_listener', params)
 
 
-def nvmf_subsystem_add_ns(client, nqn, bdev_name, tgt_name=None, ptpl_file=None, nsid=None, nguid=None, eui64=None, uuid=None):
+def nvmf_subsystem_listener_set_ana_state(
+        client,
+        nqn,
+        ana_state,
+        trtype,
+        traddr,
+        trsvcid,
+        adrfam,
+        anagrpid=None,
+        tgt_name=None):
+    """Set ANA state of a listener for an NVMe-oF subsystem.
+
+    Args:
+        nqn: Subsystem NQN.
+        ana_state: ANA state to set ("optimized", "non_optimized", "inaccessible" or "persistent_loss").
+        trtype: Transport type ("RDMA").
+        traddr: Transport address.
+        trsvcid: Transport service ID.
+        adrfam: Address family ("IPv4", "IPv6", "IB", or "FC").
+        anagrpid: ANA group ID to change, all ANA groups if not specified (optional).
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+            True or False
+    """
+    listen_address = {'trtype': trtype,
+                      'traddr': traddr,
+                      'trsvcid': trsvcid}
+
+    if adrfam:
+        listen_address['adrfam'] = adrfam
+
+    params = {'nqn': nqn,
+              'listen_address': listen_address,
+              'ana_state': ana_state}
+
+    if anagrpid:
+        params['anagrpid'] = anagrpid
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_listener_set_ana_state', params)
+
+
+def nvmf_subsystem_add_ns(client, nqn, bdev_name, tgt_name=None, ptpl_file=None, nsid=None, nguid=None, eui64=None, uuid=None,
+                          anagrpid=None):
     """Add a namespace to a subsystem.
 
     Args:
@@ -263,6 +314,7 @@ def nvmf_subsystem_add_ns(client, nqn, bdev_name, tgt_name=None, ptpl_file=None,
         nguid: 16-byte namespace globally unique identifier in hexadecimal (optional).
         eui64: 8-byte namespace EUI-64 in hexadecimal (e.g. "ABCDEF0123456789") (optional).
         uuid: Namespace UUID (optional).
+        anagrpid: ANA group ID, defaults to the namespace ID (optional).
 
     Returns:
         The namespace ID
@@ -284,6 +336,9 @@ def nvmf_subsystem_add_ns(client, nqn, bdev_name, tgt_name=None, ptpl_file=None,
     if uuid:
         ns['uuid'] = uuid
 
+    if anagrpid:
+        ns['anagrpid'] = anagrpid
+
     params = {'nqn': nqn,
               'namespace': ns}
 
@@ -372,6 +427,125 @@ def nvmf_subsystem_allow_any_host(client, nqn, disable, tgt_name=None):
     return client.call('nvmf_subsystem_allow_any_host', params)
 
 
+def nvmf_subsystem_set_ns_sched(client, nqn, nsid, enable, max_outstanding=None, tgt_name=None):
+    """Configure the I/O scheduler of a namespace.
+
+    Args:
+        nqn: Subsystem NQN.
+        nsid: Namespace ID.
+        enable: Queue the I/O per host and dispatch it in weighted round robin order (true) or not (false).
+        max_outstanding: I/O each poll group dispatches to the namespace before queueing, 0 for no limit (optional).
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        True or False
+    """
+    params = {'nqn': nqn, 'nsid': nsid, 'enable': enable}
+
+    if max_outstanding is not None:
+        params['max_outstanding'] = max_outstanding
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_set_ns_sched', params)
+
+
+def nvmf_subsystem_set_ns_sched_host(client, nqn, nsid, host, weight=None, rw_ios_per_sec=None,
+                                     rw_mbytes_per_sec=None, tgt_name=None):
+    """Configure the share and rate limits of a host in the I/O scheduler of a namespace.
+
+    Args:
+        nqn: Subsystem NQN.
+        nsid: Namespace ID.
+        host: Host NQN.
+        weight: Share of the namespace relative to the other hosts (optional).
+        rw_ios_per_sec: R/W IOs per second limit, 0 for unlimited (optional).
+        rw_mbytes_per_sec: R/W megabytes per second limit, 0 for unlimited (optional).
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        True or False
+    """
+    params = {'nqn': nqn, 'nsid': nsid, 'host': host}
+
+    if weight is not None:
+        params['weight'] = weight
+
+    if rw_ios_per_sec is not None:
+        params['rw_ios_per_sec'] = rw_ios_per_sec
+
+    if rw_mbytes_per_sec is not None:
+        params['rw_mbytes_per_sec'] = rw_mbytes_per_sec
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_set_ns_sched_host', params)
+
+
+def nvmf_subsystem_get_ns_sched_stats(client, nqn, nsid, tgt_name=None):
+    """Get the per host I/O scheduler statistics of a namespace.
+
+    Args:
+        nqn: Subsystem NQN.
+        nsid: Namespace ID.
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        Number of I/O and queueing delay of each host.
+    """
+    params = {'nqn': nqn, 'nsid': nsid}
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_get_ns_sched_stats', params)
+
+
+def nvmf_subsystem_set_ns_cache(client, nqn, nsid, size_mb, line_size=None, tgt_name=None):
+    """Configure the read cache of a namespace.
+
+    Args:
+        nqn: Subsystem NQN.
+        nsid: Namespace ID.
+        size_mb: Memory used for cached data in megabytes, 0 to disable the cache.
+        line_size: Size of the unit the namespace is cached in, in bytes (optional).
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        True or False
+    """
+    params = {'nqn': nqn, 'nsid': nsid, 'size_mb': size_mb}
+
+    if line_size is not None:
+        params['line_size'] = line_size
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_set_ns_cache', params)
+
+
+def nvmf_subsystem_get_ns_cache_stats(client, nqn, nsid, tgt_name=None):
+    """Get the read cache statistics of a namespace.
+
+    Args:
+        nqn: Subsystem NQN.
+        nsid: Namespace ID.
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        Hit, miss and invalidation counts, and the amount of data cached.
+    """
+    params = {'nqn': nqn, 'nsid': nsid}
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_get_ns_cache_stats', params)
+
+
 def delete_nvmf_subsystem(client, nqn, tgt_name=None):
     """Delete an existing NVMe-oF subsystem.
 
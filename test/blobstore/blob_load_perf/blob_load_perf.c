@@ -0,0 +1,573 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/blob.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+/*
+ * This application measures how long it takes to load a blobstore holding a
+ *  large number of blobs, both after a clean shutdown and after a dirty one
+ *  where all of the metadata has to be replayed.  It then times opening every
+ *  blob through spdk_bs_for_each_blob(), one at a time and with the queue
+ *  depth the lvol store uses when it loads its lvols.  The blobstore sits on
+ *  a memory backed device, so the numbers only reflect the work done by the
+ *  blobstore itself.
+ *
+ * With -l every I/O issued after the blobs are created completes only after
+ *  the given latency, which shows how much of the load time goes to waiting
+ *  on the device.
+ *
+ * The dirty shutdown is simulated by saving a copy of the device right after
+ *  the blobs are created, before the blobstore is unloaded, and loading from
+ *  that copy again at the end.
+ */
+
+#define DEV_BLOCKLEN		4096
+#define DEFAULT_NUM_BLOBS	100000
+#define ITER_QUEUE_DEPTH	64
+
+struct perf_io {
+	struct spdk_bs_dev_cb_args	*cb_args;
+	uint64_t			complete_tsc;
+	TAILQ_ENTRY(perf_io)		link;
+};
+
+struct perf_dev {
+	struct spdk_bs_dev	bs_dev;
+	uint8_t			*buf;
+	uint8_t			*dirty_buf;
+	uint64_t		size;
+	uint64_t		latency_ticks;
+	struct spdk_poller	*poller;
+	TAILQ_HEAD(, perf_io)	ios;
+};
+
+static struct perf_dev g_dev;
+static struct spdk_blob_store *g_bs;
+static uint32_t g_num_blobs = DEFAULT_NUM_BLOBS;
+static uint32_t g_blob_idx;
+static uint32_t g_blobs_visited;
+static uint64_t g_start_tsc;
+static uint64_t g_latency_ticks;
+static int g_rc;
+static bool g_done;
+static bool g_dev_unregistered;
+
+static void create_next_blob(void *arg);
+
+static int
+dev_channel_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+dev_channel_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static struct spdk_io_channel *
+dev_create_channel(struct spdk_bs_dev *bs_dev)
+{
+	return spdk_get_io_channel(&g_dev);
+}
+
+static void
+dev_destroy_channel(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel)
+{
+	spdk_put_io_channel(channel);
+}
+
+static void
+dev_unregister_done(void *io_device)
+{
+	spdk_poller_unregister(&g_dev.poller);
+	g_dev_unregistered = true;
+}
+
+static void
+dev_destroy(struct spdk_bs_dev *bs_dev)
+{
+	spdk_io_device_unregister(&g_dev, dev_unregister_done);
+}
+
+static void
+dev_complete(void *arg)
+{
+	struct spdk_bs_dev_cb_args *cb_args = arg;
+
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
+
+static int
+dev_poll(void *arg)
+{
+	struct perf_io *io;
+	uint64_t now = spdk_get_ticks();
+	int count = 0;
+
+	/* All I/O has the same latency, so the list is sorted by completion time */
+	while ((io = TAILQ_FIRST(&g_dev.ios)) != NULL && io->complete_tsc <= now) {
+		TAILQ_REMOVE(&g_dev.ios, io, link);
+		dev_complete(io->cb_args);
+		free(io);
+		count++;
+	}
+
+	return count;
+}
+
+/* Complete from a message, the same way a real device would complete asynchronously */
+static void
+dev_io_done(struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct perf_io *io;
+
+	if (g_dev.latency_ticks == 0) {
+		spdk_thread_send_msg(spdk_get_thread(), dev_complete, cb_args);
+		return;
+	}
+
+	io = calloc(1, sizeof(*io));
+	if (io == NULL) {
+		cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -ENOMEM);
+		return;
+	}
+
+	io->cb_args = cb_args;
+	io->complete_tsc = spdk_get_ticks() + g_dev.latency_ticks;
+	TAILQ_INSERT_TAIL(&g_dev.ios, io, link);
+}
+
+static void
+dev_read(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel, void *payload,
+	 uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	memcpy(payload, &g_dev.buf[lba * DEV_BLOCKLEN], (size_t)lba_count * DEV_BLOCKLEN);
+	dev_io_done(cb_args);
+}
+
+static void
+dev_write(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel, void *payload,
+	  uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	memcpy(&g_dev.buf[lba * DEV_BLOCKLEN], payload, (size_t)lba_count * DEV_BLOCKLEN);
+	dev_io_done(cb_args);
+}
+
+static void
+dev_readv(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+	  struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+	  struct spdk_bs_dev_cb_args *cb_args)
+{
+	uint8_t *buf = &g_dev.buf[lba * DEV_BLOCKLEN];
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		memcpy(iov[i].iov_base, buf, iov[i].iov_len);
+		buf += iov[i].iov_len;
+	}
+	dev_io_done(cb_args);
+}
+
+static void
+dev_writev(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+	   struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+	   struct spdk_bs_dev_cb_args *cb_args)
+{
+	uint8_t *buf = &g_dev.buf[lba * DEV_BLOCKLEN];
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		memcpy(buf, iov[i].iov_base, iov[i].iov_len);
+		buf += iov[i].iov_len;
+	}
+	dev_io_done(cb_args);
+}
+
+static void
+dev_flush(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+	  struct spdk_bs_dev_cb_args *cb_args)
+{
+	dev_io_done(cb_args);
+}
+
+static void
+dev_zero(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+	 uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	memset(&g_dev.buf[lba * DEV_BLOCKLEN], 0, (size_t)lba_count * DEV_BLOCKLEN);
+	dev_io_done(cb_args);
+}
+
+static int
+dev_init(uint32_t num_blobs)
+{
+	/* Two metadata pages (the blob and its extent page) and one cluster per blob,
+	 * plus the blobstore's own metadata */
+	uint64_t blockcnt = (uint64_t)num_blobs * 3 + 1024;
+
+	g_dev.size = blockcnt * DEV_BLOCKLEN;
+	g_dev.buf = calloc(blockcnt, DEV_BLOCKLEN);
+	g_dev.dirty_buf = malloc(g_dev.size);
+	if (g_dev.buf == NULL || g_dev.dirty_buf == NULL) {
+		return -ENOMEM;
+	}
+
+	g_dev.bs_dev.create_channel = dev_create_channel;
+	g_dev.bs_dev.destroy_channel = dev_destroy_channel;
+	g_dev.bs_dev.destroy = dev_destroy;
+	g_dev.bs_dev.read = dev_read;
+	g_dev.bs_dev.write = dev_write;
+	g_dev.bs_dev.readv = dev_readv;
+	g_dev.bs_dev.writev = dev_writev;
+	g_dev.bs_dev.flush = dev_flush;
+	g_dev.bs_dev.write_zeroes = dev_zero;
+	g_dev.bs_dev.unmap = dev_zero;
+	g_dev.bs_dev.blockcnt = blockcnt;
+	g_dev.bs_dev.blocklen = DEV_BLOCKLEN;
+	TAILQ_INIT(&g_dev.ios);
+
+	return 0;
+}
+
+/* The blobstore destroys its bs_dev on unload, so register it again for every load */
+static void
+dev_register(void)
+{
+	g_dev_unregistered = false;
+	spdk_io_device_register(&g_dev, dev_channel_create_cb, dev_channel_destroy_cb, 0,
+				"blob_load_perf_dev");
+	g_dev.poller = spdk_poller_register(dev_poll, NULL, 0);
+}
+
+static void
+print_pass(const char *name, uint64_t start_tsc)
+{
+	uint64_t us = (spdk_get_ticks() - start_tsc) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+
+	printf("%-16s %10u blobs in %10" PRIu64 " us, %10.0f blobs/s\n", name, g_num_blobs, us,
+	       us ? (double)g_num_blobs * SPDK_SEC_TO_USEC / us : 0.0);
+}
+
+static void
+fail_unload_complete(void *cb_arg, int bserrno)
+{
+	g_done = true;
+}
+
+static void
+fail(const char *msg, int rc)
+{
+	fprintf(stderr, "%s: %d\n", msg, rc);
+	g_rc = rc;
+	spdk_bs_unload(g_bs, fail_unload_complete, NULL);
+}
+
+static void
+dirty_unload_complete(void *cb_arg, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to unload blobstore: %d\n", bserrno);
+		g_rc = bserrno;
+	}
+	g_done = true;
+}
+
+static void
+dirty_load_complete(void *cb_arg, struct spdk_blob_store *bs, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to recover blobstore: %d\n", bserrno);
+		g_rc = bserrno;
+		g_done = true;
+		return;
+	}
+
+	print_pass("dirty load", g_start_tsc);
+	g_bs = bs;
+	spdk_bs_unload(g_bs, dirty_unload_complete, NULL);
+}
+
+static void
+dirty_load(void *arg)
+{
+	struct spdk_bs_opts bs_opts;
+
+	if (!g_dev_unregistered) {
+		/* Wait for the device of the previous load to go away */
+		spdk_thread_send_msg(spdk_get_thread(), dirty_load, NULL);
+		return;
+	}
+
+	memcpy(g_dev.buf, g_dev.dirty_buf, g_dev.size);
+	dev_register();
+
+	spdk_bs_opts_init(&bs_opts);
+	g_start_tsc = spdk_get_ticks();
+	spdk_bs_load(&g_dev.bs_dev, &bs_opts, dirty_load_complete, NULL);
+}
+
+static void
+clean_unload_complete(void *cb_arg, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to unload blobstore: %d\n", bserrno);
+		g_rc = bserrno;
+		g_done = true;
+		return;
+	}
+
+	dirty_load(NULL);
+}
+
+static int
+count_blob(void *cb_arg, struct spdk_blob *blob)
+{
+	g_blobs_visited++;
+	return 0;
+}
+
+static void
+iter_complete(void *cb_arg, int bserrno)
+{
+	uint32_t queue_depth = (uintptr_t)cb_arg;
+	char name[32];
+
+	if (bserrno != 0 || g_blobs_visited != g_num_blobs) {
+		fail("Failed to open all blobs", bserrno ? bserrno : -EIO);
+		return;
+	}
+
+	snprintf(name, sizeof(name), "open qd=%u", queue_depth);
+	print_pass(name, g_start_tsc);
+
+	if (queue_depth == 1) {
+		g_blobs_visited = 0;
+		g_start_tsc = spdk_get_ticks();
+		spdk_bs_for_each_blob(g_bs, ITER_QUEUE_DEPTH, count_blob, iter_complete,
+				      (void *)(uintptr_t)ITER_QUEUE_DEPTH);
+		return;
+	}
+
+	spdk_bs_unload(g_bs, clean_unload_complete, NULL);
+}
+
+static void
+clean_load_complete(void *cb_arg, struct spdk_blob_store *bs, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to load blobstore: %d\n", bserrno);
+		g_rc = bserrno;
+		g_done = true;
+		return;
+	}
+
+	print_pass("clean load", g_start_tsc);
+	g_bs = bs;
+
+	g_blobs_visited = 0;
+	g_start_tsc = spdk_get_ticks();
+	spdk_bs_for_each_blob(g_bs, 1, count_blob, iter_complete, (void *)(uintptr_t)1);
+}
+
+static void
+clean_load(void *arg)
+{
+	struct spdk_bs_opts bs_opts;
+
+	if (!g_dev_unregistered) {
+		spdk_thread_send_msg(spdk_get_thread(), clean_load, NULL);
+		return;
+	}
+
+	dev_register();
+	g_dev.latency_ticks = g_latency_ticks;
+
+	spdk_bs_opts_init(&bs_opts);
+	g_start_tsc = spdk_get_ticks();
+	spdk_bs_load(&g_dev.bs_dev, &bs_opts, clean_load_complete, NULL);
+}
+
+static void
+init_unload_complete(void *cb_arg, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to unload blobstore: %d\n", bserrno);
+		g_rc = bserrno;
+		g_done = true;
+		return;
+	}
+
+	clean_load(NULL);
+}
+
+static void
+create_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to create blob %u: %d\n", g_blob_idx, bserrno);
+		fail("Failed to create blobs", bserrno);
+		return;
+	}
+
+	g_blob_idx++;
+	spdk_thread_send_msg(spdk_get_thread(), create_next_blob, NULL);
+}
+
+static void
+create_next_blob(void *arg)
+{
+	struct spdk_blob_opts opts;
+
+	if (g_blob_idx == g_num_blobs) {
+		print_pass("create", g_start_tsc);
+		/* Everything is on disk, but the blobstore wasn't cleanly unloaded yet */
+		memcpy(g_dev.dirty_buf, g_dev.buf, g_dev.size);
+		spdk_bs_unload(g_bs, init_unload_complete, NULL);
+		return;
+	}
+
+	spdk_blob_opts_init(&opts);
+	opts.num_clusters = 1;
+	spdk_bs_create_blob_ext(g_bs, &opts, create_complete, NULL);
+}
+
+static void
+init_complete(void *cb_arg, struct spdk_blob_store *bs, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to initialize blobstore: %d\n", bserrno);
+		g_rc = bserrno;
+		g_done = true;
+		return;
+	}
+
+	g_bs = bs;
+	g_start_tsc = spdk_get_ticks();
+	create_next_blob(NULL);
+}
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [-n num_blobs] [-l latency_us]\n", prog);
+	printf("Options:\n");
+	printf(" -n num_blobs   number of blobs in the blobstore (default %u)\n",
+	       DEFAULT_NUM_BLOBS);
+	printf(" -l latency_us  latency of each device I/O (default 0)\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_env_opts opts;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_thread *thread;
+	uint64_t latency_us = 0;
+	long int val;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "n:l:")) != -1) {
+		switch (ch) {
+		case 'n':
+			val = spdk_strtol(optarg, 10);
+			if (val <= 0 || val > UINT32_MAX / 4) {
+				fprintf(stderr, "Invalid number of blobs: %s\n", optarg);
+				return 1;
+			}
+			g_num_blobs = val;
+			break;
+		case 'l':
+			val = spdk_strtol(optarg, 10);
+			if (val < 0) {
+				fprintf(stderr, "Invalid latency: %s\n", optarg);
+				return 1;
+			}
+			latency_us = val;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	spdk_env_opts_init(&opts);
+	opts.name = "blob_load_perf";
+	if (spdk_env_init(&opts)) {
+		printf("Err: Unable to initialize SPDK env\n");
+		return 1;
+	}
+
+	spdk_thread_lib_init(NULL, 0);
+	thread = spdk_thread_create("blob_load_perf", NULL);
+	if (thread == NULL) {
+		printf("Err: Unable to create thread\n");
+		spdk_thread_lib_fini();
+		return 1;
+	}
+	spdk_set_thread(thread);
+
+	g_latency_ticks = latency_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+
+	if (dev_init(g_num_blobs) != 0) {
+		printf("Err: Unable to allocate device buffer\n");
+		g_rc = -ENOMEM;
+		g_done = true;
+		g_dev_unregistered = true;
+	} else {
+		dev_register();
+		spdk_bs_opts_init(&bs_opts);
+		bs_opts.cluster_sz = DEV_BLOCKLEN;
+		bs_opts.num_md_pages = g_num_blobs * 2;
+		spdk_bs_init(&g_dev.bs_dev, &bs_opts, init_complete, NULL);
+	}
+
+	while (!g_done || !g_dev_unregistered) {
+		spdk_thread_poll(thread, 0, 0);
+	}
+
+	spdk_thread_exit(thread);
+	spdk_thread_destroy(thread);
+	spdk_thread_lib_fini();
+
+	free(g_dev.buf);
+	free(g_dev.dirty_buf);
+
+	return g_rc == 0 ? 0 : 1;
+}
@@ -0,0 +1,428 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/blob.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+/*
+ * This application measures how long it takes to open and close a large
+ *  number of blobs, with all of them held open at the same time.  The
+ *  blobstore sits on a memory backed device, so the numbers only reflect
+ *  the metadata handling done by the blobstore itself.
+ *
+ * The blobs are created first, then opened one after another and closed
+ *  one after another, and the time taken by each pass is printed out.
+ */
+
+#define DEV_BLOCKLEN		4096
+#define DEFAULT_NUM_BLOBS	100000
+
+struct perf_dev {
+	struct spdk_bs_dev	bs_dev;
+	uint8_t			*buf;
+};
+
+static struct perf_dev g_dev;
+static struct spdk_blob_store *g_bs;
+static struct spdk_blob **g_blobs;
+static spdk_blob_id *g_blobids;
+static uint32_t g_num_blobs = DEFAULT_NUM_BLOBS;
+static uint32_t g_blob_idx;
+static uint64_t g_start_tsc;
+static int g_rc;
+static bool g_unloaded;
+static bool g_dev_unregistered;
+
+static void open_next_blob(void *arg);
+static void close_next_blob(void *arg);
+static void unload_bs(void);
+
+static int
+dev_channel_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+dev_channel_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static struct spdk_io_channel *
+dev_create_channel(struct spdk_bs_dev *bs_dev)
+{
+	return spdk_get_io_channel(&g_dev);
+}
+
+static void
+dev_destroy_channel(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel)
+{
+	spdk_put_io_channel(channel);
+}
+
+static void
+dev_unregister_done(void *io_device)
+{
+	g_dev_unregistered = true;
+}
+
+static void
+dev_destroy(struct spdk_bs_dev *bs_dev)
+{
+	spdk_io_device_unregister(&g_dev, dev_unregister_done);
+}
+
+static void
+dev_complete(void *arg)
+{
+	struct spdk_bs_dev_cb_args *cb_args = arg;
+
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
+
+/* Complete from a message, the same way a real device would complete asynchronously */
+static void
+dev_io_done(struct spdk_bs_dev_cb_args *cb_args)
+{
+	spdk_thread_send_msg(spdk_get_thread(), dev_complete, cb_args);
+}
+
+static void
+dev_read(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel, void *payload,
+	 uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	memcpy(payload, &g_dev.buf[lba * DEV_BLOCKLEN], (size_t)lba_count * DEV_BLOCKLEN);
+	dev_io_done(cb_args);
+}
+
+static void
+dev_write(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel, void *payload,
+	  uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	memcpy(&g_dev.buf[lba * DEV_BLOCKLEN], payload, (size_t)lba_count * DEV_BLOCKLEN);
+	dev_io_done(cb_args);
+}
+
+static void
+dev_readv(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+	  struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+	  struct spdk_bs_dev_cb_args *cb_args)
+{
+	uint8_t *buf = &g_dev.buf[lba * DEV_BLOCKLEN];
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		memcpy(iov[i].iov_base, buf, iov[i].iov_len);
+		buf += iov[i].iov_len;
+	}
+	dev_io_done(cb_args);
+}
+
+static void
+dev_writev(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+	   struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+	   struct spdk_bs_dev_cb_args *cb_args)
+{
+	uint8_t *buf = &g_dev.buf[lba * DEV_BLOCKLEN];
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		memcpy(buf, iov[i].iov_base, iov[i].iov_len);
+		buf += iov[i].iov_len;
+	}
+	dev_io_done(cb_args);
+}
+
+static void
+dev_flush(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+	  struct spdk_bs_dev_cb_args *cb_args)
+{
+	dev_io_done(cb_args);
+}
+
+static void
+dev_zero(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+	 uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	memset(&g_dev.buf[lba * DEV_BLOCKLEN], 0, (size_t)lba_count * DEV_BLOCKLEN);
+	dev_io_done(cb_args);
+}
+
+static int
+dev_init(uint32_t num_blobs)
+{
+	/* Room for one metadata page per blob, plus the blobstore's own metadata */
+	uint64_t blockcnt = (uint64_t)num_blobs + 1024;
+
+	g_dev.buf = calloc(blockcnt, DEV_BLOCKLEN);
+	if (g_dev.buf == NULL) {
+		return -ENOMEM;
+	}
+
+	g_dev.bs_dev.create_channel = dev_create_channel;
+	g_dev.bs_dev.destroy_channel = dev_destroy_channel;
+	g_dev.bs_dev.destroy = dev_destroy;
+	g_dev.bs_dev.read = dev_read;
+	g_dev.bs_dev.write = dev_write;
+	g_dev.bs_dev.readv = dev_readv;
+	g_dev.bs_dev.writev = dev_writev;
+	g_dev.bs_dev.flush = dev_flush;
+	g_dev.bs_dev.write_zeroes = dev_zero;
+	g_dev.bs_dev.unmap = dev_zero;
+	g_dev.bs_dev.blockcnt = blockcnt;
+	g_dev.bs_dev.blocklen = DEV_BLOCKLEN;
+
+	spdk_io_device_register(&g_dev, dev_channel_create_cb, dev_channel_destroy_cb, 0,
+				"blob_open_perf_dev");
+	return 0;
+}
+
+static void
+print_pass(const char *name, uint64_t start_tsc)
+{
+	uint64_t us = (spdk_get_ticks() - start_tsc) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+
+	printf("%-8s %10u blobs in %10" PRIu64 " us, %10.0f blobs/s\n", name, g_num_blobs, us,
+	       us ? (double)g_num_blobs * SPDK_SEC_TO_USEC / us : 0.0);
+}
+
+static void
+unload_complete(void *cb_arg, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to unload blobstore: %d\n", bserrno);
+		g_rc = bserrno;
+	}
+	g_unloaded = true;
+}
+
+static void
+unload_bs(void)
+{
+	spdk_bs_unload(g_bs, unload_complete, NULL);
+}
+
+static void
+close_complete(void *cb_arg, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to close blob %u: %d\n", g_blob_idx, bserrno);
+		g_rc = bserrno;
+		unload_bs();
+		return;
+	}
+
+	g_blob_idx++;
+	spdk_thread_send_msg(spdk_get_thread(), close_next_blob, NULL);
+}
+
+static void
+close_next_blob(void *arg)
+{
+	if (g_blob_idx == g_num_blobs) {
+		print_pass("close", g_start_tsc);
+		unload_bs();
+		return;
+	}
+
+	spdk_blob_close(g_blobs[g_blob_idx], close_complete, NULL);
+}
+
+static void
+open_complete(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to open blob %u: %d\n", g_blob_idx, bserrno);
+		g_rc = bserrno;
+		/* Close the blobs opened so far */
+		g_num_blobs = g_blob_idx;
+		g_blob_idx = 0;
+		close_next_blob(NULL);
+		return;
+	}
+
+	g_blobs[g_blob_idx++] = blob;
+	spdk_thread_send_msg(spdk_get_thread(), open_next_blob, NULL);
+}
+
+static void
+open_next_blob(void *arg)
+{
+	if (g_blob_idx == g_num_blobs) {
+		print_pass("open", g_start_tsc);
+		g_blob_idx = 0;
+		g_start_tsc = spdk_get_ticks();
+		close_next_blob(NULL);
+		return;
+	}
+
+	spdk_bs_open_blob(g_bs, g_blobids[g_blob_idx], open_complete, NULL);
+}
+
+static void create_next_blob(void *arg);
+
+static void
+create_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to create blob %u: %d\n", g_blob_idx, bserrno);
+		g_rc = bserrno;
+		unload_bs();
+		return;
+	}
+
+	g_blobids[g_blob_idx++] = blobid;
+	spdk_thread_send_msg(spdk_get_thread(), create_next_blob, NULL);
+}
+
+static void
+create_next_blob(void *arg)
+{
+	if (g_blob_idx == g_num_blobs) {
+		print_pass("create", g_start_tsc);
+		g_blob_idx = 0;
+		g_start_tsc = spdk_get_ticks();
+		open_next_blob(NULL);
+		return;
+	}
+
+	spdk_bs_create_blob(g_bs, create_complete, NULL);
+}
+
+static void
+init_complete(void *cb_arg, struct spdk_blob_store *bs, int bserrno)
+{
+	if (bserrno != 0) {
+		fprintf(stderr, "Failed to initialize blobstore: %d\n", bserrno);
+		g_rc = bserrno;
+		g_unloaded = true;
+		return;
+	}
+
+	g_bs = bs;
+	g_start_tsc = spdk_get_ticks();
+	create_next_blob(NULL);
+}
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [-n num_blobs]\n", prog);
+	printf("Options:\n");
+	printf(" -n num_blobs  number of blobs to create, open and close (default %u)\n",
+	       DEFAULT_NUM_BLOBS);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_env_opts opts;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_thread *thread;
+	long int val;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "n:")) != -1) {
+		switch (ch) {
+		case 'n':
+			val = spdk_strtol(optarg, 10);
+			if (val <= 0 || val > UINT32_MAX / 2) {
+				fprintf(stderr, "Invalid number of blobs: %s\n", optarg);
+				return 1;
+			}
+			g_num_blobs = val;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	spdk_env_opts_init(&opts);
+	opts.name = "blob_open_perf";
+	if (spdk_env_init(&opts)) {
+		printf("Err: Unable to initialize SPDK env\n");
+		return 1;
+	}
+
+	g_blobs = calloc(g_num_blobs, sizeof(*g_blobs));
+	g_blobids = calloc(g_num_blobs, sizeof(*g_blobids));
+	if (g_blobs == NULL || g_blobids == NULL) {
+		printf("Err: Unable to allocate blob arrays\n");
+		free(g_blobs);
+		free(g_blobids);
+		return 1;
+	}
+
+	spdk_thread_lib_init(NULL, 0);
+	thread = spdk_thread_create("blob_open_perf", NULL);
+	if (thread == NULL) {
+		printf("Err: Unable to create thread\n");
+		spdk_thread_lib_fini();
+		free(g_blobs);
+		free(g_blobids);
+		return 1;
+	}
+	spdk_set_thread(thread);
+
+	if (dev_init(g_num_blobs) != 0) {
+		printf("Err: Unable to allocate device buffer\n");
+		g_rc = -ENOMEM;
+		g_unloaded = true;
+		g_dev_unregistered = true;
+	} else {
+		spdk_bs_opts_init(&bs_opts);
+		bs_opts.cluster_sz = DEV_BLOCKLEN;
+		bs_opts.num_md_pages = g_num_blobs;
+		spdk_bs_init(&g_dev.bs_dev, &bs_opts, init_complete, NULL);
+	}
+
+	while (!g_unloaded || !g_dev_unregistered) {
+		spdk_thread_poll(thread, 0, 0);
+	}
+
+	spdk_thread_exit(thread);
+	spdk_thread_destroy(thread);
+	spdk_thread_lib_fini();
+
+	free(g_dev.buf);
+	free(g_blobs);
+	free(g_blobids);
+
+	return g_rc == 0 ? 0 : 1;
+}
@@ -35,4 +35,10 @@ rm -rf $testdir/blobcli.conf
 rm -rf $testdir/*.blob
 rm -rf $testdir/test.pattern
 
+# open and close a large number of blobs held open at the same time
+$testdir/blob_open_perf/blob_open_perf -n 100000
+
+# load and recover a blobstore with a large number of blobs on a slow device
+$testdir/blob_load_perf/blob_load_perf -n 20000 -l 20
+
 timing_exit blobstore
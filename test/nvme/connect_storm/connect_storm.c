@@ -0,0 +1,356 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Connect storm benchmark.
+ *
+ * Attaches a number of controllers to a single NVMe-oF subsystem and then
+ * repeatedly tears down and re-creates all of their I/O queue pairs from
+ * several threads at once, the way hosts reconnect after a network blip.
+ * Reports how long it takes the target to accept every I/O queue connect.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/nvme.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+struct storm_ctrlr {
+	struct spdk_nvme_ctrlr	*ctrlr;
+	struct spdk_nvme_qpair	**qpairs;
+};
+
+struct storm_worker {
+	pthread_t		thread;
+	uint32_t		first_ctrlr;
+	uint32_t		num_ctrlrs;
+	uint64_t		connected;
+	uint64_t		failed;
+	uint64_t		max_ticks;
+	uint64_t		total_ticks;
+};
+
+static struct spdk_nvme_transport_id g_trid;
+static struct storm_ctrlr *g_ctrlrs;
+static struct storm_worker *g_workers;
+static uint32_t g_num_ctrlrs = 4;
+static uint32_t g_num_qpairs = 16;
+static uint32_t g_num_workers = 4;
+static uint32_t g_num_iterations = 10;
+static uint32_t g_io_queue_size = 32;
+static uint64_t g_tsc_rate;
+
+static void
+usage(char *program_name)
+{
+	printf("%s options\n", program_name);
+	printf("\t[-r remote NVMe-oF target transport ID, e.g.\n");
+	printf("\t    'trtype:TCP adrfam:IPv4 traddr:192.168.100.8 trsvcid:4420 subnqn:nqn.2016-06.io.spdk:cnode1']\n");
+	printf("\t[-c number of controllers to attach (default: 4)]\n");
+	printf("\t[-q number of I/O queue pairs per controller (default: 16)]\n");
+	printf("\t[-s I/O queue size (default: 32)]\n");
+	printf("\t[-w number of threads connecting I/O queue pairs (default: 4)]\n");
+	printf("\t[-n number of reconnect iterations (default: 10)]\n");
+}
+
+static int
+parse_args(int argc, char **argv)
+{
+	bool trid_specified = false;
+	int op;
+	long int val;
+
+	while ((op = getopt(argc, argv, "c:n:q:r:s:w:")) != -1) {
+		if (op == 'r') {
+			if (spdk_nvme_transport_id_parse(&g_trid, optarg) != 0) {
+				fprintf(stderr, "Error parsing transport address\n");
+				return 1;
+			}
+			trid_specified = true;
+			continue;
+		} else if (op == '?') {
+			usage(argv[0]);
+			return 1;
+		}
+
+		val = spdk_strtol(optarg, 10);
+		if (val <= 0) {
+			fprintf(stderr, "Invalid value for -%c: %s\n", op, optarg);
+			return 1;
+		}
+
+		switch (op) {
+		case 'c':
+			g_num_ctrlrs = val;
+			break;
+		case 'n':
+			g_num_iterations = val;
+			break;
+		case 'q':
+			g_num_qpairs = val;
+			break;
+		case 's':
+			g_io_queue_size = val;
+			break;
+		case 'w':
+			g_num_workers = val;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (!trid_specified) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (g_trid.subnqn[0] == '\0') {
+		snprintf(g_trid.subnqn, sizeof(g_trid.subnqn), "%s", SPDK_NVMF_DISCOVERY_NQN);
+	}
+
+	g_num_workers = spdk_min(g_num_workers, g_num_ctrlrs);
+
+	return 0;
+}
+
+static int
+attach_controllers(void)
+{
+	struct spdk_nvme_ctrlr_opts opts;
+	uint32_t i;
+
+	g_ctrlrs = calloc(g_num_ctrlrs, sizeof(*g_ctrlrs));
+	if (g_ctrlrs == NULL) {
+		return -ENOMEM;
+	}
+
+	spdk_nvme_ctrlr_get_default_ctrlr_opts(&opts, sizeof(opts));
+	opts.num_io_queues = g_num_qpairs;
+
+	for (i = 0; i < g_num_ctrlrs; i++) {
+		g_ctrlrs[i].qpairs = calloc(g_num_qpairs, sizeof(struct spdk_nvme_qpair *));
+		if (g_ctrlrs[i].qpairs == NULL) {
+			return -ENOMEM;
+		}
+
+		g_ctrlrs[i].ctrlr = spdk_nvme_connect(&g_trid, &opts, sizeof(opts));
+		if (g_ctrlrs[i].ctrlr == NULL) {
+			fprintf(stderr, "spdk_nvme_connect() failed for controller %u\n", i);
+			return -ENODEV;
+		}
+	}
+
+	return 0;
+}
+
+static void
+detach_controllers(void)
+{
+	uint32_t i;
+
+	if (g_ctrlrs == NULL) {
+		return;
+	}
+
+	for (i = 0; i < g_num_ctrlrs; i++) {
+		if (g_ctrlrs[i].ctrlr != NULL) {
+			spdk_nvme_detach(g_ctrlrs[i].ctrlr);
+		}
+		free(g_ctrlrs[i].qpairs);
+	}
+
+	free(g_ctrlrs);
+}
+
+static void *
+worker_fn(void *arg)
+{
+	struct storm_worker *worker = arg;
+	struct spdk_nvme_io_qpair_opts opts;
+	struct storm_ctrlr *ctrlr;
+	uint64_t tsc_start, ticks;
+	uint32_t i, q;
+
+	/* Interleave the controllers so each target controller sees connects from all workers. */
+	for (q = 0; q < g_num_qpairs; q++) {
+		for (i = 0; i < worker->num_ctrlrs; i++) {
+			ctrlr = &g_ctrlrs[worker->first_ctrlr + i];
+
+			spdk_nvme_ctrlr_get_default_io_qpair_opts(ctrlr->ctrlr, &opts, sizeof(opts));
+			opts.io_queue_size = g_io_queue_size;
+			opts.io_queue_requests = spdk_max(opts.io_queue_requests, g_io_queue_size);
+
+			tsc_start = spdk_get_ticks();
+			ctrlr->qpairs[q] = spdk_nvme_ctrlr_alloc_io_qpair(ctrlr->ctrlr, &opts, sizeof(opts));
+			ticks = spdk_get_ticks() - tsc_start;
+
+			if (ctrlr->qpairs[q] == NULL) {
+				worker->failed++;
+				continue;
+			}
+
+			worker->connected++;
+			worker->total_ticks += ticks;
+			worker->max_ticks = spdk_max(worker->max_ticks, ticks);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+free_qpairs(void)
+{
+	uint32_t i, q;
+
+	for (i = 0; i < g_num_ctrlrs; i++) {
+		for (q = 0; q < g_num_qpairs; q++) {
+			if (g_ctrlrs[i].qpairs[q] != NULL) {
+				spdk_nvme_ctrlr_free_io_qpair(g_ctrlrs[i].qpairs[q]);
+				g_ctrlrs[i].qpairs[q] = NULL;
+			}
+		}
+	}
+}
+
+static int
+run_storm(uint32_t iteration)
+{
+	struct storm_worker *worker;
+	uint64_t tsc_start, elapsed_us, connected = 0, failed = 0, total_ticks = 0, max_ticks = 0;
+	uint32_t i, per_worker, extra, next = 0;
+	int rc;
+
+	memset(g_workers, 0, g_num_workers * sizeof(*g_workers));
+
+	per_worker = g_num_ctrlrs / g_num_workers;
+	extra = g_num_ctrlrs % g_num_workers;
+
+	tsc_start = spdk_get_ticks();
+	for (i = 0; i < g_num_workers; i++) {
+		worker = &g_workers[i];
+		worker->first_ctrlr = next;
+		worker->num_ctrlrs = per_worker + (i < extra ? 1 : 0);
+		next += worker->num_ctrlrs;
+
+		rc = pthread_create(&worker->thread, NULL, worker_fn, worker);
+		if (rc != 0) {
+			fprintf(stderr, "Unable to start worker thread: %s\n", spdk_strerror(rc));
+			g_num_workers = i;
+			break;
+		}
+	}
+
+	for (i = 0; i < g_num_workers; i++) {
+		worker = &g_workers[i];
+		pthread_join(worker->thread, NULL);
+		connected += worker->connected;
+		failed += worker->failed;
+		total_ticks += worker->total_ticks;
+		max_ticks = spdk_max(max_ticks, worker->max_ticks);
+	}
+	elapsed_us = (spdk_get_ticks() - tsc_start) * SPDK_SEC_TO_USEC / g_tsc_rate;
+
+	printf("Iteration %3u: %8" PRIu64 " qpairs in %10" PRIu64 " us (%10.2f connects/s)"
+	       " avg %8.2f us max %8.2f us",
+	       iteration, connected, elapsed_us,
+	       elapsed_us ? (double)connected * SPDK_SEC_TO_USEC / elapsed_us : 0.0,
+	       connected ? (double)total_ticks * SPDK_SEC_TO_USEC / g_tsc_rate / connected : 0.0,
+	       (double)max_ticks * SPDK_SEC_TO_USEC / g_tsc_rate);
+	if (failed) {
+		printf(" failed %" PRIu64, failed);
+	}
+	printf("\n");
+
+	free_qpairs();
+
+	return failed ? -EIO : 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct spdk_env_opts opts;
+	uint32_t i;
+	int rc;
+
+	rc = parse_args(argc, argv);
+	if (rc != 0) {
+		return rc;
+	}
+
+	spdk_env_opts_init(&opts);
+	opts.name = "connect_storm";
+	opts.core_mask = "0x1";
+	opts.shm_id = -1;
+	if (spdk_env_init(&opts) < 0) {
+		fprintf(stderr, "Unable to initialize SPDK env\n");
+		return 1;
+	}
+
+	g_tsc_rate = spdk_get_ticks_hz();
+
+	g_workers = calloc(g_num_workers, sizeof(*g_workers));
+	if (g_workers == NULL) {
+		fprintf(stderr, "Unable to allocate workers\n");
+		return 1;
+	}
+
+	rc = attach_controllers();
+	if (rc != 0) {
+		goto cleanup;
+	}
+
+	printf("Attached %u controllers, %u I/O qpairs each, %u connecting threads\n",
+	       g_num_ctrlrs, g_num_qpairs, g_num_workers);
+
+	for (i = 0; i < g_num_iterations; i++) {
+		rc = run_storm(i);
+		if (rc != 0) {
+			break;
+		}
+	}
+
+cleanup:
+	detach_controllers();
+	free(g_workers);
+
+	if (rc != 0) {
+		fprintf(stderr, "%s: errors occurred\n", argv[0]);
+	}
+
+	return rc != 0;
+}
@@ -0,0 +1,81 @@
+#!/usr/bin/env bash
+
+testdir=$(readlink -f $(dirname $0))
+rootdir=$(readlink -f $testdir/../../..)
+source $rootdir/test/common/autotest_common.sh
+source $rootdir/test/nvmf/common.sh
+
+MALLOC_BDEV_SIZE=64
+MALLOC_BLOCK_SIZE=512
+
+rpc_py="$rootdir/scripts/rpc.py"
+
+if [ "$TEST_TRANSPORT" != "rdma" ]; then
+	echo "Inline data is specific to the RDMA transport, skipping"
+	exit 0
+fi
+
+if [ $RUN_NIGHTLY -eq 1 ]; then
+	run_time=10
+else
+	run_time=2
+fi
+
+function jsum()
+{
+	local filter=$1
+	jq "$filter" | awk '{s+=$1}END{print s}'
+}
+
+# Run small random reads against a fresh target with the given max_inline_data_size
+# and store the IOPS reported by perf in perf_iops.
+function inline_perf()
+{
+	local inline_size=$1
+	local io_size=$2
+	local stats inline_wrs send_wrs send_doorbells
+
+	nvmfappstart "-m 0xF"
+
+	$rpc_py nvmf_create_transport $NVMF_TRANSPORT_OPTS -l $inline_size
+	$rpc_py bdev_malloc_create $MALLOC_BDEV_SIZE $MALLOC_BLOCK_SIZE -b Malloc0
+	$rpc_py nvmf_subsystem_create nqn.2016-06.io.spdk:cnode1 -a -s SPDK00000000000001
+	$rpc_py nvmf_subsystem_add_ns nqn.2016-06.io.spdk:cnode1 Malloc0
+	$rpc_py nvmf_subsystem_add_listener nqn.2016-06.io.spdk:cnode1 -t $TEST_TRANSPORT -a $NVMF_FIRST_TARGET_IP -s $NVMF_PORT
+
+	perf_iops=$($rootdir/examples/nvme/perf/perf -q 32 -o $io_size -w randread -t $run_time \
+		-r "trtype:$TEST_TRANSPORT adrfam:IPv4 traddr:$NVMF_FIRST_TARGET_IP trsvcid:$NVMF_PORT" \
+		| awk '/^Total/ {print int($3)}')
+
+	stats=$($rpc_py nvmf_get_stats)
+	inline_wrs=$(jsum '.poll_groups[].transports[].devices[].inline_data_wrs' <<< "$stats")
+	send_wrs=$(jsum '.poll_groups[].transports[].devices[].send_wrs' <<< "$stats")
+	send_doorbells=$(jsum '.poll_groups[].transports[].devices[].send_doorbells' <<< "$stats")
+
+	# Work requests are posted in batches, never one doorbell per WR or more
+	[ "$send_doorbells" -le "$send_wrs" ]
+	if [ "$inline_size" -ge "$io_size" ]; then
+		[ "$inline_wrs" -gt 0 ]
+	else
+		[ "$inline_wrs" -eq 0 ]
+	fi
+
+	echo "inline=$inline_size io_size=$io_size iops=$perf_iops send_wrs=$send_wrs" \
+		"send_doorbells=$send_doorbells inline_data_wrs=$inline_wrs"
+
+	$rpc_py delete_nvmf_subsystem nqn.2016-06.io.spdk:cnode1
+	trap - SIGINT SIGTERM EXIT
+	nvmftestfini
+}
+
+timing_enter rdma_inline_perf
+nvmftestinit
+
+for io_size in 512 4096; do
+	inline_perf 256 $io_size
+	iops_inline=$perf_iops
+	inline_perf 0 $io_size
+	echo "io_size $io_size: $iops_inline IOPS with inline data, $perf_iops IOPS without"
+done
+
+timing_exit rdma_inline_perf
@@ -18,6 +18,7 @@ TEST_ARGS=$@
 run_test suite test/nvmf/target/filesystem.sh $TEST_ARGS
 run_test suite test/nvmf/target/discovery.sh $TEST_ARGS
 run_test suite test/nvmf/target/connect_disconnect.sh $TEST_ARGS
+run_test suite test/nvmf/target/connect_storm.sh $TEST_ARGS
 if [ $SPDK_TEST_NVME_CLI -eq 1 ]; then
 	run_test suite test/nvmf/target/nvme_cli.sh $TEST_ARGS
 fi
@@ -45,6 +46,7 @@ timing_enter host
 run_test suite test/nvmf/host/bdevperf.sh $TEST_ARGS
 run_test suite test/nvmf/host/identify.sh $TEST_ARGS
 run_test suite test/nvmf/host/perf.sh $TEST_ARGS
+run_test suite test/nvmf/host/rdma_inline_perf.sh $TEST_ARGS
 
 # TODO: disabled due to intermittent failures (RDMA_CM_EVENT_UNREACHABLE/ETIMEDOUT)
 #run_test test/nvmf/host/identify_kernel_nvmf.sh $TEST_ARGS
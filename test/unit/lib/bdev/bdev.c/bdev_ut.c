@@ -830,6 +830,231 @@ bdev_io_types_test(void)
 	poll_threads();
 }
 
+static void
+bdev_io_abort(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_io *bio_to_abort;
+	struct spdk_bdev_opts bdev_opts = {
+		.bdev_io_pool_size = 4,
+		.bdev_io_cache_size = 2,
+	};
+	int io_ctx;
+	int rc;
+
+	rc = spdk_bdev_set_opts(&bdev_opts);
+	CU_ASSERT(rc == 0);
+	spdk_bdev_initialize(bdev_init_cb, NULL);
+	poll_threads();
+
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open(bdev, true, NULL, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+
+	rc = spdk_bdev_read_blocks(desc, io_ch, NULL, 0, 1, io_done, &io_ctx);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	bio_to_abort = g_bdev_io;
+
+	/* ABORT is not supported */
+	rc = spdk_bdev_abort(desc, io_ch, &io_ctx, io_done, NULL);
+	CU_ASSERT(rc == -ENOTSUP);
+
+	ut_enable_io_type(SPDK_BDEV_IO_TYPE_ABORT, true);
+
+	/* A NULL cb_arg cannot identify an I/O */
+	rc = spdk_bdev_abort(desc, io_ch, NULL, io_done, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* No I/O was submitted with this cb_arg */
+	rc = spdk_bdev_abort(desc, io_ch, &rc, io_done, NULL);
+	CU_ASSERT(rc == -ENOENT);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+
+	/* The abort is passed to the module together with the I/O to abort */
+	rc = spdk_bdev_abort(desc, io_ch, &io_ctx, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	CU_ASSERT(g_bdev_io->type == SPDK_BDEV_IO_TYPE_ABORT);
+	CU_ASSERT(g_bdev_io->u.abort.bio_cb_arg == &io_ctx);
+	CU_ASSERT(g_bdev_io->u.abort.bio_to_abort == bio_to_abort);
+
+	g_io_done = false;
+	stub_complete_io(2);
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+
+	/* The I/O has completed, so there is nothing left to abort */
+	rc = spdk_bdev_abort(desc, io_ch, &io_ctx, io_done, NULL);
+	CU_ASSERT(rc == -ENOENT);
+
+	ut_enable_io_type(SPDK_BDEV_IO_TYPE_ABORT, false);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	spdk_bdev_finish(bdev_fini_cb, NULL);
+	poll_threads();
+}
+
+static uint64_t g_append_location;
+
+static void
+zone_append_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	g_io_done = true;
+	g_io_status = bdev_io->internal.status;
+	g_append_location = spdk_bdev_io_get_append_location(bdev_io);
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void
+bdev_zone_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_zone_info info[2];
+	char buf[512];
+	int rc;
+
+	spdk_bdev_initialize(bdev_init_cb, NULL);
+	poll_threads();
+
+	/* Zone calls are rejected on a regular bdev */
+	bdev = allocate_bdev("bdev0");
+	CU_ASSERT(spdk_bdev_is_zoned(bdev) == false);
+	CU_ASSERT(spdk_bdev_get_zone_size(bdev) == 0);
+	rc = spdk_bdev_open(bdev, true, NULL, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+
+	ut_enable_io_type(SPDK_BDEV_IO_TYPE_GET_ZONE_INFO, true);
+	ut_enable_io_type(SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT, true);
+	ut_enable_io_type(SPDK_BDEV_IO_TYPE_ZONE_APPEND, true);
+
+	rc = spdk_bdev_get_zone_info(desc, io_ch, 0, 1, info, io_done, NULL);
+	CU_ASSERT(rc == -ENOTSUP);
+	rc = spdk_bdev_zone_append(desc, io_ch, buf, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == -ENOTSUP);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+
+	/* The block count has to be a multiple of the zone size */
+	bdev = calloc(1, sizeof(*bdev));
+	SPDK_CU_ASSERT_FATAL(bdev != NULL);
+	bdev->name = "zoned0";
+	bdev->fn_table = &fn_table;
+	bdev->module = &bdev_ut_if;
+	bdev->blockcnt = 1024;
+	bdev->blocklen = 512;
+	bdev->zoned = true;
+	bdev->zone_size = 100;
+	rc = spdk_bdev_register(bdev);
+	CU_ASSERT(rc == -EINVAL);
+
+	bdev->zone_size = 128;
+	bdev->max_open_zones = 4;
+	bdev->optimal_open_zones = 2;
+	rc = spdk_bdev_register(bdev);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_bdev_is_zoned(bdev) == true);
+	CU_ASSERT(spdk_bdev_get_zone_size(bdev) == 128);
+	CU_ASSERT(spdk_bdev_get_max_open_zones(bdev) == 4);
+	CU_ASSERT(spdk_bdev_get_optimal_open_zones(bdev) == 2);
+	CU_ASSERT(spdk_bdev_get_zone_id(bdev, 300) == 256);
+
+	/* Zone management and append need a writable descriptor */
+	desc = NULL;
+	rc = spdk_bdev_open(bdev, false, NULL, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+	rc = spdk_bdev_zone_management(desc, io_ch, 0, SPDK_BDEV_ZONE_RESET, io_done, NULL);
+	CU_ASSERT(rc == -EBADF);
+	rc = spdk_bdev_zone_append(desc, io_ch, buf, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == -EBADF);
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+
+	desc = NULL;
+	rc = spdk_bdev_open(bdev, true, NULL, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+
+	/* Zone ids must be the first block of a zone within the bdev */
+	rc = spdk_bdev_get_zone_info(desc, io_ch, 1, 1, info, io_done, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_bdev_get_zone_info(desc, io_ch, 896, 2, info, io_done, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_bdev_zone_management(desc, io_ch, 1024, SPDK_BDEV_ZONE_OPEN, io_done, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_bdev_zone_append(desc, io_ch, buf, 64, 1, io_done, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_bdev_zone_append(desc, io_ch, buf, 0, 129, io_done, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	rc = spdk_bdev_get_zone_info(desc, io_ch, 768, 2, info, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_io->type == SPDK_BDEV_IO_TYPE_GET_ZONE_INFO);
+	CU_ASSERT(g_bdev_io->u.zone_mgmt.zone_id == 768);
+	CU_ASSERT(g_bdev_io->u.zone_mgmt.num_zones == 2);
+	CU_ASSERT(g_bdev_io->u.zone_mgmt.buf == info);
+	g_io_done = false;
+	stub_complete_io(1);
+	CU_ASSERT(g_io_done == true);
+
+	rc = spdk_bdev_zone_management(desc, io_ch, 128, SPDK_BDEV_ZONE_FINISH, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_io->type == SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT);
+	CU_ASSERT(g_bdev_io->u.zone_mgmt.zone_id == 128);
+	CU_ASSERT(g_bdev_io->u.zone_mgmt.zone_action == SPDK_BDEV_ZONE_FINISH);
+	g_io_done = false;
+	stub_complete_io(1);
+	CU_ASSERT(g_io_done == true);
+
+	/* The module reports where the data was placed through offset_blocks */
+	rc = spdk_bdev_zone_append(desc, io_ch, buf, 128, 1, zone_append_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_io->type == SPDK_BDEV_IO_TYPE_ZONE_APPEND);
+	CU_ASSERT(g_bdev_io->u.bdev.offset_blocks == 128);
+	CU_ASSERT(g_bdev_io->u.bdev.num_blocks == 1);
+	CU_ASSERT(g_bdev_io->u.bdev.iovcnt == 1);
+	CU_ASSERT(g_bdev_io->u.bdev.iovs[0].iov_base == buf);
+	CU_ASSERT(g_bdev_io->u.bdev.iovs[0].iov_len == 512);
+	g_bdev_io->u.bdev.offset_blocks = 133;
+	g_io_done = false;
+	g_append_location = 0;
+	stub_complete_io(1);
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_append_location == 133);
+
+	ut_enable_io_type(SPDK_BDEV_IO_TYPE_GET_ZONE_INFO, false);
+	ut_enable_io_type(SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT, false);
+	ut_enable_io_type(SPDK_BDEV_IO_TYPE_ZONE_APPEND, false);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	spdk_bdev_finish(bdev_fini_cb, NULL);
+	poll_threads();
+}
+
 static void
 bdev_io_wait_test(void)
 {
@@ -2077,6 +2302,8 @@ main(int argc, char **argv)
 		CU_add_test(suite, "get_device_stat", get_device_stat_test) == NULL ||
 		CU_add_test(suite, "bdev_io_types", bdev_io_types_test) == NULL ||
 		CU_add_test(suite, "bdev_io_wait", bdev_io_wait_test) == NULL ||
+		CU_add_test(suite, "bdev_io_abort", bdev_io_abort) == NULL ||
+		CU_add_test(suite, "bdev_zone", bdev_zone_test) == NULL ||
 		CU_add_test(suite, "bdev_io_spans_boundary", bdev_io_spans_boundary_test) == NULL ||
 		CU_add_test(suite, "bdev_io_split", bdev_io_split) == NULL ||
 		CU_add_test(suite, "bdev_io_split_with_io_wait", bdev_io_split_with_io_wait) == NULL ||
@@ -61,6 +61,8 @@ bool lvol_already_opened = false;
 bool g_examine_done = false;
 bool g_bdev_alias_already_exists = false;
 bool g_lvs_with_name_already_exists = false;
+struct spdk_bs_dev *g_shallow_copy_ext_dev = NULL;
+const struct spdk_blob_copy_opts *g_shallow_copy_opts = NULL;
 
 int
 spdk_bdev_alias_add(struct spdk_bdev *bdev, const char *alias)
@@ -211,11 +213,23 @@ spdk_blob_is_thin_provisioned(struct spdk_blob *blob)
 	return false;
 }
 
+bool
+spdk_blob_is_esnap_clone(const struct spdk_blob *blob)
+{
+	return false;
+}
+
+spdk_blob_id
+spdk_blob_get_id(struct spdk_blob *blob)
+{
+	return 0;
+}
+
 static struct spdk_lvol *_lvol_create(struct spdk_lvol_store *lvs);
 
 void
-spdk_lvs_load(struct spdk_bs_dev *dev,
-	      spdk_lvs_op_with_handle_complete cb_fn, void *cb_arg)
+spdk_lvs_load_ext(struct spdk_bs_dev *dev, const struct spdk_lvs_opts *o,
+		  spdk_lvs_op_with_handle_complete cb_fn, void *cb_arg)
 {
 	struct spdk_lvol_store *lvs = NULL;
 	int i;
@@ -310,6 +324,13 @@ spdk_bdev_create_bs_dev(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb,
 	return bs_dev;
 }
 
+struct spdk_bs_dev *
+spdk_bdev_create_bs_dev_ro(struct spdk_bdev *bdev, spdk_bdev_remove_cb_t remove_cb,
+			   void *remove_ctx)
+{
+	return NULL;
+}
+
 void
 spdk_lvs_opts_init(struct spdk_lvs_opts *opts)
 {
@@ -410,6 +431,18 @@ spdk_lvol_set_read_only(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, voi
 	cb_fn(cb_arg, 0);
 }
 
+void
+spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
+		       const struct spdk_blob_copy_opts *opts,
+		       spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	/* The destination must stay claimed until the copy completes */
+	CU_ASSERT(lvol_already_opened == true);
+	g_shallow_copy_ext_dev = ext_dev;
+	g_shallow_copy_opts = opts;
+	cb_fn(cb_arg, 0);
+}
+
 int
 spdk_bdev_notify_blockcnt_change(struct spdk_bdev *bdev, uint64_t size)
 {
@@ -423,6 +456,36 @@ spdk_bs_get_cluster_size(struct spdk_blob_store *bs)
 	return g_cluster_size;
 }
 
+struct spdk_bdev *
+spdk_bdev_first(void)
+{
+	return g_base_bdev;
+}
+
+struct spdk_bdev *
+spdk_bdev_next(struct spdk_bdev *prev)
+{
+	return NULL;
+}
+
+const struct spdk_uuid *
+spdk_bdev_get_uuid(const struct spdk_bdev *bdev)
+{
+	return &bdev->uuid;
+}
+
+uint64_t
+spdk_bdev_get_num_blocks(const struct spdk_bdev *bdev)
+{
+	return bdev->blockcnt;
+}
+
+uint32_t
+spdk_bdev_get_block_size(const struct spdk_bdev *bdev)
+{
+	return bdev->blocklen;
+}
+
 struct spdk_bdev *
 spdk_bdev_get_by_name(const char *bdev_name)
 {
@@ -594,6 +657,23 @@ spdk_lvol_create(struct spdk_lvol_store *lvs, const char *name, size_t sz,
 	return 0;
 }
 
+int
+spdk_lvol_create_esnap_clone(const void *esnap_id, uint32_t id_len, uint64_t size_bytes,
+			     struct spdk_lvol_store *lvs, const char *clone_name,
+			     spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg)
+{
+	struct spdk_lvol *clone;
+
+	CU_ASSERT(id_len == SPDK_UUID_STRING_LEN);
+	CU_ASSERT(size_bytes % g_cluster_size == 0);
+
+	clone = _lvol_create(lvs);
+	snprintf(clone->name, sizeof(clone->name), "%s", clone_name);
+	cb_fn(cb_arg, clone, 0);
+
+	return 0;
+}
+
 void
 spdk_lvol_create_snapshot(struct spdk_lvol *lvol, const char *snapshot_name,
 			  spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg)
@@ -650,6 +730,12 @@ vbdev_lvol_set_read_only_complete(void *cb_arg, int lvolerrno)
 	g_lvolerrno = lvolerrno;
 }
 
+static void
+vbdev_lvol_shallow_copy_complete(void *cb_arg, int lvolerrno)
+{
+	g_lvolerrno = lvolerrno;
+}
+
 static void
 vbdev_lvol_rename_complete(void *cb_arg, int lvolerrno)
 {
@@ -839,6 +925,61 @@ ut_lvol_clone(void)
 	CU_ASSERT(g_lvol_store == NULL);
 }
 
+static void
+ut_lvol_bdev_clone(void)
+{
+	struct spdk_lvol_store *lvs;
+	struct spdk_bdev esnap_bdev = {};
+	struct spdk_lvol *clone;
+	int rc;
+
+	g_cluster_size = 4096;
+	esnap_bdev.name = "esnap";
+	esnap_bdev.blocklen = 512;
+	esnap_bdev.blockcnt = 16;
+	spdk_uuid_generate(&esnap_bdev.uuid);
+	g_base_bdev = &esnap_bdev;
+
+	/* Lvol store is successfully created */
+	rc = vbdev_lvs_create(&g_bdev, "lvs", 0, LVS_CLEAR_WITH_UNMAP, lvol_store_op_with_handle_complete,
+			      NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+	lvs = g_lvol_store;
+
+	/* Bdev does not exist */
+	rc = vbdev_lvol_create_bdev_clone("missing", lvs, "clone", vbdev_lvol_create_complete, NULL);
+	CU_ASSERT(rc == -ENODEV);
+
+	/* Bdev size is not a multiple of the cluster size */
+	esnap_bdev.blockcnt = 15;
+	rc = vbdev_lvol_create_bdev_clone("esnap", lvs, "clone", vbdev_lvol_create_complete, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	esnap_bdev.blockcnt = 16;
+
+	/* Successful clone create, bdev looked up by UUID */
+	g_lvol = NULL;
+	g_lvolerrno = -1;
+	rc = vbdev_lvol_create_bdev_clone("esnap", lvs, "clone", vbdev_lvol_create_complete, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	CU_ASSERT(g_lvolerrno == 0);
+	clone = g_lvol;
+
+	/* Successful clone destroy */
+	vbdev_lvol_destroy(clone, lvol_store_op_complete, NULL);
+	CU_ASSERT(g_lvol == NULL);
+
+	/* Destroy lvol store */
+	vbdev_lvs_destruct(lvs, lvol_store_op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_lvol_store == NULL);
+
+	g_base_bdev = NULL;
+	g_cluster_size = 0;
+}
+
 static void
 ut_lvol_hotremove(void)
 {
@@ -1134,6 +1275,68 @@ ut_lvol_set_read_only(void)
 	CU_ASSERT(g_lvol_store == NULL);
 }
 
+static void
+ut_lvol_shallow_copy(void)
+{
+	struct spdk_lvol_store *lvs;
+	struct spdk_lvol *lvol;
+	struct spdk_bdev dst_bdev = {};
+	struct spdk_blob_copy_opts opts = {};
+	int sz = 10;
+	int rc = 0;
+
+	dst_bdev.name = "dst";
+	g_base_bdev = &dst_bdev;
+
+	/* Lvol store is successfully created */
+	rc = vbdev_lvs_create(&g_bdev, "lvs", 0, LVS_CLEAR_WITH_UNMAP, lvol_store_op_with_handle_complete,
+			      NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+	lvs = g_lvol_store;
+
+	/* Successful lvol create */
+	g_lvolerrno = -1;
+	rc = vbdev_lvol_create(lvs, "lvol", sz, false, LVOL_CLEAR_WITH_DEFAULT, vbdev_lvol_create_complete,
+			       NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvolerrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	lvol = g_lvol;
+
+	/* Destination bdev does not exist */
+	rc = vbdev_lvol_shallow_copy(lvol, "missing", &opts, vbdev_lvol_shallow_copy_complete, NULL);
+	CU_ASSERT(rc == -ENODEV);
+
+	/* Destination bdev is already in use */
+	rc = vbdev_lvol_shallow_copy(lvol, "dst", &opts, vbdev_lvol_shallow_copy_complete, NULL);
+	CU_ASSERT(rc == -ENODEV);
+
+	/* Successful shallow copy, destination device is released on completion */
+	lvol_already_opened = false;
+	g_lvolerrno = -1;
+	g_shallow_copy_ext_dev = NULL;
+	rc = vbdev_lvol_shallow_copy(lvol, "dst", &opts, vbdev_lvol_shallow_copy_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvolerrno == 0);
+	CU_ASSERT(g_shallow_copy_ext_dev != NULL);
+	CU_ASSERT(g_shallow_copy_opts == &opts);
+	CU_ASSERT(lvol_already_opened == false);
+	lvol_already_opened = true;
+
+	/* Successful lvol destroy */
+	vbdev_lvol_destroy(lvol, lvol_store_op_complete, NULL);
+	CU_ASSERT(g_lvol == NULL);
+
+	/* Destroy lvol store */
+	vbdev_lvs_destruct(lvs, lvol_store_op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_lvol_store == NULL);
+
+	g_base_bdev = NULL;
+}
+
 static void
 ut_lvs_unload(void)
 {
@@ -1412,10 +1615,12 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "ut_lvol_init", ut_lvol_init) == NULL ||
 		CU_add_test(suite, "ut_lvol_snapshot", ut_lvol_snapshot) == NULL ||
 		CU_add_test(suite, "ut_lvol_clone", ut_lvol_clone) == NULL ||
+		CU_add_test(suite, "ut_lvol_bdev_clone", ut_lvol_bdev_clone) == NULL ||
 		CU_add_test(suite, "ut_lvs_destroy", ut_lvs_destroy) == NULL ||
 		CU_add_test(suite, "ut_lvs_unload", ut_lvs_unload) == NULL ||
 		CU_add_test(suite, "ut_lvol_resize", ut_lvol_resize) == NULL ||
 		CU_add_test(suite, "ut_lvol_set_read_only", ut_lvol_set_read_only) == NULL ||
+		CU_add_test(suite, "ut_lvol_shallow_copy", ut_lvol_shallow_copy) == NULL ||
 		CU_add_test(suite, "lvol_hotremove", ut_lvol_hotremove) == NULL ||
 		CU_add_test(suite, "ut_vbdev_lvol_get_io_channel", ut_vbdev_lvol_get_io_channel) == NULL ||
 		CU_add_test(suite, "ut_vbdev_lvol_io_type_supported", ut_vbdev_lvol_io_type_supported) == NULL ||
@@ -0,0 +1,519 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_cunit.h"
+#include "spdk/env.h"
+#include "spdk_internal/mock.h"
+#include "common/lib/ut_multithread.c"
+#include "bdev/zone_block/vbdev_zone_block.c"
+
+#define BLOCK_CNT 1000
+#define BLOCK_SIZE 512
+#define ZONE_CAPACITY 100
+#define ZONE_SIZE 128
+#define NUM_ZONES (BLOCK_CNT / ZONE_CAPACITY)
+
+DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
+DEFINE_STUB_V(spdk_bdev_module_examine_done, (struct spdk_bdev_module *module));
+DEFINE_STUB_V(spdk_bdev_module_release_bdev, (struct spdk_bdev *bdev));
+DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
+DEFINE_STUB(spdk_bdev_module_claim_bdev, int, (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+		struct spdk_bdev_module *module), 0);
+DEFINE_STUB(spdk_bdev_io_type_supported, bool, (struct spdk_bdev *bdev,
+		enum spdk_bdev_io_type io_type), true);
+DEFINE_STUB(spdk_json_write_name, int, (struct spdk_json_write_ctx *w, const char *name), 0);
+DEFINE_STUB(spdk_json_write_named_string, int, (struct spdk_json_write_ctx *w,
+		const char *name, const char *val), 0);
+DEFINE_STUB(spdk_json_write_named_uint64, int, (struct spdk_json_write_ctx *w,
+		const char *name, uint64_t val), 0);
+DEFINE_STUB(spdk_json_write_object_begin, int, (struct spdk_json_write_ctx *w), 0);
+DEFINE_STUB(spdk_json_write_named_object_begin, int, (struct spdk_json_write_ctx *w,
+		const char *name), 0);
+DEFINE_STUB(spdk_json_write_object_end, int, (struct spdk_json_write_ctx *w), 0);
+
+struct spdk_bdev_desc {
+	struct spdk_bdev *bdev;
+};
+
+static struct spdk_bdev g_base_bdev;
+static struct spdk_bdev_desc g_base_desc = { .bdev = &g_base_bdev };
+static struct spdk_bdev *g_registered_bdev;
+static int g_io_device_base;
+
+static uint64_t g_base_offset;
+static uint64_t g_base_num_blocks;
+static int g_base_io_type;
+static enum spdk_bdev_io_status g_io_status;
+static int g_io_count;
+static struct spdk_io_channel *g_io_ch;
+
+struct spdk_bdev *
+spdk_bdev_get_by_name(const char *bdev_name)
+{
+	if (strcmp(bdev_name, g_base_bdev.name) == 0) {
+		return &g_base_bdev;
+	}
+	if (g_registered_bdev && strcmp(bdev_name, g_registered_bdev->name) == 0) {
+		return g_registered_bdev;
+	}
+
+	return NULL;
+}
+
+int
+spdk_bdev_open(struct spdk_bdev *bdev, bool write, spdk_bdev_remove_cb_t remove_cb,
+	       void *remove_ctx, struct spdk_bdev_desc **_desc)
+{
+	*_desc = &g_base_desc;
+	return 0;
+}
+
+struct spdk_bdev *
+spdk_bdev_desc_get_bdev(struct spdk_bdev_desc *desc)
+{
+	return desc->bdev;
+}
+
+const char *
+spdk_bdev_get_name(const struct spdk_bdev *bdev)
+{
+	return bdev->name;
+}
+
+bool
+spdk_bdev_is_zoned(const struct spdk_bdev *bdev)
+{
+	return bdev->zoned;
+}
+
+int
+spdk_bdev_register(struct spdk_bdev *bdev)
+{
+	g_registered_bdev = bdev;
+	return 0;
+}
+
+void
+spdk_bdev_unregister(struct spdk_bdev *bdev, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(bdev == g_registered_bdev);
+	bdev->fn_table->destruct(bdev->ctxt);
+	g_registered_bdev = NULL;
+
+	if (cb_fn) {
+		cb_fn(cb_arg, 0);
+	}
+}
+
+static int
+ut_base_ch_create(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_base_ch_destroy(void *io_device, void *ctx_buf)
+{
+}
+
+struct spdk_io_channel *
+spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc)
+{
+	return spdk_get_io_channel(&g_io_device_base);
+}
+
+void
+spdk_bdev_io_get_buf(struct spdk_bdev_io *bdev_io, spdk_bdev_io_get_buf_cb cb, uint64_t len)
+{
+	cb(g_io_ch, bdev_io, true);
+}
+
+void
+spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
+{
+	g_io_status = status;
+	g_io_count++;
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+}
+
+static int
+ut_base_io(int type, uint64_t offset_blocks, uint64_t num_blocks,
+	   spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	g_base_io_type = type;
+	g_base_offset = offset_blocks;
+	g_base_num_blocks = num_blocks;
+
+	cb(NULL, true, cb_arg);
+	return 0;
+}
+
+int
+spdk_bdev_writev_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_base_io(SPDK_BDEV_IO_TYPE_WRITE, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+int
+spdk_bdev_readv_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return ut_base_io(SPDK_BDEV_IO_TYPE_READ, offset_blocks, num_blocks, cb, cb_arg);
+}
+
+static void
+init_test_globals(void)
+{
+	memset(&g_base_bdev, 0, sizeof(g_base_bdev));
+	g_base_bdev.name = "Nvme0n1";
+	g_base_bdev.blockcnt = BLOCK_CNT;
+	g_base_bdev.blocklen = BLOCK_SIZE;
+	g_registered_bdev = NULL;
+
+	allocate_threads(1);
+	set_thread(0);
+	spdk_io_device_register(&g_io_device_base, ut_base_ch_create, ut_base_ch_destroy, 0, NULL);
+}
+
+static void
+free_test_globals(void)
+{
+	spdk_io_device_unregister(&g_io_device_base, NULL);
+	poll_threads();
+	free_threads();
+}
+
+static struct bdev_zone_block *
+create_test_zone_bdev(void)
+{
+	int rc;
+
+	rc = spdk_vbdev_zone_block_create("Nvme0n1", "zone_dev1", ZONE_CAPACITY, 1);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_registered_bdev != NULL);
+
+	return SPDK_CONTAINEROF(g_registered_bdev, struct bdev_zone_block, bdev);
+}
+
+static void
+delete_test_zone_bdev(void)
+{
+	spdk_vbdev_zone_block_delete("zone_dev1", NULL, NULL);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_nodes));
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_configs));
+}
+
+static int
+submit_io(struct bdev_zone_block *bdev_node, struct spdk_io_channel *ch,
+	  struct spdk_bdev_io *bdev_io)
+{
+	g_io_count = 0;
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+	bdev_io->bdev = &bdev_node->bdev;
+	g_io_ch = ch;
+	zone_block_submit_request(ch, bdev_io);
+	CU_ASSERT(g_io_count == 1);
+
+	return g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS ? 0 : -1;
+}
+
+static int
+submit_write(struct bdev_zone_block *bdev_node, struct spdk_io_channel *ch,
+	     int type, uint64_t lba, uint64_t num_blocks, struct spdk_bdev_io *bdev_io)
+{
+	memset(bdev_io, 0, sizeof(*bdev_io));
+	bdev_io->type = type;
+	bdev_io->u.bdev.offset_blocks = lba;
+	bdev_io->u.bdev.num_blocks = num_blocks;
+
+	return submit_io(bdev_node, ch, bdev_io);
+}
+
+static int
+submit_zone_mgmt(struct bdev_zone_block *bdev_node, struct spdk_io_channel *ch,
+		 uint64_t zone_id, enum spdk_bdev_zone_action action)
+{
+	struct spdk_bdev_io bdev_io = {};
+
+	bdev_io.type = SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT;
+	bdev_io.u.zone_mgmt.zone_id = zone_id;
+	bdev_io.u.zone_mgmt.zone_action = action;
+
+	return submit_io(bdev_node, ch, &bdev_io);
+}
+
+static void
+get_zone_info(struct bdev_zone_block *bdev_node, struct spdk_io_channel *ch,
+	      uint64_t zone_id, struct spdk_bdev_zone_info *info)
+{
+	struct spdk_bdev_io bdev_io = {};
+
+	bdev_io.type = SPDK_BDEV_IO_TYPE_GET_ZONE_INFO;
+	bdev_io.u.zone_mgmt.zone_id = zone_id;
+	bdev_io.u.zone_mgmt.num_zones = 1;
+	bdev_io.u.zone_mgmt.buf = info;
+
+	CU_ASSERT(submit_io(bdev_node, ch, &bdev_io) == 0);
+}
+
+static void
+test_zone_block_create(void)
+{
+	struct bdev_zone_block *bdev_node;
+	int rc;
+
+	init_test_globals();
+
+	/* Zero capacity and zero open zones are rejected */
+	rc = spdk_vbdev_zone_block_create("Nvme0n1", "zone_dev1", 0, 1);
+	CU_ASSERT(rc == -EINVAL);
+	rc = spdk_vbdev_zone_block_create("Nvme0n1", "zone_dev1", ZONE_CAPACITY, 0);
+	CU_ASSERT(rc == -EINVAL);
+
+	bdev_node = create_test_zone_bdev();
+	CU_ASSERT(bdev_node->bdev.zoned == true);
+	CU_ASSERT(bdev_node->bdev.zone_size == ZONE_SIZE);
+	CU_ASSERT(bdev_node->bdev.blockcnt == NUM_ZONES * ZONE_SIZE);
+	CU_ASSERT(bdev_node->bdev.optimal_io_boundary == ZONE_SIZE);
+	CU_ASSERT(bdev_node->bdev.split_on_optimal_io_boundary == true);
+	CU_ASSERT(bdev_node->num_zones == NUM_ZONES);
+	CU_ASSERT(bdev_node->zones[NUM_ZONES - 1].zone_info.zone_id == (NUM_ZONES - 1) * ZONE_SIZE);
+
+	/* The same vbdev or base bdev can't be used twice */
+	rc = spdk_vbdev_zone_block_create("Nvme0n1", "zone_dev1", ZONE_CAPACITY, 1);
+	CU_ASSERT(rc == -EEXIST);
+	rc = spdk_vbdev_zone_block_create("Nvme0n1", "zone_dev2", ZONE_CAPACITY, 1);
+	CU_ASSERT(rc == -EEXIST);
+
+	delete_test_zone_bdev();
+
+	/* Creation is deferred until the base bdev shows up */
+	rc = spdk_vbdev_zone_block_create("Nvme1n1", "zone_dev1", ZONE_CAPACITY, 1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_registered_bdev == NULL);
+	zone_block_finish();
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_configs));
+
+	free_test_globals();
+}
+
+static void
+test_zone_block_write(void)
+{
+	struct bdev_zone_block *bdev_node;
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_io bdev_io;
+	struct spdk_bdev_zone_info info;
+
+	init_test_globals();
+	bdev_node = create_test_zone_bdev();
+	ch = spdk_get_io_channel(bdev_node);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Writes have to start at the write pointer */
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_WRITE, ZONE_SIZE + 1, 1, &bdev_io) != 0);
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_WRITE, ZONE_SIZE, 10, &bdev_io) == 0);
+	CU_ASSERT(g_base_io_type == SPDK_BDEV_IO_TYPE_WRITE);
+	CU_ASSERT(g_base_offset == ZONE_CAPACITY);
+	CU_ASSERT(g_base_num_blocks == 10);
+
+	get_zone_info(bdev_node, ch, ZONE_SIZE, &info);
+	CU_ASSERT(info.zone_id == ZONE_SIZE);
+	CU_ASSERT(info.write_pointer == ZONE_SIZE + 10);
+	CU_ASSERT(info.capacity == ZONE_CAPACITY);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_OPEN);
+
+	/* Writes can't go past the zone capacity */
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_WRITE, ZONE_SIZE + 10,
+			       ZONE_CAPACITY, &bdev_io) != 0);
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_WRITE, ZONE_SIZE + 10,
+			       ZONE_CAPACITY - 10, &bdev_io) == 0);
+	get_zone_info(bdev_node, ch, ZONE_SIZE, &info);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_FULL);
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_WRITE, ZONE_SIZE + ZONE_CAPACITY,
+			       1, &bdev_io) != 0);
+
+	/* Reads are translated the same way as writes */
+	memset(&bdev_io, 0, sizeof(bdev_io));
+	bdev_io.type = SPDK_BDEV_IO_TYPE_READ;
+	bdev_io.u.bdev.offset_blocks = 2 * ZONE_SIZE + 5;
+	bdev_io.u.bdev.num_blocks = 5;
+	CU_ASSERT(submit_io(bdev_node, ch, &bdev_io) == 0);
+	CU_ASSERT(g_base_io_type == SPDK_BDEV_IO_TYPE_READ);
+	CU_ASSERT(g_base_offset == 2 * ZONE_CAPACITY + 5);
+
+	/* Reads beyond the zone capacity are rejected */
+	bdev_io.u.bdev.offset_blocks = 2 * ZONE_SIZE + ZONE_CAPACITY - 1;
+	bdev_io.u.bdev.num_blocks = 2;
+	CU_ASSERT(submit_io(bdev_node, ch, &bdev_io) != 0);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
+	delete_test_zone_bdev();
+	free_test_globals();
+}
+
+static void
+test_zone_block_append(void)
+{
+	struct bdev_zone_block *bdev_node;
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_io bdev_io;
+	struct spdk_bdev_zone_info info;
+
+	init_test_globals();
+	bdev_node = create_test_zone_bdev();
+	ch = spdk_get_io_channel(bdev_node);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Each append lands at the write pointer and reports where it went */
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_ZONE_APPEND, 3 * ZONE_SIZE, 8,
+			       &bdev_io) == 0);
+	CU_ASSERT(bdev_io.u.bdev.offset_blocks == 3 * ZONE_SIZE);
+	CU_ASSERT(g_base_offset == 3 * ZONE_CAPACITY);
+
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_ZONE_APPEND, 3 * ZONE_SIZE, 4,
+			       &bdev_io) == 0);
+	CU_ASSERT(bdev_io.u.bdev.offset_blocks == 3 * ZONE_SIZE + 8);
+	CU_ASSERT(g_base_offset == 3 * ZONE_CAPACITY + 8);
+
+	get_zone_info(bdev_node, ch, 3 * ZONE_SIZE, &info);
+	CU_ASSERT(info.write_pointer == 3 * ZONE_SIZE + 12);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_OPEN);
+
+	/* An append that doesn't fit in the zone fails without moving the write pointer */
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_ZONE_APPEND, 3 * ZONE_SIZE,
+			       ZONE_CAPACITY, &bdev_io) != 0);
+	get_zone_info(bdev_node, ch, 3 * ZONE_SIZE, &info);
+	CU_ASSERT(info.write_pointer == 3 * ZONE_SIZE + 12);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
+	delete_test_zone_bdev();
+	free_test_globals();
+}
+
+static void
+test_zone_block_management(void)
+{
+	struct bdev_zone_block *bdev_node;
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_io bdev_io;
+	struct spdk_bdev_zone_info info;
+
+	init_test_globals();
+	bdev_node = create_test_zone_bdev();
+	ch = spdk_get_io_channel(bdev_node);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Only zone start LBAs are accepted */
+	CU_ASSERT(submit_zone_mgmt(bdev_node, ch, 1, SPDK_BDEV_ZONE_OPEN) != 0);
+	CU_ASSERT(submit_zone_mgmt(bdev_node, ch, NUM_ZONES * ZONE_SIZE, SPDK_BDEV_ZONE_OPEN) != 0);
+
+	/* Opening and closing a zone that was never written leaves it empty */
+	CU_ASSERT(submit_zone_mgmt(bdev_node, ch, 0, SPDK_BDEV_ZONE_OPEN) == 0);
+	get_zone_info(bdev_node, ch, 0, &info);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_OPEN);
+	CU_ASSERT(submit_zone_mgmt(bdev_node, ch, 0, SPDK_BDEV_ZONE_CLOSE) == 0);
+	get_zone_info(bdev_node, ch, 0, &info);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_EMPTY);
+
+	/* A written zone is closed and reopened implicitly by the next write */
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_WRITE, 0, 1, &bdev_io) == 0);
+	CU_ASSERT(submit_zone_mgmt(bdev_node, ch, 0, SPDK_BDEV_ZONE_CLOSE) == 0);
+	get_zone_info(bdev_node, ch, 0, &info);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_CLOSED);
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_WRITE, 1, 1, &bdev_io) == 0);
+	get_zone_info(bdev_node, ch, 0, &info);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_OPEN);
+
+	/* Finish moves the write pointer to the end of the zone */
+	CU_ASSERT(submit_zone_mgmt(bdev_node, ch, 0, SPDK_BDEV_ZONE_FINISH) == 0);
+	get_zone_info(bdev_node, ch, 0, &info);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_FULL);
+	CU_ASSERT(info.write_pointer == ZONE_CAPACITY);
+	CU_ASSERT(submit_zone_mgmt(bdev_node, ch, 0, SPDK_BDEV_ZONE_OPEN) != 0);
+
+	/* Reset makes the zone writable from the start again */
+	CU_ASSERT(submit_zone_mgmt(bdev_node, ch, 0, SPDK_BDEV_ZONE_RESET) == 0);
+	get_zone_info(bdev_node, ch, 0, &info);
+	CU_ASSERT(info.state == SPDK_BDEV_ZONE_STATE_EMPTY);
+	CU_ASSERT(info.write_pointer == 0);
+	CU_ASSERT(submit_write(bdev_node, ch, SPDK_BDEV_IO_TYPE_WRITE, 0, 1, &bdev_io) == 0);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
+	delete_test_zone_bdev();
+	free_test_globals();
+}
+
+int main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	if (CU_initialize_registry() != CUE_SUCCESS) {
+		return CU_get_error();
+	}
+
+	suite = CU_add_suite("zone_block", NULL, NULL);
+	if (suite == NULL) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	if (
+		CU_add_test(suite, "test_zone_block_create", test_zone_block_create) == NULL ||
+		CU_add_test(suite, "test_zone_block_write", test_zone_block_write) == NULL ||
+		CU_add_test(suite, "test_zone_block_append", test_zone_block_append) == NULL ||
+		CU_add_test(suite, "test_zone_block_management", test_zone_block_management) == NULL
+	) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+	return num_failures;
+}
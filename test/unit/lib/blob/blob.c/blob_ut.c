@@ -142,6 +142,15 @@ blob_op_complete(void *cb_arg, int bserrno)
 	g_bserrno = bserrno;
 }
 
+static void
+blob_op_with_cnt_complete(void *cb_arg, int bserrno)
+{
+	int *cnt = cb_arg;
+
+	g_bserrno = bserrno;
+	(*cnt)++;
+}
+
 static void
 blob_op_with_id_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
 {
@@ -4478,6 +4487,239 @@ blob_thin_prov_alloc(void)
 	g_bs = NULL;
 }
 
+static int
+for_each_blob_count(void *cb_arg, struct spdk_blob *blob)
+{
+	uint32_t *count = cb_arg;
+
+	(*count)++;
+	return *count < 100 ? 0 : -ECANCELED;
+}
+
+static void
+blob_dirty_load_many(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob *blob;
+	spdk_blob_id blobid, last_blobid = SPDK_BLOBID_INVALID;
+	uint32_t used_md_pages, used_blobids;
+	uint64_t free_clusters;
+	uint32_t count;
+	size_t xattr_length;
+	char *xattr;
+	uint32_t i;
+	int rc;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.num_md_pages = 1200;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	/* Spread the blobs over more than one replay window. Some of them get
+	 * clusters and the last one a metadata page chain that starts past the
+	 * first window. */
+	xattr_length = 4072 - sizeof(struct spdk_blob_md_descriptor_xattr) - strlen("large_xattr");
+	xattr = calloc(xattr_length, sizeof(char));
+	SPDK_CU_ASSERT_FATAL(xattr != NULL);
+
+	for (i = 0; i < 600; i++) {
+		spdk_bs_create_blob(bs, blob_op_with_id_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		blobid = g_blobid;
+
+		if (i % 100 != 99) {
+			continue;
+		}
+
+		spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		blob = g_blob;
+
+		spdk_blob_resize(blob, 2, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		rc = spdk_blob_set_xattr(blob, "large_xattr", xattr, xattr_length);
+		CU_ASSERT(rc == 0);
+
+		spdk_blob_sync_md(blob, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		spdk_blob_close(blob, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		last_blobid = blobid;
+	}
+	free(xattr);
+	CU_ASSERT(_spdk_bs_blobid_to_page(last_blobid) >= SPDK_BS_LOAD_REPLAY_WINDOW_PAGES);
+
+	used_md_pages = spdk_bit_array_count_set(bs->used_md_pages);
+	used_blobids = spdk_bit_array_count_set(bs->used_blobids);
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	/* Dirty shutdown */
+	_spdk_bs_free(bs);
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	spdk_bs_load(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_md_pages) == used_md_pages);
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_blobids) == used_blobids);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+
+	spdk_bs_open_blob(bs, last_blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	CU_ASSERT(spdk_blob_get_num_clusters(g_blob) == 2);
+	spdk_blob_close(g_blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Stopping the traversal early closes every blob it opened */
+	count = 0;
+	g_bserrno = -1;
+	spdk_bs_for_each_blob(bs, 16, for_each_blob_count, blob_op_complete, &count);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -ECANCELED);
+	CU_ASSERT(count >= 100 && count < 100 + 16);
+	CU_ASSERT(bs->open_blobs.count == 0);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_open_many(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob *blobs[200];
+	struct spdk_blob *blob;
+	spdk_blob_id blobids[200];
+	spdk_blob_id snapshotid;
+	spdk_blob_id ids[2];
+	size_t count;
+	uint32_t i;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.num_md_pages = 512;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	/* Keep enough blobs open to grow the open blob hash a couple of times */
+	for (i = 0; i < SPDK_COUNTOF(blobs); i++) {
+		spdk_bs_create_blob(bs, blob_op_with_id_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		blobids[i] = g_blobid;
+
+		spdk_bs_open_blob(bs, blobids[i], blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		blobs[i] = g_blob;
+	}
+
+	CU_ASSERT(bs->open_blobs.count == SPDK_COUNTOF(blobs));
+	CU_ASSERT(bs->open_blobs.mask + 1 >= SPDK_COUNTOF(blobs));
+	for (i = 0; i < SPDK_COUNTOF(blobs); i++) {
+		CU_ASSERT(_spdk_blob_lookup(bs, blobids[i]) == blobs[i]);
+	}
+
+	/* Opening an open blob again finds the same handle */
+	spdk_bs_open_blob(bs, blobids[100], blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blob == blobs[100]);
+	spdk_blob_close(blobs[100], blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Snapshot and clone entries are looked up by id as well */
+	spdk_bs_create_snapshot(bs, blobids[0], NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+
+	spdk_bs_create_clone(bs, snapshotid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobids[0]) == snapshotid);
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, g_blobid) == snapshotid);
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobids[1]) == SPDK_BLOBID_INVALID);
+	count = SPDK_COUNTOF(ids);
+	CU_ASSERT(spdk_blob_get_clones(bs, snapshotid, ids, &count) == 0);
+	CU_ASSERT(count == 2);
+	CU_ASSERT(bs->clone_hash.count == 2);
+
+	spdk_bs_delete_blob(bs, g_blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->clone_hash.count == 1);
+
+	/* Deleting the snapshot hands its remaining clone back to no parent */
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->snapshot_hash.count == 0);
+	CU_ASSERT(bs->clone_hash.count == 0);
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobids[0]) == SPDK_BLOBID_INVALID);
+
+	/* Closed blobs can't be found any more, while the rest still can */
+	for (i = 0; i < SPDK_COUNTOF(blobs); i += 2) {
+		spdk_blob_close(blobs[i], blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	for (i = 0; i < SPDK_COUNTOF(blobs); i++) {
+		blob = _spdk_blob_lookup(bs, blobids[i]);
+		CU_ASSERT(blob == (i % 2 ? blobs[i] : NULL));
+	}
+	CU_ASSERT(bs->open_blobs.count == SPDK_COUNTOF(blobs) / 2);
+
+	for (i = 1; i < SPDK_COUNTOF(blobs); i += 2) {
+		spdk_blob_close(blobs[i], blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	CU_ASSERT(bs->open_blobs.count == 0);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
 static void
 blob_insert_cluster_msg(void)
 {
@@ -4520,7 +4762,8 @@ blob_insert_cluster_msg(void)
 	CU_ASSERT(blob->active.clusters[1] == 0);
 
 	_spdk_bs_claim_cluster(bs, 0xF);
-	_spdk_blob_insert_cluster_on_md_thread(blob, 1, 0xF, blob_op_complete, NULL);
+	_spdk_blob_insert_cluster_on_md_thread(spdk_io_channel_get_ctx(bs->md_channel), blob, 1, 0xF,
+					       blob_op_complete, NULL);
 	poll_threads();
 
 	CU_ASSERT(blob->active.clusters[1] != 0);
@@ -4656,9 +4899,9 @@ blob_thin_prov_rw(void)
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
-	/* For thin-provisioned blob we need to write 20 pages plus one page metadata and
-	 * read 0 bytes */
-	CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 21);
+	/* For thin-provisioned blob we need to write 20 pages plus one page metadata,
+	 * one new extent page and read 0 bytes */
+	CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 22);
 	CU_ASSERT(g_dev_read_bytes - read_bytes == 0);
 
 	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
@@ -4666,6 +4909,21 @@ blob_thin_prov_rw(void)
 	CU_ASSERT(g_bserrno == 0);
 	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
 
+	/* Allocating another cluster covered by the same extent page only
+	 * rewrites that extent page, not the rest of the metadata. */
+	write_bytes = g_dev_write_bytes;
+	spdk_blob_io_write(blob, channel, payload_write, 4 + 2 * 256, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 11);
+	CU_ASSERT(blob->state == SPDK_BLOB_STATE_CLEAN);
+
+	spdk_blob_io_read(blob, channel, payload_read, 4 + 2 * 256, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
 	spdk_blob_close(blob, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
@@ -4689,77 +4947,1136 @@ blob_thin_prov_rw(void)
 }
 
 static void
-blob_thin_prov_rw_iov(void)
+blob_md_group_commit_id_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	spdk_blob_id *id = cb_arg;
+
+	CU_ASSERT(bserrno == 0);
+	*id = blobid;
+}
+
+static void
+blob_md_group_commit_complete(void *cb_arg, int bserrno)
+{
+	int *rc = cb_arg;
+
+	*rc = bserrno;
+}
+
+static void
+blob_md_group_commit(void)
 {
-	static const uint8_t zero[10 * 4096] = { 0 };
 	struct spdk_blob_store *bs;
 	struct spdk_bs_dev *dev;
-	struct spdk_blob *blob;
-	struct spdk_io_channel *channel;
-	struct spdk_blob_opts opts;
-	spdk_blob_id blobid;
-	uint64_t free_clusters;
-	uint8_t payload_read[10 * 4096];
-	uint8_t payload_write[10 * 4096];
-	struct iovec iov_read[3];
-	struct iovec iov_write[3];
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob *blobs[16];
+	spdk_blob_id blobids[16];
+	int rcs[16];
+	uint64_t write_ops;
+	const void *value;
+	size_t value_len;
+	uint32_t i;
+	int rc;
 
 	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	snprintf(bs_opts.bstype.bstype, sizeof(bs_opts.bstype.bstype), "TESTTYPE");
 
-	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
 	bs = g_bs;
-	free_clusters = spdk_bs_free_cluster_count(bs);
-
-	channel = spdk_bs_alloc_io_channel(bs);
-	CU_ASSERT(channel != NULL);
-
-	spdk_blob_opts_init(&opts);
-	opts.thin_provision = true;
 
-	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	/* The first metadata update marks the blobstore dirty */
+	spdk_bs_create_blob(bs, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-	blobid = g_blobid;
 
-	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	/* The first create is written right away, the root pages of all the
+	 * others are written together while it is in flight. They are next to
+	 * each other, so that takes a single write.
+	 */
+	write_ops = g_dev_write_ops;
+	for (i = 0; i < 16; i++) {
+		blobids[i] = SPDK_BLOBID_INVALID;
+		spdk_bs_create_blob(bs, blob_md_group_commit_id_complete, &blobids[i]);
+	}
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	blob = g_blob;
+	CU_ASSERT(g_dev_write_ops - write_ops == 2);
 
-	CU_ASSERT(blob->active.num_clusters == 0);
+	for (i = 0; i < 16; i++) {
+		CU_ASSERT(blobids[i] != SPDK_BLOBID_INVALID);
 
-	/* The blob started at 0 clusters. Resize it to be 5, but still unallocated. */
-	spdk_blob_resize(blob, 5, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-	CU_ASSERT(blob->active.num_clusters == 5);
+		spdk_bs_open_blob(bs, blobids[i], blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		blobs[i] = g_blob;
 
-	spdk_blob_sync_md(blob, blob_op_complete, NULL);
+		rc = spdk_blob_set_xattr(blobs[i], "name", &blobids[i], sizeof(blobids[i]));
+		CU_ASSERT(rc == 0);
+	}
+
+	/* Same for syncs of many blobs */
+	write_ops = g_dev_write_ops;
+	for (i = 0; i < 16; i++) {
+		rcs[i] = -1;
+		spdk_blob_sync_md(blobs[i], blob_md_group_commit_complete, &rcs[i]);
+	}
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	/* Sync must not change anything */
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-	CU_ASSERT(blob->active.num_clusters == 5);
+	CU_ASSERT(g_dev_write_ops - write_ops == 2);
 
-	/* Payload should be all zeros from unallocated clusters */
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
-	iov_read[2].iov_len = 3 * 4096;
-	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	for (i = 0; i < 16; i++) {
+		CU_ASSERT(rcs[i] == 0);
+
+		spdk_blob_close(blobs[i], blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+	g_bs = NULL;
+
+	/* With a commit window, metadata writes wait for it to expire */
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	snprintf(bs_opts.bstype.bstype, sizeof(bs_opts.bstype.bstype), "TESTTYPE");
+	bs_opts.md_commit_window_us = 100;
+
+	spdk_bs_load(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	for (i = 0; i < 16; i++) {
+		spdk_bs_open_blob(bs, blobids[i], blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		blobs[i] = g_blob;
+
+		rc = spdk_blob_get_xattr_value(blobs[i], "name", &value, &value_len);
+		CU_ASSERT(rc == 0);
+		SPDK_CU_ASSERT_FATAL(value != NULL);
+		CU_ASSERT(value_len == sizeof(blobids[i]));
+		CU_ASSERT(memcmp(value, &blobids[i], value_len) == 0);
+
+		rc = spdk_blob_set_xattr(blobs[i], "length", &i, sizeof(i));
+		CU_ASSERT(rc == 0);
+	}
+
+	/* Marking the blobstore dirty is not part of the group commit */
+	rcs[0] = -1;
+	spdk_blob_sync_md(blobs[0], blob_md_group_commit_complete, &rcs[0]);
+	poll_threads();
+	CU_ASSERT(rcs[0] == -1);
+	spdk_delay_us(100);
+	/* The expired window poller unregisters itself, which poll_threads()
+	 * does not count as busy, so poll again for the writes it started. */
+	poll_threads();
+	poll_threads();
+	CU_ASSERT(rcs[0] == 0);
+
+	write_ops = g_dev_write_ops;
+	for (i = 1; i < 16; i++) {
+		rcs[i] = -1;
+		spdk_blob_sync_md(blobs[i], blob_md_group_commit_complete, &rcs[i]);
+	}
+	poll_threads();
+	CU_ASSERT(g_dev_write_ops == write_ops);
+	CU_ASSERT(rcs[1] == -1);
+
+	spdk_delay_us(100);
+	poll_threads();
+	poll_threads();
+	CU_ASSERT(g_dev_write_ops - write_ops == 1);
+
+	for (i = 0; i < 16; i++) {
+		CU_ASSERT(rcs[i] == 0);
+
+		spdk_blob_close(blobs[i], blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_thin_prov_unmap_release(void)
+{
+	static const uint8_t zero[4096] = { 0 };
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob *blob, *snapshot, *clone;
+	struct spdk_io_channel *channel, *channel_thread1;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid, cloneid;
+	uint64_t free_clusters;
+	uint8_t payload_read[4096];
+	uint8_t payload_write[4096];
+	int completed = 0;
+	uint64_t i;
+
+	dev = init_dev();
+
+	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	blobid = g_blobid;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	/* Allocate the first 4 clusters */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	for (i = 0; i < 4; i++) {
+		spdk_blob_io_write(blob, channel, payload_write, i * 256, 1, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	CU_ASSERT(free_clusters - 4 == spdk_bs_free_cluster_count(bs));
+
+	/* Unmapping part of a cluster keeps it allocated */
+	spdk_blob_io_unmap(blob, channel, 0, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 4 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.clusters[0] != 0);
+
+	/* Unmap covering cluster 1 and parts of clusters 0 and 2 only releases cluster 1 */
+	spdk_blob_io_unmap(blob, channel, 128, 512, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 3 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	CU_ASSERT(blob->active.clusters[1] == 0);
+	CU_ASSERT(blob->active.clusters[2] != 0);
+	CU_ASSERT(blob->state == SPDK_BLOB_STATE_CLEAN);
+
+	/* Write zeroes over clusters 2 to 4 releases the two allocated ones,
+	 * without allocating the last one */
+	spdk_blob_io_write_zeroes(blob, channel, 512, 768, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.clusters[2] == 0);
+	CU_ASSERT(blob->active.clusters[3] == 0);
+	CU_ASSERT(blob->active.clusters[4] == 0);
+
+	memset(payload_read, 0xFF, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 768, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, sizeof(payload_read)) == 0);
+
+	/* Releases issued together are synced together */
+	for (i = 1; i < 4; i++) {
+		spdk_blob_io_write(blob, channel, payload_write, i * 256, 1, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	CU_ASSERT(free_clusters - 4 == spdk_bs_free_cluster_count(bs));
+
+	g_bserrno = -1;
+	for (i = 1; i < 4; i++) {
+		spdk_blob_io_unmap(blob, channel, i * 256, 256, blob_op_complete, NULL);
+	}
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+
+	/* Clusters are not released while I/O on another thread may still use them */
+	spdk_blob_io_write(blob, channel, payload_write, 256, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
+
+	set_thread(1);
+	channel_thread1 = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel_thread1 != NULL);
+	spdk_blob_io_write(blob, channel_thread1, payload_write, 257, 1, blob_op_with_cnt_complete,
+			   &completed);
+	set_thread(0);
+	g_bserrno = -1;
+	spdk_blob_io_unmap(blob, channel, 256, 256, blob_op_complete, NULL);
+	poll_thread(0);
+	CU_ASSERT(blob->active.clusters[1] == 0);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(completed == 0);
+	CU_ASSERT(g_bserrno == -1);
+
+	poll_threads();
+	CU_ASSERT(completed == 1);
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+
+	set_thread(1);
+	spdk_bs_free_io_channel(channel_thread1);
+	set_thread(0);
+	poll_threads();
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Released clusters stay released after the blobstore is loaded again */
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+
+	dev = init_dev();
+	spdk_bs_load(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	for (i = 1; i < 5; i++) {
+		CU_ASSERT(blob->active.clusters[i] == 0);
+	}
+
+	/* Clusters of a clone are not released, the data of its snapshot would show through */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	spdk_bs_create_clone(bs, snapshotid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	cloneid = g_blobid;
+
+	spdk_bs_open_blob(bs, cloneid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	clone = g_blob;
+
+	spdk_blob_io_write(clone, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
+
+	spdk_blob_io_unmap(clone, channel, 0, 256, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(clone->active.clusters[0] != 0);
+
+	/* Snapshots are read-only, so their clusters can't be unmapped either */
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+
+	spdk_blob_io_unmap(snapshot, channel, 0, 256, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EPERM);
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
+
+	spdk_blob_close(snapshot, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_blob_close(clone, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_thin_prov_parallel_alloc(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid;
+	uint64_t free_clusters;
+	uint64_t page_size;
+	uint64_t write_bytes;
+	uint8_t payload_read[4096];
+	uint8_t payload_write[4096];
+	int completed = 0;
+
+	dev = init_dev();
+
+	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	page_size = spdk_bs_get_page_size(bs);
+
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 8;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	blobid = g_blobid;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	/* Allocations on thread 1 come from a pool claimed by its channel */
+	set_thread(1);
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	memset(payload_write, 0xA5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	CU_ASSERT(bs->num_reserved_clusters == SPDK_BS_CHANNEL_CLUSTER_POOL_SIZE - 1);
+	CU_ASSERT(free_clusters - 1 == spdk_bs_free_cluster_count(bs));
+	set_thread(0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->active.clusters[0] != 0);
+
+	/* Allocate three clusters at once, with a second write to one of them.
+	 * That write waits for the cluster, but does not claim another one. */
+	write_bytes = g_dev_write_bytes;
+	set_thread(1);
+	spdk_blob_io_write(blob, channel, payload_write, 256, 1, blob_op_with_cnt_complete, &completed);
+	spdk_blob_io_write(blob, channel, payload_write, 512, 1, blob_op_with_cnt_complete, &completed);
+	spdk_blob_io_write(blob, channel, payload_write, 768, 1, blob_op_with_cnt_complete, &completed);
+	spdk_blob_io_write(blob, channel, payload_write, 257, 1, blob_op_with_cnt_complete, &completed);
+	CU_ASSERT(free_clusters - 4 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(bs->num_reserved_clusters == SPDK_BS_CHANNEL_CLUSTER_POOL_SIZE - 4);
+	set_thread(0);
+	poll_threads();
+	CU_ASSERT(completed == 4);
+	CU_ASSERT(blob->active.clusters[1] != 0);
+	CU_ASSERT(blob->active.clusters[2] != 0);
+	CU_ASSERT(blob->active.clusters[3] != 0);
+	CU_ASSERT(blob->active.clusters[4] == 0);
+	CU_ASSERT(blob->state == SPDK_BLOB_STATE_CLEAN);
+	/* Four data pages, plus the extent page written once for the first insert
+	 * and once for the two inserts batched behind it. */
+	CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 6);
+
+	spdk_blob_io_read(blob, channel, payload_read, 257, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, sizeof(payload_read)) == 0);
+
+	/* Freeing the channel hands the unused part of its pool back */
+	set_thread(1);
+	spdk_bs_free_io_channel(channel);
+	set_thread(0);
+	poll_threads();
+	CU_ASSERT(bs->num_reserved_clusters == 0);
+	CU_ASSERT(bs->num_free_clusters == free_clusters - 4);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_delete_blob(bs, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_extent_pages(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob *blob, *legacy;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, legacy_id;
+	uint64_t free_clusters, used_md_pages;
+	uint64_t lba0, lba1100;
+	uint8_t payload_read[4096];
+	uint8_t payload_write[4096];
+	uint64_t i;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.cluster_sz = SPDK_BS_PAGE_SIZE * 4;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	used_md_pages = spdk_bit_array_count_set(bs->used_md_pages);
+
+	/* Thin provisioned blob spanning three extent pages */
+	spdk_blob_opts_init(&opts);
+	CU_ASSERT(opts.use_extent_table == true);
+	opts.thin_provision = true;
+	opts.num_clusters = 3 * SPDK_EXTENTS_PER_EP;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	blobid = g_blobid;
+
+	/* Blob in the old format, with the clusters in the metadata page chain */
+	spdk_blob_opts_init(&opts);
+	opts.use_extent_table = false;
+	opts.num_clusters = 10;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	legacy_id = g_blobid;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(blob->use_extent_table == true);
+	CU_ASSERT(blob->active.num_extent_pages == 3);
+	/* No extent pages are needed while nothing is allocated */
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_md_pages) == used_md_pages + 2);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	/* Allocate a cluster in the first and in the last extent page */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_io_write(blob, channel, payload_write, 1100 * 4, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters - 12 == spdk_bs_free_cluster_count(bs));
+
+	CU_ASSERT(blob->active.extent_pages[0] != 0);
+	CU_ASSERT(blob->active.extent_pages[1] == 0);
+	CU_ASSERT(blob->active.extent_pages[2] != 0);
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_md_pages) == used_md_pages + 4);
+	lba0 = blob->active.clusters[0];
+	lba1100 = blob->active.clusters[1100];
+	CU_ASSERT(lba0 != 0);
+	CU_ASSERT(lba1100 != 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Dirty shutdown - the used cluster and md page masks are rebuilt from
+	 * the extent tables and extent pages */
+	_spdk_bs_free(bs);
+
+	dev = init_dev();
+	spdk_bs_load(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	CU_ASSERT(free_clusters - 12 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_md_pages) == used_md_pages + 4);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 3 * SPDK_EXTENTS_PER_EP);
+	for (i = 0; i < spdk_blob_get_num_clusters(blob); i++) {
+		if (i == 0) {
+			CU_ASSERT(blob->active.clusters[i] == lba0);
+		} else if (i == 1100) {
+			CU_ASSERT(blob->active.clusters[i] == lba1100);
+		} else {
+			CU_ASSERT(blob->active.clusters[i] == 0);
+		}
+	}
+
+	spdk_bs_open_blob(bs, legacy_id, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	legacy = g_blob;
+	CU_ASSERT(legacy->use_extent_table == false);
+	CU_ASSERT(legacy->active.num_extent_pages == 0);
+	CU_ASSERT(spdk_blob_get_num_clusters(legacy) == 10);
+	for (i = 0; i < spdk_blob_get_num_clusters(legacy); i++) {
+		CU_ASSERT(legacy->active.clusters[i] != 0);
+	}
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 1100 * 4, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, sizeof(payload_read)) == 0);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	/* Shrinking the blob releases the extent pages past its new end */
+	spdk_blob_resize(blob, SPDK_EXTENTS_PER_EP, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_sync_md(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->active.num_extent_pages == 1);
+	CU_ASSERT(free_clusters - 11 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_md_pages) == used_md_pages + 3);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_close(legacy, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Clean shutdown and load */
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	dev = init_dev();
+	spdk_bs_load(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == SPDK_EXTENTS_PER_EP);
+	CU_ASSERT(blob->active.clusters[0] == lba0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Deleting the blobs releases all of their metadata pages */
+	spdk_bs_delete_blob(bs, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_delete_blob(bs, legacy_id, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_md_pages) == used_md_pages);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_thin_prov_rw_iov(void)
+{
+	static const uint8_t zero[10 * 4096] = { 0 };
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid;
+	uint64_t free_clusters;
+	uint8_t payload_read[10 * 4096];
+	uint8_t payload_write[10 * 4096];
+	struct iovec iov_read[3];
+	struct iovec iov_write[3];
+
+	dev = init_dev();
+
+	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	blobid = g_blobid;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	CU_ASSERT(blob->active.num_clusters == 0);
+
+	/* The blob started at 0 clusters. Resize it to be 5, but still unallocated. */
+	spdk_blob_resize(blob, 5, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.num_clusters == 5);
+
+	spdk_blob_sync_md(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	/* Sync must not change anything */
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.num_clusters == 5);
+
+	/* Payload should be all zeros from unallocated clusters */
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
+	iov_read[2].iov_len = 3 * 4096;
+	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	iov_write[0].iov_base = payload_write;
+	iov_write[0].iov_len = 1 * 4096;
+	iov_write[1].iov_base = payload_write + 1 * 4096;
+	iov_write[1].iov_len = 5 * 4096;
+	iov_write[2].iov_base = payload_write + 6 * 4096;
+	iov_write[2].iov_len = 4 * 4096;
+
+	spdk_blob_io_writev(blob, channel, iov_write, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
+	iov_read[2].iov_len = 3 * 4096;
+	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	/* Unload the blob store */
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+struct iter_ctx {
+	int		current_iter;
+	spdk_blob_id	blobid[4];
+};
+
+static void
+test_iter(void *arg, struct spdk_blob *blob, int bserrno)
+{
+	struct iter_ctx *iter_ctx = arg;
+	spdk_blob_id blobid;
+
+	CU_ASSERT(bserrno == 0);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(blobid == iter_ctx->blobid[iter_ctx->current_iter++]);
+}
+
+static void
+bs_load_iter(void)
+{
+	struct spdk_bs_dev *dev;
+	struct iter_ctx iter_ctx = { 0 };
+	struct spdk_blob *blob;
+	int i, rc;
+	struct spdk_bs_opts opts;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&opts);
+	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
+
+	/* Initialize a new blob store */
+	spdk_bs_init(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+
+	for (i = 0; i < 4; i++) {
+		g_bserrno = -1;
+		g_blobid = SPDK_BLOBID_INVALID;
+		spdk_bs_create_blob(g_bs, blob_op_with_id_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+		iter_ctx.blobid[i] = g_blobid;
+
+		g_bserrno = -1;
+		g_blob = NULL;
+		spdk_bs_open_blob(g_bs, g_blobid, blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(g_blob != NULL);
+		blob = g_blob;
+
+		/* Just save the blobid as an xattr for testing purposes. */
+		rc = spdk_blob_set_xattr(blob, "blobid", &g_blobid, sizeof(g_blobid));
+		CU_ASSERT(rc == 0);
+
+		/* Resize the blob */
+		spdk_blob_resize(blob, i, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		spdk_blob_close(blob, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	g_bserrno = -1;
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	dev = init_dev();
+	spdk_bs_opts_init(&opts);
+	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
+	opts.iter_cb_fn = test_iter;
+	opts.iter_cb_arg = &iter_ctx;
+
+	/* Test blob iteration during load after a clean shutdown. */
+	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+
+	/* Dirty shutdown */
+	_spdk_bs_free(g_bs);
+
+	dev = init_dev();
+	spdk_bs_opts_init(&opts);
+	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
+	opts.iter_cb_fn = test_iter;
+	iter_ctx.current_iter = 0;
+	opts.iter_cb_arg = &iter_ctx;
+
+	/* Test blob iteration during load after a dirty shutdown. */
+	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_snapshot_rw(void)
+{
+	static const uint8_t zero[10 * 4096] = { 0 };
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t free_clusters;
+	uint64_t cluster_size;
+	uint64_t page_size;
+	uint8_t payload_read[10 * 4096];
+	uint8_t payload_write[10 * 4096];
+	uint64_t write_bytes;
+	uint64_t read_bytes;
+
+	dev = init_dev();
+
+	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	cluster_size = spdk_bs_get_cluster_size(bs);
+	page_size = spdk_bs_get_page_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	blobid = g_blobid;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+
+	memset(payload_read, 0xFF, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
+
+	/* Create snapshot from blob */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	CU_ASSERT(snapshot->data_ro == true);
+	CU_ASSERT(snapshot->md_ro == true);
+
+	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
+
+	write_bytes = g_dev_write_bytes;
+	read_bytes = g_dev_read_bytes;
+
+	memset(payload_write, 0xAA, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
+
+	/* For a clone we need to allocate and copy one cluster, update one page of metadata,
+	 * write one new extent page and then write 10 pages of payload.
+	 */
+	CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 12 + cluster_size);
+	CU_ASSERT(g_dev_read_bytes - read_bytes == cluster_size);
+
+	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	/* Data on snapshot should not change after write to clone */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_read(snapshot, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_blob_close(snapshot, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_delete_blob(bs, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	/* Unload the blob store */
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_snapshot_rw_iov(void)
+{
+	static const uint8_t zero[10 * 4096] = { 0 };
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t free_clusters;
+	uint8_t payload_read[10 * 4096];
+	uint8_t payload_write[10 * 4096];
+	struct iovec iov_read[3];
+	struct iovec iov_write[3];
+
+	dev = init_dev();
+
+	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	blobid = g_blobid;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+
+	/* Create snapshot from blob */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	CU_ASSERT(snapshot->data_ro == true);
+	CU_ASSERT(snapshot->md_ro == true);
+	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
+
+	/* Payload should be all zeros from unallocated clusters */
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
+	iov_read[2].iov_len = 3 * 4096;
+	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
 
 	memset(payload_write, 0xE5, sizeof(payload_write));
 	iov_write[0].iov_base = payload_write;
@@ -4769,21 +6086,433 @@ blob_thin_prov_rw_iov(void)
 	iov_write[2].iov_base = payload_write + 6 * 4096;
 	iov_write[2].iov_len = 4 * 4096;
 
-	spdk_blob_io_writev(blob, channel, iov_write, 3, 250, 10, blob_op_complete, NULL);
+	spdk_blob_io_writev(blob, channel, iov_write, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
+	iov_read[2].iov_len = 3 * 4096;
+	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_blob_close(snapshot, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	/* Unload the blob store */
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+ut_fill_pattern(uint8_t *buf, uint64_t first_page, uint64_t num_pages)
+{
+	uint64_t i;
+
+	for (i = 0; i < num_pages; i++) {
+		memset(buf + i * 4096, (int)(first_page + i + 1), 4096);
+	}
+}
+
+static void
+blob_subcluster_cow(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel, *channel_thread1;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t full_mask, mask;
+	uint64_t read_bytes, write_bytes;
+	uint8_t snapshot_data[16 * 4096];
+	uint8_t expected[16 * 4096];
+	uint8_t payload_read[16 * 4096];
+	uint8_t payload_write[4 * 4096];
+	struct iovec iov;
+	int completed = 0;
+
+	dev = init_dev();
+
+	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	/* Default 1MiB clusters are split into 64 sub-clusters of 4 pages each */
+	CU_ASSERT(bs->subclusters_per_cluster == 64);
+	CU_ASSERT(bs->pages_per_subcluster == 4);
+	full_mask = _spdk_bs_subcluster_full_mask(bs);
+	CU_ASSERT(full_mask == UINT64_MAX);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.use_subcluster_cow = true;
+	opts.num_clusters = 5;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	blobid = g_blobid;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(blob->use_subcluster_cow == true);
+	CU_ASSERT(blob->invalid_flags & SPDK_BLOB_SUBCLUSTER_COW);
+
+	/* Fill first 16 pages before taking a snapshot */
+	ut_fill_pattern(snapshot_data, 0, 16);
+	spdk_blob_io_write(blob, channel, snapshot_data, 0, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 0) == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	CU_ASSERT(snapshot->use_subcluster_cow == true);
+	CU_ASSERT(blob->active.clusters[0] == 0);
+	memcpy(expected, snapshot_data, sizeof(expected));
+
+	/* Single page write copies only the rest of its sub-cluster */
+	read_bytes = g_dev_read_bytes;
+	write_bytes = g_dev_write_bytes;
+	memset(payload_write, 0xAA, 4096);
+	spdk_blob_io_write(blob, channel, payload_write, 5, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_bytes - read_bytes == 3 * 4096);
+	/* Four data pages, new extent page and the md page holding the mask */
+	CU_ASSERT(g_dev_write_bytes - write_bytes == 6 * 4096);
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	mask = full_mask & ~(1ULL << 1);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 0) == mask);
+	memcpy(expected + 5 * 4096, payload_write, 4096);
+
+	/* Write covering a whole sub-cluster does not read from the snapshot */
+	read_bytes = g_dev_read_bytes;
+	memset(payload_write, 0xBB, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 8, 4, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_bytes - read_bytes == 0);
+	mask &= ~(1ULL << 2);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 0) == mask);
+	memcpy(expected + 8 * 4096, payload_write, 4 * 4096);
+
+	/* Writes to the same sub-cluster from two threads are serialized */
+	set_thread(1);
+	channel_thread1 = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel_thread1 != NULL);
+	memset(payload_write, 0xCC, 4096);
+	spdk_blob_io_write(blob, channel_thread1, payload_write, 12, 1, blob_op_with_cnt_complete,
+			   &completed);
+	set_thread(0);
+	memset(payload_write + 4096, 0xDD, 4096);
+	iov.iov_base = payload_write + 4096;
+	iov.iov_len = 4096;
+	spdk_blob_io_writev(blob, channel, &iov, 1, 14, 1, blob_op_with_cnt_complete, &completed);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(completed == 2);
+	mask &= ~(1ULL << 3);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 0) == mask);
+	memcpy(expected + 12 * 4096, payload_write, 4096);
+	memcpy(expected + 14 * 4096, payload_write + 4096, 4096);
+
+	/* Clone returns its own sub-clusters and the snapshot's for the rest */
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(expected, payload_read, sizeof(payload_read)) == 0);
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(snapshot, channel, payload_read, 0, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(snapshot_data, payload_read, sizeof(payload_read)) == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_blob_close(snapshot, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	set_thread(1);
+	spdk_bs_free_io_channel(channel_thread1);
+	set_thread(0);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	/* Masks have to survive reload */
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+
+	dev = init_dev();
+	spdk_bs_load(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(blob->use_subcluster_cow == true);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 0) == mask);
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(expected, payload_read, sizeof(payload_read)) == 0);
+
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+ut_blob_read_cmp(struct spdk_blob *blob, struct spdk_io_channel *channel, const uint8_t *expected,
+		 uint64_t offset, uint64_t length)
+{
+	uint8_t payload_read[16 * 4096];
+
+	SPDK_CU_ASSERT_FATAL(length <= 16);
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, offset, length, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(expected, payload_read, length * 4096) == 0);
+}
+
+/**
+ * Sub-cluster copy-on-write across snapshot chains.
+ *
+ *                      cluster 0            cluster 1
+ *                   ,------------------+------------------.
+ *         snapshot  |xxxxxxxxxxxxx     |xxxxxxxxxxxxx     |
+ *                   +------------------+------------------+
+ *         snapshot2 |  y               |  y               |
+ *                   +------------------+------------------+
+ *         blob      |          z       |                  |
+ *                   '------------------+------------------'
+ *
+ * Deleting snapshot2 fills the blob's partial cluster 0 and hands over
+ * snapshot2's partial cluster 1 together with its mask. Inflating the
+ * blob afterwards leaves no partial clusters.
+ */
+static void
+blob_subcluster_cow_topology(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob *blob, *snapshot2;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid, snapshotid2;
+	uint64_t full_mask, pages_per_cluster;
+	uint8_t expected0[16 * 4096];
+	uint8_t expected1[16 * 4096];
+	uint8_t payload_write[4096];
+
+	dev = init_dev();
+
+	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	full_mask = _spdk_bs_subcluster_full_mask(bs);
+	pages_per_cluster = bs->pages_per_cluster;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.use_subcluster_cow = true;
+	opts.num_clusters = 2;
+
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	blobid = g_blobid;
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	ut_fill_pattern(expected0, 0, 16);
+	ut_fill_pattern(expected1, 16, 16);
+	spdk_blob_io_write(blob, channel, expected0, 0, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_io_write(blob, channel, expected1, pages_per_cluster, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	/* Partial clusters 0 and 1 end up in snapshot2 */
+	memset(payload_write, 0xAA, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 1, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	memcpy(expected0 + 1 * 4096, payload_write, 4096);
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster + 1, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	memcpy(expected1 + 1 * 4096, payload_write, 4096);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid2 = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid2, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot2 = g_blob;
+	CU_ASSERT(snapshot2->active.clusters[0] != 0);
+	CU_ASSERT(_spdk_blob_subcluster_mask(snapshot2, 0) == (full_mask & ~1ULL));
+	CU_ASSERT(_spdk_blob_subcluster_mask(snapshot2, 1) == (full_mask & ~1ULL));
+	CU_ASSERT(blob->active.clusters[0] == 0);
+	CU_ASSERT(blob->active.clusters[1] == 0);
+
+	/* Copy for the blob reads through both snapshots */
+	memset(payload_write, 0xBB, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 10, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	memcpy(expected0 + 10 * 4096, payload_write, 4096);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 0) == (full_mask & ~(1ULL << 2)));
+
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
+
+	spdk_blob_close(snapshot2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_delete_blob(bs, snapshotid2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	CU_ASSERT(blob->parent_id == snapshotid);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 0) == 0);
+	CU_ASSERT(blob->active.clusters[1] != 0);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 1) == (full_mask & ~1ULL));
+
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
+
+	/* Reload keeps the partial clusters taken over from snapshot2 */
+	spdk_blob_close(blob, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
-	iov_read[2].iov_len = 3 * 4096;
-	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	g_bs = NULL;
+
+	dev = init_dev();
+	spdk_bs_load(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 1) == (full_mask & ~1ULL));
+
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
+
+	/* Inflate fills every partial cluster */
+	spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->parent_id == SPDK_BLOBID_INVALID);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 0) == 0);
+	CU_ASSERT(_spdk_blob_subcluster_mask(blob, 1) == 0);
+
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
 
 	spdk_blob_close(blob, blob_op_complete, NULL);
 	poll_threads();
@@ -4792,7 +6521,6 @@ blob_thin_prov_rw_iov(void)
 	spdk_bs_free_io_channel(channel);
 	poll_threads();
 
-	/* Unload the blob store */
 	spdk_bs_unload(g_bs, bs_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
@@ -4801,358 +6529,447 @@ blob_thin_prov_rw_iov(void)
 	g_blobid = 0;
 }
 
-struct iter_ctx {
-	int		current_iter;
-	spdk_blob_id	blobid[4];
-};
+#define UT_ESNAP_ID "golden"
+#define UT_ESNAP_BLOCKLEN 512
 
-static void
-test_iter(void *arg, struct spdk_blob *blob, int bserrno)
+static int g_ut_esnap_devs;
+static int g_ut_esnap_channels;
+
+static struct spdk_io_channel *
+ut_esnap_create_channel(struct spdk_bs_dev *dev)
 {
-	struct iter_ctx *iter_ctx = arg;
-	spdk_blob_id blobid;
+	g_ut_esnap_channels++;
+	return &g_io_channel;
+}
 
-	CU_ASSERT(bserrno == 0);
-	blobid = spdk_blob_get_id(blob);
-	CU_ASSERT(blobid == iter_ctx->blobid[iter_ctx->current_iter++]);
+static void
+ut_esnap_destroy_channel(struct spdk_bs_dev *dev, struct spdk_io_channel *channel)
+{
+	g_ut_esnap_channels--;
 }
 
 static void
-bs_load_iter(void)
+ut_esnap_destroy(struct spdk_bs_dev *dev)
 {
-	struct spdk_bs_dev *dev;
-	struct iter_ctx iter_ctx = { 0 };
-	struct spdk_blob *blob;
-	int i, rc;
-	struct spdk_bs_opts opts;
+	g_ut_esnap_devs--;
+	free(dev);
+}
 
-	dev = init_dev();
-	spdk_bs_opts_init(&opts);
-	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
+/* Every block of the external snapshot holds the low byte of its lba */
+static void
+ut_esnap_fill(void *payload, uint64_t lba, uint32_t lba_count)
+{
+	uint32_t i;
 
-	/* Initialize a new blob store */
-	spdk_bs_init(dev, &opts, bs_op_with_handle_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	for (i = 0; i < lba_count; i++) {
+		memset((uint8_t *)payload + i * UT_ESNAP_BLOCKLEN, (int)((lba + i) & 0xFF), UT_ESNAP_BLOCKLEN);
+	}
+}
 
-	for (i = 0; i < 4; i++) {
-		g_bserrno = -1;
-		g_blobid = SPDK_BLOBID_INVALID;
-		spdk_bs_create_blob(g_bs, blob_op_with_id_complete, NULL);
-		poll_threads();
-		CU_ASSERT(g_bserrno == 0);
-		CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
-		iter_ctx.blobid[i] = g_blobid;
+static void
+ut_esnap_read(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payload,
+	      uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	CU_ASSERT(lba + lba_count <= dev->blockcnt);
+	ut_esnap_fill(payload, lba, lba_count);
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
 
-		g_bserrno = -1;
-		g_blob = NULL;
-		spdk_bs_open_blob(g_bs, g_blobid, blob_op_with_handle_complete, NULL);
-		poll_threads();
-		CU_ASSERT(g_bserrno == 0);
-		CU_ASSERT(g_blob != NULL);
-		blob = g_blob;
+static void
+ut_esnap_readv(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+	       struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+	       struct spdk_bs_dev_cb_args *cb_args)
+{
+	int i;
 
-		/* Just save the blobid as an xattr for testing purposes. */
-		rc = spdk_blob_set_xattr(blob, "blobid", &g_blobid, sizeof(g_blobid));
-		CU_ASSERT(rc == 0);
+	for (i = 0; i < iovcnt; i++) {
+		CU_ASSERT(iov[i].iov_len % UT_ESNAP_BLOCKLEN == 0);
+		ut_esnap_fill(iov[i].iov_base, lba, iov[i].iov_len / UT_ESNAP_BLOCKLEN);
+		lba += iov[i].iov_len / UT_ESNAP_BLOCKLEN;
+	}
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
 
-		/* Resize the blob */
-		spdk_blob_resize(blob, i, blob_op_complete, NULL);
-		poll_threads();
-		CU_ASSERT(g_bserrno == 0);
+static int
+ut_esnap_dev_create(void *bs_ctx, struct spdk_blob *blob, const void *esnap_id, uint32_t id_len,
+		    struct spdk_bs_dev **bs_dev)
+{
+	struct spdk_bs_dev *dev;
 
-		spdk_blob_close(blob, blob_op_complete, NULL);
-		poll_threads();
-		CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs_ctx == &g_ut_esnap_devs);
+	if (id_len != sizeof(UT_ESNAP_ID) || memcmp(esnap_id, UT_ESNAP_ID, id_len) != 0) {
+		return -ENODEV;
 	}
 
-	g_bserrno = -1;
+	dev = calloc(1, sizeof(*dev));
+	SPDK_CU_ASSERT_FATAL(dev != NULL);
+	dev->blocklen = UT_ESNAP_BLOCKLEN;
+	dev->blockcnt = DEV_BUFFER_SIZE / UT_ESNAP_BLOCKLEN;
+	dev->create_channel = ut_esnap_create_channel;
+	dev->destroy_channel = ut_esnap_destroy_channel;
+	dev->destroy = ut_esnap_destroy;
+	dev->read = ut_esnap_read;
+	dev->readv = ut_esnap_readv;
+
+	g_ut_esnap_devs++;
+	*bs_dev = dev;
+	return 0;
+}
+
+static void
+ut_esnap_bs_load(struct spdk_bs_opts *opts)
+{
+	struct spdk_bs_dev *dev;
+
 	spdk_bs_unload(g_bs, bs_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
 
 	dev = init_dev();
-	spdk_bs_opts_init(&opts);
-	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
-	opts.iter_cb_fn = test_iter;
-	opts.iter_cb_arg = &iter_ctx;
-
-	/* Test blob iteration during load after a clean shutdown. */
-	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+	spdk_bs_load(dev, opts, bs_op_with_handle_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+}
 
-	/* Dirty shutdown */
-	_spdk_bs_free(g_bs);
-
-	dev = init_dev();
-	spdk_bs_opts_init(&opts);
-	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "TESTTYPE");
-	opts.iter_cb_fn = test_iter;
-	iter_ctx.current_iter = 0;
-	opts.iter_cb_arg = &iter_ctx;
-
-	/* Test blob iteration during load after a dirty shutdown. */
-	spdk_bs_load(dev, &opts, bs_op_with_handle_complete, NULL);
+static struct spdk_blob *
+ut_blob_open(struct spdk_blob_store *bs, spdk_blob_id blobid)
+{
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	return g_blob;
+}
 
-	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+static void
+ut_blob_close(struct spdk_blob *blob)
+{
+	spdk_blob_close(blob, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	g_bs = NULL;
 }
 
 static void
-blob_snapshot_rw(void)
+blob_esnap_clone(void)
 {
-	static const uint8_t zero[10 * 4096] = { 0 };
 	struct spdk_blob_store *bs;
 	struct spdk_bs_dev *dev;
 	struct spdk_blob *blob, *snapshot;
-	struct spdk_io_channel *channel;
+	struct spdk_io_channel *channel, *channel_thread1;
+	struct spdk_bs_opts bs_opts;
 	struct spdk_blob_opts opts;
 	spdk_blob_id blobid, snapshotid;
-	uint64_t free_clusters;
-	uint64_t cluster_size;
-	uint64_t page_size;
-	uint8_t payload_read[10 * 4096];
-	uint8_t payload_write[10 * 4096];
-	uint64_t write_bytes;
-	uint64_t read_bytes;
+	uint64_t pages_per_cluster;
+	const void *esnap_id;
+	size_t id_len;
+	uint8_t expected0[16 * 4096];
+	uint8_t expected1[16 * 4096];
+	uint8_t payload_write[4096];
 
-	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.esnap_bs_dev_create = ut_esnap_dev_create;
+	bs_opts.esnap_ctx = &g_ut_esnap_devs;
 
-	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	dev = init_dev();
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
 	bs = g_bs;
-	free_clusters = spdk_bs_free_cluster_count(bs);
-	cluster_size = spdk_bs_get_cluster_size(bs);
-	page_size = spdk_bs_get_page_size(bs);
+	pages_per_cluster = bs->pages_per_cluster;
 
 	channel = spdk_bs_alloc_io_channel(bs);
 	CU_ASSERT(channel != NULL);
 
+	/* Thin provisioning is implied */
 	spdk_blob_opts_init(&opts);
-	opts.thin_provision = true;
-	opts.num_clusters = 5;
-
+	opts.num_clusters = 2;
+	opts.esnap_id = UT_ESNAP_ID;
+	opts.esnap_id_len = sizeof(UT_ESNAP_ID);
 	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
 	blobid = g_blobid;
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == bs->total_data_clusters);
 
-	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	blob = g_blob;
+	blob = ut_blob_open(bs, blobid);
+	CU_ASSERT(g_ut_esnap_devs == 1);
+	CU_ASSERT(spdk_blob_is_esnap_clone(blob));
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob));
+	CU_ASSERT(!spdk_blob_is_clone(blob));
+	CU_ASSERT(spdk_blob_get_esnap_id(blob, &esnap_id, &id_len) == 0);
+	CU_ASSERT(id_len == sizeof(UT_ESNAP_ID));
+	CU_ASSERT(memcmp(esnap_id, UT_ESNAP_ID, id_len) == 0);
 
-	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+	/* Reads go to the external snapshot, with a channel per thread created on first use */
+	ut_esnap_fill(expected0, 0, 16 * 4096 / UT_ESNAP_BLOCKLEN);
+	ut_esnap_fill(expected1, pages_per_cluster * 8, 16 * 4096 / UT_ESNAP_BLOCKLEN);
+	CU_ASSERT(g_ut_esnap_channels == 0);
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	CU_ASSERT(g_ut_esnap_channels == 1);
 
-	memset(payload_read, 0xFF, sizeof(payload_read));
-	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	set_thread(1);
+	channel_thread1 = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel_thread1 != NULL);
+	ut_blob_read_cmp(blob, channel_thread1, expected1, pages_per_cluster, 16);
+	CU_ASSERT(g_ut_esnap_channels == 2);
+	spdk_bs_free_io_channel(channel_thread1);
+	set_thread(0);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(g_ut_esnap_channels == 1);
 
-	memset(payload_write, 0xE5, sizeof(payload_write));
-	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	/* Write copies the rest of the cluster from the external snapshot */
+	memset(payload_write, 0xAA, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 1, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	memcpy(expected0 + 4096, payload_write, 4096);
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
 
-	/* Create snapshot from blob */
+	/* Snapshot takes over the external snapshot, blob becomes its clone */
 	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
 	snapshotid = g_blobid;
+	CU_ASSERT(g_ut_esnap_devs == 1);
 
-	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	snapshot = ut_blob_open(bs, snapshotid);
+	CU_ASSERT(spdk_blob_is_esnap_clone(snapshot));
+	CU_ASSERT(!spdk_blob_is_esnap_clone(blob));
+	CU_ASSERT(spdk_blob_is_clone(blob));
+	CU_ASSERT(blob->parent_id == snapshotid);
+	ut_blob_close(snapshot);
+
+	memset(payload_write, 0xBB, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster + 2, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	snapshot = g_blob;
-	CU_ASSERT(snapshot->data_ro == true);
-	CU_ASSERT(snapshot->md_ro == true);
-
-	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
+	memcpy(expected1 + 2 * 4096, payload_write, 4096);
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
 
-	write_bytes = g_dev_write_bytes;
-	read_bytes = g_dev_read_bytes;
-
-	memset(payload_write, 0xAA, sizeof(payload_write));
-	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	/* Deleting the snapshot hands the external snapshot back to the blob */
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(spdk_blob_is_esnap_clone(blob));
+	CU_ASSERT(blob->parent_id == SPDK_BLOBID_INVALID);
+	CU_ASSERT(g_ut_esnap_devs == 1);
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
+
+	/* Closing the blob puts the channels and destroys the device */
+	ut_blob_close(blob);
+	CU_ASSERT(g_ut_esnap_channels == 0);
+	CU_ASSERT(g_ut_esnap_devs == 0);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
 
-	/* For a clone we need to allocate and copy one cluster, update one page of metadata
-	 * and then write 10 pages of payload.
-	 */
-	CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 11 + cluster_size);
-	CU_ASSERT(g_dev_read_bytes - read_bytes == cluster_size);
+	ut_esnap_bs_load(&bs_opts);
+	bs = g_bs;
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
 
-	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	blob = ut_blob_open(bs, blobid);
+	CU_ASSERT(spdk_blob_is_esnap_clone(blob));
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
+
+	/* Decoupling a clone of the snapshot makes it a clone of the external snapshot */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	snapshotid = g_blobid;
+	CU_ASSERT(!spdk_blob_is_esnap_clone(blob));
 
-	/* Data on snapshot should not change after write to clone */
-	memset(payload_write, 0xE5, sizeof(payload_write));
-	spdk_blob_io_read(snapshot, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	spdk_bs_blob_decouple_parent(bs, channel, blobid, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(spdk_blob_is_esnap_clone(blob));
+	CU_ASSERT(blob->parent_id == SPDK_BLOBID_INVALID);
+	/* The snapshot got closed along with its own external snapshot device */
+	CU_ASSERT(g_ut_esnap_devs == 1);
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
 
-	spdk_blob_close(blob, blob_op_complete, NULL);
+	/* External snapshot has no parent blob to decouple from */
+	spdk_bs_blob_decouple_parent(bs, channel, blobid, blob_op_complete, NULL);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_bserrno == -EINVAL);
 
-	spdk_blob_close(snapshot, blob_op_complete, NULL);
+	/* Inflating removes the dependency on the external snapshot */
+	spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(!spdk_blob_is_esnap_clone(blob));
+	CU_ASSERT(!spdk_blob_is_thin_provisioned(blob));
+	CU_ASSERT(spdk_blob_get_esnap_id(blob, &esnap_id, &id_len) == -EINVAL);
+	CU_ASSERT(g_ut_esnap_devs == 0);
+	ut_blob_read_cmp(blob, channel, expected0, 0, 16);
+	ut_blob_read_cmp(blob, channel, expected1, pages_per_cluster, 16);
+	ut_blob_close(blob);
 
-	spdk_bs_delete_blob(bs, blobid, blob_op_complete, NULL);
+	spdk_bs_free_io_channel(channel);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_ut_esnap_channels == 0);
 
-	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	/* Clones of an external snapshot can't be opened without the callback */
+	ut_esnap_bs_load(NULL);
+	bs = g_bs;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_bserrno == -ENOTSUP);
 
-	spdk_bs_free_io_channel(channel);
+	blob = ut_blob_open(bs, blobid);
+	ut_blob_close(blob);
+
+	spdk_blob_opts_init(&opts);
+	opts.esnap_id = UT_ESNAP_ID;
+	opts.esnap_id_len = sizeof(UT_ESNAP_ID);
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
 	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
 
-	/* Unload the blob store */
 	spdk_bs_unload(g_bs, bs_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_ut_esnap_devs == 0);
 	g_bs = NULL;
 	g_blob = NULL;
 	g_blobid = 0;
 }
 
 static void
-blob_snapshot_rw_iov(void)
+ut_clone_chain_read(struct spdk_blob *blob, struct spdk_io_channel *channel,
+		    uint8_t *expected, uint64_t length, uint64_t expected_ops)
+{
+	uint8_t payload_read[4 * 4 * 4096];
+	struct iovec iov[3];
+	uint64_t read_ops;
+
+	memset(payload_read, 0, sizeof(payload_read));
+	read_ops = g_dev_read_ops;
+	spdk_blob_io_read(blob, channel, payload_read, 0, length, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_ops - read_ops == expected_ops);
+	CU_ASSERT(memcmp(expected, payload_read, length * 4096) == 0);
+
+	/* Same with iovs that don't line up with the cluster boundaries */
+	iov[0].iov_base = payload_read;
+	iov[0].iov_len = 5 * 4096;
+	iov[1].iov_base = payload_read + 5 * 4096;
+	iov[1].iov_len = 6 * 4096;
+	iov[2].iov_base = payload_read + 11 * 4096;
+	iov[2].iov_len = (length - 11) * 4096;
+
+	memset(payload_read, 0, sizeof(payload_read));
+	read_ops = g_dev_read_ops;
+	spdk_blob_io_readv(blob, channel, iov, 3, 0, length, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_ops - read_ops == expected_ops);
+	CU_ASSERT(memcmp(expected, payload_read, length * 4096) == 0);
+}
+
+static void
+blob_clone_chain_read(void)
 {
-	static const uint8_t zero[10 * 4096] = { 0 };
 	struct spdk_blob_store *bs;
 	struct spdk_bs_dev *dev;
-	struct spdk_blob *blob, *snapshot;
+	struct spdk_blob *blob;
 	struct spdk_io_channel *channel;
+	struct spdk_bs_opts bs_opts;
 	struct spdk_blob_opts opts;
-	spdk_blob_id blobid, snapshotid;
-	uint64_t free_clusters;
-	uint8_t payload_read[10 * 4096];
-	uint8_t payload_write[10 * 4096];
-	struct iovec iov_read[3];
-	struct iovec iov_write[3];
+	spdk_blob_id blobid, snapshotid[3];
+	uint64_t pages_per_cluster;
+	uint8_t expected[4 * 4 * 4096];
+	int i;
 
-	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.cluster_sz = 4 * SPDK_BS_PAGE_SIZE;
 
-	spdk_bs_init(dev, NULL, bs_op_with_handle_complete, NULL);
+	dev = init_dev();
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
 	bs = g_bs;
-	free_clusters = spdk_bs_free_cluster_count(bs);
+	pages_per_cluster = bs->pages_per_cluster;
+	SPDK_CU_ASSERT_FATAL(pages_per_cluster == 4);
 
 	channel = spdk_bs_alloc_io_channel(bs);
 	CU_ASSERT(channel != NULL);
 
+	/* Thick provisioned, so that the clusters are contiguous on the device */
 	spdk_blob_opts_init(&opts);
-	opts.thin_provision = true;
-	opts.num_clusters = 5;
-
+	opts.num_clusters = 4;
 	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
 	blobid = g_blobid;
+	blob = ut_blob_open(bs, blobid);
 
-	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	memset(expected, 0xAA, sizeof(expected));
+	spdk_blob_io_write(blob, channel, expected, 0, 4 * pages_per_cluster, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	blob = g_blob;
 
-	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+	/* Build blob -> snapshot2 -> snapshot1 -> snapshot0, with snapshot1 holding
+	 * cluster 1 and snapshot0 holding the others.
+	 */
+	for (i = 0; i < 3; i++) {
+		if (i == 1) {
+			memset(expected + pages_per_cluster * 4096, 0xBB, pages_per_cluster * 4096);
+			spdk_blob_io_write(blob, channel, expected + pages_per_cluster * 4096,
+					   pages_per_cluster, pages_per_cluster, blob_op_complete, NULL);
+			poll_threads();
+			CU_ASSERT(g_bserrno == 0);
+		}
 
-	/* Create snapshot from blob */
-	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
-	snapshotid = g_blobid;
+		spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+		snapshotid[i] = g_blobid;
+	}
 
-	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	snapshot = g_blob;
-	CU_ASSERT(snapshot->data_ro == true);
-	CU_ASSERT(snapshot->md_ro == true);
-	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
+	/* Clusters 0, 2 and 3 come from snapshot0 and cluster 1 from snapshot1. Clusters 2
+	 * and 3 are next to each other, so they take a single read. The second time around
+	 * the cluster locations are cached.
+	 */
+	ut_clone_chain_read(blob, channel, expected, 4 * pages_per_cluster, 3);
+	ut_clone_chain_read(blob, channel, expected, 4 * pages_per_cluster, 3);
 
-	/* Payload should be all zeros from unallocated clusters */
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
-	iov_read[2].iov_len = 3 * 4096;
-	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	/* Cluster 1 moves over to snapshot2 when snapshot1 is deleted */
+	spdk_bs_delete_blob(bs, snapshotid[1], blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
-
-	memset(payload_write, 0xE5, sizeof(payload_write));
-	iov_write[0].iov_base = payload_write;
-	iov_write[0].iov_len = 1 * 4096;
-	iov_write[1].iov_base = payload_write + 1 * 4096;
-	iov_write[1].iov_len = 5 * 4096;
-	iov_write[2].iov_base = payload_write + 6 * 4096;
-	iov_write[2].iov_len = 4 * 4096;
 
-	spdk_blob_io_writev(blob, channel, iov_write, 3, 250, 10, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	ut_clone_chain_read(blob, channel, expected, 4 * pages_per_cluster, 3);
 
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
-	iov_read[2].iov_len = 3 * 4096;
-	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	/* Once the clone holds cluster 3 itself, clusters 2 and 3 are not contiguous anymore */
+	memset(expected + 3 * pages_per_cluster * 4096, 0xCC, pages_per_cluster * 4096);
+	spdk_blob_io_write(blob, channel, expected + 3 * pages_per_cluster * 4096,
+			   3 * pages_per_cluster, pages_per_cluster, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
 
-	spdk_blob_close(blob, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	ut_clone_chain_read(blob, channel, expected, 4 * pages_per_cluster, 4);
 
-	spdk_blob_close(snapshot, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	ut_blob_close(blob);
 
 	spdk_bs_free_io_channel(channel);
 	poll_threads();
 
-	/* Unload the blob store */
 	spdk_bs_unload(g_bs, bs_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
@@ -5505,6 +7322,248 @@ blob_inflate_rw(void)
 	_blob_inflate_rw(true);
 }
 
+static void
+blob_inflate_rate_limit(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	struct spdk_blob_copy_opts copy_opts;
+	struct spdk_blob_copy_progress progress;
+	spdk_blob_id blobid, snapshotid;
+	uint8_t payload[16 * 4096];
+	int slices;
+
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.cluster_sz = 4 * SPDK_BS_PAGE_SIZE;
+
+	dev = init_dev();
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	spdk_blob_opts_init(&opts);
+	opts.num_clusters = 16;
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	blobid = g_blobid;
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+
+	blob = ut_blob_open(bs, blobid);
+	CU_ASSERT(spdk_blob_get_copy_progress(blob, &progress) == -ENOENT);
+
+	spdk_blob_copy_opts_init(&copy_opts);
+	copy_opts.queue_depth = 0;
+	spdk_bs_inflate_blob_ext(bs, channel, blobid, &copy_opts, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+	CU_ASSERT(spdk_blob_is_thin_provisioned(blob));
+
+	/* At 1 MiB/s a 16 KiB cluster takes a bit less than two 10 ms time slices */
+	copy_opts.queue_depth = 2;
+	copy_opts.mbytes_per_sec = 1;
+	g_bserrno = -1;
+	spdk_bs_inflate_blob_ext(bs, channel, blobid, &copy_opts, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -1);
+
+	CU_ASSERT(spdk_blob_get_copy_progress(blob, &progress) == 0);
+	CU_ASSERT(progress.clusters_total == 16);
+	CU_ASSERT(progress.clusters_done == 1);
+
+	/* Another copy of the same blob can't run at the same time */
+	spdk_bs_blob_decouple_parent(bs, channel, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EBUSY);
+	g_bserrno = -1;
+
+	spdk_delay_us(100000);
+	poll_threads();
+	CU_ASSERT(spdk_blob_get_copy_progress(blob, &progress) == 0);
+	CU_ASSERT(progress.clusters_done > 1 && progress.clusters_done < 16);
+	CU_ASSERT(progress.elapsed_ms == 100);
+	CU_ASSERT(progress.eta_ms > 0);
+
+	for (slices = 0; slices < 100 && g_bserrno == -1; slices++) {
+		spdk_delay_us(10000);
+		poll_threads();
+	}
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(slices > 10);
+	CU_ASSERT(spdk_blob_get_copy_progress(blob, &progress) == -ENOENT);
+	CU_ASSERT(!spdk_blob_is_thin_provisioned(blob));
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == SPDK_BLOBID_INVALID);
+
+	memset(payload, 0xFF, sizeof(payload));
+	spdk_blob_io_read(blob, channel, payload, 0, 16, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_mem_all_zero(payload, sizeof(payload)));
+
+	ut_blob_close(blob);
+
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+#define UT_COPY_DEV_BLOCKLEN 512
+
+static uint8_t *g_ut_copy_dev_buf;
+static uint64_t g_ut_copy_dev_writes;
+
+static struct spdk_io_channel *
+ut_copy_dev_create_channel(struct spdk_bs_dev *dev)
+{
+	return &g_io_channel;
+}
+
+static void
+ut_copy_dev_destroy_channel(struct spdk_bs_dev *dev, struct spdk_io_channel *channel)
+{
+}
+
+static void
+ut_copy_dev_write(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payload,
+		  uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	SPDK_CU_ASSERT_FATAL(lba + lba_count <= dev->blockcnt);
+	memcpy(g_ut_copy_dev_buf + lba * UT_COPY_DEV_BLOCKLEN, payload,
+	       lba_count * UT_COPY_DEV_BLOCKLEN);
+	g_ut_copy_dev_writes++;
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
+
+static void
+blob_shallow_copy(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_dev copy_dev = {};
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t cluster_size;
+	uint8_t payload[4 * 4096];
+	uint8_t expected[4 * 4 * 4096];
+
+	spdk_bs_opts_init(&bs_opts);
+	bs_opts.cluster_sz = 4 * SPDK_BS_PAGE_SIZE;
+
+	dev = init_dev();
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	cluster_size = spdk_bs_get_cluster_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	g_ut_copy_dev_buf = calloc(1, sizeof(expected));
+	SPDK_CU_ASSERT_FATAL(g_ut_copy_dev_buf != NULL);
+	copy_dev.blocklen = UT_COPY_DEV_BLOCKLEN;
+	copy_dev.blockcnt = sizeof(expected) / UT_COPY_DEV_BLOCKLEN;
+	copy_dev.create_channel = ut_copy_dev_create_channel;
+	copy_dev.destroy_channel = ut_copy_dev_destroy_channel;
+	copy_dev.write = ut_copy_dev_write;
+
+	/* Thin blob with data in clusters 0 and 2, and the snapshot of it */
+	spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 4;
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	blobid = g_blobid;
+	blob = ut_blob_open(bs, blobid);
+
+	memset(payload, 0xAA, sizeof(payload));
+	spdk_blob_io_write(blob, channel, payload, 0, 4, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	memset(payload, 0xBB, sizeof(payload));
+	spdk_blob_io_write(blob, channel, payload, 8, 4, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+
+	/* The clone itself now holds cluster 1 only */
+	memset(payload, 0xCC, sizeof(payload));
+	spdk_blob_io_write(blob, channel, payload, 4, 4, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Only read-only blobs can be copied */
+	spdk_bs_blob_shallow_copy(bs, channel, blobid, &copy_dev, NULL, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EPERM);
+
+	/* The device must be large enough */
+	copy_dev.blockcnt--;
+	spdk_bs_blob_shallow_copy(bs, channel, snapshotid, &copy_dev, NULL, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+	copy_dev.blockcnt++;
+
+	/* Clusters 1 and 3 of the device are left alone */
+	memset(g_ut_copy_dev_buf, 0x55, sizeof(expected));
+	memset(expected, 0x55, sizeof(expected));
+	memset(expected, 0xAA, cluster_size);
+	memset(expected + 2 * cluster_size, 0xBB, cluster_size);
+	g_ut_copy_dev_writes = 0;
+
+	spdk_bs_blob_shallow_copy(bs, channel, snapshotid, &copy_dev, NULL, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_ut_copy_dev_writes == 2);
+	CU_ASSERT(memcmp(g_ut_copy_dev_buf, expected, sizeof(expected)) == 0);
+
+	ut_blob_close(blob);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	spdk_bs_unload(g_bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+	free(g_ut_copy_dev_buf);
+	g_ut_copy_dev_buf = NULL;
+}
+
 /**
  * Snapshot-clones relation test
  *
@@ -7446,11 +9505,21 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "blob_set_xattrs", blob_set_xattrs) == NULL ||
 		CU_add_test(suite, "blob_thin_prov_alloc", blob_thin_prov_alloc) == NULL ||
 		CU_add_test(suite, "blob_insert_cluster_msg", blob_insert_cluster_msg) == NULL ||
+		CU_add_test(suite, "blob_open_many", blob_open_many) == NULL ||
+		CU_add_test(suite, "blob_dirty_load_many", blob_dirty_load_many) == NULL ||
+		CU_add_test(suite, "blob_md_group_commit", blob_md_group_commit) == NULL ||
 		CU_add_test(suite, "blob_thin_prov_rw", blob_thin_prov_rw) == NULL ||
+		CU_add_test(suite, "blob_thin_prov_unmap_release", blob_thin_prov_unmap_release) == NULL ||
+		CU_add_test(suite, "blob_extent_pages", blob_extent_pages) == NULL ||
+		CU_add_test(suite, "blob_thin_prov_parallel_alloc", blob_thin_prov_parallel_alloc) == NULL ||
 		CU_add_test(suite, "blob_thin_prov_rw_iov", blob_thin_prov_rw_iov) == NULL ||
 		CU_add_test(suite, "bs_load_iter", bs_load_iter) == NULL ||
 		CU_add_test(suite, "blob_snapshot_rw", blob_snapshot_rw) == NULL ||
 		CU_add_test(suite, "blob_snapshot_rw_iov", blob_snapshot_rw_iov) == NULL ||
+		CU_add_test(suite, "blob_subcluster_cow", blob_subcluster_cow) == NULL ||
+		CU_add_test(suite, "blob_subcluster_cow_topology", blob_subcluster_cow_topology) == NULL ||
+		CU_add_test(suite, "blob_esnap_clone", blob_esnap_clone) == NULL ||
+		CU_add_test(suite, "blob_clone_chain_read", blob_clone_chain_read) == NULL ||
 		CU_add_test(suite, "blob_relations", blob_relations) == NULL ||
 		CU_add_test(suite, "blob_relations2", blob_relations2) == NULL ||
 		CU_add_test(suite, "blob_delete_snapshot_power_failure",
@@ -7458,6 +9527,8 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "blob_create_snapshot_power_failure",
 			    blob_create_snapshot_power_failure) == NULL ||
 		CU_add_test(suite, "blob_inflate_rw", blob_inflate_rw) == NULL ||
+		CU_add_test(suite, "blob_inflate_rate_limit", blob_inflate_rate_limit) == NULL ||
+		CU_add_test(suite, "blob_shallow_copy", blob_shallow_copy) == NULL ||
 		CU_add_test(suite, "blob_snapshot_freeze_io", blob_snapshot_freeze_io) == NULL ||
 		CU_add_test(suite, "blob_operation_split_rw", blob_operation_split_rw) == NULL ||
 		CU_add_test(suite, "blob_operation_split_rw_iov", blob_operation_split_rw_iov) == NULL ||
@@ -67,6 +67,7 @@ struct spdk_blob {
 	char			uuid[SPDK_UUID_STRING_LEN];
 	char			name[SPDK_LVS_NAME_MAX];
 	bool			thin_provisioned;
+	bool			esnap_clone;
 };
 
 int g_lvolerrno;
@@ -74,6 +75,8 @@ int g_lvserrno;
 int g_close_super_status;
 int g_resize_rc;
 int g_inflate_rc;
+const struct spdk_blob_copy_opts *g_copy_opts;
+struct spdk_bs_dev *g_copy_ext_dev;
 int g_remove_rc;
 bool g_lvs_rename_blob_open_error = false;
 struct spdk_lvol_store *g_lvol_store;
@@ -95,15 +98,29 @@ struct lvol_ut_bs_dev {
 	struct spdk_blob_store	*bs;
 };
 
-void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
-			  spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
+void spdk_bs_inflate_blob_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			      spdk_blob_id blobid, const struct spdk_blob_copy_opts *opts,
+			      spdk_blob_op_complete cb_fn, void *cb_arg)
 {
+	g_copy_opts = opts;
 	cb_fn(cb_arg, g_inflate_rc);
 }
 
-void spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
-				  spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg)
+void spdk_bs_blob_decouple_parent_ext(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+				      spdk_blob_id blobid, const struct spdk_blob_copy_opts *opts,
+				      spdk_blob_op_complete cb_fn, void *cb_arg)
 {
+	g_copy_opts = opts;
+	cb_fn(cb_arg, g_inflate_rc);
+}
+
+void spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			       spdk_blob_id blobid, struct spdk_bs_dev *ext_dev,
+			       const struct spdk_blob_copy_opts *opts,
+			       spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	g_copy_opts = opts;
+	g_copy_ext_dev = ext_dev;
 	cb_fn(cb_arg, g_inflate_rc);
 }
 
@@ -141,6 +158,26 @@ spdk_bs_iter_first(struct spdk_blob_store *bs,
 	cb_fn(cb_arg, first, _errno);
 }
 
+void
+spdk_bs_for_each_blob(struct spdk_blob_store *bs, uint32_t queue_depth,
+		      spdk_blob_iter_fn fn, spdk_bs_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob *blob;
+	int _errno = 0;
+
+	TAILQ_FOREACH(blob, &bs->blobs, link) {
+		_errno = blob->load_status;
+		if (_errno == 0) {
+			_errno = fn(cb_arg, blob);
+		}
+		if (_errno != 0) {
+			break;
+		}
+	}
+
+	cb_fn(cb_arg, _errno);
+}
+
 uint64_t spdk_blob_get_num_clusters(struct spdk_blob *blob)
 {
 	return 0;
@@ -423,6 +460,15 @@ spdk_blob_opts_init(struct spdk_blob_opts *opts)
 	opts->xattrs.names = NULL;
 	opts->xattrs.ctx = NULL;
 	opts->xattrs.get_value = NULL;
+	opts->esnap_id = NULL;
+	opts->esnap_id_len = 0;
+}
+
+void
+spdk_blob_copy_opts_init(struct spdk_blob_copy_opts *opts)
+{
+	opts->queue_depth = SPDK_BLOB_COPY_DEFAULT_QUEUE_DEPTH;
+	opts->mbytes_per_sec = 0;
 }
 
 void
@@ -456,6 +502,9 @@ spdk_bs_create_blob_ext(struct spdk_blob_store *bs, const struct spdk_blob_opts
 	if (opts != NULL && opts->thin_provision) {
 		b->thin_provisioned = true;
 	}
+	if (opts != NULL && opts->esnap_id != NULL) {
+		b->esnap_clone = true;
+	}
 	b->bs = bs;
 
 	TAILQ_INSERT_TAIL(&bs->blobs, b, link);
@@ -1980,11 +2029,79 @@ lvol_create_thin_provisioned(void)
 	free_dev(&dev);
 }
 
+static int
+ut_esnap_dev_create(void *bs_ctx, struct spdk_blob *blob, const void *esnap_id, uint32_t id_len,
+		    struct spdk_bs_dev **bs_dev)
+{
+	return -ENOTSUP;
+}
+
+static void
+lvol_create_esnap_clone(void)
+{
+	struct lvol_ut_bs_dev dev;
+	struct spdk_lvs_opts opts;
+	const char esnap_id[] = "esnap";
+	int rc = 0;
+
+	init_dev(&dev);
+
+	spdk_lvs_opts_init(&opts);
+	snprintf(opts.name, sizeof(opts.name), "lvs");
+	opts.esnap_bs_dev_create = ut_esnap_dev_create;
+	opts.esnap_ctx = &dev;
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&dev.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+	CU_ASSERT(dev.bs->bs_opts.esnap_bs_dev_create == ut_esnap_dev_create);
+	CU_ASSERT(dev.bs->bs_opts.esnap_ctx == &dev);
+
+	/* Size must be a multiple of the cluster size */
+	rc = spdk_lvol_create_esnap_clone(esnap_id, sizeof(esnap_id), BS_CLUSTER_SIZE + 1,
+					  g_lvol_store, "clone", lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	rc = spdk_lvol_create_esnap_clone(NULL, 0, BS_CLUSTER_SIZE, g_lvol_store, "clone",
+					  lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	g_lvol = NULL;
+	rc = spdk_lvol_create_esnap_clone(esnap_id, sizeof(esnap_id), BS_CLUSTER_SIZE,
+					  g_lvol_store, "clone", lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	CU_ASSERT(g_lvol->blob->thin_provisioned == true);
+	CU_ASSERT(g_lvol->blob->esnap_clone == true);
+
+	/* Name has to be unique, the same as for other lvols */
+	rc = spdk_lvol_create_esnap_clone(esnap_id, sizeof(esnap_id), BS_CLUSTER_SIZE,
+					  g_lvol_store, "clone", lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == -EEXIST);
+
+	spdk_lvol_close(g_lvol, close_cb, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_destroy(g_lvol, destroy_cb, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(g_lvol_store, lvol_store_op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	g_lvol_store = NULL;
+
+	free_dev(&dev);
+}
+
 static void
 lvol_inflate(void)
 {
 	struct lvol_ut_bs_dev dev;
 	struct spdk_lvs_opts opts;
+	struct spdk_blob_copy_opts copy_opts;
 	int rc = 0;
 
 	init_dev(&dev);
@@ -2010,6 +2127,12 @@ lvol_inflate(void)
 	g_inflate_rc = 0;
 	spdk_lvol_inflate(g_lvol, lvol_op_complete, NULL);
 	CU_ASSERT(g_lvolerrno == 0);
+	CU_ASSERT(g_copy_opts == NULL);
+
+	spdk_blob_copy_opts_init(&copy_opts);
+	spdk_lvol_inflate_ext(g_lvol, &copy_opts, lvol_op_complete, NULL);
+	CU_ASSERT(g_lvolerrno == 0);
+	CU_ASSERT(g_copy_opts == &copy_opts);
 
 	spdk_lvol_close(g_lvol, close_cb, NULL);
 	CU_ASSERT(g_lvserrno == 0);
@@ -2035,6 +2158,7 @@ lvol_decouple_parent(void)
 {
 	struct lvol_ut_bs_dev dev;
 	struct spdk_lvs_opts opts;
+	struct spdk_blob_copy_opts copy_opts;
 	int rc = 0;
 
 	init_dev(&dev);
@@ -2060,6 +2184,12 @@ lvol_decouple_parent(void)
 	g_inflate_rc = 0;
 	spdk_lvol_decouple_parent(g_lvol, lvol_op_complete, NULL);
 	CU_ASSERT(g_lvolerrno == 0);
+	CU_ASSERT(g_copy_opts == NULL);
+
+	spdk_blob_copy_opts_init(&copy_opts);
+	spdk_lvol_decouple_parent_ext(g_lvol, &copy_opts, lvol_op_complete, NULL);
+	CU_ASSERT(g_lvolerrno == 0);
+	CU_ASSERT(g_copy_opts == &copy_opts);
 
 	spdk_lvol_close(g_lvol, close_cb, NULL);
 	CU_ASSERT(g_lvserrno == 0);
@@ -2080,6 +2210,59 @@ lvol_decouple_parent(void)
 	CU_ASSERT(g_io_channel == NULL);
 }
 
+static void
+lvol_shallow_copy(void)
+{
+	struct lvol_ut_bs_dev dev;
+	struct spdk_lvs_opts opts;
+	struct spdk_blob_copy_opts copy_opts;
+	struct spdk_bs_dev ext_dev = {};
+	int rc = 0;
+
+	init_dev(&dev);
+
+	spdk_lvs_opts_init(&opts);
+	snprintf(opts.name, sizeof(opts.name), "lvs");
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&dev.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+
+	spdk_lvol_create(g_lvol_store, "lvol", 10, false, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+
+	g_inflate_rc = -EPERM;
+	spdk_lvol_shallow_copy(g_lvol, &ext_dev, NULL, lvol_op_complete, NULL);
+	CU_ASSERT(g_lvolerrno == -EPERM);
+
+	g_inflate_rc = 0;
+	spdk_blob_copy_opts_init(&copy_opts);
+	copy_opts.mbytes_per_sec = 100;
+	spdk_lvol_shallow_copy(g_lvol, &ext_dev, &copy_opts, lvol_op_complete, NULL);
+	CU_ASSERT(g_lvolerrno == 0);
+	CU_ASSERT(g_copy_opts == &copy_opts);
+	CU_ASSERT(g_copy_ext_dev == &ext_dev);
+
+	spdk_lvol_close(g_lvol, close_cb, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_destroy(g_lvol, destroy_cb, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(g_lvol_store, lvol_store_op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	g_lvol_store = NULL;
+
+	free_dev(&dev);
+
+	CU_ASSERT(g_io_channel == NULL);
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -2121,10 +2304,12 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "lvol_refcnt", lvol_refcnt) == NULL ||
 		CU_add_test(suite, "lvol_names", lvol_names) == NULL ||
 		CU_add_test(suite, "lvol_create_thin_provisioned", lvol_create_thin_provisioned) == NULL ||
+		CU_add_test(suite, "lvol_create_esnap_clone", lvol_create_esnap_clone) == NULL ||
 		CU_add_test(suite, "lvol_rename", lvol_rename) == NULL ||
 		CU_add_test(suite, "lvs_rename", lvs_rename) == NULL ||
 		CU_add_test(suite, "lvol_inflate", lvol_inflate) == NULL ||
-		CU_add_test(suite, "lvol_decouple_parent", lvol_decouple_parent) == NULL
+		CU_add_test(suite, "lvol_decouple_parent", lvol_decouple_parent) == NULL ||
+		CU_add_test(suite, "lvol_shallow_copy", lvol_shallow_copy) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
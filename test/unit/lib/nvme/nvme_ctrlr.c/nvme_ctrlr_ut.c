@@ -67,6 +67,7 @@ DEFINE_STUB(nvme_ctrlr_cmd_set_host_id, int,
 	    (struct spdk_nvme_ctrlr *ctrlr, void *host_id, uint32_t host_id_size,
 	     spdk_nvme_cmd_cb cb_fn, void *cb_arg), 0);
 DEFINE_STUB_V(nvme_ns_set_identify_data, (struct spdk_nvme_ns *ns));
+DEFINE_STUB_V(nvme_ns_set_id_desc_list_data, (struct spdk_nvme_ns *ns));
 
 struct spdk_nvme_ctrlr *nvme_transport_ctrlr_construct(const struct spdk_nvme_transport_id *trid,
 		const struct spdk_nvme_ctrlr_opts *opts,
@@ -240,11 +241,21 @@ spdk_nvme_ctrlr_cmd_get_feature(struct spdk_nvme_ctrlr *ctrlr, uint8_t feature,
 	return -1;
 }
 
+static bool g_hold_log_page;
+static spdk_nvme_cmd_cb g_log_page_cb_fn;
+static void *g_log_page_cb_arg;
+
 int
 spdk_nvme_ctrlr_cmd_get_log_page(struct spdk_nvme_ctrlr *ctrlr, uint8_t log_page,
 				 uint32_t nsid, void *payload, uint32_t payload_size,
 				 uint64_t offset, spdk_nvme_cmd_cb cb_fn, void *cb_arg)
 {
+	if (g_hold_log_page) {
+		g_log_page_cb_fn = cb_fn;
+		g_log_page_cb_arg = cb_arg;
+		return 0;
+	}
+
 	fake_cpl_success(cb_fn, cb_arg);
 	return 0;
 }
@@ -330,11 +341,21 @@ nvme_ctrlr_cmd_set_async_event_config(struct spdk_nvme_ctrlr *ctrlr,
 	return 0;
 }
 
+static bool g_fail_active_ns_list;
+
 int
 nvme_ctrlr_cmd_identify(struct spdk_nvme_ctrlr *ctrlr, uint8_t cns, uint16_t cntid, uint32_t nsid,
-			void *payload, size_t payload_size,
+			uint8_t csi, void *payload, size_t payload_size,
 			spdk_nvme_cmd_cb cb_fn, void *cb_arg)
 {
+	if (cns == SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST && g_fail_active_ns_list) {
+		struct spdk_nvme_cpl cpl = {};
+
+		cpl.status.sc = SPDK_NVME_SC_INVALID_FIELD;
+		cb_fn(cb_arg, &cpl);
+		return 0;
+	}
+
 	if (cns == SPDK_NVME_IDENTIFY_ACTIVE_NS_LIST) {
 		uint32_t count = 0;
 		uint32_t i = 0;
@@ -512,6 +533,8 @@ test_nvme_ctrlr_init_en_1_rdy_0(void)
 	g_ut_nvme_regs.csts.bits.rdy = 0;
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 
 	/*
 	 * Transition to CC.EN = 1
@@ -566,6 +589,8 @@ test_nvme_ctrlr_init_en_1_rdy_1(void)
 	g_ut_nvme_regs.csts.bits.rdy = 0;
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 
 	/*
 	 * Transition to CC.EN = 1
@@ -625,6 +650,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_rr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 1);
@@ -656,6 +683,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_rr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) != 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 0);
@@ -685,6 +714,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_rr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) != 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 0);
@@ -714,6 +745,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_rr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) != 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 0);
@@ -743,6 +776,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_rr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 1);
@@ -800,6 +835,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_wrr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 1);
@@ -831,6 +868,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_wrr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 1);
@@ -862,6 +901,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_wrr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) != 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 0);
@@ -891,6 +932,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_wrr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) != 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 0);
@@ -920,6 +963,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_wrr(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 1);
@@ -976,6 +1021,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_vs(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 1);
@@ -1007,6 +1054,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_vs(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) != 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 0);
@@ -1036,6 +1085,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_vs(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 1);
@@ -1067,6 +1118,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_vs(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) != 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 0);
@@ -1096,6 +1149,8 @@ test_nvme_ctrlr_init_en_0_rdy_0_ams_vs(void)
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
 	CU_ASSERT(g_ut_nvme_regs.cc.bits.en == 1);
@@ -1143,6 +1198,8 @@ test_nvme_ctrlr_init_en_0_rdy_0(void)
 
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
@@ -1192,6 +1249,8 @@ test_nvme_ctrlr_init_en_0_rdy_1(void)
 	g_ut_nvme_regs.csts.bits.rdy = 0;
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 
 	/*
 	 * Transition to CC.EN = 1
@@ -1694,10 +1753,21 @@ test_spdk_nvme_ctrlr_update_firmware(void)
 	set_status_cpl = 0;
 }
 
+static bool g_doorbell_buffer_config_fail = false;
+
 int
 nvme_ctrlr_cmd_doorbell_buffer_config(struct spdk_nvme_ctrlr *ctrlr, uint64_t prp1, uint64_t prp2,
 				      spdk_nvme_cmd_cb cb_fn, void *cb_arg)
 {
+	struct spdk_nvme_cpl cpl = {};
+
+	if (g_doorbell_buffer_config_fail) {
+		cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		cpl.status.sc = SPDK_NVME_SC_INVALID_FIELD;
+		cb_fn(cb_arg, &cpl);
+		return 0;
+	}
+
 	fake_cpl_success(cb_fn, cb_arg);
 	return 0;
 }
@@ -1715,7 +1785,157 @@ test_spdk_nvme_ctrlr_doorbell_buffer_config(void)
 	MOCK_CLEAR(spdk_zmalloc);
 	ret = nvme_ctrlr_set_doorbell_buffer_config(&ctrlr);
 	CU_ASSERT(ret == 0);
+	CU_ASSERT(ctrlr.shadow_doorbell != NULL);
+	CU_ASSERT(ctrlr.eventidx != NULL);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_KEEP_ALIVE_TIMEOUT);
 	nvme_ctrlr_free_doorbell_buffer(&ctrlr);
+
+	/* Controller rejects the command, I/O queues must keep using MMIO doorbells */
+	g_doorbell_buffer_config_fail = true;
+	ret = nvme_ctrlr_set_doorbell_buffer_config(&ctrlr);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(ctrlr.shadow_doorbell == NULL);
+	CU_ASSERT(ctrlr.eventidx == NULL);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_KEEP_ALIVE_TIMEOUT);
+	g_doorbell_buffer_config_fail = false;
+}
+
+static void
+test_nvme_ctrlr_init_stats(void)
+{
+	struct spdk_nvme_ctrlr_init_stats stats;
+	DECLARE_AND_CONSTRUCT_CTRLR();
+
+	memset(&g_ut_nvme_regs, 0, sizeof(g_ut_nvme_regs));
+
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr_construct(&ctrlr) == 0);
+	ctrlr.cdata.nn = 1;
+	ctrlr.page_size = 0x1000;
+	ctrlr.state = NVME_CTRLR_STATE_INIT;
+
+	/* Nothing has been accounted before the state machine is polled */
+	spdk_nvme_ctrlr_get_init_stats(&ctrlr, &stats);
+	CU_ASSERT(stats.total_us == 0);
+
+	/* 10us spent constructing the controller */
+	spdk_delay_us(10);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
+
+	/* 20us waiting for CSTS.RDY = 0, 100us delay before setting CC.EN = 1 */
+	spdk_delay_us(20);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	spdk_delay_us(100);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
+
+	g_ut_nvme_regs.csts.bits.rdy = 1;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_ADMIN_QUEUE);
+
+	while (ctrlr.state != NVME_CTRLR_STATE_READY) {
+		nvme_ctrlr_process_init(&ctrlr);
+	}
+
+	spdk_nvme_ctrlr_get_init_stats(&ctrlr, &stats);
+	CU_ASSERT(stats.construct_us == 10);
+	CU_ASSERT(stats.enable_us == 120);
+	CU_ASSERT(stats.identify_us == 0);
+	CU_ASSERT(stats.namespaces_us == 0);
+	CU_ASSERT(stats.configure_us == 0);
+	CU_ASSERT(stats.total_us == 130);
+
+	/* A reset starts new timings, but keeps the construction time */
+	ctrlr.state = NVME_CTRLR_STATE_READY;
+	g_ut_nvme_regs.cc.bits.en = 0;
+	g_ut_nvme_regs.csts.bits.rdy = 0;
+	nvme_ctrlr_set_state(&ctrlr, NVME_CTRLR_STATE_INIT, NVME_TIMEOUT_INFINITE);
+	spdk_delay_us(5);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_DISABLE_WAIT_FOR_READY_0);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	spdk_delay_us(100);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	g_ut_nvme_regs.csts.bits.rdy = 1;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_ADMIN_QUEUE);
+
+	spdk_nvme_ctrlr_get_init_stats(&ctrlr, &stats);
+	CU_ASSERT(stats.construct_us == 10);
+	CU_ASSERT(stats.enable_us == 105);
+	CU_ASSERT(stats.identify_us == 0);
+
+	g_ut_nvme_regs.csts.bits.shst = SPDK_NVME_SHST_COMPLETE;
+	nvme_ctrlr_destruct(&ctrlr);
+}
+
+static void
+test_nvme_ctrlr_init_active_ns_error(void)
+{
+	DECLARE_AND_CONSTRUCT_CTRLR();
+
+	memset(&g_ut_nvme_regs, 0, sizeof(g_ut_nvme_regs));
+
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr_construct(&ctrlr) == 0);
+	ctrlr.vs.raw = SPDK_NVME_VERSION(1, 2, 0);
+	ctrlr.cdata.nn = 4;
+	ctrlr.page_size = 0x1000;
+	ctrlr.opts.admin_timeout_ms = 1000;
+
+	nvme_ctrlr_set_state(&ctrlr, NVME_CTRLR_STATE_CONSTRUCT_NS, NVME_TIMEOUT_INFINITE);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_ACTIVE_NS);
+	CU_ASSERT(ctrlr.num_ns == 4);
+
+	/* Without an Active Namespace List, the controller fails to initialize */
+	g_fail_active_ns_list = true;
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ERROR);
+	CU_ASSERT(ctrlr.num_ns == 0);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) != 0);
+	g_fail_active_ns_list = false;
+
+	g_ut_nvme_regs.csts.bits.shst = SPDK_NVME_SHST_COMPLETE;
+	nvme_ctrlr_destruct(&ctrlr);
+}
+
+static void
+test_nvme_ctrlr_init_log_page_dir_timeout(void)
+{
+	DECLARE_AND_CONSTRUCT_CTRLR();
+
+	memset(&g_ut_nvme_regs, 0, sizeof(g_ut_nvme_regs));
+
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr_construct(&ctrlr) == 0);
+	ctrlr.cdata.vid = SPDK_PCI_VID_INTEL;
+	ctrlr.opts.admin_timeout_ms = 1000;
+
+	g_hold_log_page = true;
+	nvme_ctrlr_set_state(&ctrlr, NVME_CTRLR_STATE_SET_SUPPORTED_LOG_PAGES,
+			     NVME_TIMEOUT_INFINITE);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_WAIT_FOR_SUPPORTED_LOG_PAGES);
+	SPDK_CU_ASSERT_FATAL(g_log_page_cb_fn != NULL);
+
+	/* The Intel log page directory is optional, initialization goes on without it */
+	spdk_delay_us(1000 * 1000 + 1);
+	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES);
+	CU_ASSERT(ctrlr.log_page_supported[SPDK_NVME_INTEL_LOG_PAGE_DIRECTORY] == false);
+
+	/* A late completion doesn't take the controller back */
+	fake_cpl_success(g_log_page_cb_fn, g_log_page_cb_arg);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_SET_SUPPORTED_FEATURES);
+	CU_ASSERT(ctrlr.log_page_supported[SPDK_NVME_INTEL_LOG_PAGE_DIRECTORY] == false);
+
+	g_hold_log_page = false;
+	g_log_page_cb_fn = NULL;
+	g_log_page_cb_arg = NULL;
+
+	g_ut_nvme_regs.csts.bits.shst = SPDK_NVME_SHST_COMPLETE;
+	nvme_ctrlr_destruct(&ctrlr);
 }
 
 static void
@@ -1819,6 +2039,8 @@ test_nvme_ctrlr_init_delay(void)
 
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE);
+	/* Wait for the delay before setting CC.EN = 1 */
+	spdk_delay_us(100);
 
 	CU_ASSERT(nvme_ctrlr_process_init(&ctrlr) == 0);
 	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ENABLE_WAIT_FOR_READY_1);
@@ -1874,6 +2096,12 @@ int main(int argc, char **argv)
 			       test_nvme_ctrlr_init_en_0_rdy_0_ams_vs) == NULL
 		|| CU_add_test(suite, "test_nvme_ctrlr_init_delay",
 			       test_nvme_ctrlr_init_delay) == NULL
+		|| CU_add_test(suite, "test_nvme_ctrlr_init_stats",
+			       test_nvme_ctrlr_init_stats) == NULL
+		|| CU_add_test(suite, "test_nvme_ctrlr_init_active_ns_error",
+			       test_nvme_ctrlr_init_active_ns_error) == NULL
+		|| CU_add_test(suite, "test_nvme_ctrlr_init_log_page_dir_timeout",
+			       test_nvme_ctrlr_init_log_page_dir_timeout) == NULL
 		|| CU_add_test(suite, "alloc_io_qpair_rr 1", test_alloc_io_qpair_rr_1) == NULL
 		|| CU_add_test(suite, "get_default_ctrlr_opts", test_ctrlr_get_default_ctrlr_opts) == NULL
 		|| CU_add_test(suite, "get_default_io_qpair_opts", test_ctrlr_get_default_io_qpair_opts) == NULL
@@ -297,6 +297,27 @@ nvme_ctrlr_submit_admin_request(struct spdk_nvme_ctrlr *ctrlr, struct nvme_reque
 	return 0;
 }
 
+static struct nvme_request *g_outstanding_reqs[4];
+static uint32_t g_num_outstanding_reqs;
+
+int
+nvme_transport_qpair_iterate_requests(struct spdk_nvme_qpair *qpair,
+				      int (*iter_fn)(struct nvme_request *req, void *arg),
+				      void *arg)
+{
+	uint32_t i;
+	int rc;
+
+	for (i = 0; i < g_num_outstanding_reqs; i++) {
+		rc = iter_fn(g_outstanding_reqs[i], arg);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
 #define DECLARE_AND_CONSTRUCT_CTRLR()	\
 	struct spdk_nvme_ctrlr	ctrlr = {};	\
 	struct spdk_nvme_qpair	adminq = {};	\
@@ -493,6 +514,224 @@ test_abort_cmd(void)
 	spdk_nvme_ctrlr_cmd_abort(&ctrlr, &qpair, abort_cid, NULL, NULL);
 }
 
+static struct nvme_request g_abort_reqs[4];
+static uint32_t g_num_abort_reqs;
+
+static void
+verify_abort_ext_cmd(struct nvme_request *req)
+{
+	SPDK_CU_ASSERT_FATAL(g_num_abort_reqs < SPDK_COUNTOF(g_abort_reqs));
+	CU_ASSERT(req->cmd.opc == SPDK_NVME_OPC_ABORT);
+	CU_ASSERT((req->cmd.cdw10 & 0xFFFF) == abort_sqid);
+	g_abort_reqs[g_num_abort_reqs++] = *req;
+}
+
+static struct spdk_nvme_cpl g_abort_ext_cpl;
+static uint32_t g_abort_ext_done;
+
+static void
+abort_ext_done(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	g_abort_ext_cpl = *cpl;
+	g_abort_ext_done++;
+}
+
+static pthread_mutex_t *g_abort_ctrlr_lock;
+static bool g_abort_ctrlr_lock_held;
+
+static void *
+try_ctrlr_lock(void *arg)
+{
+	if (pthread_mutex_trylock(g_abort_ctrlr_lock) != 0) {
+		g_abort_ctrlr_lock_held = true;
+	} else {
+		pthread_mutex_unlock(g_abort_ctrlr_lock);
+	}
+	return NULL;
+}
+
+static void
+queued_req_done(void *cb_arg, const struct spdk_nvme_cpl *cpl)
+{
+	pthread_t thread;
+
+	*(struct spdk_nvme_cpl *)cb_arg = *cpl;
+
+	/* The lock is recursive, so check from another thread whether it is still held. */
+	if (g_abort_ctrlr_lock != NULL &&
+	    pthread_create(&thread, NULL, try_ctrlr_lock, NULL) == 0) {
+		pthread_join(thread, NULL);
+	}
+}
+
+static void
+test_abort_ext_cmd(void)
+{
+	struct spdk_nvme_ctrlr	ctrlr = {};
+	struct spdk_nvme_qpair	adminq = {};
+	struct spdk_nvme_qpair	qpair = {};
+	struct nvme_request	admin_reqs[2] = {};
+	struct nvme_request	reqs[4] = {};
+	struct spdk_nvme_cpl	cpl = {}, queued_cpl = {};
+	int			cmd_cb_arg, other_cb_arg;
+	uint32_t		i;
+	pthread_mutexattr_t	attr;
+
+	/* The controller lock is recursive, spdk_nvme_ctrlr_cmd_abort() takes it again. */
+	SPDK_CU_ASSERT_FATAL(pthread_mutexattr_init(&attr) == 0);
+	SPDK_CU_ASSERT_FATAL(pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) == 0);
+	SPDK_CU_ASSERT_FATAL(pthread_mutex_init(&ctrlr.ctrlr_lock, &attr) == 0);
+	pthread_mutexattr_destroy(&attr);
+
+	STAILQ_INIT(&adminq.free_req);
+	for (i = 0; i < SPDK_COUNTOF(admin_reqs); i++) {
+		STAILQ_INSERT_HEAD(&adminq.free_req, &admin_reqs[i], stailq);
+	}
+	ctrlr.adminq = &adminq;
+	ctrlr.cdata.acl = 3;
+	STAILQ_INIT(&ctrlr.queued_aborts);
+	qpair.id = abort_sqid;
+	STAILQ_INIT(&qpair.free_req);
+	STAILQ_INIT(&qpair.queued_req);
+	TAILQ_INIT(&qpair.err_cmd_head);
+
+	verify_fn = verify_abort_ext_cmd;
+	g_num_abort_reqs = 0;
+	g_abort_ext_done = 0;
+
+	/* reqs[0] matches, reqs[1] does not, reqs[2] is a child of the matching reqs[3] */
+	reqs[0].cb_arg = &cmd_cb_arg;
+	reqs[0].cmd.cid = 1;
+	reqs[1].cb_arg = &other_cb_arg;
+	reqs[1].cmd.cid = 2;
+	reqs[3].cb_arg = &cmd_cb_arg;
+	reqs[2].cb_arg = &reqs[2];
+	reqs[2].parent = &reqs[3];
+	reqs[2].cmd.cid = 3;
+	g_outstanding_reqs[0] = &reqs[0];
+	g_outstanding_reqs[1] = &reqs[1];
+	g_outstanding_reqs[2] = &reqs[2];
+	g_num_outstanding_reqs = 3;
+
+	CU_ASSERT(spdk_nvme_ctrlr_cmd_abort_ext(&ctrlr, &qpair, NULL, abort_ext_done, NULL) == -EINVAL);
+	CU_ASSERT(spdk_nvme_ctrlr_cmd_abort_ext(&ctrlr, &qpair, &ctrlr, abort_ext_done, NULL) == -ENOENT);
+	CU_ASSERT(g_num_abort_reqs == 0);
+
+	CU_ASSERT(spdk_nvme_ctrlr_cmd_abort_ext(&ctrlr, &qpair, &cmd_cb_arg, abort_ext_done, NULL) == 0);
+	CU_ASSERT(g_num_abort_reqs == 2);
+	CU_ASSERT((g_abort_reqs[0].cmd.cdw10 >> 16) == 1);
+	CU_ASSERT((g_abort_reqs[1].cmd.cdw10 >> 16) == 3);
+	CU_ASSERT(g_abort_ext_done == 0);
+
+	/* The callback fires once both aborts completed, reporting the one that missed. */
+	g_abort_reqs[0].user_cb_fn(g_abort_reqs[0].user_cb_arg, &cpl);
+	CU_ASSERT(g_abort_ext_done == 0);
+	cpl.cdw0 = 1;
+	g_abort_reqs[1].user_cb_fn(g_abort_reqs[1].user_cb_arg, &cpl);
+	CU_ASSERT(g_abort_ext_done == 1);
+	CU_ASSERT(!spdk_nvme_cpl_is_error(&g_abort_ext_cpl));
+	CU_ASSERT(g_abort_ext_cpl.cdw0 == 1);
+
+	/* Requests that were not submitted yet are completed immediately. */
+	g_num_outstanding_reqs = 0;
+	g_num_abort_reqs = 0;
+	reqs[3].qpair = &qpair;
+	reqs[3].cb_fn = queued_req_done;
+	reqs[3].cb_arg = &queued_cpl;
+	STAILQ_INSERT_TAIL(&qpair.queued_req, &reqs[1], stailq);
+	STAILQ_INSERT_TAIL(&qpair.queued_req, &reqs[3], stailq);
+	g_abort_ctrlr_lock = &ctrlr.ctrlr_lock;
+	g_abort_ctrlr_lock_held = false;
+
+	CU_ASSERT(spdk_nvme_ctrlr_cmd_abort_ext(&ctrlr, &qpair, &queued_cpl, abort_ext_done, NULL) == 0);
+	/* Queued requests are completed once the controller lock is released. */
+	CU_ASSERT(g_abort_ctrlr_lock_held == false);
+	g_abort_ctrlr_lock = NULL;
+	CU_ASSERT(g_num_abort_reqs == 0);
+	CU_ASSERT(g_abort_ext_done == 2);
+	CU_ASSERT(queued_cpl.status.sc == SPDK_NVME_SC_ABORTED_BY_REQUEST);
+	CU_ASSERT(STAILQ_FIRST(&qpair.queued_req) == &reqs[1]);
+	CU_ASSERT(STAILQ_NEXT(&reqs[1], stailq) == NULL);
+	CU_ASSERT(STAILQ_FIRST(&qpair.free_req) == &reqs[3]);
+
+	pthread_mutex_destroy(&ctrlr.ctrlr_lock);
+}
+
+static void
+test_abort_ext_cmd_queued_children(void)
+{
+	struct spdk_nvme_ctrlr	ctrlr = {};
+	struct spdk_nvme_qpair	adminq = {};
+	struct spdk_nvme_qpair	qpair = {};
+	struct nvme_request	admin_reqs[2] = {};
+	struct nvme_request	parent = {}, other = {};
+	struct nvme_request	children[3] = {};
+	struct spdk_nvme_cpl	cpl = {}, parent_cpl = {};
+	uint32_t		i;
+	pthread_mutexattr_t	attr;
+
+	SPDK_CU_ASSERT_FATAL(pthread_mutexattr_init(&attr) == 0);
+	SPDK_CU_ASSERT_FATAL(pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) == 0);
+	SPDK_CU_ASSERT_FATAL(pthread_mutex_init(&ctrlr.ctrlr_lock, &attr) == 0);
+	pthread_mutexattr_destroy(&attr);
+
+	STAILQ_INIT(&adminq.free_req);
+	for (i = 0; i < SPDK_COUNTOF(admin_reqs); i++) {
+		STAILQ_INSERT_HEAD(&adminq.free_req, &admin_reqs[i], stailq);
+	}
+	ctrlr.adminq = &adminq;
+	ctrlr.cdata.acl = 3;
+	STAILQ_INIT(&ctrlr.queued_aborts);
+	qpair.id = abort_sqid;
+	STAILQ_INIT(&qpair.free_req);
+	STAILQ_INIT(&qpair.queued_req);
+	TAILQ_INIT(&qpair.err_cmd_head);
+
+	verify_fn = verify_abort_ext_cmd;
+	g_num_abort_reqs = 0;
+	g_abort_ext_done = 0;
+
+	/* A split request whose first child was submitted while the other two are still queued */
+	parent.qpair = &qpair;
+	parent.cb_fn = queued_req_done;
+	parent.cb_arg = &parent_cpl;
+	for (i = 0; i < SPDK_COUNTOF(children); i++) {
+		children[i].qpair = &qpair;
+		nvme_request_add_child(&parent, &children[i]);
+	}
+	children[0].cmd.cid = 1;
+	g_outstanding_reqs[0] = &children[0];
+	g_num_outstanding_reqs = 1;
+	other.cb_arg = &cpl;
+	STAILQ_INSERT_TAIL(&qpair.queued_req, &children[1], stailq);
+	STAILQ_INSERT_TAIL(&qpair.queued_req, &other, stailq);
+	STAILQ_INSERT_TAIL(&qpair.queued_req, &children[2], stailq);
+
+	/* The queued children are completed, the submitted one gets an abort command. */
+	CU_ASSERT(spdk_nvme_ctrlr_cmd_abort_ext(&ctrlr, &qpair, &parent_cpl,
+					       abort_ext_done, NULL) == 0);
+	CU_ASSERT(g_num_abort_reqs == 1);
+	CU_ASSERT((g_abort_reqs[0].cmd.cdw10 >> 16) == 1);
+	CU_ASSERT(parent.num_children == 1);
+	CU_ASSERT(TAILQ_FIRST(&parent.children) == &children[0]);
+	CU_ASSERT(STAILQ_FIRST(&qpair.queued_req) == &other);
+	CU_ASSERT(STAILQ_NEXT(&other, stailq) == NULL);
+	CU_ASSERT(g_abort_ext_done == 0);
+
+	g_abort_reqs[0].user_cb_fn(g_abort_reqs[0].user_cb_arg, &cpl);
+	CU_ASSERT(g_abort_ext_done == 1);
+	CU_ASSERT(!spdk_nvme_cpl_is_error(&g_abort_ext_cpl));
+
+	/* The parent completes with the aborted status once the last child does. */
+	cpl.status.sc = SPDK_NVME_SC_ABORTED_BY_REQUEST;
+	g_num_outstanding_reqs = 0;
+	nvme_complete_request(children[0].cb_fn, children[0].cb_arg, &qpair, &children[0], &cpl);
+	CU_ASSERT(parent.num_children == 0);
+	CU_ASSERT(parent_cpl.status.sc == SPDK_NVME_SC_ABORTED_BY_REQUEST);
+
+	pthread_mutex_destroy(&ctrlr.ctrlr_lock);
+}
+
 static void
 test_io_raw_cmd(void)
 {
@@ -623,6 +862,9 @@ int main(int argc, char **argv)
 		|| CU_add_test(suite, "test ctrlr cmd get_feature", test_get_feature_cmd) == NULL
 		|| CU_add_test(suite, "test ctrlr cmd get_feature_ns", test_get_feature_ns_cmd) == NULL
 		|| CU_add_test(suite, "test ctrlr cmd abort_cmd", test_abort_cmd) == NULL
+		|| CU_add_test(suite, "test ctrlr cmd abort_ext_cmd", test_abort_ext_cmd) == NULL
+		|| CU_add_test(suite, "test ctrlr cmd abort_ext_cmd_queued_children",
+			       test_abort_ext_cmd_queued_children) == NULL
 		|| CU_add_test(suite, "test ctrlr cmd io_raw_cmd", test_io_raw_cmd) == NULL
 		|| CU_add_test(suite, "test ctrlr cmd io_raw_cmd_with_md", test_io_raw_cmd_with_md) == NULL
 		|| CU_add_test(suite, "test ctrlr cmd namespace_attach", test_namespace_attach) == NULL
@@ -275,12 +275,22 @@ nvme_qpair_enable(struct spdk_nvme_qpair *qpair)
 	abort();
 }
 
-int
-nvme_request_check_timeout(struct nvme_request *req, uint16_t cid,
-			   struct spdk_nvme_ctrlr_process *active_proc,
-			   uint64_t now_tick)
+struct spdk_nvme_ctrlr_process *
+spdk_nvme_ctrlr_get_current_process(struct spdk_nvme_ctrlr *ctrlr)
 {
-	abort();
+	return NULL;
+}
+
+static uint16_t g_timed_out_cids[8];
+static uint32_t g_num_timed_out;
+
+void
+nvme_request_timeout(struct nvme_request *req, uint16_t cid,
+		     struct spdk_nvme_ctrlr_process *active_proc)
+{
+	SPDK_CU_ASSERT_FATAL(g_num_timed_out < SPDK_COUNTOF(g_timed_out_cids));
+	req->timed_out = true;
+	g_timed_out_cids[g_num_timed_out++] = cid;
 }
 
 struct spdk_nvme_ctrlr *
@@ -809,6 +819,186 @@ static void test_shadow_doorbell_update(void)
 
 	ret = nvme_pcie_qpair_need_event(14, 15, 14);
 	CU_ASSERT(ret == true);
+
+	/* EventIdx equal to the new value has not been passed yet */
+	ret = nvme_pcie_qpair_need_event(15, 15, 14);
+	CU_ASSERT(ret == false);
+
+	/* Doorbell wraps around */
+	ret = nvme_pcie_qpair_need_event(0xFFFF, 2, 0xFFFE);
+	CU_ASSERT(ret == true);
+	ret = nvme_pcie_qpair_need_event(2, 2, 0xFFFE);
+	CU_ASSERT(ret == false);
+}
+
+static void
+test_shadow_doorbell_mmio_required(void)
+{
+	struct spdk_nvme_qpair qpair = {};
+	uint32_t shadow_db = 0, eventidx = 0;
+
+	/* No shadow doorbell, always ring the MMIO doorbell */
+	CU_ASSERT(nvme_pcie_qpair_update_mmio_required(&qpair, 5, NULL, NULL) == true);
+
+	/* Controller asked to be notified when entry 0 is submitted */
+	CU_ASSERT(nvme_pcie_qpair_update_mmio_required(&qpair, 4, &shadow_db, &eventidx) == true);
+	CU_ASSERT(shadow_db == 4);
+
+	/* Controller is polling and has not moved EventIdx, only the shadow is updated */
+	CU_ASSERT(nvme_pcie_qpair_update_mmio_required(&qpair, 8, &shadow_db, &eventidx) == false);
+	CU_ASSERT(shadow_db == 8);
+
+	/* Controller went idle after consuming entry 9 */
+	eventidx = 9;
+	CU_ASSERT(nvme_pcie_qpair_update_mmio_required(&qpair, 9, &shadow_db, &eventidx) == false);
+	CU_ASSERT(nvme_pcie_qpair_update_mmio_required(&qpair, 10, &shadow_db, &eventidx) == true);
+	CU_ASSERT(shadow_db == 10);
+}
+
+static void
+test_cmb_io_buffer(void)
+{
+	struct nvme_pcie_ctrlr pctrlr = {};
+	uint8_t bar[0x10000];
+	void *buf1, *buf2, *buf3;
+	uint64_t offset, offset2;
+
+	pctrlr.ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pctrlr.cmb_bar_virt_addr = bar;
+	pctrlr.cmb_current_offset = 0x800;
+	pctrlr.cmb_max_offset = 0x8000;
+	pctrlr.cmb_io_data_supported = true;
+
+	/* The allocatable range starts at the next CMB page */
+	CU_ASSERT(nvme_pcie_ctrlr_init_cmb_page_map(&pctrlr) == 0);
+	CU_ASSERT(pctrlr.cmb_current_offset == 0x1000);
+	CU_ASSERT(spdk_bit_array_capacity(pctrlr.cmb_page_map) == 7);
+
+	buf1 = nvme_pcie_ctrlr_alloc_cmb_io_buffer(&pctrlr.ctrlr, 0x1000);
+	CU_ASSERT(buf1 == bar + 0x1000);
+	buf2 = nvme_pcie_ctrlr_alloc_cmb_io_buffer(&pctrlr.ctrlr, 0x1800);
+	CU_ASSERT(buf2 == bar + 0x2000);
+	CU_ASSERT(pctrlr.cmb_first_free_page == 3);
+
+	/* Only four pages are left */
+	CU_ASSERT(nvme_pcie_ctrlr_alloc_cmb_io_buffer(&pctrlr.ctrlr, 0x5000) == NULL);
+
+	/* Freed space is reused */
+	CU_ASSERT(nvme_pcie_ctrlr_free_cmb_io_buffer(&pctrlr.ctrlr, buf1, 0x1000) == 0);
+	CU_ASSERT(pctrlr.cmb_first_free_page == 0);
+	buf3 = nvme_pcie_ctrlr_alloc_cmb_io_buffer(&pctrlr.ctrlr, 0x200);
+	CU_ASSERT(buf3 == buf1);
+	CU_ASSERT(pctrlr.cmb_first_free_page == 1);
+
+	/* Aligned allocations skip pages that do not satisfy the alignment */
+	CU_ASSERT(nvme_pcie_ctrlr_alloc_cmb(&pctrlr.ctrlr, 0x1000, 0x4000, &offset) == 0);
+	CU_ASSERT(offset == 0x4000);
+
+	/* A run of free pages too short for the request is skipped */
+	CU_ASSERT(nvme_pcie_ctrlr_free_cmb_io_buffer(&pctrlr.ctrlr, buf2, 0x1800) == 0);
+	CU_ASSERT(nvme_pcie_ctrlr_alloc_cmb(&pctrlr.ctrlr, 0x3000, 0, &offset2) == 0);
+	CU_ASSERT(offset2 == 0x5000);
+	CU_ASSERT(pctrlr.cmb_first_free_page == 1);
+	buf2 = nvme_pcie_ctrlr_alloc_cmb_io_buffer(&pctrlr.ctrlr, 0x1800);
+	CU_ASSERT(buf2 == bar + 0x2000);
+	CU_ASSERT(pctrlr.cmb_first_free_page == 3);
+	CU_ASSERT(nvme_pcie_ctrlr_alloc_cmb_io_buffer(&pctrlr.ctrlr, 0x1000) == NULL);
+	nvme_pcie_ctrlr_free_cmb(&pctrlr.ctrlr, offset2, 0x3000);
+
+	/* Buffers outside of the CMB are rejected */
+	CU_ASSERT(nvme_pcie_ctrlr_free_cmb_io_buffer(&pctrlr.ctrlr, bar + 0x9000, 0x1000) == -EINVAL);
+
+	CU_ASSERT(nvme_pcie_ctrlr_free_cmb_io_buffer(&pctrlr.ctrlr, buf2, 0x1800) == 0);
+	CU_ASSERT(nvme_pcie_ctrlr_free_cmb_io_buffer(&pctrlr.ctrlr, buf3, 0x200) == 0);
+	nvme_pcie_ctrlr_free_cmb(&pctrlr.ctrlr, offset, 0x1000);
+	CU_ASSERT(spdk_bit_array_count_set(pctrlr.cmb_page_map) == 0);
+
+	spdk_bit_array_free(&pctrlr.cmb_page_map);
+}
+
+static void
+ut_timeout_cb(void *cb_arg, struct spdk_nvme_ctrlr *ctrlr,
+	      struct spdk_nvme_qpair *qpair, uint16_t cid)
+{
+}
+
+static void
+test_timeout_tracking(void)
+{
+	struct nvme_pcie_qpair pqpair = {};
+	struct spdk_nvme_ctrlr ctrlr = {};
+	struct spdk_nvme_ctrlr_process proc = {};
+	struct nvme_tracker *tr;
+	struct nvme_request req[4] = {};
+	uint64_t submit_ticks[4] = { 10, 20, 15, 0 };
+	int i;
+
+	tr = calloc(4, sizeof(*tr));
+	SPDK_CU_ASSERT_FATAL(tr != NULL);
+
+	ctrlr.state = NVME_CTRLR_STATE_READY;
+	proc.timeout_cb_fn = ut_timeout_cb;
+	proc.timeout_ticks = 100;
+	pqpair.qpair.id = 1;
+	pqpair.qpair.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pqpair.qpair.ctrlr = &ctrlr;
+	pqpair.qpair.active_proc = &proc;
+	TAILQ_INIT(&pqpair.outstanding_tr);
+	TAILQ_INIT(&pqpair.untimed_tr);
+	g_num_timed_out = 0;
+
+	/*
+	 * Request 2 waited for a free tracker and is submitted after request 1, but
+	 * its deadline is earlier. Request 3 was submitted with timeouts disabled.
+	 */
+	for (i = 0; i < 4; i++) {
+		req[i].qpair = &pqpair.qpair;
+		req[i].pid = g_spdk_nvme_pid;
+		req[i].submit_tick = submit_ticks[i];
+		tr[i].cid = i;
+		tr[i].req = &req[i];
+		nvme_pcie_qpair_track_timeout(&pqpair, &tr[i], &req[i]);
+	}
+
+	CU_ASSERT(TAILQ_FIRST(&pqpair.outstanding_tr) == &tr[0]);
+	CU_ASSERT(TAILQ_NEXT(&tr[0], tq_list) == &tr[2]);
+	CU_ASSERT(TAILQ_NEXT(&tr[2], tq_list) == &tr[1]);
+	CU_ASSERT(TAILQ_NEXT(&tr[1], tq_list) == NULL);
+	CU_ASSERT(TAILQ_FIRST(&pqpair.untimed_tr) == &tr[3]);
+	CU_ASSERT(tr[3].untimed == 1);
+
+	/* Nothing expired yet */
+	MOCK_SET(spdk_get_ticks, 109);
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(g_num_timed_out == 0);
+
+	/* Requests 0 and 2 expired, in deadline order */
+	MOCK_SET(spdk_get_ticks, 116);
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(g_num_timed_out == 2);
+	CU_ASSERT(g_timed_out_cids[0] == 0);
+	CU_ASSERT(g_timed_out_cids[1] == 2);
+	CU_ASSERT(TAILQ_FIRST(&pqpair.outstanding_tr) == &tr[1]);
+	CU_ASSERT(tr[0].untimed == 1);
+	CU_ASSERT(tr[2].untimed == 1);
+
+	/* Timed out requests are not reported again */
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(g_num_timed_out == 2);
+
+	MOCK_SET(spdk_get_ticks, 200);
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(g_num_timed_out == 3);
+	CU_ASSERT(g_timed_out_cids[2] == 1);
+	CU_ASSERT(TAILQ_EMPTY(&pqpair.outstanding_tr));
+
+	/* The untimed request is never checked */
+	MOCK_SET(spdk_get_ticks, 1000);
+	nvme_pcie_qpair_check_timeout(&pqpair.qpair);
+	CU_ASSERT(g_num_timed_out == 3);
+
+	MOCK_CLEAR(spdk_get_ticks);
+	free(tr);
 }
 
 int main(int argc, char **argv)
@@ -828,7 +1018,11 @@ int main(int argc, char **argv)
 
 	if (CU_add_test(suite, "prp_list_append", test_prp_list_append) == NULL
 	    || CU_add_test(suite, "shadow_doorbell_update",
-			   test_shadow_doorbell_update) == NULL) {
+			   test_shadow_doorbell_update) == NULL
+	    || CU_add_test(suite, "shadow_doorbell_mmio_required",
+			   test_shadow_doorbell_mmio_required) == NULL
+	    || CU_add_test(suite, "cmb_io_buffer", test_cmb_io_buffer) == NULL
+	    || CU_add_test(suite, "timeout_tracking", test_timeout_tracking) == NULL) {
 		CU_cleanup_registry();
 		return CU_get_error();
 	}
@@ -457,6 +457,58 @@ test_nvme_tcp_build_iovs_with_md(void)
 	CU_ASSERT(mapped_length == 256 + 512 + SPDK_NVME_TCP_DIGEST_LEN);
 }
 
+static void
+test_nvme_tcp_pdus_calc_data_digest(void)
+{
+	struct nvme_tcp_pdu pdus[3] = {}, *pdu_ptrs[3];
+	uint8_t data[4][1024];
+	uint32_t crc32c[3];
+	uint32_t i, j;
+
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < sizeof(data[i]); j++) {
+			data[i][j] = (uint8_t)(i * 13 + j);
+		}
+	}
+
+	/* A single buffer */
+	pdus[0].data_iov[0].iov_base = data[0];
+	pdus[0].data_iov[0].iov_len = 1024;
+	pdus[0].data_iovcnt = 1;
+	pdus[0].data_len = 1024;
+
+	/* Three buffers with a length which needs padding */
+	pdus[1].data_iov[0].iov_base = data[1];
+	pdus[1].data_iov[0].iov_len = 512;
+	pdus[1].data_iov[1].iov_base = data[2];
+	pdus[1].data_iov[1].iov_len = 1024;
+	pdus[1].data_iov[2].iov_base = data[3];
+	pdus[1].data_iov[2].iov_len = 7;
+	pdus[1].data_iovcnt = 3;
+	pdus[1].data_len = 512 + 1024 + 7;
+
+	/* Two buffers */
+	pdus[2].data_iov[0].iov_base = data[3] + 100;
+	pdus[2].data_iov[0].iov_len = 900;
+	pdus[2].data_iov[1].iov_base = data[0];
+	pdus[2].data_iov[1].iov_len = 1021;
+	pdus[2].data_iovcnt = 2;
+	pdus[2].data_len = 900 + 1021;
+
+	for (i = 0; i < 3; i++) {
+		crc32c[i] = nvme_tcp_pdu_calc_data_digest(&pdus[i]);
+		pdus[i].ddgst_pending = true;
+		pdu_ptrs[i] = &pdus[i];
+	}
+
+	nvme_tcp_pdus_calc_data_digest(pdu_ptrs, 3);
+
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(MATCH_DIGEST_WORD(pdus[i].data_digest, crc32c[i]));
+		CU_ASSERT(pdus[i].ddgst_pending == false);
+	}
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -481,7 +533,9 @@ int main(int argc, char **argv)
 	    CU_add_test(suite, "nvme_tcp_pdu_set_data_buf_with_md",
 			test_nvme_tcp_pdu_set_data_buf_with_md) == NULL ||
 	    CU_add_test(suite, "nvme_tcp_build_iovs_with_md",
-			test_nvme_tcp_build_iovs_with_md) == NULL
+			test_nvme_tcp_build_iovs_with_md) == NULL ||
+	    CU_add_test(suite, "nvme_tcp_pdus_calc_data_digest",
+			test_nvme_tcp_pdus_calc_data_digest) == NULL
 	   ) {
 		CU_cleanup_registry();
 		return CU_get_error();
@@ -0,0 +1,381 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk_cunit.h"
+
+#include "nvme/nvme_zns.c"
+#include "nvme/nvme.c"
+
+#include "common/lib/test_env.c"
+
+#define ZNS_SECTOR_SIZE 0x1000
+
+static struct nvme_driver _g_nvme_driver = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static struct nvme_request *g_request = NULL;
+
+int
+nvme_qpair_submit_request(struct spdk_nvme_qpair *qpair, struct nvme_request *req)
+{
+	g_request = req;
+
+	return 0;
+}
+
+void
+nvme_ctrlr_destruct(struct spdk_nvme_ctrlr *ctrlr)
+{
+}
+
+void
+nvme_ctrlr_proc_get_ref(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return;
+}
+
+int
+nvme_ctrlr_process_init(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return 0;
+}
+
+void
+nvme_ctrlr_proc_put_ref(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return;
+}
+
+void
+spdk_nvme_ctrlr_get_default_ctrlr_opts(struct spdk_nvme_ctrlr_opts *opts, size_t opts_size)
+{
+	memset(opts, 0, sizeof(*opts));
+}
+
+bool
+spdk_nvme_transport_available(enum spdk_nvme_transport_type trtype)
+{
+	return true;
+}
+
+struct spdk_nvme_ctrlr *nvme_transport_ctrlr_construct(const struct spdk_nvme_transport_id *trid,
+		const struct spdk_nvme_ctrlr_opts *opts,
+		void *devhandle)
+{
+	return NULL;
+}
+
+int
+nvme_ctrlr_get_ref_count(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return 0;
+}
+
+int
+nvme_transport_ctrlr_scan(struct spdk_nvme_probe_ctx *probe_ctx,
+			  bool direct_connect)
+{
+	return 0;
+}
+
+static struct spdk_nvme_ns_data g_nsdata;
+
+const struct spdk_nvme_ns_data *
+spdk_nvme_ns_get_data(struct spdk_nvme_ns *ns)
+{
+	return &g_nsdata;
+}
+
+uint32_t
+spdk_nvme_ns_get_sector_size(struct spdk_nvme_ns *ns)
+{
+	return ns->sector_size;
+}
+
+uint64_t
+spdk_nvme_ns_get_num_sectors(struct spdk_nvme_ns *ns)
+{
+	return g_nsdata.nsze;
+}
+
+static void
+prepare_for_test(struct spdk_nvme_ns *ns, struct spdk_nvme_ctrlr *ctrlr,
+		 struct spdk_nvme_qpair *qpair, struct spdk_nvme_zns_ns_data *nsdata_zns,
+		 struct spdk_nvme_zns_ctrlr_data *cdata_zns, uint32_t max_xfer_size)
+{
+	uint32_t num_requests = 32;
+	uint32_t i;
+
+	memset(ctrlr, 0, sizeof(*ctrlr));
+	ctrlr->max_xfer_size = max_xfer_size;
+	ctrlr->min_page_size = 4096;
+	ctrlr->page_size = 4096;
+	ctrlr->cdata_zns = cdata_zns;
+	memset(cdata_zns, 0, sizeof(*cdata_zns));
+
+	memset(ns, 0, sizeof(*ns));
+	ns->ctrlr = ctrlr;
+	ns->id = 1;
+	ns->csi = SPDK_NVME_CSI_ZNS;
+	ns->sector_size = ZNS_SECTOR_SIZE;
+	ns->extended_lba_size = ZNS_SECTOR_SIZE;
+	ns->nsdata_zns = nsdata_zns;
+	memset(nsdata_zns, 0, sizeof(*nsdata_zns));
+
+	memset(&g_nsdata, 0, sizeof(g_nsdata));
+
+	memset(qpair, 0, sizeof(*qpair));
+	qpair->ctrlr = ctrlr;
+	qpair->req_buf = calloc(num_requests, sizeof(struct nvme_request));
+	SPDK_CU_ASSERT_FATAL(qpair->req_buf != NULL);
+
+	for (i = 0; i < num_requests; i++) {
+		struct nvme_request *req = qpair->req_buf + i * sizeof(struct nvme_request);
+
+		req->qpair = qpair;
+		STAILQ_INSERT_HEAD(&qpair->free_req, req, stailq);
+	}
+
+	g_request = NULL;
+}
+
+static void
+cleanup_after_test(struct spdk_nvme_qpair *qpair)
+{
+	free(qpair->req_buf);
+}
+
+static void
+test_nvme_zns_ns_get_info(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_zns_ns_data	nsdata_zns;
+	struct spdk_nvme_zns_ctrlr_data	cdata_zns;
+
+	prepare_for_test(&ns, &ctrlr, &qpair, &nsdata_zns, &cdata_zns, 0x20000);
+
+	g_nsdata.nsze = 1024;
+	g_nsdata.flbas.format = 1;
+	nsdata_zns.lbafe[1].zsze = 128;
+	nsdata_zns.mor = 13;
+	nsdata_zns.mar = UINT32_MAX;
+
+	CU_ASSERT(spdk_nvme_zns_ns_get_data(&ns) == &nsdata_zns);
+	CU_ASSERT(spdk_nvme_zns_ns_get_zone_size_sectors(&ns) == 128);
+	CU_ASSERT(spdk_nvme_zns_ns_get_zone_size(&ns) == 128 * ZNS_SECTOR_SIZE);
+	CU_ASSERT(spdk_nvme_zns_ns_get_num_zones(&ns) == 8);
+	CU_ASSERT(spdk_nvme_zns_ns_get_max_open_zones(&ns) == 14);
+	CU_ASSERT(spdk_nvme_zns_ns_get_max_active_zones(&ns) == 0);
+
+	/* A namespace without ZNS data is not zoned */
+	ns.nsdata_zns = NULL;
+	CU_ASSERT(spdk_nvme_zns_ns_get_data(&ns) == NULL);
+	CU_ASSERT(spdk_nvme_zns_ns_get_zone_size_sectors(&ns) == 0);
+	CU_ASSERT(spdk_nvme_zns_ns_get_num_zones(&ns) == 0);
+	CU_ASSERT(spdk_nvme_zns_ns_get_max_open_zones(&ns) == 0);
+
+	/* ZASL of 0 falls back to MDTS, otherwise the smaller of the two is used */
+	CU_ASSERT(spdk_nvme_zns_ctrlr_get_max_zone_append_size(&ctrlr) == 0x20000);
+	cdata_zns.zasl = 3;
+	CU_ASSERT(spdk_nvme_zns_ctrlr_get_max_zone_append_size(&ctrlr) == 0x8000);
+	cdata_zns.zasl = 6;
+	CU_ASSERT(spdk_nvme_zns_ctrlr_get_max_zone_append_size(&ctrlr) == 0x20000);
+
+	cleanup_after_test(&qpair);
+}
+
+static void
+test_nvme_zns_zone_append(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_zns_ns_data	nsdata_zns;
+	struct spdk_nvme_zns_ctrlr_data	cdata_zns;
+	char				*buffer;
+	int				rc;
+
+	prepare_for_test(&ns, &ctrlr, &qpair, &nsdata_zns, &cdata_zns, 0x20000);
+	buffer = malloc(0x20000);
+	SPDK_CU_ASSERT_FATAL(buffer != NULL);
+
+	rc = spdk_nvme_zns_zone_append(&ns, &qpair, buffer, 0x80, 8, NULL, NULL, 0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 0);
+	CU_ASSERT(g_request->cmd.opc == SPDK_NVME_OPC_ZONE_APPEND);
+	CU_ASSERT(g_request->cmd.nsid == ns.id);
+	CU_ASSERT(g_request->cmd.cdw10 == 0x80);
+	CU_ASSERT(g_request->cmd.cdw11 == 0);
+	CU_ASSERT(g_request->cmd.cdw12 == 7);
+	CU_ASSERT(g_request->payload_size == 8 * ZNS_SECTOR_SIZE);
+	nvme_free_request(g_request);
+	g_request = NULL;
+
+	/* Zone appends are never split, so anything above the limit is rejected */
+	cdata_zns.zasl = 3;
+	rc = spdk_nvme_zns_zone_append(&ns, &qpair, buffer, 0x80, 9, NULL, NULL, 0);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(g_request == NULL);
+
+	rc = spdk_nvme_zns_zone_append(&ns, &qpair, buffer, 0x80, 0, NULL, NULL, 0);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(g_request == NULL);
+
+	rc = spdk_nvme_zns_zone_append_with_md(&ns, &qpair, buffer, NULL, 0x100000000ULL, 8, NULL, NULL,
+					       SPDK_NVME_IO_FLAGS_FORCE_UNIT_ACCESS, 0xffff, 0x1234);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.cdw10 == 0);
+	CU_ASSERT(g_request->cmd.cdw11 == 1);
+	CU_ASSERT(g_request->cmd.cdw12 == (7 | SPDK_NVME_IO_FLAGS_FORCE_UNIT_ACCESS));
+	CU_ASSERT(g_request->cmd.cdw15 == 0xffff1234);
+	nvme_free_request(g_request);
+
+	free(buffer);
+	cleanup_after_test(&qpair);
+}
+
+static void
+test_nvme_zns_zone_mgmt_send(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_zns_ns_data	nsdata_zns;
+	struct spdk_nvme_zns_ctrlr_data	cdata_zns;
+	int				rc;
+
+	prepare_for_test(&ns, &ctrlr, &qpair, &nsdata_zns, &cdata_zns, 0x20000);
+
+	rc = spdk_nvme_zns_reset_zone(&ns, &qpair, 0x1000, false, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.opc == SPDK_NVME_OPC_ZONE_MGMT_SEND);
+	CU_ASSERT(g_request->cmd.nsid == ns.id);
+	CU_ASSERT(g_request->cmd.cdw10 == 0x1000);
+	CU_ASSERT(g_request->cmd.cdw13 == SPDK_NVME_ZONE_RESET);
+	nvme_free_request(g_request);
+
+	/* Select All ignores the zone start LBA */
+	rc = spdk_nvme_zns_close_zone(&ns, &qpair, 0x1000, true, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.cdw10 == 0);
+	CU_ASSERT(g_request->cmd.cdw13 == (SPDK_NVME_ZONE_CLOSE | (1 << 8)));
+	nvme_free_request(g_request);
+
+	rc = spdk_nvme_zns_open_zone(&ns, &qpair, 0x2000, false, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.cdw13 == SPDK_NVME_ZONE_OPEN);
+	nvme_free_request(g_request);
+
+	rc = spdk_nvme_zns_finish_zone(&ns, &qpair, 0x2000, false, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.cdw13 == SPDK_NVME_ZONE_FINISH);
+	nvme_free_request(g_request);
+
+	cleanup_after_test(&qpair);
+}
+
+static void
+test_nvme_zns_report_zones(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct spdk_nvme_zns_ns_data	nsdata_zns;
+	struct spdk_nvme_zns_ctrlr_data	cdata_zns;
+	char				payload[4096];
+	int				rc;
+
+	prepare_for_test(&ns, &ctrlr, &qpair, &nsdata_zns, &cdata_zns, 0x20000);
+
+	rc = spdk_nvme_zns_report_zones(&ns, &qpair, payload, 32, 0, SPDK_NVME_ZRA_LIST_ALL, true,
+					NULL, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(g_request == NULL);
+
+	rc = spdk_nvme_zns_report_zones(&ns, &qpair, payload, sizeof(payload), 0x4000,
+					SPDK_NVME_ZRA_LIST_ZSF, true, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->cmd.opc == SPDK_NVME_OPC_ZONE_MGMT_RECV);
+	CU_ASSERT(g_request->cmd.cdw10 == 0x4000);
+	CU_ASSERT(g_request->cmd.cdw12 == sizeof(payload) / sizeof(uint32_t) - 1);
+	CU_ASSERT(g_request->cmd.cdw13 == (SPDK_NVME_ZONE_REPORT | (SPDK_NVME_ZRA_LIST_ZSF << 8) |
+					   (1 << 16)));
+	CU_ASSERT(g_request->payload_size == sizeof(payload));
+	nvme_free_request(g_request);
+
+	cleanup_after_test(&qpair);
+}
+
+int main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	if (CU_initialize_registry() != CUE_SUCCESS) {
+		return CU_get_error();
+	}
+
+	suite = CU_add_suite("nvme_zns", NULL, NULL);
+	if (suite == NULL) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	if (
+		CU_add_test(suite, "nvme_zns_ns_get_info", test_nvme_zns_ns_get_info) == NULL
+		|| CU_add_test(suite, "nvme_zns_zone_append", test_nvme_zns_zone_append) == NULL
+		|| CU_add_test(suite, "nvme_zns_zone_mgmt_send", test_nvme_zns_zone_mgmt_send) == NULL
+		|| CU_add_test(suite, "nvme_zns_report_zones", test_nvme_zns_report_zones) == NULL
+	) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	g_spdk_nvme_driver = &_g_nvme_driver;
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+	return num_failures;
+}
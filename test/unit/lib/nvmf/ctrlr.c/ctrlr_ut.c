@@ -92,6 +92,19 @@ DEFINE_STUB(spdk_nvmf_subsystem_get_ctrlr,
 	    (struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid),
 	    NULL);
 
+struct spdk_nvmf_ctrlr *
+spdk_nvmf_subsystem_lookup_ctrlr(struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid,
+				 struct spdk_thread **thread)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = spdk_nvmf_subsystem_get_ctrlr(subsystem, cntlid);
+
+	if (ctrlr != NULL) {
+		*thread = ctrlr->thread;
+	}
+
+	return ctrlr;
+}
+
 DEFINE_STUB(spdk_nvmf_ctrlr_dsm_supported,
 	    bool,
 	    (struct spdk_nvmf_ctrlr *ctrlr),
@@ -116,6 +129,11 @@ DEFINE_STUB(spdk_nvmf_subsystem_listener_allowed,
 	    (struct spdk_nvmf_subsystem *subsystem, struct spdk_nvme_transport_id *trid),
 	    true);
 
+DEFINE_STUB(spdk_nvmf_subsystem_find_listener,
+	    struct spdk_nvmf_listener *,
+	    (struct spdk_nvmf_subsystem *subsystem, const struct spdk_nvme_transport_id *trid),
+	    NULL);
+
 DEFINE_STUB(spdk_nvmf_transport_qpair_set_sqsize,
 	    int,
 	    (struct spdk_nvmf_qpair *qpair),
@@ -127,6 +145,12 @@ DEFINE_STUB(spdk_nvmf_bdev_ctrlr_read_cmd,
 	     struct spdk_nvmf_request *req),
 	    0);
 
+DEFINE_STUB(spdk_nvmf_bdev_ctrlr_cache_read_cmd,
+	    int,
+	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     struct spdk_nvmf_ns_cache *cache, struct spdk_nvmf_request *req),
+	    SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+
 DEFINE_STUB(spdk_nvmf_bdev_ctrlr_write_cmd,
 	    int,
 	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
@@ -157,6 +181,41 @@ DEFINE_STUB(spdk_nvmf_bdev_ctrlr_nvme_passthru_io,
 	     struct spdk_nvmf_request *req),
 	    0);
 
+DEFINE_STUB(spdk_nvmf_bdev_ctrlr_zcopy_start,
+	    int,
+	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     struct spdk_nvmf_request *req),
+	    0);
+
+DEFINE_STUB(spdk_nvmf_ns_sched_submit, bool,
+	    (struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_request *req), true);
+
+static int g_sched_request_done_count;
+
+void
+spdk_nvmf_ns_sched_request_done(struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_request *req)
+{
+	req->sched_flow = NULL;
+	g_sched_request_done_count++;
+}
+
+static int g_cache_invalidate_count;
+
+void
+spdk_nvmf_ns_cache_invalidate_cmd(struct spdk_nvmf_ns_cache *cache, struct spdk_nvmf_request *req)
+{
+	g_cache_invalidate_count++;
+}
+
+static int g_zcopy_release_count;
+
+void
+spdk_nvmf_bdev_ctrlr_zcopy_release(struct spdk_nvmf_request *req)
+{
+	req->zcopy_bdev_io = NULL;
+	g_zcopy_release_count++;
+}
+
 DEFINE_STUB(spdk_nvmf_transport_req_complete,
 	    int,
 	    (struct spdk_nvmf_request *req),
@@ -169,6 +228,15 @@ DEFINE_STUB(spdk_nvmf_bdev_ctrlr_get_dif_ctx, bool,
 	     struct spdk_dif_ctx *dif_ctx),
 	    true);
 
+static uint32_t g_ns_remove_done_nsid;
+
+void
+spdk_nvmf_poll_group_remove_ns_done(struct spdk_nvmf_poll_group *group,
+				    struct spdk_nvmf_subsystem *subsystem, uint32_t nsid)
+{
+	g_ns_remove_done_nsid = nsid;
+}
+
 int
 spdk_nvmf_qpair_disconnect(struct spdk_nvmf_qpair *qpair, nvmf_qpair_disconnect_cb cb_fn, void *ctx)
 {
@@ -310,6 +378,7 @@ test_connect(void)
 
 	memset(&ctrlr, 0, sizeof(ctrlr));
 	ctrlr.subsys = &subsystem;
+	ctrlr.thread = spdk_get_thread();
 	ctrlr.qpair_mask = spdk_bit_array_create(3);
 	SPDK_CU_ASSERT_FATAL(ctrlr.qpair_mask != NULL);
 	ctrlr.vcprop.cc.bits.en = 1;
@@ -552,13 +621,13 @@ test_connect(void)
 	qpair.ctrlr = NULL;
 	cmd.connect_cmd.sqsize = 31;
 
-	/* Non-existent controller */
+	/* Non-existent controller - rejected without leaving the qpair's thread */
 	memset(&rsp, 0, sizeof(rsp));
 	MOCK_SET(spdk_nvmf_subsystem_get_ctrlr, NULL);
 	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
 	rc = spdk_nvmf_ctrlr_connect(&req);
 	poll_threads();
-	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
 	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_COMMAND_SPECIFIC);
 	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVMF_FABRIC_SC_INVALID_PARAM);
 	CU_ASSERT(rsp.connect_rsp.status_code_specific.invalid.iattr == 1);
@@ -637,6 +706,20 @@ test_connect(void)
 	CU_ASSERT(qpair.ctrlr == NULL);
 	ctrlr.vcprop.cc.bits.iocqes = 4;
 
+	/* Controller removed after the lookup but before the queue was attached */
+	memset(&rsp, 0, sizeof(rsp));
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	rc = spdk_nvmf_ctrlr_connect(&req);
+	MOCK_SET(spdk_nvmf_subsystem_get_ctrlr, NULL);
+	poll_threads();
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_COMMAND_SPECIFIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVMF_FABRIC_SC_INVALID_PARAM);
+	CU_ASSERT(rsp.connect_rsp.status_code_specific.invalid.iattr == 1);
+	CU_ASSERT(rsp.connect_rsp.status_code_specific.invalid.ipo == 16);
+	CU_ASSERT(qpair.ctrlr == NULL);
+	MOCK_SET(spdk_nvmf_subsystem_get_ctrlr, &ctrlr);
+
 	/* I/O connect with too many existing qpairs */
 	memset(&rsp, 0, sizeof(rsp));
 	spdk_bit_array_set(ctrlr.qpair_mask, 0);
@@ -1202,6 +1285,59 @@ test_reservation_notification_log_page(void)
 	SPDK_CU_ASSERT_FATAL(ctrlr.num_avail_log_pages == 0);
 }
 
+static void
+test_async_event_notices(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_subsystem_poll_group sgroups[1] = {};
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_request req = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	union spdk_nvme_async_event_completion event;
+
+	subsystem.id = 0;
+	group.sgroups = sgroups;
+	sgroups[0].io_outstanding = 1;
+	ctrlr.subsys = &subsystem;
+	ctrlr.feat.async_event_configuration.bits.ns_attr_notice = 1;
+	ctrlr.feat.async_event_configuration.bits.ana_change_notice = 1;
+	qpair.ctrlr = &ctrlr;
+	qpair.group = &group;
+	req.qpair = &qpair;
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_ASYNC_EVENT_REQUEST;
+
+	/* Both notices arrive before any AER is posted, neither may be lost */
+	CU_ASSERT(spdk_nvmf_ctrlr_async_event_ns_notice(&ctrlr) == 0);
+	CU_ASSERT(spdk_nvmf_ctrlr_async_event_ana_change_notice(&ctrlr) == 0);
+	CU_ASSERT(spdk_nvmf_ctrlr_async_event_ns_notice(&ctrlr) == 0);
+
+	CU_ASSERT(spdk_nvmf_ctrlr_async_event_request(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	event.raw = rsp.nvme_cpl.cdw0;
+	CU_ASSERT(event.bits.async_event_type == SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE);
+	CU_ASSERT(event.bits.async_event_info == SPDK_NVME_ASYNC_EVENT_NS_ATTR_CHANGED);
+	CU_ASSERT(event.bits.log_page_identifier == SPDK_NVME_LOG_CHANGED_NS_LIST);
+
+	memset(&rsp, 0, sizeof(rsp));
+	CU_ASSERT(spdk_nvmf_ctrlr_async_event_request(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	event.raw = rsp.nvme_cpl.cdw0;
+	CU_ASSERT(event.bits.async_event_type == SPDK_NVME_ASYNC_EVENT_TYPE_NOTICE);
+	CU_ASSERT(event.bits.async_event_info == SPDK_NVME_ASYNC_EVENT_ANA_CHANGE);
+	CU_ASSERT(event.bits.log_page_identifier == SPDK_NVME_LOG_ASYMMETRIC_NAMESPACE_ACCESS);
+
+	/* Nothing is left, so the next AER waits for an event */
+	CU_ASSERT(spdk_nvmf_ctrlr_async_event_request(&req) ==
+		  SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(ctrlr.aer_req == &req);
+	CU_ASSERT(ctrlr.pending_notices == 0);
+	CU_ASSERT(sgroups[0].io_outstanding == 0);
+	ctrlr.aer_req = NULL;
+}
+
 static void
 test_get_dif_ctx(void)
 {
@@ -1270,6 +1406,400 @@ test_get_dif_ctx(void)
 	CU_ASSERT(ret == true);
 }
 
+static void
+test_get_ana_log_page(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_listener listener = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem, .listener = &listener };
+	struct spdk_nvmf_ns ns[4] = {};
+	struct spdk_nvmf_ns *ns_arr[4] = {&ns[0], NULL, &ns[2], &ns[3]};
+	enum spdk_nvme_ana_state ana_state[4] = {
+		SPDK_NVME_ANA_INACCESSIBLE_STATE,
+		SPDK_NVME_ANA_OPTIMIZED_STATE,
+		SPDK_NVME_ANA_OPTIMIZED_STATE,
+		SPDK_NVME_ANA_NON_OPTIMIZED_STATE,
+	};
+	struct spdk_nvme_ana_page *hdr;
+	struct spdk_nvme_ana_group_descriptor *desc;
+	char data[4096];
+	char expected[4096];
+
+	/* NSIDs 1 and 3 share ANA group 1, NSID 4 is alone in ANA group 4 */
+	ns[0].nsid = 1;
+	ns[0].opts.anagrpid = 1;
+	ns[2].nsid = 3;
+	ns[2].opts.anagrpid = 1;
+	ns[3].nsid = 4;
+	ns[3].opts.anagrpid = 4;
+	subsystem.ns = ns_arr;
+	subsystem.max_nsid = SPDK_COUNTOF(ns_arr);
+
+	listener.ana_state = ana_state;
+	listener.num_ana_groups = SPDK_COUNTOF(ana_state);
+	listener.ana_state_change_count = 3;
+
+	/* Full log page with namespace lists */
+	memset(data, 0xFF, sizeof(data));
+	spdk_nvmf_get_ana_log_page(&ctrlr, data, 0, sizeof(data), false);
+	hdr = (struct spdk_nvme_ana_page *)data;
+	CU_ASSERT(hdr->change_count == 3);
+	CU_ASSERT(hdr->num_ana_group_desc == 2);
+	desc = (struct spdk_nvme_ana_group_descriptor *)(data + sizeof(*hdr));
+	CU_ASSERT(desc->ana_group_id == 1);
+	CU_ASSERT(desc->num_of_nsid == 2);
+	CU_ASSERT(desc->change_count == 3);
+	CU_ASSERT(desc->ana_state == SPDK_NVME_ANA_INACCESSIBLE_STATE);
+	CU_ASSERT(desc->nsid[0] == 1);
+	CU_ASSERT(desc->nsid[1] == 3);
+	desc = (struct spdk_nvme_ana_group_descriptor *)((char *)desc + sizeof(*desc) + 2 * sizeof(uint32_t));
+	CU_ASSERT(desc->ana_group_id == 4);
+	CU_ASSERT(desc->num_of_nsid == 1);
+	CU_ASSERT(desc->ana_state == SPDK_NVME_ANA_NON_OPTIMIZED_STATE);
+	CU_ASSERT(desc->nsid[0] == 4);
+	/* Everything past the end of the page is zeroed */
+	CU_ASSERT(spdk_mem_all_zero((char *)desc + sizeof(*desc) + sizeof(uint32_t),
+				    sizeof(data) - sizeof(*hdr) - 2 * sizeof(*desc) - 3 * sizeof(uint32_t)));
+
+	/* Partial read starting at the first descriptor */
+	memcpy(expected, data, sizeof(data));
+	memset(data, 0xFF, sizeof(data));
+	spdk_nvmf_get_ana_log_page(&ctrlr, data, sizeof(*hdr), sizeof(*desc), false);
+	CU_ASSERT(memcmp(data, expected + sizeof(*hdr), sizeof(*desc)) == 0);
+
+	/* Return Groups Only omits the namespace lists */
+	memset(data, 0xFF, sizeof(data));
+	spdk_nvmf_get_ana_log_page(&ctrlr, data, 0, sizeof(data), true);
+	hdr = (struct spdk_nvme_ana_page *)data;
+	CU_ASSERT(hdr->num_ana_group_desc == 2);
+	desc = (struct spdk_nvme_ana_group_descriptor *)(data + sizeof(*hdr));
+	CU_ASSERT(desc->ana_group_id == 1);
+	CU_ASSERT(desc->num_of_nsid == 0);
+	desc++;
+	CU_ASSERT(desc->ana_group_id == 4);
+	CU_ASSERT(desc->num_of_nsid == 0);
+	CU_ASSERT(desc->ana_state == SPDK_NVME_ANA_NON_OPTIMIZED_STATE);
+
+	/* Controllers without a listener report all groups as optimized */
+	ctrlr.listener = NULL;
+	spdk_nvmf_get_ana_log_page(&ctrlr, data, 0, sizeof(data), true);
+	CU_ASSERT(hdr->change_count == 0);
+	desc = (struct spdk_nvme_ana_group_descriptor *)(data + sizeof(*hdr));
+	CU_ASSERT(desc->ana_state == SPDK_NVME_ANA_OPTIMIZED_STATE);
+}
+
+static void
+test_ana_io_cmd(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_listener listener = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem, .listener = &listener };
+	struct spdk_nvmf_qpair qpair = { .ctrlr = &ctrlr };
+	struct spdk_nvmf_request req = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_bdev bdev = {};
+	struct spdk_nvmf_ns ns = { .nsid = 1, .bdev = &bdev, .opts.anagrpid = 1 };
+	struct spdk_nvmf_ns *ns_arr[1] = {&ns};
+	enum spdk_nvme_ana_state ana_state[1] = {SPDK_NVME_ANA_INACCESSIBLE_STATE};
+
+	subsystem.ns = ns_arr;
+	subsystem.max_nsid = 1;
+	listener.ana_state = ana_state;
+	listener.num_ana_groups = 1;
+	ctrlr.vcprop.cc.bits.en = 1;
+
+	req.qpair = &qpair;
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
+	cmd.nvme_cmd.nsid = 1;
+
+	CU_ASSERT(spdk_nvmf_ctrlr_process_io_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_PATH);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_ASYMMETRIC_ACCESS_INACCESSIBLE);
+
+	ana_state[0] = SPDK_NVME_ANA_PERSISTENT_LOSS_STATE;
+	memset(&rsp, 0, sizeof(rsp));
+	CU_ASSERT(spdk_nvmf_ctrlr_process_io_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_PATH);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_ASYMMETRIC_ACCESS_PERSISTENT_LOSS);
+}
+
+static void
+test_ns_io_tracking(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem };
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info = {};
+	struct spdk_nvmf_subsystem_poll_group sgroup = {};
+	struct spdk_nvmf_poll_group group = { .sgroups = &sgroup };
+	struct spdk_nvmf_qpair qpair = { .ctrlr = &ctrlr, .group = &group };
+	struct spdk_nvmf_request req = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_bdev bdev = {};
+	struct spdk_nvmf_ns ns = { .nsid = 1, .bdev = &bdev, .opts.anagrpid = 1 };
+	struct spdk_nvmf_ns *ns_arr[1] = {&ns};
+
+	subsystem.ns = ns_arr;
+	subsystem.max_nsid = 1;
+	ctrlr.vcprop.cc.bits.en = 1;
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+	TAILQ_INIT(&qpair.outstanding);
+
+	req.qpair = &qpair;
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
+	cmd.nvme_cmd.nsid = 1;
+
+	/* Namespace published but not yet attached to this poll group */
+	CU_ASSERT(spdk_nvmf_ctrlr_process_io_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_NAMESPACE_OR_FORMAT);
+	CU_ASSERT(req.ns_io_tracked == false);
+
+	/* Attached - the request is counted once, even if it is resubmitted */
+	sgroup.ns_info = &ns_info;
+	sgroup.num_ns = 1;
+	ns_info.channel = (struct spdk_io_channel *)0xDEADBEEF;
+	memset(&rsp, 0, sizeof(rsp));
+	spdk_nvmf_ctrlr_process_io_cmd(&req);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+	CU_ASSERT(req.ns_io_tracked == true);
+	CU_ASSERT(ns_info.io_outstanding == 1);
+	spdk_nvmf_ctrlr_process_io_cmd(&req);
+	CU_ASSERT(ns_info.io_outstanding == 1);
+
+	/* A pending hot removal finishes when the last I/O completes */
+	ns_info.remove_cb_fn = (spdk_nvmf_poll_group_mod_done)0xDEADBEEF;
+	g_ns_remove_done_nsid = 0;
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	sgroup.io_outstanding = 1;
+	CU_ASSERT(spdk_nvmf_request_complete(&req) == 0);
+	CU_ASSERT(req.ns_io_tracked == false);
+	CU_ASSERT(ns_info.io_outstanding == 0);
+	CU_ASSERT(sgroup.io_outstanding == 0);
+	CU_ASSERT(g_ns_remove_done_nsid == 1);
+}
+
+static void
+test_ns_sched_io(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem };
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info = {};
+	struct spdk_nvmf_subsystem_poll_group sgroup = {};
+	struct spdk_nvmf_poll_group group = { .sgroups = &sgroup };
+	struct spdk_nvmf_qpair qpair = { .ctrlr = &ctrlr, .group = &group, .qid = 1 };
+	struct spdk_nvmf_request req = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_bdev bdev = {};
+	struct spdk_nvmf_ns ns = { .nsid = 1, .bdev = &bdev, .opts.anagrpid = 1 };
+	struct spdk_nvmf_ns *ns_arr[1] = {&ns};
+
+	subsystem.ns = ns_arr;
+	subsystem.max_nsid = 1;
+	ctrlr.vcprop.cc.bits.en = 1;
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+	TAILQ_INIT(&qpair.outstanding);
+	sgroup.ns_info = &ns_info;
+	sgroup.num_ns = 1;
+	sgroup.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	ns_info.channel = (struct spdk_io_channel *)0xDEADBEEF;
+	ns_info.sched = (struct spdk_nvmf_ns_sched *)0xDEADBEEF;
+
+	req.qpair = &qpair;
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
+	cmd.nvme_cmd.nsid = 1;
+
+	/* Zero copy would take the buffers before the scheduler lets the write run */
+	CU_ASSERT(spdk_nvmf_request_zcopy_start(&req, NULL) == -EBUSY);
+	CU_ASSERT(req.ns_io_tracked == false);
+
+	/* The scheduler holds the request back, it is counted against the namespace already */
+	MOCK_SET(spdk_nvmf_ns_sched_submit, false);
+	CU_ASSERT(spdk_nvmf_ctrlr_process_io_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(req.ns_io_tracked == true);
+	CU_ASSERT(ns_info.io_outstanding == 1);
+	MOCK_SET(spdk_nvmf_ns_sched_submit, true);
+
+	/* Once dispatched, the request runs and its completion is reported to the scheduler */
+	req.sched_flow = (struct spdk_nvmf_ns_sched_flow *)0xDEADBEEF;
+	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	sgroup.io_outstanding = 1;
+	g_sched_request_done_count = 0;
+	spdk_nvmf_request_exec_scheduled(&req);
+	CU_ASSERT(g_sched_request_done_count == 1);
+	CU_ASSERT(req.sched_flow == NULL);
+	CU_ASSERT(ns_info.io_outstanding == 0);
+	CU_ASSERT(sgroup.io_outstanding == 0);
+	CU_ASSERT(TAILQ_EMPTY(&qpair.outstanding));
+}
+
+static void
+test_ns_cache_io(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem };
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info = {};
+	struct spdk_nvmf_subsystem_poll_group sgroup = {};
+	struct spdk_nvmf_poll_group group = { .sgroups = &sgroup };
+	struct spdk_nvmf_qpair qpair = { .ctrlr = &ctrlr, .group = &group, .qid = 1 };
+	struct spdk_nvmf_request req = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_bdev bdev = {};
+	struct spdk_nvmf_ns ns = { .nsid = 1, .bdev = &bdev, .opts.anagrpid = 1 };
+	struct spdk_nvmf_ns *ns_arr[1] = {&ns};
+
+	subsystem.ns = ns_arr;
+	subsystem.max_nsid = 1;
+	ctrlr.vcprop.cc.bits.en = 1;
+	sgroup.ns_info = &ns_info;
+	sgroup.num_ns = 1;
+	ns_info.channel = (struct spdk_io_channel *)0xDEADBEEF;
+
+	req.qpair = &qpair;
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+	cmd.nvme_cmd.nsid = 1;
+
+	/* Without a cache reads go straight to the bdev */
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
+	CU_ASSERT(spdk_nvmf_ctrlr_process_io_cmd(&req) == 0);
+	nvmf_request_ns_io_done(&qpair, &sgroup, &req);
+
+	/* With one they go through it, and leave it alone when they are done */
+	ns.cache = (struct spdk_nvmf_ns_cache *)0xDEADBEEF;
+	g_cache_invalidate_count = 0;
+	CU_ASSERT(spdk_nvmf_ctrlr_process_io_cmd(&req) == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	nvmf_request_ns_io_done(&qpair, &sgroup, &req);
+	CU_ASSERT(g_cache_invalidate_count == 0);
+
+	/* Writes invalidate what they touch before they start and once they are done */
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
+	CU_ASSERT(spdk_nvmf_ctrlr_process_io_cmd(&req) == 0);
+	CU_ASSERT(g_cache_invalidate_count == 1);
+	nvmf_request_ns_io_done(&qpair, &sgroup, &req);
+	CU_ASSERT(g_cache_invalidate_count == 2);
+	CU_ASSERT(ns_info.io_outstanding == 0);
+}
+
+static int g_zcopy_start_status;
+
+static void
+ut_zcopy_start_done(struct spdk_nvmf_request *req, int status)
+{
+	g_zcopy_start_status = status;
+}
+
+static void
+ut_qpair_state_done(void *cb_arg, int status)
+{
+}
+
+static void
+test_zcopy_start(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem };
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info = {};
+	struct spdk_nvmf_subsystem_poll_group sgroup = {};
+	struct spdk_nvmf_poll_group group = { .sgroups = &sgroup };
+	struct spdk_nvmf_qpair qpair = { .ctrlr = &ctrlr, .group = &group, .qid = 1 };
+	struct spdk_nvmf_request req = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_bdev bdev = {};
+	struct spdk_nvmf_ns ns = { .nsid = 1, .bdev = &bdev, .opts.anagrpid = 1 };
+	struct spdk_nvmf_ns *ns_arr[1] = {&ns};
+	int rc;
+
+	subsystem.ns = ns_arr;
+	subsystem.max_nsid = 1;
+	ctrlr.vcprop.cc.bits.en = 1;
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+	qpair.state_cb = ut_qpair_state_done;
+	TAILQ_INIT(&qpair.outstanding);
+	sgroup.ns_info = &ns_info;
+	sgroup.num_ns = 1;
+	ns_info.channel = (struct spdk_io_channel *)0xDEADBEEF;
+
+	req.qpair = &qpair;
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
+	cmd.nvme_cmd.nsid = 1;
+
+	/* Only writes are placed directly */
+	rc = spdk_nvmf_request_zcopy_start(&req, ut_zcopy_start_done);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* Not while the subsystem is paused */
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
+	sgroup.state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+	rc = spdk_nvmf_request_zcopy_start(&req, ut_zcopy_start_done);
+	CU_ASSERT(rc == -EBUSY);
+
+	/* The bdev refuses, nothing is left accounted */
+	sgroup.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	MOCK_SET(spdk_nvmf_bdev_ctrlr_zcopy_start, -ENOTSUP);
+	rc = spdk_nvmf_request_zcopy_start(&req, ut_zcopy_start_done);
+	CU_ASSERT(rc == -ENOTSUP);
+	CU_ASSERT(sgroup.io_outstanding == 0);
+	CU_ASSERT(ns_info.io_outstanding == 0);
+	CU_ASSERT(TAILQ_EMPTY(&qpair.outstanding));
+	MOCK_SET(spdk_nvmf_bdev_ctrlr_zcopy_start, 0);
+
+	/* Started - the request is counted while the buffers are held */
+	rc = spdk_nvmf_request_zcopy_start(&req, ut_zcopy_start_done);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(sgroup.io_outstanding == 1);
+	CU_ASSERT(ns_info.io_outstanding == 1);
+	CU_ASSERT(TAILQ_FIRST(&qpair.outstanding) == &req);
+
+	req.zcopy_bdev_io = (struct spdk_bdev_io *)0xDEADBEEF;
+	g_zcopy_start_status = -1;
+	spdk_nvmf_request_zcopy_start_done(&req, 0);
+	CU_ASSERT(g_zcopy_start_status == 0);
+	CU_ASSERT(TAILQ_EMPTY(&qpair.outstanding));
+	CU_ASSERT(sgroup.io_outstanding == 1);
+
+	/* Execution doesn't count it again, the completion releases the unused buffers */
+	g_zcopy_release_count = 0;
+	spdk_nvmf_request_exec(&req);
+	CU_ASSERT(g_zcopy_release_count == 1);
+	CU_ASSERT(req.zcopy_bdev_io == NULL);
+	CU_ASSERT(sgroup.io_outstanding == 0);
+	CU_ASSERT(ns_info.io_outstanding == 0);
+	CU_ASSERT(TAILQ_EMPTY(&qpair.outstanding));
+
+	/* A failed start is undone before the transport is told */
+	rc = spdk_nvmf_request_zcopy_start(&req, ut_zcopy_start_done);
+	CU_ASSERT(rc == 0);
+	spdk_nvmf_request_zcopy_start_done(&req, -EIO);
+	CU_ASSERT(g_zcopy_start_status == -EIO);
+	CU_ASSERT(sgroup.io_outstanding == 0);
+	CU_ASSERT(ns_info.io_outstanding == 0);
+
+	/* The buffers are dropped if the qpair went away in the meantime */
+	rc = spdk_nvmf_request_zcopy_start(&req, ut_zcopy_start_done);
+	CU_ASSERT(rc == 0);
+	qpair.state = SPDK_NVMF_QPAIR_DEACTIVATING;
+	req.zcopy_bdev_io = (struct spdk_bdev_io *)0xDEADBEEF;
+	g_zcopy_release_count = 0;
+	spdk_nvmf_request_zcopy_start_done(&req, 0);
+	CU_ASSERT(g_zcopy_start_status == -ECONNABORTED);
+	CU_ASSERT(g_zcopy_release_count == 1);
+	CU_ASSERT(sgroup.io_outstanding == 0);
+	CU_ASSERT(ns_info.io_outstanding == 0);
+	CU_ASSERT(TAILQ_EMPTY(&qpair.outstanding));
+}
+
 int main(int argc, char **argv)
 {
 	CU_pSuite	suite = NULL;
@@ -1300,6 +1830,13 @@ int main(int argc, char **argv)
 		CU_add_test(suite, "reservation_notification_log_page",
 			    test_reservation_notification_log_page) == NULL ||
 		CU_add_test(suite, "get_dif_ctx", test_get_dif_ctx) == NULL ||
+		CU_add_test(suite, "get_ana_log_page", test_get_ana_log_page) == NULL ||
+		CU_add_test(suite, "ana_io_cmd", test_ana_io_cmd) == NULL ||
+		CU_add_test(suite, "ns_io_tracking", test_ns_io_tracking) == NULL ||
+		CU_add_test(suite, "zcopy_start", test_zcopy_start) == NULL ||
+		CU_add_test(suite, "async_event_notices", test_async_event_notices) == NULL ||
+		CU_add_test(suite, "ns_sched_io", test_ns_sched_io) == NULL ||
+		CU_add_test(suite, "ns_cache_io", test_ns_cache_io) == NULL ||
 		CU_add_test(suite, "set_get_features",
 			    test_set_get_features) == NULL
 	) {
@@ -44,6 +44,8 @@ SPDK_LOG_REGISTER_COMPONENT("nvmf", SPDK_LOG_NVMF)
 
 DEFINE_STUB(spdk_nvmf_request_complete, int, (struct spdk_nvmf_request *req), -1);
 
+DEFINE_STUB_V(spdk_nvmf_request_zcopy_start_done, (struct spdk_nvmf_request *req, int status));
+
 DEFINE_STUB(spdk_bdev_get_name, const char *, (const struct spdk_bdev *bdev), "test");
 
 struct spdk_bdev {
@@ -122,6 +124,20 @@ DEFINE_STUB(spdk_bdev_writev_blocks, int,
 	     spdk_bdev_io_completion_cb cb, void *cb_arg),
 	    0);
 
+DEFINE_STUB(spdk_bdev_zcopy_start, int,
+	    (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     uint64_t offset_blocks, uint64_t num_blocks, bool populate,
+	     spdk_bdev_io_completion_cb cb, void *cb_arg),
+	    0);
+
+DEFINE_STUB(spdk_bdev_zcopy_end, int,
+	    (struct spdk_bdev_io *bdev_io, bool commit,
+	     spdk_bdev_io_completion_cb cb, void *cb_arg),
+	    0);
+
+DEFINE_STUB_V(spdk_bdev_io_get_iovec,
+	      (struct spdk_bdev_io *bdev_io, struct iovec **iovp, int *iovcntp));
+
 DEFINE_STUB(spdk_bdev_read_blocks, int,
 	    (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
 	     uint64_t offset_blocks, uint64_t num_blocks,
@@ -172,6 +188,35 @@ spdk_nvmf_subsystem_get_next_ns(struct spdk_nvmf_subsystem *subsystem, struct sp
 	return NULL;
 }
 
+DEFINE_STUB(spdk_nvmf_ns_cache_get_line_blocks, uint32_t,
+	    (const struct spdk_nvmf_ns_cache *cache), 1);
+
+DEFINE_STUB(spdk_nvmf_ns_cache_hold_get, struct spdk_nvmf_ns_cache_hold *,
+	    (struct spdk_nvmf_ns_cache *cache, uint64_t start_lba, uint64_t num_blocks, void *ctx),
+	    NULL);
+
+DEFINE_STUB_V(spdk_nvmf_ns_cache_hold_put, (struct spdk_nvmf_ns_cache_hold *hold));
+
+DEFINE_STUB(spdk_nvmf_ns_cache_hold_get_ctx, void *,
+	    (const struct spdk_nvmf_ns_cache_hold *hold), NULL);
+
+DEFINE_STUB(spdk_nvmf_ns_cache_hold_get_num_lines, uint32_t,
+	    (const struct spdk_nvmf_ns_cache_hold *hold), 0);
+
+DEFINE_STUB(spdk_nvmf_ns_cache_hold_get_line, void *,
+	    (struct spdk_nvmf_ns_cache_hold *hold, uint32_t idx, uint64_t *lba, void **fill_ctx),
+	    NULL);
+
+DEFINE_STUB(spdk_nvmf_ns_cache_fill_done, bool,
+	    (void *fill_ctx, bool success, struct spdk_nvmf_ns_cache_hold **hold), false);
+
+DEFINE_STUB(spdk_nvmf_ns_cache_hold_is_valid, bool,
+	    (const struct spdk_nvmf_ns_cache_hold *hold), false);
+
+DEFINE_STUB_V(spdk_nvmf_ns_cache_request_serve,
+	      (struct spdk_nvmf_request *req, struct spdk_nvmf_ns_cache_hold *hold,
+	       uint64_t start_lba, uint64_t num_blocks));
+
 DEFINE_STUB_V(spdk_bdev_io_get_nvme_status,
 	      (const struct spdk_bdev_io *bdev_io, int *sct, int *sc));
 
@@ -53,6 +53,17 @@ DEFINE_STUB(spdk_nvmf_transport_stop_listen,
 	    (struct spdk_nvmf_transport *transport,
 	     const struct spdk_nvme_transport_id *trid), 0);
 
+DEFINE_STUB(spdk_nvmf_ns_sched_get_stats, int,
+	    (struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_ns_sched_host_stat **stats,
+	     uint32_t *num_stats), 0);
+
+DEFINE_STUB(spdk_nvmf_ns_cache_create, struct spdk_nvmf_ns_cache *,
+	    (const struct spdk_nvmf_ns_cache_opts *opts, uint32_t block_size), NULL);
+DEFINE_STUB_V(spdk_nvmf_ns_cache_destroy, (struct spdk_nvmf_ns_cache *cache));
+DEFINE_STUB_V(spdk_nvmf_ns_cache_purge, (struct spdk_nvmf_ns_cache *cache));
+DEFINE_STUB_V(spdk_nvmf_ns_cache_get_stats,
+	      (struct spdk_nvmf_ns_cache *cache, struct spdk_nvmf_ns_cache_stats *stats));
+
 struct spdk_event *
 spdk_event_allocate(uint32_t core, spdk_event_fn fn, void *arg1, void *arg2)
 {
@@ -158,11 +169,25 @@ spdk_nvmf_ctrlr_ns_changed(struct spdk_nvmf_ctrlr *ctrlr, uint32_t nsid)
 {
 }
 
+int
+spdk_nvmf_ctrlr_async_event_ana_change_notice(struct spdk_nvmf_ctrlr *ctrlr)
+{
+	return 0;
+}
+
 void
 spdk_nvmf_ctrlr_destruct(struct spdk_nvmf_ctrlr *ctrlr)
 {
 }
 
+void
+spdk_nvmf_poll_group_remove_ns(struct spdk_nvmf_poll_group *group,
+			       struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			       spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg)
+{
+	cb_fn(cb_arg, 0);
+}
+
 int
 spdk_nvmf_poll_group_update_subsystem(struct spdk_nvmf_poll_group *group,
 				      struct spdk_nvmf_subsystem *subsystem)
@@ -216,6 +241,7 @@ test_discovery_log(void)
 	tgt.max_subsystems = 1024;
 	tgt.subsystems = calloc(tgt.max_subsystems, sizeof(struct spdk_nvmf_subsystem *));
 	SPDK_CU_ASSERT_FATAL(tgt.subsystems != NULL);
+	SPDK_CU_ASSERT_FATAL(pthread_mutex_init(&tgt.discovery_lock, NULL) == 0);
 
 	/* Add one subsystem and verify that the discovery log contains it */
 	subsystem = spdk_nvmf_subsystem_create(&tgt, "nqn.2016-06.io.spdk:subsystem1",
@@ -235,13 +261,13 @@ test_discovery_log(void)
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
 	spdk_nvmf_get_discovery_log_page(&tgt, "nqn.2016-06.io.spdk:host1", &iov, 1, 0,
 					 sizeof(disc_log->genctr));
-	CU_ASSERT(disc_log->genctr == 1); /* one added subsystem */
+	CU_ASSERT(disc_log->genctr == 2); /* one added subsystem and its listener */
 
 	/* Get only the header, no entries */
 	memset(buffer, 0xCC, sizeof(buffer));
 	disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
 	spdk_nvmf_get_discovery_log_page(&tgt, "nqn.2016-06.io.spdk:host1", &iov, 1, 0, sizeof(*disc_log));
-	CU_ASSERT(disc_log->genctr == 1);
+	CU_ASSERT(disc_log->genctr == 2);
 	CU_ASSERT(disc_log->numrec == 1);
 
 	/* Offset 0, exact size match */
@@ -273,6 +299,94 @@ test_discovery_log(void)
 	CU_ASSERT(entry->trtype == 42);
 	subsystem->state = SPDK_NVMF_SUBSYSTEM_INACTIVE;
 	spdk_nvmf_subsystem_destroy(subsystem);
+	CU_ASSERT(tgt.discovery_cache == NULL);
+	pthread_mutex_destroy(&tgt.discovery_lock);
+	free(tgt.subsystems);
+}
+
+static void
+test_discovery_log_cache(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem *subsystem1, *subsystem2;
+	struct spdk_nvmf_discovery_cache *cache;
+	uint8_t buffer[8192];
+	struct iovec iov;
+	struct spdk_nvmf_discovery_log_page *disc_log = (struct spdk_nvmf_discovery_log_page *)buffer;
+	struct spdk_nvme_transport_id trid = {};
+	uint64_t genctr;
+
+	iov.iov_base = buffer;
+	iov.iov_len = sizeof(buffer);
+
+	tgt.max_subsystems = 1024;
+	tgt.subsystems = calloc(tgt.max_subsystems, sizeof(struct spdk_nvmf_subsystem *));
+	SPDK_CU_ASSERT_FATAL(tgt.subsystems != NULL);
+	SPDK_CU_ASSERT_FATAL(pthread_mutex_init(&tgt.discovery_lock, NULL) == 0);
+
+	trid.trtype = SPDK_NVME_TRANSPORT_RDMA;
+	trid.adrfam = SPDK_NVMF_ADRFAM_IPV4;
+	snprintf(trid.traddr, sizeof(trid.traddr), "1234");
+	snprintf(trid.trsvcid, sizeof(trid.trsvcid), "5678");
+
+	/* subsystem1 is open to any host, subsystem2 only to host2 */
+	subsystem1 = spdk_nvmf_subsystem_create(&tgt, "nqn.2016-06.io.spdk:subsystem1",
+						SPDK_NVMF_SUBTYPE_NVME, 0);
+	SPDK_CU_ASSERT_FATAL(subsystem1 != NULL);
+	subsystem1->allow_any_host = true;
+	SPDK_CU_ASSERT_FATAL(spdk_nvmf_subsystem_add_listener(subsystem1, &trid) == 0);
+	subsystem1->state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+
+	subsystem2 = spdk_nvmf_subsystem_create(&tgt, "nqn.2016-06.io.spdk:subsystem2",
+						SPDK_NVMF_SUBTYPE_NVME, 0);
+	SPDK_CU_ASSERT_FATAL(subsystem2 != NULL);
+	SPDK_CU_ASSERT_FATAL(spdk_nvmf_subsystem_add_host(subsystem2, "nqn.2016-06.io.spdk:host2") == 0);
+	SPDK_CU_ASSERT_FATAL(spdk_nvmf_subsystem_add_listener(subsystem2, &trid) == 0);
+	subsystem2->state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+
+	memset(buffer, 0xCC, sizeof(buffer));
+	spdk_nvmf_get_discovery_log_page(&tgt, "nqn.2016-06.io.spdk:host1", &iov, 1, 0, sizeof(buffer));
+	genctr = disc_log->genctr;
+	CU_ASSERT(disc_log->numrec == 1);
+	CU_ASSERT(strcmp(disc_log->entries[0].subnqn, "nqn.2016-06.io.spdk:subsystem1") == 0);
+	CU_ASSERT(disc_log->entries[0].portid == 0);
+	cache = tgt.discovery_cache;
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	/* The cached log is filtered per host and not rebuilt */
+	memset(buffer, 0xCC, sizeof(buffer));
+	spdk_nvmf_get_discovery_log_page(&tgt, "nqn.2016-06.io.spdk:host2", &iov, 1, 0, sizeof(buffer));
+	CU_ASSERT(disc_log->genctr == genctr);
+	CU_ASSERT(disc_log->numrec == 2);
+	CU_ASSERT(disc_log->entries[1].portid == 1);
+	CU_ASSERT(strcmp(disc_log->entries[1].subnqn, "nqn.2016-06.io.spdk:subsystem2") == 0);
+	CU_ASSERT(tgt.discovery_cache == cache);
+
+	/* Only the second entry, starting in the middle of it */
+	memset(buffer, 0xCC, sizeof(buffer));
+	spdk_nvmf_get_discovery_log_page(&tgt, "nqn.2016-06.io.spdk:host2", &iov, 1,
+					 offsetof(struct spdk_nvmf_discovery_log_page, entries[1].subnqn),
+					 sizeof(disc_log->entries[1].subnqn));
+	CU_ASSERT(strcmp((char *)buffer, "nqn.2016-06.io.spdk:subsystem2") == 0);
+	CU_ASSERT(spdk_mem_all_zero(buffer + sizeof(disc_log->entries[1].subnqn),
+				    sizeof(buffer) - sizeof(disc_log->entries[1].subnqn)));
+
+	/* Changing the access list invalidates the cache */
+	subsystem2->state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+	SPDK_CU_ASSERT_FATAL(spdk_nvmf_subsystem_add_host(subsystem2, "nqn.2016-06.io.spdk:host1") == 0);
+	subsystem2->state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	CU_ASSERT(tgt.discovery_cache == NULL);
+
+	memset(buffer, 0xCC, sizeof(buffer));
+	spdk_nvmf_get_discovery_log_page(&tgt, "nqn.2016-06.io.spdk:host1", &iov, 1, 0, sizeof(buffer));
+	CU_ASSERT(disc_log->genctr == genctr + 1);
+	CU_ASSERT(disc_log->numrec == 2);
+
+	subsystem1->state = SPDK_NVMF_SUBSYSTEM_INACTIVE;
+	spdk_nvmf_subsystem_destroy(subsystem1);
+	subsystem2->state = SPDK_NVMF_SUBSYSTEM_INACTIVE;
+	spdk_nvmf_subsystem_destroy(subsystem2);
+	pthread_mutex_destroy(&tgt.discovery_lock);
 	free(tgt.subsystems);
 }
 
@@ -292,7 +406,8 @@ int main(int argc, char **argv)
 	}
 
 	if (
-		CU_add_test(suite, "discovery_log", test_discovery_log) == NULL) {
+		CU_add_test(suite, "discovery_log", test_discovery_log) == NULL ||
+		CU_add_test(suite, "discovery_log_cache", test_discovery_log_cache) == NULL) {
 		CU_cleanup_registry();
 		return CU_get_error();
 	}
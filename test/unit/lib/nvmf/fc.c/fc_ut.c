@@ -123,6 +123,7 @@ DEFINE_STUB(spdk_bdev_module_claim_bdev, int,
 DEFINE_STUB_V(spdk_bdev_module_release_bdev, (struct spdk_bdev *bdev));
 DEFINE_STUB(spdk_bdev_get_block_size, uint32_t, (const struct spdk_bdev *bdev), 512);
 DEFINE_STUB(spdk_nvmf_ctrlr_async_event_ns_notice, int, (struct spdk_nvmf_ctrlr *ctrlr), 0);
+DEFINE_STUB(spdk_nvmf_ctrlr_async_event_ana_change_notice, int, (struct spdk_nvmf_ctrlr *ctrlr), 0);
 
 const char *
 spdk_nvme_transport_id_trtype_str(enum spdk_nvme_transport_type trtype)
@@ -223,6 +224,22 @@ DEFINE_STUB_V(nvmf_fc_dump_all_queues, (struct spdk_nvmf_fc_hwqp *ls_queue,
 DEFINE_STUB_V(nvmf_fc_get_xri_info, (struct spdk_nvmf_fc_hwqp *hwqp,
 				     struct spdk_nvmf_fc_xchg_info *info));
 DEFINE_STUB(nvmf_fc_get_rsvd_thread, struct spdk_thread *, (void), NULL);
+DEFINE_STUB_V(spdk_nvmf_update_discovery_log, (struct spdk_nvmf_tgt *tgt));
+DEFINE_STUB_V(spdk_nvmf_discovery_cache_free, (struct spdk_nvmf_tgt *tgt));
+DEFINE_STUB(spdk_nvmf_ns_sched_create, struct spdk_nvmf_ns_sched *,
+	    (const struct spdk_nvmf_ns_sched_conf *conf), NULL);
+DEFINE_STUB(spdk_nvmf_ns_sched_update, int,
+	    (struct spdk_nvmf_ns_sched *sched, const struct spdk_nvmf_ns_sched_conf *conf), 0);
+DEFINE_STUB_V(spdk_nvmf_ns_sched_destroy, (struct spdk_nvmf_ns_sched *sched));
+DEFINE_STUB(spdk_nvmf_ns_sched_get_stats, int,
+	    (struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_ns_sched_host_stat **stats,
+	     uint32_t *num_stats), 0);
+DEFINE_STUB(spdk_nvmf_ns_cache_create, struct spdk_nvmf_ns_cache *,
+	    (const struct spdk_nvmf_ns_cache_opts *opts, uint32_t block_size), NULL);
+DEFINE_STUB_V(spdk_nvmf_ns_cache_destroy, (struct spdk_nvmf_ns_cache *cache));
+DEFINE_STUB_V(spdk_nvmf_ns_cache_purge, (struct spdk_nvmf_ns_cache *cache));
+DEFINE_STUB_V(spdk_nvmf_ns_cache_get_stats,
+	      (struct spdk_nvmf_ns_cache *cache, struct spdk_nvmf_ns_cache_stats *stats));
 
 uint32_t
 nvmf_fc_process_queue(struct spdk_nvmf_fc_hwqp *hwqp)
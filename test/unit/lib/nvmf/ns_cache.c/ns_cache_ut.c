@@ -0,0 +1,492 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "common/lib/ut_multithread.c"
+#include "spdk_cunit.h"
+#include "spdk_internal/mock.h"
+
+#include "nvmf/ns_cache.c"
+
+#define UT_BLOCK_SIZE	512
+#define UT_LINE_SIZE	4096
+#define UT_LINE_BLOCKS	(UT_LINE_SIZE / UT_BLOCK_SIZE)
+
+DEFINE_STUB(spdk_env_get_core_count, uint32_t, (void), 4);
+
+struct ut_req {
+	struct spdk_nvmf_request	req;
+	union nvmf_h2c_msg		cmd;
+	uint8_t				buf[4 * UT_LINE_SIZE];
+};
+
+static void
+ut_req_init(struct ut_req *ureq, uint32_t length)
+{
+	memset(ureq, 0, sizeof(*ureq));
+	ureq->req.cmd = &ureq->cmd;
+	ureq->req.length = length;
+	/* Split the buffer unevenly to exercise copies across iovec boundaries */
+	ureq->req.iov[0].iov_base = ureq->buf;
+	ureq->req.iov[0].iov_len = spdk_min(length, 1000);
+	ureq->req.iov[1].iov_base = ureq->buf + ureq->req.iov[0].iov_len;
+	ureq->req.iov[1].iov_len = length - ureq->req.iov[0].iov_len;
+	ureq->req.iovcnt = ureq->req.iov[1].iov_len > 0 ? 2 : 1;
+	ureq->req.data = ureq->buf;
+}
+
+/* Stand in for the bdev: every byte holds the low bits of its LBA */
+static void
+ut_fill_lines(struct spdk_nvmf_ns_cache_hold *hold, bool success)
+{
+	struct spdk_nvmf_ns_cache_hold *done_hold = NULL;
+	uint32_t i, num_lines = spdk_nvmf_ns_cache_hold_get_num_lines(hold);
+	uint64_t lba, b;
+	void *fill_ctx;
+	uint8_t *buf;
+	bool done = false;
+
+	for (i = 0; i < num_lines; i++) {
+		buf = spdk_nvmf_ns_cache_hold_get_line(hold, i, &lba, &fill_ctx);
+		if (fill_ctx == NULL) {
+			continue;
+		}
+		CU_ASSERT(!done);
+		for (b = 0; b < UT_LINE_BLOCKS; b++) {
+			memset(buf + b * UT_BLOCK_SIZE, (uint8_t)(lba + b), UT_BLOCK_SIZE);
+		}
+		done = spdk_nvmf_ns_cache_fill_done(fill_ctx, success, &done_hold);
+		CU_ASSERT(done_hold == hold);
+	}
+	CU_ASSERT(done);
+}
+
+static uint32_t
+ut_hold_num_fills(struct spdk_nvmf_ns_cache_hold *hold)
+{
+	uint32_t i, num_fills = 0;
+	uint64_t lba;
+	void *fill_ctx;
+
+	for (i = 0; i < spdk_nvmf_ns_cache_hold_get_num_lines(hold); i++) {
+		spdk_nvmf_ns_cache_hold_get_line(hold, i, &lba, &fill_ctx);
+		if (fill_ctx != NULL) {
+			num_fills++;
+		}
+	}
+
+	return num_fills;
+}
+
+static bool
+ut_data_matches(const uint8_t *buf, uint64_t start_lba, uint64_t num_blocks)
+{
+	uint64_t b;
+	uint32_t i;
+
+	for (b = 0; b < num_blocks; b++) {
+		for (i = 0; i < UT_BLOCK_SIZE; i++) {
+			if (buf[b * UT_BLOCK_SIZE + i] != (uint8_t)(start_lba + b)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static struct spdk_nvmf_ns_cache *
+ut_cache_create(uint64_t size_mb, uint32_t line_size)
+{
+	struct spdk_nvmf_ns_cache_opts opts = {
+		.size_mb = size_mb,
+		.line_size = line_size,
+	};
+
+	return spdk_nvmf_ns_cache_create(&opts, UT_BLOCK_SIZE);
+}
+
+static void
+test_ns_cache_hit_miss(void)
+{
+	struct spdk_nvmf_ns_cache *cache;
+	struct spdk_nvmf_ns_cache_hold *hold;
+	struct spdk_nvmf_ns_cache_stats stats;
+	struct ut_req ureq;
+
+	cache = ut_cache_create(1, UT_LINE_SIZE);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+	CU_ASSERT(cache->num_shards == 4);
+	CU_ASSERT(cache->total_lines == 256);
+	CU_ASSERT(spdk_nvmf_ns_cache_get_line_blocks(cache) == UT_LINE_BLOCKS);
+
+	/* Blocks 4-11 straddle lines 0 and 1, both are missing */
+	ut_req_init(&ureq, 8 * UT_BLOCK_SIZE);
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 4, 8, &ureq.req);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	CU_ASSERT(spdk_nvmf_ns_cache_hold_get_ctx(hold) == &ureq.req);
+	CU_ASSERT(spdk_nvmf_ns_cache_hold_get_num_lines(hold) == 2);
+	CU_ASSERT(ut_hold_num_fills(hold) == 2);
+	CU_ASSERT(!spdk_nvmf_ns_cache_hold_is_valid(hold));
+
+	/* Reads of lines being filled bypass the cache */
+	CU_ASSERT(spdk_nvmf_ns_cache_hold_get(cache, 8, 1, NULL) == NULL);
+
+	ut_fill_lines(hold, true);
+	CU_ASSERT(spdk_nvmf_ns_cache_hold_is_valid(hold));
+	spdk_nvmf_ns_cache_request_serve(&ureq.req, hold, 4, 8);
+	CU_ASSERT(ureq.req.cache_hold == NULL);
+	CU_ASSERT(ureq.req.iovcnt == 2);
+	CU_ASSERT(ut_data_matches(ureq.buf, 4, 8));
+
+	/* Now it hits */
+	ut_req_init(&ureq, 3 * UT_BLOCK_SIZE);
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 9, 3, &ureq.req);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	CU_ASSERT(ut_hold_num_fills(hold) == 0);
+	CU_ASSERT(spdk_nvmf_ns_cache_hold_is_valid(hold));
+	spdk_nvmf_ns_cache_request_serve(&ureq.req, hold, 9, 3);
+	CU_ASSERT(ut_data_matches(ureq.buf, 9, 3));
+
+	/* A failed fill leaves nothing behind */
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 64, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	ut_fill_lines(hold, false);
+	CU_ASSERT(!spdk_nvmf_ns_cache_hold_is_valid(hold));
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	/* Reads spanning more lines than a request has buffers bypass the cache */
+	CU_ASSERT(spdk_nvmf_ns_cache_hold_get(cache, 0, (NVMF_REQ_MAX_BUFFERS + 1) * UT_LINE_BLOCKS,
+					      NULL) == NULL);
+
+	spdk_nvmf_ns_cache_get_stats(cache, &stats);
+	CU_ASSERT(stats.hits == 1);
+	CU_ASSERT(stats.misses == 2);
+	CU_ASSERT(stats.bypassed == 2);
+	CU_ASSERT(stats.fills == 2);
+	CU_ASSERT(stats.evictions == 0);
+	CU_ASSERT(stats.lines == 2);
+	CU_ASSERT(stats.bytes == 2 * UT_LINE_SIZE);
+
+	spdk_nvmf_ns_cache_destroy(cache);
+}
+
+static void
+test_ns_cache_zcopy(void)
+{
+	struct spdk_nvmf_ns_cache *cache;
+	struct spdk_nvmf_ns_cache_hold *hold;
+	struct spdk_nvmf_ns_cache_stats stats;
+	struct ut_req ureq;
+	uint64_t lba;
+	uint32_t i;
+
+	cache = ut_cache_create(1, UT_LINE_SIZE);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 0, 3 * UT_LINE_BLOCKS, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	/* The iov points straight into the three lines covering the read */
+	ut_req_init(&ureq, 2 * UT_LINE_SIZE);
+	ureq.req.cache_zcopy = true;
+	hold = spdk_nvmf_ns_cache_hold_get(cache, UT_LINE_BLOCKS / 2, 2 * UT_LINE_BLOCKS, &ureq.req);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	spdk_nvmf_ns_cache_request_serve(&ureq.req, hold, UT_LINE_BLOCKS / 2, 2 * UT_LINE_BLOCKS);
+	CU_ASSERT(ureq.req.cache_hold == hold);
+	CU_ASSERT(ureq.req.iovcnt == 3);
+	CU_ASSERT(ureq.req.iov[0].iov_len == UT_LINE_SIZE / 2);
+	CU_ASSERT(ureq.req.iov[1].iov_len == UT_LINE_SIZE);
+	CU_ASSERT(ureq.req.iov[2].iov_len == UT_LINE_SIZE / 2);
+	lba = UT_LINE_BLOCKS / 2;
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(ut_data_matches(ureq.req.iov[i].iov_base, lba,
+					  ureq.req.iov[i].iov_len / UT_BLOCK_SIZE));
+		lba += ureq.req.iov[i].iov_len / UT_BLOCK_SIZE;
+	}
+
+	/* Pinned lines are not evicted or reused, even when invalidated */
+	spdk_nvmf_ns_cache_purge(cache);
+	CU_ASSERT(ut_data_matches(ureq.req.iov[1].iov_base, UT_LINE_BLOCKS, UT_LINE_BLOCKS));
+	spdk_nvmf_ns_cache_get_stats(cache, &stats);
+	CU_ASSERT(stats.lines == 0);
+	CU_ASSERT(stats.invalidations == 3);
+
+	spdk_nvmf_ns_cache_request_release(&ureq.req);
+	CU_ASSERT(ureq.req.cache_hold == NULL);
+	CU_ASSERT(ureq.req.iovcnt == 2);
+
+	/* Released twice is harmless */
+	spdk_nvmf_ns_cache_request_release(&ureq.req);
+
+	for (i = 0; i < cache->num_shards; i++) {
+		CU_ASSERT(TAILQ_EMPTY(&cache->shards[i].lru));
+	}
+
+	spdk_nvmf_ns_cache_destroy(cache);
+}
+
+static void
+test_ns_cache_invalidate(void)
+{
+	struct spdk_nvmf_ns_cache *cache;
+	struct spdk_nvmf_ns_cache_hold *hold, *pinned;
+	struct spdk_nvmf_ns_cache_stats stats;
+	struct spdk_nvme_dsm_range ranges[2];
+	struct ut_req ureq;
+
+	cache = ut_cache_create(1, UT_LINE_SIZE);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 0, 8 * UT_LINE_BLOCKS, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	/* A write to line 1 drops only that line */
+	ut_req_init(&ureq, UT_BLOCK_SIZE);
+	ureq.cmd.nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
+	ureq.cmd.nvme_cmd.cdw10 = UT_LINE_BLOCKS + 1;
+	ureq.cmd.nvme_cmd.cdw12 = 0;
+	spdk_nvmf_ns_cache_invalidate_cmd(cache, &ureq.req);
+	spdk_nvmf_ns_cache_get_stats(cache, &stats);
+	CU_ASSERT(stats.lines == 7);
+	CU_ASSERT(stats.invalidations == 1);
+
+	hold = spdk_nvmf_ns_cache_hold_get(cache, UT_LINE_BLOCKS, UT_LINE_BLOCKS * 2, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	CU_ASSERT(ut_hold_num_fills(hold) == 1);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	/* Reads and flushes leave the cache alone */
+	ureq.cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
+	spdk_nvmf_ns_cache_invalidate_cmd(cache, &ureq.req);
+	ureq.cmd.nvme_cmd.opc = SPDK_NVME_OPC_FLUSH;
+	spdk_nvmf_ns_cache_invalidate_cmd(cache, &ureq.req);
+	spdk_nvmf_ns_cache_get_stats(cache, &stats);
+	CU_ASSERT(stats.lines == 8);
+
+	/* Deallocate drops the lines of each range */
+	ranges[0].starting_lba = 2 * UT_LINE_BLOCKS;
+	ranges[0].length = 1;
+	ranges[1].starting_lba = 4 * UT_LINE_BLOCKS - 1;
+	ranges[1].length = 2;
+	ureq.req.data = ranges;
+	ureq.req.length = sizeof(ranges);
+	ureq.cmd.nvme_cmd.opc = SPDK_NVME_OPC_DATASET_MANAGEMENT;
+	ureq.cmd.nvme_cmd.cdw10 = 1;
+	ureq.cmd.nvme_cmd.cdw11 = SPDK_NVME_DSM_ATTR_DEALLOCATE;
+	spdk_nvmf_ns_cache_invalidate_cmd(cache, &ureq.req);
+	spdk_nvmf_ns_cache_get_stats(cache, &stats);
+	CU_ASSERT(stats.lines == 5);
+
+	/* A line being filled when it is written is not cached */
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 2 * UT_LINE_BLOCKS, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	spdk_nvmf_ns_cache_invalidate(cache, 2 * UT_LINE_BLOCKS, UT_LINE_BLOCKS);
+	ut_fill_lines(hold, true);
+	CU_ASSERT(spdk_nvmf_ns_cache_hold_is_valid(hold));
+	spdk_nvmf_ns_cache_hold_put(hold);
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 2 * UT_LINE_BLOCKS, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	CU_ASSERT(ut_hold_num_fills(hold) == 1);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	/* A pinned line is dropped from the hash right away, and reused once released */
+	pinned = spdk_nvmf_ns_cache_hold_get(cache, 0, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(pinned != NULL);
+	CU_ASSERT(ut_hold_num_fills(pinned) == 0);
+	spdk_nvmf_ns_cache_invalidate(cache, 0, 1);
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 0, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	CU_ASSERT(ut_hold_num_fills(hold) == 1);
+	CU_ASSERT(hold->lines[0] != pinned->lines[0]);
+	CU_ASSERT(pinned->lines[0]->stale);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_hold_put(hold);
+	spdk_nvmf_ns_cache_hold_put(pinned);
+
+	/* Ranges larger than the cache scan the lines instead */
+	spdk_nvmf_ns_cache_invalidate(cache, 0, UINT64_MAX);
+	spdk_nvmf_ns_cache_get_stats(cache, &stats);
+	CU_ASSERT(stats.lines == 0);
+
+	/* Unknown commands may change anything */
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 0, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_hold_put(hold);
+	ureq.cmd.nvme_cmd.opc = 0x80;
+	spdk_nvmf_ns_cache_invalidate_cmd(cache, &ureq.req);
+	spdk_nvmf_ns_cache_get_stats(cache, &stats);
+	CU_ASSERT(stats.lines == 0);
+
+	spdk_nvmf_ns_cache_destroy(cache);
+}
+
+static void
+test_ns_cache_eviction(void)
+{
+	struct spdk_nvmf_ns_cache *cache;
+	struct spdk_nvmf_ns_cache_hold *hold, *holds[4];
+	struct spdk_nvmf_ns_cache_stats stats;
+	uint32_t i;
+
+	/* A single shard of four lines */
+	MOCK_SET(spdk_env_get_core_count, 1);
+	cache = ut_cache_create(1, 256 * 1024);
+	MOCK_SET(spdk_env_get_core_count, 4);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+	CU_ASSERT(cache->num_shards == 1);
+	CU_ASSERT(cache->total_lines == 4);
+
+	for (i = 0; i < 4; i++) {
+		hold = spdk_nvmf_ns_cache_hold_get(cache, i * 512, 1, NULL);
+		SPDK_CU_ASSERT_FATAL(hold != NULL);
+		CU_ASSERT(ut_hold_num_fills(hold) == 1);
+		ut_fill_lines(hold, true);
+		spdk_nvmf_ns_cache_hold_put(hold);
+	}
+
+	/* Touch line 0 so that line 1 is the least recently used */
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 0, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	CU_ASSERT(ut_hold_num_fills(hold) == 0);
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 4 * 512, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 0, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	CU_ASSERT(ut_hold_num_fills(hold) == 0);
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 1 * 512, 1, NULL);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	CU_ASSERT(ut_hold_num_fills(hold) == 1);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_hold_put(hold);
+
+	/* With every line pinned there is nothing to evict */
+	for (i = 0; i < 4; i++) {
+		holds[i] = spdk_nvmf_ns_cache_hold_get(cache, (10 + i) * 512, 1, NULL);
+		SPDK_CU_ASSERT_FATAL(holds[i] != NULL);
+	}
+	CU_ASSERT(spdk_nvmf_ns_cache_hold_get(cache, 20 * 512, 1, NULL) == NULL);
+	for (i = 0; i < 4; i++) {
+		ut_fill_lines(holds[i], true);
+		spdk_nvmf_ns_cache_hold_put(holds[i]);
+	}
+
+	spdk_nvmf_ns_cache_get_stats(cache, &stats);
+	CU_ASSERT(stats.evictions == 6);
+	CU_ASSERT(stats.bypassed == 1);
+	CU_ASSERT(stats.lines == 4);
+
+	spdk_nvmf_ns_cache_destroy(cache);
+}
+
+static void
+test_ns_cache_destroy_with_holds(void)
+{
+	struct spdk_nvmf_ns_cache *cache;
+	struct spdk_nvmf_ns_cache_hold *hold;
+	struct ut_req ureq;
+
+	cache = ut_cache_create(1, UT_LINE_SIZE);
+	SPDK_CU_ASSERT_FATAL(cache != NULL);
+
+	ut_req_init(&ureq, UT_LINE_SIZE);
+	ureq.req.cache_zcopy = true;
+	hold = spdk_nvmf_ns_cache_hold_get(cache, 0, UT_LINE_BLOCKS, &ureq.req);
+	SPDK_CU_ASSERT_FATAL(hold != NULL);
+	ut_fill_lines(hold, true);
+	spdk_nvmf_ns_cache_request_serve(&ureq.req, hold, 0, UT_LINE_BLOCKS);
+	CU_ASSERT(cache->ref == 2);
+
+	/* The data stays valid until the request lets go of it */
+	spdk_nvmf_ns_cache_destroy(cache);
+	CU_ASSERT(ut_data_matches(ureq.req.iov[0].iov_base, 0, UT_LINE_BLOCKS));
+	spdk_nvmf_ns_cache_request_release(&ureq.req);
+	CU_ASSERT(ureq.req.cache_hold == NULL);
+
+	/* Cache sizes that don't fit a line are refused */
+	CU_ASSERT(ut_cache_create(1, 2 * 1024 * 1024) == NULL);
+}
+
+int main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	if (CU_initialize_registry() != CUE_SUCCESS) {
+		return CU_get_error();
+	}
+
+	suite = CU_add_suite("nvmf", NULL, NULL);
+	if (suite == NULL) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	if (
+		CU_add_test(suite, "ns_cache_hit_miss", test_ns_cache_hit_miss) == NULL ||
+		CU_add_test(suite, "ns_cache_zcopy", test_ns_cache_zcopy) == NULL ||
+		CU_add_test(suite, "ns_cache_invalidate", test_ns_cache_invalidate) == NULL ||
+		CU_add_test(suite, "ns_cache_eviction", test_ns_cache_eviction) == NULL ||
+		CU_add_test(suite, "ns_cache_destroy_with_holds", test_ns_cache_destroy_with_holds) == NULL
+	) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	allocate_threads(1);
+	set_thread(0);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+
+	free_threads();
+
+	CU_cleanup_registry();
+	return num_failures;
+}
@@ -0,0 +1,416 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "common/lib/ut_multithread.c"
+#include "spdk_cunit.h"
+#include "spdk_internal/mock.h"
+
+#include "nvmf/ns_sched.c"
+
+#define UT_MAX_REQS	16
+
+static struct spdk_nvmf_request *g_exec_reqs[UT_MAX_REQS];
+static uint32_t g_num_exec_reqs;
+static struct spdk_nvmf_request *g_completed_req;
+/* Complete the scheduled requests as soon as they are executed */
+static struct spdk_nvmf_ns_sched *g_complete_inline_sched;
+
+void
+spdk_nvmf_request_exec_scheduled(struct spdk_nvmf_request *req)
+{
+	SPDK_CU_ASSERT_FATAL(g_num_exec_reqs < UT_MAX_REQS);
+	g_exec_reqs[g_num_exec_reqs++] = req;
+
+	if (g_complete_inline_sched != NULL) {
+		spdk_nvmf_ns_sched_request_done(g_complete_inline_sched, req);
+	}
+}
+
+int
+spdk_nvmf_request_complete(struct spdk_nvmf_request *req)
+{
+	g_completed_req = req;
+	return 0;
+}
+
+struct ut_host {
+	struct spdk_nvmf_ctrlr		ctrlr;
+	struct spdk_nvmf_qpair		qpair;
+	struct spdk_nvmf_request	reqs[UT_MAX_REQS];
+	union nvmf_c2h_msg		rsps[UT_MAX_REQS];
+};
+
+static void
+ut_host_init(struct ut_host *host, const char *hostnqn, uint32_t ab)
+{
+	uint32_t i;
+
+	memset(host, 0, sizeof(*host));
+	snprintf(host->ctrlr.hostnqn, sizeof(host->ctrlr.hostnqn), "%s", hostnqn);
+	host->ctrlr.feat.arbitration.bits.ab = ab;
+	host->qpair.ctrlr = &host->ctrlr;
+	host->qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+
+	for (i = 0; i < UT_MAX_REQS; i++) {
+		host->reqs[i].qpair = &host->qpair;
+		host->reqs[i].rsp = &host->rsps[i];
+		host->reqs[i].length = 4096;
+	}
+}
+
+static void
+ut_reset(void)
+{
+	g_num_exec_reqs = 0;
+	g_completed_req = NULL;
+	g_complete_inline_sched = NULL;
+}
+
+static void
+ut_sched_conf_init(struct spdk_nvmf_ns_sched_conf *conf, uint32_t max_outstanding)
+{
+	memset(conf, 0, sizeof(*conf));
+	conf->opts.enabled = true;
+	conf->opts.max_outstanding = max_outstanding;
+	conf->num_poll_groups = 1;
+}
+
+static void
+test_ns_sched_weighted_fairness(void)
+{
+	struct spdk_nvmf_ns_sched_conf conf;
+	struct spdk_nvmf_ns_sched_host hosts[2] = {};
+	struct spdk_nvmf_ns_sched *sched;
+	struct ut_host *a, *b;
+	uint32_t i;
+
+	a = calloc(1, sizeof(*a));
+	b = calloc(1, sizeof(*b));
+	SPDK_CU_ASSERT_FATAL(a != NULL && b != NULL);
+	ut_host_init(a, "nqn.2016-06.io.spdk:host_a", 0);
+	ut_host_init(b, "nqn.2016-06.io.spdk:host_b", 0);
+	ut_reset();
+
+	/* Host A gets twice the share of host B */
+	ut_sched_conf_init(&conf, 1);
+	snprintf(hosts[0].hostnqn, sizeof(hosts[0].hostnqn), "%s", a->ctrlr.hostnqn);
+	hosts[0].opts.weight = 2;
+	conf.hosts = hosts;
+	conf.num_hosts = 1;
+	sched = spdk_nvmf_ns_sched_create(&conf);
+	SPDK_CU_ASSERT_FATAL(sched != NULL);
+
+	/* The first request finds a free slot and runs right away */
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[0]) == true);
+	CU_ASSERT(a->reqs[0].sched_flow != NULL);
+	CU_ASSERT(sched->outstanding == 1);
+
+	for (i = 1; i < 7; i++) {
+		CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[i]) == false);
+	}
+	for (i = 0; i < 6; i++) {
+		CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &b->reqs[i]) == false);
+	}
+	CU_ASSERT(g_num_exec_reqs == 0);
+
+	/* Each completion dispatches the next request, two of A for each of B */
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[0]);
+	CU_ASSERT(a->reqs[0].sched_flow == NULL);
+	for (i = 0; i < 8; i++) {
+		SPDK_CU_ASSERT_FATAL(g_num_exec_reqs == i + 1);
+		spdk_nvmf_ns_sched_request_done(sched, g_exec_reqs[i]);
+	}
+
+	CU_ASSERT(g_exec_reqs[0] == &a->reqs[1]);
+	CU_ASSERT(g_exec_reqs[1] == &a->reqs[2]);
+	CU_ASSERT(g_exec_reqs[2] == &b->reqs[0]);
+	CU_ASSERT(g_exec_reqs[3] == &a->reqs[3]);
+	CU_ASSERT(g_exec_reqs[4] == &a->reqs[4]);
+	CU_ASSERT(g_exec_reqs[5] == &b->reqs[1]);
+	CU_ASSERT(g_exec_reqs[6] == &a->reqs[5]);
+	CU_ASSERT(g_exec_reqs[7] == &a->reqs[6]);
+
+	/* A has nothing left queued, so B takes all the slots */
+	CU_ASSERT(g_num_exec_reqs == 9);
+	CU_ASSERT(g_exec_reqs[8] == &b->reqs[2]);
+
+	/* Completing inline keeps dispatching from the same loop */
+	g_complete_inline_sched = sched;
+	spdk_nvmf_ns_sched_request_done(sched, g_exec_reqs[8]);
+	CU_ASSERT(g_num_exec_reqs == 12);
+	CU_ASSERT(g_exec_reqs[11] == &b->reqs[5]);
+	CU_ASSERT(sched->outstanding == 0);
+	CU_ASSERT(TAILQ_EMPTY(&sched->active));
+
+	spdk_nvmf_ns_sched_destroy(sched);
+	free(a);
+	free(b);
+}
+
+static void
+test_ns_sched_arbitration_burst(void)
+{
+	struct spdk_nvmf_ns_sched_conf conf;
+	struct spdk_nvmf_ns_sched *sched;
+	struct ut_host *a, *b;
+	uint32_t i;
+
+	a = calloc(1, sizeof(*a));
+	b = calloc(1, sizeof(*b));
+	SPDK_CU_ASSERT_FATAL(a != NULL && b != NULL);
+	/* Host A set an arbitration burst of 4 commands, host B of 1 */
+	ut_host_init(a, "nqn.2016-06.io.spdk:host_a", 2);
+	ut_host_init(b, "nqn.2016-06.io.spdk:host_b", 0);
+	ut_reset();
+
+	ut_sched_conf_init(&conf, 1);
+	sched = spdk_nvmf_ns_sched_create(&conf);
+	SPDK_CU_ASSERT_FATAL(sched != NULL);
+
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &b->reqs[0]) == true);
+	for (i = 0; i < 8; i++) {
+		CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[i]) == false);
+	}
+	for (i = 1; i < 3; i++) {
+		CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &b->reqs[i]) == false);
+	}
+
+	g_complete_inline_sched = sched;
+	spdk_nvmf_ns_sched_request_done(sched, &b->reqs[0]);
+	SPDK_CU_ASSERT_FATAL(g_num_exec_reqs == 10);
+
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT(g_exec_reqs[i] == &a->reqs[i]);
+	}
+	CU_ASSERT(g_exec_reqs[4] == &b->reqs[1]);
+	for (i = 4; i < 8; i++) {
+		CU_ASSERT(g_exec_reqs[i + 1] == &a->reqs[i]);
+	}
+	CU_ASSERT(g_exec_reqs[9] == &b->reqs[2]);
+
+	/* An arbitration burst of 111b means no limit */
+	ut_host_init(a, "nqn.2016-06.io.spdk:host_a", 7);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[0]) == true);
+	CU_ASSERT(a->reqs[0].sched_flow->burst == NVMF_NS_SCHED_MAX_BURST);
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[0]);
+
+	spdk_nvmf_ns_sched_destroy(sched);
+	free(a);
+	free(b);
+}
+
+static void
+test_ns_sched_rate_limit(void)
+{
+	struct spdk_nvmf_ns_sched_conf conf;
+	struct spdk_nvmf_ns_sched_host host = {};
+	struct spdk_nvmf_ns_sched *sched;
+	struct spdk_nvmf_ns_sched_host_stat *stats = NULL;
+	uint32_t num_stats = 0;
+	struct ut_host *a;
+	uint32_t i;
+
+	a = calloc(1, sizeof(*a));
+	SPDK_CU_ASSERT_FATAL(a != NULL);
+	ut_host_init(a, "nqn.2016-06.io.spdk:host_a", 0);
+	ut_reset();
+
+	/* 2 I/O per 1 ms timeslice, split across 2 poll groups */
+	ut_sched_conf_init(&conf, 0);
+	conf.num_poll_groups = 2;
+	snprintf(host.hostnqn, sizeof(host.hostnqn), "%s", a->ctrlr.hostnqn);
+	host.opts.rw_ios_per_sec = 4000;
+	conf.hosts = &host;
+	conf.num_hosts = 1;
+	sched = spdk_nvmf_ns_sched_create(&conf);
+	SPDK_CU_ASSERT_FATAL(sched != NULL);
+
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[0]) == true);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[1]) == true);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[2]) == false);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[3]) == false);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[4]) == false);
+
+	/* Completions don't help, only the next timeslice does */
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[0]);
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[1]);
+	CU_ASSERT(g_num_exec_reqs == 0);
+	CU_ASSERT(a->reqs[2].sched_flow->throttled == true);
+
+	spdk_delay_us(NVMF_NS_SCHED_TIMESLICE_USEC);
+	poll_threads();
+	CU_ASSERT(g_num_exec_reqs == 2);
+	CU_ASSERT(g_exec_reqs[0] == &a->reqs[2]);
+	CU_ASSERT(g_exec_reqs[1] == &a->reqs[3]);
+
+	spdk_delay_us(NVMF_NS_SCHED_TIMESLICE_USEC);
+	poll_threads();
+	CU_ASSERT(g_num_exec_reqs == 3);
+	CU_ASSERT(g_exec_reqs[2] == &a->reqs[4]);
+
+	spdk_nvmf_ns_sched_get_stats(sched, &stats, &num_stats);
+	SPDK_CU_ASSERT_FATAL(num_stats == 1);
+	CU_ASSERT(strcmp(stats[0].hostnqn, a->ctrlr.hostnqn) == 0);
+	CU_ASSERT(stats[0].ios == 5);
+	CU_ASSERT(stats[0].queued_ios == 3);
+	CU_ASSERT(stats[0].throttled_ios == 3);
+	CU_ASSERT(stats[0].queue_depth == 0);
+	/* The last request waited two timeslices, at one tick per microsecond */
+	CU_ASSERT(stats[0].max_queue_ticks == 2 * NVMF_NS_SCHED_TIMESLICE_USEC);
+	CU_ASSERT(stats[0].queue_ticks == 4 * NVMF_NS_SCHED_TIMESLICE_USEC);
+	free(stats);
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[2]);
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[3]);
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[4]);
+
+	/* A byte limit lets a large I/O through and holds the next one until the debt is paid */
+	host.opts.rw_ios_per_sec = 0;
+	host.opts.rw_mbytes_per_sec = 1;
+	conf.num_poll_groups = 1;
+	CU_ASSERT(spdk_nvmf_ns_sched_update(sched, &conf) == 0);
+	ut_reset();
+
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[5]) == true);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched, &a->reqs[6]) == false);
+	for (i = 0; i < 2; i++) {
+		spdk_delay_us(NVMF_NS_SCHED_TIMESLICE_USEC);
+		poll_threads();
+		CU_ASSERT(g_num_exec_reqs == 0);
+	}
+	spdk_delay_us(NVMF_NS_SCHED_TIMESLICE_USEC);
+	poll_threads();
+	CU_ASSERT(g_num_exec_reqs == 1);
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[5]);
+	spdk_nvmf_ns_sched_request_done(sched, &a->reqs[6]);
+
+	spdk_nvmf_ns_sched_destroy(sched);
+	poll_threads();
+	free(a);
+}
+
+static void
+test_ns_sched_abort_and_stats(void)
+{
+	struct spdk_nvmf_ns_sched_conf conf;
+	struct spdk_nvmf_ns_sched *sched[2];
+	struct spdk_nvmf_ns_sched_host_stat *stats = NULL;
+	uint32_t num_stats = 0;
+	struct ut_host *a, *b;
+
+	a = calloc(1, sizeof(*a));
+	b = calloc(1, sizeof(*b));
+	SPDK_CU_ASSERT_FATAL(a != NULL && b != NULL);
+	ut_host_init(a, "nqn.2016-06.io.spdk:host_a", 0);
+	ut_host_init(b, "nqn.2016-06.io.spdk:host_b", 0);
+	ut_reset();
+
+	ut_sched_conf_init(&conf, 1);
+	sched[0] = spdk_nvmf_ns_sched_create(&conf);
+	sched[1] = spdk_nvmf_ns_sched_create(&conf);
+	SPDK_CU_ASSERT_FATAL(sched[0] != NULL && sched[1] != NULL);
+
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched[0], &b->reqs[0]) == true);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched[0], &a->reqs[0]) == false);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched[0], &b->reqs[1]) == false);
+	CU_ASSERT(spdk_nvmf_ns_sched_submit(sched[1], &a->reqs[1]) == true);
+
+	/* The queued request of a disconnecting queue pair is aborted, not executed */
+	a->qpair.state = SPDK_NVMF_QPAIR_DEACTIVATING;
+	spdk_nvmf_ns_sched_request_done(sched[0], &b->reqs[0]);
+	CU_ASSERT(g_completed_req == &a->reqs[0]);
+	CU_ASSERT(a->reqs[0].sched_flow == NULL);
+	CU_ASSERT(a->rsps[0].nvme_cpl.status.sc == SPDK_NVME_SC_ABORTED_SQ_DELETION);
+	CU_ASSERT(g_num_exec_reqs == 1);
+	CU_ASSERT(g_exec_reqs[0] == &b->reqs[1]);
+	CU_ASSERT(sched[0]->outstanding == 1);
+
+	/* The statistics of both poll groups are merged by host */
+	CU_ASSERT(spdk_nvmf_ns_sched_get_stats(sched[0], &stats, &num_stats) == 0);
+	CU_ASSERT(spdk_nvmf_ns_sched_get_stats(sched[1], &stats, &num_stats) == 0);
+	SPDK_CU_ASSERT_FATAL(num_stats == 2);
+	CU_ASSERT(strcmp(stats[0].hostnqn, b->ctrlr.hostnqn) == 0);
+	CU_ASSERT(stats[0].ios == 2);
+	CU_ASSERT(stats[0].queued_ios == 1);
+	CU_ASSERT(strcmp(stats[1].hostnqn, a->ctrlr.hostnqn) == 0);
+	CU_ASSERT(stats[1].ios == 1);
+	CU_ASSERT(stats[1].queued_ios == 1);
+	CU_ASSERT(stats[1].throttled_ios == 0);
+	free(stats);
+
+	spdk_nvmf_ns_sched_request_done(sched[0], &b->reqs[1]);
+	spdk_nvmf_ns_sched_request_done(sched[1], &a->reqs[1]);
+	spdk_nvmf_ns_sched_destroy(sched[0]);
+	spdk_nvmf_ns_sched_destroy(sched[1]);
+	free(a);
+	free(b);
+}
+
+int main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	if (CU_initialize_registry() != CUE_SUCCESS) {
+		return CU_get_error();
+	}
+
+	suite = CU_add_suite("nvmf", NULL, NULL);
+	if (suite == NULL) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	if (
+		CU_add_test(suite, "ns_sched_weighted_fairness", test_ns_sched_weighted_fairness) == NULL ||
+		CU_add_test(suite, "ns_sched_arbitration_burst", test_ns_sched_arbitration_burst) == NULL ||
+		CU_add_test(suite, "ns_sched_rate_limit", test_ns_sched_rate_limit) == NULL ||
+		CU_add_test(suite, "ns_sched_abort_and_stats", test_ns_sched_abort_and_stats) == NULL
+	) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	allocate_threads(1);
+	set_thread(0);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+
+	free_threads();
+
+	CU_cleanup_registry();
+	return num_failures;
+}
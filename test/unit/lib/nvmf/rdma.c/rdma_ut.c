@@ -75,6 +75,8 @@ DEFINE_STUB_V(spdk_nvmf_request_exec, (struct spdk_nvmf_request *req));
 DEFINE_STUB(spdk_nvme_transport_id_compare, int, (const struct spdk_nvme_transport_id *trid1,
 		const struct spdk_nvme_transport_id *trid2), 0);
 DEFINE_STUB_V(spdk_nvmf_ctrlr_abort_aer, (struct spdk_nvmf_ctrlr *ctrlr));
+DEFINE_STUB(spdk_nvmf_transport_calc_buf_cache_max, int,
+	    (const struct spdk_nvmf_transport_opts *opts, uint32_t *buf_cache_max), 0);
 
 void
 spdk_nvmf_request_free_buffers(struct spdk_nvmf_request *req,
@@ -623,6 +625,8 @@ test_spdk_nvmf_rdma_request_process(void)
 	CU_ASSERT(rqpair.sends_to_post.last == &rdma_req->rsp.wr);
 	CU_ASSERT(resources.recvs_to_post.first == &rdma_recv->wr);
 	CU_ASSERT(resources.recvs_to_post.last == &rdma_recv->wr);
+	CU_ASSERT((rdma_req->data.wr.send_flags & IBV_SEND_INLINE) == 0);
+	CU_ASSERT((rdma_req->rsp.wr.send_flags & IBV_SEND_INLINE) == 0);
 	/* COMPLETED -> FREE */
 	rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
 	progress = spdk_nvmf_rdma_request_process(&rtransport, rdma_req);
@@ -747,6 +751,38 @@ test_spdk_nvmf_rdma_request_process(void)
 		qpair_reset(&rqpair, &poller, &port, &resources);
 	}
 
+	/* Test 4: small READ data and the response are sent inline */
+	rqpair.max_inline_data = 64;
+	rdma_recv = create_recv(&rqpair, SPDK_NVME_OPC_READ);
+	rdma_req = create_req(&rqpair, rdma_recv);
+	rqpair.current_recv_depth = 1;
+	/* NEW -> EXECUTING */
+	progress = spdk_nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(progress == true);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_EXECUTING);
+	/* EXECUTED -> TRANSFERRING_C2H */
+	rdma_req->state = RDMA_REQUEST_STATE_EXECUTED;
+	progress = spdk_nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(progress == true);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST);
+	CU_ASSERT(rqpair.sends_to_post.first == &rdma_req->data.wr);
+	CU_ASSERT(rqpair.sends_to_post.last == &rdma_req->rsp.wr);
+	CU_ASSERT(rdma_req->data.wr.send_flags & IBV_SEND_INLINE);
+	CU_ASSERT(rdma_req->rsp.wr.send_flags & IBV_SEND_INLINE);
+	CU_ASSERT(poller.stat.inline_data_wrs == 1);
+	CU_ASSERT(poller.stat.send_wrs == 2);
+	/* COMPLETED -> FREE */
+	rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
+	progress = spdk_nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(progress == true);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_FREE);
+	CU_ASSERT((rdma_req->data.wr.send_flags & IBV_SEND_INLINE) == 0);
+
+	free_recv(rdma_recv);
+	free_req(rdma_req);
+	poller_reset(&poller, &group);
+	qpair_reset(&rqpair, &poller, &port, &resources);
+
 	spdk_mempool_free(rtransport.transport.data_buf_pool);
 	spdk_mempool_free(rtransport.data_wr_pool);
 }
@@ -64,6 +64,17 @@ DEFINE_STUB(spdk_nvmf_transport_stop_listen,
 	    (struct spdk_nvmf_transport *transport,
 	     const struct spdk_nvme_transport_id *trid), 0);
 
+DEFINE_STUB(spdk_nvmf_ns_sched_get_stats, int,
+	    (struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_ns_sched_host_stat **stats,
+	     uint32_t *num_stats), 0);
+
+DEFINE_STUB(spdk_nvmf_ns_cache_create, struct spdk_nvmf_ns_cache *,
+	    (const struct spdk_nvmf_ns_cache_opts *opts, uint32_t block_size), NULL);
+DEFINE_STUB_V(spdk_nvmf_ns_cache_destroy, (struct spdk_nvmf_ns_cache *cache));
+DEFINE_STUB_V(spdk_nvmf_ns_cache_purge, (struct spdk_nvmf_ns_cache *cache));
+DEFINE_STUB_V(spdk_nvmf_ns_cache_get_stats,
+	      (struct spdk_nvmf_ns_cache *cache, struct spdk_nvmf_ns_cache_stats *stats));
+
 struct spdk_event *
 spdk_event_allocate(uint32_t core, spdk_event_fn fn, void *arg1, void *arg2)
 {
@@ -91,6 +102,14 @@ spdk_nvmf_transport_listener_discover(struct spdk_nvmf_transport *transport,
 	entry->trtype = 42;
 }
 
+static uint32_t g_discovery_updates;
+
+void
+spdk_nvmf_update_discovery_log(struct spdk_nvmf_tgt *tgt)
+{
+	g_discovery_updates++;
+}
+
 static struct spdk_nvmf_transport g_transport = {};
 
 struct spdk_nvmf_transport *
@@ -156,6 +175,21 @@ spdk_nvmf_poll_group_resume_subsystem(struct spdk_nvmf_poll_group *group,
 {
 }
 
+static spdk_nvmf_poll_group_mod_done g_remove_ns_cb_fn;
+static void *g_remove_ns_cb_arg;
+static uint32_t g_remove_ns_nsid;
+
+void
+spdk_nvmf_poll_group_remove_ns(struct spdk_nvmf_poll_group *group,
+			       struct spdk_nvmf_subsystem *subsystem, uint32_t nsid,
+			       spdk_nvmf_poll_group_mod_done cb_fn, void *cb_arg)
+{
+	/* Pretend I/O is still outstanding, the test completes the removal. */
+	g_remove_ns_nsid = nsid;
+	g_remove_ns_cb_fn = cb_fn;
+	g_remove_ns_cb_arg = cb_arg;
+}
+
 int
 spdk_nvme_transport_id_parse_trtype(enum spdk_nvme_transport_type *trtype, const char *str)
 {
@@ -203,9 +237,18 @@ spdk_nvmf_ctrlr_destruct(struct spdk_nvmf_ctrlr *ctrlr)
 {
 }
 
+static uint32_t g_ns_changed_count;
+
 void
 spdk_nvmf_ctrlr_ns_changed(struct spdk_nvmf_ctrlr *ctrlr, uint32_t nsid)
 {
+	g_ns_changed_count++;
+}
+
+int
+spdk_nvmf_ctrlr_async_event_ana_change_notice(struct spdk_nvmf_ctrlr *ctrlr)
+{
+	return 0;
 }
 
 int
@@ -292,6 +335,396 @@ test_spdk_nvmf_subsystem_add_ns(void)
 	free(tgt.subsystems);
 }
 
+static void
+test_spdk_nvmf_subsystem_set_ns_cache(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem subsystem = {
+		.max_nsid = 0,
+		.ns = NULL,
+		.tgt = &tgt,
+		.state = SPDK_NVMF_SUBSYSTEM_INACTIVE
+	};
+	struct spdk_bdev bdev = {};
+	struct spdk_nvmf_ns_opts ns_opts;
+	struct spdk_nvmf_ns_cache_opts opts = {};
+	struct spdk_nvmf_ns_cache_stats stats;
+	struct spdk_nvmf_ns *ns;
+	uint32_t nsid;
+
+	tgt.max_subsystems = 1024;
+	tgt.subsystems = calloc(tgt.max_subsystems, sizeof(struct spdk_nvmf_subsystem *));
+	SPDK_CU_ASSERT_FATAL(tgt.subsystems != NULL);
+
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	nsid = spdk_nvmf_subsystem_add_ns(&subsystem, &bdev, &ns_opts, sizeof(ns_opts), NULL);
+	SPDK_CU_ASSERT_FATAL(nsid == 1);
+	ns = subsystem.ns[nsid - 1];
+	CU_ASSERT(spdk_nvmf_ns_get_cache_stats(ns, &stats) == -ENOENT);
+
+	/* The line size defaults and must be a multiple of the block size */
+	opts.size_mb = 16;
+	opts.line_size = 1000;
+	CU_ASSERT(spdk_nvmf_subsystem_set_ns_cache(&subsystem, nsid, &opts) == -EINVAL);
+	opts.line_size = 0;
+	MOCK_SET(spdk_nvmf_ns_cache_create, (struct spdk_nvmf_ns_cache *)0xDEADBEEF);
+	CU_ASSERT(spdk_nvmf_subsystem_set_ns_cache(&subsystem, nsid, &opts) == 0);
+	CU_ASSERT(ns->cache == (struct spdk_nvmf_ns_cache *)0xDEADBEEF);
+	spdk_nvmf_ns_get_cache_opts(ns, &opts);
+	CU_ASSERT(opts.size_mb == 16);
+	CU_ASSERT(opts.line_size == SPDK_NVMF_NS_CACHE_DEFAULT_LINE_SIZE);
+	CU_ASSERT(spdk_nvmf_ns_get_cache_stats(ns, &stats) == 0);
+	MOCK_SET(spdk_nvmf_ns_cache_create, NULL);
+
+	/* Caches too small for a single line are refused */
+	opts.size_mb = 1;
+	opts.line_size = 2 * 1024 * 1024;
+	CU_ASSERT(spdk_nvmf_subsystem_set_ns_cache(&subsystem, nsid, &opts) == -EINVAL);
+	CU_ASSERT(ns->cache != NULL);
+
+	/* Only while paused */
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	opts.size_mb = 0;
+	CU_ASSERT(spdk_nvmf_subsystem_set_ns_cache(&subsystem, nsid, &opts) == -EBUSY);
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+	CU_ASSERT(spdk_nvmf_subsystem_set_ns_cache(&subsystem, nsid, &opts) == 0);
+	CU_ASSERT(ns->cache == NULL);
+	CU_ASSERT(spdk_nvmf_subsystem_set_ns_cache(&subsystem, 2, &opts) == -ENOENT);
+
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_INACTIVE;
+	CU_ASSERT(spdk_nvmf_subsystem_remove_ns(&subsystem, nsid) == 0);
+
+	free(subsystem.ns);
+	free(tgt.subsystems);
+}
+
+static void
+ut_ana_state_done(struct spdk_nvmf_subsystem *subsystem, void *cb_arg, int status)
+{
+	int *done_status = cb_arg;
+
+	*done_status = status;
+}
+
+static void
+test_spdk_nvmf_subsystem_set_ana_state(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem subsystem = {
+		.max_nsid = 0,
+		.ns = NULL,
+		.tgt = &tgt
+	};
+	struct spdk_nvme_transport_id trid = {};
+	struct spdk_bdev bdev1 = {}, bdev2 = {}, bdev3 = {};
+	struct spdk_nvmf_ns_opts ns_opts;
+	struct spdk_nvmf_listener *listener;
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	uint32_t nsid;
+	int rc, done_status;
+
+	TAILQ_INIT(&subsystem.listeners);
+	TAILQ_INIT(&subsystem.ctrlrs);
+	TAILQ_INIT(&subsystem.hosts);
+
+	/* No listener yet */
+	trid.trtype = SPDK_NVME_TRANSPORT_RDMA;
+	rc = spdk_nvmf_subsystem_set_ana_state(&subsystem, &trid, SPDK_NVME_ANA_INACCESSIBLE_STATE, 0,
+					       ut_ana_state_done, &done_status);
+	CU_ASSERT(rc == -ENOENT);
+
+	/* NSID 1 defaults to ANA group 1, NSID 2 joins ANA group 1 explicitly */
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	nsid = spdk_nvmf_subsystem_add_ns(&subsystem, &bdev1, &ns_opts, sizeof(ns_opts), NULL);
+	CU_ASSERT(nsid == 1);
+	CU_ASSERT(subsystem.ns[0]->opts.anagrpid == 1);
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	ns_opts.anagrpid = 1;
+	nsid = spdk_nvmf_subsystem_add_ns(&subsystem, &bdev2, &ns_opts, sizeof(ns_opts), NULL);
+	CU_ASSERT(nsid == 2);
+	CU_ASSERT(subsystem.ns[1]->opts.anagrpid == 1);
+
+	rc = spdk_nvmf_subsystem_add_listener(&subsystem, &trid);
+	CU_ASSERT(rc == 0);
+	listener = TAILQ_FIRST(&subsystem.listeners);
+	SPDK_CU_ASSERT_FATAL(listener != NULL);
+	CU_ASSERT(listener->num_ana_groups == 2);
+	CU_ASSERT(listener->ana_state[0] == SPDK_NVME_ANA_OPTIMIZED_STATE);
+	CU_ASSERT(listener->ana_state[1] == SPDK_NVME_ANA_OPTIMIZED_STATE);
+
+	/* ANA group ID larger than the maximum NSID */
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	ns_opts.nsid = 4;
+	ns_opts.anagrpid = 5;
+	nsid = spdk_nvmf_subsystem_add_ns(&subsystem, &bdev3, &ns_opts, sizeof(ns_opts), NULL);
+	CU_ASSERT(nsid == 0);
+
+	/* Extending the NSID range extends the ANA groups of the listener */
+	ns_opts.anagrpid = 0;
+	nsid = spdk_nvmf_subsystem_add_ns(&subsystem, &bdev3, &ns_opts, sizeof(ns_opts), NULL);
+	CU_ASSERT(nsid == 4);
+	CU_ASSERT(listener->num_ana_groups == 4);
+	CU_ASSERT(listener->ana_state[3] == SPDK_NVME_ANA_OPTIMIZED_STATE);
+
+	/* Change a single ANA group */
+	done_status = -1;
+	rc = spdk_nvmf_subsystem_set_ana_state(&subsystem, &trid, SPDK_NVME_ANA_INACCESSIBLE_STATE, 1,
+					       ut_ana_state_done, &done_status);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(done_status == 0);
+	CU_ASSERT(spdk_nvmf_listener_get_ana_state(listener, 1) == SPDK_NVME_ANA_INACCESSIBLE_STATE);
+	CU_ASSERT(spdk_nvmf_listener_get_ana_state(listener, 4) == SPDK_NVME_ANA_OPTIMIZED_STATE);
+	CU_ASSERT(listener->ana_state_change_count == 1);
+
+	/* Change all ANA groups */
+	done_status = -1;
+	rc = spdk_nvmf_subsystem_set_ana_state(&subsystem, &trid, SPDK_NVME_ANA_NON_OPTIMIZED_STATE, 0,
+					       ut_ana_state_done, &done_status);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(done_status == 0);
+	CU_ASSERT(spdk_nvmf_listener_get_ana_state(listener, 1) == SPDK_NVME_ANA_NON_OPTIMIZED_STATE);
+	CU_ASSERT(spdk_nvmf_listener_get_ana_state(listener, 4) == SPDK_NVME_ANA_NON_OPTIMIZED_STATE);
+	CU_ASSERT(listener->ana_state_change_count == 2);
+
+	/* The change state is only reported, never set */
+	rc = spdk_nvmf_subsystem_set_ana_state(&subsystem, &trid, SPDK_NVME_ANA_CHANGE_STATE, 0,
+					       ut_ana_state_done, &done_status);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* ANA group out of range */
+	rc = spdk_nvmf_subsystem_set_ana_state(&subsystem, &trid, SPDK_NVME_ANA_OPTIMIZED_STATE, 5,
+					       ut_ana_state_done, &done_status);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(listener->ana_state_change_count == 2);
+
+	/* Removing the listener detaches the controllers that connected through it */
+	ctrlr.listener = listener;
+	TAILQ_INSERT_TAIL(&subsystem.ctrlrs, &ctrlr, link);
+	rc = spdk_nvmf_subsystem_remove_listener(&subsystem, &trid);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ctrlr.listener == NULL);
+	CU_ASSERT(_spdk_nvmf_ctrlr_get_ana_state(&ctrlr, 1) == SPDK_NVME_ANA_OPTIMIZED_STATE);
+	TAILQ_REMOVE(&subsystem.ctrlrs, &ctrlr, link);
+
+	CU_ASSERT(spdk_nvmf_subsystem_remove_ns(&subsystem, 1) == 0);
+	CU_ASSERT(spdk_nvmf_subsystem_remove_ns(&subsystem, 2) == 0);
+	CU_ASSERT(spdk_nvmf_subsystem_remove_ns(&subsystem, 4) == 0);
+	free(subsystem.ns);
+}
+
+static int
+ut_poll_group_create(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+ut_poll_group_destroy(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+test_spdk_nvmf_subsystem_hot_add_remove_ns(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem subsystem = {
+		.max_nsid = 0,
+		.ns = NULL,
+		.tgt = &tgt,
+		.state = SPDK_NVMF_SUBSYSTEM_ACTIVE
+	};
+	struct spdk_bdev bdev1 = {}, bdev2 = {};
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	struct spdk_nvmf_ns_opts ns_opts;
+	struct spdk_io_channel *ch;
+	uint32_t nsid;
+	int rc, done_status;
+
+	TAILQ_INIT(&subsystem.listeners);
+	TAILQ_INIT(&subsystem.ctrlrs);
+	TAILQ_INIT(&subsystem.hosts);
+	TAILQ_INIT(&subsystem.removing_ns);
+
+	spdk_io_device_register(&tgt, ut_poll_group_create, ut_poll_group_destroy,
+				sizeof(struct spdk_nvmf_poll_group), "ut_tgt");
+	ch = spdk_get_io_channel(&tgt);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Adding to an active subsystem doesn't require a pause */
+	done_status = -1;
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	nsid = spdk_nvmf_subsystem_hot_add_ns(&subsystem, &bdev1, &ns_opts, sizeof(ns_opts), NULL,
+					      ut_ana_state_done, &done_status);
+	CU_ASSERT(nsid == 1);
+	SPDK_CU_ASSERT_FATAL(subsystem.ns[0] != NULL);
+	CU_ASSERT(subsystem.ns[0]->bdev == &bdev1);
+	CU_ASSERT(done_status == -1);
+	poll_threads();
+	CU_ASSERT(done_status == 0);
+	CU_ASSERT(subsystem.state == SPDK_NVMF_SUBSYSTEM_ACTIVE);
+
+	/* A controller that is still connecting has no admin qpair yet */
+	TAILQ_INSERT_TAIL(&subsystem.ctrlrs, &ctrlr, link);
+	g_ns_changed_count = 0;
+
+	/* The namespace is unpublished right away, but released once every poll group is done */
+	done_status = -1;
+	rc = spdk_nvmf_subsystem_hot_remove_ns(&subsystem, 1, ut_ana_state_done, &done_status);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(subsystem.ns[0] == NULL);
+	CU_ASSERT(!TAILQ_EMPTY(&subsystem.removing_ns));
+	poll_threads();
+	CU_ASSERT(g_remove_ns_nsid == 1);
+	SPDK_CU_ASSERT_FATAL(g_remove_ns_cb_fn != NULL);
+	CU_ASSERT(done_status == -1);
+
+	/* Removing it again fails */
+	rc = spdk_nvmf_subsystem_hot_remove_ns(&subsystem, 1, ut_ana_state_done, &done_status);
+	CU_ASSERT(rc == -ENOENT);
+
+	/* The NSID is not reused while the removal is in progress */
+	spdk_nvmf_ns_opts_get_defaults(&ns_opts, sizeof(ns_opts));
+	ns_opts.nsid = 1;
+	nsid = spdk_nvmf_subsystem_hot_add_ns(&subsystem, &bdev2, &ns_opts, sizeof(ns_opts), NULL,
+					      NULL, NULL);
+	CU_ASSERT(nsid == 0);
+
+	g_remove_ns_cb_fn(g_remove_ns_cb_arg, 0);
+	g_remove_ns_cb_fn = NULL;
+	poll_threads();
+	CU_ASSERT(done_status == 0);
+	CU_ASSERT(TAILQ_EMPTY(&subsystem.removing_ns));
+
+	/* On an active subsystem, only the poll groups record changed namespaces */
+	CU_ASSERT(g_ns_changed_count == 0);
+
+	nsid = spdk_nvmf_subsystem_hot_add_ns(&subsystem, &bdev2, &ns_opts, sizeof(ns_opts), NULL,
+					      NULL, NULL);
+	CU_ASSERT(nsid == 1);
+	poll_threads();
+
+	/* Transitional states are refused */
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_PAUSING;
+	rc = spdk_nvmf_subsystem_hot_remove_ns(&subsystem, 1, NULL, NULL);
+	CU_ASSERT(rc == -EBUSY);
+
+	/* Paused and inactive subsystems are changed synchronously */
+	subsystem.state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+	done_status = -1;
+	rc = spdk_nvmf_subsystem_hot_remove_ns(&subsystem, 1, ut_ana_state_done, &done_status);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(done_status == 0);
+	CU_ASSERT(subsystem.ns[0] == NULL);
+	CU_ASSERT(g_ns_changed_count == 1);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
+	spdk_io_device_unregister(&tgt, NULL);
+	poll_threads();
+	free(subsystem.ns);
+}
+
+static void
+test_spdk_nvmf_subsystem_ctrlr_lookup(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_ctrlr ctrlr1 = {}, ctrlr2 = {};
+	struct spdk_thread *thread = NULL;
+	int rc;
+
+	tgt.max_subsystems = 1024;
+	tgt.subsystems = calloc(tgt.max_subsystems, sizeof(struct spdk_nvmf_subsystem *));
+	SPDK_CU_ASSERT_FATAL(tgt.subsystems != NULL);
+
+	subsystem = spdk_nvmf_subsystem_create(&tgt, "nqn.2016-06.io.spdk:subsystem1",
+					       SPDK_NVMF_SUBTYPE_NVME, 0);
+	SPDK_CU_ASSERT_FATAL(subsystem != NULL);
+
+	ctrlr1.subsys = subsystem;
+	ctrlr1.thread = spdk_get_thread();
+	rc = spdk_nvmf_subsystem_add_ctrlr(subsystem, &ctrlr1);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ctrlr1.cntlid == 1);
+
+	/* Force the next controller into a different slot page */
+	ctrlr2.subsys = subsystem;
+	ctrlr2.thread = spdk_get_thread();
+	subsystem->next_cntlid = SPDK_NVMF_CNTLID_PAGE_SIZE * 3;
+	rc = spdk_nvmf_subsystem_add_ctrlr(subsystem, &ctrlr2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ctrlr2.cntlid == SPDK_NVMF_CNTLID_PAGE_SIZE * 3 + 1);
+	CU_ASSERT(subsystem->ctrlr_slots[1] == NULL);
+
+	CU_ASSERT(spdk_nvmf_subsystem_get_ctrlr(subsystem, ctrlr1.cntlid) == &ctrlr1);
+	CU_ASSERT(spdk_nvmf_subsystem_get_ctrlr(subsystem, ctrlr2.cntlid) == &ctrlr2);
+	CU_ASSERT(spdk_nvmf_subsystem_get_ctrlr(subsystem, 2) == NULL);
+	CU_ASSERT(spdk_nvmf_subsystem_get_ctrlr(subsystem, SPDK_NVMF_CNTLID_PAGE_SIZE + 1) == NULL);
+
+	CU_ASSERT(spdk_nvmf_subsystem_lookup_ctrlr(subsystem, ctrlr2.cntlid, &thread) == &ctrlr2);
+	CU_ASSERT(thread == spdk_get_thread());
+
+	/* Removed controllers can no longer be found */
+	spdk_nvmf_subsystem_remove_ctrlr(subsystem, &ctrlr1);
+	thread = NULL;
+	CU_ASSERT(spdk_nvmf_subsystem_lookup_ctrlr(subsystem, ctrlr1.cntlid, &thread) == NULL);
+	CU_ASSERT(thread == NULL);
+	CU_ASSERT(spdk_nvmf_subsystem_get_ctrlr(subsystem, ctrlr2.cntlid) == &ctrlr2);
+
+	spdk_nvmf_subsystem_remove_ctrlr(subsystem, &ctrlr2);
+	CU_ASSERT(TAILQ_EMPTY(&subsystem->ctrlrs));
+
+	spdk_nvmf_subsystem_destroy(subsystem);
+	free(tgt.subsystems);
+}
+
+static void
+test_spdk_nvmf_subsystem_hosts(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_subsystem *subsystem;
+	char hostnqn[64];
+	uint32_t i, updates;
+
+	tgt.max_subsystems = 1024;
+	tgt.subsystems = calloc(tgt.max_subsystems, sizeof(struct spdk_nvmf_subsystem *));
+	SPDK_CU_ASSERT_FATAL(tgt.subsystems != NULL);
+
+	subsystem = spdk_nvmf_subsystem_create(&tgt, "nqn.2016-06.io.spdk:subsystem1",
+					       SPDK_NVMF_SUBTYPE_NVME, 0);
+	SPDK_CU_ASSERT_FATAL(subsystem != NULL);
+
+	/* More hosts than hash buckets, so that some of them share a bucket */
+	for (i = 0; i < SPDK_NVMF_HOST_HASH_BUCKETS * 2; i++) {
+		snprintf(hostnqn, sizeof(hostnqn), "nqn.2016-06.io.spdk:host%u", i);
+		CU_ASSERT(spdk_nvmf_subsystem_add_host(subsystem, hostnqn) == 0);
+	}
+
+	for (i = 0; i < SPDK_NVMF_HOST_HASH_BUCKETS * 2; i++) {
+		snprintf(hostnqn, sizeof(hostnqn), "nqn.2016-06.io.spdk:host%u", i);
+		CU_ASSERT(spdk_nvmf_subsystem_host_allowed(subsystem, hostnqn));
+	}
+	CU_ASSERT(!spdk_nvmf_subsystem_host_allowed(subsystem, "nqn.2016-06.io.spdk:host"));
+	CU_ASSERT(!spdk_nvmf_subsystem_host_allowed(subsystem, NULL));
+
+	/* Every change of the access list changes the discovery log */
+	updates = g_discovery_updates;
+	CU_ASSERT(spdk_nvmf_subsystem_remove_host(subsystem, "nqn.2016-06.io.spdk:host3") == 0);
+	CU_ASSERT(!spdk_nvmf_subsystem_host_allowed(subsystem, "nqn.2016-06.io.spdk:host3"));
+	CU_ASSERT(spdk_nvmf_subsystem_host_allowed(subsystem, "nqn.2016-06.io.spdk:host4"));
+	CU_ASSERT(spdk_nvmf_subsystem_remove_host(subsystem, "nqn.2016-06.io.spdk:host3") == -ENOENT);
+	CU_ASSERT(g_discovery_updates == updates + 1);
+
+	CU_ASSERT(spdk_nvmf_subsystem_set_allow_any_host(subsystem, true) == 0);
+	CU_ASSERT(spdk_nvmf_subsystem_host_allowed(subsystem, "nqn.2016-06.io.spdk:host3"));
+	CU_ASSERT(g_discovery_updates == updates + 2);
+
+	spdk_nvmf_subsystem_destroy(subsystem);
+	free(tgt.subsystems);
+}
+
 static void
 nvmf_test_create_subsystem(void)
 {
@@ -1264,7 +1697,16 @@ int main(int argc, char **argv)
 	if (
 		CU_add_test(suite, "create_subsystem", nvmf_test_create_subsystem) == NULL ||
 		CU_add_test(suite, "nvmf_subsystem_add_ns", test_spdk_nvmf_subsystem_add_ns) == NULL ||
+		CU_add_test(suite, "nvmf_subsystem_set_ns_cache",
+			    test_spdk_nvmf_subsystem_set_ns_cache) == NULL ||
 		CU_add_test(suite, "nvmf_subsystem_set_sn", test_spdk_nvmf_subsystem_set_sn) == NULL ||
+		CU_add_test(suite, "nvmf_subsystem_hosts", test_spdk_nvmf_subsystem_hosts) == NULL ||
+		CU_add_test(suite, "nvmf_subsystem_set_ana_state",
+			    test_spdk_nvmf_subsystem_set_ana_state) == NULL ||
+		CU_add_test(suite, "nvmf_subsystem_hot_add_remove_ns",
+			    test_spdk_nvmf_subsystem_hot_add_remove_ns) == NULL ||
+		CU_add_test(suite, "nvmf_subsystem_ctrlr_lookup",
+			    test_spdk_nvmf_subsystem_ctrlr_lookup) == NULL ||
 		CU_add_test(suite, "reservation_register", test_reservation_register) == NULL ||
 		CU_add_test(suite, "reservation_register_with_ptpl", test_reservation_register_with_ptpl) == NULL ||
 		CU_add_test(suite, "reservation_acquire_preempt_1", test_reservation_acquire_preempt_1) == NULL ||
@@ -74,6 +74,11 @@ DEFINE_STUB(spdk_nvmf_subsystem_get_ctrlr,
 	    (struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid),
 	    NULL);
 
+DEFINE_STUB(spdk_nvmf_subsystem_lookup_ctrlr,
+	    struct spdk_nvmf_ctrlr *,
+	    (struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid, struct spdk_thread **thread),
+	    NULL);
+
 DEFINE_STUB(spdk_nvmf_tgt_find_subsystem,
 	    struct spdk_nvmf_subsystem *,
 	    (struct spdk_nvmf_tgt *tgt, const char *subnqn),
@@ -84,6 +89,11 @@ DEFINE_STUB(spdk_nvmf_subsystem_listener_allowed,
 	    (struct spdk_nvmf_subsystem *subsystem, struct spdk_nvme_transport_id *trid),
 	    true);
 
+DEFINE_STUB(spdk_nvmf_subsystem_find_listener,
+	    struct spdk_nvmf_listener *,
+	    (struct spdk_nvmf_subsystem *subsystem, const struct spdk_nvme_transport_id *trid),
+	    NULL);
+
 DEFINE_STUB(spdk_nvmf_transport_qpair_set_sqsize,
 	    int,
 	    (struct spdk_nvmf_qpair *qpair),
@@ -127,6 +137,12 @@ DEFINE_STUB(spdk_nvmf_bdev_ctrlr_read_cmd,
 	     struct spdk_nvmf_request *req),
 	    0);
 
+DEFINE_STUB(spdk_nvmf_bdev_ctrlr_cache_read_cmd,
+	    int,
+	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     struct spdk_nvmf_ns_cache *cache, struct spdk_nvmf_request *req),
+	    0);
+
 DEFINE_STUB(spdk_nvmf_bdev_ctrlr_write_cmd,
 	    int,
 	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
@@ -162,11 +178,24 @@ DEFINE_STUB(spdk_nvmf_bdev_ctrlr_get_dif_ctx,
 	    (struct spdk_bdev *bdev, struct spdk_nvme_cmd *cmd, struct spdk_dif_ctx *dif_ctx),
 	    false);
 
+DEFINE_STUB(spdk_nvmf_bdev_ctrlr_zcopy_start,
+	    int,
+	    (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+	     struct spdk_nvmf_request *req),
+	    -ENOTSUP);
+
+DEFINE_STUB_V(spdk_nvmf_bdev_ctrlr_zcopy_release, (struct spdk_nvmf_request *req));
+
 DEFINE_STUB(spdk_nvmf_transport_req_complete,
 	    int,
 	    (struct spdk_nvmf_request *req),
 	    0);
 
+DEFINE_STUB(spdk_nvmf_transport_calc_buf_cache_max,
+	    int,
+	    (const struct spdk_nvmf_transport_opts *opts, uint32_t *buf_cache_max),
+	    0);
+
 DEFINE_STUB(spdk_nvmf_request_get_buffers,
 	    int,
 	    (struct spdk_nvmf_request *req, struct spdk_nvmf_transport_poll_group *group,
@@ -194,6 +223,29 @@ DEFINE_STUB(spdk_sock_set_priority,
 
 DEFINE_STUB_V(spdk_nvmf_ns_reservation_request, (void *ctx));
 
+DEFINE_STUB_V(spdk_nvmf_poll_group_remove_ns_done,
+	      (struct spdk_nvmf_poll_group *group, struct spdk_nvmf_subsystem *subsystem, uint32_t nsid));
+
+DEFINE_STUB(spdk_nvmf_ns_sched_submit, bool,
+	    (struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_request *req), true);
+
+DEFINE_STUB_V(spdk_nvmf_ns_sched_request_done,
+	      (struct spdk_nvmf_ns_sched *sched, struct spdk_nvmf_request *req));
+
+DEFINE_STUB_V(spdk_nvmf_ns_cache_invalidate_cmd,
+	      (struct spdk_nvmf_ns_cache *cache, struct spdk_nvmf_request *req));
+
+DEFINE_STUB_V(spdk_nvmf_ns_cache_request_release, (struct spdk_nvmf_request *req));
+
+DEFINE_STUB(spdk_copy_engine_get_io_channel, struct spdk_io_channel *, (void), NULL);
+
+DEFINE_STUB(spdk_copy_task_size, size_t, (void), 0);
+
+DEFINE_STUB(spdk_copy_submit_crc32c, int,
+	    (struct spdk_copy_task *copy_req, struct spdk_io_channel *ch, uint32_t *dst,
+	     struct iovec *iovs, uint32_t iovcnt, uint32_t seed, spdk_copy_completion_cb cb),
+	    -ENOTSUP);
+
 struct spdk_trace_histories *g_trace_histories;
 
 struct spdk_bdev {
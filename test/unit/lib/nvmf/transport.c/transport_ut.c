@@ -0,0 +1,428 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright (c) Intel Corporation.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "common/lib/ut_multithread.c"
+#include "spdk_cunit.h"
+#include "spdk_internal/mock.h"
+
+#include "nvmf/transport.c"
+
+#define UT_IO_UNIT_SIZE		4096
+#define UT_NUM_SHARED_BUFFERS	64
+#define UT_BUF_CACHE_SIZE	8
+
+DEFINE_STUB(spdk_nvme_transport_id_trtype_str, const char *,
+	    (enum spdk_nvme_transport_type trtype), "ut");
+
+static struct spdk_nvmf_transport g_ut_transport;
+static struct spdk_nvmf_transport_poll_group g_ut_tgroup;
+
+static struct spdk_nvmf_transport *
+ut_transport_create(struct spdk_nvmf_transport_opts *opts)
+{
+	return &g_ut_transport;
+}
+
+static int
+ut_transport_destroy(struct spdk_nvmf_transport *transport)
+{
+	return 0;
+}
+
+static struct spdk_nvmf_transport_poll_group *
+ut_poll_group_create(struct spdk_nvmf_transport *transport)
+{
+	return &g_ut_tgroup;
+}
+
+static void
+ut_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
+{
+}
+
+const struct spdk_nvmf_transport_ops spdk_nvmf_transport_tcp = {
+	.type = SPDK_NVME_TRANSPORT_TCP,
+	.create = ut_transport_create,
+	.destroy = ut_transport_destroy,
+	.poll_group_create = ut_poll_group_create,
+	.poll_group_destroy = ut_poll_group_destroy,
+};
+
+#ifdef SPDK_CONFIG_RDMA
+const struct spdk_nvmf_transport_ops spdk_nvmf_transport_rdma = {
+	.type = SPDK_NVME_TRANSPORT_RDMA,
+};
+#endif
+
+#ifdef SPDK_CONFIG_FC
+const struct spdk_nvmf_transport_ops spdk_nvmf_transport_fc = {
+	.type = SPDK_NVME_TRANSPORT_FC,
+};
+#endif
+
+static void
+ut_transport_opts_init(struct spdk_nvmf_transport_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->io_unit_size = UT_IO_UNIT_SIZE;
+	opts->num_shared_buffers = UT_NUM_SHARED_BUFFERS;
+	opts->buf_cache_size = UT_BUF_CACHE_SIZE;
+}
+
+static void
+test_transport_data_buf_pools(void)
+{
+	struct spdk_nvmf_transport_opts opts;
+	struct spdk_nvmf_transport *transport;
+	struct spdk_nvmf_transport_poll_group *group;
+	struct spdk_mempool *socket_pools[2];
+
+	/* A single socket gets a single pool holding all the buffers */
+	ut_transport_opts_init(&opts);
+	MOCK_SET(spdk_env_get_next_core, UINT32_MAX);
+	memset(&g_ut_transport, 0, sizeof(g_ut_transport));
+	transport = spdk_nvmf_transport_create(SPDK_NVME_TRANSPORT_TCP, &opts);
+	SPDK_CU_ASSERT_FATAL(transport == &g_ut_transport);
+	CU_ASSERT(transport->data_buf_pool != NULL);
+	CU_ASSERT(transport->socket_data_buf_pools == NULL);
+	CU_ASSERT(transport->data_buf_pool_size == UT_NUM_SHARED_BUFFERS);
+
+	memset(&g_ut_tgroup, 0, sizeof(g_ut_tgroup));
+	group = spdk_nvmf_transport_poll_group_create(transport);
+	SPDK_CU_ASSERT_FATAL(group == &g_ut_tgroup);
+	CU_ASSERT(group->data_buf_pool == transport->data_buf_pool);
+	CU_ASSERT(group->data_buf_socket_id == SPDK_ENV_SOCKET_ID_ANY);
+	CU_ASSERT(group->buf_cache_count == UT_BUF_CACHE_SIZE);
+	CU_ASSERT(spdk_mempool_count(transport->data_buf_pool) ==
+		  UT_NUM_SHARED_BUFFERS - UT_BUF_CACHE_SIZE);
+
+	spdk_nvmf_transport_poll_group_destroy(group);
+	CU_ASSERT(spdk_mempool_count(transport->data_buf_pool) == UT_NUM_SHARED_BUFFERS);
+	spdk_nvmf_transport_destroy(transport);
+	CU_ASSERT(transport->data_buf_pool == NULL);
+
+	/* Poll groups take their buffers from the pool of their own socket */
+	socket_pools[0] = spdk_mempool_create("ut_pool_0", UT_NUM_SHARED_BUFFERS / 2, UT_IO_UNIT_SIZE, 0, 0);
+	socket_pools[1] = spdk_mempool_create("ut_pool_1", UT_NUM_SHARED_BUFFERS / 2, UT_IO_UNIT_SIZE, 0, 1);
+	memset(&g_ut_transport, 0, sizeof(g_ut_transport));
+	g_ut_transport.ops = &spdk_nvmf_transport_tcp;
+	g_ut_transport.opts = opts;
+	g_ut_transport.data_buf_pool = socket_pools[0];
+	g_ut_transport.socket_data_buf_pools = socket_pools;
+	g_ut_transport.num_socket_ids = 2;
+
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	memset(&g_ut_tgroup, 0, sizeof(g_ut_tgroup));
+	group = spdk_nvmf_transport_poll_group_create(&g_ut_transport);
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	CU_ASSERT(group->data_buf_pool == socket_pools[1]);
+	CU_ASSERT(group->data_buf_socket_id == 1);
+	CU_ASSERT(spdk_mempool_count(socket_pools[0]) == UT_NUM_SHARED_BUFFERS / 2);
+	CU_ASSERT(spdk_mempool_count(socket_pools[1]) == UT_NUM_SHARED_BUFFERS / 2 - UT_BUF_CACHE_SIZE);
+	spdk_nvmf_transport_poll_group_destroy(group);
+
+	/* A socket without a pool of its own falls back to the first one */
+	MOCK_SET(spdk_env_get_socket_id, 2);
+	memset(&g_ut_tgroup, 0, sizeof(g_ut_tgroup));
+	group = spdk_nvmf_transport_poll_group_create(&g_ut_transport);
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	CU_ASSERT(group->data_buf_pool == socket_pools[0]);
+	CU_ASSERT(group->data_buf_socket_id == SPDK_ENV_SOCKET_ID_ANY);
+	spdk_nvmf_transport_poll_group_destroy(group);
+
+	MOCK_SET(spdk_env_get_socket_id, 0);
+	spdk_mempool_free(socket_pools[0]);
+	spdk_mempool_free(socket_pools[1]);
+}
+
+static void
+test_transport_buf_cache(void)
+{
+	struct spdk_nvmf_transport_opts opts;
+	struct spdk_nvmf_transport *transport;
+	struct spdk_nvmf_transport_poll_group *group;
+	struct spdk_nvmf_request req = {};
+	uint32_t i;
+	int rc;
+
+	ut_transport_opts_init(&opts);
+	memset(&g_ut_transport, 0, sizeof(g_ut_transport));
+	transport = spdk_nvmf_transport_create(SPDK_NVME_TRANSPORT_TCP, &opts);
+	SPDK_CU_ASSERT_FATAL(transport != NULL);
+	memset(&g_ut_tgroup, 0, sizeof(g_ut_tgroup));
+	group = spdk_nvmf_transport_poll_group_create(transport);
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	CU_ASSERT(group->buf_cache_max == 2 * UT_BUF_CACHE_SIZE);
+
+	/* Requests that fit in the cache don't touch the pool */
+	rc = spdk_nvmf_request_get_buffers(&req, group, transport, UT_BUF_CACHE_SIZE);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(group->buf_cache_count == 0);
+	CU_ASSERT(group->buf_stat.buf_cache_misses == 0);
+	spdk_nvmf_request_free_buffers(&req, group, transport, UT_BUF_CACHE_SIZE);
+	CU_ASSERT(group->buf_cache_count == UT_BUF_CACHE_SIZE);
+
+	/* Bigger ones take the rest from the pool, which grows the cache at the next adjustment */
+	for (i = 0; i < NVMF_BUF_CACHE_ADJUST_INTERVAL; i++) {
+		rc = spdk_nvmf_request_get_buffers(&req, group, transport, UT_BUF_CACHE_SIZE + 2);
+		CU_ASSERT(rc == 0);
+		spdk_nvmf_request_free_buffers(&req, group, transport, UT_BUF_CACHE_SIZE + 2);
+	}
+	CU_ASSERT(group->buf_stat.buf_cache_misses > 0);
+	CU_ASSERT(group->buf_cache_size == UT_BUF_CACHE_SIZE + 2);
+	CU_ASSERT(group->buf_cache_count == UT_BUF_CACHE_SIZE + 2);
+
+	/* Growth is capped */
+	for (i = 0; i < NVMF_BUF_CACHE_ADJUST_INTERVAL; i++) {
+		rc = spdk_nvmf_request_get_buffers(&req, group, transport, 3 * UT_BUF_CACHE_SIZE);
+		CU_ASSERT(rc == 0);
+		spdk_nvmf_request_free_buffers(&req, group, transport, 3 * UT_BUF_CACHE_SIZE);
+	}
+	CU_ASSERT(group->buf_cache_size == group->buf_cache_max);
+
+	/* Unused cache is given back to the pool, once a whole interval went by without misses */
+	for (i = 0; i < 2 * NVMF_BUF_CACHE_ADJUST_INTERVAL; i++) {
+		rc = spdk_nvmf_request_get_buffers(&req, group, transport, 4);
+		CU_ASSERT(rc == 0);
+		spdk_nvmf_request_free_buffers(&req, group, transport, 4);
+	}
+	CU_ASSERT(group->buf_cache_size == group->buf_cache_max - (group->buf_cache_max - 4) / 2);
+	CU_ASSERT(group->buf_cache_count == group->buf_cache_size);
+	CU_ASSERT(spdk_mempool_count(transport->data_buf_pool) ==
+		  UT_NUM_SHARED_BUFFERS - group->buf_cache_count);
+
+	/* Running out of buffers is counted once per exhaustion, every failed attempt is a wait */
+	MOCK_SET(spdk_mempool_get, NULL);
+	rc = spdk_nvmf_request_get_buffers(&req, group, transport, group->buf_cache_count + 1);
+	CU_ASSERT(rc == -ENOMEM);
+	rc = spdk_nvmf_request_get_buffers(&req, group, transport, group->buf_cache_count + 1);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(group->buf_stat.buf_waits == 2);
+	CU_ASSERT(group->buf_stat.buf_pool_exhausted == 1);
+	MOCK_CLEAR_P(spdk_mempool_get);
+
+	rc = spdk_nvmf_request_get_buffers(&req, group, transport, 1);
+	CU_ASSERT(rc == 0);
+	spdk_nvmf_request_free_buffers(&req, group, transport, 1);
+	CU_ASSERT(group->buf_pool_exhausted == false);
+
+	spdk_nvmf_transport_poll_group_destroy(group);
+	CU_ASSERT(spdk_mempool_count(transport->data_buf_pool) == UT_NUM_SHARED_BUFFERS);
+	spdk_nvmf_transport_destroy(transport);
+}
+
+static void
+test_transport_buf_cache_idle(void)
+{
+	struct spdk_nvmf_transport_opts opts;
+	struct spdk_nvmf_transport *transport;
+	struct spdk_nvmf_transport_poll_group *group;
+	struct spdk_nvmf_request req = {};
+	uint32_t i;
+	int rc;
+
+	ut_transport_opts_init(&opts);
+	memset(&g_ut_transport, 0, sizeof(g_ut_transport));
+	transport = spdk_nvmf_transport_create(SPDK_NVME_TRANSPORT_TCP, &opts);
+	SPDK_CU_ASSERT_FATAL(transport != NULL);
+	memset(&g_ut_tgroup, 0, sizeof(g_ut_tgroup));
+	group = spdk_nvmf_transport_poll_group_create(transport);
+	SPDK_CU_ASSERT_FATAL(group != NULL);
+	CU_ASSERT(group->buf_cache_poller != NULL);
+
+	/* A burst grows the cache to its largest */
+	for (i = 0; i < NVMF_BUF_CACHE_ADJUST_INTERVAL; i++) {
+		rc = spdk_nvmf_request_get_buffers(&req, group, transport, 3 * UT_BUF_CACHE_SIZE);
+		CU_ASSERT(rc == 0);
+		spdk_nvmf_request_free_buffers(&req, group, transport, 3 * UT_BUF_CACHE_SIZE);
+	}
+	CU_ASSERT(group->buf_cache_size == group->buf_cache_max);
+	CU_ASSERT(group->buf_cache_count == group->buf_cache_max);
+
+	/*
+	 * Once the group is idle, the cache is handed back to the pool over time. The
+	 *  last adjustment happened while a request held all the cached buffers, so the
+	 *  first idle period only starts a new window.
+	 */
+	spdk_delay_us(NVMF_BUF_CACHE_ADJUST_PERIOD_US);
+	poll_threads();
+	CU_ASSERT(group->buf_cache_size == group->buf_cache_max);
+	spdk_delay_us(NVMF_BUF_CACHE_ADJUST_PERIOD_US);
+	poll_threads();
+	CU_ASSERT(group->buf_cache_size == group->buf_cache_max / 2);
+	CU_ASSERT(group->buf_cache_count == group->buf_cache_size);
+
+	for (i = 0; i < 8; i++) {
+		spdk_delay_us(NVMF_BUF_CACHE_ADJUST_PERIOD_US);
+		poll_threads();
+	}
+	CU_ASSERT(group->buf_cache_size == 0);
+	CU_ASSERT(group->buf_cache_count == 0);
+	CU_ASSERT(spdk_mempool_count(transport->data_buf_pool) == UT_NUM_SHARED_BUFFERS);
+
+	spdk_nvmf_transport_poll_group_destroy(group);
+	CU_ASSERT(group->buf_cache_poller == NULL);
+	spdk_nvmf_transport_destroy(transport);
+}
+
+static void
+test_transport_calc_buf_cache_max(void)
+{
+	struct spdk_nvmf_transport_opts opts;
+	uint32_t buf_cache_max;
+
+	ut_transport_opts_init(&opts);
+	MOCK_SET(spdk_env_get_next_core, UINT32_MAX);
+
+	/* Caches may grow to twice their size if the pool can hold them */
+	CU_ASSERT(spdk_nvmf_transport_calc_buf_cache_max(&opts, &buf_cache_max) == 0);
+	CU_ASSERT(buf_cache_max == 2 * UT_BUF_CACHE_SIZE);
+
+	/* Otherwise growth is limited to what the pool holds */
+	opts.num_shared_buffers = UT_BUF_CACHE_SIZE + 2;
+	CU_ASSERT(spdk_nvmf_transport_calc_buf_cache_max(&opts, &buf_cache_max) == 0);
+	CU_ASSERT(buf_cache_max == UT_BUF_CACHE_SIZE + 2);
+
+	/* The pool can't even fill the caches */
+	opts.num_shared_buffers = UT_BUF_CACHE_SIZE - 1;
+	CU_ASSERT(spdk_nvmf_transport_calc_buf_cache_max(&opts, &buf_cache_max) == -EINVAL);
+
+	/* No cache, nothing to check */
+	opts.buf_cache_size = 0;
+	CU_ASSERT(spdk_nvmf_transport_calc_buf_cache_max(&opts, &buf_cache_max) == 0);
+	CU_ASSERT(buf_cache_max == 0);
+}
+
+static int
+ut_tgt_poll_group_create(void *io_device, void *ctx_buf)
+{
+	struct spdk_nvmf_poll_group *group = ctx_buf;
+
+	TAILQ_INIT(&group->tgroups);
+	TAILQ_INSERT_TAIL(&group->tgroups, &g_ut_tgroup, link);
+	return 0;
+}
+
+static void
+ut_tgt_poll_group_destroy(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+test_transport_poll_group_get_stat(void)
+{
+	struct spdk_nvmf_tgt tgt = {};
+	struct spdk_nvmf_transport_poll_group_stat *stat = NULL;
+	struct spdk_io_channel *ch;
+	int rc;
+
+	memset(&g_ut_transport, 0, sizeof(g_ut_transport));
+	g_ut_transport.ops = &spdk_nvmf_transport_tcp;
+	memset(&g_ut_tgroup, 0, sizeof(g_ut_tgroup));
+	g_ut_tgroup.transport = &g_ut_transport;
+	g_ut_tgroup.data_buf_socket_id = 1;
+	g_ut_tgroup.buf_cache_size = 12;
+	g_ut_tgroup.buf_cache_count = 5;
+	g_ut_tgroup.buf_stat.buf_cache_misses = 100;
+	g_ut_tgroup.buf_stat.buf_waits = 7;
+	g_ut_tgroup.buf_stat.buf_pool_exhausted = 3;
+
+	spdk_io_device_register(&tgt, ut_tgt_poll_group_create, ut_tgt_poll_group_destroy,
+				sizeof(struct spdk_nvmf_poll_group), "ut_tgt");
+	ch = spdk_get_io_channel(&tgt);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* Buffer statistics are reported even if the transport has none of its own */
+	rc = spdk_nvmf_transport_poll_group_get_stat(&tgt, &g_ut_transport, &stat);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(stat != NULL);
+	CU_ASSERT(stat->trtype == SPDK_NVME_TRANSPORT_TCP);
+	CU_ASSERT(stat->numa_socket == 1);
+	CU_ASSERT(stat->buf_cache_size == 12);
+	CU_ASSERT(stat->buf_cache_count == 5);
+	CU_ASSERT(stat->buf_cache_misses == 100);
+	CU_ASSERT(stat->buf_waits == 7);
+	CU_ASSERT(stat->buf_pool_exhausted == 3);
+	spdk_nvmf_transport_poll_group_free_stat(&g_ut_transport, stat);
+
+	/* Unknown transport */
+	rc = spdk_nvmf_transport_poll_group_get_stat(&tgt, &g_ut_transport + 1, &stat);
+	CU_ASSERT(rc == -ENOENT);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
+	spdk_io_device_unregister(&tgt, NULL);
+	poll_threads();
+}
+
+int main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	if (CU_initialize_registry() != CUE_SUCCESS) {
+		return CU_get_error();
+	}
+
+	suite = CU_add_suite("nvmf", NULL, NULL);
+	if (suite == NULL) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	if (
+		CU_add_test(suite, "transport_data_buf_pools", test_transport_data_buf_pools) == NULL ||
+		CU_add_test(suite, "transport_buf_cache", test_transport_buf_cache) == NULL ||
+		CU_add_test(suite, "transport_buf_cache_idle", test_transport_buf_cache_idle) == NULL ||
+		CU_add_test(suite, "transport_calc_buf_cache_max",
+			    test_transport_calc_buf_cache_max) == NULL ||
+		CU_add_test(suite, "transport_poll_group_get_stat", test_transport_poll_group_get_stat) == NULL
+	) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	allocate_threads(1);
+	set_thread(0);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+
+	free_threads();
+
+	CU_cleanup_registry();
+	return num_failures;
+}
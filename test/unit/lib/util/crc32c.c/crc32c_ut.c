@@ -121,6 +121,44 @@ test_crc32c(void)
 	CU_ASSERT(crc == 0x6087809A);
 }
 
+static void
+test_crc32c_multi(void)
+{
+	uint8_t data[6][4100];
+	const void *bufs[6];
+	size_t lens[6] = { 4096, 4100, 7, 0, 4096, 1029 };
+	uint32_t crcs[6], expected[6];
+	uint32_t count, i, j;
+
+	for (i = 0; i < 6; i++) {
+		for (j = 0; j < sizeof(data[i]); j++) {
+			data[i][j] = (uint8_t)(i * 31 + j * 7);
+		}
+		bufs[i] = data[i];
+	}
+
+	/* Cover less than one full set of lanes, exactly one set and a partial second set. */
+	for (count = 0; count <= 6; count++) {
+		for (i = 0; i < count; i++) {
+			crcs[i] = 0xFFFFFFFFu - i;
+			expected[i] = spdk_crc32c_update(bufs[i], lens[i], crcs[i]);
+		}
+
+		spdk_crc32c_update_multi(bufs, lens, crcs, count);
+
+		for (i = 0; i < count; i++) {
+			CU_ASSERT(crcs[i] == expected[i]);
+		}
+	}
+
+	/* Known value from test_crc32c() */
+	bufs[0] = "Hello world!";
+	lens[0] = strlen("Hello world!");
+	crcs[0] = 0xFFFFFFFFu;
+	spdk_crc32c_update_multi(bufs, lens, crcs, 1);
+	CU_ASSERT((crcs[0] ^ 0xFFFFFFFFu) == 0x7b98e751);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -138,7 +176,8 @@ main(int argc, char **argv)
 	}
 
 	if (
-		CU_add_test(suite, "test_crc32c", test_crc32c) == NULL) {
+		CU_add_test(suite, "test_crc32c", test_crc32c) == NULL ||
+		CU_add_test(suite, "test_crc32c_multi", test_crc32c_multi) == NULL) {
 		CU_cleanup_registry();
 		return CU_get_error();
 	}
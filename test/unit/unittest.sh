@@ -60,6 +60,7 @@ $valgrind $testdir/lib/bdev/part.c/part_ut
 $valgrind $testdir/lib/bdev/scsi_nvme.c/scsi_nvme_ut
 $valgrind $testdir/lib/bdev/gpt/gpt.c/gpt_ut
 $valgrind $testdir/lib/bdev/vbdev_lvol.c/vbdev_lvol_ut
+$valgrind $testdir/lib/bdev/vbdev_zone_block.c/vbdev_zone_block_ut
 
 if grep -q '#define SPDK_CONFIG_CRYPTO 1' $rootdir/include/spdk/config.h; then
 	$valgrind $testdir/lib/bdev/crypto.c/crypto_ut
@@ -98,6 +99,7 @@ $valgrind $testdir/lib/nvme/nvme_qpair.c/nvme_qpair_ut
 $valgrind $testdir/lib/nvme/nvme_pcie.c/nvme_pcie_ut
 $valgrind $testdir/lib/nvme/nvme_quirks.c/nvme_quirks_ut
 $valgrind $testdir/lib/nvme/nvme_tcp.c/nvme_tcp_ut
+$valgrind $testdir/lib/nvme/nvme_zns.c/nvme_zns_ut
 if grep -q '#define SPDK_CONFIG_RDMA 1' $rootdir/include/spdk/config.h; then
 	$valgrind $testdir/lib/nvme/nvme_rdma.c/nvme_rdma_ut
 fi
@@ -120,6 +122,9 @@ if grep -q '#define SPDK_CONFIG_RDMA 1' $rootdir/include/spdk/config.h; then
 fi
 $valgrind $testdir/lib/nvmf/subsystem.c/subsystem_ut
 $valgrind $testdir/lib/nvmf/tcp.c/tcp_ut
+$valgrind $testdir/lib/nvmf/transport.c/transport_ut
+$valgrind $testdir/lib/nvmf/ns_sched.c/ns_sched_ut
+$valgrind $testdir/lib/nvmf/ns_cache.c/ns_cache_ut
 
 $valgrind $testdir/lib/scsi/dev.c/dev_ut
 $valgrind $testdir/lib/scsi/lun.c/lun_ut